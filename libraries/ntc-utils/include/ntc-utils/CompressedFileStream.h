@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <ntc-utils/MappedFileStream.h>
+#include <memory>
+#include <vector>
+
+// Page size of the compressed texture set files, same as the GDeflate tile size.
+constexpr uint32_t c_CompressedFilePageSize = 65536;
+
+struct CompressedFilePageEntry;
+struct GDeflateCodec;
+
+enum class CompressedFilePageFormat
+{
+    Deflate,  // zlib streams, decompressed on the CPU
+    GDeflate, // GDeflate streams, which DirectStorage can decompress on the GPU
+};
+
+char const* GetCompressedFilePageFormatName(CompressedFilePageFormat format);
+
+// Returns true if this build can compress and decompress GDeflate pages, which requires DirectStorage.
+bool IsGDeflateCodecAvailable();
+
+// Compresses a serialized texture set, such as the output of ITextureSet::SaveToMemory, into a page-compressed
+// container. Every page is compressed independently, so any range of the texture set can be read by decompressing
+// only the pages that cover it. Pages that don't get smaller are stored as is.
+// When GDeflate is requested but the codec is not available, the pages are deflated with zlib instead.
+// Pages are compressed on 'threadCount' threads, 0 means one per hardware thread.
+// Returns the format that was used.
+CompressedFilePageFormat CompressTextureSetData(void const* data, size_t size, std::vector<uint8_t>& outData,
+    CompressedFilePageFormat format = CompressedFilePageFormat::Deflate, int threadCount = 0);
+
+// Returns true if the data starts with a valid page-compressed container header.
+bool IsCompressedTextureSetData(void const* data, size_t size);
+
+// Read-only stream over a page-compressed texture set file that presents the original, uncompressed
+// texture set data to the library. Pages are decompressed on demand when they are read, and the last
+// decompressed page is kept for the following small reads, such as header parsing.
+// GDeflate pages are decompressed with the DirectStorage CPU codec; reading them fails in builds without it.
+class CompressedFileStream : public ntc::IStream
+{
+public:
+    // Location of one page in the file, for decompressing it outside of the stream, such as on the GPU
+    struct PageInfo
+    {
+        uint64_t uncompressedOffset = 0;
+        uint32_t uncompressedSize = 0;
+        void const* storedData = nullptr; // Points into the file mapping, valid for the lifetime of the stream
+        uint32_t storedSize = 0;
+        bool isDeflate = false;
+        bool isGDeflate = false; // Pages with neither flag are stored as is
+    };
+    // Returns nullptr if the file cannot be opened or mapped, or if it's not a page-compressed container.
+    // The reason is stored into 'outErrorMessage' if it's not null.
+    static std::unique_ptr<CompressedFileStream> Open(char const* fileName, std::string* outErrorMessage = nullptr);
+
+    friend std::unique_ptr<ntc::IStream> OpenTextureSetFile(char const* fileName, std::string* outErrorMessage);
+
+    bool Read(void* dataPtr, size_t size) override;
+
+    // Always fails, the stream is read-only.
+    bool Write(void const* dataPtr, size_t size) override;
+
+    bool Seek(uint64_t offset) override;
+
+    uint64_t Tell() override;
+
+    // Returns the uncompressed size of the texture set data.
+    uint64_t Size() override;
+
+    // Returns the size of the file on disk.
+    uint64_t GetStoredSize() const;
+
+    // GDeflate if any page of the file is GDeflate, otherwise Deflate.
+    CompressedFilePageFormat GetPageFormat() const { return m_pageFormat; }
+
+    uint32_t GetPageSize() const { return m_pageSize; }
+    uint32_t GetPageCount() const { return m_pageCount; }
+    PageInfo GetPageInfo(uint32_t pageIndex) const;
+
+    ~CompressedFileStream() override;
+
+private:
+    CompressedFileStream() = default;
+
+    static std::unique_ptr<CompressedFileStream> Create(std::unique_ptr<MappedFileStream>&& file);
+
+    bool DecompressPage(uint32_t pageIndex);
+
+    std::unique_ptr<MappedFileStream> m_file;
+    CompressedFilePageEntry const* m_pages = nullptr;
+    uint32_t m_pageSize = 0;
+    uint32_t m_pageCount = 0;
+    uint64_t m_size = 0;
+    uint64_t m_position = 0;
+    std::vector<uint8_t> m_pageData;
+    int64_t m_decompressedPage = -1;
+    CompressedFilePageFormat m_pageFormat = CompressedFilePageFormat::Deflate;
+    std::unique_ptr<GDeflateCodec> m_gdeflateCodec; // Created on the first GDeflate page
+};
+
+// Opens a texture set file for reading. Page-compressed files are opened through a CompressedFileStream,
+// and regular files through a MappedFileStream. Returns nullptr if the file cannot be opened, and stores
+// the reason into 'outErrorMessage' if it's not null.
+std::unique_ptr<ntc::IStream> OpenTextureSetFile(char const* fileName, std::string* outErrorMessage = nullptr);
@@ -13,6 +13,7 @@
 #pragma once
 
 #include <nvrhi/nvrhi.h>
+#include <string>
 
 namespace donut::app
 {
@@ -30,3 +31,14 @@ bool IsDP4aSupported(nvrhi::IDevice* device);
 bool IsFloat16Supported(nvrhi::IDevice* device);
 
 bool IsDX12DeveloperModeEnabled();
+
+// Tells whether resources written on the copy queue can be read on the graphics queue without explicit
+// transitions between the queues. That is true on DX12, where buffers and textures decay to the common state
+// after the copy queue work. On Vulkan, NVRHI creates resources with exclusive sharing and doesn't transfer
+// their queue family ownership, and the copy queue of the Donut device managers comes from a dedicated transfer
+// family, so data uploaded there is not guaranteed to be visible to the graphics queue.
+bool IsCopyQueueUploadSupported(nvrhi::IDevice* device);
+
+// Returns a string with the graphics API, PCI IDs, name and driver version of the adapter, which can be used
+// as a key for settings that depend on the GPU and driver. Returns an empty string if the adapter is unknown.
+std::string GetAdapterIdentifier(nvrhi::IDevice* device);
@@ -15,8 +15,20 @@
 #include <nvrhi/nvrhi.h>
 #include <libntc/ntc.h>
 #include <unordered_map>
+#include <vector>
 #include <donut/engine/BindingCache.h>
 
+// One texture or region to encode, see GraphicsBlockCompressionPass::ExecuteBatch(...)
+struct BlockCompressionJob
+{
+    ntc::MakeBlockCompressionComputePassParameters params;
+    nvrhi::ITexture* inputTexture = nullptr;
+    nvrhi::Format inputFormat = nvrhi::Format::UNKNOWN;
+    int inputMipLevel = 0;
+    nvrhi::ITexture* outputTexture = nullptr;
+    int outputMipLevel = 0;
+};
+
 class GraphicsBlockCompressionPass
 {
 public:
@@ -35,6 +47,16 @@ public:
         nvrhi::ITexture* inputTexture, nvrhi::Format inputFormat, int inputMipLevel,
         nvrhi::ITexture* outputTexture, int outputMipLevel, nvrhi::IBuffer* accelerationBuffer);
 
+    // Makes the compute passes for all jobs and records them with one set of barriers, still one dispatch per job.
+    // The jobs are ordered by the shader so that the jobs with the same format and quality share the pipeline,
+    // and there are no UAV barriers between them, so the jobs must not write the same subresource. Needs one
+    // constant buffer version per job, and doesn't support the acceleration buffer.
+    // On failure, 'outFailedJob' receives the index of the job that failed, and 'outStatus' the status returned
+    // by MakeBlockCompressionComputePass, or Ok if the pipeline or the binding set could not be created.
+    // Note: ExecuteBatch expects that the commandList is open, and leaves it open.
+    bool ExecuteBatch(nvrhi::ICommandList* commandList, ntc::IContext* context,
+        std::vector<BlockCompressionJob> const& jobs, int* outFailedJob = nullptr, ntc::Status* outStatus = nullptr);
+
     void ClearBindingSetCache() { m_bindingCache.Clear(); }
 
 private:
@@ -45,4 +67,11 @@ private:
     nvrhi::BufferHandle m_constantBuffer;
     bool m_useAccelerationBuffer;
     int m_maxConstantBufferVersions;
+
+    nvrhi::IComputePipeline* GetOrCreatePipeline(ntc::ComputePassDesc const& computePass);
+
+    bool CreateConstantBuffer(size_t size);
+
+    nvrhi::IBindingSet* GetOrCreateBindingSet(nvrhi::ITexture* inputTexture, nvrhi::Format inputFormat,
+        int inputMipLevel, nvrhi::ITexture* outputTexture, int outputMipLevel, nvrhi::IBuffer* accelerationBuffer);
 };
@@ -30,14 +30,20 @@ public:
 
     void WriteDescriptor(nvrhi::BindingSetItem item);
 
+    // Uploads the range from the stream into the input buffer. When the stream is a MappedFileStream,
+    // the data is copied into the upload buffer directly from the mapped file.
     bool SetInputData(nvrhi::ICommandList* commandList, ntc::IStream* inputStream, ntc::StreamRange range);
 
-    void SetInputBuffer(nvrhi::IBuffer* buffer);
+    bool SetInputData(nvrhi::ICommandList* commandList, void const* data, size_t size);
+
+    // Uses an external input buffer, or a range of it when the latents of multiple texture sets share one buffer
+    void SetInputBuffer(nvrhi::IBuffer* buffer, nvrhi::BufferRange range = nvrhi::EntireBuffer);
 
     bool SetWeightsFromTextureSet(nvrhi::ICommandList* commandList, ntc::ITextureSetMetadata* textureSetMetadata,
         ntc::InferenceWeightType weightType);
 
-    void SetWeightBuffer(nvrhi::IBuffer* buffer);
+    // Uses an external weight buffer, or a range of it when the weights of multiple texture sets share one buffer
+    void SetWeightBuffer(nvrhi::IBuffer* buffer, nvrhi::BufferRange range = nvrhi::EntireBuffer);
 
     bool ExecuteComputePass(nvrhi::ICommandList* commandList, ntc::ComputePassDesc& computePass);
 
@@ -52,8 +58,10 @@ private:
     donut::engine::BindingCache m_bindingCache;
     nvrhi::DescriptorTableHandle m_descriptorTable;
     nvrhi::BufferHandle m_inputBuffer;
+    nvrhi::BufferRange m_inputBufferRange = nvrhi::EntireBuffer;
     nvrhi::BufferHandle m_weightUploadBuffer;
     nvrhi::BufferHandle m_weightBuffer;
+    nvrhi::BufferRange m_weightBufferRange = nvrhi::EntireBuffer;
     nvrhi::BufferHandle m_constantBuffer;
     bool m_inputBufferIsExternal = false;
     bool m_weightBufferIsExternal = false;
@@ -71,6 +71,7 @@ enum class ToolInputType
     CompressedTextureSet,
     Manifest,
     Images,
+    MaterialAtlas, // Multiple manifests or directories with --atlas
     Mixed
 };
 
@@ -87,13 +88,20 @@ char const* SemanticLabelToString(SemanticLabel label);
 
 int GetSemanticChannelCount(SemanticLabel label);
 
-void GenerateManifestFromDirectory(const char* path, bool loadMips, Manifest& outManifest);
+// When 'includeTextureContainers' is true, DDS and KTX2 files are also added to the manifest.
+void GenerateManifestFromDirectory(const char* path, bool loadMips, Manifest& outManifest,
+    bool includeTextureContainers = false);
 
 void GenerateManifestFromFileList(std::vector<const char*> const& files, Manifest& outManifest);
     
 bool ReadManifestFromFile(const char* fileName, Manifest& outManifest,
     std::string& outError);
 
+// Parses a manifest that is already in memory. 'fileName' is used for error messages,
+// and the texture file names are resolved relative to its directory.
+bool ReadManifestFromMemory(char const* data, size_t size, const char* fileName, Manifest& outManifest,
+    std::string& outError);
+
 bool IsSupportedImageFileExtension(std::string const& extension);
 
 void UpdateToolInputType(ToolInputType& current, ToolInputType newInput);
@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <ntc-utils/Manifest.h>
+#include <functional>
+#include <string>
+
+// A material found by ScanManifestIndex. It is either a manifest file, or a directory with images
+// and no manifest files, in which case the manifest is generated with GenerateManifestFromDirectory.
+struct ManifestIndexMaterial
+{
+    std::string path;
+    bool isDirectory = false;
+    Manifest manifest;
+};
+
+struct ManifestIndexParameters
+{
+    char const* rootPath = nullptr;
+    // Binary file with the directory listings from a previous scan, or nullptr to disable caching.
+    // Directories whose modification time matches the cached one are not enumerated again.
+    // The file is rewritten after every scan.
+    char const* cacheFileName = nullptr;
+    // Extension of the manifest files, compared case-insensitively
+    char const* manifestExtension = ".json";
+    // Number of scanning threads, 0 means one per hardware thread
+    int threadCount = 0;
+    // Options for the generated manifests, see GenerateManifestFromDirectory
+    bool loadMips = false;
+    bool includeTextureContainers = false;
+};
+
+struct ManifestIndexStats
+{
+    size_t directories = 0;
+    size_t cachedDirectories = 0;
+    size_t materials = 0;
+    size_t errors = 0;
+};
+
+// Called from the scanning threads for every material as soon as its manifest is ready, in no particular order.
+using ManifestIndexMaterialCallback = std::function<void(ManifestIndexMaterial&& material)>;
+
+// Called from the scanning threads for manifests that cannot be parsed and directories that cannot be read.
+using ManifestIndexErrorCallback = std::function<void(std::string const& path, std::string const& error)>;
+
+// Walks the directory tree under 'rootPath' on multiple threads, parsing the manifests while the scan continues.
+// The 'mips' subdirectory of an image directory belongs to that directory and is not scanned separately.
+// Symbolic links to directories are skipped.
+// Returns false if the root is not a directory; other errors are reported through 'onError'.
+bool ScanManifestIndex(ManifestIndexParameters const& params, ManifestIndexMaterialCallback const& onMaterial,
+    ManifestIndexErrorCallback const& onError, ManifestIndexStats* outStats, std::string& outError);
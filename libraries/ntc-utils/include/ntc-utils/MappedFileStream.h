@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <libntc/ntc.h>
+#include <memory>
+#include <string>
+
+// Read-only stream over a memory-mapped file.
+// Besides the regular stream functions, it provides direct pointers into the file contents,
+// so that the data can be copied into GPU upload buffers without reading it into a temporary buffer first.
+class MappedFileStream : public ntc::IStream
+{
+public:
+    // Returns nullptr if the file cannot be opened or mapped, and stores the system error text
+    // into 'outErrorMessage' if it's not null.
+    static std::unique_ptr<MappedFileStream> Open(char const* fileName, std::string* outErrorMessage = nullptr);
+
+    // Creates a stream over a range of this file's mapping, such as one texture set in an archive.
+    // The view doesn't own the mapping, so it must not outlive this stream. Returns nullptr if the range
+    // is outside of the file.
+    std::unique_ptr<MappedFileStream> CreateView(uint64_t offset, uint64_t size) const;
+
+    ~MappedFileStream() override;
+
+    bool Read(void* dataPtr, size_t size) override;
+
+    // Always fails, the stream is read-only.
+    bool Write(void const* dataPtr, size_t size) override;
+
+    bool Seek(uint64_t offset) override;
+
+    uint64_t Tell() override;
+
+    uint64_t Size() override;
+
+    // Returns a pointer to the file contents at the given range, or nullptr if the range is outside of the file.
+    void const* GetData(uint64_t offset, uint64_t size) const;
+
+    // Returns a pointer to the range if the stream is a MappedFileStream, nullptr otherwise.
+    static void const* GetStreamData(ntc::IStream* stream, uint64_t offset, uint64_t size);
+
+    // Asks the OS to start reading the range into memory, so that it's read with large sequential requests
+    // instead of page faults. Does nothing if the range is outside of the file.
+    void Prefetch(uint64_t offset, uint64_t size) const;
+
+private:
+    MappedFileStream() = default;
+
+    uint8_t const* m_data = nullptr;
+    uint64_t m_size = 0;
+    uint64_t m_position = 0;
+    bool m_isView = false;
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;
+    void* m_mappingHandle = nullptr;
+#endif
+};
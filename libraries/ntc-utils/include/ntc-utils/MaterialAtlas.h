@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+constexpr int c_MaterialAtlasLayoutVersion = 1;
+
+// Location of one material in the atlas, in the pixels of MIP 0.
+struct MaterialAtlasEntry
+{
+    std::string name;
+    int left = 0;
+    int top = 0;
+    int width = 0;
+    int height = 0;
+    int mips = 1; // MIP levels where the rectangle covers whole texels and doesn't mix with its neighbors
+};
+
+// Layout of a texture set that contains several materials side by side. All materials share the latents,
+// the network and the weights of the texture set, and each one occupies a rectangle of it.
+// See docs/CommandLineTool.md for the file format.
+struct MaterialAtlasLayout
+{
+    std::string textureSetFileName; // Relative to the layout file
+    int width = 0;
+    int height = 0;
+    int mips = 1;
+    std::vector<MaterialAtlasEntry> materials;
+
+    MaterialAtlasEntry const* FindMaterial(std::string const& name) const;
+};
+
+// Places the materials into the atlas, using their 'width' and 'height' fields and filling the positions and
+// the atlas dimensions. Every rectangle is aligned to the largest power of 2 that divides its width and height,
+// so that the materials don't share any texels through as many MIP levels as possible.
+// Returns false if the materials don't fit into a 'maxSize' x 'maxSize' atlas.
+bool PackMaterialAtlas(MaterialAtlasLayout& layout, int maxSize);
+
+// Sets the 'mips' fields of the materials, assuming that the texture set has 'mips' MIP levels.
+void UpdateMaterialAtlasMips(MaterialAtlasLayout& layout, int mips);
+
+// Returns the name of the layout file that goes with the texture set file, "<name>.atlas.json".
+std::string GetMaterialAtlasLayoutFileName(std::string const& textureSetFileName);
+
+bool ReadMaterialAtlasLayout(char const* fileName, MaterialAtlasLayout& outLayout, std::string& outError);
+
+bool WriteMaterialAtlasLayout(char const* fileName, MaterialAtlasLayout const& layout, std::string& outError);
@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <libntc/ntc.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Power-of-two size classes from 64 bytes to 1 MB, plus one category for the larger allocations
+constexpr int c_PooledAllocatorSizeClasses = 15;
+constexpr int c_PooledAllocatorCategories = c_PooledAllocatorSizeClasses + 1;
+
+struct PooledAllocatorStats
+{
+    int64_t bytesAllocated = 0;       // Requested bytes that are currently allocated
+    int64_t peakBytesAllocated = 0;   // Maximum of bytesAllocated since the allocator was created or ResetPeak
+    int64_t liveAllocations = 0;
+    int64_t bytesPooled = 0;          // Freed blocks that are kept for reuse
+    uint64_t totalAllocations = 0;
+    uint64_t pooledAllocations = 0;   // Allocations served from the pools without calling malloc
+    std::array<uint64_t, c_PooledAllocatorCategories> allocationsPerCategory{};
+};
+
+// Thread-safe allocator for NTC contexts that keeps the freed blocks of small and medium allocations in
+// per-size-class free lists, so that the metadata, staging and temporary buffers that the library creates
+// for every texture set reuse the same memory instead of going through malloc each time.
+// The pools are limited to 'maxPooledBytes', larger allocations always use malloc.
+// Call Trim between texture sets or loading phases to return the pooled memory to the system.
+class PooledAllocator : public ntc::IAllocator
+{
+public:
+    explicit PooledAllocator(size_t maxPooledBytes = size_t(64) << 20)
+        : m_maxPooledBytes(int64_t(maxPooledBytes))
+    { }
+
+    ~PooledAllocator() override;
+
+    void* Allocate(size_t size) override;
+
+    void Deallocate(void* ptr, size_t size) override;
+
+    // Frees all pooled blocks.
+    void Trim();
+
+    // Sets the peak to the current allocation size, e.g. to measure the peak of the next texture set.
+    void ResetPeak();
+
+    PooledAllocatorStats GetStats() const;
+
+    int64_t GetBytesAllocated() const { return m_bytesAllocated; }
+
+    // Returns a name like "<=64B", "<=1MB" or ">1MB" for the index in allocationsPerCategory.
+    static std::string GetCategoryName(int category);
+
+    // Formats the statistics into one line, for printing or logging.
+    static std::string FormatStats(PooledAllocatorStats const& stats);
+
+private:
+    struct Pool
+    {
+        std::mutex mutex;
+        std::vector<void*> freeBlocks;
+    };
+
+    int64_t const m_maxPooledBytes;
+    std::array<Pool, c_PooledAllocatorSizeClasses> m_pools;
+    std::atomic<int64_t> m_bytesAllocated = 0;
+    std::atomic<int64_t> m_peakBytesAllocated = 0;
+    std::atomic<int64_t> m_liveAllocations = 0;
+    std::atomic<int64_t> m_bytesPooled = 0;
+    std::atomic<uint64_t> m_totalAllocations = 0;
+    std::atomic<uint64_t> m_pooledAllocations = 0;
+    std::array<std::atomic<uint64_t>, c_PooledAllocatorCategories> m_allocationsPerCategory{};
+};
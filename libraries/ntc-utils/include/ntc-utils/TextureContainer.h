@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <libntc/ntc.h>
+#include <array>
+#include <string>
+
+struct TextureContainerMip
+{
+    uint64_t offset = 0; // Offset of the mip data from the beginning of the file
+    uint64_t size = 0;
+};
+
+// Describes a 2D texture stored in a DDS or KTX2 file with its mip chain.
+// Uncompressed data is stored with tightly packed rows, so it can be passed to WriteChannels directly.
+// Block compressed data needs to be decoded with DecodeBlockCompressedImage first.
+struct TextureContainerInfo
+{
+    int width = 0;
+    int height = 0;
+    int mips = 0;
+    int channels = 0; // Channel count of the stored pixels, or of the decoded pixels for BCn data
+    ntc::ChannelFormat channelFormat = ntc::ChannelFormat::UNKNOWN;
+    ntc::BlockCompressedFormat blockFormat = ntc::BlockCompressedFormat::None;
+    bool isSRGB = false;
+    bool isBGR = false; // 8-bit pixels stored in BGRA order
+    bool isSigned = false; // BC6H data with signed half-float values
+    std::array<TextureContainerMip, NTC_MAX_MIPS> mipData;
+};
+
+bool IsTextureContainerFileExtension(std::string const& extension);
+
+// Parses the DDS or KTX2 headers found in the file data. Mip levels beyond NTC_MAX_MIPS are ignored.
+// Only 2D textures with one array layer or face are supported, and KTX2 files can't be supercompressed.
+bool ReadTextureContainerInfo(void const* data, uint64_t size, TextureContainerInfo& outInfo,
+    std::string& outError);
+
+// Decodes BCn blocks into pixels with the channel count reported by ReadTextureContainerInfo:
+// 4 for BC1-BC3 and BC7, 1 for BC4, 2 for BC5 and 3 for BC6H. BC6H is decoded into FLOAT16 pixels,
+// with isSigned selecting the signed variant of the format, and the other formats into UNORM8 pixels.
+// The output rows are tightly packed.
+bool DecodeBlockCompressedImage(ntc::BlockCompressedFormat format, bool isSigned, void const* blocks,
+    uint64_t blocksSize, int width, int height, uint8_t* outPixels);
@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <ntc-utils/MappedFileStream.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Texture set data in archives starts at multiples of this alignment, which matches the common
+// disk sector and memory page sizes, so that each texture set can be read or uploaded directly.
+constexpr uint64_t c_TextureSetArchiveAlignment = 4096;
+
+// Index entry for one texture set stored in an archive.
+struct TextureSetArchiveEntry
+{
+    std::string name;            // Usually the path of the original file relative to the archive
+    uint64_t offset = 0;         // Offset of the NTC container from the beginning of the archive
+    uint64_t size = 0;           // Size of the NTC container
+    uint64_t descriptorSize = 0; // Size of the container header and JSON chunk, from the container start
+    ntc::StreamRange latents;    // Latents for all mip levels, relative to the container start
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int mips = 0;
+};
+
+// Read-only archive with many texture sets in one file, loaded with a single file mapping.
+class TextureSetArchive
+{
+public:
+    // Returns nullptr and sets 'outError' if the file cannot be opened or it's not a valid archive.
+    static std::unique_ptr<TextureSetArchive> Open(char const* fileName, std::string& outError);
+
+    // Entries are sorted by their offset in the archive.
+    std::vector<TextureSetArchiveEntry> const& GetEntries() const { return m_entries; }
+
+    // Returns nullptr if there is no entry with this name.
+    TextureSetArchiveEntry const* FindEntry(std::string const& name) const;
+
+    // Creates a stream over the NTC container of the entry. The stream reads from the archive mapping,
+    // so it must not outlive the archive, but multiple streams can be used on different threads at once.
+    std::unique_ptr<MappedFileStream> OpenEntry(TextureSetArchiveEntry const& entry) const;
+
+    // Starts reading the whole entry into memory, see MappedFileStream::Prefetch.
+    void PrefetchEntry(TextureSetArchiveEntry const& entry) const;
+
+private:
+    TextureSetArchive() = default;
+
+    std::unique_ptr<MappedFileStream> m_file;
+    std::vector<TextureSetArchiveEntry> m_entries;
+    std::unordered_map<std::string, size_t> m_entriesByName;
+};
+
+// Writes an archive sequentially: the texture sets go first, and the index is written by Close.
+class TextureSetArchiveWriter
+{
+public:
+    ~TextureSetArchiveWriter();
+
+    bool Open(char const* fileName, std::string& outError);
+
+    // Appends a serialized NTC container, such as the contents of an .ntc file. The metadata for the same
+    // container provides the dimensions and the latent range for the index. Names must be unique.
+    bool AddTextureSet(std::string const& name, void const* data, size_t size,
+        ntc::ITextureSetMetadata* metadata, std::string& outError);
+
+    // Writes the index and closes the file. The archive is not valid until Close succeeds.
+    bool Close(std::string& outError);
+
+private:
+    FILE* m_file = nullptr;
+    std::string m_fileName;
+    uint64_t m_position = 0;
+    std::vector<TextureSetArchiveEntry> m_entries;
+    std::unordered_map<std::string, size_t> m_entriesByName;
+
+    bool Write(void const* data, size_t size);
+};
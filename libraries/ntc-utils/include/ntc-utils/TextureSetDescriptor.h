@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <libntc/ntc.h>
+#include <string>
+#include <vector>
+
+// Texture entry of the JSON descriptor. Enumerations are kept as the strings stored in the file.
+struct TextureSetDescriptorTexture
+{
+    std::string name;
+    int firstChannel = 0;
+    int numChannels = 0;
+    std::string channelFormat = "UNORM8";
+    std::string rgbColorSpace = "Linear";
+    std::string alphaColorSpace = "Linear";
+    std::string bcFormat = "None";
+    int bcQuality = -1; // -1 if not specified
+    bool hasBcAccelerationData = false;
+};
+
+// Decompression network stored in the file, one per weight type.
+struct TextureSetDescriptorMlp
+{
+    std::string weightType; // Weight type of the first layer
+    std::vector<int> layerChannels; // Input channels of the first layer, then output channels of every layer
+};
+
+// Texture set parameters read from the header and JSON descriptor of an NTC container, without the library.
+// See docs/TextureSetFile.md for the meaning of the fields.
+struct TextureSetDescriptor
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int mips = 1;
+    bool hasLatentShape = false;
+    int highResFeatures = 0;
+    int lowResFeatures = 0;
+    int highResQuantBits = 0;
+    int lowResQuantBits = 0;
+    int latentMips = 0;
+    uint64_t descriptorSize = 0; // Size of the container header and JSON chunk
+    uint64_t dataSize = 0;       // Size of the data chunk
+    std::vector<TextureSetDescriptorTexture> textures;
+    std::vector<TextureSetDescriptorMlp> mlps;
+};
+
+// Reads the container header and the JSON chunk from the stream, and nothing else. Works with any stream,
+// including the page-compressed files opened with OpenTextureSetFile, where only the pages covering the
+// descriptor are inflated. Doesn't need an NTC context, so it can run on many threads at once.
+// Returns false and sets 'outError' if the stream doesn't contain a valid container.
+bool ReadTextureSetDescriptor(ntc::IStream* stream, TextureSetDescriptor& outDescriptor, std::string& outError);
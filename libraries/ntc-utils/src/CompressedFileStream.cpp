@@ -0,0 +1,456 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/CompressedFileStream.h>
+#include <lodepng.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#if NTC_WITH_DIRECTSTORAGE
+#include <dstorage.h>
+#include <wrl/client.h>
+#endif
+
+// File layout, little-endian:
+//   CompressedFileHeader
+//   CompressedFilePageEntry[pageCount]
+//   Page data, every page starts at a 4-byte aligned offset
+// Page N covers bytes [N * pageSize, min((N + 1) * pageSize, uncompressedSize)) of the texture set data.
+namespace
+{
+    constexpr char c_CompressedFileSignature[4] = { 'N', 'T', 'C', 'Z' };
+    constexpr uint32_t c_CompressedFileVersion = 2; // Version 1 files have no GDeflate pages
+    constexpr uint32_t c_PageFlagDeflate = 1; // Page is stored as a zlib stream
+    constexpr uint32_t c_PageFlagGDeflate = 2; // Page is stored as a GDeflate stream
+    // Pages with neither flag are stored as is
+
+    struct CompressedFileHeader
+    {
+        char signature[4];
+        uint32_t version;
+        uint32_t pageSize;
+        uint32_t pageCount;
+        uint64_t uncompressedSize;
+        uint64_t reserved;
+    };
+    static_assert(sizeof(CompressedFileHeader) == 32);
+
+    uint64_t GetPageLength(uint64_t size, uint32_t pageSize, uint32_t pageIndex)
+    {
+        uint64_t const pageStart = uint64_t(pageIndex) * pageSize;
+        return std::min<uint64_t>(pageSize, size - pageStart);
+    }
+
+    CompressedFileHeader const* GetValidHeader(void const* data, size_t size)
+    {
+        if (!data || size < sizeof(CompressedFileHeader))
+            return nullptr;
+
+        CompressedFileHeader const* header = static_cast<CompressedFileHeader const*>(data);
+        if (memcmp(header->signature, c_CompressedFileSignature, sizeof(c_CompressedFileSignature)) != 0 ||
+            header->version == 0 || header->version > c_CompressedFileVersion ||
+            header->pageSize == 0 ||
+            header->pageCount != (header->uncompressedSize + header->pageSize - 1) / header->pageSize)
+            return nullptr;
+
+        return header;
+    }
+}
+
+struct CompressedFilePageEntry
+{
+    uint64_t offset;     // From the beginning of the file
+    uint32_t storedSize;
+    uint32_t flags;
+};
+static_assert(sizeof(CompressedFilePageEntry) == 16);
+
+// DirectStorage CPU codec for the GDeflate pages. The codec is used by one thread at a time.
+struct GDeflateCodec
+{
+#if NTC_WITH_DIRECTSTORAGE
+    Microsoft::WRL::ComPtr<IDStorageCompressionCodec> codec;
+#endif
+
+    // Returns nullptr when the build doesn't include DirectStorage
+    static std::unique_ptr<GDeflateCodec> Create()
+    {
+#if NTC_WITH_DIRECTSTORAGE
+        std::unique_ptr<GDeflateCodec> result = std::make_unique<GDeflateCodec>();
+        // The pages are already processed in parallel, so the codec doesn't need its own threads
+        if (FAILED(DStorageCreateCompressionCodec(DSTORAGE_COMPRESSION_FORMAT_GDEFLATE, 1,
+            IID_PPV_ARGS(&result->codec))))
+            return nullptr;
+        return result;
+#else
+        return nullptr;
+#endif
+    }
+
+    bool Compress(void const* data, size_t size, std::vector<uint8_t>& outData)
+    {
+#if NTC_WITH_DIRECTSTORAGE
+        outData.resize(codec->CompressBufferBound(size));
+        size_t compressedSize = 0;
+        if (FAILED(codec->CompressBuffer(data, size, DSTORAGE_COMPRESSION_BEST_RATIO, outData.data(),
+            outData.size(), &compressedSize)))
+            return false;
+        outData.resize(compressedSize);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool Decompress(void const* data, size_t size, void* outData, size_t outSize)
+    {
+#if NTC_WITH_DIRECTSTORAGE
+        size_t decompressedSize = 0;
+        return SUCCEEDED(codec->DecompressBuffer(data, size, outData, outSize, &decompressedSize)) &&
+            decompressedSize == outSize;
+#else
+        return false;
+#endif
+    }
+};
+
+char const* GetCompressedFilePageFormatName(CompressedFilePageFormat format)
+{
+    switch (format)
+    {
+        case CompressedFilePageFormat::Deflate:
+            return "zlib";
+        case CompressedFilePageFormat::GDeflate:
+            return "GDeflate";
+        default:
+            return "Unknown";
+    }
+}
+
+bool IsGDeflateCodecAvailable()
+{
+    static bool const available = GDeflateCodec::Create() != nullptr;
+    return available;
+}
+
+CompressedFilePageFormat CompressTextureSetData(void const* data, size_t size, std::vector<uint8_t>& outData,
+    CompressedFilePageFormat format, int threadCount)
+{
+    uint8_t const* const input = static_cast<uint8_t const*>(data);
+    uint32_t const pageSize = c_CompressedFilePageSize;
+    uint32_t const pageCount = uint32_t((size + pageSize - 1) / pageSize);
+
+    if (format == CompressedFilePageFormat::GDeflate && !IsGDeflateCodecAvailable())
+        format = CompressedFilePageFormat::Deflate;
+    uint32_t const compressedPageFlag = (format == CompressedFilePageFormat::GDeflate)
+        ? c_PageFlagGDeflate
+        : c_PageFlagDeflate;
+
+    // Compressed page contents, empty for pages that are stored as is
+    std::vector<std::vector<uint8_t>> compressedPages(pageCount);
+    std::atomic<uint32_t> nextPage = 0;
+
+    auto compressPages = [&]()
+    {
+        LodePNGCompressSettings settings;
+        lodepng_compress_settings_init(&settings);
+        settings.windowsize = 32768;
+        settings.nicematch = 258;
+        settings.lazymatching = 1;
+
+        std::unique_ptr<GDeflateCodec> gdeflateCodec;
+        if (format == CompressedFilePageFormat::GDeflate)
+            gdeflateCodec = GDeflateCodec::Create();
+
+        for (uint32_t pageIndex = nextPage++; pageIndex < pageCount; pageIndex = nextPage++)
+        {
+            uint8_t const* pageData = input + uint64_t(pageIndex) * pageSize;
+            size_t const pageLength = size_t(GetPageLength(size, pageSize, pageIndex));
+
+            if (gdeflateCodec)
+            {
+                std::vector<uint8_t>& compressedPage = compressedPages[pageIndex];
+                if (!gdeflateCodec->Compress(pageData, pageLength, compressedPage) ||
+                    compressedPage.size() >= pageLength)
+                    compressedPage.clear();
+                continue;
+            }
+
+            unsigned char* compressedData = nullptr;
+            size_t compressedSize = 0;
+            unsigned const error = lodepng_zlib_compress(&compressedData, &compressedSize, pageData, pageLength,
+                &settings);
+
+            if (error == 0 && compressedSize < pageLength)
+                compressedPages[pageIndex].assign(compressedData, compressedData + compressedSize);
+
+            if (compressedData)
+                free(compressedData);
+        }
+    };
+
+    if (threadCount <= 0)
+        threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+    threadCount = std::max(1, std::min(threadCount, int(pageCount)));
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; ++i)
+        threads.emplace_back(compressPages);
+    compressPages();
+    for (std::thread& thread : threads)
+        thread.join();
+
+    // Lay out the pages after the header and the page table
+    std::vector<CompressedFilePageEntry> pageTable(pageCount);
+    uint64_t fileSize = sizeof(CompressedFileHeader) + sizeof(CompressedFilePageEntry) * uint64_t(pageCount);
+    for (uint32_t pageIndex = 0; pageIndex < pageCount; ++pageIndex)
+    {
+        bool const isCompressed = !compressedPages[pageIndex].empty();
+        CompressedFilePageEntry& entry = pageTable[pageIndex];
+        entry.offset = fileSize;
+        entry.storedSize = uint32_t(isCompressed
+            ? compressedPages[pageIndex].size()
+            : GetPageLength(size, pageSize, pageIndex));
+        entry.flags = isCompressed ? compressedPageFlag : 0;
+        fileSize += (uint64_t(entry.storedSize) + 3) & ~uint64_t(3);
+    }
+
+    CompressedFileHeader header{};
+    memcpy(header.signature, c_CompressedFileSignature, sizeof(header.signature));
+    // Files without GDeflate pages keep version 1, so that older readers can open them
+    header.version = (format == CompressedFilePageFormat::GDeflate) ? c_CompressedFileVersion : 1;
+    header.pageSize = pageSize;
+    header.pageCount = pageCount;
+    header.uncompressedSize = size;
+
+    // The alignment padding stays filled with zeros
+    outData.assign(size_t(fileSize), 0);
+    memcpy(outData.data(), &header, sizeof(header));
+    memcpy(outData.data() + sizeof(header), pageTable.data(),
+        pageTable.size() * sizeof(CompressedFilePageEntry));
+    for (uint32_t pageIndex = 0; pageIndex < pageCount; ++pageIndex)
+    {
+        CompressedFilePageEntry const& entry = pageTable[pageIndex];
+        uint8_t const* src = (entry.flags != 0)
+            ? compressedPages[pageIndex].data()
+            : input + uint64_t(pageIndex) * pageSize;
+        memcpy(outData.data() + entry.offset, src, entry.storedSize);
+    }
+
+    return format;
+}
+
+bool IsCompressedTextureSetData(void const* data, size_t size)
+{
+    return GetValidHeader(data, size) != nullptr;
+}
+
+std::unique_ptr<CompressedFileStream> CompressedFileStream::Open(char const* fileName, std::string* outErrorMessage)
+{
+    std::unique_ptr<MappedFileStream> file = MappedFileStream::Open(fileName, outErrorMessage);
+    if (!file)
+        return nullptr;
+
+    std::unique_ptr<CompressedFileStream> stream = Create(std::move(file));
+    if (!stream && outErrorMessage)
+        *outErrorMessage = "not a valid page-compressed file";
+    return stream;
+}
+
+std::unique_ptr<CompressedFileStream> CompressedFileStream::Create(std::unique_ptr<MappedFileStream>&& file)
+{
+    uint64_t const fileSize = file->Size();
+    size_t const headerSize = size_t(std::min<uint64_t>(fileSize, sizeof(CompressedFileHeader)));
+    CompressedFileHeader const* header = GetValidHeader(file->GetData(0, headerSize), headerSize);
+    if (!header)
+        return nullptr;
+
+    uint64_t const pageTableSize = sizeof(CompressedFilePageEntry) * uint64_t(header->pageCount);
+    CompressedFilePageEntry const* pages = static_cast<CompressedFilePageEntry const*>(
+        file->GetData(sizeof(CompressedFileHeader), pageTableSize));
+    if (!pages && header->pageCount != 0)
+        return nullptr;
+
+    // Validate the page table once, so that reading doesn't need to check the ranges
+    CompressedFilePageFormat pageFormat = CompressedFilePageFormat::Deflate;
+    uint32_t const validFlags = (header->version >= 2) ? (c_PageFlagDeflate | c_PageFlagGDeflate) : c_PageFlagDeflate;
+    for (uint32_t pageIndex = 0; pageIndex < header->pageCount; ++pageIndex)
+    {
+        CompressedFilePageEntry const& page = pages[pageIndex];
+        uint64_t const pageLength = GetPageLength(header->uncompressedSize, header->pageSize, pageIndex);
+        if (page.offset > fileSize || page.storedSize > fileSize - page.offset)
+            return nullptr;
+        if ((page.flags & ~validFlags) != 0 || page.flags == (c_PageFlagDeflate | c_PageFlagGDeflate))
+            return nullptr;
+        if (page.flags == 0 && page.storedSize != pageLength)
+            return nullptr;
+        if (page.flags == c_PageFlagGDeflate)
+            pageFormat = CompressedFilePageFormat::GDeflate;
+    }
+
+    std::unique_ptr<CompressedFileStream> stream(new CompressedFileStream());
+    stream->m_pageFormat = pageFormat;
+    stream->m_pages = pages;
+    stream->m_pageSize = header->pageSize;
+    stream->m_pageCount = header->pageCount;
+    stream->m_size = header->uncompressedSize;
+    stream->m_file = std::move(file);
+    return stream;
+}
+
+CompressedFileStream::~CompressedFileStream() = default;
+
+CompressedFileStream::PageInfo CompressedFileStream::GetPageInfo(uint32_t pageIndex) const
+{
+    CompressedFilePageEntry const& page = m_pages[pageIndex];
+
+    PageInfo info;
+    info.uncompressedOffset = uint64_t(pageIndex) * m_pageSize;
+    info.uncompressedSize = uint32_t(GetPageLength(m_size, m_pageSize, pageIndex));
+    info.storedData = m_file->GetData(page.offset, page.storedSize);
+    info.storedSize = page.storedSize;
+    info.isDeflate = page.flags == c_PageFlagDeflate;
+    info.isGDeflate = page.flags == c_PageFlagGDeflate;
+    return info;
+}
+
+bool CompressedFileStream::DecompressPage(uint32_t pageIndex)
+{
+    if (m_decompressedPage == int64_t(pageIndex))
+        return true;
+
+    CompressedFilePageEntry const& page = m_pages[pageIndex];
+    uint64_t const pageLength = GetPageLength(m_size, m_pageSize, pageIndex);
+    void const* storedData = m_file->GetData(page.offset, page.storedSize);
+
+    if (page.flags == c_PageFlagGDeflate)
+    {
+        if (!m_gdeflateCodec)
+            m_gdeflateCodec = GDeflateCodec::Create();
+        if (!m_gdeflateCodec)
+            return false;
+
+        m_pageData.resize(m_pageSize);
+        if (!m_gdeflateCodec->Decompress(storedData, page.storedSize, m_pageData.data(), size_t(pageLength)))
+            return false;
+
+        m_decompressedPage = pageIndex;
+        return true;
+    }
+
+    LodePNGDecompressSettings settings;
+    lodepng_decompress_settings_init(&settings);
+
+    unsigned char* inflatedData = nullptr;
+    size_t inflatedSize = 0;
+    unsigned const error = lodepng_zlib_decompress(&inflatedData, &inflatedSize,
+        static_cast<unsigned char const*>(storedData), page.storedSize, &settings);
+
+    bool const success = error == 0 && inflatedSize == pageLength;
+    if (success)
+    {
+        m_pageData.resize(m_pageSize);
+        memcpy(m_pageData.data(), inflatedData, inflatedSize);
+        m_decompressedPage = pageIndex;
+    }
+
+    if (inflatedData)
+        free(inflatedData);
+
+    return success;
+}
+
+bool CompressedFileStream::Read(void* dataPtr, size_t size)
+{
+    if (size == 0)
+        return true;
+
+    if (m_position > m_size || size > m_size - m_position)
+        return false;
+
+    uint8_t* dst = static_cast<uint8_t*>(dataPtr);
+    while (size != 0)
+    {
+        uint32_t const pageIndex = uint32_t(m_position / m_pageSize);
+        uint64_t const pageOffset = m_position % m_pageSize;
+        size_t const chunkSize = size_t(std::min<uint64_t>(size,
+            GetPageLength(m_size, m_pageSize, pageIndex) - pageOffset));
+
+        CompressedFilePageEntry const& page = m_pages[pageIndex];
+        uint8_t const* src;
+        if (page.flags != 0)
+        {
+            if (!DecompressPage(pageIndex))
+                return false;
+            src = m_pageData.data() + pageOffset;
+        }
+        else
+        {
+            src = static_cast<uint8_t const*>(m_file->GetData(page.offset + pageOffset, chunkSize));
+        }
+
+        memcpy(dst, src, chunkSize);
+        dst += chunkSize;
+        size -= chunkSize;
+        m_position += chunkSize;
+    }
+
+    return true;
+}
+
+bool CompressedFileStream::Write(void const* /* dataPtr */, size_t /* size */)
+{
+    return false;
+}
+
+bool CompressedFileStream::Seek(uint64_t offset)
+{
+    if (offset > m_size)
+        return false;
+
+    m_position = offset;
+    return true;
+}
+
+uint64_t CompressedFileStream::Tell()
+{
+    return m_position;
+}
+
+uint64_t CompressedFileStream::Size()
+{
+    return m_size;
+}
+
+uint64_t CompressedFileStream::GetStoredSize() const
+{
+    return m_file->Size();
+}
+
+std::unique_ptr<ntc::IStream> OpenTextureSetFile(char const* fileName, std::string* outErrorMessage)
+{
+    std::unique_ptr<MappedFileStream> file = MappedFileStream::Open(fileName, outErrorMessage);
+    if (!file)
+        return nullptr;
+
+    size_t const headerSize = size_t(std::min<uint64_t>(file->Size(), sizeof(CompressedFileHeader)));
+    if (!IsCompressedTextureSetData(file->GetData(0, headerSize), headerSize))
+        return file;
+
+    std::unique_ptr<CompressedFileStream> stream = CompressedFileStream::Create(std::move(file));
+    if (!stream && outErrorMessage)
+        *outErrorMessage = "not a valid page-compressed file";
+    return stream;
+}
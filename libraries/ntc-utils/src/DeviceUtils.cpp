@@ -12,6 +12,7 @@
 
 #if NTC_WITH_DX12
 #include <directx/d3d12.h>
+#include <dxgi1_4.h>
 extern "C"
 {
     _declspec(dllexport) extern const unsigned int D3D12SDKVersion = D3D12_PREVIEW_SDK_VERSION;
@@ -24,6 +25,11 @@ extern "C"
 #include <libntc/ntc.h>
 #include <donut/app/DeviceManager.h>
 #include <donut/core/log.h>
+#include <cstdio>
+
+#if NTC_WITH_VULKAN
+#include <vulkan/vulkan.hpp>
+#endif
 
 #if NTC_WITH_DX12
 static bool g_dx12DeveloperModeEnabled = false;
@@ -91,6 +97,54 @@ bool IsDX12DeveloperModeEnabled()
 #endif
 }
 
+bool IsCopyQueueUploadSupported(nvrhi::IDevice* device)
+{
+    return device->getGraphicsAPI() == nvrhi::GraphicsAPI::D3D12 &&
+        device->queryFeatureSupport(nvrhi::Feature::CopyQueue);
+}
+
+std::string GetAdapterIdentifier(nvrhi::IDevice* device)
+{
+    char identifier[384] = "";
+
+#if NTC_WITH_VULKAN
+    if (device->getGraphicsAPI() == nvrhi::GraphicsAPI::VULKAN)
+    {
+        VkPhysicalDevice physicalDevice = device->getNativeObject(nvrhi::ObjectTypes::VK_PhysicalDevice);
+        vk::PhysicalDeviceProperties const properties = vk::PhysicalDevice(physicalDevice).getProperties();
+        snprintf(identifier, sizeof(identifier), "VK %04x:%04x %s, driver %08x",
+            properties.vendorID, properties.deviceID, properties.deviceName.data(), properties.driverVersion);
+    }
+#endif
+
+#if NTC_WITH_DX12
+    if (device->getGraphicsAPI() == nvrhi::GraphicsAPI::D3D12)
+    {
+        ID3D12Device* d3d12Device = device->getNativeObject(nvrhi::ObjectTypes::D3D12_Device);
+        nvrhi::RefCountPtr<IDXGIFactory4> factory;
+        nvrhi::RefCountPtr<IDXGIAdapter1> adapter;
+        DXGI_ADAPTER_DESC1 desc{};
+        if (SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&factory))) &&
+            SUCCEEDED(factory->EnumAdapterByLuid(d3d12Device->GetAdapterLuid(), IID_PPV_ARGS(&adapter))) &&
+            SUCCEEDED(adapter->GetDesc1(&desc)))
+        {
+            // The UMD version is only reported through the legacy IDXGIDevice interface query
+            LARGE_INTEGER driverVersion{};
+            adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion);
+
+            char name[256] = "";
+            WideCharToMultiByte(CP_UTF8, 0, desc.Description, -1, name, sizeof(name), nullptr, nullptr);
+            snprintf(identifier, sizeof(identifier), "DX12 %04x:%04x %s, driver %u.%u.%u.%u",
+                desc.VendorId, desc.DeviceId, name,
+                HIWORD(driverVersion.HighPart), LOWORD(driverVersion.HighPart),
+                HIWORD(driverVersion.LowPart), LOWORD(driverVersion.LowPart));
+        }
+    }
+#endif
+
+    return identifier;
+}
+
 void SetNtcGraphicsDeviceParameters(
     donut::app::DeviceCreationParameters& deviceParams,
     nvrhi::GraphicsAPI graphicsApi,
@@ -11,6 +11,8 @@
  */
 
 #include <ntc-utils/GraphicsBlockCompressionPass.h>
+#include <algorithm>
+#include <cassert>
 
 bool GraphicsBlockCompressionPass::Init()
 {
@@ -38,9 +40,7 @@ bool GraphicsBlockCompressionPass::Init()
     return true;
 }
 
-bool GraphicsBlockCompressionPass::ExecuteComputePass(nvrhi::ICommandList* commandList, ntc::ComputePassDesc& computePass,
-    nvrhi::ITexture* inputTexture, nvrhi::Format inputFormat, int inputMipLevel,
-    nvrhi::ITexture* outputTexture, int outputMipLevel, nvrhi::IBuffer* accelerationBuffer)
+nvrhi::IComputePipeline* GraphicsBlockCompressionPass::GetOrCreatePipeline(ntc::ComputePassDesc const& computePass)
 {
     // Create the pipeline for this shader if it doesn't exist yet
     auto& pipeline = m_pipelines[computePass.computeShader];
@@ -55,17 +55,19 @@ bool GraphicsBlockCompressionPass::ExecuteComputePass(nvrhi::ICommandList* comma
             .addBindingLayout(m_bindingLayout);
 
         pipeline = m_device->createComputePipeline(pipelineDesc);
-
-        if (!pipeline)
-            return false;
     }
 
+    return pipeline;
+}
+
+bool GraphicsBlockCompressionPass::CreateConstantBuffer(size_t size)
+{
     // Create the constant buffer if it doesn't exist yet or if it is too small (which shouldn't happen currently)
-    if (!m_constantBuffer || m_constantBuffer->getDesc().byteSize < computePass.constantBufferSize)
+    if (!m_constantBuffer || m_constantBuffer->getDesc().byteSize < size)
     {
         nvrhi::BufferDesc constantBufferDesc;
         constantBufferDesc
-            .setByteSize(computePass.constantBufferSize)
+            .setByteSize(size)
             .setDebugName("BlockCompressionConstants")
             .setIsConstantBuffer(true)
             .setIsVolatile(true)
@@ -77,6 +79,13 @@ bool GraphicsBlockCompressionPass::ExecuteComputePass(nvrhi::ICommandList* comma
             return false;
     }
 
+    return true;
+}
+
+nvrhi::IBindingSet* GraphicsBlockCompressionPass::GetOrCreateBindingSet(nvrhi::ITexture* inputTexture,
+    nvrhi::Format inputFormat, int inputMipLevel, nvrhi::ITexture* outputTexture, int outputMipLevel,
+    nvrhi::IBuffer* accelerationBuffer)
+{
     nvrhi::BindingSetDesc bindingSetDesc;
     bindingSetDesc
         .addItem(nvrhi::BindingSetItem::ConstantBuffer(0, m_constantBuffer))
@@ -88,7 +97,22 @@ bool GraphicsBlockCompressionPass::ExecuteComputePass(nvrhi::ICommandList* comma
     if (accelerationBuffer)
         bindingSetDesc.addItem(nvrhi::BindingSetItem::RawBuffer_UAV(3, accelerationBuffer));
 
-    nvrhi::BindingSetHandle bindingSet = m_bindingCache.GetOrCreateBindingSet(bindingSetDesc, m_bindingLayout);
+    return m_bindingCache.GetOrCreateBindingSet(bindingSetDesc, m_bindingLayout);
+}
+
+bool GraphicsBlockCompressionPass::ExecuteComputePass(nvrhi::ICommandList* commandList, ntc::ComputePassDesc& computePass,
+    nvrhi::ITexture* inputTexture, nvrhi::Format inputFormat, int inputMipLevel,
+    nvrhi::ITexture* outputTexture, int outputMipLevel, nvrhi::IBuffer* accelerationBuffer)
+{
+    nvrhi::IComputePipeline* pipeline = GetOrCreatePipeline(computePass);
+    if (!pipeline)
+        return false;
+
+    if (!CreateConstantBuffer(computePass.constantBufferSize))
+        return false;
+
+    nvrhi::IBindingSet* bindingSet = GetOrCreateBindingSet(inputTexture, inputFormat, inputMipLevel,
+        outputTexture, outputMipLevel, accelerationBuffer);
     if (!bindingSet)
         return false;
 
@@ -101,4 +125,106 @@ bool GraphicsBlockCompressionPass::ExecuteComputePass(nvrhi::ICommandList* comma
     commandList->dispatch(computePass.dispatchWidth, computePass.dispatchHeight);
 
     return true;
-}
\ No newline at end of file
+}
+
+bool GraphicsBlockCompressionPass::ExecuteBatch(nvrhi::ICommandList* commandList, ntc::IContext* context,
+    std::vector<BlockCompressionJob> const& jobs, int* outFailedJob, ntc::Status* outStatus)
+{
+    assert(!m_useAccelerationBuffer);
+    if (jobs.empty())
+        return true;
+
+    auto fail = [outFailedJob, outStatus, &jobs](BlockCompressionJob const* job, ntc::Status status)
+    {
+        if (outFailedJob)
+            *outFailedJob = int(job - jobs.data());
+        if (outStatus)
+            *outStatus = status;
+        return false;
+    };
+
+    struct PreparedJob
+    {
+        BlockCompressionJob const* job;
+        nvrhi::IComputePipeline* pipeline;
+        size_t constantsOffset;
+        size_t constantsSize;
+        uint32_t dispatchWidth;
+        uint32_t dispatchHeight;
+    };
+    std::vector<PreparedJob> preparedJobs;
+    preparedJobs.reserve(jobs.size());
+
+    // The constants returned by MakeBlockCompressionComputePass are only valid until the next call,
+    // so keep a copy of them for every job
+    std::vector<uint8_t> constants;
+
+    for (BlockCompressionJob const& job : jobs)
+    {
+        ntc::ComputePassDesc computePass;
+        ntc::Status const status = context->MakeBlockCompressionComputePass(job.params, &computePass);
+        if (status != ntc::Status::Ok)
+            return fail(&job, status);
+
+        nvrhi::IComputePipeline* pipeline = GetOrCreatePipeline(computePass);
+        if (!pipeline)
+            return fail(&job, ntc::Status::Ok);
+
+        if (!CreateConstantBuffer(computePass.constantBufferSize))
+            return fail(&job, ntc::Status::Ok);
+
+        PreparedJob& preparedJob = preparedJobs.emplace_back();
+        preparedJob.job = &job;
+        preparedJob.pipeline = pipeline;
+        preparedJob.constantsOffset = constants.size();
+        preparedJob.constantsSize = computePass.constantBufferSize;
+        preparedJob.dispatchWidth = computePass.dispatchWidth;
+        preparedJob.dispatchHeight = computePass.dispatchHeight;
+
+        uint8_t const* constantBufferData = static_cast<uint8_t const*>(computePass.constantBufferData);
+        constants.insert(constants.end(), constantBufferData, constantBufferData + computePass.constantBufferSize);
+    }
+
+    std::stable_sort(preparedJobs.begin(), preparedJobs.end(), [](PreparedJob const& a, PreparedJob const& b)
+    {
+        return a.pipeline < b.pipeline;
+    });
+
+    // Make all transitions at once, so that the dispatches are not separated by barriers and can overlap
+    for (PreparedJob const& preparedJob : preparedJobs)
+    {
+        BlockCompressionJob const& job = *preparedJob.job;
+        commandList->setTextureState(job.inputTexture, nvrhi::TextureSubresourceSet(job.inputMipLevel, 1, 0, 1),
+            nvrhi::ResourceStates::ShaderResource);
+        commandList->setTextureState(job.outputTexture, nvrhi::TextureSubresourceSet(job.outputMipLevel, 1, 0, 1),
+            nvrhi::ResourceStates::UnorderedAccess);
+        commandList->setEnableUavBarriersForTexture(job.outputTexture, false);
+    }
+    commandList->commitBarriers();
+
+    bool success = true;
+    for (PreparedJob const& preparedJob : preparedJobs)
+    {
+        BlockCompressionJob const& job = *preparedJob.job;
+        nvrhi::IBindingSet* bindingSet = GetOrCreateBindingSet(job.inputTexture, job.inputFormat, job.inputMipLevel,
+            job.outputTexture, job.outputMipLevel, nullptr);
+        if (!bindingSet)
+        {
+            success = fail(&job, ntc::Status::Ok);
+            break;
+        }
+
+        commandList->writeBuffer(m_constantBuffer, constants.data() + preparedJob.constantsOffset,
+            preparedJob.constantsSize);
+        auto state = nvrhi::ComputeState()
+            .setPipeline(preparedJob.pipeline)
+            .addBindingSet(bindingSet);
+        commandList->setComputeState(state);
+        commandList->dispatch(preparedJob.dispatchWidth, preparedJob.dispatchHeight);
+    }
+
+    for (BlockCompressionJob const& job : jobs)
+        commandList->setEnableUavBarriersForTexture(job.outputTexture, true);
+
+    return success;
+}
@@ -11,6 +11,7 @@
  */
 
 #include <ntc-utils/GraphicsDecompressionPass.h>
+#include <ntc-utils/MappedFileStream.h>
 
 bool GraphicsDecompressionPass::Init()
 {
@@ -79,12 +80,31 @@ bool GraphicsDecompressionPass::SetInputData(nvrhi::ICommandList* commandList, n
         range.size = inputStream->Size();
     }
 
+    // Mapped files don't need the intermediate copy
+    void const* mappedData = MappedFileStream::GetStreamData(inputStream, range.offset, range.size);
+    if (mappedData)
+        return SetInputData(commandList, mappedData, range.size);
+
+    std::vector<uint8_t> latentsBuffer;
+    latentsBuffer.resize(range.size);
+
+    if (!inputStream->Seek(range.offset))
+        return false;
+        
+    if (!inputStream->Read(latentsBuffer.data(), latentsBuffer.size()))
+        return false;
+
+    return SetInputData(commandList, latentsBuffer.data(), latentsBuffer.size());
+}
+
+bool GraphicsDecompressionPass::SetInputData(nvrhi::ICommandList* commandList, void const* data, size_t size)
+{
     // Make sure that the decompression input and staging buffers exist and have sufficient size
-    if (!m_inputBuffer || m_inputBufferIsExternal || m_inputBuffer->getDesc().byteSize < range.size)
+    if (!m_inputBuffer || m_inputBufferIsExternal || m_inputBuffer->getDesc().byteSize < size)
     {
         nvrhi::BufferDesc inputBufferDesc;
         inputBufferDesc
-            .setByteSize(range.size)
+            .setByteSize(size)
             .setDebugName("DecompressionInputData")
             .setCanHaveRawViews(true)
             .setInitialState(nvrhi::ResourceStates::ShaderResource)
@@ -97,22 +117,15 @@ bool GraphicsDecompressionPass::SetInputData(nvrhi::ICommandList* commandList, n
             return false;
     }
 
-    std::vector<uint8_t> latentsBuffer;
-    latentsBuffer.resize(range.size);
-
-    if (!inputStream->Seek(range.offset))
-        return false;
-        
-    if (!inputStream->Read(latentsBuffer.data(), latentsBuffer.size()))
-        return false;
-
-    commandList->writeBuffer(m_inputBuffer, latentsBuffer.data(), latentsBuffer.size());
+    m_inputBufferRange = nvrhi::EntireBuffer;
+    commandList->writeBuffer(m_inputBuffer, data, size);
 
     return true;
 }
 
-void GraphicsDecompressionPass::SetInputBuffer(nvrhi::IBuffer* buffer)
+void GraphicsDecompressionPass::SetInputBuffer(nvrhi::IBuffer* buffer, nvrhi::BufferRange range)
 {
+    m_inputBufferRange = range;
     if (buffer == m_inputBuffer)
         return;
     
@@ -167,6 +180,7 @@ bool GraphicsDecompressionPass::SetWeightsFromTextureSet(nvrhi::ICommandList* co
         if (!m_weightBuffer)
             return false;
     }
+    m_weightBufferRange = nvrhi::EntireBuffer;
 
     if (uploadBufferNeeded)
     {
@@ -204,8 +218,9 @@ bool GraphicsDecompressionPass::SetWeightsFromTextureSet(nvrhi::ICommandList* co
     return true;
 }
 
-void GraphicsDecompressionPass::SetWeightBuffer(nvrhi::IBuffer* buffer)
+void GraphicsDecompressionPass::SetWeightBuffer(nvrhi::IBuffer* buffer, nvrhi::BufferRange range)
 {
+    m_weightBufferRange = range;
     if (buffer == m_weightBuffer)
         return;
         
@@ -255,8 +270,8 @@ bool GraphicsDecompressionPass::ExecuteComputePass(nvrhi::ICommandList* commandL
     nvrhi::BindingSetDesc bindingSetDesc;
     bindingSetDesc
         .addItem(nvrhi::BindingSetItem::ConstantBuffer(0, m_constantBuffer))
-        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(1, m_inputBuffer))
-        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(2, m_weightBuffer));
+        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(1, m_inputBuffer, m_inputBufferRange))
+        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(2, m_weightBuffer, m_weightBufferRange));
     nvrhi::BindingSetHandle bindingSet = m_bindingCache.GetOrCreateBindingSet(bindingSetDesc, m_bindingLayout);
     if (!bindingSet)
         return false;
@@ -11,10 +11,14 @@
  */
 
 #include <ntc-utils/Manifest.h>
+#include <ntc-utils/MappedFileStream.h>
+#include <ntc-utils/TextureContainer.h>
 #include <filesystem>
 #include <json/value.h>
 #include <json/reader.h>
 #include <algorithm>
+#include <memory>
+#include <unordered_set>
 
 namespace fs = std::filesystem;
 
@@ -76,7 +80,8 @@ static void ComputeDistinctImageNames(Manifest& manifest)
     }
 }
 
-void GenerateManifestFromDirectory(const char* path, bool loadMips, Manifest& outManifest)
+void GenerateManifestFromDirectory(const char* path, bool loadMips, Manifest& outManifest,
+    bool includeTextureContainers)
 {
     for (const fs::directory_entry& directoryEntry : fs::directory_iterator(path))
     {
@@ -86,7 +91,8 @@ void GenerateManifestFromDirectory(const char* path, bool loadMips, Manifest& ou
         std::string extension = fileName.extension().generic_string();
         LowercaseString(extension);
 
-        if (!IsSupportedImageFileExtension(extension))
+        if (!IsSupportedImageFileExtension(extension) &&
+            !(includeTextureContainers && IsTextureContainerFileExtension(extension)))
             continue;
 
         ManifestEntry& entry = outManifest.textures.emplace_back();
@@ -97,6 +103,11 @@ void GenerateManifestFromDirectory(const char* path, bool loadMips, Manifest& ou
 
     if (loadMips)
     {
+        // Look up the mip 0 entries by name, the directory may contain many images
+        std::unordered_set<std::string> entryNames;
+        for (ManifestEntry const& entry : outManifest.textures)
+            entryNames.insert(entry.entryName);
+
         for (const fs::directory_entry& directoryEntry : fs::directory_iterator(fs::path(path) / "mips"))
         {
             const fs::path& fileName = directoryEntry.path();
@@ -115,10 +126,7 @@ void GenerateManifestFromDirectory(const char* path, bool loadMips, Manifest& ou
             if (mip.empty() || name.empty())
                 continue;
 
-            auto found = std::find_if(outManifest.textures.begin(), outManifest.textures.end(),
-                [&name](const ManifestEntry& entry) { return entry.entryName == name; });
-
-            if (found == outManifest.textures.end())
+            if (entryNames.find(name.generic_string()) == entryNames.end())
                 continue;
             
             int mipLevel = 0;
@@ -153,19 +161,6 @@ void GenerateManifestFromFileList(std::vector<const char *> const &files, Manife
     ComputeDistinctImageNames(outManifest);
 }
 
-static bool ReadFileIntoVector(FILE* inputFile, std::vector<char>& vector)
-{
-    if (fseek(inputFile, 0, SEEK_END))
-        return false;
-    long fileSize = ftell(inputFile);
-    if (fseek(inputFile, 0, SEEK_SET))
-        return false;
-    vector.resize(fileSize);
-    if (fread(vector.data(), fileSize, 1, inputFile) != 1)
-        return false;
-    return true;
-}
-
 std::optional<ntc::BlockCompressedFormat> ParseBlockCompressedFormat(char const* format, bool enableAuto)
 {
     if (!format || !format[0])
@@ -288,34 +283,35 @@ int GetSemanticChannelCount(SemanticLabel label)
 
 bool ReadManifestFromFile(const char* fileName, Manifest& outManifest, std::string& outError)
 {
-    Json::CharReaderBuilder builder;
-    builder["collectComments"] = false;
-    Json::CharReader* reader = builder.newCharReader();
-
-    FILE* inputFile = fopen(fileName, "rb");
+    // Parse the JSON straight from the file mapping instead of copying the file into memory first
+    std::string openError;
+    std::unique_ptr<MappedFileStream> inputFile = MappedFileStream::Open(fileName, &openError);
     if (!inputFile)
     {
         std::ostringstream oss;
-        oss << "Cannot open manifest file '" << fileName << "': " << strerror(errno);
+        oss << "Cannot open manifest file '" << fileName << "': " << openError;
         outError = oss.str();
         return false;
     }
 
-    std::vector<char> fileContents;
-    bool success = ReadFileIntoVector(inputFile, fileContents);
-    fclose(inputFile);
-    
-    if (!success)
-    {
-        std::ostringstream oss;
-        oss << "Error while reading manifest file '" << fileName << "': " << strerror(errno);
-        outError = oss.str();
-        return false;
-    }
+    uint64_t const fileSize = inputFile->Size();
+    char const* fileContents = fileSize != 0
+        ? static_cast<char const*>(inputFile->GetData(0, fileSize))
+        : "";
+
+    return ReadManifestFromMemory(fileContents, size_t(fileSize), fileName, outManifest, outError);
+}
+
+bool ReadManifestFromMemory(char const* data, size_t size, const char* fileName, Manifest& outManifest,
+    std::string& outError)
+{
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
 
     Json::Value root;
     Json::String errorMessages;
-    if (!reader->parse(fileContents.data(), fileContents.data() + fileContents.size(), &root, &errorMessages))
+    if (!reader->parse(data, data + size, &root, &errorMessages))
     {
         std::ostringstream oss;
         oss << "Cannot parse manifest file '" << fileName << "': " << errorMessages;
@@ -481,6 +477,7 @@ void UpdateToolInputType(ToolInputType& current, ToolInputType newInput)
         case ToolInputType::Directory:
         case ToolInputType::CompressedTextureSet:
         case ToolInputType::Manifest:
+        case ToolInputType::MaterialAtlas:
             // Mismatching input types or using more than one of these is not allowed
             current = ToolInputType::Mixed;
             return;
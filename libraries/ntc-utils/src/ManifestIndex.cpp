@@ -0,0 +1,480 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/ManifestIndex.h>
+#include <ntc-utils/MappedFileStream.h>
+#include <ntc-utils/TextureContainer.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Cache file layout:
+    //   magic, flags (uint32), manifest extension (string), directory count (uint32), directories.
+    // Each directory:
+    //   path (string), modification time (int64), has images (uint8),
+    //   subdirectory count (uint32), subdirectory names, manifest count (uint32), manifest names.
+    // Strings are stored as a uint32 length followed by the characters.
+    constexpr char c_IndexMagic[8] = { 'N', 'T', 'C', 'M', 'I', 'D', 'X', '2' };
+    constexpr uint32_t c_IndexFlagTextureContainers = 1;
+
+    struct DirectoryListing
+    {
+        int64_t modificationTime = 0;
+        std::vector<std::string> subdirectories;
+        std::vector<std::string> manifests;
+        bool hasImages = false;
+    };
+
+    using DirectoryIndex = std::unordered_map<std::string, DirectoryListing>;
+
+    class IndexReader
+    {
+    public:
+        IndexReader(uint8_t const* data, uint64_t size)
+            : m_data(data)
+            , m_size(size)
+        { }
+
+        bool Read(void* dst, uint64_t size)
+        {
+            if (size > m_size - m_position)
+                return false;
+            memcpy(dst, m_data + m_position, size);
+            m_position += size;
+            return true;
+        }
+
+        template<typename T>
+        bool Read(T& value)
+        {
+            return Read(&value, sizeof(T));
+        }
+
+        bool Read(std::string& value)
+        {
+            uint32_t length = 0;
+            if (!Read(length) || length > m_size - m_position)
+                return false;
+            value.assign(reinterpret_cast<char const*>(m_data + m_position), length);
+            m_position += length;
+            return true;
+        }
+
+        bool Read(std::vector<std::string>& values)
+        {
+            uint32_t count = 0;
+            if (!Read(count) || count > m_size - m_position)
+                return false;
+            values.resize(count);
+            for (std::string& value : values)
+            {
+                if (!Read(value))
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        uint8_t const* m_data;
+        uint64_t m_size;
+        uint64_t m_position = 0;
+    };
+
+    class IndexWriter
+    {
+    public:
+        void Write(void const* src, size_t size)
+        {
+            uint8_t const* bytes = static_cast<uint8_t const*>(src);
+            m_data.insert(m_data.end(), bytes, bytes + size);
+        }
+
+        template<typename T>
+        void Write(T const& value)
+        {
+            Write(&value, sizeof(T));
+        }
+
+        void Write(std::string const& value)
+        {
+            Write(uint32_t(value.size()));
+            Write(value.data(), value.size());
+        }
+
+        void Write(std::vector<std::string> const& values)
+        {
+            Write(uint32_t(values.size()));
+            for (std::string const& value : values)
+                Write(value);
+        }
+
+        std::vector<uint8_t> const& GetData() const { return m_data; }
+
+    private:
+        std::vector<uint8_t> m_data;
+    };
+
+    uint32_t GetIndexFlags(ManifestIndexParameters const& params)
+    {
+        return params.includeTextureContainers ? c_IndexFlagTextureContainers : 0;
+    }
+
+    // Loads the cached index. A missing, stale or damaged cache file is not an error, it just leaves the index empty.
+    void ReadDirectoryIndex(char const* fileName, uint32_t flags, std::string const& manifestExtension,
+        DirectoryIndex& outIndex)
+    {
+        std::unique_ptr<MappedFileStream> file = MappedFileStream::Open(fileName);
+        if (!file || file->Size() == 0)
+            return;
+
+        IndexReader reader(static_cast<uint8_t const*>(file->GetData(0, file->Size())), file->Size());
+
+        char magic[sizeof(c_IndexMagic)];
+        uint32_t fileFlags = 0;
+        std::string fileManifestExtension;
+        uint32_t directoryCount = 0;
+        if (!reader.Read(magic, sizeof(magic)) || memcmp(magic, c_IndexMagic, sizeof(magic)) != 0 ||
+            !reader.Read(fileFlags) || fileFlags != flags ||
+            !reader.Read(fileManifestExtension) || fileManifestExtension != manifestExtension ||
+            !reader.Read(directoryCount))
+            return;
+
+        DirectoryIndex index;
+        index.reserve(directoryCount);
+        for (uint32_t i = 0; i < directoryCount; ++i)
+        {
+            std::string path;
+            DirectoryListing listing;
+            uint8_t hasImages = 0;
+            if (!reader.Read(path) || !reader.Read(listing.modificationTime) || !reader.Read(hasImages) ||
+                !reader.Read(listing.subdirectories) || !reader.Read(listing.manifests))
+                return;
+
+            listing.hasImages = hasImages != 0;
+            index.emplace(std::move(path), std::move(listing));
+        }
+
+        outIndex = std::move(index);
+    }
+
+    // Writes the index into a temporary file first, so that an interrupted scan doesn't leave a damaged cache behind.
+    bool WriteDirectoryIndex(char const* fileName, uint32_t flags, std::string const& manifestExtension,
+        DirectoryIndex const& index, std::string& outError)
+    {
+        IndexWriter writer;
+        writer.Write(c_IndexMagic, sizeof(c_IndexMagic));
+        writer.Write(flags);
+        writer.Write(manifestExtension);
+        writer.Write(uint32_t(index.size()));
+        for (auto const& [path, listing] : index)
+        {
+            writer.Write(path);
+            writer.Write(listing.modificationTime);
+            writer.Write(uint8_t(listing.hasImages ? 1 : 0));
+            writer.Write(listing.subdirectories);
+            writer.Write(listing.manifests);
+        }
+
+        std::string const temporaryFileName = std::string(fileName) + ".tmp";
+        FILE* file = fopen(temporaryFileName.c_str(), "wb");
+        if (!file)
+        {
+            outError = std::string("Cannot open '") + temporaryFileName + "' for writing: " + strerror(errno);
+            return false;
+        }
+
+        std::vector<uint8_t> const& data = writer.GetData();
+        bool const success = fwrite(data.data(), data.size(), 1, file) == 1;
+        fclose(file);
+        if (!success)
+        {
+            outError = std::string("Failed to write '") + temporaryFileName + "'.";
+            return false;
+        }
+
+        std::error_code ec;
+        fs::rename(temporaryFileName, fileName, ec);
+        if (ec)
+        {
+            outError = std::string("Cannot rename '") + temporaryFileName + "' to '" + fileName + "': " + ec.message();
+            return false;
+        }
+
+        return true;
+    }
+
+    class DirectoryScanner
+    {
+    public:
+        DirectoryScanner(ManifestIndexParameters const& params, std::string const& manifestExtension,
+            DirectoryIndex const& cachedIndex, ManifestIndexMaterialCallback const& onMaterial,
+            ManifestIndexErrorCallback const& onError)
+            : m_params(params)
+            , m_manifestExtension(manifestExtension)
+            , m_cachedIndex(cachedIndex)
+            , m_onMaterial(onMaterial)
+            , m_onError(onError)
+        { }
+
+        void Run(std::string const& rootPath, int threadCount)
+        {
+            Push(rootPath);
+
+            std::vector<std::thread> threads;
+            for (int i = 1; i < threadCount; ++i)
+                threads.emplace_back(&DirectoryScanner::Worker, this);
+            Worker();
+
+            for (std::thread& thread : threads)
+                thread.join();
+        }
+
+        DirectoryIndex& GetIndex() { return m_index; }
+
+        void GetStats(ManifestIndexStats& outStats) const
+        {
+            outStats.directories = m_directories;
+            outStats.cachedDirectories = m_cachedDirectories;
+            outStats.materials = m_materials;
+            outStats.errors = m_errors;
+        }
+
+    private:
+        ManifestIndexParameters const& m_params;
+        std::string const& m_manifestExtension;
+        DirectoryIndex const& m_cachedIndex;
+        ManifestIndexMaterialCallback const& m_onMaterial;
+        ManifestIndexErrorCallback const& m_onError;
+
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::deque<std::string> m_pending;
+        size_t m_unfinished = 0; // Directories that are queued or being processed
+        DirectoryIndex m_index;
+
+        std::atomic<size_t> m_directories = 0;
+        std::atomic<size_t> m_cachedDirectories = 0;
+        std::atomic<size_t> m_materials = 0;
+        std::atomic<size_t> m_errors = 0;
+
+        void Push(std::string&& path)
+        {
+            std::lock_guard lockGuard(m_mutex);
+            m_pending.push_back(std::move(path));
+            ++m_unfinished;
+            m_condition.notify_one();
+        }
+
+        void Push(std::string const& path)
+        {
+            Push(std::string(path));
+        }
+
+        void Worker()
+        {
+            while (true)
+            {
+                std::string path;
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_condition.wait(lock, [this]() { return !m_pending.empty() || m_unfinished == 0; });
+                    if (m_pending.empty())
+                        return;
+
+                    path = std::move(m_pending.front());
+                    m_pending.pop_front();
+                }
+
+                ProcessDirectory(path);
+
+                std::lock_guard lockGuard(m_mutex);
+                --m_unfinished;
+                if (m_unfinished == 0)
+                    m_condition.notify_all();
+            }
+        }
+
+        void ReportError(std::string const& path, std::string const& error)
+        {
+            ++m_errors;
+            if (m_onError)
+                m_onError(path, error);
+        }
+
+        void ReportMaterial(ManifestIndexMaterial&& material)
+        {
+            ++m_materials;
+            m_onMaterial(std::move(material));
+        }
+
+        bool ListDirectory(std::string const& path, DirectoryListing& outListing)
+        {
+            std::error_code ec;
+            for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec))
+            {
+                fs::path const& entryPath = it->path();
+
+                // Links to directories are not followed, they can form cycles that the scan would never leave.
+                // The link itself must be a directory, which also excludes NTFS junctions.
+                std::error_code statError;
+                if (it->is_directory(statError))
+                {
+                    if (it->symlink_status(statError).type() != fs::file_type::directory)
+                        continue;
+
+                    outListing.subdirectories.push_back(entryPath.filename().generic_string());
+                    continue;
+                }
+
+                // Get a lowercase file extension for case-insensitive comparison
+                std::string extension = entryPath.extension().generic_string();
+                LowercaseString(extension);
+
+                if (extension == m_manifestExtension)
+                    outListing.manifests.push_back(entryPath.filename().generic_string());
+                else if (IsSupportedImageFileExtension(extension) ||
+                    (m_params.includeTextureContainers && IsTextureContainerFileExtension(extension)))
+                    outListing.hasImages = true;
+            }
+
+            if (ec)
+            {
+                ReportError(path, "Cannot read directory: " + ec.message());
+                return false;
+            }
+
+            // Keep the materials in a predictable order within each directory
+            std::sort(outListing.manifests.begin(), outListing.manifests.end());
+            return true;
+        }
+
+        void ProcessDirectory(std::string const& path)
+        {
+            std::error_code ec;
+            fs::file_time_type const modificationTime = fs::last_write_time(path, ec);
+            if (ec)
+            {
+                ReportError(path, "Cannot read directory: " + ec.message());
+                return;
+            }
+
+            DirectoryListing listing;
+            auto cached = m_cachedIndex.find(path);
+            if (cached != m_cachedIndex.end() &&
+                cached->second.modificationTime == int64_t(modificationTime.time_since_epoch().count()))
+            {
+                listing = cached->second;
+                ++m_cachedDirectories;
+            }
+            else if (!ListDirectory(path, listing))
+                return;
+
+            listing.modificationTime = int64_t(modificationTime.time_since_epoch().count());
+            ++m_directories;
+
+            // Queue the subdirectories first so that other threads can start working on them
+            for (std::string const& subdirectory : listing.subdirectories)
+            {
+                if (listing.hasImages && subdirectory == "mips")
+                    continue;
+
+                Push((fs::path(path) / subdirectory).generic_string());
+            }
+
+            for (std::string const& manifestName : listing.manifests)
+            {
+                ManifestIndexMaterial material;
+                material.path = (fs::path(path) / manifestName).generic_string();
+
+                std::string error;
+                if (ReadManifestFromFile(material.path.c_str(), material.manifest, error))
+                    ReportMaterial(std::move(material));
+                else
+                    ReportError(material.path, error);
+            }
+
+            if (listing.manifests.empty() && listing.hasImages)
+            {
+                ManifestIndexMaterial material;
+                material.path = path;
+                material.isDirectory = true;
+
+                try
+                {
+                    GenerateManifestFromDirectory(path.c_str(), m_params.loadMips, material.manifest,
+                        m_params.includeTextureContainers);
+                    ReportMaterial(std::move(material));
+                }
+                catch (fs::filesystem_error const& e)
+                {
+                    ReportError(path, e.what());
+                }
+            }
+
+            std::lock_guard lockGuard(m_mutex);
+            m_index.insert_or_assign(path, std::move(listing));
+        }
+    };
+}
+
+bool ScanManifestIndex(ManifestIndexParameters const& params, ManifestIndexMaterialCallback const& onMaterial,
+    ManifestIndexErrorCallback const& onError, ManifestIndexStats* outStats, std::string& outError)
+{
+    std::error_code ec;
+    if (!params.rootPath || !fs::is_directory(params.rootPath, ec))
+    {
+        outError = std::string("'") + (params.rootPath ? params.rootPath : "") + "' is not a directory.";
+        return false;
+    }
+
+    std::string manifestExtension = params.manifestExtension ? params.manifestExtension : "";
+    LowercaseString(manifestExtension);
+    uint32_t const flags = GetIndexFlags(params);
+
+    DirectoryIndex cachedIndex;
+    if (params.cacheFileName)
+        ReadDirectoryIndex(params.cacheFileName, flags, manifestExtension, cachedIndex);
+
+    int threadCount = params.threadCount;
+    if (threadCount <= 0)
+        threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+
+    DirectoryScanner scanner(params, manifestExtension, cachedIndex, onMaterial, onError);
+    scanner.Run(fs::path(params.rootPath).generic_string(), threadCount);
+
+    if (outStats)
+        scanner.GetStats(*outStats);
+
+    if (params.cacheFileName)
+    {
+        std::string cacheError;
+        if (!WriteDirectoryIndex(params.cacheFileName, flags, manifestExtension, scanner.GetIndex(), cacheError))
+        {
+            if (outStats)
+                ++outStats->errors;
+            if (onError)
+                onError(params.cacheFileName, cacheError);
+        }
+    }
+
+    return true;
+}
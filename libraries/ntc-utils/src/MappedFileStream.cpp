@@ -0,0 +1,202 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/MappedFileStream.h>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<MappedFileStream> MappedFileStream::Open(char const* fileName, std::string* outErrorMessage)
+{
+    std::unique_ptr<MappedFileStream> stream(new MappedFileStream());
+
+    // Takes the GetLastError or errno value, which must be read before any other system call
+    auto fail = [outErrorMessage](int error)
+    {
+        if (outErrorMessage)
+            *outErrorMessage = std::system_category().message(error);
+        return std::unique_ptr<MappedFileStream>();
+    };
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return fail(int(GetLastError()));
+    stream->m_fileHandle = fileHandle;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize))
+        return fail(int(GetLastError()));
+    stream->m_size = uint64_t(fileSize.QuadPart);
+
+    // Empty files cannot be mapped, but they are valid streams
+    if (stream->m_size == 0)
+        return stream;
+
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle)
+        return fail(int(GetLastError()));
+    stream->m_mappingHandle = mappingHandle;
+
+    stream->m_data = static_cast<uint8_t const*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!stream->m_data)
+        return fail(int(GetLastError()));
+#else
+    int const fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+        return fail(errno);
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0)
+    {
+        int const error = errno;
+        close(fd);
+        return fail(error);
+    }
+    stream->m_size = uint64_t(fileStat.st_size);
+
+    int mapError = 0;
+    if (stream->m_size != 0)
+    {
+        void* data = mmap(nullptr, stream->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+            stream->m_data = static_cast<uint8_t const*>(data);
+        else
+            mapError = errno;
+    }
+
+    // The mapping stays valid after the file is closed
+    close(fd);
+
+    if (stream->m_size != 0 && !stream->m_data)
+        return fail(mapError);
+#endif
+
+    return stream;
+}
+
+std::unique_ptr<MappedFileStream> MappedFileStream::CreateView(uint64_t offset, uint64_t size) const
+{
+    if (offset > m_size || size > m_size - offset)
+        return nullptr;
+
+    std::unique_ptr<MappedFileStream> view(new MappedFileStream());
+    view->m_data = size != 0 ? m_data + offset : nullptr;
+    view->m_size = size;
+    view->m_isView = true;
+    return view;
+}
+
+MappedFileStream::~MappedFileStream()
+{
+    if (m_isView)
+        return;
+
+#ifdef _WIN32
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mappingHandle)
+        CloseHandle(m_mappingHandle);
+    if (m_fileHandle)
+        CloseHandle(m_fileHandle);
+#else
+    if (m_data)
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+}
+
+bool MappedFileStream::Read(void* dataPtr, size_t size)
+{
+    if (size == 0)
+        return true;
+
+    void const* src = GetData(m_position, size);
+    if (!src)
+        return false;
+
+    memcpy(dataPtr, src, size);
+    m_position += size;
+    return true;
+}
+
+bool MappedFileStream::Write(void const* /* dataPtr */, size_t /* size */)
+{
+    return false;
+}
+
+bool MappedFileStream::Seek(uint64_t offset)
+{
+    if (offset > m_size)
+        return false;
+
+    m_position = offset;
+    return true;
+}
+
+uint64_t MappedFileStream::Tell()
+{
+    return m_position;
+}
+
+uint64_t MappedFileStream::Size()
+{
+    return m_size;
+}
+
+void const* MappedFileStream::GetData(uint64_t offset, uint64_t size) const
+{
+    if (!m_data || offset > m_size || size > m_size - offset)
+        return nullptr;
+
+    return m_data + offset;
+}
+
+void const* MappedFileStream::GetStreamData(ntc::IStream* stream, uint64_t offset, uint64_t size)
+{
+    MappedFileStream const* mappedStream = dynamic_cast<MappedFileStream const*>(stream);
+    if (!mappedStream)
+        return nullptr;
+
+    return mappedStream->GetData(offset, size);
+}
+
+void MappedFileStream::Prefetch(uint64_t offset, uint64_t size) const
+{
+    uint8_t const* data = static_cast<uint8_t const*>(GetData(offset, size));
+    if (!data || size == 0)
+        return;
+
+#ifdef _WIN32
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<uint8_t*>(data);
+    range.NumberOfBytes = size_t(size);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    // madvise needs a page aligned address
+    uintptr_t const pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+    uintptr_t const start = reinterpret_cast<uintptr_t>(data) & ~(pageSize - 1);
+    uintptr_t const end = reinterpret_cast<uintptr_t>(data) + size;
+    madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+#endif
+}
@@ -0,0 +1,283 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/MaterialAtlas.h>
+#include <ntc-utils/MappedFileStream.h>
+#include <json/value.h>
+#include <json/reader.h>
+#include <json/writer.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <numeric>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Largest power of 2 that divides the value, 'value' must be positive
+    int GetPowerOfTwoFactor(int value)
+    {
+        return value & -value;
+    }
+
+    int GetAlignment(MaterialAtlasEntry const& entry)
+    {
+        return std::min(GetPowerOfTwoFactor(entry.width), GetPowerOfTwoFactor(entry.height));
+    }
+
+    int AlignUp(int value, int alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Shelf packing into an atlas of the given width, the entries are visited in 'order'.
+    // Returns the atlas height.
+    int PackShelves(std::vector<MaterialAtlasEntry>& materials, std::vector<size_t> const& order, int atlasWidth)
+    {
+        int x = 0;
+        int shelfTop = 0;
+        int shelfHeight = 0;
+        for (size_t index : order)
+        {
+            MaterialAtlasEntry& entry = materials[index];
+            int const alignment = GetAlignment(entry);
+            int left = AlignUp(x, alignment);
+
+            // Start a new shelf when the rectangle doesn't fit horizontally, or the current shelf
+            // is not aligned well enough for it
+            if (left + entry.width > atlasWidth || shelfTop % alignment != 0)
+            {
+                shelfTop = AlignUp(shelfTop + shelfHeight, alignment);
+                shelfHeight = 0;
+                left = 0;
+            }
+
+            entry.left = left;
+            entry.top = shelfTop;
+            x = left + entry.width;
+            shelfHeight = std::max(shelfHeight, entry.height);
+        }
+        return shelfTop + shelfHeight;
+    }
+}
+
+MaterialAtlasEntry const* MaterialAtlasLayout::FindMaterial(std::string const& name) const
+{
+    for (MaterialAtlasEntry const& entry : materials)
+    {
+        if (entry.name == name)
+            return &entry;
+    }
+    return nullptr;
+}
+
+bool PackMaterialAtlas(MaterialAtlasLayout& layout, int maxSize)
+{
+    if (layout.materials.empty())
+        return false;
+
+    int maxWidth = 0;
+    int maxAlignment = 1;
+    for (MaterialAtlasEntry const& entry : layout.materials)
+    {
+        if (entry.width <= 0 || entry.height <= 0)
+            return false;
+        maxWidth = std::max(maxWidth, entry.width);
+        maxAlignment = std::max(maxAlignment, GetAlignment(entry));
+    }
+
+    // Tallest materials first, they start the shelves
+    std::vector<size_t> order(layout.materials.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&layout](size_t a, size_t b)
+    {
+        MaterialAtlasEntry const& entryA = layout.materials[a];
+        MaterialAtlasEntry const& entryB = layout.materials[b];
+        if (entryA.height != entryB.height)
+            return entryA.height > entryB.height;
+        return entryA.width > entryB.width;
+    });
+
+    // Try the power-of-2 atlas widths and keep the smallest area, preferring square atlases on ties
+    std::vector<MaterialAtlasEntry> bestPlacement;
+    int64_t bestArea = INT64_MAX;
+    int bestSide = INT_MAX;
+    int atlasWidth = 1;
+    while (atlasWidth < maxWidth)
+        atlasWidth <<= 1;
+
+    for (; atlasWidth <= maxSize; atlasWidth <<= 1)
+    {
+        std::vector<MaterialAtlasEntry> placement = layout.materials;
+        int const atlasHeight = AlignUp(PackShelves(placement, order, atlasWidth), maxAlignment);
+        if (atlasHeight > maxSize)
+            continue;
+
+        // Trim the unused columns, keeping the alignment
+        int usedWidth = 0;
+        for (MaterialAtlasEntry const& entry : placement)
+            usedWidth = std::max(usedWidth, entry.left + entry.width);
+        usedWidth = AlignUp(usedWidth, maxAlignment);
+
+        int64_t const area = int64_t(usedWidth) * int64_t(atlasHeight);
+        int const side = std::max(usedWidth, atlasHeight);
+        if (area < bestArea || (area == bestArea && side < bestSide))
+        {
+            bestPlacement = std::move(placement);
+            bestArea = area;
+            bestSide = side;
+            layout.width = usedWidth;
+            layout.height = atlasHeight;
+        }
+    }
+
+    if (bestPlacement.empty())
+        return false;
+
+    layout.materials = std::move(bestPlacement);
+    return true;
+}
+
+void UpdateMaterialAtlasMips(MaterialAtlasLayout& layout, int mips)
+{
+    layout.mips = mips;
+    for (MaterialAtlasEntry& entry : layout.materials)
+    {
+        // MIP level N maps the rectangle to whole texels when all its edges are divisible by 2^N
+        int const edges = entry.left | entry.top | entry.width | entry.height;
+        entry.mips = 1;
+        while (entry.mips < mips && (edges & ((1 << entry.mips) - 1)) == 0)
+            ++entry.mips;
+    }
+}
+
+std::string GetMaterialAtlasLayoutFileName(std::string const& textureSetFileName)
+{
+    return fs::path(textureSetFileName).replace_extension(".atlas.json").generic_string();
+}
+
+bool ReadMaterialAtlasLayout(char const* fileName, MaterialAtlasLayout& outLayout, std::string& outError)
+{
+    std::string openError;
+    std::unique_ptr<MappedFileStream> inputFile = MappedFileStream::Open(fileName, &openError);
+    if (!inputFile)
+    {
+        outError = std::string("Cannot open atlas layout file '") + fileName + "': " + openError;
+        return false;
+    }
+
+    uint64_t const fileSize = inputFile->Size();
+    char const* fileContents = fileSize != 0
+        ? static_cast<char const*>(inputFile->GetData(0, fileSize))
+        : "";
+
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+    Json::Value root;
+    Json::String errorMessages;
+    if (!reader->parse(fileContents, fileContents + fileSize, &root, &errorMessages))
+    {
+        outError = std::string("Cannot parse atlas layout file '") + fileName + "': " + errorMessages;
+        return false;
+    }
+
+    if (!root.isObject() || !root["materials"].isArray() || !root["width"].isNumeric() ||
+        !root["height"].isNumeric())
+    {
+        outError = std::string("Malformed atlas layout file '") + fileName + "'.";
+        return false;
+    }
+
+    if (root.get("version", 0).asInt() > c_MaterialAtlasLayoutVersion)
+    {
+        outError = std::string("Atlas layout file '") + fileName + "' has unsupported version "
+            + std::to_string(root["version"].asInt()) + ".";
+        return false;
+    }
+
+    MaterialAtlasLayout& layout = outLayout;
+    layout.textureSetFileName = root["textureSet"].asString();
+    layout.width = root["width"].asInt();
+    layout.height = root["height"].asInt();
+    layout.mips = root.get("mips", 1).asInt();
+    layout.materials.clear();
+
+    for (Json::Value const& node : root["materials"])
+    {
+        MaterialAtlasEntry entry;
+        entry.name = node["name"].asString();
+        entry.left = node["left"].asInt();
+        entry.top = node["top"].asInt();
+        entry.width = node["width"].asInt();
+        entry.height = node["height"].asInt();
+        entry.mips = node.get("mips", 1).asInt();
+
+        if (entry.name.empty() || entry.left < 0 || entry.top < 0 || entry.width <= 0 || entry.height <= 0 ||
+            entry.left + entry.width > layout.width || entry.top + entry.height > layout.height ||
+            entry.mips < 1 || entry.mips > layout.mips)
+        {
+            outError = std::string("Atlas layout file '") + fileName + "' has an invalid entry for material '"
+                + entry.name + "'.";
+            return false;
+        }
+
+        layout.materials.push_back(std::move(entry));
+    }
+
+    return true;
+}
+
+bool WriteMaterialAtlasLayout(char const* fileName, MaterialAtlasLayout const& layout, std::string& outError)
+{
+    Json::Value root(Json::objectValue);
+    root["version"] = c_MaterialAtlasLayoutVersion;
+    root["textureSet"] = layout.textureSetFileName;
+    root["width"] = layout.width;
+    root["height"] = layout.height;
+    root["mips"] = layout.mips;
+
+    Json::Value& materials = root["materials"] = Json::Value(Json::arrayValue);
+    for (MaterialAtlasEntry const& entry : layout.materials)
+    {
+        Json::Value& node = materials.append(Json::Value(Json::objectValue));
+        node["name"] = entry.name;
+        node["left"] = entry.left;
+        node["top"] = entry.top;
+        node["width"] = entry.width;
+        node["height"] = entry.height;
+        node["mips"] = entry.mips;
+    }
+
+    std::ofstream file(fileName);
+    if (!file.is_open())
+    {
+        outError = std::string("Cannot open atlas layout file '") + fileName + "' for writing.";
+        return false;
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    file << Json::writeString(builder, root) << std::endl;
+
+    if (!file.good())
+    {
+        outError = std::string("Failed to write atlas layout file '") + fileName + "'.";
+        return false;
+    }
+    return true;
+}
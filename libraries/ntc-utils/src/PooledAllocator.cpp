@@ -0,0 +1,190 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/PooledAllocator.h>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    constexpr int c_MinSizeClassLog2 = 6; // 64 bytes
+
+    // Returns the size class for the allocation size, or c_PooledAllocatorSizeClasses if it's too large.
+    int GetSizeClass(size_t size)
+    {
+        int sizeClass = 0;
+        while (sizeClass < c_PooledAllocatorSizeClasses && (size_t(1) << (sizeClass + c_MinSizeClassLog2)) < size)
+            ++sizeClass;
+        return sizeClass;
+    }
+
+    size_t GetSizeClassBytes(int sizeClass)
+    {
+        return size_t(1) << (sizeClass + c_MinSizeClassLog2);
+    }
+}
+
+PooledAllocator::~PooledAllocator()
+{
+    Trim();
+}
+
+void* PooledAllocator::Allocate(size_t size)
+{
+    int const sizeClass = GetSizeClass(size);
+    void* ptr = nullptr;
+
+    if (sizeClass < c_PooledAllocatorSizeClasses)
+    {
+        Pool& pool = m_pools[sizeClass];
+        {
+            std::lock_guard lockGuard(pool.mutex);
+            if (!pool.freeBlocks.empty())
+            {
+                ptr = pool.freeBlocks.back();
+                pool.freeBlocks.pop_back();
+            }
+        }
+
+        if (ptr)
+        {
+            m_bytesPooled -= int64_t(GetSizeClassBytes(sizeClass));
+            ++m_pooledAllocations;
+        }
+        else
+            ptr = malloc(GetSizeClassBytes(sizeClass));
+    }
+    else
+        ptr = malloc(size);
+
+    if (!ptr)
+        return nullptr;
+
+    int64_t const bytesAllocated = m_bytesAllocated += int64_t(size);
+    int64_t peak = m_peakBytesAllocated;
+    while (bytesAllocated > peak && !m_peakBytesAllocated.compare_exchange_weak(peak, bytesAllocated))
+        ;
+
+    ++m_liveAllocations;
+    ++m_totalAllocations;
+    ++m_allocationsPerCategory[sizeClass];
+    return ptr;
+}
+
+void PooledAllocator::Deallocate(void* ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    m_bytesAllocated -= int64_t(size);
+    --m_liveAllocations;
+
+    // The library passes the same size that it allocated, so the block belongs to the same class
+    int const sizeClass = GetSizeClass(size);
+    if (sizeClass < c_PooledAllocatorSizeClasses)
+    {
+        // Reserve the pool space with one atomic update, so that concurrent frees can't exceed the limit together
+        int64_t const blockSize = int64_t(GetSizeClassBytes(sizeClass));
+        int64_t pooled = m_bytesPooled;
+        while (pooled + blockSize <= m_maxPooledBytes &&
+            !m_bytesPooled.compare_exchange_weak(pooled, pooled + blockSize))
+            ;
+
+        if (pooled + blockSize <= m_maxPooledBytes)
+        {
+            Pool& pool = m_pools[sizeClass];
+            std::lock_guard lockGuard(pool.mutex);
+            pool.freeBlocks.push_back(ptr);
+            return;
+        }
+    }
+
+    free(ptr);
+}
+
+void PooledAllocator::Trim()
+{
+    for (int sizeClass = 0; sizeClass < c_PooledAllocatorSizeClasses; ++sizeClass)
+    {
+        Pool& pool = m_pools[sizeClass];
+        std::vector<void*> freeBlocks;
+        {
+            std::lock_guard lockGuard(pool.mutex);
+            freeBlocks.swap(pool.freeBlocks);
+        }
+
+        for (void* ptr : freeBlocks)
+            free(ptr);
+        m_bytesPooled -= int64_t(freeBlocks.size() * GetSizeClassBytes(sizeClass));
+    }
+}
+
+void PooledAllocator::ResetPeak()
+{
+    m_peakBytesAllocated = m_bytesAllocated.load();
+}
+
+PooledAllocatorStats PooledAllocator::GetStats() const
+{
+    PooledAllocatorStats stats;
+    stats.bytesAllocated = m_bytesAllocated;
+    stats.peakBytesAllocated = m_peakBytesAllocated;
+    stats.liveAllocations = m_liveAllocations;
+    stats.bytesPooled = m_bytesPooled;
+    stats.totalAllocations = m_totalAllocations;
+    stats.pooledAllocations = m_pooledAllocations;
+    for (int category = 0; category < c_PooledAllocatorCategories; ++category)
+        stats.allocationsPerCategory[category] = m_allocationsPerCategory[category];
+    return stats;
+}
+
+std::string PooledAllocator::GetCategoryName(int category)
+{
+    char const* prefix = "<=";
+    if (category >= c_PooledAllocatorSizeClasses)
+    {
+        prefix = ">";
+        category = c_PooledAllocatorSizeClasses - 1;
+    }
+
+    size_t const bytes = GetSizeClassBytes(category);
+    char name[16];
+    if (bytes >= (size_t(1) << 20))
+        snprintf(name, sizeof(name), "%s%zuMB", prefix, bytes >> 20);
+    else if (bytes >= 1024)
+        snprintf(name, sizeof(name), "%s%zuKB", prefix, bytes >> 10);
+    else
+        snprintf(name, sizeof(name), "%s%zuB", prefix, bytes);
+    return name;
+}
+
+std::string PooledAllocator::FormatStats(PooledAllocatorStats const& stats)
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "peak %.2f MB, %lld live allocation(s) with %.2f MB, %.2f MB pooled, "
+        "%llu allocation(s) of which %.1f%% pooled", double(stats.peakBytesAllocated) * 0x1p-20,
+        (long long)stats.liveAllocations, double(stats.bytesAllocated) * 0x1p-20, double(stats.bytesPooled) * 0x1p-20,
+        (unsigned long long)stats.totalAllocations,
+        stats.totalAllocations > 0 ? 100.0 * double(stats.pooledAllocations) / double(stats.totalAllocations) : 0.0);
+
+    std::string result = buffer;
+    result += "; by size:";
+    for (int category = 0; category < c_PooledAllocatorCategories; ++category)
+    {
+        if (stats.allocationsPerCategory[category] == 0)
+            continue;
+        snprintf(buffer, sizeof(buffer), " %s %llu", GetCategoryName(category).c_str(),
+            (unsigned long long)stats.allocationsPerCategory[category]);
+        result += buffer;
+    }
+    return result;
+}
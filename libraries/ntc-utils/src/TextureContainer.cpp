@@ -0,0 +1,1010 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/TextureContainer.h>
+#include <ntc-utils/DDSHeader.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+using namespace donut::engine::dds;
+
+namespace
+{
+    struct ContainerPixelFormat
+    {
+        DXGI_FORMAT dxgiFormat;
+        uint32_t vkFormat;
+        int channels;
+        ntc::ChannelFormat channelFormat;
+        ntc::BlockCompressedFormat blockFormat;
+        bool isSRGB;
+        bool isBGR;
+        bool isSigned;
+    };
+
+    using BCF = ntc::BlockCompressedFormat;
+    using CF = ntc::ChannelFormat;
+
+    // Formats that can be loaded from DDS and KTX2 files, with their DXGI_FORMAT and VkFormat values.
+    // Zero means that the format has no equivalent in that container.
+    const ContainerPixelFormat c_ContainerPixelFormats[] = {
+        { DXGI_FORMAT_R8_UNORM,                9,   1, CF::UNORM8,  BCF::None, false, false, false },
+        { DXGI_FORMAT_UNKNOWN,                 15,  1, CF::UNORM8,  BCF::None, true,  false, false },
+        { DXGI_FORMAT_R8G8_UNORM,              16,  2, CF::UNORM8,  BCF::None, false, false, false },
+        { DXGI_FORMAT_UNKNOWN,                 22,  2, CF::UNORM8,  BCF::None, true,  false, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM,          37,  4, CF::UNORM8,  BCF::None, false, false, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,     43,  4, CF::UNORM8,  BCF::None, true,  false, false },
+        { DXGI_FORMAT_B8G8R8A8_UNORM,          44,  4, CF::UNORM8,  BCF::None, false, true,  false },
+        { DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,     50,  4, CF::UNORM8,  BCF::None, true,  true,  false },
+        { DXGI_FORMAT_R16_UNORM,               70,  1, CF::UNORM16, BCF::None, false, false, false },
+        { DXGI_FORMAT_R16G16_UNORM,            77,  2, CF::UNORM16, BCF::None, false, false, false },
+        { DXGI_FORMAT_R16G16B16A16_UNORM,      91,  4, CF::UNORM16, BCF::None, false, false, false },
+        { DXGI_FORMAT_R16_FLOAT,               76,  1, CF::FLOAT16, BCF::None, false, false, false },
+        { DXGI_FORMAT_R16G16_FLOAT,            83,  2, CF::FLOAT16, BCF::None, false, false, false },
+        { DXGI_FORMAT_R16G16B16A16_FLOAT,      97,  4, CF::FLOAT16, BCF::None, false, false, false },
+        { DXGI_FORMAT_R32_FLOAT,               100, 1, CF::FLOAT32, BCF::None, false, false, false },
+        { DXGI_FORMAT_R32G32_FLOAT,            103, 2, CF::FLOAT32, BCF::None, false, false, false },
+        { DXGI_FORMAT_R32G32B32A32_FLOAT,      109, 4, CF::FLOAT32, BCF::None, false, false, false },
+        { DXGI_FORMAT_BC1_UNORM,               131, 4, CF::UNORM8,  BCF::BC1,  false, false, false },
+        { DXGI_FORMAT_BC1_UNORM,               133, 4, CF::UNORM8,  BCF::BC1,  false, false, false },
+        { DXGI_FORMAT_BC1_UNORM_SRGB,          132, 4, CF::UNORM8,  BCF::BC1,  true,  false, false },
+        { DXGI_FORMAT_BC1_UNORM_SRGB,          134, 4, CF::UNORM8,  BCF::BC1,  true,  false, false },
+        { DXGI_FORMAT_BC2_UNORM,               135, 4, CF::UNORM8,  BCF::BC2,  false, false, false },
+        { DXGI_FORMAT_BC2_UNORM_SRGB,          136, 4, CF::UNORM8,  BCF::BC2,  true,  false, false },
+        { DXGI_FORMAT_BC3_UNORM,               137, 4, CF::UNORM8,  BCF::BC3,  false, false, false },
+        { DXGI_FORMAT_BC3_UNORM_SRGB,          138, 4, CF::UNORM8,  BCF::BC3,  true,  false, false },
+        { DXGI_FORMAT_BC4_UNORM,               139, 1, CF::UNORM8,  BCF::BC4,  false, false, false },
+        { DXGI_FORMAT_BC5_UNORM,               141, 2, CF::UNORM8,  BCF::BC5,  false, false, false },
+        { DXGI_FORMAT_BC6H_UF16,               143, 3, CF::FLOAT16, BCF::BC6,  false, false, false },
+        { DXGI_FORMAT_BC6H_SF16,               144, 3, CF::FLOAT16, BCF::BC6,  false, false, true  },
+        { DXGI_FORMAT_BC7_UNORM,               145, 4, CF::UNORM8,  BCF::BC7,  false, false, false },
+        { DXGI_FORMAT_BC7_UNORM_SRGB,          146, 4, CF::UNORM8,  BCF::BC7,  true,  false, false },
+    };
+
+    ContainerPixelFormat const* FindFormatByDxgi(DXGI_FORMAT format)
+    {
+        for (ContainerPixelFormat const& candidate : c_ContainerPixelFormats)
+        {
+            if (candidate.dxgiFormat == format && format != DXGI_FORMAT_UNKNOWN)
+                return &candidate;
+        }
+        return nullptr;
+    }
+
+    ContainerPixelFormat const* FindFormatByVk(uint32_t format)
+    {
+        for (ContainerPixelFormat const& candidate : c_ContainerPixelFormats)
+        {
+            if (candidate.vkFormat == format && format != 0)
+                return &candidate;
+        }
+        return nullptr;
+    }
+
+    // Translates the pixel formats of DDS files without the DX10 header, only the commonly used ones.
+    DXGI_FORMAT GetLegacyDdsFormat(DDS_PIXELFORMAT const& pf)
+    {
+        if (pf.flags & DDS_FOURCC)
+        {
+            switch (pf.fourCC)
+            {
+            case MAKEFOURCC('D', 'X', 'T', '1'): return DXGI_FORMAT_BC1_UNORM;
+            case MAKEFOURCC('D', 'X', 'T', '2'):
+            case MAKEFOURCC('D', 'X', 'T', '3'): return DXGI_FORMAT_BC2_UNORM;
+            case MAKEFOURCC('D', 'X', 'T', '4'):
+            case MAKEFOURCC('D', 'X', 'T', '5'): return DXGI_FORMAT_BC3_UNORM;
+            case MAKEFOURCC('A', 'T', 'I', '1'):
+            case MAKEFOURCC('B', 'C', '4', 'U'): return DXGI_FORMAT_BC4_UNORM;
+            case MAKEFOURCC('A', 'T', 'I', '2'):
+            case MAKEFOURCC('B', 'C', '5', 'U'): return DXGI_FORMAT_BC5_UNORM;
+            // D3DFORMAT values stored in the FourCC field
+            case 36:  return DXGI_FORMAT_R16G16B16A16_UNORM;
+            case 111: return DXGI_FORMAT_R16_FLOAT;
+            case 112: return DXGI_FORMAT_R16G16_FLOAT;
+            case 113: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+            case 114: return DXGI_FORMAT_R32_FLOAT;
+            case 115: return DXGI_FORMAT_R32G32_FLOAT;
+            case 116: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+            default:  return DXGI_FORMAT_UNKNOWN;
+            }
+        }
+
+        if ((pf.flags & DDS_RGB) && pf.RGBBitCount == 32)
+        {
+            if (pf.RBitMask == 0x000000ff && pf.GBitMask == 0x0000ff00 && pf.BBitMask == 0x00ff0000 &&
+                pf.ABitMask == 0xff000000)
+                return DXGI_FORMAT_R8G8B8A8_UNORM;
+            if (pf.RBitMask == 0x00ff0000 && pf.GBitMask == 0x0000ff00 && pf.BBitMask == 0x000000ff &&
+                pf.ABitMask == 0xff000000)
+                return DXGI_FORMAT_B8G8R8A8_UNORM;
+            if (pf.RBitMask == 0x0000ffff && pf.GBitMask == 0xffff0000 && pf.BBitMask == 0 && pf.ABitMask == 0)
+                return DXGI_FORMAT_R16G16_UNORM;
+        }
+
+        if ((pf.flags & DDS_LUMINANCE) && !(pf.flags & DDS_ALPHAPIXELS))
+        {
+            if (pf.RGBBitCount == 8 && pf.RBitMask == 0xff)
+                return DXGI_FORMAT_R8_UNORM;
+            if (pf.RGBBitCount == 16 && pf.RBitMask == 0xffff)
+                return DXGI_FORMAT_R16_UNORM;
+        }
+
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    uint64_t GetMipDataSize(ContainerPixelFormat const& format, int width, int height)
+    {
+        if (format.blockFormat != BCF::None)
+        {
+            bool const smallBlocks = format.blockFormat == BCF::BC1 || format.blockFormat == BCF::BC4;
+            return uint64_t((width + 3) / 4) * uint64_t((height + 3) / 4) * (smallBlocks ? 8 : 16);
+        }
+
+        return uint64_t(width) * uint64_t(height) * uint64_t(format.channels) *
+            ntc::GetBytesPerPixelComponent(format.channelFormat);
+    }
+
+    bool FillContainerInfo(ContainerPixelFormat const& format, int width, int height, int mips,
+        TextureContainerInfo& outInfo, std::string& outError)
+    {
+        if (width <= 0 || height <= 0)
+        {
+            outError = "Invalid texture dimensions.";
+            return false;
+        }
+
+        outInfo.width = width;
+        outInfo.height = height;
+        outInfo.mips = std::min(std::max(mips, 1), NTC_MAX_MIPS);
+        outInfo.channels = format.channels;
+        outInfo.channelFormat = format.channelFormat;
+        outInfo.blockFormat = format.blockFormat;
+        outInfo.isSRGB = format.isSRGB;
+        outInfo.isBGR = format.isBGR;
+        outInfo.isSigned = format.isSigned;
+        return true;
+    }
+
+    bool ReadDdsInfo(uint8_t const* data, uint64_t size, TextureContainerInfo& outInfo, std::string& outError)
+    {
+        uint64_t offset = sizeof(uint32_t);
+        DDS_HEADER header;
+        if (size < offset + sizeof(header))
+        {
+            outError = "File is too small for a DDS header.";
+            return false;
+        }
+        memcpy(&header, data + offset, sizeof(header));
+        offset += sizeof(header);
+
+        if (header.size != sizeof(DDS_HEADER) || header.ddspf.size != sizeof(DDS_PIXELFORMAT))
+        {
+            outError = "Malformed DDS header.";
+            return false;
+        }
+
+        if ((header.flags & DDS_HEADER_FLAGS_VOLUME) || (header.caps2 & (DDS_CUBEMAP | DDS_FLAGS_VOLUME)))
+        {
+            outError = "Volume and cube map DDS textures are not supported.";
+            return false;
+        }
+
+        DXGI_FORMAT dxgiFormat;
+        if ((header.ddspf.flags & DDS_FOURCC) && header.ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0'))
+        {
+            DDS_HEADER_DXT10 dx10header;
+            if (size < offset + sizeof(dx10header))
+            {
+                outError = "File is too small for a DDS DX10 header.";
+                return false;
+            }
+            memcpy(&dx10header, data + offset, sizeof(dx10header));
+            offset += sizeof(dx10header);
+
+            if (dx10header.resourceDimension != DDS_DIMENSION_TEXTURE2D || dx10header.arraySize > 1 ||
+                (dx10header.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE))
+            {
+                outError = "Only 2D DDS textures without array layers are supported.";
+                return false;
+            }
+            dxgiFormat = dx10header.dxgiFormat;
+        }
+        else
+        {
+            dxgiFormat = GetLegacyDdsFormat(header.ddspf);
+        }
+
+        ContainerPixelFormat const* format = FindFormatByDxgi(dxgiFormat);
+        if (!format)
+        {
+            std::ostringstream oss;
+            oss << "Unsupported DDS pixel format (DXGI_FORMAT " << int(dxgiFormat) << ").";
+            outError = oss.str();
+            return false;
+        }
+
+        int const mips = (header.flags & DDS_HEADER_FLAGS_MIPMAP) ? int(header.mipMapCount) : 1;
+        if (!FillContainerInfo(*format, int(header.width), int(header.height), mips, outInfo, outError))
+            return false;
+
+        // DDS files store the mips one after another, starting with mip 0
+        for (int mip = 0; mip < outInfo.mips; ++mip)
+        {
+            TextureContainerMip& mipData = outInfo.mipData[mip];
+            mipData.offset = offset;
+            mipData.size = GetMipDataSize(*format, std::max(1, outInfo.width >> mip), std::max(1, outInfo.height >> mip));
+            offset += mipData.size;
+        }
+
+        if (offset > size)
+        {
+            outError = "DDS file is truncated.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const uint8_t c_Ktx2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    struct Ktx2Header
+    {
+        uint8_t identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+
+    struct Ktx2Level
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    static_assert(sizeof(Ktx2Header) == 80, "KTX2 header size mismatch");
+    static_assert(sizeof(Ktx2Level) == 24, "KTX2 level index size mismatch");
+
+    bool ReadKtx2Info(uint8_t const* data, uint64_t size, TextureContainerInfo& outInfo, std::string& outError)
+    {
+        Ktx2Header header;
+        if (size < sizeof(header))
+        {
+            outError = "File is too small for a KTX2 header.";
+            return false;
+        }
+        memcpy(&header, data, sizeof(header));
+
+        if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+        {
+            outError = "Only 2D KTX2 textures without array layers or faces are supported.";
+            return false;
+        }
+
+        if (header.supercompressionScheme != 0)
+        {
+            outError = "Supercompressed KTX2 textures are not supported.";
+            return false;
+        }
+
+        ContainerPixelFormat const* format = FindFormatByVk(header.vkFormat);
+        if (!format)
+        {
+            std::ostringstream oss;
+            oss << "Unsupported KTX2 pixel format (VkFormat " << header.vkFormat << ").";
+            outError = oss.str();
+            return false;
+        }
+
+        int const levelCount = std::max(int(header.levelCount), 1);
+        if (size < sizeof(header) + sizeof(Ktx2Level) * uint64_t(levelCount))
+        {
+            outError = "KTX2 file is truncated.";
+            return false;
+        }
+
+        if (!FillContainerInfo(*format, int(header.pixelWidth), int(header.pixelHeight), levelCount, outInfo, outError))
+            return false;
+
+        // The level index starts with mip 0, but the data is usually stored smallest mip first
+        for (int mip = 0; mip < outInfo.mips; ++mip)
+        {
+            Ktx2Level level;
+            memcpy(&level, data + sizeof(header) + sizeof(Ktx2Level) * mip, sizeof(level));
+
+            uint64_t const expectedSize = GetMipDataSize(*format, std::max(1, outInfo.width >> mip),
+                std::max(1, outInfo.height >> mip));
+            if (level.byteLength != expectedSize || level.byteOffset + level.byteLength > size)
+            {
+                std::ostringstream oss;
+                oss << "KTX2 level " << mip << " has invalid size or offset.";
+                outError = oss.str();
+                return false;
+            }
+
+            outInfo.mipData[mip].offset = level.byteOffset;
+            outInfo.mipData[mip].size = level.byteLength;
+        }
+
+        return true;
+    }
+
+    void DecodeColorBlock(uint8_t const* block, bool allowTransparent, uint8_t outColors[16][4])
+    {
+        uint16_t const c0 = uint16_t(block[0] | (block[1] << 8));
+        uint16_t const c1 = uint16_t(block[2] | (block[3] << 8));
+        uint32_t const indices = uint32_t(block[4]) | (uint32_t(block[5]) << 8) | (uint32_t(block[6]) << 16) |
+            (uint32_t(block[7]) << 24);
+
+        int palette[4][4];
+        for (int i = 0; i < 2; ++i)
+        {
+            uint16_t const c = i ? c1 : c0;
+            int const r = (c >> 11) & 31;
+            int const g = (c >> 5) & 63;
+            int const b = c & 31;
+            palette[i][0] = (r << 3) | (r >> 2);
+            palette[i][1] = (g << 2) | (g >> 4);
+            palette[i][2] = (b << 3) | (b >> 2);
+            palette[i][3] = 255;
+        }
+
+        bool const fourColors = c0 > c1 || !allowTransparent;
+        for (int ch = 0; ch < 3; ++ch)
+        {
+            if (fourColors)
+            {
+                palette[2][ch] = (2 * palette[0][ch] + palette[1][ch] + 1) / 3;
+                palette[3][ch] = (palette[0][ch] + 2 * palette[1][ch] + 1) / 3;
+            }
+            else
+            {
+                palette[2][ch] = (palette[0][ch] + palette[1][ch] + 1) / 2;
+                palette[3][ch] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = fourColors ? 255 : 0;
+
+        for (int pixel = 0; pixel < 16; ++pixel)
+        {
+            int const index = (indices >> (pixel * 2)) & 3;
+            for (int ch = 0; ch < 4; ++ch)
+                outColors[pixel][ch] = uint8_t(palette[index][ch]);
+        }
+    }
+
+    // Decodes a BC4 block, which is also used for the alpha channel in BC3 and for both channels in BC5.
+    void DecodeSingleChannelBlock(uint8_t const* block, uint8_t outValues[16])
+    {
+        int const a0 = block[0];
+        int const a1 = block[1];
+
+        int palette[8] = { a0, a1 };
+        if (a0 > a1)
+        {
+            for (int i = 2; i < 8; ++i)
+                palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+        }
+        else
+        {
+            for (int i = 2; i < 6; ++i)
+                palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; ++i)
+            indices |= uint64_t(block[2 + i]) << (i * 8);
+
+        for (int pixel = 0; pixel < 16; ++pixel)
+            outValues[pixel] = uint8_t(palette[(indices >> (pixel * 3)) & 7]);
+    }
+
+    // Reads the bits of a 128-bit BC6H or BC7 block, starting with the least significant bit of the first byte.
+    class BlockBitReader
+    {
+    public:
+        explicit BlockBitReader(uint8_t const* block)
+            : m_block(block)
+        { }
+
+        int Read(int count)
+        {
+            int result = 0;
+            for (int bit = 0; bit < count; ++bit, ++m_position)
+                result |= ((m_block[m_position >> 3] >> (m_position & 7)) & 1) << bit;
+            return result;
+        }
+
+    private:
+        uint8_t const* m_block;
+        int m_position = 0;
+    };
+
+    // Subset masks of the BC6H and BC7 partitions with 2 subsets, bit N is set when pixel N is in subset 1.
+    // The tables are generated from the partition lists in support/tools/gen_bc7_tables.py.
+    const uint16_t c_Partitions2[64] = {
+        0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+        0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+        0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+        0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+        0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+        0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+        0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+        0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+    };
+
+    // Subsets of the BC7 partitions with 3 subsets, 2 bits per pixel starting with pixel 0 in the low bits.
+    const uint32_t c_Partitions3[64] = {
+        0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+        0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+        0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+        0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+        0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+        0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+        0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+        0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254,
+    };
+
+    // Anchor pixels of subset 1 in the 2-subset partitions, and of subsets 1 and 2 in the 3-subset partitions.
+    // The index of an anchor pixel is stored with one bit less, subset 0 always has its anchor at pixel 0.
+    const uint8_t c_Anchors2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+    };
+
+    const uint8_t c_Anchors3[2][64] = {
+        {
+             3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+             3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+             8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+             3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+        },
+        {
+            15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+            15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+            15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+            15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+        }
+    };
+
+    // Interpolation weights for 2, 3 and 4-bit indices, out of 64
+    int GetInterpolationWeight(int index, int indexBits)
+    {
+        static const int c_Weights2[4] = { 0, 21, 43, 64 };
+        static const int c_Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+        static const int c_Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        return indexBits == 2 ? c_Weights2[index] : indexBits == 3 ? c_Weights3[index] : c_Weights4[index];
+    }
+
+    int Interpolate(int a, int b, int index, int indexBits)
+    {
+        int const weight = GetInterpolationWeight(index, indexBits);
+        return ((64 - weight) * a + weight * b + 32) >> 6;
+    }
+
+    int GetSubset(int subsets, int partition, int pixel)
+    {
+        if (subsets == 2)
+            return (c_Partitions2[partition] >> pixel) & 1;
+        if (subsets == 3)
+            return (c_Partitions3[partition] >> (pixel * 2)) & 3;
+        return 0;
+    }
+
+    bool IsAnchorPixel(int subsets, int partition, int pixel)
+    {
+        if (pixel == 0)
+            return true;
+        if (subsets == 2)
+            return pixel == c_Anchors2[partition];
+        if (subsets == 3)
+            return pixel == c_Anchors3[0][partition] || pixel == c_Anchors3[1][partition];
+        return false;
+    }
+
+    struct Bc7ModeInfo
+    {
+        int subsets;
+        int partitionBits;
+        int rotationBits;
+        int indexSelectionBits;
+        int colorBits;
+        int alphaBits;
+        int endpointPBits;  // One P-bit per endpoint
+        int sharedPBits;    // One P-bit per subset
+        int indexBits;
+        int secondaryIndexBits;
+    };
+
+    const Bc7ModeInfo c_Bc7Modes[8] = {
+        { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+        { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+    };
+
+    // Expands an endpoint component to 8 bits by replicating its high bits
+    int ExpandTo8Bits(int value, int bits)
+    {
+        value <<= 8 - bits;
+        return value | (value >> bits);
+    }
+
+    void DecodeBc7Block(uint8_t const* block, uint8_t outColors[16][4])
+    {
+        int mode = 0;
+        while (mode < 8 && !(block[0] & (1 << mode)))
+            ++mode;
+
+        // The reserved mode decodes into transparent black
+        if (mode == 8)
+        {
+            memset(outColors, 0, 16 * 4);
+            return;
+        }
+
+        Bc7ModeInfo const& info = c_Bc7Modes[mode];
+        BlockBitReader bits(block);
+        bits.Read(mode + 1);
+        int const partition = bits.Read(info.partitionBits);
+        int const rotation = bits.Read(info.rotationBits);
+        int const indexSelection = bits.Read(info.indexSelectionBits);
+
+        // Endpoints are stored as all R values, then all G values, and so on
+        int endpoints[3][2][4];
+        for (int ch = 0; ch < 4; ++ch)
+        {
+            for (int subset = 0; subset < info.subsets; ++subset)
+            {
+                for (int endpoint = 0; endpoint < 2; ++endpoint)
+                {
+                    int& value = endpoints[subset][endpoint][ch];
+                    if (ch < 3)
+                        value = bits.Read(info.colorBits);
+                    else
+                        value = info.alphaBits ? bits.Read(info.alphaBits) : 255;
+                }
+            }
+        }
+
+        int colorBits = info.colorBits;
+        int alphaBits = info.alphaBits;
+        if (info.endpointPBits || info.sharedPBits)
+        {
+            for (int subset = 0; subset < info.subsets; ++subset)
+            {
+                int pbits[2];
+                pbits[0] = bits.Read(1);
+                pbits[1] = info.endpointPBits ? bits.Read(1) : pbits[0];
+                for (int endpoint = 0; endpoint < 2; ++endpoint)
+                {
+                    for (int ch = 0; ch < (alphaBits ? 4 : 3); ++ch)
+                    {
+                        int& value = endpoints[subset][endpoint][ch];
+                        value = (value << 1) | pbits[endpoint];
+                    }
+                }
+            }
+            ++colorBits;
+            if (alphaBits)
+                ++alphaBits;
+        }
+
+        for (int subset = 0; subset < info.subsets; ++subset)
+        {
+            for (int endpoint = 0; endpoint < 2; ++endpoint)
+            {
+                for (int ch = 0; ch < 3; ++ch)
+                    endpoints[subset][endpoint][ch] = ExpandTo8Bits(endpoints[subset][endpoint][ch], colorBits);
+                if (alphaBits)
+                    endpoints[subset][endpoint][3] = ExpandTo8Bits(endpoints[subset][endpoint][3], alphaBits);
+            }
+        }
+
+        int indices[16];
+        for (int pixel = 0; pixel < 16; ++pixel)
+            indices[pixel] = bits.Read(info.indexBits - (IsAnchorPixel(info.subsets, partition, pixel) ? 1 : 0));
+
+        // Modes 4 and 5 have a second set of indices, used for alpha unless the index selection bit is set
+        int secondaryIndices[16] {};
+        if (info.secondaryIndexBits)
+        {
+            for (int pixel = 0; pixel < 16; ++pixel)
+                secondaryIndices[pixel] = bits.Read(info.secondaryIndexBits - (pixel == 0 ? 1 : 0));
+        }
+
+        for (int pixel = 0; pixel < 16; ++pixel)
+        {
+            int const subset = GetSubset(info.subsets, partition, pixel);
+            int const* e0 = endpoints[subset][0];
+            int const* e1 = endpoints[subset][1];
+
+            int colorIndex = indices[pixel];
+            int colorIndexBits = info.indexBits;
+            int alphaIndex = indices[pixel];
+            int alphaIndexBits = info.indexBits;
+            if (info.secondaryIndexBits)
+            {
+                if (indexSelection)
+                {
+                    colorIndex = secondaryIndices[pixel];
+                    colorIndexBits = info.secondaryIndexBits;
+                }
+                else
+                {
+                    alphaIndex = secondaryIndices[pixel];
+                    alphaIndexBits = info.secondaryIndexBits;
+                }
+            }
+
+            uint8_t* color = outColors[pixel];
+            for (int ch = 0; ch < 3; ++ch)
+                color[ch] = uint8_t(Interpolate(e0[ch], e1[ch], colorIndex, colorIndexBits));
+            color[3] = uint8_t(Interpolate(e0[3], e1[3], alphaIndex, alphaIndexBits));
+
+            // Rotation swaps the alpha channel with one of the color channels
+            if (rotation)
+                std::swap(color[3], color[rotation - 1]);
+        }
+    }
+
+    // Endpoint components of BC6H blocks, W and X are the endpoints of region 0, Y and Z of region 1
+    enum Bc6Field : uint8_t
+    {
+        RW, GW, BW, RX, GX, BX, RY, GY, BY, RZ, GZ, BZ
+    };
+
+    // A group of consecutive bits in a BC6H block that goes into bits [firstBit, firstBit + count) of a field
+    struct Bc6Segment
+    {
+        Bc6Field field;
+        uint8_t firstBit;
+        uint8_t count;
+    };
+
+    struct Bc6ModeInfo
+    {
+        int modeValue; // Low 2 bits for modes 1 and 2, low 5 bits for the others
+        bool transformed;
+        int regions;
+        int endpointBits;
+        int deltaBits[3];
+        Bc6Segment segments[24];
+    };
+
+    // Bit layouts of the BC6H modes, in the order of the mode numbers in the format specification.
+    // The high bits of the W endpoints in modes 13 and 14 are stored in reverse order.
+    const Bc6ModeInfo c_Bc6Modes[14] = {
+        { 0x00, true, 2, 10, { 5, 5, 5 }, {
+            { GY, 4, 1 }, { BY, 4, 1 }, { BZ, 4, 1 }, { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 5 },
+            { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 5 }, { BZ, 1, 1 },
+            { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 } } },
+        { 0x01, true, 2, 7, { 6, 6, 6 }, {
+            { GY, 5, 1 }, { GZ, 4, 1 }, { GZ, 5, 1 }, { RW, 0, 7 }, { BZ, 0, 1 }, { BZ, 1, 1 }, { BY, 4, 1 },
+            { GW, 0, 7 }, { BY, 5, 1 }, { BZ, 2, 1 }, { GY, 4, 1 }, { BW, 0, 7 }, { BZ, 3, 1 }, { BZ, 5, 1 },
+            { BZ, 4, 1 }, { RX, 0, 6 }, { GY, 0, 4 }, { GX, 0, 6 }, { GZ, 0, 4 }, { BX, 0, 6 }, { BY, 0, 4 },
+            { RY, 0, 6 }, { RZ, 0, 6 } } },
+        { 0x02, true, 2, 11, { 5, 4, 4 }, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 5 }, { RW, 10, 1 }, { GY, 0, 4 }, { GX, 0, 4 },
+            { GW, 10, 1 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 4 }, { BW, 10, 1 }, { BZ, 1, 1 }, { BY, 0, 4 },
+            { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 } } },
+        { 0x06, true, 2, 11, { 4, 5, 4 }, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 4 }, { RW, 10, 1 }, { GZ, 4, 1 }, { GY, 0, 4 },
+            { GX, 0, 5 }, { GW, 10, 1 }, { GZ, 0, 4 }, { BX, 0, 4 }, { BW, 10, 1 }, { BZ, 1, 1 }, { BY, 0, 4 },
+            { RY, 0, 4 }, { BZ, 0, 1 }, { BZ, 2, 1 }, { RZ, 0, 4 }, { GY, 4, 1 }, { BZ, 3, 1 } } },
+        { 0x0a, true, 2, 11, { 4, 4, 5 }, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 4 }, { RW, 10, 1 }, { BY, 4, 1 }, { GY, 0, 4 },
+            { GX, 0, 4 }, { GW, 10, 1 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 5 }, { BW, 10, 1 }, { BY, 0, 4 },
+            { RY, 0, 4 }, { BZ, 1, 1 }, { BZ, 2, 1 }, { RZ, 0, 4 }, { BZ, 4, 1 }, { BZ, 3, 1 } } },
+        { 0x0e, true, 2, 9, { 5, 5, 5 }, {
+            { RW, 0, 9 }, { BY, 4, 1 }, { GW, 0, 9 }, { GY, 4, 1 }, { BW, 0, 9 }, { BZ, 4, 1 }, { RX, 0, 5 },
+            { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 }, { GZ, 0, 4 }, { BX, 0, 5 }, { BZ, 1, 1 },
+            { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 } } },
+        { 0x12, true, 2, 8, { 6, 5, 5 }, {
+            { RW, 0, 8 }, { GZ, 4, 1 }, { BY, 4, 1 }, { GW, 0, 8 }, { BZ, 2, 1 }, { GY, 4, 1 }, { BW, 0, 8 },
+            { BZ, 3, 1 }, { BZ, 4, 1 }, { RX, 0, 6 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 }, { GZ, 0, 4 },
+            { BX, 0, 5 }, { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 6 }, { RZ, 0, 6 } } },
+        { 0x16, true, 2, 8, { 5, 6, 5 }, {
+            { RW, 0, 8 }, { BZ, 0, 1 }, { BY, 4, 1 }, { GW, 0, 8 }, { GY, 5, 1 }, { GY, 4, 1 }, { BW, 0, 8 },
+            { GZ, 5, 1 }, { BZ, 4, 1 }, { RX, 0, 5 }, { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 6 }, { GZ, 0, 4 },
+            { BX, 0, 5 }, { BZ, 1, 1 }, { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 } } },
+        { 0x1a, true, 2, 8, { 5, 5, 6 }, {
+            { RW, 0, 8 }, { BZ, 1, 1 }, { BY, 4, 1 }, { GW, 0, 8 }, { BY, 5, 1 }, { GY, 4, 1 }, { BW, 0, 8 },
+            { BZ, 5, 1 }, { BZ, 4, 1 }, { RX, 0, 5 }, { GZ, 4, 1 }, { GY, 0, 4 }, { GX, 0, 5 }, { BZ, 0, 1 },
+            { GZ, 0, 4 }, { BX, 0, 6 }, { BY, 0, 4 }, { RY, 0, 5 }, { BZ, 2, 1 }, { RZ, 0, 5 }, { BZ, 3, 1 } } },
+        { 0x1e, false, 2, 6, { 6, 6, 6 }, {
+            { RW, 0, 6 }, { GZ, 4, 1 }, { BZ, 0, 1 }, { BZ, 1, 1 }, { BY, 4, 1 }, { GW, 0, 6 }, { GY, 5, 1 },
+            { BY, 5, 1 }, { BZ, 2, 1 }, { GY, 4, 1 }, { BW, 0, 6 }, { GZ, 5, 1 }, { BZ, 3, 1 }, { BZ, 5, 1 },
+            { BZ, 4, 1 }, { RX, 0, 6 }, { GY, 0, 4 }, { GX, 0, 6 }, { GZ, 0, 4 }, { BX, 0, 6 }, { BY, 0, 4 },
+            { RY, 0, 6 }, { RZ, 0, 6 } } },
+        { 0x03, false, 1, 10, { 10, 10, 10 }, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 10 }, { GX, 0, 10 }, { BX, 0, 10 } } },
+        { 0x07, true, 1, 11, { 9, 9, 9 }, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 9 }, { RW, 10, 1 }, { GX, 0, 9 }, { GW, 10, 1 },
+            { BX, 0, 9 }, { BW, 10, 1 } } },
+        { 0x0b, true, 1, 12, { 8, 8, 8 }, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 8 }, { RW, 11, 1 }, { RW, 10, 1 }, { GX, 0, 8 },
+            { GW, 11, 1 }, { GW, 10, 1 }, { BX, 0, 8 }, { BW, 11, 1 }, { BW, 10, 1 } } },
+        { 0x0f, true, 1, 16, { 4, 4, 4 }, {
+            { RW, 0, 10 }, { GW, 0, 10 }, { BW, 0, 10 }, { RX, 0, 4 }, { RW, 15, 1 }, { RW, 14, 1 }, { RW, 13, 1 },
+            { RW, 12, 1 }, { RW, 11, 1 }, { RW, 10, 1 }, { GX, 0, 4 }, { GW, 15, 1 }, { GW, 14, 1 }, { GW, 13, 1 },
+            { GW, 12, 1 }, { GW, 11, 1 }, { GW, 10, 1 }, { BX, 0, 4 }, { BW, 15, 1 }, { BW, 14, 1 }, { BW, 13, 1 },
+            { BW, 12, 1 }, { BW, 11, 1 }, { BW, 10, 1 } } },
+    };
+
+    int SignExtend(int value, int bits)
+    {
+        int const shift = 32 - bits;
+        return int(uint32_t(value) << shift) >> shift;
+    }
+
+    // Scales an endpoint component to the 16-bit (unsigned) or 15-bit (signed) interpolation range
+    int UnquantizeBc6Endpoint(int value, int bits, bool isSigned)
+    {
+        if (!isSigned)
+        {
+            if (bits >= 15 || value == 0)
+                return value;
+            if (value == (1 << bits) - 1)
+                return 0xffff;
+            return ((value << 16) + 0x8000) >> bits;
+        }
+
+        if (bits >= 16)
+            return value;
+
+        bool const negative = value < 0;
+        int const magnitude = negative ? -value : value;
+        int result;
+        if (magnitude == 0)
+            result = 0;
+        else if (magnitude >= (1 << (bits - 1)) - 1)
+            result = 0x7fff;
+        else
+            result = ((magnitude << 15) + 0x4000) >> (bits - 1);
+        return negative ? -result : result;
+    }
+
+    // Converts an interpolated value into the bits of a half-float number
+    uint16_t FinishUnquantizeBc6(int value, bool isSigned)
+    {
+        if (!isSigned)
+            return uint16_t((value * 31) >> 6);
+
+        if (value < 0)
+            return uint16_t(0x8000 | (((-value) * 31) >> 5));
+        return uint16_t((value * 31) >> 5);
+    }
+
+    void DecodeBc6Block(uint8_t const* block, bool isSigned, uint16_t outColors[16][3])
+    {
+        BlockBitReader bits(block);
+        int modeValue = bits.Read(2);
+        if (modeValue >= 2)
+            modeValue |= bits.Read(3) << 2;
+
+        Bc6ModeInfo const* info = nullptr;
+        for (Bc6ModeInfo const& candidate : c_Bc6Modes)
+        {
+            if (candidate.modeValue == modeValue)
+                info = &candidate;
+        }
+
+        // The reserved modes decode into black
+        if (!info)
+        {
+            memset(outColors, 0, 16 * 3 * sizeof(uint16_t));
+            return;
+        }
+
+        int fields[12] {};
+        for (Bc6Segment const& segment : info->segments)
+        {
+            if (segment.count == 0)
+                break;
+            fields[segment.field] |= bits.Read(segment.count) << segment.firstBit;
+        }
+
+        int const partition = info->regions == 2 ? bits.Read(5) : 0;
+        int const endpointCount = info->regions * 2;
+
+        // endpoints[0] is the base endpoint W, the other ones are deltas from it in the transformed modes
+        int endpoints[4][3];
+        for (int endpoint = 0; endpoint < endpointCount; ++endpoint)
+        {
+            for (int ch = 0; ch < 3; ++ch)
+                endpoints[endpoint][ch] = fields[endpoint * 3 + ch];
+        }
+
+        int const mask = (1 << info->endpointBits) - 1;
+        for (int ch = 0; ch < 3; ++ch)
+        {
+            if (isSigned)
+                endpoints[0][ch] = SignExtend(endpoints[0][ch], info->endpointBits);
+
+            for (int endpoint = 1; endpoint < endpointCount; ++endpoint)
+            {
+                int& value = endpoints[endpoint][ch];
+                if (info->transformed || isSigned)
+                    value = SignExtend(value, info->deltaBits[ch]);
+
+                if (info->transformed)
+                {
+                    value = (endpoints[0][ch] + value) & mask;
+                    if (isSigned)
+                        value = SignExtend(value, info->endpointBits);
+                }
+            }
+        }
+
+        for (int endpoint = 0; endpoint < endpointCount; ++endpoint)
+        {
+            for (int ch = 0; ch < 3; ++ch)
+                endpoints[endpoint][ch] = UnquantizeBc6Endpoint(endpoints[endpoint][ch], info->endpointBits, isSigned);
+        }
+
+        int const indexBits = info->regions == 2 ? 3 : 4;
+        for (int pixel = 0; pixel < 16; ++pixel)
+        {
+            int const index = bits.Read(indexBits - (IsAnchorPixel(info->regions, partition, pixel) ? 1 : 0));
+            int const region = GetSubset(info->regions, partition, pixel);
+            for (int ch = 0; ch < 3; ++ch)
+            {
+                int const value = Interpolate(endpoints[region * 2][ch], endpoints[region * 2 + 1][ch], index,
+                    indexBits);
+                outColors[pixel][ch] = FinishUnquantizeBc6(value, isSigned);
+            }
+        }
+    }
+}
+
+bool IsTextureContainerFileExtension(std::string const& extension)
+{
+    return extension == ".dds" || extension == ".ktx2";
+}
+
+bool ReadTextureContainerInfo(void const* data, uint64_t size, TextureContainerInfo& outInfo, std::string& outError)
+{
+    outInfo = TextureContainerInfo();
+
+    uint8_t const* bytes = static_cast<uint8_t const*>(data);
+    if (size >= sizeof(uint32_t))
+    {
+        uint32_t magic;
+        memcpy(&magic, bytes, sizeof(magic));
+        if (magic == DDS_MAGIC)
+            return ReadDdsInfo(bytes, size, outInfo, outError);
+    }
+
+    if (size >= sizeof(c_Ktx2Identifier) && memcmp(bytes, c_Ktx2Identifier, sizeof(c_Ktx2Identifier)) == 0)
+        return ReadKtx2Info(bytes, size, outInfo, outError);
+
+    outError = "Not a DDS or KTX2 file.";
+    return false;
+}
+
+bool DecodeBlockCompressedImage(ntc::BlockCompressedFormat format, bool isSigned, void const* blocks,
+    uint64_t blocksSize, int width, int height, uint8_t* outPixels)
+{
+    int channels;
+    uint64_t bytesPerBlock;
+    switch (format)
+    {
+    case BCF::BC1: channels = 4; bytesPerBlock = 8; break;
+    case BCF::BC2:
+    case BCF::BC3:
+    case BCF::BC7: channels = 4; bytesPerBlock = 16; break;
+    case BCF::BC4: channels = 1; bytesPerBlock = 8; break;
+    case BCF::BC5: channels = 2; bytesPerBlock = 16; break;
+    case BCF::BC6: channels = 3; bytesPerBlock = 16; break;
+    default: return false;
+    }
+
+    // BC6H is decoded into half-float pixels, all other formats into UNORM8 pixels
+    size_t const pixelSize = size_t(channels) * (format == BCF::BC6 ? sizeof(uint16_t) : sizeof(uint8_t));
+
+    int const blocksX = (width + 3) / 4;
+    int const blocksY = (height + 3) / 4;
+    if (blocksSize < uint64_t(blocksX) * uint64_t(blocksY) * bytesPerBlock)
+        return false;
+
+    uint8_t const* block = static_cast<uint8_t const*>(blocks);
+    for (int blockY = 0; blockY < blocksY; ++blockY)
+    {
+        for (int blockX = 0; blockX < blocksX; ++blockX, block += bytesPerBlock)
+        {
+            uint8_t texels[16][4] {};
+            uint16_t halfTexels[16][3];
+            uint8_t values[16];
+
+            switch (format)
+            {
+            case BCF::BC1:
+                DecodeColorBlock(block, true, texels);
+                break;
+            case BCF::BC2:
+                DecodeColorBlock(block + 8, false, texels);
+                for (int pixel = 0; pixel < 16; ++pixel)
+                    texels[pixel][3] = uint8_t(((block[pixel / 2] >> ((pixel & 1) * 4)) & 15) * 17);
+                break;
+            case BCF::BC3:
+                DecodeColorBlock(block + 8, false, texels);
+                DecodeSingleChannelBlock(block, values);
+                for (int pixel = 0; pixel < 16; ++pixel)
+                    texels[pixel][3] = values[pixel];
+                break;
+            case BCF::BC4:
+                DecodeSingleChannelBlock(block, values);
+                for (int pixel = 0; pixel < 16; ++pixel)
+                    texels[pixel][0] = values[pixel];
+                break;
+            case BCF::BC5:
+                DecodeSingleChannelBlock(block, values);
+                for (int pixel = 0; pixel < 16; ++pixel)
+                    texels[pixel][0] = values[pixel];
+                DecodeSingleChannelBlock(block + 8, values);
+                for (int pixel = 0; pixel < 16; ++pixel)
+                    texels[pixel][1] = values[pixel];
+                break;
+            case BCF::BC6:
+                DecodeBc6Block(block, isSigned, halfTexels);
+                break;
+            case BCF::BC7:
+                DecodeBc7Block(block, texels);
+                break;
+            default:
+                return false;
+            }
+
+            uint8_t const* decodedTexels = format == BCF::BC6
+                ? reinterpret_cast<uint8_t const*>(halfTexels)
+                : &texels[0][0];
+            size_t const decodedTexelStride = format == BCF::BC6 ? sizeof(halfTexels[0]) : sizeof(texels[0]);
+
+            // Store the block, clipping it at the image edges
+            for (int y = 0; y < 4 && blockY * 4 + y < height; ++y)
+            {
+                for (int x = 0; x < 4 && blockX * 4 + x < width; ++x)
+                {
+                    uint8_t* pixel = outPixels + (size_t(blockY * 4 + y) * size_t(width) + size_t(blockX * 4 + x))
+                        * pixelSize;
+                    memcpy(pixel, decodedTexels + size_t(y * 4 + x) * decodedTexelStride, pixelSize);
+                }
+            }
+        }
+    }
+
+    return true;
+}
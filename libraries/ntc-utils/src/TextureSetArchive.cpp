@@ -0,0 +1,287 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/TextureSetArchive.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+// Archive layout, little-endian:
+//   ArchiveHeader, padded to c_TextureSetArchiveAlignment
+//   NTC containers, each starting at a multiple of c_TextureSetArchiveAlignment
+//   Index: for each entry, ArchiveIndexEntry followed by the name, padded to 8 bytes
+namespace
+{
+    constexpr char c_ArchiveSignature[4] = { 'N', 'T', 'C', 'A' };
+    constexpr uint32_t c_ArchiveVersion = 1;
+
+    // Signature and the JSON chunk location in the NTC container header, see TextureSetFile.md
+    constexpr char c_ContainerSignature[4] = { 'N', 'T', 'E', 'X' };
+    constexpr size_t c_ContainerJsonOffsetPosition = 8;
+    constexpr size_t c_ContainerHeaderSize = 40;
+
+    struct ArchiveHeader
+    {
+        char signature[4];
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t reserved;
+        uint64_t indexOffset;
+        uint64_t indexSize;
+    };
+    static_assert(sizeof(ArchiveHeader) == 32);
+
+    struct ArchiveIndexEntry
+    {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t descriptorSize;
+        uint64_t latentOffset;
+        uint64_t latentSize;
+        int32_t width;
+        int32_t height;
+        int32_t channels;
+        int32_t mips;
+        uint32_t nameLength;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(ArchiveIndexEntry) == 64);
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    uint8_t const c_Zeros[c_TextureSetArchiveAlignment] = {};
+}
+
+std::unique_ptr<TextureSetArchive> TextureSetArchive::Open(char const* fileName, std::string& outError)
+{
+    std::string openError;
+    std::unique_ptr<MappedFileStream> file = MappedFileStream::Open(fileName, &openError);
+    if (!file)
+    {
+        outError = std::string("Cannot open archive '") + fileName + "': " + openError;
+        return nullptr;
+    }
+
+    auto invalidArchive = [&outError, fileName]()
+    {
+        outError = std::string("File '") + fileName + "' is not a valid texture set archive.";
+        return nullptr;
+    };
+
+    ArchiveHeader const* header = static_cast<ArchiveHeader const*>(file->GetData(0, sizeof(ArchiveHeader)));
+    if (!header || memcmp(header->signature, c_ArchiveSignature, sizeof(c_ArchiveSignature)) != 0 ||
+        header->version != c_ArchiveVersion)
+        return invalidArchive();
+
+    uint8_t const* index = static_cast<uint8_t const*>(file->GetData(header->indexOffset, header->indexSize));
+    if (!index && header->indexSize != 0)
+        return invalidArchive();
+
+    // Every entry takes at least its fixed part in the index, check that before reserving space for the entries
+    if (uint64_t(header->entryCount) * sizeof(ArchiveIndexEntry) > header->indexSize)
+        return invalidArchive();
+
+    std::unique_ptr<TextureSetArchive> archive(new TextureSetArchive());
+    archive->m_entries.reserve(header->entryCount);
+
+    uint64_t position = 0;
+    for (uint32_t entryIndex = 0; entryIndex < header->entryCount; ++entryIndex)
+    {
+        if (sizeof(ArchiveIndexEntry) > header->indexSize - position)
+            return invalidArchive();
+
+        ArchiveIndexEntry indexEntry;
+        memcpy(&indexEntry, index + position, sizeof(indexEntry));
+        position += sizeof(indexEntry);
+
+        if (indexEntry.nameLength > header->indexSize - position ||
+            !file->GetData(indexEntry.offset, indexEntry.size) ||
+            indexEntry.descriptorSize > indexEntry.size ||
+            indexEntry.latentOffset > indexEntry.size ||
+            indexEntry.latentSize > indexEntry.size - indexEntry.latentOffset)
+            return invalidArchive();
+
+        TextureSetArchiveEntry& entry = archive->m_entries.emplace_back();
+        entry.name.assign(reinterpret_cast<char const*>(index + position), indexEntry.nameLength);
+        entry.offset = indexEntry.offset;
+        entry.size = indexEntry.size;
+        entry.descriptorSize = indexEntry.descriptorSize;
+        entry.latents.offset = indexEntry.latentOffset;
+        entry.latents.size = indexEntry.latentSize;
+        entry.width = indexEntry.width;
+        entry.height = indexEntry.height;
+        entry.channels = indexEntry.channels;
+        entry.mips = indexEntry.mips;
+        position = std::min(header->indexSize, AlignUp(position + indexEntry.nameLength, 8));
+    }
+
+    std::sort(archive->m_entries.begin(), archive->m_entries.end(),
+        [](TextureSetArchiveEntry const& a, TextureSetArchiveEntry const& b) { return a.offset < b.offset; });
+
+    for (size_t entryIndex = 0; entryIndex < archive->m_entries.size(); ++entryIndex)
+        archive->m_entriesByName[archive->m_entries[entryIndex].name] = entryIndex;
+
+    archive->m_file = std::move(file);
+    return archive;
+}
+
+TextureSetArchiveEntry const* TextureSetArchive::FindEntry(std::string const& name) const
+{
+    auto found = m_entriesByName.find(name);
+    if (found == m_entriesByName.end())
+        return nullptr;
+
+    return &m_entries[found->second];
+}
+
+std::unique_ptr<MappedFileStream> TextureSetArchive::OpenEntry(TextureSetArchiveEntry const& entry) const
+{
+    return m_file->CreateView(entry.offset, entry.size);
+}
+
+void TextureSetArchive::PrefetchEntry(TextureSetArchiveEntry const& entry) const
+{
+    m_file->Prefetch(entry.offset, entry.size);
+}
+
+TextureSetArchiveWriter::~TextureSetArchiveWriter()
+{
+    if (m_file)
+        fclose(m_file);
+}
+
+bool TextureSetArchiveWriter::Write(void const* data, size_t size)
+{
+    if (size != 0 && fwrite(data, size, 1, m_file) != 1)
+        return false;
+
+    m_position += size;
+    return true;
+}
+
+bool TextureSetArchiveWriter::Open(char const* fileName, std::string& outError)
+{
+    m_file = fopen(fileName, "wb");
+    if (!m_file)
+    {
+        outError = std::string("Cannot open '") + fileName + "' for writing: " + strerror(errno);
+        return false;
+    }
+    m_fileName = fileName;
+
+    // The header is written by Close, when the index location is known
+    if (!Write(c_Zeros, c_TextureSetArchiveAlignment))
+    {
+        outError = std::string("Failed to write '") + fileName + "'.";
+        return false;
+    }
+
+    return true;
+}
+
+bool TextureSetArchiveWriter::AddTextureSet(std::string const& name, void const* data, size_t size,
+    ntc::ITextureSetMetadata* metadata, std::string& outError)
+{
+    if (m_entriesByName.find(name) != m_entriesByName.end())
+    {
+        outError = "Texture set '" + name + "' is already in the archive.";
+        return false;
+    }
+
+    uint8_t const* bytes = static_cast<uint8_t const*>(data);
+    if (size < c_ContainerHeaderSize || memcmp(bytes, c_ContainerSignature, sizeof(c_ContainerSignature)) != 0)
+    {
+        outError = "Texture set '" + name + "' is not an NTC container.";
+        return false;
+    }
+
+    uint64_t jsonLocation[2]; // Offset and size
+    memcpy(jsonLocation, bytes + c_ContainerJsonOffsetPosition, sizeof(jsonLocation));
+
+    ntc::TextureSetDesc const& desc = metadata->GetDesc();
+    TextureSetArchiveEntry entry;
+    entry.name = name;
+    entry.offset = m_position;
+    entry.size = size;
+    entry.descriptorSize = std::min<uint64_t>(size, jsonLocation[0] + jsonLocation[1]);
+    entry.width = desc.width;
+    entry.height = desc.height;
+    entry.channels = desc.channels;
+    entry.mips = desc.mips;
+
+    ntc::Status ntcStatus = metadata->GetStreamRangeForLatents(0, desc.mips, entry.latents);
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        outError = "Cannot get the latent range for texture set '" + name + "', code = " +
+            ntc::StatusToString(ntcStatus) + ": " + ntc::GetLastErrorMessage();
+        return false;
+    }
+
+    size_t const padding = size_t(AlignUp(m_position + size, c_TextureSetArchiveAlignment) - (m_position + size));
+    if (!Write(data, size) || !Write(c_Zeros, padding))
+    {
+        outError = "Failed to write '" + m_fileName + "'.";
+        return false;
+    }
+
+    m_entriesByName[name] = m_entries.size();
+    m_entries.push_back(std::move(entry));
+    return true;
+}
+
+bool TextureSetArchiveWriter::Close(std::string& outError)
+{
+    if (!m_file)
+        return false;
+
+    ArchiveHeader header{};
+    memcpy(header.signature, c_ArchiveSignature, sizeof(header.signature));
+    header.version = c_ArchiveVersion;
+    header.entryCount = uint32_t(m_entries.size());
+    header.indexOffset = m_position;
+
+    bool success = true;
+    for (TextureSetArchiveEntry const& entry : m_entries)
+    {
+        ArchiveIndexEntry indexEntry{};
+        indexEntry.offset = entry.offset;
+        indexEntry.size = entry.size;
+        indexEntry.descriptorSize = entry.descriptorSize;
+        indexEntry.latentOffset = entry.latents.offset;
+        indexEntry.latentSize = entry.latents.size;
+        indexEntry.width = entry.width;
+        indexEntry.height = entry.height;
+        indexEntry.channels = entry.channels;
+        indexEntry.mips = entry.mips;
+        indexEntry.nameLength = uint32_t(entry.name.size());
+
+        size_t const padding = size_t(AlignUp(entry.name.size(), 8) - entry.name.size());
+        success = success && Write(&indexEntry, sizeof(indexEntry)) &&
+            Write(entry.name.data(), entry.name.size()) && Write(c_Zeros, padding);
+    }
+    header.indexSize = m_position - header.indexOffset;
+
+    success = success && fseek(m_file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, m_file) == 1;
+    success = (fclose(m_file) == 0) && success;
+    m_file = nullptr;
+
+    if (!success)
+    {
+        outError = "Failed to write '" + m_fileName + "'.";
+        return false;
+    }
+
+    return true;
+}
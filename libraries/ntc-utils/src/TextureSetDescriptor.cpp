@@ -0,0 +1,161 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/TextureSetDescriptor.h>
+#include <json/value.h>
+#include <json/reader.h>
+#include <cstring>
+#include <memory>
+#include <string>
+
+// Container header layout, see docs/TextureSetFile.md
+namespace
+{
+    constexpr char c_ContainerSignature[4] = { 'N', 'T', 'E', 'X' };
+
+    // The earlier binary-only format used the same signature with versions up to 19
+    constexpr uint32_t c_ContainerVersion = 0x100;
+
+    struct ContainerHeader
+    {
+        char signature[4];
+        uint32_t version;
+        uint64_t jsonOffset;
+        uint64_t jsonSize;
+        uint64_t dataOffset;
+        uint64_t dataSize;
+    };
+    static_assert(sizeof(ContainerHeader) == 40);
+
+    // Real descriptors are a few kilobytes, reject the sizes that can only come from corrupted files.
+    constexpr uint64_t c_MaxJsonSize = 64ull << 20;
+
+    void ReadMlp(Json::Value const& node, std::vector<TextureSetDescriptorMlp>& outMlps)
+    {
+        Json::Value const& layers = node["layers"];
+        if (!layers.isArray() || layers.empty())
+            return;
+
+        TextureSetDescriptorMlp& mlp = outMlps.emplace_back();
+        mlp.weightType = layers[0]["weightType"].asString();
+        mlp.layerChannels.push_back(layers[0]["inputChannels"].asInt());
+        for (Json::Value const& layer : layers)
+            mlp.layerChannels.push_back(layer["outputChannels"].asInt());
+    }
+}
+
+bool ReadTextureSetDescriptor(ntc::IStream* stream, TextureSetDescriptor& outDescriptor, std::string& outError)
+{
+    ContainerHeader header;
+    if (!stream->Seek(0) || !stream->Read(&header, sizeof(header)) ||
+        memcmp(header.signature, c_ContainerSignature, sizeof(c_ContainerSignature)) != 0)
+    {
+        outError = "Not an NTC container.";
+        return false;
+    }
+
+    if (header.version != c_ContainerVersion)
+    {
+        outError = header.version < c_ContainerVersion
+            ? "Legacy binary NTC file, version " + std::to_string(header.version) + "."
+            : "Unsupported container version " + std::to_string(header.version) + ".";
+        return false;
+    }
+
+    uint64_t const streamSize = stream->Size();
+    if (header.jsonSize == 0 || header.jsonSize > c_MaxJsonSize || header.jsonOffset > streamSize ||
+        header.jsonSize > streamSize - header.jsonOffset)
+    {
+        outError = "Invalid JSON chunk location in the container header.";
+        return false;
+    }
+
+    std::unique_ptr<char[]> json(new char[header.jsonSize]);
+    if (!stream->Seek(header.jsonOffset) || !stream->Read(json.get(), header.jsonSize))
+    {
+        outError = "Failed to read the JSON chunk.";
+        return false;
+    }
+
+    // The chunk is padded with zeros to a multiple of 4 bytes
+    size_t jsonLength = size_t(header.jsonSize);
+    while (jsonLength > 0 && json[jsonLength - 1] == 0)
+        --jsonLength;
+
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+    Json::Value root;
+    Json::String errorMessages;
+    if (!reader->parse(json.get(), json.get() + jsonLength, &root, &errorMessages))
+    {
+        outError = "Cannot parse the JSON chunk: " + errorMessages;
+        return false;
+    }
+
+    if (!root.isObject() || !root["width"].isNumeric() || !root["height"].isNumeric() ||
+        !root["numChannels"].isNumeric())
+    {
+        outError = "Malformed JSON chunk: missing texture set dimensions.";
+        return false;
+    }
+
+    TextureSetDescriptor& desc = outDescriptor;
+    desc.width = root["width"].asInt();
+    desc.height = root["height"].asInt();
+    desc.channels = root["numChannels"].asInt();
+    desc.mips = root.get("numColorMips", 1).asInt();
+    desc.descriptorSize = header.jsonOffset + header.jsonSize;
+    desc.dataSize = header.dataSize;
+
+    Json::Value const& latentShape = root["latentShape"];
+    desc.hasLatentShape = latentShape.isObject();
+    if (desc.hasLatentShape)
+    {
+        desc.highResFeatures = latentShape["highResFeatures"].asInt();
+        desc.lowResFeatures = latentShape["lowResFeatures"].asInt();
+        desc.highResQuantBits = latentShape["highResQuantBits"].asInt();
+        desc.lowResQuantBits = latentShape["lowResQuantBits"].asInt();
+    }
+    desc.latentMips = root["latents"].isArray() ? int(root["latents"].size()) : 0;
+
+    for (Json::Value const& node : root["textures"])
+    {
+        if (!node.isObject())
+            continue;
+
+        TextureSetDescriptorTexture& texture = desc.textures.emplace_back();
+        texture.name = node["name"].asString();
+        texture.firstChannel = node["firstChannel"].asInt();
+        texture.numChannels = node["numChannels"].asInt();
+        texture.channelFormat = node.get("channelFormat", texture.channelFormat).asString();
+        texture.rgbColorSpace = node.get("rgbColorSpace", texture.rgbColorSpace).asString();
+        // The schema documents the key as 'alpaColorSpace', accept both spellings
+        texture.alphaColorSpace = node.get("alphaColorSpace",
+            node.get("alpaColorSpace", texture.alphaColorSpace)).asString();
+        texture.bcFormat = node.get("bcFormat", texture.bcFormat).asString();
+        texture.bcQuality = node.get("bcQuality", texture.bcQuality).asInt();
+        texture.hasBcAccelerationData = node.isMember("bcAccelerationDataView");
+    }
+
+    // The legacy 'mlp' field goes first, as if it was a part of 'mlpVersions'
+    if (root["mlp"].isObject())
+        ReadMlp(root["mlp"], desc.mlps);
+    for (Json::Value const& node : root["mlpVersions"])
+    {
+        if (node.isObject())
+            ReadMlp(node, desc.mlps);
+    }
+
+    return true;
+}
@@ -22,16 +22,19 @@ Use like this:
   print(f'Compression successful, PSNR = {result.overallPsnr})
 
 When an error happens in ntc-cli, the run(...) function will raise a RuntimeError.
+To follow the progress, pass a function that receives the telemetry events as they arrive:
+
+  result = ntc.run(task, onEvent = lambda event: print(event))
 """
 
 from dataclasses import dataclass
 from typing import Optional, List, Tuple, Any, Callable
-from argparse import Namespace
+import json
 import subprocess
-import re
 import os
 import signal
 import sys
+import tempfile
 import threading
 import time
 import traceback
@@ -80,18 +83,26 @@ class Arguments:
     
     # All the below parameters are passed directly as command line arguments to ntc-cli
     adapter: Optional[int] = None
+    batch: str = ''
+    batchReport: str = ''
     bcFormat: str = ''
     bcPsnrThreshold: Optional[float] = None
     bcPsnrOffset: Optional[float] = None
     bcQuality: Optional[int] = None
     benchmark: Optional[int] = None
     bitsPerPixel: Optional[float] = None
+    cache: str = ''
+    cacheSizeLimit: Optional[int] = None
     compress: bool = False
+    cpuAdapter: bool = False
     cudaDevice: Optional[int] = None
+    cudaDevices: str = ''
     debug: bool = False
     decompress: bool = False
     describe: bool = False
     dimensions: str = None
+    earlyStopMargin: Optional[float] = None
+    earlyStopPsnr: Optional[float] = None
     discardMaskedOutPixels: bool = False
     experimentalKnob: Optional[float] = None
     generateMips: bool = False
@@ -104,6 +115,7 @@ class Arguments:
     loadCompressed: str = ''
     loadImages: str = ''
     loadManifest: str = ''
+    loadMemoryBudget: Optional[int] = None
     loadMips: bool = False
     matchBcPsnr: bool = False
     maxBcPsnr: Optional[float] = None
@@ -112,6 +124,9 @@ class Arguments:
     networkLearningRate: Optional[float] = None
     networkVersion: str = ''
     optimizeBC: bool = False
+    parallelSearch: Optional[int] = None
+    plateauIterations: Optional[int] = None
+    plateauThreshold: Optional[float] = None
     randomSeed: Optional[int] = None
     saveCompressed: str = ''
     saveImages: str = ''
@@ -120,6 +135,8 @@ class Arguments:
     stepsPerIteration: Optional[int] = None
     targetPsnr: Optional[float] = None
     trainingSteps: Optional[int] = None
+    warmStart: str = ''
+    warmStartSteps: Optional[int] = None
 
     def get_command_line(self) -> List[str]:
         "Returns the command line with the provided arguments, as a list passable to subprocess.call."
@@ -171,6 +188,7 @@ class Arguments:
 class CompressionRun:
     bitsPerPixel: Optional[float] = None
     learningCurve: Optional[List[Tuple[int, float, float]]] = None # (steps, ms/step, psnr)
+    earlyStopStep: Optional[int] = None # step at which the training was stopped by an early stop criterion
 
 @dataclass
 class Result:
@@ -179,6 +197,9 @@ class Result:
     overallPsnrFP8: Optional[float] = None
     perMipPsnr: Optional[List[float]] = None
     bitsPerPixel: Optional[float] = None
+    cacheHit: Optional[bool] = None # set when using --cache
+    warmStartPsnr: Optional[float] = None # PSNR of the data loaded with --warmStart, None if it was incompatible
+    warmStartRetained: Optional[bool] = None # False if the tool fell back to full training after the warm start
     combinedBcPsnr: Optional[float] = None
     combinedBcBitsPerPixel: Optional[float] = None
     compressionRuns: Optional[List[CompressionRun]] = None
@@ -188,6 +209,11 @@ class Result:
     gpuName: str = ''
     graphicsApi: str = ''
     gpuFeatures: Optional[List[str]] = None # may contain 'DP4a', 'FP16', 'CoopVecInt8', 'CoopVecFP8'
+    perTexturePsnr: Optional[dict] = None # texture name -> PSNR, when decompressing with reference images
+    stageTimes: Optional[dict] = None # 'load', 'compression', 'save' -> seconds
+    gpuMemoryUsed: Optional[int] = None # bytes used on the CUDA device after compression, including other processes
+    hostMemoryPeak: Optional[int] = None # peak bytes allocated by the NTC library in host memory
+    batchJobs: Optional[List[dict]] = None # 'batchJob' events when using --batch
 
     # describe command output:
     dimensions: Optional[Tuple[int, int]] = None # (width, height)
@@ -211,126 +237,215 @@ class RuntimeError(Exception):
         if self.stderr: s += f'stderr:\n{self.stderr}'
         return s
 
+@dataclass
+class Cancelled(Exception):
+    "Raised by run(...) when the 'onEvent' callback returned False and the tool was terminated."
+    command: List[str]
+
+    def __str__(self) -> str:
+        return f'The following command was cancelled:\n> {" ".join(self.command)}\n'
+
 def _create_or_append_list(lst: Optional[List[Any]], x: Any) -> List[Any]:
     if lst is None:
         return [x]
     lst.append(x)
     return lst
 
-class Regex:
-    def __init__(self, pattern: str):
-        self.regex = re.compile(pattern)
-
-    def parse(self, line: str):
-        match = self.regex.match(line)
-        if not match:
-            return None
-        return Namespace(**match.groupdict())
-
-_baseCompRateRegex = Regex(r'Base compression rate: --bitsPerPixel (?P<bpp>[0-9\.]+)')
-_bppRegex = Regex(r'Selected compression rate: (?P<bpp>[0-9\.]+) bpp, (?P<psnr>[0-9\.]+|inf) dB PSNR')
-_bcQualityRegex = Regex(r'Combined BCn PSNR: (?P<psnr>[0-9\.]+|inf) dB, bit rate: (?P<bpp>[0-9\.]+) bpp')
-_cudaDecompressionTimeRegex = Regex(r'CUDA decompression time: (?P<milliseconds>[0-9\.]+) ms')
-_dimensionsRegex = Regex(r'Dimensions: (?P<width>\d+)x(?P<height>\d+), (?P<channels>\d+) channels, (?P<mipLevels>\d+) mip level\(s\)')
-_experimentRegex = Regex(r'Experiment (?P<index>\d+): (?P<bpp>[0-9\.]+) bpp')
-_fileSizeRegex = Regex(r'File size: (?P<bytes>\d+) bytes, (?P<bpp>[0-9\.]+) bits per pixel')
-_graphicsDecompressionTimeRegex = Regex(r'Median decompression time over \d+ iterations: (?P<milliseconds>[0-9\.]+) ms')
-_latentShapeRegex = Regex(r'Latent shape: --gridSizeScale (?P<gss>\d+) --highResFeatures (?P<hrf>\d+) '
-                         r'--lowResFeatures (?P<lrf>\d+) --highResQuantBits (?P<hrqb>\d+) --lowResQuantBits (?P<lrqb>\d+)')
-_mipRegex = Regex(r'MIP\s+(?P<mipLevel>\d+)\s+PSNR: (?P<psnr>[0-9\.]+|inf) dB')
-_networkVersionRegex = Regex(r'Network version: (?P<version>[A-Z_]+)')
-_overallPsnrRegex = Regex(r'Overall PSNR \((?P<type>\w+) weights\): (?P<psnr>[0-9\.]+|inf) dB')
-_stepRegex = Regex(r'Training: (?P<steps>\d+) steps, (?P<milliseconds>[0-9\.]+) ms/step, intermediate PSNR: (?P<psnr>[0-9\.]+|inf) dB')
-_systemRegex = Regex(r'Using (?P<gpu>.+) with (?P<api>.+) API\. DP4a \[(?P<dp4a>[YN])\], FP16 \[(?P<fp16>[YN])\], CoopVec-Int8 \[(?P<coopVecInt8>[YN])\], CoopVec-FP8 \[(?P<coopVecFP8>[YN])\]')
-
-
-def run(args: Arguments) -> Result:
-    "Executes the NTC-CLI tool with the provided arguments and returns its interpreted output as a Results object."
-
-    command = args.get_command_line()
+# Version of the ntc-cli telemetry stream that this module understands, see docs/CommandLineTool.md
+TELEMETRY_VERSION = 1
 
-    taskStartTime = time.time()
-    output = subprocess.run(command, capture_output=True, text=True)
-    taskEndTime = time.time()
+def _parse_event(line: str) -> Optional[dict]:
+    "Returns the telemetry event on the line, or None if the line is not a valid event."
+    if not line.startswith('{"'):
+        return None
+    try:
+        event = json.loads(line)
+    except json.JSONDecodeError:
+        return None
+    return event if isinstance(event, dict) and 'event' in event else None
+
+class _EventProcessor:
+    "Accumulates the telemetry events of one ntc-cli run into a Result."
+
+    def __init__(self, result: Result):
+        self.result = result
+        self.compressionRun = CompressionRun()
+
+    def _finish_run(self):
+        if self.compressionRun.learningCurve:
+            self.result.compressionRuns = _create_or_append_list(self.result.compressionRuns, self.compressionRun)
+
+    def process(self, event: dict):
+        result = self.result
+        name = event['event']
+
+        if name == 'start':
+            if event.get('version', 0) > TELEMETRY_VERSION:
+                print(f'Warning: ntc-cli telemetry version {event["version"]} is newer than the supported '
+                      f'version {TELEMETRY_VERSION}.', file=sys.stderr)
+
+        elif name == 'device':
+            if event['api'] == 'CUDA':
+                if not result.gpuName: result.gpuName = event['name']
+            else:
+                result.gpuName = event['name']
+                result.graphicsApi = event['api']
+                result.gpuFeatures = list(event.get('features', []))
+
+        elif name == 'textureSet':
+            result.dimensions = event['width'], event['height']
+            result.channels = event['channels']
+            result.mipLevels = event['mips']
+            result.bitsPerPixel = event['bitsPerPixel']
+            result.latentShape = LatentShape(**event['latentShape'])
+            result.networkVersion = event['networkVersion']
+
+        elif name == 'experiment':
+            self._finish_run()
+            self.compressionRun = CompressionRun(bitsPerPixel=event['bitsPerPixel'])
+
+        elif name == 'trainingStep':
+            point = event['step'], event['millisecondsPerStep'], event['psnr']
+            self.compressionRun.learningCurve = _create_or_append_list(self.compressionRun.learningCurve, point)
+
+        elif name == 'earlyStop':
+            self.compressionRun.earlyStopStep = event['step']
+
+        elif name == 'selectedRate':
+            result.bitsPerPixel = event['bitsPerPixel']
+            result.overallPsnr = event['psnr']
+
+        elif name == 'bcQuality':
+            result.combinedBcPsnr = event['psnr']
+            result.combinedBcBitsPerPixel = event['bitsPerPixel']
+
+        elif name == 'cache':
+            result.cacheHit = event['hit']
+
+        elif name == 'warmStart':
+            result.warmStartPsnr = event['psnr']
+            result.warmStartRetained = True
+
+        elif name == 'warmStartLost':
+            # The full training that follows is reported as a separate run
+            result.warmStartRetained = False
+            self._finish_run()
+            self.compressionRun = CompressionRun()
+
+        elif name == 'decompression':
+            result.decompressionTime = event['gpuMilliseconds']
+            if event.get('weightType') == 'FP8':
+                result.overallPsnrFP8 = event.get('overallPsnr', result.overallPsnrFP8)
+            else:
+                result.overallPsnr = event.get('overallPsnr', result.overallPsnr)
+                if 'mipPsnr' in event:
+                    result.perMipPsnr = list(event['mipPsnr'])
+                if 'textures' in event:
+                    result.perTexturePsnr = { texture['name']: texture['psnr'] for texture in event['textures'] }
 
-    if output.returncode != 0:
-        raise RuntimeError(command, output.returncode, output.stdout, output.stderr)
-    
-    result = Result(
-        elapsedTime=taskEndTime - taskStartTime,
-        bitsPerPixel=args.bitsPerPixel # if the tool doesn't give us selected BPP, inherit it from the arguments
-    )
+        elif name == 'fileSaved':
+            result.savedFileSize = event['bytes']
+            result.savedFileBpp = event['bitsPerPixel']
+
+        elif name == 'stage':
+            if result.stageTimes is None: result.stageTimes = {}
+            result.stageTimes[event['stage']] = event['seconds']
 
-    compressionRun = CompressionRun()
+        elif name == 'memory':
+            if 'gpuUsedBytes' in event:
+                result.gpuMemoryUsed = max(result.gpuMemoryUsed or 0, event['gpuUsedBytes'])
+            if 'hostPeakBytes' in event:
+                result.hostMemoryPeak = event['hostPeakBytes']
 
-    for line in output.stdout.splitlines():
-        if m := _baseCompRateRegex.parse(line):
-            result.bitsPerPixel = float(m.bpp)
+        elif name == 'batchJob':
+            result.batchJobs = _create_or_append_list(result.batchJobs, event)
 
-        elif m := _bppRegex.parse(line):
-            result.bitsPerPixel = float(m.bpp)
-            result.overallPsnr = float(m.psnr)
+    def finish(self):
+        self._finish_run()
 
-        elif m := _bcQualityRegex.parse(line):
-            result.combinedBcPsnr = float(m.psnr)
-            result.combinedBcBitsPerPixel = float(m.bpp)
 
-        elif m := _cudaDecompressionTimeRegex.parse(line):
-            result.decompressionTime = float(m.milliseconds)
+def run(args: Arguments, onEvent: Optional[Callable[[dict], Optional[bool]]] = None) -> Result:
+    """
+    Executes the NTC-CLI tool with the provided arguments and returns its interpreted output as a Results object.
+
+    The results are collected from the telemetry events that the tool writes into a temporary file while it runs.
+    If 'onEvent' is provided, it is called with every event as a dict, for example to follow the training progress.
+    When it returns False, the tool is terminated and Cancelled is raised.
+    """
+
+    # The events go into a file of their own: on stdout, they could be interleaved with the regular output,
+    # which the tool writes from several threads and sometimes in partial lines.
+    telemetryFile = tempfile.NamedTemporaryFile(prefix='ntc-telemetry-', suffix='.jsonl', delete=False)
+    telemetryFile.close()
+    command = args.get_command_line() + ['--telemetry', telemetryFile.name]
 
-        elif m := _dimensionsRegex.parse(line):
-            result.dimensions = int(m.width), int(m.height)
-            result.channels = int(m.channels)
-            result.mipLevels = int(m.mipLevels)
+    taskStartTime = time.time()
+    process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, bufsize=1)
 
-        elif m := _experimentRegex.parse(line):
-            if compressionRun.learningCurve:
-                result.compressionRuns = _create_or_append_list(result.compressionRuns, compressionRun)
-            compressionRun = CompressionRun(bitsPerPixel=float(m.bpp))
+    # Read stdout and stderr on other threads so that the tool doesn't block when the pipes are full
+    stdoutLines = []
+    stderrLines = []
+    stdoutThread = threading.Thread(target=lambda: stdoutLines.extend(process.stdout))
+    stderrThread = threading.Thread(target=lambda: stderrLines.extend(process.stderr))
+    stdoutThread.start()
+    stderrThread.start()
 
-        elif m := _fileSizeRegex.parse(line):
-            result.savedFileSize = int(m.bytes)
-            result.savedFileBpp = float(m.bpp)
+    result = Result(
+        bitsPerPixel=args.bitsPerPixel # if the tool doesn't give us selected BPP, inherit it from the arguments
+    )
+    processor = _EventProcessor(result)
+    cancelled = False
 
-        elif m := _graphicsDecompressionTimeRegex.parse(line):
-            result.decompressionTime = float(m.milliseconds)
+    try:
+        # Follow the file until the tool exits and everything it wrote is read. The tool writes and flushes
+        # whole lines, but a read can still end in the middle of one, so keep the partial line for the next read.
+        with open(telemetryFile.name, 'r') as events:
+            partialLine = ''
+            while not cancelled:
+                exited = process.poll() is not None
+                line = events.readline()
+                if not line:
+                    if exited:
+                        break
+                    time.sleep(0.02)
+                    continue
+
+                partialLine += line
+                if not partialLine.endswith('\n'):
+                    continue
+                event = _parse_event(partialLine)
+                partialLine = ''
+                if event is None:
+                    continue
+
+                processor.process(event)
+                if onEvent is not None and onEvent(event) is False:
+                    cancelled = True
+                    process.terminate()
+    except BaseException:
+        process.kill()
+        raise
+    finally:
+        returncode = process.wait()
+        stdoutThread.join()
+        stderrThread.join()
+        os.remove(telemetryFile.name)
 
-        elif m := _latentShapeRegex.parse(line):
-            result.latentShape = LatentShape(gridSizeScale=int(m.gss), highResFeatures=int(m.hrf),
-                lowResFeatures=int(m.lrf), highResQuantBits=int(m.hrqb), lowResQuantBits=int(m.lrqb))
+    taskEndTime = time.time()
 
-        elif m := _mipRegex.parse(line):
-            result.perMipPsnr = _create_or_append_list(result.perMipPsnr, float(m.psnr))
+    if cancelled:
+        raise Cancelled(command)
 
-        elif m := _networkVersionRegex.parse(line):
-            result.networkVersion = m.version
-            
-        elif m := _overallPsnrRegex.parse(line):
-            if m.type == 'FP8':
-                result.overallPsnrFP8 = float(m.psnr)
-            else:
-                result.overallPsnr = float(m.psnr)
-
-        elif m := _stepRegex.parse(line):
-            tuple = int(m.steps), float(m.milliseconds), float(m.psnr)
-            compressionRun.learningCurve = _create_or_append_list(compressionRun.learningCurve, tuple)
-
-        elif m := _systemRegex.parse(line):
-            result.gpuName = m.gpu
-            result.graphicsApi = m.api
-            result.gpuFeatures = []
-            if m.dp4a == 'Y': result.gpuFeatures.append('DP4a')
-            if m.fp16 == 'Y': result.gpuFeatures.append('FP16')
-            if m.coopVecInt8 == 'Y': result.gpuFeatures.append('CoopVecInt8')
-            if m.coopVecFP8 == 'Y': result.gpuFeatures.append('CoopVecFP8')
-        
-    if compressionRun.learningCurve:
-        result.compressionRuns = _create_or_append_list(result.compressionRuns, compressionRun)
+    if returncode != 0:
+        raise RuntimeError(command, returncode, ''.join(stdoutLines), ''.join(stderrLines))
 
+    processor.finish()
+    result.elapsedTime = taskEndTime - taskStartTime
     return result
 
 
-def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callable) -> bool:
+def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callable,
+                             onEvent: Optional[Callable] = None) -> bool:
     """
     Executes the tasks from the list on one or more GPUs concurrently.
     The 0-based indices of CUDA devices are provided in the 'devices' argument.
@@ -346,6 +461,13 @@ def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callab
     The 'task' argument to 'ready' is the original task from the input list,
     which may be Arguments or tuple. The 'ready' function is called from the worker threads,
     but under a mutex, so only one call at a time.
+
+    The optional 'onEvent' function receives the telemetry events of the running tasks:
+
+        def onEvent(task, event: dict, device: int) -> Optional[bool]:
+
+    It is called from the worker threads without a mutex. Returning False cancels the task:
+    the tool is terminated, 'ready' is not called for it, and the worker moves on to the next task.
     """
 
     mutex = threading.Lock()
@@ -380,7 +502,10 @@ def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callab
 
             # Run the task
             try:
-                result = run(args)
+                taskOnEvent = (lambda event: onEvent(task, event, device)) if onEvent is not None else None
+                result = run(args, taskOnEvent)
+            except Cancelled:
+                continue
             except Exception as e:
                 if isinstance(e, RuntimeError):
                     if not terminate:
@@ -0,0 +1,262 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "Benchmark.h"
+#include <donut/core/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace donut;
+using namespace donut::math;
+
+bool CameraPath::Load(std::string const& fileName)
+{
+    std::ifstream file(fileName);
+    if (!file.is_open())
+    {
+        log::error("Cannot open the camera path file '%s'.", fileName.c_str());
+        return false;
+    }
+
+    m_keyframes.clear();
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream stream(line);
+        Keyframe keyframe;
+        stream >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+            >> keyframe.direction.x >> keyframe.direction.y >> keyframe.direction.z
+            >> keyframe.up.x >> keyframe.up.y >> keyframe.up.z;
+
+        if (stream.fail() || length(keyframe.direction) == 0.f || length(keyframe.up) == 0.f)
+        {
+            log::error("Invalid keyframe on line %d of the camera path file '%s'.", lineNumber, fileName.c_str());
+            return false;
+        }
+
+        keyframe.direction = normalize(keyframe.direction);
+        keyframe.up = normalize(keyframe.up);
+        m_keyframes.push_back(keyframe);
+    }
+
+    if (m_keyframes.empty())
+    {
+        log::error("The camera path file '%s' contains no keyframes.", fileName.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool CameraPath::AppendKeyframe(std::string const& fileName, Keyframe const& keyframe)
+{
+    FILE* file = fopen(fileName.c_str(), "a");
+    if (!file)
+    {
+        log::warning("Cannot open the camera path file '%s' for writing.", fileName.c_str());
+        return false;
+    }
+
+    fprintf(file, "%.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f\n",
+        keyframe.position.x, keyframe.position.y, keyframe.position.z,
+        keyframe.direction.x, keyframe.direction.y, keyframe.direction.z,
+        keyframe.up.x, keyframe.up.y, keyframe.up.z);
+
+    fclose(file);
+    return true;
+}
+
+CameraPath::Keyframe CameraPath::Evaluate(float t) const
+{
+    if (m_keyframes.size() < 2)
+        return m_keyframes.empty() ? Keyframe() : m_keyframes[0];
+
+    float const position = std::clamp(t, 0.f, 1.f) * float(m_keyframes.size() - 1);
+    size_t const index = std::min(size_t(position), m_keyframes.size() - 2);
+    float const fraction = position - float(index);
+
+    Keyframe const& a = m_keyframes[index];
+    Keyframe const& b = m_keyframes[index + 1];
+
+    Keyframe result;
+    result.position = lerp(a.position, b.position, fraction);
+    result.direction = normalize(lerp(a.direction, b.direction, fraction));
+    result.up = normalize(lerp(a.up, b.up, fraction));
+    return result;
+}
+
+std::string BenchmarkRun::GetName() const
+{
+    std::string name = ntcMode;
+    if (useSTF)
+        name += " STF-" + stfFilterMode;
+    name += " " + aaMode;
+    return name;
+}
+
+namespace
+{
+    struct TimeStatistics
+    {
+        double mean = 0;
+        double median = 0;
+        double p95 = 0;
+    };
+
+    TimeStatistics GetTimeStatistics(std::vector<BenchmarkFrame> const& frames, double BenchmarkFrame::* field)
+    {
+        TimeStatistics stats;
+        if (frames.empty())
+            return stats;
+
+        std::vector<double> values;
+        values.reserve(frames.size());
+        for (BenchmarkFrame const& frame : frames)
+            values.push_back(frame.*field);
+        std::sort(values.begin(), values.end());
+
+        for (double value : values)
+            stats.mean += value;
+        stats.mean /= double(values.size());
+        stats.median = values[values.size() / 2];
+        stats.p95 = values[std::min(values.size() - 1, size_t(std::ceil(double(values.size()) * 0.95)) - 1)];
+        return stats;
+    }
+
+    std::string EscapeJsonString(std::string const& s)
+    {
+        std::string result;
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result;
+    }
+
+    void WriteJsonStatistics(FILE* file, char const* name, TimeStatistics const& stats)
+    {
+        fprintf(file, "\"%s\": { \"mean\": %.6f, \"median\": %.6f, \"p95\": %.6f }",
+            name, stats.mean * 1e3, stats.median * 1e3, stats.p95 * 1e3);
+    }
+}
+
+static bool WriteBenchmarkResultsCsv(FILE* file, std::vector<BenchmarkRun> const& runs)
+{
+    fprintf(file, "run,ntcMode,useSTF,stfFilterMode,aaMode,frame,frameTimeMs,prePassTimeMs,renderTimeMs,"
+        "transcodingTimeMs,tilesTotal,tilesAllocated,tilesStandby,tilesTranscoded,textureMemoryMB\n");
+
+    for (size_t runIndex = 0; runIndex < runs.size(); ++runIndex)
+    {
+        BenchmarkRun const& run = runs[runIndex];
+        for (size_t frameIndex = 0; frameIndex < run.frames.size(); ++frameIndex)
+        {
+            BenchmarkFrame const& frame = run.frames[frameIndex];
+            fprintf(file, "%zu,%s,%d,%s,%s,%zu,%.4f,%.4f,%.4f,%.4f,%u,%u,%u,%u,%.2f\n",
+                runIndex, run.ntcMode.c_str(), run.useSTF ? 1 : 0, run.stfFilterMode.c_str(), run.aaMode.c_str(),
+                frameIndex, frame.frameTime * 1e3, frame.prePassTime * 1e3, frame.renderTime * 1e3,
+                frame.transcodingTime * 1e3, frame.tilesTotal, frame.tilesAllocated, frame.tilesStandby,
+                frame.tilesTranscoded, double(frame.textureMemorySize) / 1048576.0);
+        }
+    }
+
+    return !ferror(file);
+}
+
+static bool WriteBenchmarkResultsJson(FILE* file, std::string const& sceneName, std::vector<BenchmarkRun> const& runs)
+{
+    // Times are in milliseconds, same as in the CSV output
+    fprintf(file, "{\n  \"scene\": \"%s\",\n  \"runs\": [\n", EscapeJsonString(sceneName).c_str());
+
+    for (size_t runIndex = 0; runIndex < runs.size(); ++runIndex)
+    {
+        BenchmarkRun const& run = runs[runIndex];
+        fprintf(file, "    {\n");
+        fprintf(file, "      \"name\": \"%s\",\n", EscapeJsonString(run.GetName()).c_str());
+        fprintf(file, "      \"ntcMode\": \"%s\",\n", run.ntcMode.c_str());
+        fprintf(file, "      \"useSTF\": %s,\n", run.useSTF ? "true" : "false");
+        fprintf(file, "      \"stfFilterMode\": \"%s\",\n", run.stfFilterMode.c_str());
+        fprintf(file, "      \"aaMode\": \"%s\",\n", run.aaMode.c_str());
+
+        fprintf(file, "      ");
+        WriteJsonStatistics(file, "renderTimeMs", GetTimeStatistics(run.frames, &BenchmarkFrame::renderTime));
+        fprintf(file, ",\n      ");
+        WriteJsonStatistics(file, "prePassTimeMs", GetTimeStatistics(run.frames, &BenchmarkFrame::prePassTime));
+        fprintf(file, ",\n      ");
+        WriteJsonStatistics(file, "transcodingTimeMs", GetTimeStatistics(run.frames, &BenchmarkFrame::transcodingTime));
+        fprintf(file, ",\n");
+
+        fprintf(file, "      \"frames\": [\n");
+        for (size_t frameIndex = 0; frameIndex < run.frames.size(); ++frameIndex)
+        {
+            BenchmarkFrame const& frame = run.frames[frameIndex];
+            fprintf(file, "        { \"frameTimeMs\": %.4f, \"prePassTimeMs\": %.4f, \"renderTimeMs\": %.4f, "
+                "\"transcodingTimeMs\": %.4f, \"tilesTotal\": %u, \"tilesAllocated\": %u, \"tilesStandby\": %u, "
+                "\"tilesTranscoded\": %u, \"textureMemoryMB\": %.2f }%s\n",
+                frame.frameTime * 1e3, frame.prePassTime * 1e3, frame.renderTime * 1e3, frame.transcodingTime * 1e3,
+                frame.tilesTotal, frame.tilesAllocated, frame.tilesStandby, frame.tilesTranscoded,
+                double(frame.textureMemorySize) / 1048576.0, frameIndex + 1 < run.frames.size() ? "," : "");
+        }
+        fprintf(file, "      ]\n");
+        fprintf(file, "    }%s\n", runIndex + 1 < runs.size() ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+    return !ferror(file);
+}
+
+bool WriteBenchmarkResults(std::string const& fileName, std::string const& sceneName,
+    std::vector<BenchmarkRun> const& runs)
+{
+    FILE* file = fopen(fileName.c_str(), "w");
+    if (!file)
+    {
+        log::error("Cannot open the benchmark output file '%s'.", fileName.c_str());
+        return false;
+    }
+
+    std::string extension = std::filesystem::path(fileName).extension().generic_string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    bool const success = (extension == ".json")
+        ? WriteBenchmarkResultsJson(file, sceneName, runs)
+        : WriteBenchmarkResultsCsv(file, runs);
+
+    fclose(file);
+
+    if (!success)
+        log::error("Failed to write the benchmark output file '%s'.", fileName.c_str());
+
+    return success;
+}
+
+void LogBenchmarkSummary(std::vector<BenchmarkRun> const& runs)
+{
+    for (BenchmarkRun const& run : runs)
+    {
+        TimeStatistics const renderTime = GetTimeStatistics(run.frames, &BenchmarkFrame::renderTime);
+        TimeStatistics const transcodingTime = GetTimeStatistics(run.frames, &BenchmarkFrame::transcodingTime);
+        log::info("Benchmark %-32s render %.3f ms (p95 %.3f ms), transcoding %.3f ms", run.GetName().c_str(),
+            renderTime.median * 1e3, renderTime.p95 * 1e3, transcodingTime.median * 1e3);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A camera path for the benchmark mode, stored as a text file with one keyframe per line:
+// position, view direction and up vector, 9 numbers separated by spaces. Lines starting with '#' are ignored.
+// The keyframes are evenly spaced in time, and the camera moves linearly between them.
+class CameraPath
+{
+public:
+    struct Keyframe
+    {
+        donut::math::float3 position = 0.f;
+        donut::math::float3 direction = donut::math::float3(0.f, 0.f, 1.f);
+        donut::math::float3 up = donut::math::float3(0.f, 1.f, 0.f);
+    };
+
+    bool Load(std::string const& fileName);
+
+    // Appends one keyframe to the file, creating it if necessary. Used to record the paths in the UI.
+    static bool AppendKeyframe(std::string const& fileName, Keyframe const& keyframe);
+
+    void AddKeyframe(Keyframe const& keyframe) { m_keyframes.push_back(keyframe); }
+
+    bool IsEmpty() const { return m_keyframes.empty(); }
+
+    // Returns the camera at a point on the path, where 0 is the first keyframe and 1 is the last one.
+    Keyframe Evaluate(float t) const;
+
+private:
+    std::vector<Keyframe> m_keyframes;
+};
+
+struct BenchmarkFrame
+{
+    double frameTime = 0; // All times in seconds
+    double prePassTime = 0;
+    double renderTime = 0;
+    double transcodingTime = 0;
+
+    uint32_t tilesTotal = 0;
+    uint32_t tilesAllocated = 0;
+    uint32_t tilesStandby = 0;
+    uint32_t tilesTranscoded = 0;
+
+    uint64_t textureMemorySize = 0; // Same as "Texture Memory" in the UI
+};
+
+// Frames recorded with one combination of the renderer settings
+struct BenchmarkRun
+{
+    std::string ntcMode;
+    bool useSTF = false;
+    std::string stfFilterMode;
+    std::string aaMode;
+    std::vector<BenchmarkFrame> frames;
+
+    std::string GetName() const;
+};
+
+// Writes all recorded frames into a JSON file when the file name ends with .json, or into a CSV file otherwise.
+// The JSON file also contains the mean, median and 95th percentile of the GPU times for every run.
+bool WriteBenchmarkResults(std::string const& fileName, std::string const& sceneName,
+    std::vector<BenchmarkRun> const& runs);
+
+// Prints the median GPU times of every run to the log.
+void LogBenchmarkSummary(std::vector<BenchmarkRun> const& runs);
@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Scans the decoded MinMip feedback of multiple textures packed into one buffer and builds a list
+// of textures that have any sampled regions, so that the CPU only needs to process those textures.
+// Unsampled regions are decoded as 0xFF.
+
+struct TextureRange
+{
+    uint offset; // in bytes, aligned to 4
+    uint size;   // in bytes
+};
+
+struct Constants
+{
+    uint textureCount;
+};
+
+ConstantBuffer<Constants> g_Const : register(b0);
+
+StructuredBuffer<TextureRange> t_TextureRanges : register(t0);
+ByteAddressBuffer t_FeedbackData : register(t1);
+// [0] is the number of textures with requests, followed by their indices
+RWByteAddressBuffer u_RequestList : register(u0);
+
+[numthreads(64, 1, 1)]
+void main(uint textureIndex : SV_DispatchThreadID)
+{
+    if (textureIndex >= g_Const.textureCount)
+        return;
+
+    TextureRange const range = t_TextureRanges[textureIndex];
+    
+    bool hasRequests = false;
+    for (uint byteOffset = 0; byteOffset < range.size && !hasRequests; byteOffset += 4)
+    {
+        uint data = t_FeedbackData.Load(range.offset + byteOffset);
+
+        // The padding after the last byte of the texture is undefined, treat it as unsampled
+        uint const validBytes = min(range.size - byteOffset, 4);
+        if (validBytes < 4)
+            data |= ~0u << (validBytes * 8);
+
+        hasRequests = data != ~0u;
+    }
+
+    if (hasRequests)
+    {
+        uint listIndex;
+        u_RequestList.InterlockedAdd(0, 1, listIndex);
+        u_RequestList.Store((listIndex + 1) * 4, textureIndex);
+    }
+}
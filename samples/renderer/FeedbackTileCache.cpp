@@ -0,0 +1,269 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "FeedbackTileCache.h"
+#include <ntc-utils/Hash.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+// Tile file layout: TileFileHeader followed by the payload. The key is repeated in the header
+// to tell apart the hash collisions in the file names.
+namespace
+{
+    constexpr char c_TileFileSignature[4] = { 'N', 'T', 'C', 'T' };
+    constexpr uint32_t c_TileFileVersion = 1;
+    constexpr char const* c_TileFileExtension = ".tile";
+    constexpr size_t c_MaxPendingWrites = 1024; // More tiles stored while the writes are behind are not written
+
+    struct TileFileHeader
+    {
+        char signature[4];
+        uint32_t version;
+        uint64_t materialHash;
+        uint32_t mipLevel;
+        uint32_t x;
+        uint32_t y;
+        uint32_t payloadSize;
+    };
+    static_assert(sizeof(TileFileHeader) == 32);
+}
+
+uint64_t FeedbackTileCacheKey::Hash() const
+{
+    // The fields are hashed as 64-bit values, which keeps the names of the tile files from previous runs
+    Fnv1aHash hash;
+    hash.AddValue(materialHash);
+    hash.AddValue(uint64_t(mipLevel));
+    hash.AddValue((uint64_t(y) << 32) | x);
+    return hash.Get();
+}
+
+FeedbackTileCache::~FeedbackTileCache()
+{
+    {
+        std::lock_guard lockGuard(m_diskMutex);
+        m_stopWriter = true;
+    }
+    m_writeCondition.notify_all();
+
+    if (m_writerThread.joinable())
+        m_writerThread.join();
+}
+
+bool FeedbackTileCache::SetDiskDirectory(fs::path const& directory)
+{
+    // The directory of the writer thread doesn't change
+    if (m_writerThread.joinable())
+        return false;
+
+    std::error_code error;
+    fs::create_directories(directory, error);
+    if (error)
+        return false;
+
+    m_diskDirectory = directory;
+
+    std::lock_guard lockGuard(m_diskMutex);
+    m_diskTiles.clear();
+
+    for (fs::directory_entry const& entry : fs::directory_iterator(directory, error))
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != c_TileFileExtension)
+            continue;
+
+        std::string const stem = entry.path().stem().string();
+        char* end = nullptr;
+        uint64_t const keyHash = strtoull(stem.c_str(), &end, 16);
+        if (stem.size() == 16 && end == stem.c_str() + stem.size())
+            m_diskTiles.insert(keyHash);
+    }
+    m_stats.tilesOnDisk = uint32_t(m_diskTiles.size());
+
+    if (error)
+        return false;
+
+    m_writerThread = std::thread(&FeedbackTileCache::WriterThreadProc, this);
+    return true;
+}
+
+fs::path FeedbackTileCache::GetTilePath(uint64_t keyHash) const
+{
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx%s", (unsigned long long)keyHash, c_TileFileExtension);
+    return m_diskDirectory / fileName;
+}
+
+bool FeedbackTileCache::ReadTileFile(FeedbackTileCacheKey const& key, std::vector<uint8_t>& outPayload) const
+{
+    FILE* file = fopen(GetTilePath(key.Hash()).string().c_str(), "rb");
+    if (!file)
+        return false;
+
+    TileFileHeader header;
+    bool success = fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.signature, c_TileFileSignature, sizeof(c_TileFileSignature)) == 0 &&
+        header.version == c_TileFileVersion &&
+        header.materialHash == key.materialHash &&
+        header.mipLevel == key.mipLevel &&
+        header.x == key.x &&
+        header.y == key.y;
+
+    if (success)
+    {
+        outPayload.resize(header.payloadSize);
+        success = header.payloadSize != 0 && fread(outPayload.data(), header.payloadSize, 1, file) == 1;
+    }
+
+    fclose(file);
+    return success;
+}
+
+bool FeedbackTileCache::WriteTileFile(FeedbackTileCacheKey const& key, std::vector<uint8_t> const& payload) const
+{
+    fs::path const path = GetTilePath(key.Hash());
+    FILE* file = fopen(path.string().c_str(), "wb");
+    if (!file)
+        return false;
+
+    TileFileHeader header{};
+    memcpy(header.signature, c_TileFileSignature, sizeof(header.signature));
+    header.version = c_TileFileVersion;
+    header.materialHash = key.materialHash;
+    header.mipLevel = key.mipLevel;
+    header.x = key.x;
+    header.y = key.y;
+    header.payloadSize = uint32_t(payload.size());
+
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(payload.data(), payload.size(), 1, file) == 1;
+    success = (fclose(file) == 0) && success;
+
+    // Don't leave truncated files behind, they would be read and rejected on every lookup
+    if (!success)
+    {
+        std::error_code error;
+        fs::remove(path, error);
+    }
+    return success;
+}
+
+void FeedbackTileCache::WriterThreadProc()
+{
+    std::unique_lock lock(m_diskMutex);
+    while (true)
+    {
+        m_writeCondition.wait(lock, [this]() { return m_stopWriter || !m_pendingWrites.empty(); });
+        if (m_pendingWrites.empty())
+            return;
+
+        Entry entry = std::move(m_pendingWrites.front());
+        m_pendingWrites.pop_front();
+
+        // A file that is being rewritten is not listed, so that Find(...) doesn't read it at the same time
+        uint64_t const keyHash = entry.key.Hash();
+        m_diskTiles.erase(keyHash);
+        lock.unlock();
+
+        bool const written = WriteTileFile(entry.key, entry.payload);
+
+        lock.lock();
+        if (written)
+            m_diskTiles.insert(keyHash);
+        m_stats.tilesOnDisk = uint32_t(m_diskTiles.size());
+    }
+}
+
+void FeedbackTileCache::Insert(FeedbackTileCacheKey const& key, std::vector<uint8_t>&& payload)
+{
+    auto found = m_entriesByKey.find(key);
+    if (found != m_entriesByKey.end())
+    {
+        m_stats.memoryBytes -= found->second->payload.size();
+        m_entries.erase(found->second);
+        m_entriesByKey.erase(found);
+    }
+
+    m_stats.memoryBytes += payload.size();
+    m_entries.push_front({ key, std::move(payload) });
+    m_entriesByKey[key] = m_entries.begin();
+
+    // Keep at least the new entry, even if it's larger than the budget
+    while (m_stats.memoryBytes > m_memoryBudget && m_entries.size() > 1)
+    {
+        Entry const& oldest = m_entries.back();
+        m_stats.memoryBytes -= oldest.payload.size();
+        m_entriesByKey.erase(oldest.key);
+        m_entries.pop_back();
+    }
+
+    m_stats.tilesInMemory = uint32_t(m_entries.size());
+}
+
+std::vector<uint8_t> const* FeedbackTileCache::Find(FeedbackTileCacheKey const& key)
+{
+    auto found = m_entriesByKey.find(key);
+    if (found != m_entriesByKey.end())
+    {
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        ++m_stats.memoryHits;
+        return &m_entries.front().payload;
+    }
+
+    if (!m_diskDirectory.empty())
+    {
+        // The lock also keeps the writer thread from replacing the file while it's read
+        std::lock_guard lockGuard(m_diskMutex);
+        uint64_t const keyHash = key.Hash();
+        if (m_diskTiles.find(keyHash) != m_diskTiles.end())
+        {
+            std::vector<uint8_t> payload;
+            if (ReadTileFile(key, payload))
+            {
+                Insert(key, std::move(payload));
+                ++m_stats.diskHits;
+                return &m_entries.front().payload;
+            }
+
+            // Hash collision or a file from a different version, it will be overwritten when this tile is stored
+            m_diskTiles.erase(keyHash);
+            m_stats.tilesOnDisk = uint32_t(m_diskTiles.size());
+        }
+    }
+
+    ++m_stats.misses;
+    return nullptr;
+}
+
+void FeedbackTileCache::Store(FeedbackTileCacheKey const& key, std::vector<uint8_t>&& payload)
+{
+    if (m_writerThread.joinable())
+    {
+        std::lock_guard lockGuard(m_diskMutex);
+        if (m_pendingWrites.size() < c_MaxPendingWrites)
+        {
+            m_pendingWrites.push_back({ key, payload });
+            m_writeCondition.notify_one();
+        }
+    }
+
+    Insert(key, std::move(payload));
+    ++m_stats.tilesStored;
+}
+
+FeedbackTileCacheStats FeedbackTileCache::GetStats()
+{
+    std::lock_guard lockGuard(m_diskMutex);
+    return m_stats;
+}
@@ -0,0 +1,115 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Identifies one transcoded feedback tile. The material hash covers everything that affects the transcoded
+// data, so that entries written to disk by a previous run can be recognized.
+struct FeedbackTileCacheKey
+{
+    uint64_t materialHash = 0;
+    uint32_t mipLevel = 0;
+    uint32_t x = 0; // Tile position in texels
+    uint32_t y = 0;
+
+    bool operator==(FeedbackTileCacheKey const& other) const
+    {
+        return materialHash == other.materialHash && mipLevel == other.mipLevel && x == other.x && y == other.y;
+    }
+
+    uint64_t Hash() const;
+};
+
+struct FeedbackTileCacheStats
+{
+    uint64_t memoryHits = 0;   // Lookups found in host memory
+    uint64_t diskHits = 0;     // Lookups found in the disk cache and loaded into host memory
+    uint64_t misses = 0;
+    uint64_t tilesStored = 0;  // Tiles added to the cache since it was created
+    uint32_t tilesInMemory = 0;
+    uint32_t tilesOnDisk = 0;
+    uint64_t memoryBytes = 0;  // Size of the payloads kept in host memory
+};
+
+// Second-level cache of the block-compressed payloads of feedback tiles, so that tiles evicted from
+// the tile heaps and requested again can be restored with a copy instead of running inference.
+// Keeps the most recently used payloads in host memory up to a byte budget and, optionally, writes every
+// stored payload into a directory that later runs can read. The files are written on a separate thread,
+// the other methods must be called from one thread at a time.
+class FeedbackTileCache
+{
+public:
+    explicit FeedbackTileCache(uint64_t memoryBudget)
+        : m_memoryBudget(memoryBudget)
+    { }
+
+    // Writes the queued tile files before returning
+    ~FeedbackTileCache();
+
+    // Enables the disk cache. Lists the tiles already present in the directory, creating it if necessary.
+    // Returns false if the directory cannot be created or listed.
+    bool SetDiskDirectory(std::filesystem::path const& directory);
+
+    // Returns the payload of the tile, loading it from disk if necessary, or nullptr if the tile is not cached.
+    // The pointer is valid until the next Store(...) call.
+    std::vector<uint8_t> const* Find(FeedbackTileCacheKey const& key);
+
+    // Adds or replaces the payload of a tile and evicts the least recently used tiles to fit the budget.
+    // With the disk cache, queues a copy of the payload for writing. Tiles that are evicted before their file
+    // is written are not found on disk until then.
+    void Store(FeedbackTileCacheKey const& key, std::vector<uint8_t>&& payload);
+
+    FeedbackTileCacheStats GetStats();
+
+private:
+    struct Entry
+    {
+        FeedbackTileCacheKey key;
+        std::vector<uint8_t> payload;
+    };
+
+    struct KeyHasher
+    {
+        size_t operator()(FeedbackTileCacheKey const& key) const { return size_t(key.Hash()); }
+    };
+
+    uint64_t m_memoryBudget;
+    std::list<Entry> m_entries; // Most recently used first
+    std::unordered_map<FeedbackTileCacheKey, std::list<Entry>::iterator, KeyHasher> m_entriesByKey;
+    std::filesystem::path m_diskDirectory;
+    FeedbackTileCacheStats m_stats;
+
+    // Disk cache state shared with the writer thread, m_stats.tilesOnDisk is also protected by m_diskMutex
+    std::mutex m_diskMutex;
+    std::condition_variable m_writeCondition;
+    std::unordered_set<uint64_t> m_diskTiles; // Key hashes of the tile files in m_diskDirectory
+    std::deque<Entry> m_pendingWrites;
+    bool m_stopWriter = false;
+    std::thread m_writerThread;
+
+    std::filesystem::path GetTilePath(uint64_t keyHash) const;
+    bool ReadTileFile(FeedbackTileCacheKey const& key, std::vector<uint8_t>& outPayload) const;
+    bool WriteTileFile(FeedbackTileCacheKey const& key, std::vector<uint8_t> const& payload) const;
+    void WriterThreadProc();
+    void Insert(FeedbackTileCacheKey const& key, std::vector<uint8_t>&& payload);
+};
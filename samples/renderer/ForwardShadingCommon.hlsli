@@ -111,6 +111,7 @@ void EvaluateForwardShading(
         + specularTerm
         + surfaceMaterial.emissiveColor;
 
+#if !COMPUTE_SHADING // No derivatives in compute shaders, and the deferred pass only shades opaque materials
     if (materialConstants.domain == MaterialDomain_AlphaTested)
     {
         // Fix the fuzzy edges on alpha tested geometry.
@@ -120,6 +121,7 @@ void EvaluateForwardShading(
             / max(fwidth(surfaceMaterial.opacity) * 1.4142, 0.0001) + 0.5);
     }
     else
+#endif
         o_color.a = surfaceMaterial.opacity;
 
 #endif // TRANSMISSIVE_MATERIAL
@@ -0,0 +1,161 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "GpuDecompressionQueue.h"
+#include <donut/core/log.h>
+
+using namespace donut;
+
+#if NTC_WITH_DX12 && NTC_WITH_DIRECTSTORAGE
+
+// The queue is submitted early when it's half full, so that EnqueueRequest never waits for free entries
+static const uint32_t g_queueCapacity = DSTORAGE_MAX_QUEUE_CAPACITY;
+
+std::unique_ptr<GpuDecompressionQueue> GpuDecompressionQueue::Create(nvrhi::IDevice* device)
+{
+    if (device->getGraphicsAPI() != nvrhi::GraphicsAPI::D3D12)
+        return nullptr;
+
+    ID3D12Device* d3dDevice = device->getNativeObject(nvrhi::ObjectTypes::D3D12_Device);
+
+    std::unique_ptr<GpuDecompressionQueue> queue(new GpuDecompressionQueue());
+    HRESULT hr = DStorageGetFactory(IID_PPV_ARGS(&queue->m_factory));
+    if (FAILED(hr))
+    {
+        log::warning("DStorageGetFactory failed, HRESULT = 0x%08x", uint32_t(hr));
+        return nullptr;
+    }
+
+    DSTORAGE_QUEUE_DESC queueDesc{};
+    queueDesc.Capacity = uint16_t(g_queueCapacity);
+    queueDesc.Priority = DSTORAGE_PRIORITY_NORMAL;
+    queueDesc.SourceType = DSTORAGE_REQUEST_SOURCE_MEMORY;
+    queueDesc.Device = d3dDevice;
+    queueDesc.Name = "NTC latents";
+    hr = queue->m_factory->CreateQueue(&queueDesc, IID_PPV_ARGS(&queue->m_queue));
+    if (FAILED(hr))
+    {
+        log::warning("Cannot create the DirectStorage queue, HRESULT = 0x%08x", uint32_t(hr));
+        return nullptr;
+    }
+
+    hr = d3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&queue->m_fence));
+    if (FAILED(hr))
+        return nullptr;
+
+    // Older runtimes without IDStorageQueue2 don't say where GDeflate runs, assume the CPU fallback
+    Microsoft::WRL::ComPtr<IDStorageQueue2> queue2;
+    if (SUCCEEDED(queue->m_queue.As(&queue2)))
+    {
+        DSTORAGE_COMPRESSION_SUPPORT const support = queue2->GetCompressionSupport(DSTORAGE_COMPRESSION_FORMAT_GDEFLATE);
+        queue->m_gpuDecompression = (support & (DSTORAGE_COMPRESSION_SUPPORT_GPU_OPTIMIZED |
+            DSTORAGE_COMPRESSION_SUPPORT_GPU_FALLBACK)) != 0;
+    }
+
+    return queue;
+}
+
+void GpuDecompressionQueue::EnqueuePage(CompressedFileStream::PageInfo const& page, nvrhi::IBuffer* buffer,
+    uint64_t bufferOffset)
+{
+    if (m_queuedRequests >= g_queueCapacity / 2)
+    {
+        m_queue->Submit();
+        m_queuedRequests = 0;
+    }
+
+    DSTORAGE_REQUEST request{};
+    request.Options.SourceType = DSTORAGE_REQUEST_SOURCE_MEMORY;
+    request.Options.DestinationType = DSTORAGE_REQUEST_DESTINATION_BUFFER;
+    request.Options.CompressionFormat = page.isGDeflate
+        ? DSTORAGE_COMPRESSION_FORMAT_GDEFLATE
+        : DSTORAGE_COMPRESSION_FORMAT_NONE;
+    request.Source.Memory.Source = page.storedData;
+    request.Source.Memory.Size = page.storedSize;
+    request.Destination.Buffer.Resource = buffer->getNativeObject(nvrhi::ObjectTypes::D3D12_Resource);
+    request.Destination.Buffer.Offset = bufferOffset;
+    request.Destination.Buffer.Size = page.uncompressedSize;
+    request.UncompressedSize = page.uncompressedSize;
+    m_queue->EnqueueRequest(&request);
+    ++m_queuedRequests;
+}
+
+uint64_t GpuDecompressionQueue::Submit()
+{
+    ++m_fenceValue;
+    m_queue->EnqueueSignal(m_fence.Get(), m_fenceValue);
+    m_queue->Submit();
+    m_queuedRequests = 0;
+    return m_fenceValue;
+}
+
+bool GpuDecompressionQueue::IsCompleted(uint64_t fenceValue) const
+{
+    return m_fence->GetCompletedValue() >= fenceValue;
+}
+
+void GpuDecompressionQueue::Wait(uint64_t fenceValue) const
+{
+    // A null event makes the call block until the fence reaches the value
+    if (!IsCompleted(fenceValue))
+        m_fence->SetEventOnCompletion(fenceValue, nullptr);
+}
+
+uint32_t GpuDecompressionQueue::GetNewFailureCount()
+{
+    DSTORAGE_ERROR_RECORD errorRecord{};
+    m_queue->RetrieveErrorRecord(&errorRecord);
+    uint32_t const newFailures = errorRecord.FailureCount - m_reportedFailures;
+    m_reportedFailures = errorRecord.FailureCount;
+    return newFailures;
+}
+
+GpuDecompressionQueue::~GpuDecompressionQueue()
+{
+    // The requests read from file mappings that are closed after this
+    if (m_fence && m_fenceValue != 0)
+        Wait(m_fenceValue);
+}
+
+#else
+
+std::unique_ptr<GpuDecompressionQueue> GpuDecompressionQueue::Create(nvrhi::IDevice* device)
+{
+    return nullptr;
+}
+
+void GpuDecompressionQueue::EnqueuePage(CompressedFileStream::PageInfo const& page, nvrhi::IBuffer* buffer,
+    uint64_t bufferOffset)
+{ }
+
+uint64_t GpuDecompressionQueue::Submit()
+{
+    return 0;
+}
+
+bool GpuDecompressionQueue::IsCompleted(uint64_t fenceValue) const
+{
+    return true;
+}
+
+void GpuDecompressionQueue::Wait(uint64_t fenceValue) const
+{ }
+
+uint32_t GpuDecompressionQueue::GetNewFailureCount()
+{
+    return 0;
+}
+
+GpuDecompressionQueue::~GpuDecompressionQueue()
+{ }
+
+#endif
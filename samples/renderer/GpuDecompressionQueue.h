@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <ntc-utils/CompressedFileStream.h>
+#include <nvrhi/nvrhi.h>
+#include <memory>
+
+#if NTC_WITH_DX12 && NTC_WITH_DIRECTSTORAGE
+#include <d3d12.h>
+#include <dstorage.h>
+#include <wrl/client.h>
+#endif
+
+// Decompresses the GDeflate pages of compressed NTC files straight into GPU buffers with DirectStorage.
+// Only available on DX12 in builds with NTC_WITH_DIRECTSTORAGE, Create(...) returns nullptr otherwise,
+// and the pages are decompressed on the CPU by CompressedFileStream instead.
+// The requests read from the file mapping of the stream, which must stay alive until they are completed.
+// The destination buffers must not be used by any command list until then.
+class GpuDecompressionQueue
+{
+public:
+    static std::unique_ptr<GpuDecompressionQueue> Create(nvrhi::IDevice* device);
+
+    // False when DirectStorage runs GDeflate on its CPU fallback, such as on GPUs without the required features
+    bool IsGpuDecompression() const { return m_gpuDecompression; }
+
+    // Queues the decompression of one stored or GDeflate page into 'buffer'
+    void EnqueuePage(CompressedFileStream::PageInfo const& page, nvrhi::IBuffer* buffer, uint64_t bufferOffset);
+
+    // Submits the queued requests and returns the fence value that is signaled when they are completed
+    uint64_t Submit();
+
+    bool IsCompleted(uint64_t fenceValue) const;
+    void Wait(uint64_t fenceValue) const;
+
+    // Returns the number of requests that failed since the last call
+    uint32_t GetNewFailureCount();
+
+    ~GpuDecompressionQueue();
+
+private:
+    GpuDecompressionQueue() = default;
+
+    bool m_gpuDecompression = false;
+    uint64_t m_fenceValue = 0;
+    uint32_t m_queuedRequests = 0;
+    uint32_t m_reportedFailures = 0;
+
+#if NTC_WITH_DX12 && NTC_WITH_DIRECTSTORAGE
+    Microsoft::WRL::ComPtr<IDStorageFactory> m_factory;
+    Microsoft::WRL::ComPtr<IDStorageQueue> m_queue;
+    Microsoft::WRL::ComPtr<ID3D12Fence> m_fence;
+#endif
+};
@@ -0,0 +1,138 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "LatentBufferPool.h"
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <cassert>
+
+int LatentBufferPool::CreateBlock(uint64_t size)
+{
+    nvrhi::BufferDesc bufferDesc = nvrhi::BufferDesc()
+        .setByteSize(size)
+        .setCanHaveRawViews(true)
+        .setInitialState(nvrhi::ResourceStates::ShaderResource)
+        .setKeepInitialState(true)
+        .setDebugName("Latent pool");
+    nvrhi::BufferHandle buffer = m_device->createBuffer(bufferDesc);
+    if (!buffer)
+        return -1;
+
+    if (m_memoryTracker)
+        m_memoryTracker->TrackBuffer(buffer, MemoryCategory::NtcLatents, "Latent pool");
+
+    // Reuse the slot of a released block, so that the block indices stay small
+    auto slot = std::find_if(m_blocks.begin(), m_blocks.end(), [](Block const& block) { return !block.buffer; });
+    if (slot == m_blocks.end())
+        slot = m_blocks.insert(m_blocks.end(), Block());
+
+    slot->buffer = buffer;
+    slot->size = size;
+    slot->allocatedBytes = 0;
+    slot->freeRanges.clear();
+    slot->freeRanges[0] = size;
+    m_reservedBytes += size;
+
+    return int(slot - m_blocks.begin());
+}
+
+LatentBufferPool::Allocation LatentBufferPool::Allocate(uint64_t size)
+{
+    uint64_t const alignedSize = std::max<uint64_t>((size + m_alignment - 1) / m_alignment * m_alignment, m_alignment);
+
+    // First fit over the existing blocks. The free ranges keep the alignment because all sizes are aligned.
+    int blockIndex = -1;
+    std::map<uint64_t, uint64_t>::iterator freeRange;
+    for (int index = 0; index < int(m_blocks.size()) && blockIndex < 0; ++index)
+    {
+        Block& block = m_blocks[index];
+        if (!block.buffer || block.size - block.allocatedBytes < alignedSize)
+            continue;
+
+        freeRange = std::find_if(block.freeRanges.begin(), block.freeRanges.end(),
+            [alignedSize](auto const& range) { return range.second >= alignedSize; });
+        if (freeRange != block.freeRanges.end())
+            blockIndex = index;
+    }
+
+    if (blockIndex < 0)
+    {
+        blockIndex = CreateBlock(std::max(m_blockSize, alignedSize));
+        if (blockIndex < 0)
+            return Allocation();
+        freeRange = m_blocks[blockIndex].freeRanges.begin();
+    }
+
+    Block& block = m_blocks[blockIndex];
+    uint64_t const offset = freeRange->first;
+    uint64_t const remainingSize = freeRange->second - alignedSize;
+    block.freeRanges.erase(freeRange);
+    if (remainingSize != 0)
+        block.freeRanges[offset + alignedSize] = remainingSize;
+
+    block.allocatedBytes += alignedSize;
+    m_allocatedBytes += alignedSize;
+
+    Allocation allocation;
+    allocation.buffer = block.buffer;
+    allocation.range = nvrhi::BufferRange(offset, alignedSize);
+    allocation.block = blockIndex;
+    return allocation;
+}
+
+void LatentBufferPool::Free(Allocation& allocation)
+{
+    if (!allocation)
+        return;
+
+    assert(allocation.block >= 0 && allocation.block < int(m_blocks.size()));
+    Block& block = m_blocks[allocation.block];
+    assert(block.buffer == allocation.buffer);
+
+    uint64_t offset = allocation.range.byteOffset;
+    uint64_t size = allocation.range.byteSize;
+    block.allocatedBytes -= size;
+    m_allocatedBytes -= size;
+    allocation = Allocation();
+
+    if (block.allocatedBytes == 0)
+    {
+        m_reservedBytes -= block.size;
+        block = Block();
+        return;
+    }
+
+    // Merge with the free ranges on both sides
+    auto next = block.freeRanges.lower_bound(offset);
+    if (next != block.freeRanges.end() && next->first == offset + size)
+    {
+        size += next->second;
+        next = block.freeRanges.erase(next);
+    }
+    if (next != block.freeRanges.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            prev->second += size;
+            return;
+        }
+    }
+    block.freeRanges[offset] = size;
+}
+
+void LatentBufferPool::Clear()
+{
+    m_blocks.clear();
+    m_allocatedBytes = 0;
+    m_reservedBytes = 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <map>
+#include <vector>
+
+class MemoryTracker;
+
+// Sub-allocates material latents from a few large raw buffers, so that the resident mip levels of a material
+// can be replaced without creating and destroying buffers. Allocations can be freed in any order,
+// and adjacent free ranges are merged. Requests larger than the block size get a block of their own.
+// The buffers stay in the shader resource state, writes to them are tracked per command list.
+class LatentBufferPool
+{
+public:
+    struct Allocation
+    {
+        nvrhi::BufferHandle buffer;
+        nvrhi::BufferRange range;
+        int block = -1;
+
+        explicit operator bool() const { return buffer != nullptr; }
+    };
+
+    LatentBufferPool(nvrhi::IDevice* device, uint64_t blockSize, uint64_t alignment)
+        : m_device(device)
+        , m_blockSize(blockSize)
+        , m_alignment(alignment)
+    { }
+
+    // Reports the blocks created after this call to the tracker. The tracker may be null.
+    void SetMemoryTracker(MemoryTracker* memoryTracker) { m_memoryTracker = memoryTracker; }
+
+    // Returns an empty allocation if a new block is needed and cannot be created.
+    Allocation Allocate(uint64_t size);
+
+    // Returns the range to the pool and resets the allocation. The caller makes sure that the GPU
+    // doesn't use the range anymore. Blocks without allocations are released.
+    void Free(Allocation& allocation);
+
+    // Releases all blocks. Outstanding allocations keep their buffers alive but must not be freed.
+    void Clear();
+
+    uint64_t GetAllocatedBytes() const { return m_allocatedBytes; }
+
+    uint64_t GetReservedBytes() const { return m_reservedBytes; }
+
+private:
+    struct Block
+    {
+        nvrhi::BufferHandle buffer;
+        uint64_t size = 0;
+        uint64_t allocatedBytes = 0;
+        std::map<uint64_t, uint64_t> freeRanges; // Offset -> size
+    };
+
+    nvrhi::DeviceHandle m_device;
+    MemoryTracker* m_memoryTracker = nullptr;
+    uint64_t m_blockSize;
+    uint64_t m_alignment;
+    std::vector<Block> m_blocks; // Released blocks keep their slots with a null buffer
+    uint64_t m_allocatedBytes = 0;
+    uint64_t m_reservedBytes = 0;
+
+    int CreateBlock(uint64_t size);
+};
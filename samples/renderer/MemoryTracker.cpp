@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "MemoryTracker.h"
+#include <donut/core/log.h>
+#include <algorithm>
+#include <vector>
+
+using namespace donut;
+
+static constexpr double c_BytesToMB = 1.0 / 1048576.0;
+
+char const* MemoryCategoryToString(MemoryCategory category)
+{
+    switch (category)
+    {
+    case MemoryCategory::NtcLatents:         return "NTC Latents";
+    case MemoryCategory::NtcWeights:         return "NTC Weights";
+    case MemoryCategory::NtcConstants:       return "NTC Constants";
+    case MemoryCategory::TranscodedTextures: return "Transcoded Textures";
+    case MemoryCategory::TranscodeStaging:   return "Transcode Staging";
+    case MemoryCategory::UploadBuffers:      return "Upload Buffers";
+    case MemoryCategory::FeedbackTileHeaps:  return "Feedback Tile Heaps";
+    case MemoryCategory::FeedbackBuffers:    return "Feedback Buffers";
+    case MemoryCategory::ReferenceTextures:  return "Reference Textures";
+    case MemoryCategory::RenderTargets:      return "Render Targets";
+    case MemoryCategory::PassBuffers:        return "Pass Buffers";
+    default:                                 return "Unknown";
+    }
+}
+
+void MemoryTracker::Track(nvrhi::IResource* resource, MemoryCategory category, std::string const& owner,
+    std::string const& name, uint64_t bytes)
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    Allocation& allocation = m_resources[resource];
+    allocation.resource = resource;
+    allocation.category = category;
+    allocation.owner = owner;
+    allocation.name = name;
+    allocation.bytes = bytes;
+}
+
+void MemoryTracker::TrackBuffer(nvrhi::IBuffer* buffer, MemoryCategory category, std::string const& owner)
+{
+    if (!buffer)
+        return;
+
+    // Virtual buffers have no memory of their own
+    uint64_t const bytes = buffer->getDesc().isVirtual ? 0 : m_device->getBufferMemoryRequirements(buffer).size;
+    Track(buffer, category, owner, buffer->getDesc().debugName, bytes);
+}
+
+void MemoryTracker::TrackTexture(nvrhi::ITexture* texture, MemoryCategory category, std::string const& owner)
+{
+    if (!texture)
+        return;
+
+    // Tiled and virtual textures have no memory of their own, their tiles are in the heaps
+    nvrhi::TextureDesc const& desc = texture->getDesc();
+    uint64_t const bytes = (desc.isTiled || desc.isVirtual) ? 0 : m_device->getTextureMemoryRequirements(texture).size;
+    Track(texture, category, owner, desc.debugName, bytes);
+}
+
+void MemoryTracker::SetExternalAllocation(MemoryCategory category, std::string const& owner, uint64_t bytes)
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    auto key = std::make_pair(category, owner);
+    if (bytes == 0)
+        m_externalAllocations.erase(key);
+    else
+        m_externalAllocations[key] = bytes;
+}
+
+void MemoryTracker::Update()
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    for (auto it = m_resources.begin(); it != m_resources.end(); )
+    {
+        // Release() returns the remaining reference count, which is 1 when only the tracker holds the resource
+        nvrhi::IResource* resource = it->first;
+        resource->AddRef();
+        if (resource->Release() <= 1)
+            it = m_resources.erase(it);
+        else
+            ++it;
+    }
+}
+
+MemoryStats MemoryTracker::GetStats() const
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    MemoryStats stats;
+    auto add = [&stats](MemoryCategory category, uint64_t bytes)
+    {
+        MemoryCategoryStats& categoryStats = stats.categories[size_t(category)];
+        categoryStats.bytes += bytes;
+        ++categoryStats.resources;
+        stats.totalBytes += bytes;
+    };
+
+    for (auto const& [resource, allocation] : m_resources)
+        add(allocation.category, allocation.bytes);
+
+    for (auto const& [key, bytes] : m_externalAllocations)
+        add(key.first, bytes);
+
+    return stats;
+}
+
+void MemoryTracker::Dump() const
+{
+    MemoryStats const stats = GetStats();
+
+    std::lock_guard lockGuard(m_mutex);
+
+    std::vector<Allocation> allocations;
+    allocations.reserve(m_resources.size() + m_externalAllocations.size());
+    std::map<std::string, uint64_t> ownerBytes;
+    for (auto const& [resource, allocation] : m_resources)
+    {
+        allocations.push_back(allocation);
+        ownerBytes[allocation.owner] += allocation.bytes;
+    }
+    for (auto const& [key, bytes] : m_externalAllocations)
+    {
+        Allocation& allocation = allocations.emplace_back();
+        allocation.category = key.first;
+        allocation.owner = key.second;
+        allocation.name = "(external)";
+        allocation.bytes = bytes;
+        ownerBytes[allocation.owner] += bytes;
+    }
+
+    std::sort(allocations.begin(), allocations.end(), [](Allocation const& a, Allocation const& b)
+    {
+        if (a.category != b.category)
+            return a.category < b.category;
+        return a.bytes > b.bytes;
+    });
+
+    log::info("GPU memory: %.2f MB in %d allocations", double(stats.totalBytes) * c_BytesToMB, int(allocations.size()));
+    for (size_t index = 0; index < stats.categories.size(); ++index)
+    {
+        MemoryCategoryStats const& categoryStats = stats.categories[index];
+        if (categoryStats.resources == 0)
+            continue;
+        log::info("  %-20s %10.2f MB in %u allocations", MemoryCategoryToString(MemoryCategory(index)),
+            double(categoryStats.bytes) * c_BytesToMB, categoryStats.resources);
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> owners(ownerBytes.begin(), ownerBytes.end());
+    std::sort(owners.begin(), owners.end(), [](auto const& a, auto const& b) { return a.second > b.second; });
+    size_t const maxOwners = 20;
+    log::info("Largest owners:");
+    for (size_t index = 0; index < std::min(owners.size(), maxOwners); ++index)
+        log::info("  %-40s %10.2f MB", owners[index].first.c_str(), double(owners[index].second) * c_BytesToMB);
+
+    log::info("All allocations:");
+    for (Allocation const& allocation : allocations)
+    {
+        log::info("  %-20s %-40s %-40s %10.3f MB", MemoryCategoryToString(allocation.category),
+            allocation.owner.c_str(), allocation.name.c_str(), double(allocation.bytes) * c_BytesToMB);
+    }
+}
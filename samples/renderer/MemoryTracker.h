@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+enum class MemoryCategory
+{
+    NtcLatents,
+    NtcWeights,
+    NtcConstants,
+    TranscodedTextures,
+    TranscodeStaging,
+    UploadBuffers,
+    FeedbackTileHeaps,
+    FeedbackBuffers,
+    ReferenceTextures,
+    RenderTargets,
+    PassBuffers,
+
+    Count
+};
+
+char const* MemoryCategoryToString(MemoryCategory category);
+
+struct MemoryCategoryStats
+{
+    uint64_t bytes = 0;
+    uint32_t resources = 0;
+};
+
+struct MemoryStats
+{
+    std::array<MemoryCategoryStats, size_t(MemoryCategory::Count)> categories;
+    uint64_t totalBytes = 0;
+};
+
+// The MemoryTracker class keeps a list of the GPU resources created by the renderer, the material loader and
+// the passes, tagged with a category and an owner, such as the material name. The tracker holds a reference to
+// every resource and forgets it in Update() once nothing else references it, so the totals follow the resources
+// that are actually alive, at most one frame late. Memory that is not allocated through tracked resources,
+// such as the feedback tile heaps, is reported with SetExternalAllocation().
+class MemoryTracker
+{
+public:
+    MemoryTracker(nvrhi::IDevice* device)
+        : m_device(device)
+    { }
+
+    // Null resources are ignored, so the result of createBuffer/createTexture can be passed directly.
+    void TrackBuffer(nvrhi::IBuffer* buffer, MemoryCategory category, std::string const& owner);
+    void TrackTexture(nvrhi::ITexture* texture, MemoryCategory category, std::string const& owner);
+
+    // Sets the size of an allocation that is not a tracked resource, replacing the previous value for the same
+    // category and owner. A size of 0 removes the allocation.
+    void SetExternalAllocation(MemoryCategory category, std::string const& owner, uint64_t bytes);
+
+    // Forgets the resources that are only referenced by the tracker. Call once per frame.
+    void Update();
+
+    MemoryStats GetStats() const;
+
+    // Prints the per-category totals, the largest owners and all tracked resources into the log.
+    void Dump() const;
+
+private:
+    struct Allocation
+    {
+        nvrhi::ResourceHandle resource; // Null for external allocations
+        MemoryCategory category = MemoryCategory::Count;
+        std::string owner;
+        std::string name;
+        uint64_t bytes = 0;
+    };
+
+    nvrhi::DeviceHandle m_device;
+    mutable std::mutex m_mutex;
+    std::unordered_map<nvrhi::IResource*, Allocation> m_resources;
+    std::map<std::pair<MemoryCategory, std::string>, uint64_t> m_externalAllocations;
+
+    void Track(nvrhi::IResource* resource, MemoryCategory category, std::string const& owner,
+        std::string const& name, uint64_t bytes);
+};
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Depth pre-pass shader for alpha tested Inference on Sample materials. It decompresses only the opacity
+// from the NTC texture set and discards the transparent pixels, so these materials don't need a transcoded
+// opacity texture for the pre-pass. There are no color outputs.
+
+#include "ForwardShadingCommon.hlsli"
+
+#include "libntc/shaders/InferenceConstants.h"
+#include "libntc/shaders/Inference.hlsli"
+typedef NtcNetworkParams<NETWORK_VERSION> NtcParams;
+
+#define STF_SHADER_STAGE STF_SHADER_STAGE_PIXEL
+#define STF_SHADER_MODEL_MAJOR 6
+#define STF_SHADER_MODEL_MINOR 5
+#include "STFSamplerState.hlsli"
+#include "NtcForwardShadingPassConstants.h"
+#include "NtcChannelMapping.h"
+
+DECLARE_CBUFFER(NtcForwardShadingPassConstants, g_Pass, FORWARD_BINDING_NTC_PASS_CONSTANTS, FORWARD_SPACE_SHADING);
+RWByteAddressBuffer u_MipRequests : REGISTER_UAV(FORWARD_BINDING_MIP_REQUESTS_UAV, FORWARD_SPACE_SHADING);
+
+#if BINDLESS_MATERIALS
+DECLARE_PUSH_CONSTANTS(NtcForwardPushConstants, g_NtcPush, FORWARD_BINDING_PUSH_CONSTANTS, FORWARD_SPACE_INPUT);
+#define NTC_BINDLESS_MATERIAL_INDEX g_NtcPush.materialIndex
+#endif
+
+#include "NtcMaterialSampling.hlsli"
+
+void main(
+    in float4 i_position : SV_Position,
+    in SceneVertex i_vtx
+)
+{
+    float const opacity = g_Material.opacity * SampleNtcMaterialOpacity(int2(i_position.xy), i_vtx.texCoord);
+    clip(opacity - g_Material.alphaCutoff);
+}
@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+
+// Groups the pixels of the thin G-buffer by material, so that the deferred shading pass can process
+// every material with its own pipeline and coherent waves. Runs in three dispatches, see BINNING_PASS.
+// With the material cache, the scatter pass also separates the pixels that need inference from the pixels
+// that reuse the cached textures, so that most waves of the shading pass take only one of the paths.
+
+#include "donut/shaders/binding_helpers.hlsli"
+#include "NtcThinGBuffer.hlsli"
+
+DECLARE_CBUFFER(NtcDeferredShadingConstants, g_Const, DEFERRED_BINDING_CONSTANTS, DEFERRED_SPACE_PASS);
+Texture2D<uint4> t_GBuffer1 : REGISTER_SRV(DEFERRED_BINDING_GBUFFER1, DEFERRED_SPACE_PASS);
+Texture2D<float> t_Depth : REGISTER_SRV(DEFERRED_BINDING_DEPTH, DEFERRED_SPACE_PASS);
+Texture2D<uint2> t_MaterialCacheHistoryKeys : REGISTER_SRV(DEFERRED_BINDING_MATERIAL_CACHE_HISTORY_KEYS, DEFERRED_SPACE_PASS);
+RWByteAddressBuffer u_MaterialBins : REGISTER_UAV(DEFERRED_BINDING_MATERIAL_BINS, DEFERRED_SPACE_PASS);
+RWByteAddressBuffer u_PixelList : REGISTER_UAV(DEFERRED_BINDING_PIXEL_LIST, DEFERRED_SPACE_PASS);
+RWByteAddressBuffer u_IndirectArgs : REGISTER_UAV(DEFERRED_BINDING_INDIRECT_ARGS, DEFERRED_SPACE_PASS);
+
+#define BIN_SIZE 16
+#define BIN_PIXEL_COUNT 0
+#define BIN_FIRST_PIXEL 4
+#define BIN_INFERENCE_CURSOR 8
+#define BIN_REUSE_CURSOR 12
+
+#include "NtcMaterialCache.hlsli"
+
+#if BINNING_PASS == DEFERRED_BINNING_SCAN
+
+groupshared uint s_ChunkSums[DEFERRED_SCAN_GROUP_SIZE];
+
+// Computes the bin offsets with an exclusive prefix sum over the pixel counts. Every thread processes
+// a contiguous chunk of materials sequentially, and the chunk sums are scanned in shared memory.
+[numthreads(DEFERRED_SCAN_GROUP_SIZE, 1, 1)]
+void main(uint threadIndex : SV_GroupThreadID)
+{
+    uint const chunkSize = (g_Const.materialCount + DEFERRED_SCAN_GROUP_SIZE - 1) / DEFERRED_SCAN_GROUP_SIZE;
+    uint const chunkBegin = min(threadIndex * chunkSize, g_Const.materialCount);
+    uint const chunkEnd = min(chunkBegin + chunkSize, g_Const.materialCount);
+
+    uint chunkSum = 0;
+    for (uint materialIndex = chunkBegin; materialIndex < chunkEnd; ++materialIndex)
+        chunkSum += u_MaterialBins.Load(materialIndex * BIN_SIZE + BIN_PIXEL_COUNT);
+
+    s_ChunkSums[threadIndex] = chunkSum;
+    GroupMemoryBarrierWithGroupSync();
+
+    // Hillis-Steele inclusive scan of the chunk sums
+    for (uint stride = 1; stride < DEFERRED_SCAN_GROUP_SIZE; stride *= 2)
+    {
+        uint const addend = (threadIndex >= stride) ? s_ChunkSums[threadIndex - stride] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        s_ChunkSums[threadIndex] += addend;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    uint offset = s_ChunkSums[threadIndex] - chunkSum;
+    for (uint materialIndex = chunkBegin; materialIndex < chunkEnd; ++materialIndex)
+    {
+        uint const pixelCount = u_MaterialBins.Load(materialIndex * BIN_SIZE + BIN_PIXEL_COUNT);
+        u_MaterialBins.Store2(materialIndex * BIN_SIZE + BIN_FIRST_PIXEL, uint2(offset, 0));
+        u_IndirectArgs.Store3(materialIndex * 12, uint3(
+            (pixelCount + DEFERRED_SHADING_GROUP_SIZE - 1) / DEFERRED_SHADING_GROUP_SIZE, 1, 1));
+        offset += pixelCount;
+    }
+}
+
+#else // DEFERRED_BINNING_COUNT or DEFERRED_BINNING_SCATTER
+
+[numthreads(DEFERRED_BINNING_GROUP_SIZE, DEFERRED_BINNING_GROUP_SIZE, 1)]
+void main(uint2 threadIndex : SV_DispatchThreadID)
+{
+    if (any(threadIndex >= g_Const.viewportSize))
+        return;
+
+    uint2 const pixelPosition = threadIndex + g_Const.viewportOrigin;
+
+    uint materialIndex;
+    if (!DecodeThinGBufferMaterial(t_GBuffer1[pixelPosition], materialIndex) || materialIndex >= g_Const.materialCount)
+        return;
+
+#if BINNING_PASS == DEFERRED_BINNING_COUNT
+    u_MaterialBins.InterlockedAdd(materialIndex * BIN_SIZE + BIN_PIXEL_COUNT, 1);
+#else
+    uint const firstPixel = u_MaterialBins.Load(materialIndex * BIN_SIZE + BIN_FIRST_PIXEL);
+    uint const packedPixel = pixelPosition.x | (pixelPosition.y << 16);
+
+    // The reused pixels fill the bin from the end, the inference pixels from the start
+    uint slot;
+    if (CanReuseMaterialCache(pixelPosition, materialIndex, t_Depth[pixelPosition]))
+    {
+        u_MaterialBins.InterlockedAdd(materialIndex * BIN_SIZE + BIN_REUSE_CURSOR, 1, slot);
+        uint const pixelCount = u_MaterialBins.Load(materialIndex * BIN_SIZE + BIN_PIXEL_COUNT);
+        u_PixelList.Store((firstPixel + pixelCount - 1 - slot) * 4, packedPixel);
+    }
+    else
+    {
+        u_MaterialBins.InterlockedAdd(materialIndex * BIN_SIZE + BIN_INFERENCE_CURSOR, 1, slot);
+        u_PixelList.Store((firstPixel + slot) * 4, packedPixel);
+    }
+#endif
+}
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Runs NTC inference and shading for the pixels of one material, read from the bin that NtcDeferredBinning.hlsl
+// built for it. Each pixel runs inference exactly once, regardless of the overdraw in the thin G-buffer pass.
+// With the material cache, the pixels at the end of the bin take the textures from the previous frame instead,
+// when STF selects the same texel as on the frame when the cached textures were decompressed.
+
+#define COMPUTE_SHADING 1
+#define TRANSMISSIVE_MATERIAL 0
+#define ENABLE_ALPHA_TEST 0
+#define BINDLESS_MATERIALS 1
+#define NTC_EXPLICIT_GRADIENTS 1
+
+#include "ForwardShadingCommon.hlsli"
+
+// Include the constants header unconditionally so that NTC_NETWORK_UNKNOWN is always defined
+#include "libntc/shaders/InferenceConstants.h"
+// Include other NTC headers only if there is actually a texture to decompress
+#if NETWORK_VERSION != NTC_NETWORK_UNKNOWN
+#include "libntc/shaders/Inference.hlsli"
+typedef NtcNetworkParams<NETWORK_VERSION> NtcParams;
+#endif
+
+#define STF_SHADER_STAGE STF_SHADER_STAGE_COMPUTE
+#define STF_SHADER_MODEL_MAJOR 6
+#define STF_SHADER_MODEL_MINOR 5
+#include "STFSamplerState.hlsli"
+#include "NtcForwardShadingPassConstants.h"
+#include "NtcChannelMapping.h"
+#include "NtcThinGBuffer.hlsli"
+
+DECLARE_CBUFFER(NtcDeferredShadingConstants, g_Const, DEFERRED_BINDING_CONSTANTS, DEFERRED_SPACE_PASS);
+DECLARE_CBUFFER(ForwardShadingViewConstants, g_ForwardView, DEFERRED_BINDING_VIEW_CONSTANTS, DEFERRED_SPACE_PASS);
+DECLARE_CBUFFER(ForwardShadingLightConstants, g_ForwardLight, DEFERRED_BINDING_LIGHT_CONSTANTS, DEFERRED_SPACE_PASS);
+DECLARE_CBUFFER(NtcForwardShadingPassConstants, g_Pass, DEFERRED_BINDING_NTC_PASS_CONSTANTS, DEFERRED_SPACE_PASS);
+DECLARE_PUSH_CONSTANTS(NtcDeferredPushConstants, g_Push, DEFERRED_BINDING_PUSH_CONSTANTS, DEFERRED_SPACE_PASS);
+#define NTC_BINDLESS_MATERIAL_INDEX g_Push.materialIndex
+
+Texture2D<uint4> t_GBuffer0 : REGISTER_SRV(DEFERRED_BINDING_GBUFFER0, DEFERRED_SPACE_PASS);
+Texture2D<uint4> t_GBuffer1 : REGISTER_SRV(DEFERRED_BINDING_GBUFFER1, DEFERRED_SPACE_PASS);
+Texture2D<float> t_Depth : REGISTER_SRV(DEFERRED_BINDING_DEPTH, DEFERRED_SPACE_PASS);
+ByteAddressBuffer t_MaterialBins : REGISTER_SRV(DEFERRED_BINDING_MATERIAL_BINS, DEFERRED_SPACE_PASS);
+ByteAddressBuffer t_PixelList : REGISTER_SRV(DEFERRED_BINDING_PIXEL_LIST, DEFERRED_SPACE_PASS);
+RWTexture2D<float4> u_Color : REGISTER_UAV(DEFERRED_BINDING_COLOR_OUTPUT, DEFERRED_SPACE_PASS);
+RWByteAddressBuffer u_MipRequests : REGISTER_UAV(DEFERRED_BINDING_MIP_REQUESTS_UAV, DEFERRED_SPACE_PASS);
+Texture2D<uint4> t_MaterialCacheHistory : REGISTER_SRV(DEFERRED_BINDING_MATERIAL_CACHE_HISTORY, DEFERRED_SPACE_PASS);
+Texture2D<uint2> t_MaterialCacheHistoryKeys : REGISTER_SRV(DEFERRED_BINDING_MATERIAL_CACHE_HISTORY_KEYS, DEFERRED_SPACE_PASS);
+RWTexture2D<uint4> u_MaterialCache : REGISTER_UAV(DEFERRED_BINDING_MATERIAL_CACHE_OUTPUT, DEFERRED_SPACE_PASS);
+RWTexture2D<uint2> u_MaterialCacheKeys : REGISTER_UAV(DEFERRED_BINDING_MATERIAL_CACHE_OUTPUT_KEYS, DEFERRED_SPACE_PASS);
+
+#include "NtcMaterialSampling.hlsli"
+#include "NtcMaterialCache.hlsli"
+
+// The colors are stored with a square root to reduce the banding in dark areas. All channels, including
+// the normals and roughness, are quantized to 8 bits without dithering, so a reused pixel differs from
+// inference by up to half of an 8-bit step, and the difference stays the same for as long as the pixel
+// is reused. That can show as faint banding in the highlights of smooth surfaces.
+uint4 PackMaterialCache(MaterialTextureSample textures, bool specularGloss)
+{
+    float4 metalRoughOrSpecular = textures.metalRoughOrSpecular;
+    if (specularGloss)
+        metalRoughOrSpecular.rgb = sqrt(saturate(metalRoughOrSpecular.rgb));
+
+    return uint4(
+        Pack_RGBA8_UNORM(float4(sqrt(saturate(textures.baseOrDiffuse.rgb)), textures.opacity.r)),
+        Pack_RGBA8_UNORM(metalRoughOrSpecular),
+        Pack_RGBA8_UNORM(float4(textures.normal.rgb, textures.occlusion.r)),
+        Pack_RGBA8_UNORM(float4(sqrt(saturate(textures.emissive.rgb)), textures.transmission.r)));
+}
+
+MaterialTextureSample UnpackMaterialCache(uint4 data, bool specularGloss)
+{
+    MaterialTextureSample textures = DefaultMaterialTextures();
+
+    float4 const baseColorOpacity = Unpack_RGBA8_UNORM(data.x);
+    textures.baseOrDiffuse.rgb = baseColorOpacity.rgb * baseColorOpacity.rgb;
+    textures.opacity.r = baseColorOpacity.a;
+
+    textures.metalRoughOrSpecular = Unpack_RGBA8_UNORM(data.y);
+    if (specularGloss)
+        textures.metalRoughOrSpecular.rgb *= textures.metalRoughOrSpecular.rgb;
+
+    float4 const normalOcclusion = Unpack_RGBA8_UNORM(data.z);
+    textures.normal.rgb = normalOcclusion.rgb;
+    textures.occlusion.r = normalOcclusion.a;
+
+    float4 const emissiveTransmission = Unpack_RGBA8_UNORM(data.w);
+    textures.emissive.rgb = emissiveTransmission.rgb * emissiveTransmission.rgb;
+    textures.transmission.r = emissiveTransmission.a;
+
+    return textures;
+}
+
+[numthreads(DEFERRED_SHADING_GROUP_SIZE, 1, 1)]
+void main(uint pixelIndex : SV_DispatchThreadID)
+{
+    // See struct NtcDeferredMaterialBin
+    uint3 const bin = t_MaterialBins.Load3(g_Push.materialIndex * 16);
+    if (pixelIndex >= bin.x)
+        return;
+
+    uint const packedPixel = t_PixelList.Load((bin.y + pixelIndex) * 4);
+    uint2 const pixelPosition = uint2(packedPixel & 0xffff, packedPixel >> 16);
+
+    ThinGBufferSurface surface = DecodeThinGBuffer(t_GBuffer0[pixelPosition], t_GBuffer1[pixelPosition]);
+
+    // Reconstruct the world position from depth, using the same jittered projection as the rasterizer
+    PlanarViewConstants view = g_ForwardView.view;
+    float2 const windowPos = float2(pixelPosition) + 0.5;
+    float2 const clipXY = windowPos * view.windowToClipScale + view.windowToClipBias;
+    float const depth = t_Depth[pixelPosition];
+    float4 worldPos = mul(float4(clipXY, depth, 1), view.matClipToWorld);
+    worldPos.xyz /= worldPos.w;
+
+    bool const specularGloss = (g_Material.flags & MaterialFlags_UseSpecularGlossModel) != 0;
+
+#if NETWORK_VERSION == NTC_NETWORK_UNKNOWN
+    MaterialTextureSample textures = DefaultMaterialTextures();
+    int2 texel = 0;
+    int mipLevel = 0;
+    uint age = 0;
+#else
+    int2 texel;
+    int mipLevel;
+    GetNtcMaterialSamplePosition(pixelPosition, surface.texCoord, surface.texCoordDx, surface.texCoordDy,
+        texel, mipLevel);
+
+    // The pixels at the end of the bin reuse the cached textures if STF selected the same sample as on the
+    // frame when they were decompressed, the others fall through to inference
+    MaterialTextureSample textures;
+    bool reused = false;
+    uint age = 0;
+    if (pixelIndex >= bin.z)
+    {
+        // The scatter pass has checked that the reprojected pixel is valid
+        uint2 previousPixel;
+        float previousViewDepth;
+        ReprojectMaterialCache(pixelPosition, depth, previousPixel, previousViewDepth);
+        uint2 const cachedKey = t_MaterialCacheHistoryKeys[previousPixel];
+        if (cachedKey.y == EncodeMaterialCacheSample(texel, mipLevel))
+        {
+            textures = UnpackMaterialCache(t_MaterialCacheHistory[previousPixel], specularGloss);
+            age = GetMaterialCacheAge(cachedKey) + 1;
+            reused = true;
+        }
+    }
+
+    if (!reused)
+        textures = DecompressNtcMaterial(texel, mipLevel);
+#endif
+
+    if (g_Const.materialCache != NTC_MATERIAL_CACHE_OFF)
+    {
+        float const viewDepth = mul(float4(worldPos.xyz, 1), view.matWorldToClip).w;
+        u_MaterialCache[pixelPosition] = PackMaterialCache(textures, specularGloss);
+        u_MaterialCacheKeys[pixelPosition] = EncodeMaterialCacheKey(g_Push.materialIndex, age, viewDepth,
+            texel, mipLevel);
+    }
+
+    // Same as in NtcForwardShadingPass.hlsl
+    MaterialConstants materialConstants = g_Material;
+    materialConstants.flags |= MaterialFlags_MetalnessInRedChannel;
+    materialConstants.flags |= MaterialFlags_UseOpacityTexture;
+
+    MaterialSample surfaceMaterial = EvaluateSceneMaterial(surface.normal, surface.tangent, materialConstants, textures);
+
+    float4 color;
+    EvaluateForwardShading(
+        materialConstants,
+        surfaceMaterial,
+        worldPos.xyz,
+        surface.isFrontFace,
+        view,
+        g_ForwardLight,
+        color);
+
+    u_Color[pixelPosition] = color;
+}
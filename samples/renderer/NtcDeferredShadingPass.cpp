@@ -0,0 +1,454 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "NtcDeferredShadingPass.h"
+#include "NtcForwardShadingPass.h"
+#include "NtcMaterial.h"
+#include "MemoryTracker.h"
+#include <donut/engine/ShaderFactory.h>
+#include <donut/engine/View.h>
+#include <nvrhi/utils.h>
+#include <libntc/ntc.h>
+#include <algorithm>
+#include <vector>
+
+#if NTC_WITH_DX12
+    #include "compiled_shaders/NtcDeferredBinning.dxil.h"
+    #include "compiled_shaders/NtcDeferredShading.dxil.h"
+    #include "compiled_shaders/NtcDeferredShading_CoopVec.dxil.h"
+#endif
+
+#if NTC_WITH_VULKAN
+    #include "compiled_shaders/NtcDeferredBinning.spirv.h"
+    #include "compiled_shaders/NtcDeferredShading.spirv.h"
+    #include "compiled_shaders/NtcDeferredShading_CoopVec.spirv.h"
+#endif
+
+using namespace donut::math;
+#include <donut/shaders/forward_cb.h>
+#include "NtcForwardShadingPassConstants.h"
+
+static_assert(sizeof(NtcDeferredMaterialBin) == 16, "NtcDeferredBinning.hlsl assumes 16-byte bins");
+
+// Relative difference between the view depths of a pixel and its reprojection into the material cache
+// above which the cached textures are considered to belong to a different surface
+static const float g_materialCacheDepthTolerance = 0.02f;
+
+bool NtcDeferredShadingPass::Init(NtcForwardShadingPass const& forwardPass)
+{
+    // The material indices and resources come from the forward pass's bindless table
+    nvrhi::IBindingLayout* bindlessLayout = forwardPass.GetBindlessMaterialLayout();
+    if (!bindlessLayout)
+        return false;
+
+    auto binningLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .setRegisterSpace(DEFERRED_SPACE_PASS)
+        .setRegisterSpaceIsDescriptorSet(true)
+        .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(DEFERRED_BINDING_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_GBUFFER1))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_DEPTH))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_MATERIAL_CACHE_HISTORY_KEYS))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_UAV(DEFERRED_BINDING_MATERIAL_BINS))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_UAV(DEFERRED_BINDING_PIXEL_LIST))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_UAV(DEFERRED_BINDING_INDIRECT_ARGS));
+
+    m_binningBindingLayout = m_device->createBindingLayout(binningLayoutDesc);
+
+    auto shadingLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .setRegisterSpace(DEFERRED_SPACE_PASS)
+        .setRegisterSpaceIsDescriptorSet(true)
+        .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(DEFERRED_BINDING_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(DEFERRED_BINDING_VIEW_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(DEFERRED_BINDING_LIGHT_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(DEFERRED_BINDING_NTC_PASS_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::PushConstants(DEFERRED_BINDING_PUSH_CONSTANTS, sizeof(NtcDeferredPushConstants)))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_GBUFFER0))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_GBUFFER1))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_DEPTH))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(DEFERRED_BINDING_MATERIAL_BINS))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(DEFERRED_BINDING_PIXEL_LIST))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_MATERIAL_CACHE_HISTORY))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_MATERIAL_CACHE_HISTORY_KEYS))
+        .addItem(nvrhi::BindingLayoutItem::Texture_UAV(DEFERRED_BINDING_COLOR_OUTPUT))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_UAV(DEFERRED_BINDING_MIP_REQUESTS_UAV))
+        .addItem(nvrhi::BindingLayoutItem::Texture_UAV(DEFERRED_BINDING_MATERIAL_CACHE_OUTPUT))
+        .addItem(nvrhi::BindingLayoutItem::Texture_UAV(DEFERRED_BINDING_MATERIAL_CACHE_OUTPUT_KEYS));
+
+    m_shadingBindingLayout = m_device->createBindingLayout(shadingLayoutDesc);
+
+    if (!m_binningBindingLayout || !m_shadingBindingLayout)
+        return false;
+
+    // The binning shaders don't use the bindless table, but it occupies descriptor set 0 on Vulkan
+    for (int pass = DEFERRED_BINNING_COUNT; pass <= DEFERRED_BINNING_SCATTER; ++pass)
+    {
+        std::vector<donut::engine::ShaderMacro> defines = { { "BINNING_PASS", std::to_string(pass) } };
+        nvrhi::ShaderHandle shader = m_shaderFactory->CreateStaticPlatformShader(
+            DONUT_MAKE_PLATFORM_SHADER(g_NtcDeferredBinning), &defines, nvrhi::ShaderType::Compute);
+        if (!shader)
+            return false;
+
+        auto pipelineDesc = nvrhi::ComputePipelineDesc()
+            .setComputeShader(shader)
+            .addBindingLayout(bindlessLayout)
+            .addBindingLayout(m_binningBindingLayout);
+
+        m_binningPipelines[pass] = m_device->createComputePipeline(pipelineDesc);
+        if (!m_binningPipelines[pass])
+            return false;
+    }
+
+    m_constantBuffer = m_device->createBuffer(nvrhi::utils::CreateVolatileConstantBufferDesc(
+        sizeof(NtcDeferredShadingConstants), "NtcDeferredShadingConstants", 16));
+
+    return true;
+}
+
+nvrhi::ComputePipelineHandle NtcDeferredShadingPass::GetOrCreateShadingPipeline(PipelineKey const& key,
+    nvrhi::IBindingLayout* bindlessLayout)
+{
+    auto it = m_shadingPipelines.find(key);
+    if (it != m_shadingPipelines.end())
+        return it->second;
+
+    // Same shader selection as in NtcForwardShadingPass::GetOrCreatePixelShader
+    ntc::InferenceWeightType weightType = ntc::InferenceWeightType(key.weightType);
+    bool const useCoopVec = weightType == ntc::InferenceWeightType::CoopVecInt8 ||
+                            weightType == ntc::InferenceWeightType::CoopVecFP8;
+
+    std::vector<donut::engine::ShaderMacro> defines;
+    defines.push_back({ "NETWORK_VERSION", ntc::NetworkVersionToString(key.networkVersion) });
+    if (useCoopVec)
+        defines.push_back({ "USE_FP8", weightType == ntc::InferenceWeightType::CoopVecFP8 ? "1" : "0"});
+
+    nvrhi::ShaderHandle shader;
+    if (useCoopVec)
+    {
+        shader = m_shaderFactory->CreateStaticPlatformShader(
+            DONUT_MAKE_PLATFORM_SHADER(g_NtcDeferredShading_CoopVec), &defines, nvrhi::ShaderType::Compute);
+    }
+    else
+    {
+        shader = m_shaderFactory->CreateStaticPlatformShader(
+            DONUT_MAKE_PLATFORM_SHADER(g_NtcDeferredShading), &defines, nvrhi::ShaderType::Compute);
+    }
+
+    nvrhi::ComputePipelineHandle pipeline;
+    if (shader)
+    {
+        auto pipelineDesc = nvrhi::ComputePipelineDesc()
+            .setComputeShader(shader)
+            .addBindingLayout(bindlessLayout)
+            .addBindingLayout(m_shadingBindingLayout);
+
+        pipeline = m_device->createComputePipeline(pipelineDesc);
+    }
+
+    m_shadingPipelines[key] = pipeline;
+    return pipeline;
+}
+
+void NtcDeferredShadingPass::CreateBuffers(uint32_t materialCount, uint32_t pixelCount)
+{
+    if (materialCount > m_materialCapacity)
+    {
+        // Grow in large steps because the bindless table adds materials one by one
+        m_materialCapacity = std::max(materialCount, m_materialCapacity * 2);
+        m_materialCapacity = std::max(m_materialCapacity, 256u);
+
+        m_materialBins = m_device->createBuffer(nvrhi::BufferDesc()
+            .setByteSize(m_materialCapacity * sizeof(NtcDeferredMaterialBin))
+            .setCanHaveRawViews(true)
+            .setCanHaveUAVs(true)
+            .setDebugName("NtcDeferredMaterialBins")
+            .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true));
+
+        m_indirectArgs = m_device->createBuffer(nvrhi::BufferDesc()
+            .setByteSize(m_materialCapacity * sizeof(nvrhi::DispatchIndirectArguments))
+            .setCanHaveRawViews(true)
+            .setCanHaveUAVs(true)
+            .setIsDrawIndirectArgs(true)
+            .setDebugName("NtcDeferredIndirectArgs")
+            .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true));
+
+        if (m_memoryTracker)
+        {
+            m_memoryTracker->TrackBuffer(m_materialBins, MemoryCategory::PassBuffers, "Deferred Shading");
+            m_memoryTracker->TrackBuffer(m_indirectArgs, MemoryCategory::PassBuffers, "Deferred Shading");
+        }
+
+        m_boundColor = nullptr;
+    }
+
+    if (pixelCount > m_pixelCapacity)
+    {
+        m_pixelCapacity = pixelCount;
+
+        m_pixelList = m_device->createBuffer(nvrhi::BufferDesc()
+            .setByteSize(uint64_t(m_pixelCapacity) * sizeof(uint32_t))
+            .setCanHaveRawViews(true)
+            .setCanHaveUAVs(true)
+            .setDebugName("NtcDeferredPixelList")
+            .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true));
+
+        if (m_memoryTracker)
+            m_memoryTracker->TrackBuffer(m_pixelList, MemoryCategory::PassBuffers, "Deferred Shading");
+
+        m_boundColor = nullptr;
+    }
+}
+
+void NtcDeferredShadingPass::CreateMaterialCache(uint32_t width, uint32_t height)
+{
+    if (!m_enableMaterialCache)
+        width = height = 1;
+
+    if (m_materialCache[0] && m_materialCache[0]->getDesc().width == width &&
+        m_materialCache[0]->getDesc().height == height)
+        return;
+
+    auto textureDesc = nvrhi::TextureDesc()
+        .setDimension(nvrhi::TextureDimension::Texture2D)
+        .setWidth(width)
+        .setHeight(height)
+        .setIsUAV(true)
+        .setInitialState(nvrhi::ResourceStates::ShaderResource)
+        .setKeepInitialState(true);
+
+    for (int index = 0; index < 2; ++index)
+    {
+        m_materialCache[index] = m_device->createTexture(textureDesc
+            .setFormat(nvrhi::Format::RGBA32_UINT)
+            .setDebugName("NtcMaterialCache"));
+
+        m_materialCacheKeys[index] = m_device->createTexture(textureDesc
+            .setFormat(nvrhi::Format::RG32_UINT)
+            .setDebugName("NtcMaterialCacheKeys"));
+
+        if (m_memoryTracker)
+        {
+            m_memoryTracker->TrackTexture(m_materialCache[index], MemoryCategory::PassBuffers, "Deferred Shading");
+            m_memoryTracker->TrackTexture(m_materialCacheKeys[index], MemoryCategory::PassBuffers, "Deferred Shading");
+        }
+    }
+
+    m_materialCacheValid = false;
+    m_boundColor = nullptr;
+}
+
+void NtcDeferredShadingPass::CreateBindingSets(NtcForwardShadingPass const& forwardPass, nvrhi::ITexture* gbuffer0,
+    nvrhi::ITexture* gbuffer1, nvrhi::ITexture* depth, nvrhi::ITexture* color)
+{
+    if (m_boundColor == color && m_binningBindingSets[0] && m_shadingBindingSets[0])
+        return;
+
+    // Set 'index' writes the material cache textures 'index' and reads the other ones
+    for (int index = 0; index < 2; ++index)
+    {
+        nvrhi::ITexture* const history = m_materialCache[index ^ 1];
+        nvrhi::ITexture* const historyKeys = m_materialCacheKeys[index ^ 1];
+
+        auto binningSetDesc = nvrhi::BindingSetDesc()
+            .addItem(nvrhi::BindingSetItem::ConstantBuffer(DEFERRED_BINDING_CONSTANTS, m_constantBuffer))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_GBUFFER1, gbuffer1))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_DEPTH, depth))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_MATERIAL_CACHE_HISTORY_KEYS, historyKeys))
+            .addItem(nvrhi::BindingSetItem::RawBuffer_UAV(DEFERRED_BINDING_MATERIAL_BINS, m_materialBins))
+            .addItem(nvrhi::BindingSetItem::RawBuffer_UAV(DEFERRED_BINDING_PIXEL_LIST, m_pixelList))
+            .addItem(nvrhi::BindingSetItem::RawBuffer_UAV(DEFERRED_BINDING_INDIRECT_ARGS, m_indirectArgs));
+
+        m_binningBindingSets[index] = m_device->createBindingSet(binningSetDesc, m_binningBindingLayout);
+
+        auto shadingSetDesc = nvrhi::BindingSetDesc()
+            .addItem(nvrhi::BindingSetItem::ConstantBuffer(DEFERRED_BINDING_CONSTANTS, m_constantBuffer))
+            .addItem(nvrhi::BindingSetItem::ConstantBuffer(DEFERRED_BINDING_VIEW_CONSTANTS, forwardPass.GetViewConstants()))
+            .addItem(nvrhi::BindingSetItem::ConstantBuffer(DEFERRED_BINDING_LIGHT_CONSTANTS, forwardPass.GetLightConstants()))
+            .addItem(nvrhi::BindingSetItem::ConstantBuffer(DEFERRED_BINDING_NTC_PASS_CONSTANTS, forwardPass.GetPassConstants()))
+            .addItem(nvrhi::BindingSetItem::PushConstants(DEFERRED_BINDING_PUSH_CONSTANTS, sizeof(NtcDeferredPushConstants)))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_GBUFFER0, gbuffer0))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_GBUFFER1, gbuffer1))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_DEPTH, depth))
+            .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(DEFERRED_BINDING_MATERIAL_BINS, m_materialBins))
+            .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(DEFERRED_BINDING_PIXEL_LIST, m_pixelList))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_MATERIAL_CACHE_HISTORY, history))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_MATERIAL_CACHE_HISTORY_KEYS, historyKeys))
+            .addItem(nvrhi::BindingSetItem::Texture_UAV(DEFERRED_BINDING_COLOR_OUTPUT, color))
+            .addItem(nvrhi::BindingSetItem::RawBuffer_UAV(DEFERRED_BINDING_MIP_REQUESTS_UAV, forwardPass.GetMipRequestBuffer()))
+            .addItem(nvrhi::BindingSetItem::Texture_UAV(DEFERRED_BINDING_MATERIAL_CACHE_OUTPUT, m_materialCache[index]))
+            .addItem(nvrhi::BindingSetItem::Texture_UAV(DEFERRED_BINDING_MATERIAL_CACHE_OUTPUT_KEYS, m_materialCacheKeys[index]));
+
+        m_shadingBindingSets[index] = m_device->createBindingSet(shadingSetDesc, m_shadingBindingLayout);
+    }
+
+    m_boundColor = color;
+}
+
+void NtcDeferredShadingPass::Render(nvrhi::ICommandList* commandList, NtcForwardShadingPass const& forwardPass,
+    nvrhi::ITexture* gbuffer0, nvrhi::ITexture* gbuffer1, nvrhi::ITexture* depth, nvrhi::ITexture* color,
+    donut::engine::IView const& view, donut::engine::IView const& previousView)
+{
+    auto const& materialIndices = forwardPass.GetBindlessMaterialIndices();
+    if (materialIndices.empty())
+        return;
+
+    // The bins cover all slots of the bindless table, the unused ones stay empty
+    uint32_t const materialCount = forwardPass.GetBindlessMaterialSlotCount();
+    nvrhi::TextureDesc const& colorDesc = color->getDesc();
+    CreateBuffers(materialCount, colorDesc.width * colorDesc.height);
+    CreateMaterialCache(colorDesc.width, colorDesc.height);
+    CreateBindingSets(forwardPass, gbuffer0, gbuffer1, depth, color);
+
+    nvrhi::Rect const viewExtent = view.GetViewExtent();
+
+    PlanarViewConstants viewConstants;
+    PlanarViewConstants previousViewConstants;
+    view.FillPlanarViewConstants(viewConstants);
+    previousView.FillPlanarViewConstants(previousViewConstants);
+
+    NtcDeferredShadingConstants constants {};
+    constants.matClipToWorld = viewConstants.matClipToWorld;
+    constants.matWorldToPrevClip = previousViewConstants.matWorldToClip;
+    constants.windowToClipScale = viewConstants.windowToClipScale;
+    constants.windowToClipBias = viewConstants.windowToClipBias;
+    constants.prevClipToWindowScale = previousViewConstants.clipToWindowScale;
+    constants.prevClipToWindowBias = previousViewConstants.clipToWindowBias;
+    constants.viewportOrigin = uint2(viewExtent.minX, viewExtent.minY);
+    constants.viewportSize = uint2(viewExtent.width(), viewExtent.height());
+    constants.materialCount = materialCount;
+    constants.materialCache = !m_enableMaterialCache ? NTC_MATERIAL_CACHE_OFF
+        : m_materialCacheValid ? NTC_MATERIAL_CACHE_REUSE
+        : NTC_MATERIAL_CACHE_WRITE;
+    constants.materialCacheRefreshPeriod = m_materialCacheRefreshPeriod;
+    constants.frameIndex = m_frameIndex++;
+    constants.materialCacheDepthTolerance = g_materialCacheDepthTolerance;
+    commandList->writeBuffer(m_constantBuffer, &constants, sizeof(constants));
+
+    commandList->clearBufferUInt(m_materialBins, 0);
+
+    // Pixels that are not shaded on this frame, such as the background, must not match any material
+    if (m_enableMaterialCache)
+    {
+        commandList->clearTextureUInt(m_materialCacheKeys[m_materialCacheIndex],
+            nvrhi::AllSubresources, 0);
+    }
+
+    nvrhi::IDescriptorTable* bindlessTable = forwardPass.GetBindlessMaterialTable();
+    uint2 const pixelGroups = (constants.viewportSize + DEFERRED_BINNING_GROUP_SIZE - 1) / DEFERRED_BINNING_GROUP_SIZE;
+
+    auto state = nvrhi::ComputeState()
+        .addBindingSet(bindlessTable)
+        .addBindingSet(m_binningBindingSets[m_materialCacheIndex]);
+
+    // The passes depend on each other through the UAV buffers, nvrhi inserts the barriers between dispatches
+    state.setPipeline(m_binningPipelines[DEFERRED_BINNING_COUNT]);
+    commandList->setComputeState(state);
+    commandList->dispatch(pixelGroups.x, pixelGroups.y);
+
+    state.setPipeline(m_binningPipelines[DEFERRED_BINNING_SCAN]);
+    commandList->setComputeState(state);
+    commandList->dispatch(1);
+
+    state.setPipeline(m_binningPipelines[DEFERRED_BINNING_SCATTER]);
+    commandList->setComputeState(state);
+    commandList->dispatch(pixelGroups.x, pixelGroups.y);
+
+    // Sort the materials by pipeline to minimize the state changes. Only the materials that the thin G-buffer
+    // pass has drawn on this frame can have pixels in their bins. The materials drawn in the forward pass
+    // and the culled ones also have bindless indices, but dispatching them would only add empty dispatches
+    // and the barriers between them.
+    struct MaterialDispatch
+    {
+        PipelineKey key;
+        uint32_t materialIndex;
+    };
+    auto const& thinGBufferMaterials = forwardPass.GetThinGBufferMaterials();
+    std::vector<MaterialDispatch> dispatches;
+    dispatches.reserve(thinGBufferMaterials.size());
+    for (NtcMaterial const* material : thinGBufferMaterials)
+    {
+        auto found = materialIndices.find(material);
+        if (found == materialIndices.end())
+            continue;
+
+        MaterialDispatch& dispatch = dispatches.emplace_back();
+        dispatch.key.networkVersion = material->networkVersion;
+        dispatch.key.weightType = material->weightType;
+        dispatch.materialIndex = found->second;
+    }
+    std::sort(dispatches.begin(), dispatches.end(), [](MaterialDispatch const& a, MaterialDispatch const& b)
+    {
+        if (a.key.networkVersion != b.key.networkVersion)
+            return a.key.networkVersion < b.key.networkVersion;
+        if (a.key.weightType != b.key.weightType)
+            return a.key.weightType < b.key.weightType;
+        return a.materialIndex < b.materialIndex;
+    });
+
+    state = nvrhi::ComputeState()
+        .addBindingSet(bindlessTable)
+        .addBindingSet(m_shadingBindingSets[m_materialCacheIndex])
+        .setIndirectParams(m_indirectArgs);
+
+    for (MaterialDispatch const& dispatch : dispatches)
+    {
+        nvrhi::IComputePipeline* pipeline = GetOrCreateShadingPipeline(dispatch.key,
+            forwardPass.GetBindlessMaterialLayout());
+        if (!pipeline)
+            continue;
+
+        state.setPipeline(pipeline);
+        commandList->setComputeState(state);
+
+        NtcDeferredPushConstants pushConstants {};
+        pushConstants.materialIndex = dispatch.materialIndex;
+        commandList->setPushConstants(&pushConstants, sizeof(pushConstants));
+
+        commandList->dispatchIndirect(dispatch.materialIndex * sizeof(nvrhi::DispatchIndirectArguments));
+    }
+
+    // The textures written on this frame become the history of the next one
+    if (m_enableMaterialCache)
+    {
+        m_materialCacheValid = true;
+        m_materialCacheIndex ^= 1;
+    }
+}
+
+void NtcDeferredShadingPass::SetMaterialCache(bool enable, uint32_t refreshPeriod)
+{
+    // The age field of the cache key is 4 bits, see NtcMaterialCache.hlsli
+    m_materialCacheRefreshPeriod = std::clamp(refreshPeriod, 1u, 16u);
+    if (m_enableMaterialCache == enable)
+        return;
+
+    // The cache textures are re-created at the new size on the next Render call
+    m_enableMaterialCache = enable;
+    m_materialCache[0] = m_materialCache[1] = nullptr;
+    m_materialCacheKeys[0] = m_materialCacheKeys[1] = nullptr;
+    ResetBindingCache();
+}
+
+void NtcDeferredShadingPass::ResetBindingCache()
+{
+    for (int index = 0; index < 2; ++index)
+    {
+        m_binningBindingSets[index] = nullptr;
+        m_shadingBindingSets[index] = nullptr;
+    }
+    m_boundColor = nullptr;
+    m_materialCacheValid = false;
+}
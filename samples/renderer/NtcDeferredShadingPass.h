@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <memory>
+#include <unordered_map>
+
+namespace donut::engine
+{
+    class ShaderFactory;
+    class IView;
+}
+
+class NtcForwardShadingPass;
+class MemoryTracker;
+
+// Shades the pixels that NtcForwardShadingPass wrote into the thin G-buffer. The pixels are binned by material
+// on the GPU, and then every material that has any visible pixels is shaded with one indirect dispatch,
+// so that inference runs once per pixel and with the pipeline specialized for that material's network.
+// Optionally, the decompressed material textures are kept in a temporal cache, and the pixels that can be
+// reprojected into the previous frame reuse them instead of running inference, see NtcMaterialCache.hlsli.
+class NtcDeferredShadingPass
+{
+private:
+    struct PipelineKey
+    {
+        int networkVersion = 0;
+        int weightType = 0;
+
+        bool operator==(PipelineKey const& other) const
+        {
+            return networkVersion == other.networkVersion && weightType == other.weightType;
+        }
+    };
+
+    struct PipelineKeyHash
+    {
+        size_t operator()(PipelineKey const& s) const
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.networkVersion);
+            nvrhi::hash_combine(hash, s.weightType);
+            return hash;
+        }
+    };
+
+    nvrhi::DeviceHandle m_device;
+    std::shared_ptr<donut::engine::ShaderFactory> m_shaderFactory;
+
+    nvrhi::BindingLayoutHandle m_binningBindingLayout;
+    nvrhi::BindingLayoutHandle m_shadingBindingLayout;
+    nvrhi::ComputePipelineHandle m_binningPipelines[3]; // Indexed by DEFERRED_BINNING_...
+    std::unordered_map<PipelineKey, nvrhi::ComputePipelineHandle, PipelineKeyHash> m_shadingPipelines;
+
+    nvrhi::BufferHandle m_constantBuffer;
+    nvrhi::BufferHandle m_materialBins;
+    nvrhi::BufferHandle m_indirectArgs;
+    nvrhi::BufferHandle m_pixelList;
+    uint32_t m_materialCapacity = 0;
+    uint32_t m_pixelCapacity = 0;
+
+    // Two sets of material cache textures, written on alternating frames. They are 1x1 when the cache is off.
+    nvrhi::TextureHandle m_materialCache[2];
+    nvrhi::TextureHandle m_materialCacheKeys[2];
+    uint32_t m_materialCacheIndex = 0; // Written on this frame
+    bool m_enableMaterialCache = false;
+    bool m_materialCacheValid = false; // The other set has the previous frame's textures
+    uint32_t m_materialCacheRefreshPeriod = 8;
+    uint32_t m_frameIndex = 0;
+
+    // Binding sets depend on the render targets, which are only re-created on resize, and the material cache set
+    nvrhi::BindingSetHandle m_binningBindingSets[2];
+    nvrhi::BindingSetHandle m_shadingBindingSets[2];
+    nvrhi::ITexture* m_boundColor = nullptr;
+
+    MemoryTracker* m_memoryTracker = nullptr;
+
+    nvrhi::ComputePipelineHandle GetOrCreateShadingPipeline(PipelineKey const& key, nvrhi::IBindingLayout* bindlessLayout);
+    void CreateBuffers(uint32_t materialCount, uint32_t pixelCount);
+    void CreateMaterialCache(uint32_t width, uint32_t height);
+    void CreateBindingSets(NtcForwardShadingPass const& forwardPass, nvrhi::ITexture* gbuffer0,
+        nvrhi::ITexture* gbuffer1, nvrhi::ITexture* depth, nvrhi::ITexture* color);
+
+public:
+    NtcDeferredShadingPass(nvrhi::IDevice* device, std::shared_ptr<donut::engine::ShaderFactory> shaderFactory)
+        : m_device(device)
+        , m_shaderFactory(shaderFactory)
+    { }
+
+    bool Init(NtcForwardShadingPass const& forwardPass);
+
+    // Call after the thin G-buffer pass. Reads the view, light and pass constants that the forward pass
+    // has written for this frame, and writes the shaded pixels into 'color', which must be a UAV.
+    // The previous view is used to reproject the pixels into the material cache.
+    void Render(nvrhi::ICommandList* commandList, NtcForwardShadingPass const& forwardPass,
+        nvrhi::ITexture* gbuffer0, nvrhi::ITexture* gbuffer1, nvrhi::ITexture* depth, nvrhi::ITexture* color,
+        donut::engine::IView const& view, donut::engine::IView const& previousView);
+
+    // Every pixel that reuses the cached textures still runs inference once per 'refreshPeriod' frames,
+    // which is clamped to 1-16
+    void SetMaterialCache(bool enable, uint32_t refreshPeriod);
+
+    // Call when the cached textures are no longer valid, such as when materials finish loading, or when
+    // the previous frame didn't use the deferred pass
+    void InvalidateMaterialCache() { m_materialCacheValid = false; }
+
+    void ResetBindingCache();
+
+    // Reports the binning buffers to the tracker when they are created. The tracker may be null.
+    void SetMemoryTracker(MemoryTracker* memoryTracker) { m_memoryTracker = memoryTracker; }
+};
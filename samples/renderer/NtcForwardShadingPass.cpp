@@ -18,12 +18,18 @@
 #include <donut/engine/SceneTypes.h>
 #include <nvrhi/utils.h>
 #include <libntc/ntc.h>
+#include <atomic>
+#include <thread>
+#include <unordered_set>
 
 #if NTC_WITH_DX12
     #include "compiled_shaders/NtcForwardShadingPass_CoopVec.dxil.h"
     #include "compiled_shaders/NtcForwardShadingPass.dxil.h"
     #include "compiled_shaders/LegacyForwardShadingPass.dxil.h"
     #include "compiled_shaders/ForwardShadingPassFeedback.dxil.h"
+    #include "compiled_shaders/NtcThinGBufferPass.dxil.h"
+    #include "compiled_shaders/NtcAlphaTestPass_CoopVec.dxil.h"
+    #include "compiled_shaders/NtcAlphaTestPass.dxil.h"
     // This shader comes from Donut - see CMakeLists.txt that adds an include path to .../donut/shaders
     #include "compiled_shaders/passes/forward_vs_buffer_loads.dxil.h"
 #endif
@@ -32,6 +38,9 @@
     #include "compiled_shaders/NtcForwardShadingPass_CoopVec.spirv.h"
     #include "compiled_shaders/NtcForwardShadingPass.spirv.h"
     #include "compiled_shaders/LegacyForwardShadingPass.spirv.h"
+    #include "compiled_shaders/NtcThinGBufferPass.spirv.h"
+    #include "compiled_shaders/NtcAlphaTestPass_CoopVec.spirv.h"
+    #include "compiled_shaders/NtcAlphaTestPass.spirv.h"
     // Comes from Donut, same as forward_vs_buffer_loads.dxil.h above
     #include "compiled_shaders/passes/forward_vs_buffer_loads.spirv.h"
 #endif
@@ -40,6 +49,9 @@ using namespace donut::math;
 #include <donut/shaders/forward_cb.h>
 #include "NtcForwardShadingPassConstants.h"
 
+static const uint32_t g_maxBindlessMaterials = 16384;
+static const uint32_t g_initialBindlessMaterials = 256; // The table grows as needed
+
 std::shared_ptr<donut::engine::Material> NtcSceneTypeFactory::CreateMaterial()
 {
     return std::make_shared<NtcMaterial>();
@@ -53,6 +65,9 @@ nvrhi::ShaderHandle NtcForwardShadingPass::GetOrCreatePixelShader(PipelineKey ke
     key.frontCounterClockwise = false;
     key.reverseDepth = false;
 
+    if (key.thinGBuffer)
+        return m_thinGBufferPixelShader;
+
     // See if there already is a pixel shader with that key
     auto it = m_pixelShaders.find(key);
     if (it != m_pixelShaders.end())
@@ -74,6 +89,23 @@ nvrhi::ShaderHandle NtcForwardShadingPass::GetOrCreatePixelShader(PipelineKey ke
 
 
     std::vector<donut::engine::ShaderMacro> defines;
+    if (key.alphaTestPrepass)
+    {
+        defines.push_back({ "NETWORK_VERSION", networkVersion });
+        defines.push_back({ "BINDLESS_MATERIALS", key.bindlessMaterials ? "1" : "0" });
+        if (useCoopVec)
+            defines.push_back({ "USE_FP8", weightType == ntc::InferenceWeightType::CoopVecFP8 ? "1" : "0"});
+
+        nvrhi::ShaderHandle pixelShader = useCoopVec
+            ? m_shaderFactory->CreateStaticPlatformShader(DONUT_MAKE_PLATFORM_SHADER(g_NtcAlphaTestPass_CoopVec),
+                &defines, nvrhi::ShaderType::Pixel)
+            : m_shaderFactory->CreateStaticPlatformShader(DONUT_MAKE_PLATFORM_SHADER(g_NtcAlphaTestPass),
+                &defines, nvrhi::ShaderType::Pixel);
+
+        m_pixelShaders[key] = pixelShader;
+        return pixelShader;
+    }
+
     defines.push_back({ "TRANSMISSIVE_MATERIAL", transmissiveMaterial ? "1": "0" });
     defines.push_back({ "ENABLE_ALPHA_TEST", alphaTestedMaterial ? "1" : "0" });
 
@@ -82,6 +114,8 @@ nvrhi::ShaderHandle NtcForwardShadingPass::GetOrCreatePixelShader(PipelineKey ke
     {
         case NtcMode::InferenceOnSample:
             defines.push_back({ "NETWORK_VERSION", networkVersion });
+            defines.push_back({ "BINDLESS_MATERIALS", key.bindlessMaterials ? "1" : "0" });
+            defines.push_back({ "QUAD_SHARED_INFERENCE", key.quadSharedInference ? "1" : "0" });
             if (useCoopVec)
                 defines.push_back({ "USE_FP8", weightType == ntc::InferenceWeightType::CoopVecFP8 ? "1" : "0"});
 
@@ -123,17 +157,44 @@ nvrhi::ShaderHandle NtcForwardShadingPass::GetOrCreatePixelShader(PipelineKey ke
     return pixelShader;
 }
 
-nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(PipelineKey key, nvrhi::IFramebuffer* framebuffer)
+void NtcForwardShadingPass::NormalizePipelineKey(PipelineKey& key)
 {
-    if (key.ntcMode != NtcMode::InferenceOnSample)
+    if (key.thinGBuffer)
+    {
+        // The G-buffer shader doesn't depend on the material, it only writes the bindless index
+        key.networkVersion = 0;
+        key.weightType = 0;
+        key.domain = donut::engine::MaterialDomain::Opaque;
+        key.ntcMode = NtcMode::InferenceOnSample;
+        key.useSTF = false;
+        key.bindlessMaterials = true;
+        key.quadSharedInference = false;
+    }
+    else if (key.alphaTestPrepass)
+    {
+        // The pre-pass shader only depends on the network and the binding model
+        key.domain = donut::engine::MaterialDomain::AlphaTested;
+        key.hasDepthPrepass = false;
+        key.ntcMode = NtcMode::InferenceOnSample;
+        key.useSTF = false;
+        key.quadSharedInference = false;
+    }
+    else if (key.ntcMode != NtcMode::InferenceOnSample)
     {
         key.networkVersion = 0;
         key.weightType = 0;
+        key.bindlessMaterials = false;
+        key.quadSharedInference = false;
     }
     else
     {
         key.useSTF = true;
     }
+}
+
+nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(PipelineKey key, nvrhi::IFramebuffer* framebuffer)
+{
+    NormalizePipelineKey(key);
 
     // See if there already is a pipeline with that key
     auto it = m_pipelines.find(key);
@@ -142,6 +203,16 @@ nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(Pipelin
 
     // Create a new pipeline
     nvrhi::GraphicsPipelineDesc pipelineDesc;
+    if (!FillPipelineDesc(key, pipelineDesc))
+        return nullptr;
+
+    nvrhi::GraphicsPipelineHandle pipeline = m_device->createGraphicsPipeline(pipelineDesc, framebuffer);
+    m_pipelines[key] = pipeline;
+    return pipeline;
+}
+
+bool NtcForwardShadingPass::FillPipelineDesc(PipelineKey const& key, nvrhi::GraphicsPipelineDesc& pipelineDesc)
+{
     pipelineDesc.inputLayout = m_inputLayout;
     pipelineDesc.VS = m_vertexShader;
     pipelineDesc.renderState.rasterState.frontCounterClockwise = key.frontCounterClockwise;
@@ -150,9 +221,12 @@ nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(Pipelin
     switch(key.ntcMode)
     {
         case NtcMode::InferenceOnSample:
-            materialBindingLayout = key.networkVersion == NTC_NETWORK_UNKNOWN 
-                ? (nvrhi::IBindingLayout*)m_emptyMaterialBindingLayout 
-                : (nvrhi::IBindingLayout*)m_materialBindingLayout;
+            if (key.bindlessMaterials || key.thinGBuffer)
+                materialBindingLayout = m_bindlessMaterialLayout;
+            else
+                materialBindingLayout = key.networkVersion == NTC_NETWORK_UNKNOWN 
+                    ? (nvrhi::IBindingLayout*)m_emptyMaterialBindingLayout 
+                    : (nvrhi::IBindingLayout*)m_materialBindingLayout;
             break;
 
         case NtcMode::InferenceOnLoad:
@@ -218,12 +292,96 @@ nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(Pipelin
         break;
     }
     default:
-        return nullptr;
+        return false;
     }
 
-    nvrhi::GraphicsPipelineHandle pipeline = m_device->createGraphicsPipeline(pipelineDesc, framebuffer);
-    m_pipelines[key] = pipeline;
-    return pipeline;
+    return pipelineDesc.PS != nullptr;
+}
+
+uint32_t NtcForwardShadingPass::PrecompilePipelines(PipelineWarmUpDesc const& desc, nvrhi::IFramebuffer* framebuffer)
+{
+    // Enumerate the keys that SetupMaterial(...) can produce for these materials with any of the UI settings.
+    // The alpha test pre-pass pipelines use the depth framebuffer, so they are created on first use.
+    std::unordered_set<PipelineKey, PipelineKeyHash> keys;
+    for (NtcMaterial const* material : desc.materials)
+    {
+        PipelineKey key;
+        key.domain = material->domain;
+        key.networkVersion = material->networkVersion;
+        key.weightType = material->weightType;
+        key.frontCounterClockwise = desc.frontCounterClockwise;
+        key.reverseDepth = desc.reverseDepth;
+
+        // Double-sided transparent materials are drawn with front and back faces separately
+        std::vector<nvrhi::RasterCullMode> cullModes = { nvrhi::RasterCullMode::Back };
+        if (material->doubleSided)
+            cullModes = { nvrhi::RasterCullMode::None, nvrhi::RasterCullMode::Front, nvrhi::RasterCullMode::Back };
+
+        for (NtcMode ntcMode : desc.ntcModes)
+        {
+            key.ntcMode = ntcMode;
+            for (nvrhi::RasterCullMode cullMode : cullModes)
+            {
+                key.cullMode = cullMode;
+                for (int variant = 0; variant < 16; ++variant)
+                {
+                    key.hasDepthPrepass = (variant & 1) != 0;
+                    key.useSTF = (variant & 2) != 0;
+                    key.bindlessMaterials = (variant & 4) != 0;
+                    key.quadSharedInference = (variant & 8) != 0;
+                    if (key.bindlessMaterials && !(desc.bindlessMaterials && IsBindlessMaterialsSupported()))
+                        continue;
+
+                    PipelineKey normalizedKey = key;
+                    NormalizePipelineKey(normalizedKey);
+                    if (m_pipelines.find(normalizedKey) == m_pipelines.end())
+                        keys.insert(normalizedKey);
+                }
+            }
+        }
+    }
+
+    // Shader creation is cheap and uses the shader factory, so do it here, and only create the pipelines
+    // on the worker threads - that's where the drivers compile the shaders
+    std::vector<PipelineKey> pendingKeys;
+    std::vector<nvrhi::GraphicsPipelineDesc> pipelineDescs;
+    for (PipelineKey const& key : keys)
+    {
+        nvrhi::GraphicsPipelineDesc pipelineDesc;
+        if (!FillPipelineDesc(key, pipelineDesc))
+            continue;
+
+        pendingKeys.push_back(key);
+        pipelineDescs.push_back(pipelineDesc);
+    }
+
+    std::vector<nvrhi::GraphicsPipelineHandle> pipelines(pendingKeys.size());
+    std::atomic<size_t> nextPipeline = 0;
+    auto workerFunction = [this, &pipelineDescs, &pipelines, &nextPipeline, framebuffer]()
+    {
+        for (size_t index = nextPipeline++; index < pipelines.size(); index = nextPipeline++)
+            pipelines[index] = m_device->createGraphicsPipeline(pipelineDescs[index], framebuffer);
+    };
+
+    uint32_t const threadCount = std::max(1u, std::min(desc.threadCount, uint32_t(pendingKeys.size())));
+    std::vector<std::thread> threads;
+    for (uint32_t threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+        threads.emplace_back(workerFunction);
+    workerFunction();
+    for (std::thread& thread : threads)
+        thread.join();
+
+    uint32_t createdPipelines = 0;
+    for (size_t index = 0; index < pendingKeys.size(); ++index)
+    {
+        if (!pipelines[index])
+            continue;
+
+        m_pipelines[pendingKeys[index]] = pipelines[index];
+        ++createdPipelines;
+    }
+
+    return createdPipelines;
 }
 
 nvrhi::BindingSetHandle NtcForwardShadingPass::GetOrCreateMaterialBindingSet(NtcMaterial const* material)
@@ -238,8 +396,8 @@ nvrhi::BindingSetHandle NtcForwardShadingPass::GetOrCreateMaterialBindingSet(Ntc
     if (material->ntcConstantBuffer)
     {
         bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_NTC_MATERIAL_CONSTANTS, material->ntcConstantBuffer));
-        bindingSetDesc.addItem(nvrhi::BindingSetItem::RawBuffer_SRV(FORWARD_BINDING_NTC_LATENTS_BUFFER, material->ntcLatentsBuffer));
-        bindingSetDesc.addItem(nvrhi::BindingSetItem::RawBuffer_SRV(FORWARD_BINDING_NTC_WEIGHTS_BUFFER, material->ntcWeightsBuffer));
+        bindingSetDesc.addItem(nvrhi::BindingSetItem::RawBuffer_SRV(FORWARD_BINDING_NTC_LATENTS_BUFFER, material->ntcLatentsBuffer, material->ntcLatentsRange));
+        bindingSetDesc.addItem(nvrhi::BindingSetItem::RawBuffer_SRV(FORWARD_BINDING_NTC_WEIGHTS_BUFFER, material->ntcWeightsBuffer, material->ntcWeightsRange));
         bindingSet = m_device->createBindingSet(bindingSetDesc, m_materialBindingLayout);
     }
     else
@@ -259,6 +417,55 @@ static nvrhi::BindingSetItem GetReservedBindingSetItem(uint32_t slot,
     return nvrhi::BindingSetItem::Texture_SRV(slot, fallback);
 }
 
+bool NtcForwardShadingPass::GetOrCreateBindlessMaterialIndex(NtcMaterial const* material, uint32_t& outIndex)
+{
+    auto found = m_bindlessMaterialIndices.find(material);
+    if (found != m_bindlessMaterialIndices.end())
+    {
+        outIndex = found->second;
+        return true;
+    }
+
+    uint32_t materialIndex;
+    if (!m_freeBindlessSlots.empty())
+    {
+        materialIndex = m_freeBindlessSlots.back();
+        m_freeBindlessSlots.pop_back();
+    }
+    else
+    {
+        if (m_bindlessMaterialSlotCount >= g_maxBindlessMaterials)
+            return false;
+
+        materialIndex = m_bindlessMaterialSlotCount++;
+        if (materialIndex >= m_bindlessMaterialCapacity)
+        {
+            m_bindlessMaterialCapacity = std::min(std::max(m_bindlessMaterialCapacity * 2, g_initialBindlessMaterials),
+                g_maxBindlessMaterials);
+            m_device->resizeDescriptorTable(m_bindlessMaterialTable,
+                m_bindlessMaterialCapacity * NTC_BINDLESS_DESCRIPTORS_PER_MATERIAL, /* keepContents = */ true);
+        }
+    }
+
+    // Materials without NTC data only use the material constants, see the NTC_NETWORK_UNKNOWN shader variant
+    uint32_t const firstDescriptor = materialIndex * NTC_BINDLESS_DESCRIPTORS_PER_MATERIAL;
+    m_device->writeDescriptorTable(m_bindlessMaterialTable, nvrhi::BindingSetItem::ConstantBuffer(
+        firstDescriptor + NTC_BINDLESS_MATERIAL_CONSTANTS, material->materialConstants));
+    if (material->ntcConstantBuffer)
+    {
+        m_device->writeDescriptorTable(m_bindlessMaterialTable, nvrhi::BindingSetItem::ConstantBuffer(
+            firstDescriptor + NTC_BINDLESS_NTC_CONSTANTS, material->ntcConstantBuffer));
+        m_device->writeDescriptorTable(m_bindlessMaterialTable, nvrhi::BindingSetItem::RawBuffer_SRV(
+            firstDescriptor + NTC_BINDLESS_LATENTS_BUFFER, material->ntcLatentsBuffer, material->ntcLatentsRange));
+        m_device->writeDescriptorTable(m_bindlessMaterialTable, nvrhi::BindingSetItem::RawBuffer_SRV(
+            firstDescriptor + NTC_BINDLESS_WEIGHTS_BUFFER, material->ntcWeightsBuffer, material->ntcWeightsRange));
+    }
+
+    m_bindlessMaterialIndices[material] = materialIndex;
+    outIndex = materialIndex;
+    return true;
+}
+
 static nvrhi::BindingSetItem GetFeedbackBindingSetItem(uint32_t slot,
     nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> const& texture)
 {
@@ -325,8 +532,10 @@ std::shared_ptr<donut::engine::MaterialBindingCache> NtcForwardShadingPass::Crea
         commonPasses.m_BlackTexture);
 }
 
-bool NtcForwardShadingPass::Init()
+bool NtcForwardShadingPass::Init(uint32_t framesInFlight)
 {
+    m_framesInFlight = framesInFlight;
+
     auto vertexShaderDesc = nvrhi::ShaderDesc()
         .setShaderType(nvrhi::ShaderType::Vertex)
         .setEntryName("buffer_loads");
@@ -334,6 +543,9 @@ bool NtcForwardShadingPass::Init()
     m_vertexShader = m_shaderFactory->CreateStaticPlatformShader(DONUT_MAKE_PLATFORM_SHADER(g_forward_vs_buffer_loads),
         nullptr, vertexShaderDesc);
 
+    m_thinGBufferPixelShader = m_shaderFactory->CreateStaticPlatformShader(DONUT_MAKE_PLATFORM_SHADER(g_NtcThinGBufferPass),
+        nullptr, nvrhi::ShaderType::Pixel);
+
     using namespace donut::engine;
 
     auto viewLayoutDecs = nvrhi::BindingLayoutDesc()
@@ -351,7 +563,8 @@ bool NtcForwardShadingPass::Init()
         .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(FORWARD_BINDING_LIGHT_CONSTANTS))
         .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(FORWARD_BINDING_NTC_PASS_CONSTANTS))
         .addItem(nvrhi::BindingLayoutItem::Sampler(FORWARD_BINDING_MATERIAL_SAMPLER))
-        .addItem(nvrhi::BindingLayoutItem::Sampler(FORWARD_BINDING_STF_SAMPLER));
+        .addItem(nvrhi::BindingLayoutItem::Sampler(FORWARD_BINDING_STF_SAMPLER))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_UAV(FORWARD_BINDING_MIP_REQUESTS_UAV));
 
     m_shadingBindingLayout = m_device->createBindingLayout(shadingLayoutDecs);
 
@@ -370,6 +583,21 @@ bool NtcForwardShadingPass::Init()
 
     m_materialBindingLayout = m_device->createBindingLayout(materialLayoutDesc);
 
+    // The bindless table aliases all register spaces onto the same descriptors on DX12,
+    // and each space is a separate binding in one descriptor set on Vulkan
+    auto bindlessMaterialLayoutDesc = nvrhi::BindlessLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Pixel | nvrhi::ShaderType::Compute)
+        .setMaxCapacity(g_maxBindlessMaterials * NTC_BINDLESS_DESCRIPTORS_PER_MATERIAL)
+        .addRegisterSpace(nvrhi::BindingLayoutItem::ConstantBuffer(FORWARD_SPACE_BINDLESS_MATERIAL_CONSTANTS))
+        .addRegisterSpace(nvrhi::BindingLayoutItem::ConstantBuffer(FORWARD_SPACE_BINDLESS_NTC_CONSTANTS))
+        .addRegisterSpace(nvrhi::BindingLayoutItem::RawBuffer_SRV(FORWARD_SPACE_BINDLESS_BUFFERS));
+
+    m_bindlessMaterialLayout = m_device->createBindlessLayout(bindlessMaterialLayoutDesc);
+    if (m_bindlessMaterialLayout)
+        m_bindlessMaterialTable = m_device->createDescriptorTable(m_bindlessMaterialLayout);
+    if (!m_bindlessMaterialTable)
+        m_bindlessMaterialLayout = nullptr;
+
     if (m_device->queryFeatureSupport(nvrhi::Feature::SamplerFeedback))
     {
         auto materialLayoutFeedbackDesc = nvrhi::BindingLayoutDesc()
@@ -395,13 +623,14 @@ bool NtcForwardShadingPass::Init()
         m_materialBindingLayoutFeedback = m_device->createBindingLayout(materialLayoutFeedbackDesc);
     }
 
+    // The pixel shaders read the material index from the push constants in bindless mode
     auto inputBindingLayoutDesc = nvrhi::BindingLayoutDesc()
-        .setVisibility(nvrhi::ShaderType::Vertex)
+        .setVisibility(nvrhi::ShaderType::Vertex | nvrhi::ShaderType::Pixel)
         .setRegisterSpace(FORWARD_SPACE_INPUT)
         .setRegisterSpaceIsDescriptorSet(true)
         .addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(FORWARD_BINDING_INSTANCE_BUFFER))
         .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(FORWARD_BINDING_VERTEX_BUFFER))
-        .addItem(nvrhi::BindingLayoutItem::PushConstants(FORWARD_BINDING_PUSH_CONSTANTS, sizeof(ForwardPushConstants)));
+        .addItem(nvrhi::BindingLayoutItem::PushConstants(FORWARD_BINDING_PUSH_CONSTANTS, sizeof(NtcForwardPushConstants)));
         
     m_inputBindingLayout = m_device->createBindingLayout(inputBindingLayoutDesc);
 
@@ -413,6 +642,15 @@ bool NtcForwardShadingPass::Init()
     m_passConstants = m_device->createBuffer(nvrhi::utils::CreateVolatileConstantBufferDesc(
         sizeof(NtcForwardShadingPassConstants), "NtcForwardShadingPassConstants", numConstantBufferVersions));
 
+    // Starts with no requests, the material loader clears the buffer after reading it
+    m_mipRequests = m_device->createBuffer(nvrhi::BufferDesc()
+        .setByteSize(NTC_MAX_MIP_REQUEST_SLOTS * sizeof(uint32_t))
+        .setCanHaveRawViews(true)
+        .setCanHaveUAVs(true)
+        .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+        .setKeepInitialState(true)
+        .setDebugName("Mip requests"));
+
     auto viewBindingSetDesc = nvrhi::BindingSetDesc()
         .addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_VIEW_CONSTANTS, m_viewConstants));
 
@@ -427,7 +665,8 @@ bool NtcForwardShadingPass::Init()
         .addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_LIGHT_CONSTANTS, m_lightConstants))
         .addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_NTC_PASS_CONSTANTS, m_passConstants))
         .addItem(nvrhi::BindingSetItem::Sampler(FORWARD_BINDING_MATERIAL_SAMPLER, m_commonPasses->m_AnisotropicWrapSampler))
-        .addItem(nvrhi::BindingSetItem::Sampler(FORWARD_BINDING_STF_SAMPLER, m_stfSampler));
+        .addItem(nvrhi::BindingSetItem::Sampler(FORWARD_BINDING_STF_SAMPLER, m_stfSampler))
+        .addItem(nvrhi::BindingSetItem::RawBuffer_UAV(FORWARD_BINDING_MIP_REQUESTS_UAV, m_mipRequests));
 
     m_shadingBindingSet = m_device->createBindingSet(shadingBindingSetDesc, m_shadingBindingLayout);
 
@@ -440,9 +679,30 @@ void NtcForwardShadingPass::ResetBindingCache()
 {
     m_materialBindingSets.clear();
     m_materialBindingSetsFeedback.clear();
+
+    // The frames in flight may still read the descriptors of these slots, so they are not overwritten until
+    // those frames are finished, see PreparePass
+    for (auto const& [material, materialIndex] : m_bindlessMaterialIndices)
+        m_retiredBindlessSlots.push_back({ materialIndex, m_frameIndex });
+    m_bindlessMaterialIndices.clear();
+    m_thinGBufferMaterials.clear();
     m_legacyMaterialBindingCache->Clear();
 }
 
+void NtcForwardShadingPass::ResetMaterialBindings(NtcMaterial const* material)
+{
+    m_materialBindingSets.erase(material);
+    m_materialBindingSetsFeedback.erase(material);
+
+    auto found = m_bindlessMaterialIndices.find(material);
+    if (found != m_bindlessMaterialIndices.end())
+    {
+        m_retiredBindlessSlots.push_back({ found->second, m_frameIndex });
+        m_bindlessMaterialIndices.erase(found);
+    }
+    m_thinGBufferMaterials.erase(material);
+}
+
 void NtcForwardShadingPass::PrepareLights(
     nvrhi::ICommandList* commandList,
     const std::vector<std::shared_ptr<donut::engine::Light>>& lights,
@@ -473,16 +733,47 @@ donut::engine::ViewType::Enum NtcForwardShadingPass::GetSupportedViewTypes() con
 }
 
 void NtcForwardShadingPass::PreparePass(Context& context, nvrhi::ICommandList* commandList, uint32_t frameIndex,
-    bool useSTF, int stfFilterMode, bool hasDepthPrepass, NtcMode ntcMode, float feedbackThreshold)
+    bool useSTF, int stfFilterMode, bool hasDepthPrepass, NtcMode ntcMode, float feedbackThreshold,
+    bool bindlessMaterials, bool quadSharedInference, bool deferredShading)
 {
+    m_frameIndex = frameIndex;
+    while (!m_retiredBindlessSlots.empty() &&
+        frameIndex - m_retiredBindlessSlots.front().frameIndex > m_framesInFlight)
+    {
+        m_freeBindlessSlots.push_back(m_retiredBindlessSlots.front().slot);
+        m_retiredBindlessSlots.pop_front();
+    }
+    m_thinGBufferMaterials.clear();
+
     NtcForwardShadingPassConstants passConstants {};
     passConstants.frameIndex = frameIndex;
     passConstants.stfFilterMode = stfFilterMode;
     passConstants.feedbackThreshold = feedbackThreshold;
     commandList->writeBuffer(m_passConstants, &passConstants, sizeof(passConstants));
+
+    // The mip requests are only combined with atomics, so the draws and dispatches don't need to wait for each other
+    commandList->setEnableUavBarriersForBuffer(m_mipRequests, false);
+
     context.keyTemplate.hasDepthPrepass = hasDepthPrepass;
     context.keyTemplate.ntcMode = ntcMode;
     context.keyTemplate.useSTF = useSTF;
+    context.keyTemplate.bindlessMaterials = bindlessMaterials && IsBindlessMaterialsSupported()
+        && (ntcMode == NtcMode::InferenceOnSample || ntcMode == NtcMode::Hybrid);
+    context.keyTemplate.quadSharedInference = quadSharedInference;
+    context.deferredShading = deferredShading && IsBindlessMaterialsSupported()
+        && (ntcMode == NtcMode::InferenceOnSample || ntcMode == NtcMode::Hybrid);
+    context.thinGBufferPass = false;
+    context.alphaTestPrepass = false;
+}
+
+bool NtcForwardShadingPass::UsesAlphaTestInference(NtcMaterial const& material, NtcMode ntcMode)
+{
+    if (ntcMode == NtcMode::Hybrid)
+        ntcMode = material.hybridTranscoded ? NtcMode::InferenceOnLoad : NtcMode::InferenceOnSample;
+
+    return ntcMode == NtcMode::InferenceOnSample &&
+        material.domain == donut::engine::MaterialDomain::AlphaTested &&
+        material.networkVersion != NTC_NETWORK_UNKNOWN;
 }
 
 void NtcForwardShadingPass::SetupView(
@@ -512,17 +803,41 @@ bool NtcForwardShadingPass::SetupMaterial(
 
     auto ntcMaterial = static_cast<NtcMaterial const*>(material);
 
+    if (context.alphaTestPrepass && !UsesAlphaTestInference(*ntcMaterial, context.keyTemplate.ntcMode))
+        return false;
+
     PipelineKey key = context.keyTemplate;
     key.cullMode = cullMode;
     key.domain = material->domain;
     key.networkVersion = ntcMaterial->networkVersion;
     key.weightType = ntcMaterial->weightType;
+    if (key.ntcMode == NtcMode::Hybrid)
+        key.ntcMode = ntcMaterial->hybridTranscoded ? NtcMode::InferenceOnLoad : NtcMode::InferenceOnSample;
+
+    // With deferred shading, every material is drawn either into the thin G-buffer or in the forward pass
+    bool const deferredMaterial = context.deferredShading && key.ntcMode == NtcMode::InferenceOnSample
+        && key.domain == donut::engine::MaterialDomain::Opaque;
+    if (deferredMaterial != context.thinGBufferPass)
+        return false;
+    key.thinGBuffer = context.thinGBufferPass;
+    key.alphaTestPrepass = context.alphaTestPrepass;
 
     nvrhi::IBindingSet* materialBindingSet = nullptr;
     switch(key.ntcMode)
     {
         case NtcMode::InferenceOnSample:
-            materialBindingSet = GetOrCreateMaterialBindingSet(ntcMaterial);
+            if (key.bindlessMaterials || key.thinGBuffer)
+            {
+                // All materials share the table, so consecutive draws only differ in the push constants
+                // unless the pipeline changes
+                if (!GetOrCreateBindlessMaterialIndex(ntcMaterial, context.materialIndex))
+                    return false;
+                if (key.thinGBuffer)
+                    m_thinGBufferMaterials.insert(ntcMaterial);
+                materialBindingSet = m_bindlessMaterialTable;
+            }
+            else
+                materialBindingSet = GetOrCreateMaterialBindingSet(ntcMaterial);
             break;
 
         case NtcMode::InferenceOnLoad:
@@ -573,7 +888,7 @@ nvrhi::BindingSetHandle NtcForwardShadingPass::CreateInputBindingSet(const donut
     auto bindingSetDesc = nvrhi::BindingSetDesc()
         .addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(FORWARD_BINDING_INSTANCE_BUFFER, bufferGroup->instanceBuffer))
         .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(FORWARD_BINDING_VERTEX_BUFFER, bufferGroup->vertexBuffer))
-        .addItem(nvrhi::BindingSetItem::PushConstants(FORWARD_BINDING_PUSH_CONSTANTS, sizeof(ForwardPushConstants)));
+        .addItem(nvrhi::BindingSetItem::PushConstants(FORWARD_BINDING_PUSH_CONSTANTS, sizeof(NtcForwardPushConstants)));
 
     return m_device->createBindingSet(bindingSetDesc, m_inputBindingLayout);
 }
@@ -599,13 +914,14 @@ void NtcForwardShadingPass::SetPushConstants(
 {
     auto& context = static_cast<Context&>(abstractContext);
 
-    ForwardPushConstants constants;
+    NtcForwardPushConstants constants;
     constants.startInstanceLocation = args.startInstanceLocation;
     constants.startVertexLocation = args.startVertexLocation;
     constants.positionOffset = context.positionOffset;
     constants.texCoordOffset = context.texCoordOffset;
     constants.normalOffset = context.normalOffset;
     constants.tangentOffset = context.tangentOffset;
+    constants.materialIndex = context.materialIndex;
 
     commandList->setPushConstants(&constants, sizeof(constants));
 
@@ -11,6 +11,8 @@
  */
 
 #include <donut/render/ForwardShadingPass.h>
+#include <deque>
+#include <unordered_set>
 
 struct NtcMaterial;
 
@@ -18,7 +20,8 @@ enum class NtcMode
 {
     InferenceOnSample,
     InferenceOnLoad,
-    InferenceOnFeedback
+    InferenceOnFeedback,
+    Hybrid // Inference on Load or Sample per material, see NtcMaterial::hybridTranscoded
 };
 
 class NtcForwardShadingPass : public donut::render::IGeometryPass
@@ -35,6 +38,10 @@ protected:
         bool hasDepthPrepass = false;
         NtcMode ntcMode = NtcMode::InferenceOnSample;
         bool useSTF = false;
+        bool bindlessMaterials = false;
+        bool quadSharedInference = false;
+        bool thinGBuffer = false;
+        bool alphaTestPrepass = false;
 
         bool operator==(PipelineKey const& other) const
         {
@@ -46,7 +53,11 @@ protected:
                    reverseDepth == other.reverseDepth &&
                    hasDepthPrepass == other.hasDepthPrepass &&
                    ntcMode == other.ntcMode &&
-                   useSTF == other.useSTF;
+                   useSTF == other.useSTF &&
+                   bindlessMaterials == other.bindlessMaterials &&
+                   quadSharedInference == other.quadSharedInference &&
+                   thinGBuffer == other.thinGBuffer &&
+                   alphaTestPrepass == other.alphaTestPrepass;
         }
 
         bool operator!=(PipelineKey const& other) const
@@ -69,6 +80,10 @@ protected:
             nvrhi::hash_combine(hash, s.hasDepthPrepass);
             nvrhi::hash_combine(hash, uint32_t(s.ntcMode));
             nvrhi::hash_combine(hash, s.useSTF);
+            nvrhi::hash_combine(hash, s.bindlessMaterials);
+            nvrhi::hash_combine(hash, s.quadSharedInference);
+            nvrhi::hash_combine(hash, s.thinGBuffer);
+            nvrhi::hash_combine(hash, s.alphaTestPrepass);
             return hash;
         }
     };
@@ -85,6 +100,7 @@ protected:
     nvrhi::BufferHandle m_viewConstants;
     nvrhi::BufferHandle m_lightConstants;
     nvrhi::BufferHandle m_passConstants;
+    nvrhi::BufferHandle m_mipRequests; // One uint per streamed material, see NTC_MAX_MIP_REQUEST_SLOTS
     nvrhi::SamplerHandle m_stfSampler;
     
     nvrhi::BindingLayoutHandle m_materialBindingLayout;
@@ -95,15 +111,40 @@ protected:
     std::unordered_map<NtcMaterial const*, nvrhi::BindingSetHandle> m_materialBindingSetsFeedback;
     std::unordered_map<const donut::engine::BufferGroup*, nvrhi::BindingSetHandle> m_inputBindingSets;
 
+    // Bindless material table for Inference on Sample, see NtcForwardShadingPassConstants.h for the layout
+    nvrhi::BindingLayoutHandle m_bindlessMaterialLayout;
+    nvrhi::DescriptorTableHandle m_bindlessMaterialTable;
+    std::unordered_map<NtcMaterial const*, uint32_t> m_bindlessMaterialIndices;
+    uint32_t m_bindlessMaterialCapacity = 0;
+    uint32_t m_bindlessMaterialSlotCount = 0; // Highest used index + 1
+
+    // The slots released by ResetBindingCache and ResetMaterialBindings are only reused after the frames that read them are finished
+    struct RetiredBindlessSlot
+    {
+        uint32_t slot;
+        uint32_t frameIndex;
+    };
+    std::deque<RetiredBindlessSlot> m_retiredBindlessSlots;
+    std::vector<uint32_t> m_freeBindlessSlots;
+    uint32_t m_framesInFlight = 0;
+    uint32_t m_frameIndex = 0;
+
+    // Materials drawn into the thin G-buffer since the last PreparePass, the only ones that can have deferred pixels
+    std::unordered_set<NtcMaterial const*> m_thinGBufferMaterials;
+
     nvrhi::InputLayoutHandle m_inputLayout;
     nvrhi::ShaderHandle m_vertexShader;
+    nvrhi::ShaderHandle m_thinGBufferPixelShader;
     std::unordered_map<PipelineKey, nvrhi::ShaderHandle, PipelineKeyHash> m_pixelShaders;
     std::unordered_map<PipelineKey, nvrhi::GraphicsPipelineHandle, PipelineKeyHash> m_pipelines;
 
+    static void NormalizePipelineKey(PipelineKey& key);
     nvrhi::ShaderHandle GetOrCreatePixelShader(PipelineKey key);
     nvrhi::GraphicsPipelineHandle GetOrCreatePipeline(PipelineKey key, nvrhi::IFramebuffer* framebuffer);
+    bool FillPipelineDesc(PipelineKey const& key, nvrhi::GraphicsPipelineDesc& pipelineDesc);
     nvrhi::BindingSetHandle GetOrCreateMaterialBindingSet(NtcMaterial const* material);
     nvrhi::BindingSetHandle GetOrCreateMaterialBindingSetFeedback(NtcMaterial const* material);
+    bool GetOrCreateBindlessMaterialIndex(NtcMaterial const* material, uint32_t& outIndex);
     nvrhi::BindingSetHandle CreateInputBindingSet(const donut::engine::BufferGroup* bufferGroup);
     nvrhi::BindingSetHandle GetOrCreateInputBindingSet(const donut::engine::BufferGroup* bufferGroup);
     std::shared_ptr<donut::engine::MaterialBindingCache> CreateLegacyMaterialBindingCache(donut::engine::CommonRenderPasses& commonPasses);
@@ -115,6 +156,16 @@ public:
     public:
         PipelineKey keyTemplate;
         nvrhi::BindingSetHandle inputBindingSet;
+        uint32_t materialIndex = 0; // In the bindless material table
+
+        // Opaque Inference on Sample materials are drawn into the thin G-buffer instead of the forward pass,
+        // see NtcDeferredShadingPass. Use a copy of the forward context with thinGBufferPass set for that.
+        bool deferredShading = false;
+        bool thinGBufferPass = false;
+
+        // Only draws the materials selected by UsesAlphaTestInference(...) into the depth pre-pass,
+        // evaluating their opacity with inference. Use a copy of the forward context with this set.
+        bool alphaTestPrepass = false;
         
         uint32_t positionOffset = 0;
         uint32_t texCoordOffset = 0;
@@ -130,9 +181,14 @@ public:
         , m_shaderFactory(shaderFactory)
     { }
 
-    bool Init();
+    // 'framesInFlight' is the number of frames that the GPU may still be rendering when a new frame is prepared
+    bool Init(uint32_t framesInFlight);
     void ResetBindingCache();
 
+    // Drops the binding sets and the bindless slot of one material, so that they are created again
+    // with its current buffers when it's drawn next
+    void ResetMaterialBindings(NtcMaterial const* material);
+
     void PrepareLights(
         nvrhi::ICommandList* commandList,
         const std::vector<std::shared_ptr<donut::engine::Light>>& lights,
@@ -140,7 +196,44 @@ public:
         dm::float3 ambientColorBottom);
 
     void PreparePass(Context& context, nvrhi::ICommandList* commandList, uint32_t frameIndex,
-        bool useSTF, int stfFilterMode, bool hasDepthPrepass, NtcMode ntcMode, float feedbackThreshold);
+        bool useSTF, int stfFilterMode, bool hasDepthPrepass, NtcMode ntcMode, float feedbackThreshold,
+        bool bindlessMaterials, bool quadSharedInference, bool deferredShading);
+
+    bool IsBindlessMaterialsSupported() const { return m_bindlessMaterialLayout != nullptr; }
+
+    // Returns true for the alpha tested materials that are drawn with Inference on Sample in the given mode.
+    // With alpha test inference, the depth pre-pass draws them with this pass instead of a transcoded opacity texture.
+    static bool UsesAlphaTestInference(NtcMaterial const& material, NtcMode ntcMode);
+
+    // Resources shared with NtcDeferredShadingPass
+    nvrhi::IBindingLayout* GetBindlessMaterialLayout() const { return m_bindlessMaterialLayout; }
+    nvrhi::IDescriptorTable* GetBindlessMaterialTable() const { return m_bindlessMaterialTable; }
+    std::unordered_map<NtcMaterial const*, uint32_t> const& GetBindlessMaterialIndices() const
+        { return m_bindlessMaterialIndices; }
+    // All indices in GetBindlessMaterialIndices() are below this, the slots are not contiguous after a reset
+    uint32_t GetBindlessMaterialSlotCount() const { return m_bindlessMaterialSlotCount; }
+    std::unordered_set<NtcMaterial const*> const& GetThinGBufferMaterials() const { return m_thinGBufferMaterials; }
+    nvrhi::IBuffer* GetViewConstants() const { return m_viewConstants; }
+    nvrhi::IBuffer* GetLightConstants() const { return m_lightConstants; }
+    nvrhi::IBuffer* GetPassConstants() const { return m_passConstants; }
+
+    // Finest mip levels sampled by the streamed materials, read by NtcMaterialLoader::UpdateLatentResidency(...)
+    nvrhi::IBuffer* GetMipRequestBuffer() const { return m_mipRequests; }
+
+    struct PipelineWarmUpDesc
+    {
+        std::vector<NtcMaterial const*> materials;
+        std::vector<NtcMode> ntcModes;
+        bool frontCounterClockwise = false;
+        bool reverseDepth = false;
+        bool bindlessMaterials = false;
+        uint32_t threadCount = 1;
+    };
+
+    // Creates all pipelines that the materials can use in the given modes, with every combination of
+    // the depth pre-pass, STF, bindless and quad-shared inference settings, so that switching these in the UI doesn't stall.
+    // Returns the number of pipelines created. Call from the rendering thread, outside of command list recording.
+    uint32_t PrecompilePipelines(PipelineWarmUpDesc const& desc, nvrhi::IFramebuffer* framebuffer);
 
     // IGeometryPass implementation
 
@@ -27,125 +27,23 @@ typedef NtcNetworkParams<NETWORK_VERSION> NtcParams;
 #include "NtcForwardShadingPassConstants.h"
 #include "NtcChannelMapping.h"
 
-DECLARE_CBUFFER(MaterialConstants, g_Material, FORWARD_BINDING_MATERIAL_CONSTANTS, FORWARD_SPACE_MATERIAL);
 DECLARE_CBUFFER(ForwardShadingViewConstants, g_ForwardView, FORWARD_BINDING_VIEW_CONSTANTS, FORWARD_SPACE_VIEW);
 DECLARE_CBUFFER(ForwardShadingLightConstants, g_ForwardLight, FORWARD_BINDING_LIGHT_CONSTANTS, FORWARD_SPACE_SHADING);
 DECLARE_CBUFFER(NtcForwardShadingPassConstants, g_Pass, FORWARD_BINDING_NTC_PASS_CONSTANTS, FORWARD_SPACE_SHADING);
+RWByteAddressBuffer u_MipRequests : REGISTER_UAV(FORWARD_BINDING_MIP_REQUESTS_UAV, FORWARD_SPACE_SHADING);
 
-#if NETWORK_VERSION != NTC_NETWORK_UNKNOWN
-
-DECLARE_CBUFFER(NtcTextureSetConstants, g_NtcMaterial, FORWARD_BINDING_NTC_MATERIAL_CONSTANTS, FORWARD_SPACE_MATERIAL);
-ByteAddressBuffer t_InputFile    : REGISTER_SRV(FORWARD_BINDING_NTC_LATENTS_BUFFER, FORWARD_SPACE_MATERIAL);
-ByteAddressBuffer t_WeightBuffer : REGISTER_SRV(FORWARD_BINDING_NTC_WEIGHTS_BUFFER, FORWARD_SPACE_MATERIAL);
-
-void GetSamplePositionWithSTF(inout HashBasedRNG rng, float2 uv, out int2 texel, out int mipLevel)
-{
-    float4 random = rng.NextFloat4();
-    STF_SamplerState sampler = STF_SamplerState::Create(random);
-    sampler.SetAnisoMethod(STF_ANISO_LOD_METHOD_DEFAULT);
-    sampler.SetFilterType(g_Pass.stfFilterMode);
-
-    const int2 textureSize = NtcGetTextureDimensions(g_NtcMaterial, 0);
-    const int mipLevels = NtcGetTextureMipLevels(g_NtcMaterial);
-    float3 samplePos = sampler.Texture2DGetSamplePos(textureSize.x, textureSize.y, mipLevels, uv);
-    mipLevel = int(samplePos.z);
-
-    const int2 mipSize = NtcGetTextureDimensions(g_NtcMaterial, mipLevel);
-
-    bool border;
-    samplePos.xy = STF_ApplyAddressingMode2D(samplePos.xy, mipSize, STF_ADDRESS_MODE_WRAP, border);
-
-    texel = int2(floor(samplePos.xy * mipSize));
-}
-
-MaterialTextureSample SampleNtcMaterial(uint2 pixelPosition, float2 uv)
-{
-    HashBasedRNG rng = HashBasedRNG::Create2D(pixelPosition, g_Pass.frameIndex);
-
-    // Find out which texel to decompress.
-    int mipLevel;
-    int2 texel;
-    GetSamplePositionWithSTF(rng, uv, texel, mipLevel);
-
-    // The NtcSampleTextureSet... functions can convert all channels to linear color based on metadata stored
-    // in the constant buffer. But that can be relatively slow if not optimized away by the driver.
-    // Since we know the color spaces for all channels in advance, linearize explicitly below.
-    const bool linearizeColorsOnSample = false;
-
-    // Decompress the texel and get all the channels.
-    float channels[NtcParams::OUTPUT_CHANNELS];
-#ifdef USE_COOPVEC
-    #if USE_FP8
-        NtcSampleTextureSet_CoopVec_FP8<NETWORK_VERSION>(g_NtcMaterial, t_InputFile, 0,
-            t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
-    #else
-        NtcSampleTextureSet_CoopVec_Int8<NETWORK_VERSION>(g_NtcMaterial, t_InputFile, 0,
-            t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
-    #endif
-#else
-    NtcSampleTextureSet<NETWORK_VERSION>(g_NtcMaterial, t_InputFile, 0,
-        t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
+#if BINDLESS_MATERIALS
+DECLARE_PUSH_CONSTANTS(NtcForwardPushConstants, g_NtcPush, FORWARD_BINDING_PUSH_CONSTANTS, FORWARD_SPACE_INPUT);
+#define NTC_BINDLESS_MATERIAL_INDEX g_NtcPush.materialIndex
 #endif
 
-    // Initialize the 'textures' object with default values, just in case we miss something below.
-    MaterialTextureSample textures = DefaultMaterialTextures();
-
-    // Distribute the NTC channels into the MaterialTextureSample's fields using a fixed mapping.
-    // The mapping is enforced by the loader, see NtcMaterialLoader.cpp
-    // If some texture channels are not present in the NTC material file, they are replaced with constant values
-    // by the loader.
-    
-    textures.baseOrDiffuse.rgb = float3(
-        channels[CHANNEL_BASE_COLOR + 0],
-        channels[CHANNEL_BASE_COLOR + 1],
-        channels[CHANNEL_BASE_COLOR + 2]);
-
-
-    if (!linearizeColorsOnSample)
-        textures.baseOrDiffuse.rgb = NtcSrgbColorSpace::Decode(textures.baseOrDiffuse.rgb);
-
-    textures.opacity.r = channels[CHANNEL_OPACITY];
+#include "NtcMaterialSampling.hlsli"
 
-    if ((g_Material.flags & MaterialFlags_UseSpecularGlossModel) != 0)
-    {
-        textures.metalRoughOrSpecular.rgb = float3(
-            channels[CHANNEL_SPECULAR_COLOR + 0],
-            channels[CHANNEL_SPECULAR_COLOR + 1],
-            channels[CHANNEL_SPECULAR_COLOR + 2]);
-            
-        if (!linearizeColorsOnSample)
-            textures.metalRoughOrSpecular.rgb = NtcSrgbColorSpace::Decode(textures.metalRoughOrSpecular.rgb);
-        
-        textures.metalRoughOrSpecular.a = channels[CHANNEL_GLOSSINESS];
-    }
-    else
-    {
-        textures.metalRoughOrSpecular.g = channels[CHANNEL_ROUGHNESS];
-        textures.metalRoughOrSpecular.r = channels[CHANNEL_METALNESS];
-    }
 
-    textures.normal.rgb = float3(
-        channels[CHANNEL_NORMAL + 0],
-        channels[CHANNEL_NORMAL + 1],
-        channels[CHANNEL_NORMAL + 2]);
-
-    textures.occlusion.r = channels[CHANNEL_OCCLUSION];
-
-    textures.emissive.rgb = float3(
-        channels[CHANNEL_EMISSIVE + 0],
-        channels[CHANNEL_EMISSIVE + 1],
-        channels[CHANNEL_EMISSIVE + 2]);
-
-    if (!linearizeColorsOnSample)
-        textures.emissive.rgb = NtcSrgbColorSpace::Decode(textures.emissive.rgb);
-    
-    textures.transmission.r = channels[CHANNEL_TRANSMISSION];
-    
-    return textures;
-}
+// Run the depth test before the shader when nothing is discarded, so that occluded pixels skip inference
+#if !ENABLE_ALPHA_TEST
+[earlydepthstencil]
 #endif
-
-
 void main(
     in float4 i_position : SV_Position,
     in SceneVertex i_vtx,
@@ -159,7 +57,7 @@ void main(
 #if NETWORK_VERSION == NTC_NETWORK_UNKNOWN
     MaterialTextureSample textures = DefaultMaterialTextures();
 #else
-    MaterialTextureSample textures = SampleNtcMaterial(int2(i_position.xy), i_vtx.texCoord);
+    MaterialTextureSample textures = SampleNtcMaterial(int2(i_position.xy), i_vtx.texCoord, 0, 0);
 #endif
 
     // Force the MetalnessInRedChannel flag because it might not be set in the material constants
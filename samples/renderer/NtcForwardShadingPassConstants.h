@@ -12,6 +12,8 @@
 
  #ifndef NTC_FORWARD_SHADING_PASS_CONSTANTS_H
  #define NTC_FORWARD_SHADING_PASS_CONSTANTS_H
+
+#include "libntc/shaders/InferenceConstants.h"
  
 // in FORWARD_SPACE_MATERIAL
 #define FORWARD_BINDING_NTC_MATERIAL_CONSTANTS 4
@@ -28,6 +30,142 @@
 // in FORWARD_SPACE_SHADING
 #define FORWARD_BINDING_NTC_PASS_CONSTANTS 5
 #define FORWARD_BINDING_STF_SAMPLER 1
+#define FORWARD_BINDING_MIP_REQUESTS_UAV 0
+
+// Bindless material table, replaces the material binding set when BINDLESS_MATERIALS=1.
+// The register spaces must match the declarations in NtcForwardShadingPass.hlsl
+#define FORWARD_SPACE_BINDLESS_MATERIAL_CONSTANTS 4
+#define FORWARD_SPACE_BINDLESS_NTC_CONSTANTS 5
+#define FORWARD_SPACE_BINDLESS_BUFFERS 6
+// Descriptors of one material in the table, starting at materialIndex * NTC_BINDLESS_DESCRIPTORS_PER_MATERIAL
+#define NTC_BINDLESS_DESCRIPTORS_PER_MATERIAL 4
+#define NTC_BINDLESS_MATERIAL_CONSTANTS 0
+#define NTC_BINDLESS_NTC_CONSTANTS 1
+#define NTC_BINDLESS_LATENTS_BUFFER 2
+#define NTC_BINDLESS_WEIGHTS_BUFFER 3
+
+// Thin G-buffer written for the deferred NTC shading path, see NtcThinGBuffer.hlsli for the encoding
+#define NTC_GBUFFER_MATERIAL_MASK 0x00ffffff // materialIndex + 1, 0 means the pixel is not shaded by the deferred pass
+#define NTC_GBUFFER_FRONT_FACE 0x40000000
+#define NTC_GBUFFER_TANGENT_FLIP 0x80000000
+
+// Deferred shading compute passes, see NtcDeferredShadingPass.cpp. The bindless material table is bound
+// as the first binding set, same as in the forward pass.
+#define DEFERRED_SPACE_PASS 1
+#define DEFERRED_BINDING_CONSTANTS 0
+#define DEFERRED_BINDING_VIEW_CONSTANTS 1
+#define DEFERRED_BINDING_LIGHT_CONSTANTS 2
+#define DEFERRED_BINDING_NTC_PASS_CONSTANTS 3
+#define DEFERRED_BINDING_PUSH_CONSTANTS 4
+#define DEFERRED_BINDING_GBUFFER0 0
+#define DEFERRED_BINDING_GBUFFER1 1
+#define DEFERRED_BINDING_DEPTH 2
+#define DEFERRED_BINDING_MATERIAL_BINS 3 // SRV in the shading pass, UAV in the binning passes
+#define DEFERRED_BINDING_PIXEL_LIST 4    // Same
+#define DEFERRED_BINDING_MATERIAL_CACHE_HISTORY 5
+#define DEFERRED_BINDING_MATERIAL_CACHE_HISTORY_KEYS 6
+#define DEFERRED_BINDING_INDIRECT_ARGS 0
+#define DEFERRED_BINDING_COLOR_OUTPUT 1
+#define DEFERRED_BINDING_MIP_REQUESTS_UAV 2
+#define DEFERRED_BINDING_MATERIAL_CACHE_OUTPUT 3
+#define DEFERRED_BINDING_MATERIAL_CACHE_OUTPUT_KEYS 4
+#define DEFERRED_BINNING_GROUP_SIZE 8    // 8x8 pixels for the count and scatter passes
+#define DEFERRED_SCAN_GROUP_SIZE 256
+#define DEFERRED_SHADING_GROUP_SIZE 64
+
+#define DEFERRED_BINNING_COUNT 0   // Counts the pixels of every material
+#define DEFERRED_BINNING_SCAN 1    // Allocates the bins and writes the indirect arguments
+#define DEFERRED_BINNING_SCATTER 2 // Writes the pixels into their bins
+
+// Temporal material cache of the deferred shading pass, see NtcMaterialCache.hlsli
+#define NTC_MATERIAL_CACHE_OFF 0
+#define NTC_MATERIAL_CACHE_WRITE 1 // The history is not valid, only store the material textures of this frame
+#define NTC_MATERIAL_CACHE_REUSE 2
+
+// Per-material bin in the material bins buffer, 16 bytes each. The pixels that run inference are stored
+// at the start of the bin, and the pixels that reuse the material cache at the end.
+struct NtcDeferredMaterialBin
+{
+    uint pixelCount;
+    uint firstPixel; // In the pixel list
+    uint inferenceCursor; // Number of pixels that run inference after the scatter pass
+    uint reuseCursor;
+};
+
+struct NtcDeferredShadingConstants
+{
+    // Reprojection into the previous frame for the material cache, both views include the jitter offsets
+    float4x4 matClipToWorld;
+    float4x4 matWorldToPrevClip;
+    float2 windowToClipScale;
+    float2 windowToClipBias;
+    float2 prevClipToWindowScale;
+    float2 prevClipToWindowBias;
+
+    uint2 viewportOrigin;
+    uint2 viewportSize;
+    uint materialCount;
+    uint materialCache; // NTC_MATERIAL_CACHE_...
+    uint materialCacheRefreshPeriod;
+    uint frameIndex;
+    float materialCacheDepthTolerance;
+    uint padding[3];
+};
+
+struct NtcDeferredPushConstants
+{
+    uint materialIndex;
+};
+
+// Latent streaming: every streamed material has a slot in the mip request buffer, where the shading passes
+// write the finest mip level they sampled with InterlockedMin. The buffer is cleared to ~0 after every frame.
+#define NTC_NO_MIP_REQUEST_SLOT 0xffffffff
+#define NTC_MAX_MIP_REQUEST_SLOTS 65536
+
+// Per-material NTC constants, written by NtcMaterialLoader. With latent streaming, only the mip levels
+// starting at firstResidentMip have latents in memory, and the samples of finer mips are clamped to it.
+struct NtcMaterialConstants
+{
+    NtcTextureSetConstants textureSet;
+    int firstResidentMip;
+    uint mipRequestSlot;
+    uint padding[2];
+};
+
+// Fused transcoding pass of the material loader, see NtcTranscodePass.cpp. It decompresses the texels of a batch
+// of texture regions and encodes them into BCn blocks in the same dispatch, without the staging color texture.
+#define TRANSCODE_BINDING_NTC_MATERIAL_CONSTANTS 0
+#define TRANSCODE_BINDING_PUSH_CONSTANTS 1
+#define TRANSCODE_BINDING_NTC_LATENTS_BUFFER 0
+#define TRANSCODE_BINDING_NTC_WEIGHTS_BUFFER 1
+#define TRANSCODE_BINDING_JOB_CONSTANTS 2
+#define TRANSCODE_SPACE_BLOCKS_OUTPUT 1 // Descriptor table, see NtcTranscodePass::WriteDescriptor
+#define TRANSCODE_MAX_BATCH_JOBS 256
+#define TRANSCODE_GROUP_SIZE 8 // 8x8 texels, or 2x2 blocks
+
+#define TRANSCODE_FORMAT_BC1 1
+#define TRANSCODE_FORMAT_BC4 4
+#define TRANSCODE_FORMAT_BC5 5
+
+struct NtcTranscodeJobConstants
+{
+    int2 srcOrigin; // First texel of the region in the mip level
+    int2 srcSize;   // The texels of the edge blocks outside of the region are clamped to it
+    uint2 dstBlockOrigin;
+    uint firstChannel;
+    uint outputIndex; // Block texture in the descriptor table
+};
+
+struct NtcTranscodeBatchConstants
+{
+    NtcTranscodeJobConstants jobs[TRANSCODE_MAX_BATCH_JOBS]; // Indexed by the group Z coordinate
+};
+
+struct NtcTranscodePushConstants
+{
+    int mipLevel;
+    uint padding;
+};
 
 struct NtcForwardShadingPassConstants
 {
@@ -36,4 +174,16 @@ struct NtcForwardShadingPassConstants
     float feedbackThreshold;
 };
 
+// Extends ForwardPushConstants used by the vertex shader with the index of the material in the bindless table
+struct NtcForwardPushConstants
+{
+    uint startInstanceLocation;
+    uint startVertexLocation;
+    uint positionOffset;
+    uint texCoordOffset;
+    uint normalOffset;
+    uint tangentOffset;
+    uint materialIndex;
+};
+
 #endif // NTC_FORWARD_SHADING_PASS_CONSTANTS_H
\ No newline at end of file
@@ -24,12 +24,10 @@ struct TextureTranscodeTask
     ntc::ITextureMetadata const* metadata = nullptr;
     ntc::BlockCompressedFormat bcFormat = ntc::BlockCompressedFormat::None;
     nvrhi::TextureHandle color;
-    nvrhi::TextureHandle blocks;
     nvrhi::TextureHandle compressed;
     nvrhi::Format nvrhiBcFormat = nvrhi::Format::UNKNOWN;
     int firstChannel = 0;
     int numChannels = 0;
-    int mipZeroDescriptor = 0;
     bool sRGB = false;
     char const* name = nullptr;
     std::shared_ptr<donut::engine::LoadedTexture> NtcMaterial::* pMaterialTexture = nullptr;
@@ -38,7 +36,6 @@ struct TextureTranscodeTask
     void ReleaseTextures()
     {
         color = nullptr;
-        blocks = nullptr;
         compressed = nullptr;
     }
 };
@@ -46,13 +43,17 @@ struct TextureTranscodeTask
 struct NtcMaterial : public donut::engine::Material
 {
     nvrhi::BufferHandle ntcConstantBuffer;
-    nvrhi::BufferHandle ntcWeightsBuffer;
-    nvrhi::BufferHandle ntcLatentsBuffer;
+    nvrhi::BufferHandle ntcWeightsBuffer; // Pooled, may be shared with other materials, see ntcWeightsRange
+    nvrhi::BufferRange ntcWeightsRange = nvrhi::EntireBuffer;
+    nvrhi::BufferHandle ntcLatentsBuffer; // Pooled with latent streaming, see ntcLatentsRange
+    nvrhi::BufferRange ntcLatentsRange = nvrhi::EntireBuffer;
     ntc::StreamRange latentStreamRange;
     int networkVersion = 0;
     int weightType = 0;
     size_t transcodedMemorySize = 0;
     size_t ntcMemorySize = 0;
+    bool hybridTranscoded = false; // Rendered with the transcoded textures in the hybrid NTC mode
+    uint64_t sourceHash = 0; // Identifies the NTC file data across runs, for the feedback tile cache
 
     nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> baseOrDiffuseTextureFeedback;
     nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> metalRoughOrSpecularTextureFeedback;
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Temporal material cache of the deferred shading pass. Every shaded pixel stores its decompressed material
+// textures and a key made of the material index, the view depth, the number of frames since the textures were
+// decompressed, and the texel and MIP level that STF selected. On the next frame, the binning pass predicts
+// which pixels can reuse the textures: the surface point is found in the previous frame's cache with the same
+// material, a similar depth, and an age below the refresh period, and the pixel is not in the rotating subset
+// that is refreshed on every frame. The shading pass then reuses the textures only when STF selects the same
+// texel and MIP level on this frame, so the stochastic filtering sees the same samples as without the cache,
+// and runs inference for the other pixels.
+// The including shader declares g_Const (NtcDeferredShadingConstants) and t_MaterialCacheHistoryKeys.
+
+#ifndef NTC_MATERIAL_CACHE_HLSLI
+#define NTC_MATERIAL_CACHE_HLSLI
+
+#include "NtcForwardShadingPassConstants.h"
+
+// Key layout: x = material index + 1 (12 bits), age (4 bits), view depth (fp16); y = texel X and Y (14 bits each)
+// and MIP level (4 bits). A zero key doesn't match any material.
+#define NTC_MATERIAL_CACHE_INDEX_MASK 0xfff
+#define NTC_MATERIAL_CACHE_AGE_SHIFT 12
+#define NTC_MATERIAL_CACHE_AGE_MASK 0xf
+
+uint EncodeMaterialCacheSample(int2 texel, int mipLevel)
+{
+    return (uint(texel.x) & 0x3fff) | ((uint(texel.y) & 0x3fff) << 14) | (uint(mipLevel) << 28);
+}
+
+// Materials with larger indices don't fit into the key and are never reused.
+// The age is the number of frames for which the textures have been reused, 0 after inference.
+uint2 EncodeMaterialCacheKey(uint materialIndex, uint age, float viewDepth, int2 texel, int mipLevel)
+{
+    if (materialIndex + 1 > NTC_MATERIAL_CACHE_INDEX_MASK)
+        return 0;
+    uint const x = (materialIndex + 1) | (min(age, NTC_MATERIAL_CACHE_AGE_MASK) << NTC_MATERIAL_CACHE_AGE_SHIFT)
+        | (f32tof16(viewDepth) << 16);
+    return uint2(x, EncodeMaterialCacheSample(texel, mipLevel));
+}
+
+uint GetMaterialCacheAge(uint2 key)
+{
+    return (key.x >> NTC_MATERIAL_CACHE_AGE_SHIFT) & NTC_MATERIAL_CACHE_AGE_MASK;
+}
+
+// Finds the pixel of the previous frame that covered the same surface point, assuming a static scene.
+// Returns false if the point was outside of the viewport.
+bool ReprojectMaterialCache(uint2 pixelPosition, float depth, out uint2 previousPixel, out float previousViewDepth)
+{
+    float2 const clipXY = (float2(pixelPosition) + 0.5) * g_Const.windowToClipScale + g_Const.windowToClipBias;
+    float4 worldPos = mul(float4(clipXY, depth, 1), g_Const.matClipToWorld);
+    worldPos.xyz /= worldPos.w;
+
+    // With a perspective projection, clip W is the view depth
+    float4 const prevClipPos = mul(float4(worldPos.xyz, 1), g_Const.matWorldToPrevClip);
+    previousViewDepth = prevClipPos.w;
+
+    float2 const prevWindowPos = prevClipPos.xy / prevClipPos.w * g_Const.prevClipToWindowScale
+        + g_Const.prevClipToWindowBias;
+    int2 const prevPixel = int2(floor(prevWindowPos));
+    int2 const viewportMin = int2(g_Const.viewportOrigin);
+    int2 const viewportMax = int2(g_Const.viewportOrigin + g_Const.viewportSize) - 1;
+    previousPixel = uint2(clamp(prevPixel, viewportMin, viewportMax));
+
+    return prevClipPos.w > 0 && all(prevPixel == int2(previousPixel));
+}
+
+// Returns true if the pixel may take its material textures from the previous frame's cache, which the shading
+// pass confirms by comparing the STF sample, see above
+bool CanReuseMaterialCache(uint2 pixelPosition, uint materialIndex, float depth)
+{
+    if (g_Const.materialCache != NTC_MATERIAL_CACHE_REUSE)
+        return false;
+
+    // Every pixel runs inference once per refresh period, the phases are scattered over the screen
+    uint const hash = (pixelPosition.x * 0x8da6b343u) ^ (pixelPosition.y * 0xd8163841u);
+    if (((hash >> 16) + g_Const.frameIndex) % g_Const.materialCacheRefreshPeriod == 0)
+        return false;
+
+    uint2 previousPixel;
+    float previousViewDepth;
+    if (!ReprojectMaterialCache(pixelPosition, depth, previousPixel, previousViewDepth))
+        return false;
+
+    uint2 const key = t_MaterialCacheHistoryKeys[previousPixel];
+    if ((key.x & NTC_MATERIAL_CACHE_INDEX_MASK) != materialIndex + 1)
+        return false;
+
+    // The rotating refresh follows the screen, not the surface, so a moving camera could keep the same textures
+    // alive for longer than the period without the age limit
+    if (GetMaterialCacheAge(key) + 1 >= g_Const.materialCacheRefreshPeriod)
+        return false;
+
+    // Reject the points that were occluded in the previous frame
+    float const cachedViewDepth = f16tof32(key.x >> 16);
+    return abs(cachedViewDepth - previousViewDepth) <= g_Const.materialCacheDepthTolerance * previousViewDepth;
+}
+
+#endif // NTC_MATERIAL_CACHE_HLSLI
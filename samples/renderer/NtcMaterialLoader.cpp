@@ -13,26 +13,132 @@
 #include "NtcMaterialLoader.h"
 #include "NtcMaterial.h"
 #include "NtcChannelMapping.h"
+#include "Profiler.h"
+#include "MemoryTracker.h"
+#include "NtcTranscodePass.h"
+#include "NtcForwardShadingPass.h"
 #include <ntc-utils/GraphicsDecompressionPass.h>
 #include <ntc-utils/GraphicsBlockCompressionPass.h>
 #include <ntc-utils/DeviceUtils.h>
+#include <ntc-utils/Hash.h>
+#include <ntc-utils/CompressedFileStream.h>
+#include <ntc-utils/MaterialAtlas.h>
+#include <ntc-utils/TextureSetArchive.h>
 
 #include <donut/core/log.h>
 #include <donut/core/string_utils.h>
 #include <donut/core/vfs/VFS.h>
 #include <donut/engine/Scene.h>
 
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <map>
 #include <sstream>
 #include <fstream>
+#include <tuple>
+#include <unordered_set>
 
 using namespace donut;
+using namespace donut::math;
+#include "NtcForwardShadingPassConstants.h"
+
 namespace fs = std::filesystem;
 
 static const uint32_t g_maxTileStagingTextures = 6; // Match number of textures in donut::engine::Material
+static const int g_tileAtlasWidth = 2048; // Size of the staging atlases used for transcoding
+static const int g_tileAtlasHeight = 1024;
+static const int g_tileCacheStagingSize = 256; // Size of the tile cache staging textures, in blocks
+static const uint32_t g_tileCacheFrameLatency = 4; // Frames before the tile cache readbacks are mapped, more than in flight
+static const int g_transcodeRegionSize = 512; // Size of the regions transcoded on load
+static const uint64_t g_latentUploadBufferSize = 8ull << 20; // Latents larger than this are uploaded in chunks
+static const int g_latentUploadBuffersPerThread = 2;
+static const int g_maxMaterialsUploadedPerUpdate = 4; // Limits the weight conversion work done in one frame
+static const uint64_t g_weightPoolBufferSize = 16ull << 20; // Weights of all materials are sub-allocated from buffers of this size
+static const uint64_t g_weightPoolAlignment = 256; // Satisfies the buffer view offset alignment on all APIs
+static const uint64_t g_latentPoolBlockSize = 64ull << 20; // Streamed latents are sub-allocated from buffers of this size
+static const int g_latentStreamingResidentSize = 256; // Mips of this size and smaller are always resident
+static const int g_latentEvictionFrames = 300; // Finer mips are dropped when they were not requested for this long
+static const int g_maxLatentStreamingReads = 4; // Limits the file reads and uploads in flight
+static const int g_mipRequestReadbackLatency = 3; // Frames between recording and reading the mip requests
+static const int g_autoTuningIterations = 8; // Decompression passes timed for each weight type
+
+// The NTC constants are followed by the streaming parameters in the same constant buffer
+static_assert(sizeof(NtcMaterialConstants) == sizeof(NtcTextureSetConstants) + 16);
+
+// Part of one mip level of a material that is transcoded on load in one step.
+struct TranscodeRegion
+{
+    int mipLevel;
+    ntc::Rect rect;
+};
+
+// State of one NTC file being loaded asynchronously.
+// The I/O thread fills 'loadingMaterial' and posts the results, then the rendering thread creates the GPU resources
+// for it, and when everything is uploaded, copies the NTC data into 'material' and its aliases.
+// Until then, the scene materials are not modified and render as placeholders.
+struct MaterialLoadingJob
+{
+    std::shared_ptr<NtcMaterial> material;
+    std::shared_ptr<NtcMaterial> loadingMaterial;
+    std::vector<std::shared_ptr<NtcMaterial>> aliases; // Other materials that use the same NTC data
+    donut::engine::FilePathOrInlineData source;
+    MaterialChannelMap channelMap;
+    TextureSetArchiveEntry const* archiveEntry = nullptr; // Material is read from the material archive when set
+    std::shared_ptr<MaterialAtlasLayout> atlasLayout; // Set when the NTC file contains multiple materials side by side
+    LatentResidency* latentResidency = nullptr; // Set with latent streaming
+    int coarseMip = 0; // Latent streaming: finest mip level that is always resident
+    int firstResidentMip = 0; // Latent streaming: finest mip level that is read on load
+    std::unique_ptr<ntc::IStream> fileStream;
+    ntc::MemoryStreamWrapper memoryStream;
+    uint64_t gpuDecompressionFence = 0; // DirectStorage requests reading from 'fileStream' when not 0
+    uint64_t fileSize = 0;
+    bool failed = false;
+    std::vector<TranscodeRegion> transcodeRegions; // Smallest mips first
+    size_t nextTranscodeRegion = 0;
+
+    MaterialLoadingJob(ntc::IContext* context)
+        : memoryStream(context)
+    { }
+};
+
+// Resident mip levels of one material with latent streaming, indexed by its mip request slot.
+// The latents for mips [firstResidentMip, mips) are in 'allocation', and the mips starting at coarseMip
+// never leave it. Other mips are read again from the material source on a worker thread when they are needed.
+struct LatentResidency
+{
+    uint32_t slot = 0;
+    std::vector<std::shared_ptr<NtcMaterial>> materials; // The scene material and its aliases, empty until ready
+    donut::engine::FilePathOrInlineData source;
+    TextureSetArchiveEntry const* archiveEntry = nullptr;
+    LatentBufferPool::Allocation allocation;
+    int mips = 0;
+    int coarseMip = 0;
+    int firstResidentMip = 0;
+    int windowMip = 0; // Finest mip requested within the current eviction window
+    int windowFrames = 0;
+    uint64_t fullLatentSize = 0;
+    bool failed = false; // The material stays at its current mips after a failed read
+
+    std::future<std::vector<uint8_t>> pendingRead;
+    int pendingFirstMip = 0;
+    ntc::StreamRange pendingRange;
+};
+
+NtcMaterialLoader::~NtcMaterialLoader()
+{
+    StopIoThreads();
+    ReleaseLatentUploadBuffers();
+
+    // Waits for the decompression requests before the loading jobs close their file mappings
+    m_gpuDecompressionQueue.reset();
+}
 
-bool NtcMaterialLoader::Init(bool enableCoopVecInt8, bool enableCoopVecFP8, nvrhi::ITexture* dummyTexture)
+bool NtcMaterialLoader::Init(bool enableCoopVecInt8, bool enableCoopVecFP8, bool enableCopyQueue,
+    nvrhi::ITexture* dummyTexture)
 {
     ntc::ContextParameters contextParams;
+    contextParams.pAllocator = &m_allocator;
     contextParams.cudaDevice = ntc::DisableCudaDevice;
     contextParams.graphicsApi = m_device->getGraphicsAPI() == nvrhi::GraphicsAPI::D3D12
         ? ntc::GraphicsAPI::D3D12
@@ -66,7 +172,7 @@ bool NtcMaterialLoader::Init(bool enableCoopVecInt8, bool enableCoopVecFP8, nvrh
     m_dummyTexture->texture = dummyTexture;
 
     m_graphicsDecompressionPass = std::make_shared<GraphicsDecompressionPass>(m_device,
-        /* descriptorTableSize = */ g_maxTileStagingTextures * 2 * TRANSCODE_BATCH_SIZE);
+        /* descriptorTableSize = */ g_maxTileStagingTextures * 2);
     if (!m_graphicsDecompressionPass->Init())
         return false;
 
@@ -75,8 +181,36 @@ bool NtcMaterialLoader::Init(bool enableCoopVecInt8, bool enableCoopVecFP8, nvrh
     if (!m_graphicsBlockCompressionPass->Init())
         return false;
 
+    m_transcodePass = std::make_shared<NtcTranscodePass>(m_device, m_shaderFactory,
+        /* descriptorTableSize = */ g_maxTileStagingTextures * 2);
+    if (!m_transcodePass->Init())
+        return false;
+
     m_commandList = m_device->createCommandList(nvrhi::CommandListParameters().setEnableImmediateExecution(false));
 
+    m_latentPool = std::make_unique<LatentBufferPool>(m_device, g_latentPoolBlockSize, g_weightPoolAlignment);
+    m_latentPool->SetMemoryTracker(m_memoryTracker);
+
+    if (enableCopyQueue && IsCopyQueueUploadSupported(m_device))
+    {
+        m_copyCommandList = m_device->createCommandList(nvrhi::CommandListParameters()
+            .setEnableImmediateExecution(false)
+            .setQueueType(nvrhi::CommandQueue::Copy));
+
+        // DirectStorage writes the latents outside of the command lists, which is only safe for the buffers that
+        // are handed over from the copy queue, see RetireCopyUploadBatches()
+        m_gpuDecompressionQueue = GpuDecompressionQueue::Create(m_device);
+    }
+
+    // Zlib pages are always inflated on the CPU
+    if (m_gpuDecompressionQueue)
+        log::info("GDeflate pages of compressed NTC files are decompressed by DirectStorage %s.",
+            m_gpuDecompressionQueue->IsGpuDecompression() ? "on the GPU" : "on its CPU fallback");
+    else if (IsGDeflateCodecAvailable())
+        log::info("GDeflate pages of compressed NTC files are decompressed on the CPU.");
+    else
+        log::info("Compressed NTC files with GDeflate pages cannot be read in this build, only zlib pages.");
+
     // Create a buffer for uploading inference weights before their conversion to CoopVec format
 
     nvrhi::BufferDesc uploadBufferDesc = nvrhi::BufferDesc()
@@ -85,17 +219,17 @@ bool NtcMaterialLoader::Init(bool enableCoopVecInt8, bool enableCoopVecFP8, nvrh
         .setInitialState(nvrhi::ResourceStates::CopyDest)
         .setKeepInitialState(true);
     m_weightUploadBuffer = m_device->createBuffer(uploadBufferDesc);
+    if (m_memoryTracker)
+        m_memoryTracker->TrackBuffer(m_weightUploadBuffer, MemoryCategory::UploadBuffers, "Material Loader");
 
-    // Create tile staging color textures
+    // Create the staging atlases for tile-based decompression and recompression, one of each type for every
+    // material texture. Tiles or regions from the same material and mip are packed into them side by side.
     // All these textures are transient and could be aliased with other temp texture resources
 
-    const uint32_t maxTileWidth = 512;
-    const uint32_t maxTileHeight = 512;
-
     nvrhi::TextureDesc colorTextureDesc = nvrhi::TextureDesc()
         .setDimension(nvrhi::TextureDimension::Texture2D)
-        .setWidth(maxTileWidth)
-        .setHeight(maxTileHeight)
+        .setWidth(g_tileAtlasWidth)
+        .setHeight(g_tileAtlasHeight)
         .setMipLevels(1)
         .setDebugName("Tile color")
         .setIsUAV(true)
@@ -103,61 +237,348 @@ bool NtcMaterialLoader::Init(bool enableCoopVecInt8, bool enableCoopVecFP8, nvrh
         .setInitialState(nvrhi::ResourceStates::ShaderResource)
         .setKeepInitialState(true);
 
-    for (uint32_t i = 0; i < g_maxTileStagingTextures * TRANSCODE_BATCH_SIZE; i++)
+    for (uint32_t i = 0; i < g_maxTileStagingTextures; i++)
     {
         colorTextureDesc.setFormat(nvrhi::Format::R8_UNORM);
         colorTextureDesc.setDebugName("Tile Color R8 " + std::to_string(i));
         nvrhi::TextureHandle tex = m_device->createTexture(colorTextureDesc);
         if (!tex)
             return false;
-        m_texTranscodeTiles.push_back(tex);
+        m_texTranscodeAtlases.push_back(tex);
     }
 
-    for (uint32_t i = 0; i < g_maxTileStagingTextures * TRANSCODE_BATCH_SIZE; i++)
+    for (uint32_t i = 0; i < g_maxTileStagingTextures; i++)
     {
         colorTextureDesc.setFormat(nvrhi::Format::RGBA8_UNORM);
         colorTextureDesc.setDebugName("Tile Color RGBA " + std::to_string(i));
         nvrhi::TextureHandle tex = m_device->createTexture(colorTextureDesc);
         if (!tex)
             return false;
-        m_texTranscodeTiles.push_back(tex);
+        m_texTranscodeAtlases.push_back(tex);
     }
 
     // Create tile staging block textures
 
     nvrhi::TextureDesc blockTextureDesc = nvrhi::TextureDesc()
         .setDimension(nvrhi::TextureDimension::Texture2D)
-        .setWidth(maxTileWidth / 4)
-        .setHeight(maxTileHeight / 4)
+        .setWidth(g_tileAtlasWidth / 4)
+        .setHeight(g_tileAtlasHeight / 4)
         .setDebugName("Tile blocks")
         .setIsUAV(true)
         .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
         .setKeepInitialState(true);
         
-    for (uint32_t i = 0; i < g_maxTileStagingTextures * TRANSCODE_BATCH_SIZE; i++)
+    for (uint32_t i = 0; i < g_maxTileStagingTextures; i++)
     {
         blockTextureDesc.setFormat(nvrhi::Format::RG32_UINT);
         blockTextureDesc.setDebugName("Tile Blocks RG " + std::to_string(i));
         nvrhi::TextureHandle tex = m_device->createTexture(blockTextureDesc);
         if (!tex)
             return false;
-        m_texTranscodeTiles.push_back(tex);
+        m_texTranscodeAtlases.push_back(tex);
     }
 
-    for (uint32_t i = 0; i < g_maxTileStagingTextures * TRANSCODE_BATCH_SIZE; i++)
+    for (uint32_t i = 0; i < g_maxTileStagingTextures; i++)
     {
         blockTextureDesc.setFormat(nvrhi::Format::RGBA32_UINT);
         blockTextureDesc.setDebugName("Tile Blocks RGBA " + std::to_string(i));
         nvrhi::TextureHandle tex = m_device->createTexture(blockTextureDesc);
         if (!tex)
             return false;
-        m_texTranscodeTiles.push_back(tex);
+        m_texTranscodeAtlases.push_back(tex);
+    }
+
+    if (m_memoryTracker)
+    {
+        for (nvrhi::ITexture* texture : m_texTranscodeAtlases)
+            m_memoryTracker->TrackTexture(texture, MemoryCategory::TranscodeStaging, "Material Loader");
+    }
+
+    m_texAtlasColorR8Offset = 0;
+    m_texAtlasColorRGBAOffset = 1 * g_maxTileStagingTextures;
+    m_texAtlasBlocksRGOffset = 2 * g_maxTileStagingTextures;
+    m_texAtlasBlocksRGBAOffset = 3 * g_maxTileStagingTextures;
+
+    // Write the descriptors for the color atlases into the decompression pass descriptor table once,
+    // the descriptor indices match the atlas indices.
+    for (uint32_t descriptorIndex = 0; descriptorIndex < m_texAtlasBlocksRGOffset; ++descriptorIndex)
+    {
+        nvrhi::BindingSetItem descriptor = nvrhi::BindingSetItem::Texture_UAV(
+            descriptorIndex,
+            m_texTranscodeAtlases[descriptorIndex]);
+        m_graphicsDecompressionPass->WriteDescriptor(descriptor);
+    }
+
+    // Same for the block atlases in the transcoding pass table, starting at descriptor 0
+    for (uint32_t descriptorIndex = 0; descriptorIndex < 2 * g_maxTileStagingTextures; ++descriptorIndex)
+    {
+        nvrhi::BindingSetItem descriptor = nvrhi::BindingSetItem::Texture_UAV(
+            descriptorIndex,
+            m_texTranscodeAtlases[m_texAtlasBlocksRGOffset + descriptorIndex]);
+        m_transcodePass->WriteDescriptor(descriptor);
+    }
+
+    return true;
+}
+
+// Weight types compared by the auto-tuning benchmark, in the default order of preference.
+// The generic FP8 weights are not supported by the shading passes.
+static const ntc::InferenceWeightType g_autoTuningWeightTypes[] = {
+    ntc::InferenceWeightType::CoopVecFP8,
+    ntc::InferenceWeightType::CoopVecInt8,
+    ntc::InferenceWeightType::GenericInt8
+};
+
+static char const* GetWeightTypeName(ntc::InferenceWeightType weightType)
+{
+    switch (weightType)
+    {
+    case ntc::InferenceWeightType::GenericInt8: return "GenericInt8";
+    case ntc::InferenceWeightType::GenericFP8: return "GenericFP8";
+    case ntc::InferenceWeightType::CoopVecInt8: return "CoopVecInt8";
+    case ntc::InferenceWeightType::CoopVecFP8: return "CoopVecFP8";
+    default: return "Unknown";
+    }
+}
+
+// The auto-tuning cache file has one line per adapter: the weight type name, a space, and the adapter identifier.
+static ntc::InferenceWeightType ReadAutoTuningCache(fs::path const& cacheFile, std::string const& adapterIdentifier)
+{
+    std::ifstream file(cacheFile);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t const separator = line.find(' ');
+        if (separator == std::string::npos || line.compare(separator + 1, std::string::npos, adapterIdentifier) != 0)
+            continue;
+
+        for (ntc::InferenceWeightType weightType : g_autoTuningWeightTypes)
+        {
+            if (line.compare(0, separator, GetWeightTypeName(weightType)) == 0)
+                return weightType;
+        }
+    }
+    return ntc::InferenceWeightType::Unknown;
+}
+
+// Replaces the line for the adapter, keeping the results for other adapters and drivers
+static bool WriteAutoTuningCache(fs::path const& cacheFile, std::string const& adapterIdentifier,
+    ntc::InferenceWeightType weightType)
+{
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(cacheFile);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            size_t const separator = line.find(' ');
+            if (separator != std::string::npos &&
+                line.compare(separator + 1, std::string::npos, adapterIdentifier) != 0)
+                lines.push_back(line);
+        }
+    }
+    lines.push_back(std::string(GetWeightTypeName(weightType)) + " " + adapterIdentifier);
+
+    std::ofstream file(cacheFile, std::ios::trunc);
+    for (std::string const& line : lines)
+        file << line << '\n';
+    return bool(file);
+}
+
+void NtcMaterialLoader::EnableInferenceAutoTuning(fs::path const& cacheFile)
+{
+    m_autoTuningCacheFile = cacheFile;
+    m_adapterIdentifier = GetAdapterIdentifier(m_device);
+
+    // Without an identifier, the result can't be matched to the GPU on later runs, so it's only used in this one
+    m_preferredWeightType = m_adapterIdentifier.empty()
+        ? ntc::InferenceWeightType::Unknown
+        : ReadAutoTuningCache(cacheFile, m_adapterIdentifier);
+
+    // The cached winner may have been disabled on the command line since it was measured
+    bool const cachedTypeEnabled =
+        m_preferredWeightType == ntc::InferenceWeightType::GenericInt8 ||
+        (m_preferredWeightType == ntc::InferenceWeightType::CoopVecInt8 && m_coopVecInt8) ||
+        (m_preferredWeightType == ntc::InferenceWeightType::CoopVecFP8 && m_coopVecFP8);
+
+    if (cachedTypeEnabled)
+    {
+        log::info("Using the %s inference weights selected by auto-tuning for '%s'.",
+            GetWeightTypeName(m_preferredWeightType), m_adapterIdentifier.c_str());
+        m_autoTuningPending = false;
+    }
+    else
+    {
+        m_preferredWeightType = ntc::InferenceWeightType::Unknown;
+        m_autoTuningPending = true;
+    }
+}
+
+bool NtcMaterialLoader::RunInferenceBenchmark(ntc::ITextureSetMetadata* textureSetMetadata,
+    NtcMaterial const& material, ntc::InferenceWeightType& outFastestType)
+{
+    outFastestType = ntc::InferenceWeightType::Unknown;
+
+    std::vector<ntc::InferenceWeightType> weightTypes;
+    for (ntc::InferenceWeightType weightType : g_autoTuningWeightTypes)
+    {
+        bool const enabled = weightType == ntc::InferenceWeightType::GenericInt8 ||
+            (weightType == ntc::InferenceWeightType::CoopVecInt8 && m_coopVecInt8) ||
+            (weightType == ntc::InferenceWeightType::CoopVecFP8 && m_coopVecFP8);
+        if (enabled && textureSetMetadata->IsInferenceWeightTypeSupported(weightType))
+            weightTypes.push_back(weightType);
+    }
+
+    if (weightTypes.size() < 2)
+        return true;
+
+    // The inference cost doesn't depend on the latent values, so the benchmark doesn't wait for the latents
+    // to be read and decodes a cleared buffer of the same size instead.
+    nvrhi::BufferDesc latentBufferDesc = nvrhi::BufferDesc()
+        .setByteSize(material.latentStreamRange.size)
+        .setCanHaveRawViews(true)
+        .setCanHaveUAVs(true)
+        .setInitialState(nvrhi::ResourceStates::ShaderResource)
+        .setKeepInitialState(true)
+        .setDebugName("Inference benchmark latents");
+    nvrhi::BufferHandle latentBuffer = m_device->createBuffer(latentBufferDesc);
+    if (!latentBuffer)
+        return false;
+
+    // Decode all channels of the first mip, or as much of it as fits, into the RGBA color atlases
+    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+    ntc::Rect srcRect;
+    srcRect.left = 0;
+    srcRect.top = 0;
+    srcRect.width = std::min(textureSetDesc.width, g_tileAtlasWidth);
+    srcRect.height = std::min(textureSetDesc.height, g_tileAtlasHeight);
+    ntc::Point dstOffset;
+    dstOffset.x = 0;
+    dstOffset.y = 0;
+
+    std::array<ntc::OutputTextureDesc, g_maxTileStagingTextures> outputTextureDescs;
+    int const textureCount = std::min(int(g_maxTileStagingTextures), (textureSetDesc.channels + 3) / 4);
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        ntc::OutputTextureDesc& outputDesc = outputTextureDescs[textureIndex];
+        outputDesc.firstChannel = textureIndex * 4;
+        outputDesc.numChannels = std::min(4, textureSetDesc.channels - textureIndex * 4);
+        outputDesc.descriptorIndex = m_texAtlasColorRGBAOffset + textureIndex;
+        outputDesc.rgbColorSpace = ntc::ColorSpace::Linear;
+        outputDesc.ditherScale = 0.f;
+    }
+
+    nvrhi::CommandListHandle commandList = m_device->createCommandList();
+    commandList->open();
+    commandList->beginMarker("Inference Benchmark");
+
+    commandList->clearBufferUInt(latentBuffer, 0);
+
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        commandList->setTextureState(m_texTranscodeAtlases[m_texAtlasColorRGBAOffset + textureIndex],
+            nvrhi::AllSubresources, nvrhi::ResourceStates::UnorderedAccess);
+    }
+    commandList->commitBarriers();
+
+    // Only the recording calls into the NTC context, the GPU work is waited for after releasing the lock
+    std::unique_lock contextLock(m_contextMutex);
+
+    m_graphicsDecompressionPass->SetInputBuffer(latentBuffer);
+
+    std::vector<nvrhi::TimerQueryHandle> timerQueries;
+    for (size_t typeIndex = 0; typeIndex < weightTypes.size(); ++typeIndex)
+    {
+        ntc::InferenceWeightType const weightType = weightTypes[typeIndex];
+
+        // The weights go into a temporary buffer, so that the pool doesn't keep the weights of the types
+        // that lose. The materials add the winner's weights to the pool when they are prepared.
+        void const* weightData = nullptr;
+        size_t weightSize = 0;
+        size_t convertedWeightSize = 0;
+        ntc::Status ntcStatus = textureSetMetadata->GetInferenceWeights(weightType, &weightData, &weightSize,
+            &convertedWeightSize);
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            commandList->close();
+            return false;
+        }
+
+        size_t const finalWeightSize = convertedWeightSize ? convertedWeightSize : weightSize;
+        nvrhi::BufferDesc weightBufferDesc = nvrhi::BufferDesc()
+            .setByteSize(finalWeightSize)
+            .setCanHaveRawViews(true)
+            .setCanHaveUAVs(true)
+            .setInitialState(nvrhi::ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName("Inference benchmark weights");
+        nvrhi::BufferHandle weightBuffer = m_device->createBuffer(weightBufferDesc);
+        if (!weightBuffer)
+        {
+            commandList->close();
+            return false;
+        }
+        nvrhi::BufferRange const weightRange(0, finalWeightSize);
+
+        WriteInferenceWeights(textureSetMetadata, weightType, weightData, weightSize, convertedWeightSize,
+            commandList, weightBuffer, 0);
+
+        ntc::MakeDecompressionComputePassParameters decompressionParams;
+        decompressionParams.textureSetMetadata = textureSetMetadata;
+        decompressionParams.latentStreamRange = material.latentStreamRange;
+        decompressionParams.mipLevel = 0;
+        decompressionParams.firstOutputDescriptorIndex = 0;
+        decompressionParams.pOutputTextures = outputTextureDescs.data();
+        decompressionParams.numOutputTextures = textureCount;
+        decompressionParams.weightType = weightType;
+        decompressionParams.pSrcRect = &srcRect;
+        decompressionParams.pDstOffset = &dstOffset;
+        ntc::ComputePassDesc decompressionPass;
+        ntcStatus = m_ntcContext->MakeDecompressionComputePass(decompressionParams, &decompressionPass);
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            log::warning("Failed to make a decompression pass for the inference benchmark, error code = %s: %s",
+                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            commandList->close();
+            return false;
+        }
+
+        m_graphicsDecompressionPass->SetWeightBuffer(weightBuffer, weightRange);
+
+        // The first pass creates the pipeline and warms up the caches, it's not timed
+        m_graphicsDecompressionPass->ExecuteComputePass(commandList, decompressionPass);
+
+        nvrhi::TimerQueryHandle timerQuery = m_device->createTimerQuery();
+        commandList->beginTimerQuery(timerQuery);
+        for (int iteration = 0; iteration < g_autoTuningIterations; ++iteration)
+            m_graphicsDecompressionPass->ExecuteComputePass(commandList, decompressionPass);
+        commandList->endTimerQuery(timerQuery);
+        timerQueries.push_back(timerQuery);
     }
 
-    m_texTileColorR8Offset = 0;
-    m_texTileColorRGBAOffset = 1 * g_maxTileStagingTextures * TRANSCODE_BATCH_SIZE;
-    m_texTileBlocksRGOffset = 2 * g_maxTileStagingTextures * TRANSCODE_BATCH_SIZE;
-    m_texTileBlocksRGBAOffset = 3 * g_maxTileStagingTextures * TRANSCODE_BATCH_SIZE;
+    commandList->endMarker();
+    commandList->close();
+    contextLock.unlock();
+
+    // The event query only waits for the benchmark, not for the uploads and transcoding on other queues
+    nvrhi::EventQueryHandle eventQuery = m_device->createEventQuery();
+    m_device->executeCommandList(commandList);
+    m_device->setEventQuery(eventQuery, nvrhi::CommandQueue::Graphics);
+    m_device->waitEventQuery(eventQuery);
+
+    float fastestTime = 0.f;
+    for (size_t typeIndex = 0; typeIndex < weightTypes.size(); ++typeIndex)
+    {
+        float const time = m_device->getTimerQueryTime(timerQueries[typeIndex]) / float(g_autoTuningIterations);
+        log::info("Inference benchmark: %s weights decompress %dx%d pixels in %.3f ms.",
+            GetWeightTypeName(weightTypes[typeIndex]), srcRect.width, srcRect.height, time * 1e3f);
+
+        if (outFastestType == ntc::InferenceWeightType::Unknown || time < fastestTime)
+        {
+            outFastestType = weightTypes[typeIndex];
+            fastestTime = time;
+        }
+    }
 
     return true;
 }
@@ -336,7 +757,8 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
 }
 
 static bool LoadMaterialFile(donut::engine::FilePathOrInlineData const& source, NtcMaterial& material,
-    ntc::IContext* ntcContext, ntc::FileStreamWrapper& ntcFile, ntc::MemoryStreamWrapper& ntcMemory,
+    ntc::IContext* ntcContext, TextureSetArchive const* archive, TextureSetArchiveEntry const* archiveEntry,
+    std::unique_ptr<ntc::IStream>& ntcFile, ntc::MemoryStreamWrapper& ntcMemory,
     ntc::TextureSetMetadataWrapper& textureSetMetadata)
 {
     if (material.name.empty())
@@ -359,22 +781,39 @@ static bool LoadMaterialFile(donut::engine::FilePathOrInlineData const& source,
 
         stream = ntcMemory.Get();
     }
+    else if (archiveEntry)
+    {
+        // Archive entries are views of one file mapping. Start reading the whole entry now, so that the latents
+        // are already in memory when they are copied after the metadata is parsed.
+        archive->PrefetchEntry(*archiveEntry);
+        ntcFile = archive->OpenEntry(*archiveEntry);
+        if (!ntcFile)
+        {
+            log::warning("Cannot open '%s' in the material archive.", archiveEntry->name.c_str());
+            return false;
+        }
+
+        stream = ntcFile.get();
+    }
     else
     {
-        ntcStatus = ntcContext->OpenFile(source.path.c_str(), false, ntcFile.ptr());
-        if (ntcStatus == ntc::Status::FileUnavailable)
+        if (!fs::exists(source.path))
         {
             log::warning("Material file '%s' does not exist.", source.path.c_str());
             return false;
         }
-        else if (ntcStatus != ntc::Status::Ok)
+
+        // Map the file so that the latents can be copied into the upload buffers without an intermediate buffer.
+        // Page-compressed files are inflated straight into the upload buffers by the loading thread.
+        std::string openError;
+        ntcFile = OpenTextureSetFile(source.path.c_str(), &openError);
+        if (!ntcFile)
         {
-            log::warning("Cannot open '%s', error code = %s: %s", source.path.c_str(),
-                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            log::warning("Cannot open '%s': %s", source.path.c_str(), openError.c_str());
             return false;
         }
 
-        stream = ntcFile.Get();
+        stream = ntcFile.get();
     }
 
     ntcStatus = ntcContext->CreateTextureSetMetadataFromStream(stream, textureSetMetadata.ptr());
@@ -390,289 +829,548 @@ static bool LoadMaterialFile(donut::engine::FilePathOrInlineData const& source,
     return true;
 }
 
+void NtcMaterialLoader::GetTranscodeAtlasIndices(TextureTranscodeTask const& transcodeTask, int textureIndex,
+    uint32_t& outColorIndex, uint32_t& outBlockIndex) const
+{
+    outColorIndex = ((transcodeTask.numChannels == 1) ? m_texAtlasColorR8Offset : m_texAtlasColorRGBAOffset)
+        + textureIndex;
+
+    bool const isSmallBlock =
+        (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC1) ||
+        (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC4);
+
+    outBlockIndex = (isSmallBlock ? m_texAtlasBlocksRGOffset : m_texAtlasBlocksRGBAOffset) + textureIndex;
+}
+
+bool NtcMaterialLoader::UseFusedBlockEncoding(NtcMaterial const& material,
+    TextureTranscodeTask const& transcodeTask) const
+{
+    if (!m_fusedBlockEncoding || !NtcTranscodePass::IsTextureSupported(material, transcodeTask))
+        return false;
+
+    // The fused encoder only fits the endpoints to the block's bounding box, leave the textures that ask for
+    // the maximum quality to LibNTC's block compression
+    uint8_t const quality = transcodeTask.metadata
+        ? transcodeTask.metadata->GetBlockCompressionQuality()
+        : ntc::BlockCompressionMaxQuality;
+    return quality < ntc::BlockCompressionMaxQuality;
+}
+
 bool NtcMaterialLoader::TranscodeTiles(const std::vector<TranscodeTileInfo>& tiles, nvrhi::ICommandList* commandList,
     bool enableBlockCompression)
 {
     if (tiles.empty())
         return true;
 
-    assert(tiles.size() <= TRANSCODE_BATCH_SIZE);
-
-    // Indices for grabbing the next available texture from the staging textures
-    uint32_t texTileColorR8Index = m_texTileColorR8Offset;
-    uint32_t texTileColorRGBAIndex = m_texTileColorRGBAOffset;
-    uint32_t texTileBlocksRGIndex = m_texTileBlocksRGOffset;
-    uint32_t texTileBlocksRGBAIndex = m_texTileBlocksRGBAOffset;
+    std::lock_guard lockGuard(m_transcodeAtlasMutex);
 
-    // Write all descriptors for the color textures into the decompression pass descriptor table
-    for (int descriptorIndex = 0; descriptorIndex < m_texTileBlocksRGOffset; ++descriptorIndex)
+    // Restore the tiles that were transcoded before from the cache, and transcode the rest
+    std::vector<TranscodeTileInfo> missedTiles;
+    std::vector<TranscodeTileInfo> const* tilesToTranscode = &tiles;
+    if (m_tileCache && enableBlockCompression)
     {
-        nvrhi::BindingSetItem descriptor = nvrhi::BindingSetItem::Texture_UAV(
-            descriptorIndex,
-            m_texTranscodeTiles[descriptorIndex]);
-        m_graphicsDecompressionPass->WriteDescriptor(descriptor);
+        if (!RestoreCachedTiles(tiles, commandList, missedTiles))
+            return false;
+        tilesToTranscode = &missedTiles;
     }
 
-    // Indices which map every tile/textureIndex into the list of temporary textures
-    std::vector<uint32_t> colorTextureIndices;
-    std::vector<uint32_t> blockTextureIndices;
+    // Group the tiles by material and mip level. All tiles in a group share the decompression and
+    // BCn compression dispatches, so the number of dispatches doesn't grow with the number of tiles.
+    struct TileGroup
+    {
+        NtcMaterial* material;
+        uint32_t mipLevel;
+        std::vector<nvfeedback::FeedbackTextureTileInfo> tiles;
+    };
 
-    std::array<bool, TRANSCODE_BATCH_SIZE> compressThisTexture;
+    std::vector<TileGroup> groups;
+    for (const TranscodeTileInfo& transcodeTile : *tilesToTranscode)
+    {
+        auto group = std::find_if(groups.begin(), groups.end(), [&transcodeTile](TileGroup const& existing)
+            { return existing.material == transcodeTile.material && existing.mipLevel == transcodeTile.tileInfo.mip; });
 
-    commandList->beginMarker("Transcode Tiles: NTC Decompression");
+        if (group == groups.end())
+        {
+            groups.push_back({ transcodeTile.material, transcodeTile.tileInfo.mip });
+            group = groups.end() - 1;
+        }
 
-    // Phase 1 - Select the temporary tile textures from the pool and make state transitions
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
-    {
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
-        const NtcMaterial& material = *transcodeTile.material;
+        group->tiles.push_back(transcodeTile.tileInfo);
+    }
 
-        int textureCount = int(material.transcodeMapping.size());
-        assert(textureCount <= g_maxTileStagingTextures); // Maximum number of textures supported
+    for (TileGroup& group : groups)
+    {
+        NtcMaterial const& material = *group.material;
 
         // TODO: Does this this need to be handled without faulting?
         assert(material.transcodeMapping.empty() == false);
-
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+        assert(int(material.transcodeMapping.size()) <= g_maxTileStagingTextures);
+
+        ntc::TextureSetDesc const& textureSetDesc = material.textureSetMetadata->Get()->GetDesc();
+        int const mipWidth = std::max(1, textureSetDesc.width >> group.mipLevel);
+        int const mipHeight = std::max(1, textureSetDesc.height >> group.mipLevel);
+
+        // Sort the tiles in rows so that horizontally adjacent tiles can be merged into runs
+        std::sort(group.tiles.begin(), group.tiles.end(),
+            [](nvfeedback::FeedbackTextureTileInfo const& a, nvfeedback::FeedbackTextureTileInfo const& b)
+            { return (a.yInTexels != b.yInTexels) ? (a.yInTexels < b.yInTexels) : (a.xInTexels < b.xInTexels); });
+
+        // Merge the tiles into rectangles that are decompressed with one dispatch each: first adjacent tiles
+        // in a row into runs, then runs of the same extent in consecutive rows. The requested tiles usually
+        // form contiguous areas, so this makes the recording cost grow with the number of areas rather than
+        // the number of tiles. Rectangles can only grow past tiles whose size is a multiple of the BCn block.
+        struct TileRect
         {
-            const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+            ntc::Rect srcRect;
+            std::vector<AtlasTile> tiles; // Tile positions are relative to the rectangle
+        };
+        std::vector<TileRect> rects;
+        std::map<std::tuple<int, int, int>, size_t> openRects; // (left, width, bottom) -> index in rects
 
-            bool const isSingleChannel = transcodeTask.numChannels == 1;
-
-            // Select the color texture
-            uint32_t colorTextureIndex = isSingleChannel ? texTileColorR8Index++ : texTileColorRGBAIndex++;
-            colorTextureIndices.push_back(colorTextureIndex);
-
-            compressThisTexture[tileIndex] = transcodeTask.bcFormat != ntc::BlockCompressedFormat::None
-                && enableBlockCompression;
-            if (compressThisTexture[tileIndex])
+        for (size_t tileIndex = 0; tileIndex < group.tiles.size(); )
+        {
+            // Collect one run of adjacent tiles in the row, clamped to the mip.
+            // Tiles can be block sizes of 4x4 while the mip could be smaller.
+            nvfeedback::FeedbackTextureTileInfo const& firstTile = group.tiles[tileIndex];
+            TileRect run;
+            run.srcRect.left = firstTile.xInTexels;
+            run.srcRect.top = firstTile.yInTexels;
+            run.srcRect.width = 0;
+            run.srcRect.height = std::min(int(firstTile.heightInTexels), mipHeight);
+
+            for (; tileIndex < group.tiles.size(); ++tileIndex)
             {
-                // Select the block texture
-                bool const isSmallBlock =
-                    (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC1) ||
-                    (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC4);
+                nvfeedback::FeedbackTextureTileInfo const& tileInfo = group.tiles[tileIndex];
+                int const width = std::min(int(tileInfo.widthInTexels), mipWidth);
+                int const height = std::min(int(tileInfo.heightInTexels), mipHeight);
+                bool const extendsRun = run.tiles.empty() || (
+                    run.srcRect.top == int(tileInfo.yInTexels) &&
+                    run.srcRect.height == height &&
+                    run.srcRect.left + run.srcRect.width == int(tileInfo.xInTexels) &&
+                    (run.srcRect.width & 3) == 0 &&
+                    run.srcRect.width + ((width + 3) & ~3) <= g_tileAtlasWidth);
+                if (!extendsRun)
+                    break;
 
-                uint32_t blockTextureIndex = isSmallBlock ? texTileBlocksRGIndex++ : texTileBlocksRGBAIndex++;
-                blockTextureIndices.push_back(blockTextureIndex);
+                run.tiles.push_back({ tileInfo, run.srcRect.width, 0, width, height });
+                run.srcRect.width += width;
+            }
 
-                // Disable automatic UAV barriers for the block texture
-                commandList->setEnableUavBarriersForTexture(m_texTranscodeTiles[blockTextureIndex], false);
+            // Append the run to the rectangle directly above it if it has the same extent.
+            // The entries of the rectangles that ended in earlier rows can't match anymore.
+            auto openRect = openRects.find({ run.srcRect.left, run.srcRect.width, run.srcRect.top });
+            if (openRect != openRects.end())
+            {
+                TileRect& rect = rects[openRect->second];
+                bool const canGrow = (rect.srcRect.height & 3) == 0 &&
+                    ((rect.srcRect.height + run.srcRect.height + 3) & ~3) <= g_tileAtlasHeight;
+                if (canGrow)
+                {
+                    for (AtlasTile& atlasTile : run.tiles)
+                    {
+                        atlasTile.atlasY = rect.srcRect.height;
+                        rect.tiles.push_back(atlasTile);
+                    }
+                    rect.srcRect.height += run.srcRect.height;
+                    size_t const rectIndex = openRect->second;
+                    openRects.erase(openRect);
+                    openRects[{ rect.srcRect.left, rect.srcRect.width, rect.srcRect.top + rect.srcRect.height }] =
+                        rectIndex;
+                    continue;
+                }
             }
 
-            // Transition to UAV
-            commandList->setTextureState(m_texTranscodeTiles[colorTextureIndex], nvrhi::AllSubresources,
-                nvrhi::ResourceStates::UnorderedAccess);
+            openRects[{ run.srcRect.left, run.srcRect.width, run.srcRect.top + run.srcRect.height }] = rects.size();
+            rects.push_back(std::move(run));
         }
-    }
 
-    commandList->commitBarriers();
+        // Pack the rectangles into the staging atlases using shelves.
+        // When the atlases are full, transcode what's been packed so far and start over.
+        std::vector<AtlasRun> runs;
+        std::vector<AtlasTile> atlasTiles;
+        int cursorX = 0;
+        int cursorY = 0;
+        int shelfHeight = 0;
 
-    // Phase 2 - Run NTC decompression
+        for (TileRect const& rect : rects)
+        {
+            int const alignedWidth = (rect.srcRect.width + 3) & ~3;
+            int const alignedHeight = (rect.srcRect.height + 3) & ~3;
 
-    uint32_t colorTextureIndex = 0;
-    uint32_t blockTextureIndex = 0;
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
-    {
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
-        const nvfeedback::FeedbackTextureTileInfo tileInfo = transcodeTile.tileInfo;
-        const NtcMaterial& material = *transcodeTile.material;
+            if (cursorX + alignedWidth > g_tileAtlasWidth)
+            {
+                cursorX = 0;
+                cursorY += shelfHeight;
+                shelfHeight = 0;
+            }
 
-        ntc::ITextureSetMetadata* textureSetMetadata = material.textureSetMetadata->Get();
-        ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
-        const uint32_t mipWidth = std::max(1, textureSetDesc.width >> tileInfo.mip);
-        const uint32_t mipHeight = std::max(1, textureSetDesc.height >> tileInfo.mip);
-        int textureCount = int(material.transcodeMapping.size());
-        assert(textureCount <= g_maxTileStagingTextures); // Maximum number of textures supported
+            if (cursorY + alignedHeight > g_tileAtlasHeight)
+            {
+                if (!TranscodeAtlas(material, group.mipLevel, runs, atlasTiles, commandList, enableBlockCompression))
+                    return false;
 
-        // Make sure that the latent and weight buffers have already been created
-        assert(material.ntcLatentsBuffer);
-        assert(material.ntcWeightsBuffer);
+                runs.clear();
+                atlasTiles.clear();
+                cursorX = 0;
+                cursorY = 0;
+                shelfHeight = 0;
+            }
 
-        m_graphicsDecompressionPass->SetInputBuffer(material.ntcLatentsBuffer);
-        m_graphicsDecompressionPass->SetWeightBuffer(material.ntcWeightsBuffer);
+            AtlasRun newRun;
+            newRun.srcRect = rect.srcRect;
+            newRun.atlasX = cursorX;
+            newRun.atlasY = cursorY;
+            runs.push_back(newRun);
 
-        ntc::Rect rectDecompress;
-        rectDecompress.left = tileInfo.xInTexels;
-        rectDecompress.top = tileInfo.yInTexels;
-        rectDecompress.width = std::min(tileInfo.widthInTexels, mipWidth); // Tiles can be block sizes of 4x4 while the mip could be smaller
-        rectDecompress.height = std::min(tileInfo.heightInTexels, mipHeight);
+            for (AtlasTile atlasTile : rect.tiles)
+            {
+                atlasTile.atlasX += cursorX;
+                atlasTile.atlasY += cursorY;
+                atlasTiles.push_back(atlasTile);
+            }
 
-        ntc::Point offsetDecompress;
-        offsetDecompress.x = 0;
-        offsetDecompress.y = 0;
-        
-        std::array<ntc::OutputTextureDesc, g_maxTileStagingTextures> outputTextureDescs;
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
-        {
-            const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
-            ntc::OutputTextureDesc& outputDesc = outputTextureDescs[textureIndex];
-            outputDesc.firstChannel = transcodeTask.firstChannel;
-            outputDesc.numChannels = transcodeTask.numChannels;
-            outputDesc.descriptorIndex = colorTextureIndices[colorTextureIndex++];
-            outputDesc.rgbColorSpace = transcodeTask.sRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
-            outputDesc.ditherScale = 1.f / 255.f;
+            cursorX += alignedWidth;
+            shelfHeight = std::max(shelfHeight, alignedHeight);
         }
 
-        ntc::MakeDecompressionComputePassParameters decompressionParams;
-        decompressionParams.textureSetMetadata = textureSetMetadata;
-        decompressionParams.latentStreamRange = material.latentStreamRange;
-        decompressionParams.mipLevel = tileInfo.mip;
-        decompressionParams.firstOutputDescriptorIndex = 0;
-        decompressionParams.pOutputTextures = outputTextureDescs.data();
-        decompressionParams.numOutputTextures = textureCount;
-        decompressionParams.weightType = ntc::InferenceWeightType(material.weightType);
-        decompressionParams.pSrcRect = &rectDecompress;
-        decompressionParams.pDstOffset = &offsetDecompress;
-        ntc::ComputePassDesc decompressionPass;
-        ntc::Status ntcStatus = m_ntcContext->MakeDecompressionComputePass(decompressionParams, &decompressionPass);
-        if (ntcStatus != ntc::Status::Ok)
-        {
-            log::warning("Failed to make a decompression pass for material '%s' mip %d, error code = %s: %s",
-                material.name.c_str(), tileInfo.mip, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        if (!TranscodeAtlas(material, group.mipLevel, runs, atlasTiles, commandList, enableBlockCompression))
             return false;
-        }
-
-        m_graphicsDecompressionPass->ExecuteComputePass(commandList, decompressionPass);
     }
 
-    commandList->endMarker();
-
-    // Phase 3 - Compress all mips of the color textures into BCn, where necessary
+    return true;
+}
 
-    commandList->beginMarker("Transcode Tiles: BCn Compression");
+// Identifies the data of a material file across runs: the file path with its size and modification time,
+// or the archive entry. Materials with inline data are identified by their size only.
+static uint64_t GetMaterialSourceHash(donut::engine::FilePathOrInlineData const& source,
+    TextureSetArchiveEntry const* archiveEntry, uint64_t fileSize)
+{
+    Fnv1aHash hash;
 
-    // Transition textures for BCn compression
-    colorTextureIndex = 0;
-    blockTextureIndex = 0;
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
+    hash.AddValue(fileSize);
+    if (archiveEntry)
     {
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
-        const nvfeedback::FeedbackTextureTileInfo tileInfo = transcodeTile.tileInfo;
-        const NtcMaterial& material = *transcodeTile.material;
-        int textureCount = int(material.transcodeMapping.size());
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
-        {
-            nvrhi::TextureHandle colorTexture = m_texTranscodeTiles[colorTextureIndices[colorTextureIndex++]];
-            if (compressThisTexture[tileIndex])
-            {
-                nvrhi::TextureHandle blockTexture = m_texTranscodeTiles[blockTextureIndices[blockTextureIndex++]];
-                commandList->setTextureState(colorTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::ShaderResource);
-                commandList->setTextureState(blockTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::UnorderedAccess);
-            }
-        }
+        hash.AddBytes(archiveEntry->name.data(), archiveEntry->name.size());
+        hash.AddValue(archiveEntry->offset);
     }
-    commandList->commitBarriers();
-
-    colorTextureIndex = 0;
-    blockTextureIndex = 0;
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
+    else if (!source.data)
     {
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
-        const nvfeedback::FeedbackTextureTileInfo tileInfo = transcodeTile.tileInfo;
-        const NtcMaterial& material = *transcodeTile.material;
-
-        ntc::ITextureSetMetadata* textureSetMetadata = material.textureSetMetadata->Get();
-        ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
-        const uint32_t mipWidth = std::max(1, textureSetDesc.width >> tileInfo.mip);
-        const uint32_t mipHeight = std::max(1, textureSetDesc.height >> tileInfo.mip);
-        int textureCount = int(material.transcodeMapping.size());
-        assert(textureCount <= g_maxTileStagingTextures); // Maximum number of textures supported
+        std::error_code error;
+        int64_t const writeTime = fs::last_write_time(source.path, error).time_since_epoch().count();
+        hash.AddBytes(source.path.data(), source.path.size());
+        hash.AddValue(writeTime);
+    }
 
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
-        {
-            const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+    return hash.Get();
+}
 
-            nvrhi::TextureHandle colorTexture = m_texTranscodeTiles[colorTextureIndices[colorTextureIndex++]];
+// Tiles can only be cached when all material textures are block compressed, because the staging textures
+// for the cache use the block formats.
+static bool IsTileCacheable(NtcMaterial const& material, bool enableBlockCompression)
+{
+    if (!enableBlockCompression || material.transcodeMapping.empty())
+        return false;
 
-            if (compressThisTexture[tileIndex])
-            {
-                nvrhi::TextureHandle blockTexture = m_texTranscodeTiles[blockTextureIndices[blockTextureIndex++]];
-                float const alphaThreshold = 1.f / 255.f;
-
-                ntc::MakeBlockCompressionComputePassParameters compressionParams;
-                // Tiles can be block sizes of 4x4 while the mip is smaller
-                compressionParams.srcRect.width = std::min(tileInfo.widthInTexels, mipWidth);
-                compressionParams.srcRect.height = std::min(tileInfo.heightInTexels, mipHeight);
-                compressionParams.dstFormat = transcodeTask.bcFormat;
-                compressionParams.alphaThreshold = alphaThreshold;
-                compressionParams.texture = transcodeTask.metadata;
-                compressionParams.quality = transcodeTask.metadata
-                    ? transcodeTask.metadata->GetBlockCompressionQuality()
-                    : ntc::BlockCompressionMaxQuality;
-                ntc::ComputePassDesc compressionPass;
-                ntc::Status ntcStatus = m_ntcContext->MakeBlockCompressionComputePass(compressionParams, &compressionPass);
-
-                if (ntcStatus != ntc::Status::Ok)
-                {
-                    log::warning("Failed to make a block compression pass for material '%s', error code = %s: %s",
-                        material.name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-                    return false;
-                }
+    for (TextureTranscodeTask const& transcodeTask : material.transcodeMapping)
+    {
+        if (transcodeTask.bcFormat == ntc::BlockCompressedFormat::None)
+            return false;
+    }
 
-                nvrhi::Format const inputFormat = (transcodeTask.numChannels == 1)
-                    ? nvrhi::Format::R8_UNORM
-                    : nvrhi::Format::RGBA8_UNORM;
+    return true;
+}
 
-                if (!m_graphicsBlockCompressionPass->ExecuteComputePass(commandList, compressionPass,
-                    colorTexture, inputFormat, 0, blockTexture, 0, nullptr))
-                    return false;
-            }
-        }
+// Hashes everything that affects the transcoded tiles of a material, the result identifies the material
+// in the tile cache keys, including the tiles written to disk by previous runs.
+static uint64_t GetTileCacheMaterialHash(NtcMaterial const& material, bool fusedBlockEncoding)
+{
+    Fnv1aHash hash;
+
+    ntc::TextureSetDesc const& textureSetDesc = material.textureSetMetadata->Get()->GetDesc();
+    hash.AddValue(material.sourceHash);
+    hash.AddValue(textureSetDesc.width);
+    hash.AddValue(textureSetDesc.height);
+    hash.AddValue(textureSetDesc.mips);
+    hash.AddValue(material.latentStreamRange.offset);
+    hash.AddValue(material.latentStreamRange.size);
+    hash.AddValue(material.weightType);
+    hash.AddValue(fusedBlockEncoding);
+    for (TextureTranscodeTask const& transcodeTask : material.transcodeMapping)
+    {
+        float const quality = transcodeTask.metadata
+            ? transcodeTask.metadata->GetBlockCompressionQuality()
+            : ntc::BlockCompressionMaxQuality;
+        hash.AddValue(transcodeTask.bcFormat);
+        hash.AddValue(transcodeTask.firstChannel);
+        hash.AddValue(transcodeTask.numChannels);
+        hash.AddValue(transcodeTask.sRGB);
+        hash.AddValue(quality);
     }
-    commandList->endMarker();
 
-    // Phase 4 - Copy tiles to the destination tiled resources
+    return hash.Get();
+}
 
-    commandList->beginMarker("Transcode Tiles: Copy to Tiled Resources");
+bool NtcMaterialLoader::TileCacheShelf::Allocate(int width, int height, int& outX, int& outY)
+{
+    if (width > g_tileCacheStagingSize)
+        return false;
 
-    // Transition textures for copying
-    colorTextureIndex = 0;
-    blockTextureIndex = 0;
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
-    {
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
-        const nvfeedback::FeedbackTextureTileInfo tileInfo = transcodeTile.tileInfo;
-        const NtcMaterial& material = *transcodeTile.material;
-        int textureCount = int(material.transcodeMapping.size());
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    if (x + width > g_tileCacheStagingSize)
+    {
+        x = 0;
+        y += this->height;
+        this->height = 0;
+    }
+
+    if (y + height > g_tileCacheStagingSize)
+        return false;
+
+    outX = x;
+    outY = y;
+    x += width;
+    this->height = std::max(this->height, height);
+    return true;
+}
+
+bool NtcMaterialLoader::EnableFeedbackTileCache(uint64_t memoryBudget, fs::path const& diskDirectory)
+{
+    std::lock_guard lockGuard(m_transcodeAtlasMutex);
+
+    m_tileCache = std::make_unique<FeedbackTileCache>(memoryBudget);
+    if (!diskDirectory.empty() && !m_tileCache->SetDiskDirectory(diskDirectory))
+    {
+        log::warning("Cannot use '%s' as the feedback tile cache directory.", diskDirectory.generic_string().c_str());
+        return false;
+    }
+
+    std::lock_guard statsLockGuard(m_tileCacheStatsMutex);
+    m_tileCacheStats = m_tileCache->GetStats();
+    return true;
+}
+
+FeedbackTileCacheStats NtcMaterialLoader::GetFeedbackTileCacheStats()
+{
+    std::lock_guard lockGuard(m_tileCacheStatsMutex);
+    return m_tileCacheStats;
+}
+
+void NtcMaterialLoader::BeginFrame()
+{
+    std::lock_guard lockGuard(m_transcodeAtlasMutex);
+    if (m_tileCacheFrames.empty())
+        return;
+
+    ++m_tileCacheFrame;
+    m_tileCacheUploadShelves = {};
+    m_tileCacheReadbackShelves = {};
+
+    // The readback copies recorded a full ring ago are finished, store their tiles in the cache
+    TileCacheFrame& frame = m_tileCacheFrames[m_tileCacheFrame % g_tileCacheFrameLatency];
+    if (frame.stores.empty())
+        return;
+
+    std::array<uint8_t const*, 2> mappedData {};
+    std::array<size_t, 2> rowPitch {};
+    for (int format = 0; format < 2; ++format)
+    {
+        mappedData[format] = static_cast<uint8_t const*>(m_device->mapStagingTexture(frame.readback[format],
+            nvrhi::TextureSlice(), nvrhi::CpuAccessMode::Read, &rowPitch[format]));
+    }
+
+    for (TileCacheStore& store : frame.stores)
+    {
+        std::vector<uint8_t> payload;
+        bool mapped = true;
+        for (TileCachePlacement const& placement : store.placements)
         {
-            const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
-            nvrhi::ITexture* pDestTexture = (material.*transcodeTask.pFeedbackTexture)->GetReservedTexture();
-            commandList->setTextureState(pDestTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopyDest);
-            
-            nvrhi::TextureHandle colorTexture = m_texTranscodeTiles[colorTextureIndices[colorTextureIndex++]];
-            if (compressThisTexture[tileIndex])
+            uint8_t const* src = mappedData[placement.format];
+            mapped = mapped && src;
+            if (!src)
+                break;
+
+            size_t const rowSize = size_t(placement.widthInBlocks) * (placement.format ? 16 : 8);
+            for (int row = 0; row < placement.heightInBlocks; ++row)
             {
-                nvrhi::TextureHandle blockTexture = m_texTranscodeTiles[blockTextureIndices[blockTextureIndex++]];
-                commandList->setTextureState(blockTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopySource);
+                uint8_t const* rowData = src + size_t(placement.y + row) * rowPitch[placement.format] +
+                    size_t(placement.x) * (placement.format ? 16 : 8);
+                payload.insert(payload.end(), rowData, rowData + rowSize);
             }
-            else
+        }
+
+        if (mapped)
+            m_tileCache->Store(store.key, std::move(payload));
+    }
+
+    for (int format = 0; format < 2; ++format)
+    {
+        if (mappedData[format])
+            m_device->unmapStagingTexture(frame.readback[format]);
+    }
+    frame.stores.clear();
+
+    std::lock_guard statsLockGuard(m_tileCacheStatsMutex);
+    m_tileCacheStats = m_tileCache->GetStats();
+}
+
+bool NtcMaterialLoader::RestoreCachedTiles(std::vector<TranscodeTileInfo> const& tiles,
+    nvrhi::ICommandList* commandList, std::vector<TranscodeTileInfo>& outMissedTiles)
+{
+    if (m_tileCacheFrames.empty())
+    {
+        m_tileCacheFrames.resize(g_tileCacheFrameLatency);
+        uint64_t stagingBytes = 0;
+        for (TileCacheFrame& frame : m_tileCacheFrames)
+        {
+            for (int format = 0; format < 2; ++format)
             {
-                commandList->setTextureState(colorTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopySource);
+                nvrhi::TextureDesc stagingDesc = nvrhi::TextureDesc()
+                    .setDimension(nvrhi::TextureDimension::Texture2D)
+                    .setWidth(g_tileCacheStagingSize)
+                    .setHeight(g_tileCacheStagingSize)
+                    .setFormat(format ? nvrhi::Format::RGBA32_UINT : nvrhi::Format::RG32_UINT)
+                    .setDebugName("Tile cache upload");
+                frame.upload[format] = m_device->createStagingTexture(stagingDesc, nvrhi::CpuAccessMode::Write);
+                stagingDesc.setDebugName("Tile cache readback");
+                frame.readback[format] = m_device->createStagingTexture(stagingDesc, nvrhi::CpuAccessMode::Read);
+                if (!frame.upload[format] || !frame.readback[format])
+                {
+                    m_tileCacheFrames.clear();
+                    return false;
+                }
+                stagingBytes += 2 * uint64_t(g_tileCacheStagingSize * g_tileCacheStagingSize) * (format ? 16 : 8);
             }
         }
+
+        if (m_memoryTracker)
+            m_memoryTracker->SetExternalAllocation(MemoryCategory::TranscodeStaging, "Feedback Tile Cache",
+                stagingBytes);
     }
-    commandList->commitBarriers();
 
-    colorTextureIndex = 0;
-    blockTextureIndex = 0;
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
+    TileCacheFrame& frame = m_tileCacheFrames[m_tileCacheFrame % g_tileCacheFrameLatency];
+
+    // Phase 1 - Look up the requested tiles and write the cached ones into the upload staging textures.
+    // The payloads are copied right away because looking up the following tiles may evict them.
+    // Earlier calls on the same frame may have used parts of the staging textures already. Mapping them again
+    // waits for the GPU when those calls were submitted, which only happens while materials are loading.
+
+    struct RestoredTile
     {
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
-        const nvfeedback::FeedbackTextureTileInfo tileInfo = transcodeTile.tileInfo;
-        const NtcMaterial& material = *transcodeTile.material;
+        TranscodeTileInfo const* tile;
+        std::vector<TileCachePlacement> placements;
+    };
+    std::vector<RestoredTile> restoredTiles;
+    std::array<uint8_t*, 2> mappedData {};
+    std::array<size_t, 2> rowPitch {};
+    NtcMaterial const* hashedMaterial = nullptr;
+    uint64_t materialHash = 0;
 
-        ntc::ITextureSetMetadata* textureSetMetadata = material.textureSetMetadata->Get();
-        ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
-        const uint32_t mipWidth = std::max(1, textureSetDesc.width >> tileInfo.mip);
-        const uint32_t mipHeight = std::max(1, textureSetDesc.height >> tileInfo.mip);
-        int textureCount = int(material.transcodeMapping.size());
-        assert(textureCount <= g_maxTileStagingTextures); // Maximum number of textures supported
+    for (TranscodeTileInfo const& transcodeTile : tiles)
+    {
+        NtcMaterial const& material = *transcodeTile.material;
+        if (!IsTileCacheable(material, true))
+        {
+            outMissedTiles.push_back(transcodeTile);
+            continue;
+        }
 
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+        if (hashedMaterial != &material)
         {
-            const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
-            nvrhi::ITexture* pDestTexture = (material.*transcodeTask.pFeedbackTexture)->GetReservedTexture();
+            materialHash = GetTileCacheMaterialHash(material, m_fusedBlockEncoding);
+            hashedMaterial = &material;
+        }
+
+        // Tiles can be larger than the mip, see TranscodeTiles
+        nvfeedback::FeedbackTextureTileInfo const& tileInfo = transcodeTile.tileInfo;
+        ntc::TextureSetDesc const& textureSetDesc = material.textureSetMetadata->Get()->GetDesc();
+        int const widthInBlocks = (std::min(int(tileInfo.widthInTexels),
+            std::max(1, textureSetDesc.width >> tileInfo.mip)) + 3) / 4;
+        int const heightInBlocks = (std::min(int(tileInfo.heightInTexels),
+            std::max(1, textureSetDesc.height >> tileInfo.mip)) + 3) / 4;
+
+        FeedbackTileCacheKey const key { materialHash, tileInfo.mip, tileInfo.xInTexels, tileInfo.yInTexels };
+        std::vector<uint8_t> const* payload = m_tileCache->Find(key);
+
+        RestoredTile restoredTile { &transcodeTile };
+        size_t payloadSize = 0;
+        for (int textureIndex = 0; payload && textureIndex < int(material.transcodeMapping.size()); ++textureIndex)
+        {
+            uint32_t colorIndex, blockIndex;
+            GetTranscodeAtlasIndices(material.transcodeMapping[textureIndex], textureIndex, colorIndex, blockIndex);
+
+            TileCachePlacement placement;
+            placement.format = (blockIndex >= m_texAtlasBlocksRGBAOffset) ? 1 : 0;
+            placement.widthInBlocks = widthInBlocks;
+            placement.heightInBlocks = heightInBlocks;
+            if (!m_tileCacheUploadShelves[placement.format].Allocate(widthInBlocks, heightInBlocks, placement.x, placement.y))
+            {
+                payload = nullptr;
+                break;
+            }
+            restoredTile.placements.push_back(placement);
+            payloadSize += size_t(widthInBlocks * heightInBlocks) * (placement.format ? 16 : 8);
+        }
+
+        // Tiles that don't fit into the staging textures on this frame are transcoded instead
+        if (!payload || payload->size() != payloadSize)
+        {
+            outMissedTiles.push_back(transcodeTile);
+            continue;
+        }
+
+        uint8_t const* src = payload->data();
+        for (TileCachePlacement const& placement : restoredTile.placements)
+        {
+            if (!mappedData[placement.format])
+            {
+                mappedData[placement.format] = static_cast<uint8_t*>(m_device->mapStagingTexture(
+                    frame.upload[placement.format], nvrhi::TextureSlice(), nvrhi::CpuAccessMode::Write,
+                    &rowPitch[placement.format]));
+                if (!mappedData[placement.format])
+                    return false;
+            }
+
+            size_t const rowSize = size_t(placement.widthInBlocks) * (placement.format ? 16 : 8);
+            for (int row = 0; row < placement.heightInBlocks; ++row)
+            {
+                uint8_t* rowData = mappedData[placement.format] +
+                    size_t(placement.y + row) * rowPitch[placement.format] +
+                    size_t(placement.x) * (placement.format ? 16 : 8);
+                memcpy(rowData, src, rowSize);
+                src += rowSize;
+            }
+        }
+
+        restoredTiles.push_back(std::move(restoredTile));
+    }
+
+    for (int format = 0; format < 2; ++format)
+    {
+        if (mappedData[format])
+            m_device->unmapStagingTexture(frame.upload[format]);
+    }
+
+    // Phase 2 - Copy the cached tiles into the tiled textures
+
+    if (!restoredTiles.empty())
+    {
+        commandList->beginMarker("Transcode Tiles: Restore Cached Tiles");
+        TraceScope traceScope(m_traceRecorder, "Restore Cached Tiles", commandList);
+
+        for (RestoredTile const& restoredTile : restoredTiles)
+        {
+            NtcMaterial const& material = *restoredTile.tile->material;
+            for (TextureTranscodeTask const& transcodeTask : material.transcodeMapping)
+            {
+                commandList->setTextureState((material.*transcodeTask.pFeedbackTexture)->GetReservedTexture(),
+                    nvrhi::AllSubresources, nvrhi::ResourceStates::CopyDest);
+            }
+        }
+        commandList->commitBarriers();
+
+        for (RestoredTile const& restoredTile : restoredTiles)
+        {
+            NtcMaterial const& material = *restoredTile.tile->material;
+            nvfeedback::FeedbackTextureTileInfo const& tileInfo = restoredTile.tile->tileInfo;
 
             nvrhi::TextureSlice textureSliceDst = {};
             textureSliceDst.x = tileInfo.xInTexels;
@@ -683,202 +1381,238 @@ bool NtcMaterialLoader::TranscodeTiles(const std::vector<TranscodeTileInfo>& til
             textureSliceDst.height = tileInfo.heightInTexels;
             textureSliceDst.depth = 1;
 
-            nvrhi::TextureHandle colorTexture = m_texTranscodeTiles[colorTextureIndices[colorTextureIndex++]];
-
-            if (compressThisTexture[tileIndex])
+            for (int textureIndex = 0; textureIndex < int(material.transcodeMapping.size()); ++textureIndex)
             {
-                nvrhi::TextureHandle blockTexture = m_texTranscodeTiles[blockTextureIndices[blockTextureIndex++]];
-
-                nvrhi::TextureSlice textureSliceSrc = {};
-                textureSliceSrc.x = 0;
-                textureSliceSrc.y = 0;
-                textureSliceSrc.z = 0;
-                textureSliceSrc.mipLevel = 0;
-                textureSliceSrc.width = (tileInfo.widthInTexels + 3) / 4;
-                textureSliceSrc.height = (tileInfo.heightInTexels + 3) / 4;
-                textureSliceSrc.depth = 1;
+                TileCachePlacement const& placement = restoredTile.placements[textureIndex];
 
-                commandList->copyTexture(pDestTexture, textureSliceDst, blockTexture, textureSliceSrc);
-            }
-            else
-            {
                 nvrhi::TextureSlice textureSliceSrc = {};
-                textureSliceSrc.x = 0;
-                textureSliceSrc.y = 0;
+                textureSliceSrc.x = placement.x;
+                textureSliceSrc.y = placement.y;
                 textureSliceSrc.z = 0;
                 textureSliceSrc.mipLevel = 0;
-                textureSliceSrc.width = tileInfo.widthInTexels;
-                textureSliceSrc.height = tileInfo.heightInTexels;
+                textureSliceSrc.width = placement.widthInBlocks;
+                textureSliceSrc.height = placement.heightInBlocks;
                 textureSliceSrc.depth = 1;
 
-                commandList->copyTexture(pDestTexture, textureSliceDst, colorTexture, textureSliceSrc);
+                nvrhi::ITexture* pDestTexture =
+                    (material.*material.transcodeMapping[textureIndex].pFeedbackTexture)->GetReservedTexture();
+                commandList->copyTexture(pDestTexture, textureSliceDst, frame.upload[placement.format],
+                    textureSliceSrc);
             }
         }
-    }
-    commandList->endMarker();
 
+        commandList->endMarker();
+    }
 
+    std::lock_guard lockGuard(m_tileCacheStatsMutex);
+    m_tileCacheStats = m_tileCache->GetStats();
     return true;
 }
 
-bool NtcMaterialLoader::TranscodeMaterial(ntc::IStream* ntcFile, ntc::ITextureSetMetadata* textureSetMetadata,
-    NtcMaterial& material, nvrhi::ICommandList* commandList, bool enableBlockCompression)
+void NtcMaterialLoader::ReadBackTilesForCache(NtcMaterial const& material, uint32_t mipLevel,
+    std::vector<AtlasTile> const& atlasTiles, uint32_t const* blockTextureIndices,
+    nvrhi::ICommandList* commandList)
 {
-    if (material.transcodeMapping.empty())
-        return true;
+    if (m_tileCacheFrames.empty())
+        return;
 
+    TileCacheFrame& frame = m_tileCacheFrames[m_tileCacheFrame % g_tileCacheFrameLatency];
+    uint64_t const materialHash = GetTileCacheMaterialHash(material, m_fusedBlockEncoding);
     int const textureCount = int(material.transcodeMapping.size());
 
-    // Phase 1 - Create textures (color, block, BCn) and write descriptors for NTC decompression
-
-    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
-    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    for (AtlasTile const& atlasTile : atlasTiles)
     {
-        TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
-        std::string const materialTextureName = material.name + ":" + std::string(transcodeTask.name);
-
-        // Create the color texture
+        TileCacheStore store;
+        store.key = { materialHash, mipLevel, atlasTile.tileInfo.xInTexels, atlasTile.tileInfo.yInTexels };
 
-        nvrhi::TextureDesc colorTextureDesc = nvrhi::TextureDesc()
-            .setDimension(nvrhi::TextureDimension::Texture2D)
-            .setWidth(textureSetDesc.width)
-            .setHeight(textureSetDesc.height)
-            .setMipLevels(textureSetDesc.mips)
-            .setFormat((transcodeTask.numChannels == 1)
-                ? nvrhi::Format::R8_UNORM
-                : transcodeTask.sRGB
-                    ? nvrhi::Format::SRGBA8_UNORM
-                    : nvrhi::Format::RGBA8_UNORM)
-            .setDebugName(materialTextureName)
-            .setIsUAV(true)
-            .setIsTypeless(true)
-            .setInitialState(nvrhi::ResourceStates::ShaderResource)
-            .setKeepInitialState(true);
+        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+        {
+            TileCachePlacement placement;
+            placement.format = (blockTextureIndices[textureIndex] >= m_texAtlasBlocksRGBAOffset) ? 1 : 0;
+            placement.widthInBlocks = (atlasTile.width + 3) / 4;
+            placement.heightInBlocks = (atlasTile.height + 3) / 4;
 
-        transcodeTask.color = m_device->createTexture(colorTextureDesc);
-        if (!transcodeTask.color)
-            return false;
+            // The staging textures are full, the remaining tiles of this frame are not cached
+            if (!m_tileCacheReadbackShelves[placement.format].Allocate(placement.widthInBlocks,
+                placement.heightInBlocks, placement.x, placement.y))
+                return;
 
-        bool compressThisTexture = enableBlockCompression && transcodeTask.bcFormat != ntc::BlockCompressedFormat::None;
+            store.placements.push_back(placement);
+        }
 
-        if (compressThisTexture)
+        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
         {
-            // Create the BCn texture
+            TileCachePlacement const& placement = store.placements[textureIndex];
 
-            nvrhi::TextureDesc compressedTextureDesc = nvrhi::TextureDesc()
-                .setDimension(nvrhi::TextureDimension::Texture2D)
-                .setFormat(transcodeTask.nvrhiBcFormat)
-                .setWidth(textureSetDesc.width)
-                .setHeight(textureSetDesc.height)
-                .setMipLevels(textureSetDesc.mips)
-                .setDebugName(materialTextureName)
-                .setInitialState(nvrhi::ResourceStates::ShaderResource)
-                .setKeepInitialState(true);
-
-            transcodeTask.compressed = m_device->createTexture(compressedTextureDesc);
-            if (!transcodeTask.compressed)
-                return false;
+            nvrhi::TextureSlice textureSliceDst = {};
+            textureSliceDst.x = placement.x;
+            textureSliceDst.y = placement.y;
+            textureSliceDst.z = 0;
+            textureSliceDst.mipLevel = 0;
+            textureSliceDst.width = placement.widthInBlocks;
+            textureSliceDst.height = placement.heightInBlocks;
+            textureSliceDst.depth = 1;
 
-            // Create the block texture
+            nvrhi::TextureSlice textureSliceSrc = textureSliceDst;
+            textureSliceSrc.x = atlasTile.atlasX / 4;
+            textureSliceSrc.y = atlasTile.atlasY / 4;
 
-            bool const isSmallBlock =
-                (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC1) ||
-                (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC4);
+            commandList->copyTexture(frame.readback[placement.format], textureSliceDst,
+                m_texTranscodeAtlases[blockTextureIndices[textureIndex]], textureSliceSrc);
+        }
 
-            nvrhi::TextureDesc blockTextureDesc = nvrhi::TextureDesc()
-                .setDimension(nvrhi::TextureDimension::Texture2D)
-                .setWidth((textureSetDesc.width + 3) / 4)
-                .setHeight((textureSetDesc.height + 3) / 4)
-                .setFormat(isSmallBlock ? nvrhi::Format::RG32_UINT : nvrhi::Format::RGBA32_UINT)
-                .setDebugName(materialTextureName)
-                .setIsUAV(true)
-                .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
-                .setKeepInitialState(true);
+        frame.stores.push_back(std::move(store));
+    }
+}
 
-            transcodeTask.blocks = m_device->createTexture(blockTextureDesc);
-            if (!transcodeTask.blocks)
-                return false;
-        }
-        
-        // Descriptors for all mip levels of one texture are packed together
-        transcodeTask.mipZeroDescriptor = textureSetDesc.mips * textureIndex;
+// Reports the texture whose job failed in GraphicsBlockCompressionPass::ExecuteBatch(...). The last LibNTC error
+// message only describes the failure when MakeBlockCompressionComputePass returned an error.
+static void LogBlockCompressionFailure(NtcMaterial const& material, TextureTranscodeTask const* transcodeTask,
+    ntc::Status status)
+{
+    if (status != ntc::Status::Ok)
+    {
+        log::warning("Failed to compress texture '%s' of material '%s', call to MakeBlockCompressionComputePass "
+            "failed, error code = %s: %s", transcodeTask->name, material.name.c_str(), ntc::StatusToString(status),
+            ntc::GetLastErrorMessage());
+    }
+    else
+    {
+        log::warning("Failed to compress texture '%s' of material '%s', cannot create the BCn compression pipeline "
+            "or binding set.", transcodeTask->name, material.name.c_str());
+    }
+}
 
-        // Write descriptors for all mips of the color texture
-        for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
-        {
-            int descriptorIndex = transcodeTask.mipZeroDescriptor + mipLevel;
+bool NtcMaterialLoader::TranscodeAtlas(NtcMaterial const& material, uint32_t mipLevel,
+    std::vector<AtlasRun> const& runs, std::vector<AtlasTile> const& atlasTiles, nvrhi::ICommandList* commandList,
+    bool enableBlockCompression)
+{
+    if (runs.empty())
+        return true;
 
-            nvrhi::BindingSetItem descriptor = nvrhi::BindingSetItem::Texture_UAV(
-                descriptorIndex,
-                transcodeTask.color,
-                (transcodeTask.numChannels == 1)
-                    ? nvrhi::Format::R8_UNORM
-                    : nvrhi::Format::RGBA8_UNORM, // Always use non-sRGB formats so that we can create a UAV
-                nvrhi::TextureSubresourceSet().setBaseMipLevel(mipLevel));
+    int const textureCount = int(material.transcodeMapping.size());
 
-            m_graphicsDecompressionPass->WriteDescriptor(descriptor);
-        }
+    // Find the area of the atlases that is occupied by the runs, BCn compression will process only that area
+    int usedWidth = 0;
+    int usedHeight = 0;
+    for (AtlasRun const& run : runs)
+    {
+        usedWidth = std::max(usedWidth, run.atlasX + run.srcRect.width);
+        usedHeight = std::max(usedHeight, run.atlasY + run.srcRect.height);
+    }
 
-        // Transition the texture to the UAV state because NVRHI won't do that when resources are accessed
-        // through a descriptor table. Note that there is no need to transition it back to SRV after decompression
-        // because the next operations are using regular binding sets. There is also no need for commitBarriers()
-        // because that's called by the decompression dispatch call.
-        commandList->setTextureState(transcodeTask.color, nvrhi::AllSubresources,
-            nvrhi::ResourceStates::UnorderedAccess);
-        
-        // Create a LoadedTexture object to attach the texture to the material
-        std::shared_ptr<engine::LoadedTexture> loadedTexture = std::make_shared<engine::LoadedTexture>();
-        loadedTexture->texture = compressThisTexture ? transcodeTask.compressed : transcodeTask.color;
+    // Indices which map every textureIndex into the list of staging atlases
+    std::array<uint32_t, g_maxTileStagingTextures> colorTextureIndices;
+    std::array<uint32_t, g_maxTileStagingTextures> blockTextureIndices;
+    std::array<bool, g_maxTileStagingTextures> compressThisTexture;
+    std::array<bool, g_maxTileStagingTextures> fuseThisTexture;
 
-        // Count the final texture size in the material's memory consumption metric
-        size_t const textureMemorySize = m_device->getTextureMemoryRequirements(loadedTexture->texture).size;
-        material.transcodedMemorySize += textureMemorySize;
-        
-        // Bind the created texture object to the material texture slot
-        material.*transcodeTask.pMaterialTexture = loadedTexture;
+    commandList->beginMarker("Transcode Tiles: NTC Decompression");
+    // The phase scope is a std::optional so that the early returns below close it
+    std::optional<TraceScope> phaseScope;
+    phaseScope.emplace(m_traceRecorder, "NTC Decompression", commandList);
+
+    // Phase 1 - Select the staging atlases for every texture and make state transitions
+
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+
+        GetTranscodeAtlasIndices(transcodeTask, textureIndex,
+            colorTextureIndices[textureIndex], blockTextureIndices[textureIndex]);
+
+        compressThisTexture[textureIndex] = transcodeTask.bcFormat != ntc::BlockCompressedFormat::None
+            && enableBlockCompression;
+
+        // BC1, BC4 and BC5 textures can be encoded by the decompression shader directly into the block atlas
+        fuseThisTexture[textureIndex] = compressThisTexture[textureIndex]
+            && UseFusedBlockEncoding(material, transcodeTask);
+
+        // Transition to UAV because NVRHI won't do that when resources are accessed through a descriptor table.
+        // Consecutive runs write into different areas of the atlas, so disable the UAV barriers between them.
+        nvrhi::ITexture* outputTexture = m_texTranscodeAtlases[fuseThisTexture[textureIndex]
+            ? blockTextureIndices[textureIndex]
+            : colorTextureIndices[textureIndex]];
+        commandList->setTextureState(outputTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::UnorderedAccess);
+        commandList->setEnableUavBarriersForTexture(outputTexture, false);
     }
 
-    // Submit the texture transitions performed above via setTextureState(...) to the command list.
-    // This is not really necessary because the next call to commandList->setComputeState(...) will do it,
-    // but let's be explicit.
     commandList->commitBarriers();
 
-    // Phase 2 - Run NTC decompression
+    // Phase 2 - Run NTC decompression, one dispatch per run of adjacent tiles, plus one fused decompression
+    // and encoding dispatch per run for every texture that NtcTranscodePass supports.
+    // The descriptors for the color atlases are written in Init, their indices match the atlas indices.
 
     // Make sure that the latent and weight buffers have already been created
     assert(material.ntcLatentsBuffer);
     assert(material.ntcWeightsBuffer);
 
-    m_graphicsDecompressionPass->SetInputBuffer(material.ntcLatentsBuffer);
-    m_graphicsDecompressionPass->SetWeightBuffer(material.ntcWeightsBuffer);
+    // The passes and the context are shared with the I/O threads and the on-load transcoding
+    std::unique_lock contextLock(m_contextMutex);
+
+    m_graphicsDecompressionPass->SetInputBuffer(material.ntcLatentsBuffer, material.ntcLatentsRange);
+    m_graphicsDecompressionPass->SetWeightBuffer(material.ntcWeightsBuffer, material.ntcWeightsRange);
 
-    // Pre-fill the OutputTextureDesc array for decoding of all mip levels
-    std::vector<ntc::OutputTextureDesc> outputTextureDescs;
-    outputTextureDescs.resize(textureCount);
+    // The decompression pass only writes the textures that are not encoded by the fused pass
+    std::array<ntc::OutputTextureDesc, g_maxTileStagingTextures> outputTextureDescs;
+    int decompressedTextureCount = 0;
     for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
     {
-        TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
-        ntc::OutputTextureDesc& outputDesc = outputTextureDescs[textureIndex];
+        if (fuseThisTexture[textureIndex])
+            continue;
+
+        const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+        ntc::OutputTextureDesc& outputDesc = outputTextureDescs[decompressedTextureCount++];
         outputDesc.firstChannel = transcodeTask.firstChannel;
         outputDesc.numChannels = transcodeTask.numChannels;
-        outputDesc.descriptorIndex = transcodeTask.mipZeroDescriptor;
+        outputDesc.descriptorIndex = colorTextureIndices[textureIndex];
         outputDesc.rgbColorSpace = transcodeTask.sRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
         outputDesc.ditherScale = 1.f / 255.f;
     }
 
-    for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+    // The fused jobs for all runs and textures go into one dispatch per format.
+    // The runs start at multiples of 4 texels in the atlas, so they map to whole blocks.
+    std::vector<NtcTranscodeJob> transcodeJobs;
+    for (AtlasRun const& run : runs)
     {
-        // Obtain the description of the decompression pass from LibNTC.
-        // The description includes the shader code, weights, and constants.
+        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+        {
+            if (!fuseThisTexture[textureIndex])
+                continue;
+
+            NtcTranscodeJob& job = transcodeJobs.emplace_back();
+            job.transcodeTask = &material.transcodeMapping[textureIndex];
+            job.srcRect = run.srcRect;
+            job.dstBlockX = run.atlasX / 4;
+            job.dstBlockY = run.atlasY / 4;
+            job.outputDescriptorIndex = blockTextureIndices[textureIndex] - m_texAtlasBlocksRGOffset;
+        }
+    }
+
+    if (!m_transcodePass->ExecuteBatch(commandList, material, mipLevel, transcodeJobs))
+        return false;
+
+    // When all textures are fused, there is nothing left for the decompression pass
+    for (size_t runIndex = 0; decompressedTextureCount != 0 && runIndex < runs.size(); ++runIndex)
+    {
+        AtlasRun const& run = runs[runIndex];
+
+        ntc::Rect rectDecompress = run.srcRect;
+
+        ntc::Point offsetDecompress;
+        offsetDecompress.x = run.atlasX;
+        offsetDecompress.y = run.atlasY;
+
         ntc::MakeDecompressionComputePassParameters decompressionParams;
-        decompressionParams.textureSetMetadata = textureSetMetadata;
+        decompressionParams.textureSetMetadata = material.textureSetMetadata->Get();
         decompressionParams.latentStreamRange = material.latentStreamRange;
         decompressionParams.mipLevel = mipLevel;
-        // This index is added to descriptorIndex from the outputTextureDescs array, so the indexing math works out
-        decompressionParams.firstOutputDescriptorIndex = mipLevel;
+        decompressionParams.firstOutputDescriptorIndex = 0;
         decompressionParams.pOutputTextures = outputTextureDescs.data();
-        decompressionParams.numOutputTextures = int(outputTextureDescs.size());
+        decompressionParams.numOutputTextures = decompressedTextureCount;
         decompressionParams.weightType = ntc::InferenceWeightType(material.weightType);
+        decompressionParams.pSrcRect = &rectDecompress;
+        decompressionParams.pDstOffset = &offsetDecompress;
         ntc::ComputePassDesc decompressionPass;
         ntc::Status ntcStatus = m_ntcContext->MakeDecompressionComputePass(decompressionParams, &decompressionPass);
         if (ntcStatus != ntc::Status::Ok)
@@ -888,87 +1622,424 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IStream* ntcFile, ntc::ITextureSe
             return false;
         }
 
-        // Execute the compute pass to decompress the texture.
-        // Note: ExecuteComputePass is application code (not LibNTC) and it caches PSOs based on shader code pointers.
         m_graphicsDecompressionPass->ExecuteComputePass(commandList, decompressionPass);
     }
 
-    // Phase 3 - Compress all mips of the color textures into BCn, where necessary
-
-    for (TextureTranscodeTask const& transcodeTask : material.transcodeMapping)
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
     {
-        if (!transcodeTask.compressed)
-            continue;
+        uint32_t const outputTextureIndex = fuseThisTexture[textureIndex]
+            ? blockTextureIndices[textureIndex]
+            : colorTextureIndices[textureIndex];
+        commandList->setEnableUavBarriersForTexture(m_texTranscodeAtlases[outputTextureIndex], true);
+    }
 
-        float const alphaThreshold = 1.f / 255.f;
-        
-        for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
-        {
-            int const mipWidth = std::max(textureSetDesc.width >> mipLevel, 1);
-            int const mipHeight = std::max(textureSetDesc.height >> mipLevel, 1);
+    phaseScope.reset();
+    commandList->endMarker();
 
-            // Obtain the description of the BC compression pass from LibNTC.
-            ntc::MakeBlockCompressionComputePassParameters compressionParams;
-            compressionParams.srcRect.width = mipWidth;
-            compressionParams.srcRect.height = mipHeight;
-            compressionParams.dstFormat = transcodeTask.bcFormat;
-            compressionParams.alphaThreshold = alphaThreshold;
-            compressionParams.texture = transcodeTask.metadata;
-            compressionParams.quality = transcodeTask.metadata
-                ? transcodeTask.metadata->GetBlockCompressionQuality()
-                : ntc::BlockCompressionMaxQuality;
-            ntc::ComputePassDesc compressionPass;
-            ntc::Status ntcStatus = m_ntcContext->MakeBlockCompressionComputePass(compressionParams, &compressionPass);
+    // Phase 3 - Compress the used area of the color atlases into BCn, where necessary
 
-            if (ntcStatus != ntc::Status::Ok)
-            {
-                log::warning("Failed to make a block compression pass for material '%s', error code = %s: %s",
-                    material.name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-                return false;
-            }
+    commandList->beginMarker("Transcode Tiles: BCn Compression");
+    phaseScope.emplace(m_traceRecorder, "BCn Compression", commandList);
 
-            nvrhi::Format const inputFormat = (transcodeTask.numChannels == 1)
-                ? nvrhi::Format::R8_UNORM
-                : nvrhi::Format::RGBA8_UNORM;
+    // All textures are encoded in one batch, which makes the transitions at once, so that the compression
+    // dispatches for different textures are not separated by barriers and can overlap on the GPU
+    std::vector<BlockCompressionJob> compressionJobs;
+    std::vector<TextureTranscodeTask const*> compressionTasks;
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        if (!compressThisTexture[textureIndex] || fuseThisTexture[textureIndex])
+            continue;
 
-            // Execute the compute pass to compress the texture.
-            // Note: ExecuteComputePass is application code (not LibNTC) and it caches PSOs based on shader code pointers.
-            if (!m_graphicsBlockCompressionPass->ExecuteComputePass(commandList, compressionPass,
-                transcodeTask.color, inputFormat, mipLevel, transcodeTask.blocks, 0, nullptr))
-                return false;
-            
-            int const mipWidthBlocks = (mipWidth + 3) / 4;
-            int const mipHeightBlocks = (mipHeight + 3) / 4;
+        const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+        compressionTasks.push_back(&transcodeTask);
+
+        BlockCompressionJob& job = compressionJobs.emplace_back();
+        job.params.srcRect.width = usedWidth;
+        job.params.srcRect.height = usedHeight;
+        job.params.dstFormat = transcodeTask.bcFormat;
+        job.params.alphaThreshold = 1.f / 255.f;
+        job.params.texture = transcodeTask.metadata;
+        job.params.quality = transcodeTask.metadata
+            ? transcodeTask.metadata->GetBlockCompressionQuality()
+            : ntc::BlockCompressionMaxQuality;
+        job.inputTexture = m_texTranscodeAtlases[colorTextureIndices[textureIndex]];
+        job.inputFormat = (transcodeTask.numChannels == 1)
+            ? nvrhi::Format::R8_UNORM
+            : nvrhi::Format::RGBA8_UNORM;
+        job.outputTexture = m_texTranscodeAtlases[blockTextureIndices[textureIndex]];
+    }
 
-            commandList->copyTexture(transcodeTask.compressed, nvrhi::TextureSlice().setMipLevel(mipLevel),
-                transcodeTask.blocks, nvrhi::TextureSlice().setWidth(mipWidthBlocks).setHeight(mipHeightBlocks));
-        }
+    int failedJob = 0;
+    ntc::Status compressionStatus = ntc::Status::Ok;
+    if (!m_graphicsBlockCompressionPass->ExecuteBatch(commandList, m_ntcContext, compressionJobs, &failedJob,
+        &compressionStatus))
+    {
+        LogBlockCompressionFailure(material, compressionTasks[failedJob], compressionStatus);
+        return false;
     }
 
-    // Cleanup - release the intermediate textures
+    contextLock.unlock();
+    phaseScope.reset();
+    commandList->endMarker();
+
+    // Phase 4 - Copy tiles from the atlases to the destination tiled resources
 
-    for (TextureTranscodeTask& transcodeTask : material.transcodeMapping)
+    commandList->beginMarker("Transcode Tiles: Copy to Tiled Resources");
+    phaseScope.emplace(m_traceRecorder, "Copy to Tiled Resources", commandList);
+
+    // Transition textures for copying
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
     {
-        transcodeTask.ReleaseTextures();
+        const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+        nvrhi::ITexture* pDestTexture = (material.*transcodeTask.pFeedbackTexture)->GetReservedTexture();
+        commandList->setTextureState(pDestTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopyDest);
+
+        uint32_t const srcTextureIndex = compressThisTexture[textureIndex]
+            ? blockTextureIndices[textureIndex]
+            : colorTextureIndices[textureIndex];
+        commandList->setTextureState(m_texTranscodeAtlases[srcTextureIndex], nvrhi::AllSubresources,
+            nvrhi::ResourceStates::CopySource);
     }
+    commandList->commitBarriers();
 
-    // Clear the binding set caches to avoid storing binding sets for every texture after on-load transcoding
-    m_graphicsBlockCompressionPass->ClearBindingSetCache();
-    m_graphicsDecompressionPass->ClearBindingSetCache();
+    for (AtlasTile const& atlasTile : atlasTiles)
+    {
+        nvrhi::TextureSlice textureSliceDst = {};
+        textureSliceDst.x = atlasTile.tileInfo.xInTexels;
+        textureSliceDst.y = atlasTile.tileInfo.yInTexels;
+        textureSliceDst.z = 0;
+        textureSliceDst.mipLevel = mipLevel;
+        textureSliceDst.width = atlasTile.tileInfo.widthInTexels;
+        textureSliceDst.height = atlasTile.tileInfo.heightInTexels;
+        textureSliceDst.depth = 1;
 
-    // We use custom texture packing that puts metalness and roughness into one NTC "texture"
-    // with Metalness in R channel and Roughness in G channel.
-    // Note: Only set this flag when Inference on Load is active, otherwise we get rendering corruption
-    // because reference materials store ORM in that order.
-    material.metalnessInRedChannel = true;
+        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+        {
+            const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+            nvrhi::ITexture* pDestTexture = (material.*transcodeTask.pFeedbackTexture)->GetReservedTexture();
 
-    return true;
-}
+            nvrhi::TextureSlice textureSliceSrc = {};
+            textureSliceSrc.z = 0;
+            textureSliceSrc.mipLevel = 0;
+            textureSliceSrc.depth = 1;
 
-static void GetNtcDataSourceAndChannelMap(NtcMaterial const& material,
-    donut::engine::FilePathOrInlineData& ntcData, MaterialChannelMap& channelMap)
-{
-    // Initialize the channel shuffle map with default texture values.
+            if (compressThisTexture[textureIndex])
+            {
+                textureSliceSrc.x = atlasTile.atlasX / 4;
+                textureSliceSrc.y = atlasTile.atlasY / 4;
+                textureSliceSrc.width = (atlasTile.width + 3) / 4;
+                textureSliceSrc.height = (atlasTile.height + 3) / 4;
+
+                commandList->copyTexture(pDestTexture, textureSliceDst,
+                    m_texTranscodeAtlases[blockTextureIndices[textureIndex]], textureSliceSrc);
+            }
+            else
+            {
+                textureSliceSrc.x = atlasTile.atlasX;
+                textureSliceSrc.y = atlasTile.atlasY;
+                textureSliceSrc.width = atlasTile.width;
+                textureSliceSrc.height = atlasTile.height;
+
+                commandList->copyTexture(pDestTexture, textureSliceDst,
+                    m_texTranscodeAtlases[colorTextureIndices[textureIndex]], textureSliceSrc);
+            }
+        }
+    }
+
+    // The block atlases are still in the copy source state for the cache readback
+    if (m_tileCache && IsTileCacheable(material, enableBlockCompression))
+        ReadBackTilesForCache(material, mipLevel, atlasTiles, blockTextureIndices.data(), commandList);
+
+    phaseScope.reset();
+    commandList->endMarker();
+
+    return true;
+}
+
+bool NtcMaterialLoader::CreateTranscodedTextures(ntc::ITextureSetMetadata* textureSetMetadata,
+    NtcMaterial& material, bool enableBlockCompression)
+{
+    if (material.transcodeMapping.empty())
+        return true;
+
+    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+    for (TextureTranscodeTask& transcodeTask : material.transcodeMapping)
+    {
+        std::string const materialTextureName = material.name + ":" + std::string(transcodeTask.name);
+
+        bool const compressThisTexture = enableBlockCompression
+            && transcodeTask.bcFormat != ntc::BlockCompressedFormat::None;
+
+        nvrhi::TextureDesc textureDesc = nvrhi::TextureDesc()
+            .setDimension(nvrhi::TextureDimension::Texture2D)
+            .setWidth(textureSetDesc.width)
+            .setHeight(textureSetDesc.height)
+            .setMipLevels(textureSetDesc.mips)
+            .setDebugName(materialTextureName)
+            .setInitialState(nvrhi::ResourceStates::ShaderResource)
+            .setKeepInitialState(true);
+
+        if (compressThisTexture)
+        {
+            // Create the BCn texture
+            textureDesc.setFormat(transcodeTask.nvrhiBcFormat);
+
+            transcodeTask.compressed = m_device->createTexture(textureDesc);
+            if (!transcodeTask.compressed)
+                return false;
+        }
+        else
+        {
+            // Create the color texture. It's typeless so that it can be copied from the UNORM staging textures.
+            textureDesc
+                .setFormat((transcodeTask.numChannels == 1)
+                    ? nvrhi::Format::R8_UNORM
+                    : transcodeTask.sRGB
+                        ? nvrhi::Format::SRGBA8_UNORM
+                        : nvrhi::Format::RGBA8_UNORM)
+                .setIsTypeless(true);
+
+            transcodeTask.color = m_device->createTexture(textureDesc);
+            if (!transcodeTask.color)
+                return false;
+        }
+        
+        // Create a LoadedTexture object to attach the texture to the material
+        std::shared_ptr<engine::LoadedTexture> loadedTexture = std::make_shared<engine::LoadedTexture>();
+        loadedTexture->texture = compressThisTexture ? transcodeTask.compressed : transcodeTask.color;
+
+        // Count the final texture size in the material's memory consumption metric
+        size_t const textureMemorySize = m_device->getTextureMemoryRequirements(loadedTexture->texture).size;
+        material.transcodedMemorySize += textureMemorySize;
+        if (m_memoryTracker)
+            m_memoryTracker->TrackTexture(loadedTexture->texture, MemoryCategory::TranscodedTextures, material.name);
+        
+        // Bind the created texture object to the material texture slot
+        material.*transcodeTask.pMaterialTexture = loadedTexture;
+    }
+
+    // We use custom texture packing that puts metalness and roughness into one NTC "texture"
+    // with Metalness in R channel and Roughness in G channel.
+    // Note: Only set this flag when Inference on Load is active, otherwise we get rendering corruption
+    // because reference materials store ORM in that order.
+    material.metalnessInRedChannel = true;
+
+    return true;
+}
+
+bool NtcMaterialLoader::TranscodeMaterialRegion(ntc::ITextureSetMetadata* textureSetMetadata,
+    NtcMaterial& material, int mipLevel, ntc::Rect const& rect, nvrhi::ICommandList* commandList)
+{
+    int const textureCount = int(material.transcodeMapping.size());
+    assert(textureCount <= g_maxTileStagingTextures);
+    assert(rect.width <= g_transcodeRegionSize && rect.height <= g_transcodeRegionSize);
+
+    // Phase 1 - Select the staging atlases shared with TranscodeTiles, the region is placed at the origin.
+    // The state transitions below order the reuse of the same atlas by consecutive regions on the GPU.
+
+    std::array<uint32_t, g_maxTileStagingTextures> colorTextureIndices;
+    std::array<uint32_t, g_maxTileStagingTextures> blockTextureIndices;
+    std::array<bool, g_maxTileStagingTextures> fuseThisTexture;
+
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        TextureTranscodeTask const& transcodeTask = material.transcodeMapping[textureIndex];
+
+        GetTranscodeAtlasIndices(transcodeTask, textureIndex,
+            colorTextureIndices[textureIndex], blockTextureIndices[textureIndex]);
+
+        // BC1, BC4 and BC5 textures can be encoded by the decompression shader directly into the block atlas
+        fuseThisTexture[textureIndex] = transcodeTask.compressed
+            && UseFusedBlockEncoding(material, transcodeTask);
+
+        // Transition the texture to the UAV state because NVRHI won't do that when resources are accessed
+        // through a descriptor table.
+        commandList->setTextureState(m_texTranscodeAtlases[fuseThisTexture[textureIndex]
+                ? blockTextureIndices[textureIndex]
+                : colorTextureIndices[textureIndex]],
+            nvrhi::AllSubresources, nvrhi::ResourceStates::UnorderedAccess);
+    }
+
+    commandList->commitBarriers();
+
+    // Phase 2 - Run NTC decompression for the region into the staging color textures, or directly into
+    // the block atlases for the textures that NtcTranscodePass supports.
+    // The descriptors for the color atlases are written in Init, their indices match the atlas indices.
+
+    // Make sure that the latent and weight buffers have already been created
+    assert(material.ntcLatentsBuffer);
+    assert(material.ntcWeightsBuffer);
+
+    m_graphicsDecompressionPass->SetInputBuffer(material.ntcLatentsBuffer, material.ntcLatentsRange);
+    m_graphicsDecompressionPass->SetWeightBuffer(material.ntcWeightsBuffer, material.ntcWeightsRange);
+
+    std::vector<NtcTranscodeJob> transcodeJobs;
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        if (!fuseThisTexture[textureIndex])
+            continue;
+
+        NtcTranscodeJob& job = transcodeJobs.emplace_back();
+        job.transcodeTask = &material.transcodeMapping[textureIndex];
+        job.srcRect = rect;
+        job.outputDescriptorIndex = blockTextureIndices[textureIndex] - m_texAtlasBlocksRGOffset;
+    }
+
+    if (!m_transcodePass->ExecuteBatch(commandList, material, mipLevel, transcodeJobs))
+        return false;
+
+    // The decompression pass only writes the textures that are not encoded by the fused pass
+    std::array<ntc::OutputTextureDesc, g_maxTileStagingTextures> outputTextureDescs;
+    int decompressedTextureCount = 0;
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        if (fuseThisTexture[textureIndex])
+            continue;
+
+        TextureTranscodeTask const& transcodeTask = material.transcodeMapping[textureIndex];
+        ntc::OutputTextureDesc& outputDesc = outputTextureDescs[decompressedTextureCount++];
+        outputDesc.firstChannel = transcodeTask.firstChannel;
+        outputDesc.numChannels = transcodeTask.numChannels;
+        outputDesc.descriptorIndex = colorTextureIndices[textureIndex];
+        outputDesc.rgbColorSpace = transcodeTask.sRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
+        outputDesc.ditherScale = 1.f / 255.f;
+    }
+
+    if (decompressedTextureCount != 0)
+    {
+        ntc::Rect srcRect = rect;
+        ntc::Point dstOffset;
+        dstOffset.x = 0;
+        dstOffset.y = 0;
+
+        // Obtain the description of the decompression pass from LibNTC.
+        // The description includes the shader code, weights, and constants.
+        ntc::MakeDecompressionComputePassParameters decompressionParams;
+        decompressionParams.textureSetMetadata = textureSetMetadata;
+        decompressionParams.latentStreamRange = material.latentStreamRange;
+        decompressionParams.mipLevel = mipLevel;
+        decompressionParams.firstOutputDescriptorIndex = 0;
+        decompressionParams.pOutputTextures = outputTextureDescs.data();
+        decompressionParams.numOutputTextures = decompressedTextureCount;
+        decompressionParams.weightType = ntc::InferenceWeightType(material.weightType);
+        decompressionParams.pSrcRect = &srcRect;
+        decompressionParams.pDstOffset = &dstOffset;
+        ntc::ComputePassDesc decompressionPass;
+        ntc::Status ntcStatus = m_ntcContext->MakeDecompressionComputePass(decompressionParams, &decompressionPass);
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            log::warning("Failed to make a decompression pass for material '%s' mip %d, error code = %s: %s",
+                material.name.c_str(), mipLevel, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
+
+        // Execute the compute pass to decompress the texture.
+        // Note: ExecuteComputePass is application code (not LibNTC) and it caches PSOs based on shader code pointers.
+        m_graphicsDecompressionPass->ExecuteComputePass(commandList, decompressionPass);
+    }
+
+    // Phase 3 - Compress the region into BCn where necessary. All transitions are made before the first
+    // dispatch, and the copies into the final textures wait until all textures are compressed, so that
+    // the dispatches are not separated by barriers and can overlap on the GPU.
+
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        if (fuseThisTexture[textureIndex])
+            continue;
+
+        TextureTranscodeTask const& transcodeTask = material.transcodeMapping[textureIndex];
+        commandList->setTextureState(m_texTranscodeAtlases[colorTextureIndices[textureIndex]], nvrhi::AllSubresources,
+            transcodeTask.compressed ? nvrhi::ResourceStates::ShaderResource : nvrhi::ResourceStates::CopySource);
+        if (transcodeTask.compressed)
+            commandList->setTextureState(m_texTranscodeAtlases[blockTextureIndices[textureIndex]],
+                nvrhi::AllSubresources, nvrhi::ResourceStates::UnorderedAccess);
+    }
+    commandList->commitBarriers();
+
+    std::vector<BlockCompressionJob> compressionJobs;
+    std::vector<TextureTranscodeTask const*> compressionTasks;
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        TextureTranscodeTask const& transcodeTask = material.transcodeMapping[textureIndex];
+        if (!transcodeTask.compressed || fuseThisTexture[textureIndex])
+            continue;
+
+        // The BC compression passes are made by LibNTC for every job in ExecuteBatch
+        compressionTasks.push_back(&transcodeTask);
+        BlockCompressionJob& job = compressionJobs.emplace_back();
+        job.params.srcRect.width = rect.width;
+        job.params.srcRect.height = rect.height;
+        job.params.dstFormat = transcodeTask.bcFormat;
+        job.params.alphaThreshold = 1.f / 255.f;
+        job.params.texture = transcodeTask.metadata;
+        job.params.quality = transcodeTask.metadata
+            ? transcodeTask.metadata->GetBlockCompressionQuality()
+            : ntc::BlockCompressionMaxQuality;
+        job.inputTexture = m_texTranscodeAtlases[colorTextureIndices[textureIndex]];
+        job.inputFormat = (transcodeTask.numChannels == 1)
+            ? nvrhi::Format::R8_UNORM
+            : nvrhi::Format::RGBA8_UNORM;
+        job.outputTexture = m_texTranscodeAtlases[blockTextureIndices[textureIndex]];
+    }
+
+    int failedJob = 0;
+    ntc::Status compressionStatus = ntc::Status::Ok;
+    if (!m_graphicsBlockCompressionPass->ExecuteBatch(commandList, m_ntcContext, compressionJobs, &failedJob,
+        &compressionStatus))
+    {
+        LogBlockCompressionFailure(material, compressionTasks[failedJob], compressionStatus);
+        return false;
+    }
+
+    // Phase 4 - Copy the region into the final textures, with one set of barriers for all of them
+
+    nvrhi::TextureSlice dstSlice = {};
+    dstSlice.x = rect.left;
+    dstSlice.y = rect.top;
+    dstSlice.mipLevel = mipLevel;
+    dstSlice.width = rect.width;
+    dstSlice.height = rect.height;
+    dstSlice.depth = 1;
+
+    nvrhi::TextureSubresourceSet const dstSubresources(mipLevel, 1, 0, 1);
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        TextureTranscodeTask const& transcodeTask = material.transcodeMapping[textureIndex];
+        if (transcodeTask.compressed)
+        {
+            commandList->setTextureState(m_texTranscodeAtlases[blockTextureIndices[textureIndex]],
+                nvrhi::AllSubresources, nvrhi::ResourceStates::CopySource);
+            commandList->setTextureState(transcodeTask.compressed, dstSubresources, nvrhi::ResourceStates::CopyDest);
+        }
+        else
+            commandList->setTextureState(transcodeTask.color, dstSubresources, nvrhi::ResourceStates::CopyDest);
+    }
+    commandList->commitBarriers();
+
+    for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+    {
+        TextureTranscodeTask const& transcodeTask = material.transcodeMapping[textureIndex];
+        if (transcodeTask.compressed)
+        {
+            commandList->copyTexture(transcodeTask.compressed, dstSlice,
+                m_texTranscodeAtlases[blockTextureIndices[textureIndex]],
+                nvrhi::TextureSlice().setWidth((rect.width + 3) / 4).setHeight((rect.height + 3) / 4));
+        }
+        else
+        {
+            commandList->copyTexture(transcodeTask.color, dstSlice,
+                m_texTranscodeAtlases[colorTextureIndices[textureIndex]],
+                nvrhi::TextureSlice().setWidth(rect.width).setHeight(rect.height));
+        }
+    }
+
+    return true;
+}
+
+static void GetNtcDataSourceAndChannelMap(NtcMaterial const& material,
+    donut::engine::FilePathOrInlineData& ntcData, MaterialChannelMap& channelMap)
+{
+    // Initialize the channel shuffle map with default texture values.
     // Most textures have "1.0" as the no-effect value, except for the normal map, for which it is (0.5, 0.5, 1.0)
     // See also DefaultMaterialTextures() in <donut/shaders/scene_material.hlsli>
     channelMap.swizzle.fill(ntc::ShuffleSource::Constant(1.f));
@@ -1040,11 +2111,15 @@ static void GetNtcDataSourceAndChannelMap(NtcMaterial const& material,
         CHANNEL_TRANSMISSION);
 }
 
-bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFile, 
-    ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, nvrhi::ICommandList* commandList)
+bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::ITextureSetMetadata* textureSetMetadata,
+    NtcMaterial& material, nvrhi::ICommandList* commandList, nvrhi::ICommandList* uploadCommandList,
+    LatentResidency* latentResidency)
 {
     ntc::InferenceWeightType weightType;
-    if (m_coopVecFP8 && textureSetMetadata->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::CoopVecFP8))
+    if (m_preferredWeightType != ntc::InferenceWeightType::Unknown &&
+        textureSetMetadata->IsInferenceWeightTypeSupported(m_preferredWeightType))
+        weightType = m_preferredWeightType;
+    else if (m_coopVecFP8 && textureSetMetadata->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::CoopVecFP8))
         weightType = ntc::InferenceWeightType::CoopVecFP8;
     else if (m_coopVecInt8 && textureSetMetadata->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::CoopVecInt8))
         weightType = ntc::InferenceWeightType::CoopVecInt8;
@@ -1074,78 +2149,64 @@ bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFil
         return false;
     }
 
+    // Buffers written on the copy queue can't be transitioned to the shader states there, so they start
+    // in the copy destination state and get their final states in RetireCopyUploadBatches()
+    bool const copyQueueUpload = uploadCommandList != commandList;
+
     nvrhi::BufferDesc constantBufferDesc = nvrhi::BufferDesc()
-        .setByteSize(sizeof(inferenceData.constants))
+        .setByteSize(sizeof(NtcMaterialConstants))
         .setIsConstantBuffer(true)
-        .setInitialState(nvrhi::ResourceStates::ConstantBuffer)
-        .setKeepInitialState(true)
+        .setInitialState(copyQueueUpload ? nvrhi::ResourceStates::CopyDest : nvrhi::ResourceStates::ConstantBuffer)
+        .setKeepInitialState(!copyQueueUpload)
         .setDebugName(material.name + " constants");
     material.ntcConstantBuffer = m_device->createBuffer(constantBufferDesc);
     if (!material.ntcConstantBuffer)
         return false;
 
-    nvrhi::BufferDesc weightBufferDesc = nvrhi::BufferDesc()
-        .setByteSize(convertedWeightSize ? convertedWeightSize : weightSize)
-        .setCanHaveRawViews(true)
-        .setCanHaveUAVs(true)
-        .setInitialState(nvrhi::ResourceStates::ShaderResource)
-        .setKeepInitialState(true)
-        .setDebugName(material.name + " weights");
-    material.ntcWeightsBuffer = m_device->createBuffer(weightBufferDesc);
-    if (!material.ntcWeightsBuffer)
-        return false;
-
-    nvrhi::BufferDesc latentBufferDesc = nvrhi::BufferDesc()
-        .setByteSize(material.latentStreamRange.size)
-        .setCanHaveRawViews(true)
-        .setInitialState(nvrhi::ResourceStates::ShaderResource)
-        .setKeepInitialState(true)
-        .setDebugName(material.name + " latents");
-    material.ntcLatentsBuffer = m_device->createBuffer(latentBufferDesc);
+    // Streamed latents are sub-allocated from the pool, which is only written on the graphics queue
+    if (latentResidency)
+    {
+        assert(!copyQueueUpload);
+        latentResidency->allocation = m_latentPool->Allocate(material.latentStreamRange.size);
+        material.ntcLatentsBuffer = latentResidency->allocation.buffer;
+        material.ntcLatentsRange = latentResidency->allocation.range;
+    }
+    else
+    {
+        nvrhi::BufferDesc latentBufferDesc = nvrhi::BufferDesc()
+            .setByteSize(material.latentStreamRange.size)
+            .setCanHaveRawViews(true)
+            .setInitialState(copyQueueUpload ? nvrhi::ResourceStates::CopyDest : nvrhi::ResourceStates::ShaderResource)
+            .setKeepInitialState(!copyQueueUpload)
+            .setDebugName(material.name + " latents");
+        material.ntcLatentsBuffer = m_device->createBuffer(latentBufferDesc);
+    }
     if (!material.ntcLatentsBuffer)
         return false;
 
-    std::vector<uint8_t> latentData;
-    latentData.resize(material.latentStreamRange.size);
-
-    ntcFile->Seek(material.latentStreamRange.offset);
-    if (!ntcFile->Read(latentData.data(), latentData.size()))
+    if (m_memoryTracker)
     {
-        log::warning("Failed to read latents for material '%s'", material.name.c_str());
-        return false;
+        m_memoryTracker->TrackBuffer(material.ntcConstantBuffer, MemoryCategory::NtcConstants, material.name);
+        if (!latentResidency)
+            m_memoryTracker->TrackBuffer(material.ntcLatentsBuffer, MemoryCategory::NtcLatents, material.name);
     }
 
-    commandList->writeBuffer(material.ntcLatentsBuffer, latentData.data(), latentData.size());
-    commandList->writeBuffer(material.ntcConstantBuffer, &inferenceData.constants,
-        sizeof(inferenceData.constants));
-
-    if (convertedWeightSize != 0)
-    {
-        assert(m_weightUploadBuffer->getDesc().byteSize >= weightSize);
-        commandList->writeBuffer(m_weightUploadBuffer, weightData, weightSize);
-
-        commandList->setBufferState(m_weightUploadBuffer, nvrhi::ResourceStates::ShaderResource);
-        commandList->setBufferState(material.ntcWeightsBuffer, nvrhi::ResourceStates::UnorderedAccess);
-        commandList->commitBarriers();
-
-        bool const isVulkan = m_device->getGraphicsAPI() == nvrhi::GraphicsAPI::VULKAN;
-        nvrhi::ObjectType const commandListType = isVulkan
-            ? nvrhi::ObjectTypes::VK_CommandBuffer
-            : nvrhi::ObjectTypes::D3D12_GraphicsCommandList;
-        nvrhi::ObjectType const bufferType = isVulkan
-            ? nvrhi::ObjectTypes::VK_Buffer
-            : nvrhi::ObjectTypes::D3D12_Resource;
+    NtcMaterialConstants constants {};
+    constants.textureSet = inferenceData.constants;
+    constants.firstResidentMip = latentResidency ? latentResidency->firstResidentMip : 0;
+    constants.mipRequestSlot = latentResidency ? latentResidency->slot : NTC_NO_MIP_REQUEST_SLOT;
 
-        void* nativeCommandList = commandList->getNativeObject(commandListType);
-        void* nativeSrcBuffer = m_weightUploadBuffer->getNativeObject(bufferType);
-        void* nativeDstBuffer = material.ntcWeightsBuffer->getNativeObject(bufferType);
+    // The latents are copied into the latent buffer from the upload buffers filled by the I/O threads
+    if (copyQueueUpload)
+        uploadCommandList->beginTrackingBufferState(material.ntcConstantBuffer, nvrhi::ResourceStates::CopyDest);
+    uploadCommandList->writeBuffer(material.ntcConstantBuffer, &constants, sizeof(constants));
 
-        textureSetMetadata->ConvertInferenceWeights(weightType, nativeCommandList,
-            nativeSrcBuffer, 0, nativeDstBuffer, 0);
-    }
-    else
+    bool newWeights = false;
+    if (!GetOrCreatePooledWeights(textureSetMetadata, weightType, weightData, weightSize, convertedWeightSize,
+        commandList, material.ntcWeightsBuffer, material.ntcWeightsRange, newWeights))
     {
-        commandList->writeBuffer(material.ntcWeightsBuffer, weightData, weightSize);
+        log::warning("Failed to allocate inference weights for material '%s'.", material.name.c_str());
+        return false;
     }
 
     if (material.baseOrDiffuseTexture)
@@ -1161,10 +2222,13 @@ bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFil
     if (material.transmissionTexture)
         material.transmissionTexture->texture = m_dummyTexture->texture;
 
+    // Pooled weights are only counted for the first material that uses them
     material.ntcMemorySize =
         m_device->getBufferMemoryRequirements(material.ntcConstantBuffer).size + 
-        m_device->getBufferMemoryRequirements(material.ntcWeightsBuffer).size + 
-        m_device->getBufferMemoryRequirements(material.ntcLatentsBuffer).size;
+        (newWeights ? material.ntcWeightsRange.byteSize : 0) + 
+        (latentResidency
+            ? latentResidency->allocation.range.byteSize
+            : m_device->getBufferMemoryRequirements(material.ntcLatentsBuffer).size);
     
     material.weightType = int(weightType);
     ++m_weightTypeHistogram[int(weightType)];
@@ -1172,62 +2236,340 @@ bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFil
     return true;
 }
 
-bool NtcMaterialLoader::PrepareFeedbackMaterial(std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager,
-    ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, bool enableBlockCompression)
+bool NtcMaterialLoader::GetOrCreatePooledWeights(ntc::ITextureSetMetadata* textureSetMetadata,
+    ntc::InferenceWeightType weightType, void const* weightData, size_t weightSize, size_t convertedWeightSize,
+    nvrhi::ICommandList* commandList, nvrhi::BufferHandle& outBuffer, nvrhi::BufferRange& outRange, bool& outNewWeights)
 {
-    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
-    for (TextureTranscodeTask& transcodeTask : material.transcodeMapping)
+    // Look for the same weights converted for another material. The payloads are compared
+    // in case of a hash collision.
+    Fnv1aHash weightHash;
+    weightHash.AddValue(weightType);
+    weightHash.AddBytes(weightData, weightSize);
+    uint64_t const hash = weightHash.Get();
+
+    auto entries = m_weightPoolEntries.equal_range(hash);
+    for (auto it = entries.first; it != entries.second; ++it)
     {
-         nvrhi::TextureDesc compressedTextureDesc = nvrhi::TextureDesc()
-            .setDimension(nvrhi::TextureDimension::Texture2D)
-            .setWidth(textureSetDesc.width)
-            .setHeight(textureSetDesc.height)
-            .setMipLevels(textureSetDesc.mips)
-            .setDebugName(transcodeTask.name)
-            .setInitialState(nvrhi::ResourceStates::ShaderResource)
-            .setKeepInitialState(true);
-
-        if (enableBlockCompression)
-        {
-            compressedTextureDesc.setFormat(transcodeTask.nvrhiBcFormat);
-        }
-        else
+        WeightPoolEntry const& entry = it->second;
+        if (entry.weightType == weightType && entry.weights.size() == weightSize &&
+            memcmp(entry.weights.data(), weightData, weightSize) == 0)
         {
-            compressedTextureDesc.setFormat(transcodeTask.sRGB ? nvrhi::Format::SRGBA8_UNORM : nvrhi::Format::RGBA8_UNORM);
+            outBuffer = entry.buffer;
+            outRange = entry.range;
+            outNewWeights = false;
+            ++m_weightPoolStats.sharedWeightSets;
+            return true;
         }
+    }
 
-        nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> feedbackTexture;
-        feedbackManager->CreateTexture(compressedTextureDesc, &feedbackTexture);
-        material.*transcodeTask.pFeedbackTexture = feedbackTexture;
+    // Sub-allocate the weights from the current pool buffer, or start a new one if they don't fit
+    uint64_t const finalWeightSize = convertedWeightSize ? convertedWeightSize : weightSize;
+    uint64_t const allocationSize = (finalWeightSize + g_weightPoolAlignment - 1) & ~(g_weightPoolAlignment - 1);
+    if (!m_weightPoolBuffer || m_weightPoolOffset + allocationSize > m_weightPoolBuffer->getDesc().byteSize)
+    {
+        nvrhi::BufferDesc weightBufferDesc = nvrhi::BufferDesc()
+            .setByteSize(std::max(g_weightPoolBufferSize, allocationSize))
+            .setCanHaveRawViews(true)
+            .setCanHaveUAVs(true)
+            .setInitialState(nvrhi::ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName("NTC weight pool");
+        m_weightPoolBuffer = m_device->createBuffer(weightBufferDesc);
+        m_weightPoolOffset = 0;
+        if (!m_weightPoolBuffer)
+            return false;
+        if (m_memoryTracker)
+            m_memoryTracker->TrackBuffer(m_weightPoolBuffer, MemoryCategory::NtcWeights, "Weight Pool");
+        ++m_weightPoolStats.poolBuffers;
     }
 
+    nvrhi::BufferRange const weightRange(m_weightPoolOffset, finalWeightSize);
+    m_weightPoolOffset += allocationSize;
+
+    WriteInferenceWeights(textureSetMetadata, weightType, weightData, weightSize, convertedWeightSize, commandList,
+        m_weightPoolBuffer, weightRange.byteOffset);
+
+    WeightPoolEntry entry;
+    entry.weightType = weightType;
+    entry.weights.assign(static_cast<uint8_t const*>(weightData), static_cast<uint8_t const*>(weightData) + weightSize);
+    entry.buffer = m_weightPoolBuffer;
+    entry.range = weightRange;
+    m_weightPoolEntries.emplace(hash, std::move(entry));
+
+    outBuffer = m_weightPoolBuffer;
+    outRange = weightRange;
+    outNewWeights = true;
+    ++m_weightPoolStats.uniqueWeightSets;
+    m_weightPoolStats.pooledBytes += allocationSize;
     return true;
 }
 
-bool NtcMaterialLoader::LoadMaterialsForScene(donut::engine::Scene& scene, std::filesystem::path const& materialDir, 
-    bool enableInferenceOnLoad, bool enableBlockCompression, bool enableInferenceOnSample,
-    bool enableInferenceOnFeedback, std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager)
+void NtcMaterialLoader::WriteInferenceWeights(ntc::ITextureSetMetadata* textureSetMetadata,
+    ntc::InferenceWeightType weightType, void const* weightData, size_t weightSize, size_t convertedWeightSize,
+    nvrhi::ICommandList* commandList, nvrhi::IBuffer* dstBuffer, uint64_t dstOffset)
 {
-    using namespace std::chrono;
-    time_point start = steady_clock::now();
-
-    uint64_t totalFileSize = 0;
-    uint64_t totalPixels = 0;
-    int materialCount = 0;
-    m_weightTypeHistogram.fill(0);
+    if (convertedWeightSize != 0)
+    {
+        assert(m_weightUploadBuffer->getDesc().byteSize >= weightSize);
+        commandList->writeBuffer(m_weightUploadBuffer, weightData, weightSize);
 
-    std::vector<std::shared_ptr<engine::Material>> materials;
-    for (std::shared_ptr<engine::Material> const& material : scene.GetSceneGraph()->GetMaterials())
-        materials.push_back(material);
+        commandList->setBufferState(m_weightUploadBuffer, nvrhi::ResourceStates::ShaderResource);
+        commandList->setBufferState(dstBuffer, nvrhi::ResourceStates::UnorderedAccess);
+        commandList->commitBarriers();
+
+        bool const isVulkan = m_device->getGraphicsAPI() == nvrhi::GraphicsAPI::VULKAN;
+        nvrhi::ObjectType const commandListType = isVulkan
+            ? nvrhi::ObjectTypes::VK_CommandBuffer
+            : nvrhi::ObjectTypes::D3D12_GraphicsCommandList;
+        nvrhi::ObjectType const bufferType = isVulkan
+            ? nvrhi::ObjectTypes::VK_Buffer
+            : nvrhi::ObjectTypes::D3D12_Resource;
+
+        void* nativeCommandList = commandList->getNativeObject(commandListType);
+        void* nativeSrcBuffer = m_weightUploadBuffer->getNativeObject(bufferType);
+        void* nativeDstBuffer = dstBuffer->getNativeObject(bufferType);
 
-    std::unordered_map<std::string, std::shared_ptr<NtcMaterial>> ntcMaterialCache; // ntcData.ToString() -> NtcMaterial
+        textureSetMetadata->ConvertInferenceWeights(weightType, nativeCommandList,
+            nativeSrcBuffer, 0, nativeDstBuffer, dstOffset);
+    }
+    else
+    {
+        commandList->writeBuffer(dstBuffer, weightData, weightSize, dstOffset);
+    }
+}
 
-    for (std::shared_ptr<engine::Material> const& material : materials)
+bool NtcMaterialLoader::PrepareFeedbackMaterial(std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager,
+    ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, bool enableBlockCompression)
+{
+    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+    for (TextureTranscodeTask& transcodeTask : material.transcodeMapping)
     {
-        std::shared_ptr<NtcMaterial> ntcMaterial = std::static_pointer_cast<NtcMaterial>(material);
+         nvrhi::TextureDesc compressedTextureDesc = nvrhi::TextureDesc()
+            .setDimension(nvrhi::TextureDimension::Texture2D)
+            .setWidth(textureSetDesc.width)
+            .setHeight(textureSetDesc.height)
+            .setMipLevels(textureSetDesc.mips)
+            .setDebugName(transcodeTask.name)
+            .setInitialState(nvrhi::ResourceStates::ShaderResource)
+            .setKeepInitialState(true);
+
+        if (enableBlockCompression)
+        {
+            compressedTextureDesc.setFormat(transcodeTask.nvrhiBcFormat);
+        }
+        else
+        {
+            compressedTextureDesc.setFormat(transcodeTask.sRGB ? nvrhi::Format::SRGBA8_UNORM : nvrhi::Format::RGBA8_UNORM);
+        }
+
+        nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> feedbackTexture;
+        feedbackManager->CreateTexture(compressedTextureDesc, &feedbackTexture);
+        material.*transcodeTask.pFeedbackTexture = feedbackTexture;
+
+        // The reserved texture has no memory of its own, its tiles are counted in the feedback heaps
+        if (m_memoryTracker && feedbackTexture)
+            m_memoryTracker->TrackTexture(feedbackTexture->GetMinMipTexture(), MemoryCategory::FeedbackBuffers,
+                material.name);
+    }
+
+    return true;
+}
+
+
+static void CopyNtcMaterialData(NtcMaterial& dst, NtcMaterial const& src)
+{
+    // Copy over all the properties that we touch when decoding NTC materials,
+    // but not the entire material: some flags or parameters might be different.
+    dst.ntcConstantBuffer = src.ntcConstantBuffer;
+    dst.ntcWeightsBuffer = src.ntcWeightsBuffer;
+    dst.ntcWeightsRange = src.ntcWeightsRange;
+    dst.ntcLatentsBuffer = src.ntcLatentsBuffer;
+    dst.ntcLatentsRange = src.ntcLatentsRange;
+    dst.latentStreamRange = src.latentStreamRange;
+    dst.networkVersion = src.networkVersion;
+    dst.weightType = src.weightType;
+    dst.sourceHash = src.sourceHash;
+    dst.baseOrDiffuseTexture = src.baseOrDiffuseTexture;
+    dst.metalRoughOrSpecularTexture = src.metalRoughOrSpecularTexture;
+    dst.normalTexture = src.normalTexture;
+    dst.emissiveTexture = src.emissiveTexture;
+    dst.occlusionTexture = src.occlusionTexture;
+    dst.transmissionTexture = src.transmissionTexture;
+    dst.opacityTexture = src.opacityTexture;
+    dst.metalnessInRedChannel = src.metalnessInRedChannel;
+    dst.baseOrDiffuseTextureFeedback = src.baseOrDiffuseTextureFeedback;
+    dst.metalRoughOrSpecularTextureFeedback = src.metalRoughOrSpecularTextureFeedback;
+    dst.normalTextureFeedback = src.normalTextureFeedback;
+    dst.emissiveTextureFeedback = src.emissiveTextureFeedback;
+    dst.occlusionTextureFeedback = src.occlusionTextureFeedback;
+    dst.transmissionTextureFeedback = src.transmissionTextureFeedback;
+    dst.opacityTextureFeedback = src.opacityTextureFeedback;
+    dst.textureSetMetadata = src.textureSetMetadata;
+    dst.transcodeMapping = src.transcodeMapping;
+
+    // Make the scene update the material constants, which depend on the presence of textures
+    dst.dirty = true;
+}
+
+bool NtcMaterialLoader::CopyAtlasMaterialTextures(MaterialAtlasEntry const& atlasEntry,
+    NtcMaterial const& atlasMaterial, NtcMaterial& material)
+{
+    // Create all the textures first, so that the material keeps its placeholders if any of them fails
+    std::vector<std::shared_ptr<engine::LoadedTexture>> loadedTextures;
+    size_t transcodedMemorySize = 0;
+
+    for (TextureTranscodeTask const& transcodeTask : atlasMaterial.transcodeMapping)
+    {
+        std::shared_ptr<engine::LoadedTexture> const& atlasTexture = atlasMaterial.*transcodeTask.pMaterialTexture;
+        loadedTextures.push_back(nullptr);
+        if (!atlasTexture || !atlasTexture->texture)
+            continue;
+
+        nvrhi::ITexture* srcTexture = atlasTexture->texture;
+        nvrhi::TextureDesc textureDesc = srcTexture->getDesc();
+
+        // Only copy the MIP levels where the rectangle starts and ends on whole texels or BC blocks
+        int const blockSize = int(nvrhi::getFormatInfo(textureDesc.format).blockSize);
+        int const edges = atlasEntry.left | atlasEntry.top | atlasEntry.width | atlasEntry.height;
+        uint32_t mips = 0;
+        while (mips < uint32_t(std::min(atlasEntry.mips, int(textureDesc.mipLevels))) &&
+            (edges % (blockSize << mips)) == 0)
+            ++mips;
+
+        if (mips == 0)
+        {
+            log::warning("Material '%s' is not aligned to the texture blocks in the atlas.", material.name.c_str());
+            return false;
+        }
+
+        textureDesc
+            .setWidth(uint32_t(atlasEntry.width))
+            .setHeight(uint32_t(atlasEntry.height))
+            .setMipLevels(mips)
+            .setDebugName(material.name + ":" + std::string(transcodeTask.name));
+
+        nvrhi::TextureHandle dstTexture = m_device->createTexture(textureDesc);
+        if (!dstTexture)
+            return false;
+
+        m_commandList->setTextureState(srcTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopySource);
+        m_commandList->setTextureState(dstTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopyDest);
+        m_commandList->commitBarriers();
+
+        for (uint32_t mipLevel = 0; mipLevel < mips; ++mipLevel)
+        {
+            nvrhi::TextureSlice textureSliceDst = {};
+            textureSliceDst.mipLevel = mipLevel;
+            textureSliceDst.width = uint32_t(atlasEntry.width) >> mipLevel;
+            textureSliceDst.height = uint32_t(atlasEntry.height) >> mipLevel;
+            textureSliceDst.depth = 1;
+
+            nvrhi::TextureSlice textureSliceSrc = textureSliceDst;
+            textureSliceSrc.x = uint32_t(atlasEntry.left) >> mipLevel;
+            textureSliceSrc.y = uint32_t(atlasEntry.top) >> mipLevel;
+
+            m_commandList->copyTexture(dstTexture, textureSliceDst, srcTexture, textureSliceSrc);
+        }
+
+        loadedTextures.back() = std::make_shared<engine::LoadedTexture>();
+        loadedTextures.back()->texture = dstTexture;
+        transcodedMemorySize += m_device->getTextureMemoryRequirements(dstTexture).size;
+    }
+
+    CopyNtcMaterialData(material, atlasMaterial);
+    material.transcodedMemorySize = transcodedMemorySize;
+    for (size_t index = 0; index < loadedTextures.size(); ++index)
+    {
+        material.*atlasMaterial.transcodeMapping[index].pMaterialTexture = loadedTextures[index];
+        if (m_memoryTracker && loadedTextures[index])
+        {
+            m_memoryTracker->TrackTexture(loadedTextures[index]->texture, MemoryCategory::TranscodedTextures,
+                material.name);
+        }
+    }
+
+    return true;
+}
+
+bool NtcMaterialLoader::LoadMaterialsForScene(donut::engine::Scene& scene, std::filesystem::path const& materialDir, 
+    bool enableInferenceOnLoad, bool enableBlockCompression, bool enableInferenceOnSample,
+    bool enableInferenceOnFeedback, std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager,
+    int ioThreadCount)
+{
+    if (!BeginLoadingMaterialsForScene(scene, materialDir, enableInferenceOnLoad, enableBlockCompression,
+        enableInferenceOnSample, enableInferenceOnFeedback, feedbackManager, ioThreadCount))
+        return false;
+
+    // Nobody is waiting for the frame, so transcode the materials as soon as they are uploaded
+    uint64_t const transcodeBudgetPixels = m_transcodeBudgetPixels;
+    m_transcodeBudgetPixels = 0;
+
+    std::vector<std::shared_ptr<NtcMaterial>> readyMaterials;
+    while (IsLoadingMaterials())
+    {
+        UpdateMaterialLoading(readyMaterials);
 
-        fs::path modelFileName = material->modelFileName;
-        fs::path currentMaterialDir = materialDir.empty() ? modelFileName.parent_path() : materialDir;
+        // Give the upload buffers back to the I/O threads as soon as the GPU is done with them,
+        // then wait until the threads read more data.
+        RecycleLatentUploadBuffers(/* wait = */ true);
+
+        // Materials uploaded on the copy queue are handed over by the next update
+        if (!m_copyUploadBatches.empty())
+        {
+            m_device->waitEventQuery(m_copyUploadBatches.front().query);
+            continue;
+        }
+
+        std::unique_lock lock(m_ioMutex);
+        m_ioResultCondition.wait(lock, [this]()
+            { return !m_ioResults.empty() || !m_transcodeQueue.empty() || !IsLoadingMaterials(); });
+    }
+
+    m_transcodeBudgetPixels = transcodeBudgetPixels;
+
+    return true;
+}
+
+bool NtcMaterialLoader::BeginLoadingMaterialsForScene(donut::engine::Scene& scene,
+    std::filesystem::path const& materialDir, bool enableInferenceOnLoad, bool enableBlockCompression,
+    bool enableInferenceOnSample, bool enableInferenceOnFeedback,
+    std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager, int ioThreadCount)
+{
+    if (IsLoadingMaterials())
+    {
+        log::error("Cannot load materials for a scene while the materials for another scene are being loaded.");
+        return false;
+    }
+
+    if (m_latentStreaming && (enableInferenceOnLoad || enableInferenceOnFeedback || !enableInferenceOnSample ||
+        m_copyCommandList))
+    {
+        log::error("Latent streaming requires Inference on Sample as the only NTC mode, without copy queue uploads.");
+        return false;
+    }
+
+    m_loadingStartTime = std::chrono::steady_clock::now();
+    m_loadingStats = MaterialLoadingStats();
+    m_loadingFileSize = 0;
+    m_loadingPixels = 0;
+    m_weightTypeHistogram.fill(0);
+    m_weightPoolEntries.clear();
+    m_weightPoolBuffer = nullptr;
+    m_weightPoolOffset = 0;
+    m_weightPoolStats = WeightPoolStats();
+    ReleaseLatentResidency();
+    m_enableInferenceOnLoad = enableInferenceOnLoad;
+    m_enableBlockCompression = enableBlockCompression;
+    m_enableInferenceOnFeedback = enableInferenceOnFeedback;
+    m_feedbackManager = feedbackManager;
+
+    std::unordered_map<std::string, MaterialLoadingJob*> jobsBySource; // ntcData.ToString() -> job
+    std::unordered_set<std::string> skippedAtlasSources;
+    int archivedJobCount = 0;
+
+    for (std::shared_ptr<engine::Material> const& material : scene.GetSceneGraph()->GetMaterials())
+    {
+        std::shared_ptr<NtcMaterial> ntcMaterial = std::static_pointer_cast<NtcMaterial>(material);
 
         // Find a single NTC file that contains channels for all textures for this material.
         // In a general case, there may be multiple different files used in a single material,
@@ -1241,121 +2583,1212 @@ bool NtcMaterialLoader::LoadMaterialsForScene(donut::engine::Scene& scene, std::
         if (!ntcData)
             continue;
 
-        auto cacheIterator = ntcMaterialCache.find(ntcData.ToString());
-        if (cacheIterator != ntcMaterialCache.end())
-        {
-            auto previouslyLoadedMaterial = cacheIterator->second;
-
-            // Copy over all the properties that we touch when decoding NTC materials,
-            // but not the entire material: some flags or parameters might be different.
-            ntcMaterial->ntcConstantBuffer = previouslyLoadedMaterial->ntcConstantBuffer;
-            ntcMaterial->ntcWeightsBuffer = previouslyLoadedMaterial->ntcWeightsBuffer;
-            ntcMaterial->ntcLatentsBuffer = previouslyLoadedMaterial->ntcLatentsBuffer;
-            ntcMaterial->latentStreamRange = previouslyLoadedMaterial->latentStreamRange;
-            ntcMaterial->networkVersion = previouslyLoadedMaterial->networkVersion;
-            ntcMaterial->weightType = previouslyLoadedMaterial->weightType;
-            ntcMaterial->baseOrDiffuseTexture = previouslyLoadedMaterial->baseOrDiffuseTexture;
-            ntcMaterial->metalRoughOrSpecularTexture = previouslyLoadedMaterial->metalRoughOrSpecularTexture;
-            ntcMaterial->normalTexture = previouslyLoadedMaterial->normalTexture;
-            ntcMaterial->emissiveTexture = previouslyLoadedMaterial->emissiveTexture;
-            ntcMaterial->occlusionTexture = previouslyLoadedMaterial->occlusionTexture;
-            ntcMaterial->transmissionTexture = previouslyLoadedMaterial->transmissionTexture;
-            ntcMaterial->opacityTexture = previouslyLoadedMaterial->opacityTexture;
-            ntcMaterial->metalnessInRedChannel = previouslyLoadedMaterial->metalnessInRedChannel;
-            ntcMaterial->baseOrDiffuseTextureFeedback = previouslyLoadedMaterial->baseOrDiffuseTextureFeedback;
-            ntcMaterial->metalRoughOrSpecularTextureFeedback = previouslyLoadedMaterial->metalRoughOrSpecularTextureFeedback;
-            ntcMaterial->normalTextureFeedback = previouslyLoadedMaterial->normalTextureFeedback;
-            ntcMaterial->emissiveTextureFeedback = previouslyLoadedMaterial->emissiveTextureFeedback;
-            ntcMaterial->occlusionTextureFeedback = previouslyLoadedMaterial->occlusionTextureFeedback;
-            ntcMaterial->transmissionTextureFeedback = previouslyLoadedMaterial->transmissionTextureFeedback;
-            ntcMaterial->opacityTextureFeedback = previouslyLoadedMaterial->opacityTextureFeedback;
-            ntcMaterial->textureSetMetadata = previouslyLoadedMaterial->textureSetMetadata;
-            ntcMaterial->transcodeMapping = previouslyLoadedMaterial->transcodeMapping;
+        auto jobIterator = jobsBySource.find(ntcData.ToString());
+        if (jobIterator != jobsBySource.end())
+        {
+            jobIterator->second->aliases.push_back(ntcMaterial);
+            continue;
+        }
 
+        if (skippedAtlasSources.count(ntcData.ToString()))
             continue;
+
+        // Materials that were compressed together with ntc-cli --atlas share one NTC file, and the layout file
+        // next to it tells which part of the texture set belongs to each material. They are all loaded
+        // by one job, as aliases of the first material.
+        std::shared_ptr<MaterialAtlasLayout> atlasLayout;
+        if (!ntcData.data)
+        {
+            std::string const layoutFileName = GetMaterialAtlasLayoutFileName(ntcData.path);
+            if (fs::exists(layoutFileName))
+            {
+                // The other modes would need the atlas rectangles in the shaders or the feedback tiles
+                bool const atlasSupported = enableInferenceOnLoad && !enableInferenceOnSample &&
+                    !enableInferenceOnFeedback;
+
+                atlasLayout = std::make_shared<MaterialAtlasLayout>();
+                std::string layoutError;
+                if (!ReadMaterialAtlasLayout(layoutFileName.c_str(), *atlasLayout, layoutError))
+                {
+                    log::warning("%s", layoutError.c_str());
+                    atlasLayout = nullptr;
+                }
+                else if (!atlasSupported)
+                {
+                    log::warning("The materials in '%s' share one texture set through an atlas layout, which is only "
+                        "supported with Inference on Load as the only NTC mode. They will use placeholder textures.",
+                        ntcData.path.c_str());
+                    atlasLayout = nullptr;
+                }
+
+                if (!atlasLayout)
+                {
+                    skippedAtlasSources.insert(ntcData.ToString());
+                    continue;
+                }
+            }
         }
 
-        ntcMaterialCache[ntcData.ToString()] = ntcMaterial;
+        std::shared_ptr<MaterialLoadingJob> job = std::make_shared<MaterialLoadingJob>(m_ntcContext);
+        job->material = ntcMaterial;
+        job->loadingMaterial = std::make_shared<NtcMaterial>(*ntcMaterial);
+        job->source = ntcData;
+        job->channelMap = channelMap;
+        job->atlasLayout = atlasLayout;
+        if (m_materialArchive && !ntcData.data)
+        {
+            std::string const entryName = fs::absolute(ntcData.path).lexically_relative(m_materialArchiveDir)
+                .generic_string();
+            job->archiveEntry = m_materialArchive->FindEntry(entryName);
+            if (job->archiveEntry)
+                ++archivedJobCount;
+        }
+        jobsBySource[ntcData.ToString()] = job.get();
+        m_loadingJobs.push_back(job);
+    }
+
+    m_loadingJobCount = int(m_loadingJobs.size());
+    m_loadingStats.materialsTotal = m_loadingJobCount;
 
-        // Use differnt wrappers for file and memory streams because they have different deleter functions...
-        ntc::FileStreamWrapper ntcFileStream(m_ntcContext);
-        ntc::MemoryStreamWrapper ntcMemoryStream(m_ntcContext);
+    if (m_loadingJobs.empty())
+    {
+        log::info("No NTC materials found in the scene.");
+        return true;
+    }
 
-        ntcMaterial->textureSetMetadata = std::make_shared<ntc::TextureSetMetadataWrapper>(m_ntcContext);
+    if (m_materialArchive)
+        log::info("%d of %d NTC materials found in the material archive.", archivedJobCount, m_loadingJobCount);
 
-        if (!LoadMaterialFile(ntcData, *ntcMaterial, m_ntcContext, ntcFileStream, ntcMemoryStream,
-            *ntcMaterial->textureSetMetadata))
-            continue;
+    ioThreadCount = std::clamp(ioThreadCount, 1, m_loadingJobCount);
 
-        // Upcast the file or memory stream to a basic stream type
-        ntc::IStream* const dataStream = ntcFileStream.Get() ? ntcFileStream.Get() : ntcMemoryStream.Get();
+    // Create the upload buffers and map them once, they stay mapped until the loading is finished
+    int const uploadBufferCount = ioThreadCount * g_latentUploadBuffersPerThread;
+    nvrhi::BufferDesc uploadBufferDesc = nvrhi::BufferDesc()
+        .setByteSize(g_latentUploadBufferSize)
+        .setCpuAccess(nvrhi::CpuAccessMode::Write)
+        .setInitialState(nvrhi::ResourceStates::CopySource)
+        .setKeepInitialState(true);
 
-        ntc::ITextureSetMetadata* textureSetMetadata = *ntcMaterial->textureSetMetadata;
+    for (int index = 0; index < uploadBufferCount; ++index)
+    {
+        LatentUploadBuffer& uploadBuffer = m_latentUploadBuffers.emplace_back();
+        uploadBufferDesc.setDebugName("Latent upload buffer " + std::to_string(index));
+        uploadBuffer.buffer = m_device->createBuffer(uploadBufferDesc);
+        if (!uploadBuffer.buffer)
+            return false;
+        if (m_memoryTracker)
+            m_memoryTracker->TrackBuffer(uploadBuffer.buffer, MemoryCategory::UploadBuffers, "Material Loader");
 
-        // Obtain the stream range for latents covering all mip levels of the material.
-        ntc::Status ntcStatus = textureSetMetadata->GetStreamRangeForLatents(0, textureSetMetadata->GetDesc().mips,
-            ntcMaterial->latentStreamRange);
-        if (ntcStatus != ntc::Status::Ok)
+        uploadBuffer.mappedData = static_cast<uint8_t*>(m_device->mapBuffer(uploadBuffer.buffer,
+            nvrhi::CpuAccessMode::Write));
+        if (!uploadBuffer.mappedData)
         {
-            log::warning("Cannot process material '%s', call to GetStreamRangeForLatents failed, error code = %s: %s",
-                ntcMaterial->name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            log::error("Failed to map the latent upload buffer.");
+            return false;
         }
 
-        m_commandList->open();
-        bool loadedSuccessfully = true;
+        uploadBuffer.query = m_device->createEventQuery();
+        m_freeLatentUploadBuffers.push_back(index);
+    }
 
-        ntcStatus = textureSetMetadata->ShuffleInferenceOutputs(channelMap.swizzle.data());
-        if (ntcStatus != ntc::Status::Ok)
+    {
+        std::lock_guard lockGuard(m_ioMutex);
+        m_stopIoThreads = false;
+        for (std::shared_ptr<MaterialLoadingJob> const& job : m_loadingJobs)
+            m_ioJobs.push_back(job.get());
+
+        // Read the archived materials in the order of their offsets, so that the archive is read mostly sequentially
+        // by all threads, and the separate files after them
+        std::stable_sort(m_ioJobs.begin(), m_ioJobs.end(), [](MaterialLoadingJob const* a, MaterialLoadingJob const* b)
+        {
+            uint64_t const offsetA = a->archiveEntry ? a->archiveEntry->offset : UINT64_MAX;
+            uint64_t const offsetB = b->archiveEntry ? b->archiveEntry->offset : UINT64_MAX;
+            return offsetA < offsetB;
+        });
+    }
+
+    for (int thread = 0; thread < ioThreadCount; ++thread)
+        m_ioThreads.emplace_back(&NtcMaterialLoader::IoThreadProc, this);
+
+    return true;
+}
+
+void NtcMaterialLoader::IoThreadProc()
+{
+    while (true)
+    {
+        MaterialLoadingJob* job = nullptr;
+        {
+            // All jobs are queued before the threads are started, so an empty queue means that the work is done
+            std::lock_guard lockGuard(m_ioMutex);
+            if (m_stopIoThreads || m_ioJobs.empty())
+                return;
+            job = m_ioJobs.front();
+            m_ioJobs.pop_front();
+        }
+
+        ReadMaterialData(*job);
+    }
+}
+
+int NtcMaterialLoader::AcquireLatentUploadBuffer()
+{
+    std::unique_lock lock(m_ioMutex);
+    m_uploadBufferCondition.wait(lock, [this]() { return m_stopIoThreads || !m_freeLatentUploadBuffers.empty(); });
+    if (m_stopIoThreads)
+        return -1;
+
+    int const index = m_freeLatentUploadBuffers.back();
+    m_freeLatentUploadBuffers.pop_back();
+    return index;
+}
+
+void NtcMaterialLoader::PostIoResult(IoResult const& result)
+{
+    {
+        std::lock_guard lockGuard(m_ioMutex);
+        m_ioResults.push_back(result);
+    }
+    m_ioResultCondition.notify_one();
+}
+
+void NtcMaterialLoader::ReadMaterialData(MaterialLoadingJob& job)
+{
+    NtcMaterial& material = *job.loadingMaterial;
+
+    IoResult result;
+    result.job = &job;
+    result.type = IoResult::Type::Failed;
+    result.last = true;
+
+    {
+        std::lock_guard lockGuard(m_contextMutex);
+
+        material.textureSetMetadata = std::make_shared<ntc::TextureSetMetadataWrapper>(m_ntcContext);
+        if (!LoadMaterialFile(job.source, material, m_ntcContext, m_materialArchive.get(), job.archiveEntry,
+            job.fileStream, job.memoryStream, *material.textureSetMetadata))
+        {
+            PostIoResult(result);
+            return;
+        }
+    }
+
+    // Upcast the file or memory stream to a basic stream type
+    ntc::IStream* const dataStream = job.fileStream ? job.fileStream.get() : job.memoryStream.Get();
+
+    ntc::ITextureSetMetadata* textureSetMetadata = *material.textureSetMetadata;
+
+    // Obtain the stream range for latents covering all mip levels of the material.
+    // Archive entries store that range in the index, relative to the entry stream.
+    ntc::Status ntcStatus = ntc::Status::Ok;
+    if (job.archiveEntry)
+        material.latentStreamRange = job.archiveEntry->latents;
+    else
+        ntcStatus = textureSetMetadata->GetStreamRangeForLatents(0, textureSetMetadata->GetDesc().mips,
+            material.latentStreamRange);
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        log::warning("Cannot process material '%s', call to GetStreamRangeForLatents failed, error code = %s: %s",
+            material.name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        PostIoResult(result);
+        return;
+    }
+
+    ntcStatus = textureSetMetadata->ShuffleInferenceOutputs(job.channelMap.swizzle.data());
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        log::warning("Cannot process material '%s', call to ShuffleInferenceOutputs failed, error code = %s: %s",
+            material.name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+    }
+
+    // Derive the transcode mapping using the channel map and texture metadata
+    // The alpha mask is skipped only for the materials whose depth pre-pass runs inference instead, using the same
+    // predicate as the pre-pass. Materials with an unknown network version still need the transcoded mask.
+    bool const onlyAlphaMask = !m_enableInferenceOnLoad && !m_enableInferenceOnFeedback;
+    bool const alphaMaskFromInference = onlyAlphaMask && m_alphaTestInference &&
+        NtcForwardShadingPass::UsesAlphaTestInference(material, NtcMode::InferenceOnSample);
+    if (!alphaMaskFromInference)
+        FillMaterialTranscodeMapping(material, textureSetMetadata, job.channelMap, onlyAlphaMask);
+
+    // With latent streaming, read only the coarse mips unless the alpha mask is transcoded from all of them.
+    // Those materials start with all mips resident and drop the finer ones when they are not sampled.
+    if (m_latentStreaming)
+    {
+        ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+        job.coarseMip = 0;
+        while (job.coarseMip + 1 < textureSetDesc.mips && std::max(textureSetDesc.width >> job.coarseMip,
+            textureSetDesc.height >> job.coarseMip) > g_latentStreamingResidentSize)
+            ++job.coarseMip;
+        job.firstResidentMip = material.transcodeMapping.empty() ? job.coarseMip : 0;
+
+        if (job.firstResidentMip != 0)
         {
-            log::warning("Cannot process material '%s', call to ShuffleInferenceOutputs failed, error code = %s: %s",
-                ntcMaterial->name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            ntcStatus = textureSetMetadata->GetStreamRangeForLatents(job.firstResidentMip,
+                textureSetDesc.mips - job.firstResidentMip, material.latentStreamRange);
+            if (ntcStatus != ntc::Status::Ok)
+            {
+                log::warning("Cannot process material '%s', call to GetStreamRangeForLatents failed, "
+                    "error code = %s: %s", material.name.c_str(), ntc::StatusToString(ntcStatus),
+                    ntc::GetLastErrorMessage());
+                PostIoResult(result);
+                return;
+            }
         }
+    }
 
-        // Derive the transcode mapping using the channel map and texture metadata
-        bool const onlyAlphaMask = !enableInferenceOnLoad && !enableInferenceOnFeedback;
-        FillMaterialTranscodeMapping(*ntcMaterial, textureSetMetadata, channelMap, onlyAlphaMask);
+    job.fileSize = dataStream->Size();
+    material.sourceHash = GetMaterialSourceHash(job.source, job.archiveEntry, job.fileSize);
 
-        // Load the material data for Inference On Sample/Feedback first, so that the latent and weight buffers
-        // can be reused for On Load.
-        loadedSuccessfully = PrepareMaterialForInferenceOnSample(dataStream, textureSetMetadata,
-            *ntcMaterial, m_commandList);
+    uint64_t const latentSize = material.latentStreamRange.size;
 
-        // Transcode the material into raw color data or BCn (Inference On Load).
-        // When Inference on Load is disabled, we still go through the materials and extract alpha mask channels,
-        // encoding them into BC4 when allowed. They are used for the depth pre-pass (or any-hit shaders
-        // in a path tracing renderer).
-        if (loadedSuccessfully)
+    // The whole GDeflate pages of a compressed file can be decompressed on the GPU, straight from the file
+    // mapping. Only the partial pages at both ends of the latents go through the upload buffers then.
+    uint64_t gpuBegin = latentSize;
+    uint64_t gpuEnd = latentSize;
+    uint32_t gpuFirstPage = 0;
+    uint32_t gpuPageCount = 0;
+    if (m_gpuDecompressionQueue && !job.archiveEntry && !job.latentResidency)
+    {
+        if (auto compressedStream = dynamic_cast<CompressedFileStream*>(job.fileStream.get()))
         {
-            loadedSuccessfully = TranscodeMaterial(dataStream, textureSetMetadata, *ntcMaterial, m_commandList,
-                enableBlockCompression);
+            uint64_t const pageSize = compressedStream->GetPageSize();
+            uint64_t const begin = material.latentStreamRange.offset;
+            uint64_t const end = begin + latentSize;
+            gpuFirstPage = uint32_t((begin + pageSize - 1) / pageSize);
+            uint32_t const endPage = (end == compressedStream->Size())
+                ? compressedStream->GetPageCount()
+                : uint32_t(end / pageSize);
+            gpuPageCount = (compressedStream->GetPageFormat() == CompressedFilePageFormat::GDeflate &&
+                endPage > gpuFirstPage) ? endPage - gpuFirstPage : 0;
+
+            // Zlib pages in the range keep the whole material on the CPU path
+            for (uint32_t page = gpuFirstPage; page < gpuFirstPage + gpuPageCount; ++page)
+            {
+                if (compressedStream->GetPageInfo(page).isDeflate)
+                {
+                    gpuPageCount = 0;
+                    break;
+                }
+            }
+
+            if (gpuPageCount != 0)
+            {
+                gpuBegin = uint64_t(gpuFirstPage) * pageSize - begin;
+                gpuEnd = std::min(uint64_t(gpuFirstPage + gpuPageCount) * pageSize - begin, latentSize);
+            }
         }
+    }
 
-        if (enableInferenceOnFeedback && loadedSuccessfully)
+    result.type = IoResult::Type::Metadata;
+    result.last = latentSize == 0;
+    PostIoResult(result);
+
+    if (gpuPageCount != 0)
+    {
+        result.type = IoResult::Type::GpuLatents;
+        result.latentOffset = gpuBegin;
+        result.size = gpuEnd - gpuBegin;
+        result.firstPage = gpuFirstPage;
+        result.pageCount = gpuPageCount;
+        result.last = gpuBegin == 0 && gpuEnd == latentSize;
+        PostIoResult(result);
+    }
+
+    // Read the rest of the latents straight into the upload buffers, in chunks if they don't fit into one buffer.
+    // For files, this is a single copy from the file mapping, or inflating the pages of a compressed file.
+    // The rendering thread copies every chunk into the latent buffer and returns the upload buffer to the pool
+    // when the copy is finished on the GPU.
+    uint64_t offset = 0;
+    while (offset < latentSize)
+    {
+        if (offset == gpuBegin)
         {
-            loadedSuccessfully = PrepareFeedbackMaterial(feedbackManager, textureSetMetadata, *ntcMaterial,
-                enableBlockCompression);
+            offset = gpuEnd;
+            continue;
         }
-        
-        m_commandList->close();
 
-        if (loadedSuccessfully)
+        int const uploadBufferIndex = AcquireLatentUploadBuffer();
+        if (uploadBufferIndex < 0)
+            return;
+
+        uint64_t const rangeEnd = (offset < gpuBegin) ? gpuBegin : latentSize;
+        uint64_t const chunkSize = std::min(rangeEnd - offset, g_latentUploadBufferSize);
+
+        dataStream->Seek(material.latentStreamRange.offset + offset);
+        if (!dataStream->Read(m_latentUploadBuffers[uploadBufferIndex].mappedData, chunkSize))
         {
-            m_device->executeCommandList(m_commandList);
-            m_device->waitForIdle();
-            m_device->runGarbageCollection();
+            log::warning("Failed to read latents for material '%s'", material.name.c_str());
+
+            {
+                std::lock_guard lockGuard(m_ioMutex);
+                m_freeLatentUploadBuffers.push_back(uploadBufferIndex);
+            }
+            m_uploadBufferCondition.notify_one();
+
+            result.type = IoResult::Type::Failed;
+            result.last = true;
+            PostIoResult(result);
+            return;
         }
 
-        auto const& textureSetDesc = textureSetMetadata->GetDesc();
-        totalFileSize += dataStream->Size();
-        totalPixels += (textureSetDesc.width * textureSetDesc.height * 4) / 3;
-        ++materialCount;
+        result.type = IoResult::Type::Latents;
+        result.uploadBufferIndex = uploadBufferIndex;
+        result.latentOffset = offset;
+        result.size = chunkSize;
+        result.last = offset + chunkSize == latentSize || (offset + chunkSize == gpuBegin && gpuEnd == latentSize);
+        PostIoResult(result);
+
+        offset += chunkSize;
     }
+}
 
-    time_point end = steady_clock::now();
-    int64_t durationMs = duration_cast<milliseconds>(end - start).count();
-    
-    log::info("%d materials loaded in %lli ms - that's %.2f Mpix from %.2f MB", materialCount, durationMs,
-        double(totalPixels) * 1e-6, double(totalFileSize) * 0x1p-20);
+void NtcMaterialLoader::RecycleLatentUploadBuffers(bool wait)
+{
+    int recycledCount = 0;
+    for (int index = 0; index < int(m_latentUploadBuffers.size()); ++index)
+    {
+        LatentUploadBuffer& uploadBuffer = m_latentUploadBuffers[index];
+        if (!uploadBuffer.inFlight)
+            continue;
 
-    return true;
+        if (wait)
+            m_device->waitEventQuery(uploadBuffer.query);
+        else if (!m_device->pollEventQuery(uploadBuffer.query))
+            continue;
+
+        m_device->resetEventQuery(uploadBuffer.query);
+        uploadBuffer.inFlight = false;
+
+        std::lock_guard lockGuard(m_ioMutex);
+        m_freeLatentUploadBuffers.push_back(index);
+        ++recycledCount;
+    }
+
+    if (recycledCount != 0)
+        m_uploadBufferCondition.notify_all();
+}
+
+void NtcMaterialLoader::ReleaseLatentUploadBuffers()
+{
+    for (LatentUploadBuffer& uploadBuffer : m_latentUploadBuffers)
+    {
+        // Don't unmap the buffers while the GPU may still be copying from them
+        if (uploadBuffer.inFlight)
+        {
+            m_device->waitEventQuery(uploadBuffer.query);
+            uploadBuffer.inFlight = false;
+        }
+
+        if (uploadBuffer.mappedData)
+            m_device->unmapBuffer(uploadBuffer.buffer);
+    }
+    m_latentUploadBuffers.clear();
+    m_freeLatentUploadBuffers.clear();
+}
+
+void NtcMaterialLoader::StopIoThreads()
+{
+    {
+        std::lock_guard lockGuard(m_ioMutex);
+        m_stopIoThreads = true;
+    }
+    m_uploadBufferCondition.notify_all();
+
+    for (std::thread& thread : m_ioThreads)
+        thread.join();
+    m_ioThreads.clear();
+
+    m_ioJobs.clear();
+    m_ioResults.clear();
+}
+
+static uint64_t GetTranscodeRegionPixels(TranscodeRegion const& region, NtcMaterial const& material)
+{
+    return uint64_t(region.rect.width) * uint64_t(region.rect.height) * material.transcodeMapping.size();
+}
+
+bool NtcMaterialLoader::QueueMaterialForTranscoding(MaterialLoadingJob& job)
+{
+    NtcMaterial& material = *job.loadingMaterial;
+    ntc::ITextureSetMetadata* textureSetMetadata = *material.textureSetMetadata;
+
+    // Transcode the material into raw color data or BCn (Inference On Load).
+    // When Inference on Load is disabled, we still go through the materials and extract alpha mask channels,
+    // encoding them into BC4 when allowed. They are used for the depth pre-pass (or any-hit shaders
+    // in a path tracing renderer).
+    // The final textures are created here, and the transcoding itself is split into regions that
+    // ProcessTranscodeQueue spreads over multiple updates.
+    if (!CreateTranscodedTextures(textureSetMetadata, material, m_enableBlockCompression))
+        return false;
+
+    if (!material.transcodeMapping.empty())
+    {
+        ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+        for (int mipLevel = textureSetDesc.mips - 1; mipLevel >= 0; --mipLevel)
+        {
+            int const mipWidth = std::max(textureSetDesc.width >> mipLevel, 1);
+            int const mipHeight = std::max(textureSetDesc.height >> mipLevel, 1);
+
+            for (int top = 0; top < mipHeight; top += g_transcodeRegionSize)
+            {
+                for (int left = 0; left < mipWidth; left += g_transcodeRegionSize)
+                {
+                    TranscodeRegion& region = job.transcodeRegions.emplace_back();
+                    region.mipLevel = mipLevel;
+                    region.rect.left = left;
+                    region.rect.top = top;
+                    region.rect.width = std::min(mipWidth - left, g_transcodeRegionSize);
+                    region.rect.height = std::min(mipHeight - top, g_transcodeRegionSize);
+                    m_loadingStats.transcodePixelsPending += GetTranscodeRegionPixels(region, material);
+                }
+            }
+        }
+    }
+
+    m_transcodeQueue.push_back(&job);
+    ++m_loadingStats.materialsTranscoding;
+
+    return true;
+}
+
+void NtcMaterialLoader::RetireCopyUploadBatches()
+{
+    while (!m_copyUploadBatches.empty() && m_device->pollEventQuery(m_copyUploadBatches.front().query))
+    {
+        // The fence covers the DirectStorage requests of the batch and of all batches before it
+        CopyUploadBatch const& batch = m_copyUploadBatches.front();
+        if (batch.gpuDecompressionFence != 0 && !m_gpuDecompressionQueue->IsCompleted(batch.gpuDecompressionFence))
+            break;
+
+        // Failed requests can't be attributed to a job, so fail all jobs of the batch that used DirectStorage
+        bool const gpuDecompressionFailed = batch.gpuDecompressionFence != 0 &&
+            m_gpuDecompressionQueue->GetNewFailureCount() != 0;
+        if (gpuDecompressionFailed)
+            log::warning("DirectStorage failed to decompress the latents of some materials.");
+
+        for (MaterialLoadingJob* job : batch.jobs)
+        {
+            --m_loadingStats.materialsUploading;
+
+            // The copies are finished, so the graphics queue can take over the buffers. They decay to the common
+            // state after the copy queue work on DX12, and they are only read from now on, so make the final
+            // states permanent to skip the state tracking in every command list that uses them.
+            NtcMaterial& material = *job->loadingMaterial;
+            m_commandList->beginTrackingBufferState(material.ntcConstantBuffer, nvrhi::ResourceStates::Common);
+            m_commandList->setPermanentBufferState(material.ntcConstantBuffer, nvrhi::ResourceStates::ConstantBuffer);
+            m_commandList->beginTrackingBufferState(material.ntcLatentsBuffer, nvrhi::ResourceStates::Common);
+            m_commandList->setPermanentBufferState(material.ntcLatentsBuffer, nvrhi::ResourceStates::ShaderResource);
+
+            if (!(gpuDecompressionFailed && job->gpuDecompressionFence != 0) && QueueMaterialForTranscoding(*job))
+                continue;
+
+            ++m_loadingStats.materialsFailed;
+            ReleaseLoadingJob(*job);
+            --m_loadingJobCount;
+        }
+
+        m_copyUploadBatches.pop_front();
+    }
+}
+
+// Lists the packed MIP tails of all feedback textures of a material, once per mip.
+// The tails of textures with different formats can start at different mips, see GetPackedTileInfo(...)
+static void AppendPackedTiles(NtcMaterial& material, std::vector<TranscodeTileInfo>& outTiles)
+{
+    std::vector<nvfeedback::FeedbackTextureTileInfo> packedTiles;
+    size_t const firstTile = outTiles.size();
+    for (TextureTranscodeTask const& transcodeTask : material.transcodeMapping)
+    {
+        nvfeedback::FeedbackTexture* feedbackTexture = (material.*transcodeTask.pFeedbackTexture).Get();
+        if (!feedbackTexture)
+            continue;
+
+        feedbackTexture->GetPackedTileInfo(packedTiles);
+        for (nvfeedback::FeedbackTextureTileInfo const& tileInfo : packedTiles)
+        {
+            bool const listed = std::any_of(outTiles.begin() + firstTile, outTiles.end(),
+                [&tileInfo](TranscodeTileInfo const& tile) { return tile.tileInfo.mip == tileInfo.mip; });
+            if (!listed)
+                outTiles.push_back({ &material, tileInfo });
+        }
+    }
+}
+
+void NtcMaterialLoader::ProcessTranscodeQueue(std::vector<std::shared_ptr<NtcMaterial>>& outReadyMaterials)
+{
+    uint64_t pixelsTranscoded = 0;
+
+    // The packed MIP tails of the feedback textures are mapped when the textures are created, and they are
+    // filled here for all materials finished on this update with one TranscodeTiles(...) call
+    std::vector<TranscodeTileInfo> packedTiles;
+
+    while (!m_transcodeQueue.empty() && (m_transcodeBudgetPixels == 0 || pixelsTranscoded < m_transcodeBudgetPixels))
+    {
+        MaterialLoadingJob& job = *m_transcodeQueue.front();
+        NtcMaterial& material = *job.loadingMaterial;
+
+        if (job.nextTranscodeRegion < job.transcodeRegions.size())
+        {
+            TranscodeRegion const& region = job.transcodeRegions[job.nextTranscodeRegion++];
+            uint64_t const regionPixels = GetTranscodeRegionPixels(region, material);
+            pixelsTranscoded += regionPixels;
+            m_loadingStats.transcodePixelsPending -= regionPixels;
+
+            {
+                // The region is transcoded through the same staging atlases as the feedback tiles
+                std::scoped_lock lock(m_transcodeAtlasMutex, m_contextMutex);
+                if (TranscodeMaterialRegion(*material.textureSetMetadata, material, region.mipLevel, region.rect,
+                    m_commandList))
+                    continue;
+            }
+
+            // Drop the remaining work for the failed material from the stats
+            job.failed = true;
+            for (; job.nextTranscodeRegion < job.transcodeRegions.size(); ++job.nextTranscodeRegion)
+            {
+                m_loadingStats.transcodePixelsPending -= GetTranscodeRegionPixels(
+                    job.transcodeRegions[job.nextTranscodeRegion], material);
+            }
+        }
+
+        m_transcodeQueue.pop_front();
+        --m_loadingStats.materialsTranscoding;
+
+        if (!job.failed)
+        {
+            std::lock_guard lockGuard(m_contextMutex);
+            job.failed = !FinishMaterial(job, outReadyMaterials);
+        }
+
+        if (job.failed)
+            ++m_loadingStats.materialsFailed;
+        else if (m_enableInferenceOnFeedback)
+            AppendPackedTiles(*job.material, packedTiles);
+
+        // Clear the binding set caches to avoid storing binding sets for every material after on-load transcoding
+        m_graphicsBlockCompressionPass->ClearBindingSetCache();
+        m_graphicsDecompressionPass->ClearBindingSetCache();
+        m_transcodePass->ClearBindingSetCache();
+
+        ReleaseLoadingJob(job);
+        --m_loadingJobCount;
+    }
+
+    if (!packedTiles.empty())
+    {
+        // The materials stay usable without their packed tiles, the tiles are only sampled as a fallback
+        if (!TranscodeTiles(packedTiles, m_commandList, m_enableBlockCompression))
+            log::warning("Cannot transcode the packed MIP tails of the feedback textures.");
+
+        m_graphicsBlockCompressionPass->ClearBindingSetCache();
+        m_graphicsDecompressionPass->ClearBindingSetCache();
+        m_transcodePass->ClearBindingSetCache();
+    }
+}
+
+bool NtcMaterialLoader::FinishMaterial(MaterialLoadingJob& job,
+    std::vector<std::shared_ptr<NtcMaterial>>& outReadyMaterials)
+{
+    NtcMaterial& material = *job.loadingMaterial;
+    ntc::ITextureSetMetadata* textureSetMetadata = *material.textureSetMetadata;
+
+    // The textures are referenced by the material slots now
+    for (TextureTranscodeTask& transcodeTask : material.transcodeMapping)
+    {
+        transcodeTask.ReleaseTextures();
+    }
+
+    if (m_enableInferenceOnFeedback)
+    {
+        if (!PrepareFeedbackMaterial(m_feedbackManager, textureSetMetadata, material, m_enableBlockCompression))
+            return false;
+    }
+
+    // Replace the placeholder data in the scene materials
+    if (job.atlasLayout)
+    {
+        // Every material of an atlas gets its own textures, cut out of the textures transcoded for the entire atlas
+        std::vector<std::shared_ptr<NtcMaterial>> sceneMaterials = job.aliases;
+        sceneMaterials.insert(sceneMaterials.begin(), job.material);
+        std::vector<std::pair<NtcMaterial*, int64_t>> readyMaterialAreas;
+        int64_t totalArea = 0;
+        for (std::shared_ptr<NtcMaterial> const& sceneMaterial : sceneMaterials)
+        {
+            MaterialAtlasEntry const* atlasEntry = job.atlasLayout->FindMaterial(sceneMaterial->name);
+            if (!atlasEntry)
+            {
+                log::warning("Material '%s' is not listed in the atlas layout of '%s', it keeps the placeholder "
+                    "textures.", sceneMaterial->name.c_str(), job.source.path.c_str());
+                continue;
+            }
+
+            if (!CopyAtlasMaterialTextures(*atlasEntry, material, *sceneMaterial))
+            {
+                log::warning("Cannot create the textures for material '%s' from the atlas '%s', it keeps the "
+                    "placeholder textures.", sceneMaterial->name.c_str(), job.source.path.c_str());
+                continue;
+            }
+            outReadyMaterials.push_back(sceneMaterial);
+
+            int64_t const area = int64_t(atlasEntry->width) * int64_t(atlasEntry->height);
+            readyMaterialAreas.push_back({ sceneMaterial.get(), area });
+            totalArea += area;
+        }
+
+        // The latents and weights are shared, split their size between the materials by area so that the sum
+        // over the scene stays the size of the file. The last material gets the rounding remainder.
+        size_t remainingNtcMemorySize = material.ntcMemorySize;
+        for (size_t index = 0; index < readyMaterialAreas.size(); ++index)
+        {
+            auto [readyMaterial, area] = readyMaterialAreas[index];
+            size_t const share = (index + 1 == readyMaterialAreas.size())
+                ? remainingNtcMemorySize
+                : size_t(double(material.ntcMemorySize) * double(area) / double(totalArea));
+            readyMaterial->ntcMemorySize = share;
+            remainingNtcMemorySize -= share;
+        }
+
+        // The copies are recorded, the command list keeps the atlas-wide textures alive until it's executed
+        for (TextureTranscodeTask const& transcodeTask : material.transcodeMapping)
+            material.*transcodeTask.pMaterialTexture = nullptr;
+        material.transcodedMemorySize = 0;
+    }
+    else
+    {
+        CopyNtcMaterialData(*job.material, material);
+        job.material->ntcMemorySize = material.ntcMemorySize;
+        job.material->transcodedMemorySize = material.transcodedMemorySize;
+        outReadyMaterials.push_back(job.material);
+
+        for (std::shared_ptr<NtcMaterial> const& alias : job.aliases)
+        {
+            CopyNtcMaterialData(*alias, material);
+            outReadyMaterials.push_back(alias);
+        }
+    }
+
+    // Start streaming the latents, all materials that share them are updated together
+    if (job.latentResidency)
+    {
+        job.latentResidency->materials.push_back(job.material);
+        job.latentResidency->materials.insert(job.latentResidency->materials.end(),
+            job.aliases.begin(), job.aliases.end());
+    }
+
+    auto const& textureSetDesc = textureSetMetadata->GetDesc();
+    m_loadingFileSize += job.fileSize;
+    m_loadingPixels += (textureSetDesc.width * textureSetDesc.height * 4) / 3;
+    ++m_loadingStats.materialsReady;
+
+    return true;
+}
+
+void NtcMaterialLoader::ReleaseLoadingJob(MaterialLoadingJob& job)
+{
+    // Materials that failed to load keep their residency slot, but the latents go back to the pool
+    // when the GPU is done with the uploads
+    if (job.latentResidency && job.latentResidency->materials.empty() && job.latentResidency->allocation)
+    {
+        m_retiredLatentAllocations.push_back(job.latentResidency->allocation);
+        job.latentResidency->allocation = LatentBufferPool::Allocation();
+        job.latentResidency->failed = true;
+    }
+
+    // DirectStorage may still be reading from the file mapping when the job failed after submitting its pages
+    if (job.gpuDecompressionFence != 0)
+        m_gpuDecompressionQueue->Wait(job.gpuDecompressionFence);
+
+    // Closing the streams calls into the NTC context
+    std::lock_guard lockGuard(m_contextMutex);
+
+    auto it = std::find_if(m_loadingJobs.begin(), m_loadingJobs.end(),
+        [&job](std::shared_ptr<MaterialLoadingJob> const& item) { return item.get() == &job; });
+    assert(it != m_loadingJobs.end());
+    std::swap(*it, m_loadingJobs.back());
+    m_loadingJobs.pop_back();
+}
+
+void NtcMaterialLoader::UpdateMaterialLoading(std::vector<std::shared_ptr<NtcMaterial>>& outReadyMaterials)
+{
+    if (!IsLoadingMaterials())
+        return;
+
+    RecycleLatentUploadBuffers(/* wait = */ false);
+
+    bool hasIoResults;
+    {
+        std::lock_guard lockGuard(m_ioMutex);
+        hasIoResults = !m_ioResults.empty();
+    }
+
+    if (!hasIoResults && m_transcodeQueue.empty() && m_copyUploadBatches.empty())
+        return;
+
+    std::vector<int> usedUploadBuffers;
+    int uploadedMaterialCount = 0;
+    CopyUploadBatch copyUploadBatch;
+
+    m_commandList->open();
+    if (m_copyCommandList)
+        m_copyCommandList->open();
+    nvrhi::ICommandList* uploadCommandList = m_copyCommandList ? m_copyCommandList.Get() : m_commandList.Get();
+
+    RetireCopyUploadBatches();
+
+    BeginTraceScope(m_traceRecorder, "Material Uploads", m_commandList);
+
+    while (uploadedMaterialCount < g_maxMaterialsUploadedPerUpdate)
+    {
+        IoResult result;
+        {
+            std::lock_guard lockGuard(m_ioMutex);
+            if (m_ioResults.empty())
+                break;
+            result = m_ioResults.front();
+            m_ioResults.pop_front();
+        }
+
+        MaterialLoadingJob& job = *result.job;
+        NtcMaterial& material = *job.loadingMaterial;
+
+        switch (result.type)
+        {
+            case IoResult::Type::Metadata: {
+                // Create the latent, weight and constant buffers and upload or convert the weights
+                // while the I/O thread is reading the latents.
+                ntc::ITextureSetMetadata* textureSetMetadata = *material.textureSetMetadata;
+                if (m_autoTuningPending)
+                {
+                    // Materials with a single usable weight type can't be compared, try again with the next one
+                    ntc::InferenceWeightType fastestType;
+                    bool const benchmarkDone = RunInferenceBenchmark(textureSetMetadata, material, fastestType);
+                    m_autoTuningPending = benchmarkDone && fastestType == ntc::InferenceWeightType::Unknown;
+                    if (!benchmarkDone)
+                        log::warning("The inference benchmark failed, using the default weight types.");
+                    else if (fastestType != ntc::InferenceWeightType::Unknown)
+                    {
+                        m_preferredWeightType = fastestType;
+                        log::info("Auto-tuning selected the %s inference weights.", GetWeightTypeName(fastestType));
+                        if (!m_adapterIdentifier.empty() &&
+                            !WriteAutoTuningCache(m_autoTuningCacheFile, m_adapterIdentifier, fastestType))
+                            log::warning("Cannot write the auto-tuning cache file '%s'.",
+                                m_autoTuningCacheFile.generic_string().c_str());
+                    }
+                }
+
+                std::lock_guard lockGuard(m_contextMutex);
+                LatentResidency* latentResidency = m_latentStreaming
+                    ? CreateLatentResidency(job, textureSetMetadata)
+                    : nullptr;
+                job.failed = (m_latentStreaming && !latentResidency) ||
+                    !PrepareMaterialForInferenceOnSample(textureSetMetadata, material, m_commandList,
+                        uploadCommandList, latentResidency);
+                if (!job.failed)
+                    m_loadingStats.latentBytesTotal += material.latentStreamRange.size;
+                break;
+            }
+
+            case IoResult::Type::Latents:
+                if (job.failed)
+                {
+                    // Nothing was copied from this buffer, so it can be reused right away
+                    {
+                        std::lock_guard lockGuard(m_ioMutex);
+                        m_freeLatentUploadBuffers.push_back(result.uploadBufferIndex);
+                    }
+                    m_uploadBufferCondition.notify_one();
+                    break;
+                }
+
+                if (m_copyCommandList)
+                    m_copyCommandList->beginTrackingBufferState(material.ntcLatentsBuffer, nvrhi::ResourceStates::CopyDest);
+                uploadCommandList->copyBuffer(material.ntcLatentsBuffer,
+                    material.ntcLatentsRange.byteOffset + result.latentOffset,
+                    m_latentUploadBuffers[result.uploadBufferIndex].buffer, 0, result.size);
+                usedUploadBuffers.push_back(result.uploadBufferIndex);
+                m_loadingStats.latentBytesUploaded += result.size;
+                break;
+
+            case IoResult::Type::GpuLatents: {
+                if (job.failed)
+                    break;
+
+                // The I/O thread only posts these for compressed files when the copy queue is used. The pages are
+                // submitted right away so that a failed job can wait for its requests before closing the file.
+                auto compressedStream = static_cast<CompressedFileStream*>(job.fileStream.get());
+                uint64_t const bufferOffset = material.ntcLatentsRange.byteOffset + result.latentOffset;
+                uint64_t const firstPageOffset = uint64_t(result.firstPage) * compressedStream->GetPageSize();
+                for (uint32_t page = result.firstPage; page < result.firstPage + result.pageCount; ++page)
+                {
+                    CompressedFileStream::PageInfo const pageInfo = compressedStream->GetPageInfo(page);
+                    m_gpuDecompressionQueue->EnqueuePage(pageInfo, material.ntcLatentsBuffer,
+                        bufferOffset + pageInfo.uncompressedOffset - firstPageOffset);
+                }
+                job.gpuDecompressionFence = m_gpuDecompressionQueue->Submit();
+                m_loadingStats.latentBytesUploaded += result.size;
+                m_loadingStats.latentBytesGpuDecompressed += result.size;
+                break;
+            }
+
+            case IoResult::Type::Failed:
+                job.failed = true;
+                break;
+        }
+
+        if (!result.last)
+            continue;
+
+        ++uploadedMaterialCount;
+
+        // Materials uploaded on the copy queue wait until the copies are finished, see RetireCopyUploadBatches()
+        if (!job.failed && m_copyCommandList)
+        {
+            copyUploadBatch.jobs.push_back(&job);
+            copyUploadBatch.gpuDecompressionFence = std::max(copyUploadBatch.gpuDecompressionFence,
+                job.gpuDecompressionFence);
+            ++m_loadingStats.materialsUploading;
+            continue;
+        }
+
+        // The latent copies recorded above are ordered before the transcoding by the buffer state transitions.
+        if (!job.failed && QueueMaterialForTranscoding(job))
+            continue;
+
+        ++m_loadingStats.materialsFailed;
+        ReleaseLoadingJob(job);
+        --m_loadingJobCount;
+    }
+
+    EndTraceScope(m_traceRecorder);
+
+    BeginTraceScope(m_traceRecorder, "Transcode on Load", m_commandList);
+    ProcessTranscodeQueue(outReadyMaterials);
+    EndTraceScope(m_traceRecorder);
+
+    nvrhi::CommandQueue const uploadQueue = m_copyCommandList ? nvrhi::CommandQueue::Copy : nvrhi::CommandQueue::Graphics;
+    if (m_copyCommandList)
+    {
+        m_copyCommandList->close();
+        m_device->executeCommandList(m_copyCommandList, nvrhi::CommandQueue::Copy);
+    }
+
+    m_commandList->close();
+    m_device->executeCommandList(m_commandList);
+
+    // Track when the GPU is done copying from the upload buffers, so that the I/O threads can reuse them
+    for (int index : usedUploadBuffers)
+    {
+        LatentUploadBuffer& uploadBuffer = m_latentUploadBuffers[index];
+        m_device->setEventQuery(uploadBuffer.query, uploadQueue);
+        uploadBuffer.inFlight = true;
+    }
+
+    if (!copyUploadBatch.jobs.empty())
+    {
+        copyUploadBatch.query = m_device->createEventQuery();
+        m_device->setEventQuery(copyUploadBatch.query, nvrhi::CommandQueue::Copy);
+        m_copyUploadBatches.push_back(std::move(copyUploadBatch));
+    }
+
+    m_device->runGarbageCollection();
+
+    if (!IsLoadingMaterials())
+    {
+        StopIoThreads();
+        ReleaseLatentUploadBuffers();
+
+        using namespace std::chrono;
+        int64_t durationMs = duration_cast<milliseconds>(steady_clock::now() - m_loadingStartTime).count();
+        
+        log::info("%d materials loaded in %lli ms - that's %.2f Mpix from %.2f MB", m_loadingStats.materialsReady,
+            durationMs, double(m_loadingPixels) * 1e-6, double(m_loadingFileSize) * 0x1p-20);
+        if (m_gpuDecompressionQueue)
+            log::info("DirectStorage decompressed %.2f MB of the %.2f MB of latents %s.",
+                double(m_loadingStats.latentBytesGpuDecompressed) * 0x1p-20,
+                double(m_loadingStats.latentBytesUploaded) * 0x1p-20,
+                m_gpuDecompressionQueue->IsGpuDecompression() ? "on the GPU" : "on its CPU fallback");
+
+        // The metadata and staging buffers of the loaded materials are gone, release their pooled blocks
+        log::info("NTC host memory after loading: %s", PooledAllocator::FormatStats(m_allocator.GetStats()).c_str());
+        m_allocator.Trim();
+    }
+}
+
+LatentResidency* NtcMaterialLoader::CreateLatentResidency(MaterialLoadingJob& job,
+    ntc::ITextureSetMetadata* textureSetMetadata)
+{
+    if (m_latentResidency.size() >= NTC_MAX_MIP_REQUEST_SLOTS)
+    {
+        log::warning("Cannot stream the latents of material '%s', the scene has more than %d NTC materials.",
+            job.loadingMaterial->name.c_str(), NTC_MAX_MIP_REQUEST_SLOTS);
+        return nullptr;
+    }
+
+    std::unique_ptr<LatentResidency> residency = std::make_unique<LatentResidency>();
+    residency->slot = uint32_t(m_latentResidency.size());
+    residency->source = job.source;
+    residency->archiveEntry = job.archiveEntry;
+    residency->mips = textureSetMetadata->GetDesc().mips;
+    residency->coarseMip = job.coarseMip;
+    residency->firstResidentMip = job.firstResidentMip;
+    residency->windowMip = job.coarseMip;
+
+    ntc::StreamRange fullRange;
+    if (textureSetMetadata->GetStreamRangeForLatents(0, residency->mips, fullRange) == ntc::Status::Ok)
+        residency->fullLatentSize = fullRange.size;
+
+    job.latentResidency = residency.get();
+    m_latentResidency.push_back(std::move(residency));
+    return job.latentResidency;
+}
+
+void NtcMaterialLoader::ReleaseLatentResidency()
+{
+    // Waits for the reads in flight. The GPU may still use the pool buffers, but their handles are kept
+    // by the command lists and the materials until then.
+    m_latentResidency.clear();
+    m_retiredLatentAllocations.clear();
+    m_retiredLatentBatches.clear();
+    for (MipRequestReadback& readback : m_mipRequestReadbacks)
+        readback.slotCount = 0;
+    if (m_latentPool)
+        m_latentPool->Clear();
+    m_pendingLatentReads = 0;
+    m_latentStreamingStats = LatentStreamingStats();
+}
+
+// Reads a latent range of a material from its source on a worker thread, returns an empty vector on failure.
+// Inline data and archive entries are read from memory, and files are mapped or inflated again.
+static std::vector<uint8_t> ReadLatentRange(donut::engine::FilePathOrInlineData const& source,
+    TextureSetArchive const* archive, TextureSetArchiveEntry const* archiveEntry, ntc::StreamRange range)
+{
+    std::vector<uint8_t> data;
+
+    if (source.data)
+    {
+        uint8_t const* sourceData = static_cast<uint8_t const*>(source.data->buffer->data());
+        size_t const sourceSize = source.data->buffer->size();
+        if (range.offset <= sourceSize && range.size <= sourceSize - range.offset)
+            data.assign(sourceData + range.offset, sourceData + range.offset + range.size);
+        return data;
+    }
+
+    std::unique_ptr<ntc::IStream> stream = archiveEntry
+        ? std::unique_ptr<ntc::IStream>(archive->OpenEntry(*archiveEntry))
+        : OpenTextureSetFile(source.path.c_str());
+    if (!stream)
+        return data;
+
+    data.resize(size_t(range.size));
+    if (!stream->Seek(range.offset) || !stream->Read(data.data(), data.size()))
+        data.clear();
+
+    return data;
+}
+
+void NtcMaterialLoader::StartLatentRead(LatentResidency& residency, int firstMip)
+{
+    NtcMaterial const& material = *residency.materials[0];
+
+    ntc::Status ntcStatus;
+    {
+        std::lock_guard lockGuard(m_contextMutex);
+        ntcStatus = (*material.textureSetMetadata)->GetStreamRangeForLatents(firstMip, residency.mips - firstMip,
+            residency.pendingRange);
+    }
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        log::warning("Cannot stream material '%s', call to GetStreamRangeForLatents failed, error code = %s: %s",
+            material.name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        residency.failed = true;
+        return;
+    }
+
+    residency.pendingFirstMip = firstMip;
+    residency.pendingRead = std::async(std::launch::async,
+        [source = residency.source, archive = m_materialArchive, archiveEntry = residency.archiveEntry,
+            range = residency.pendingRange]()
+        {
+            return ReadLatentRange(source, archive.get(), archiveEntry, range);
+        });
+    ++m_pendingLatentReads;
+}
+
+bool NtcMaterialLoader::FinishLatentRead(LatentResidency& residency, nvrhi::ICommandList* commandList)
+{
+    std::vector<uint8_t> const data = residency.pendingRead.get();
+    --m_pendingLatentReads;
+
+    NtcMaterial& material = *residency.materials[0];
+    if (data.empty())
+    {
+        log::warning("Failed to read the latents for mip %d of material '%s'", residency.pendingFirstMip,
+            material.name.c_str());
+        residency.failed = true;
+        return false;
+    }
+
+    ntc::InferenceData inferenceData;
+    ntc::Status ntcStatus;
+    {
+        std::lock_guard lockGuard(m_contextMutex);
+        ntcStatus = m_ntcContext->MakeInferenceData(*material.textureSetMetadata, residency.pendingRange,
+            ntc::InferenceWeightType(material.weightType), &inferenceData);
+    }
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        log::warning("Failed to make inference data for material '%s', error code = %s: %s",
+            material.name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        residency.failed = true;
+        return false;
+    }
+
+    LatentBufferPool::Allocation allocation = m_latentPool->Allocate(data.size());
+    if (!allocation)
+    {
+        log::warning("Failed to allocate %.2f MB of latents for material '%s'", double(data.size()) / 1048576.0,
+            material.name.c_str());
+        residency.failed = true;
+        return false;
+    }
+
+    // The next frame samples the new latents with the new constants. The old latents may still be read by
+    // the frames in flight, so they go back to the pool later.
+    commandList->writeBuffer(allocation.buffer, data.data(), data.size(), allocation.range.byteOffset);
+
+    NtcMaterialConstants constants {};
+    constants.textureSet = inferenceData.constants;
+    constants.firstResidentMip = residency.pendingFirstMip;
+    constants.mipRequestSlot = residency.slot;
+    commandList->writeBuffer(material.ntcConstantBuffer, &constants, sizeof(constants));
+
+    material.ntcMemorySize = material.ntcMemorySize - residency.allocation.range.byteSize + allocation.range.byteSize;
+    m_retiredLatentAllocations.push_back(residency.allocation);
+    residency.allocation = allocation;
+    residency.firstResidentMip = residency.pendingFirstMip;
+
+    for (std::shared_ptr<NtcMaterial> const& residentMaterial : residency.materials)
+    {
+        residentMaterial->ntcLatentsBuffer = allocation.buffer;
+        residentMaterial->ntcLatentsRange = allocation.range;
+        residentMaterial->latentStreamRange = residency.pendingRange;
+    }
+
+    return true;
+}
+
+void NtcMaterialLoader::UpdateMaterialResidency(LatentResidency& residency, uint32_t requestedMip)
+{
+    if (residency.materials.empty() || residency.failed)
+        return;
+
+    // Materials that were not sampled only need the mips that are always resident
+    int const neededMip = int(std::min(requestedMip, uint32_t(residency.coarseMip)));
+    residency.windowMip = std::min(residency.windowMip, neededMip);
+    ++residency.windowFrames;
+
+    // Finer mips are streamed in as soon as they are requested, and coarser mips replace the resident ones
+    // when no finer mips were requested for the whole window
+    int firstMip = residency.firstResidentMip;
+    if (neededMip < residency.firstResidentMip)
+        firstMip = neededMip;
+    else if (residency.windowFrames >= g_latentEvictionFrames)
+    {
+        firstMip = residency.windowMip;
+        residency.windowMip = residency.coarseMip;
+        residency.windowFrames = 0;
+    }
+
+    if (firstMip == residency.firstResidentMip || residency.pendingRead.valid() ||
+        m_pendingLatentReads >= g_maxLatentStreamingReads)
+        return;
+
+    StartLatentRead(residency, firstMip);
+}
+
+void NtcMaterialLoader::UpdateLatentResidency(nvrhi::ICommandList* commandList, nvrhi::IBuffer* mipRequestBuffer,
+    std::vector<std::shared_ptr<NtcMaterial>>& outChangedMaterials)
+{
+    if (!m_latentStreaming)
+        return;
+
+    uint64_t const frame = m_residencyFrame++;
+
+    // The frames and uploads that could read the allocations retired since the last call have been submitted,
+    // including the one that recorded the replacement. The query is signaled when the GPU has finished them.
+    if (!m_retiredLatentAllocations.empty())
+    {
+        RetiredLatentBatch& batch = m_retiredLatentBatches.emplace_back();
+        batch.query = m_device->createEventQuery();
+        m_device->setEventQuery(batch.query, nvrhi::CommandQueue::Graphics);
+        batch.allocations = std::move(m_retiredLatentAllocations);
+        m_retiredLatentAllocations.clear();
+    }
+
+    while (!m_retiredLatentBatches.empty() && m_device->pollEventQuery(m_retiredLatentBatches.front().query))
+    {
+        for (LatentBufferPool::Allocation& allocation : m_retiredLatentBatches.front().allocations)
+            m_latentPool->Free(allocation);
+        m_retiredLatentBatches.pop_front();
+    }
+
+    if (m_mipRequestReadbacks.empty())
+        m_mipRequestReadbacks.resize(g_mipRequestReadbackLatency);
+
+    // The readback buffer was last written g_mipRequestReadbackLatency frames ago, so the GPU is usually done with it,
+    // and mapBuffer waits for that frame otherwise
+    MipRequestReadback& readback = m_mipRequestReadbacks[frame % g_mipRequestReadbackLatency];
+    if (readback.slotCount != 0)
+    {
+        uint32_t const* requests = static_cast<uint32_t const*>(
+            m_device->mapBuffer(readback.buffer, nvrhi::CpuAccessMode::Read));
+        if (requests)
+        {
+            for (uint32_t slot = 0; slot < readback.slotCount; ++slot)
+                UpdateMaterialResidency(*m_latentResidency[slot], requests[slot]);
+            m_device->unmapBuffer(readback.buffer);
+        }
+    }
+
+    // Read back the requests of this frame and start over
+    readback.slotCount = uint32_t(m_latentResidency.size());
+    if (readback.slotCount != 0)
+    {
+        if (!readback.buffer)
+        {
+            readback.buffer = m_device->createBuffer(nvrhi::BufferDesc()
+                .setByteSize(NTC_MAX_MIP_REQUEST_SLOTS * sizeof(uint32_t))
+                .setCpuAccess(nvrhi::CpuAccessMode::Read)
+                .setInitialState(nvrhi::ResourceStates::CopyDest)
+                .setKeepInitialState(true)
+                .setDebugName("Mip request readback"));
+            if (m_memoryTracker)
+                m_memoryTracker->TrackBuffer(readback.buffer, MemoryCategory::UploadBuffers, "Material Loader");
+        }
+        commandList->copyBuffer(readback.buffer, 0, mipRequestBuffer, 0, readback.slotCount * sizeof(uint32_t));
+    }
+    commandList->clearBufferUInt(mipRequestBuffer, ~0u);
+
+    m_latentStreamingStats = LatentStreamingStats();
+    for (std::unique_ptr<LatentResidency> const& residency : m_latentResidency)
+    {
+        if (residency->pendingRead.valid() &&
+            residency->pendingRead.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            if (FinishLatentRead(*residency, commandList))
+                outChangedMaterials.insert(outChangedMaterials.end(), residency->materials.begin(),
+                    residency->materials.end());
+        }
+
+        if (residency->materials.empty())
+            continue;
+
+        ++m_latentStreamingStats.streamedMaterials;
+        if (residency->firstResidentMip == 0)
+            ++m_latentStreamingStats.materialsAtFinestMip;
+        m_latentStreamingStats.residentLatentBytes += residency->allocation.range.byteSize;
+        m_latentStreamingStats.fullLatentBytes += residency->fullLatentSize;
+    }
+    m_latentStreamingStats.pendingReads = m_pendingLatentReads;
+    m_latentStreamingStats.poolBytes = m_latentPool->GetReservedBytes();
 }
@@ -13,23 +13,39 @@
 #pragma once
 
 #include <libntc/ntc.h>
+#include <ntc-utils/PooledAllocator.h>
 #include <nvrhi/nvrhi.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include "feedbackmanager/include/FeedbackManager.h"
+#include "GpuDecompressionQueue.h"
+#include "LatentBufferPool.h"
+#include "FeedbackTileCache.h"
 
 struct NtcMaterial;
+struct MaterialLoadingJob;
+struct LatentResidency;
+struct TextureTranscodeTask;
+struct MaterialAtlasEntry;
 class GraphicsDecompressionPass;
 class GraphicsBlockCompressionPass;
-
-#define MAX_TILES_PER_FRAME 32
-#define TRANSCODE_BATCH_SIZE 8
+class NtcTranscodePass;
+class TraceRecorder;
+class MemoryTracker;
+class TextureSetArchive;
 
 namespace donut::engine
 {
     struct LoadedTexture;
     class Scene;
+    class ShaderFactory;
 }
 
 struct TranscodeTileInfo
@@ -52,58 +68,434 @@ struct MaterialChannelMap
 
 typedef std::array<int, size_t(ntc::InferenceWeightType::Count)> WeightTypeHistogram;
 
+struct MaterialLoadingStats
+{
+    int materialsTotal = 0;
+    int materialsReady = 0;
+    int materialsFailed = 0;
+    uint64_t latentBytesTotal = 0;
+    uint64_t latentBytesUploaded = 0;
+    uint64_t latentBytesGpuDecompressed = 0; // Part of latentBytesUploaded decompressed by DirectStorage
+    int materialsUploading = 0; // Materials waiting for their copy queue uploads to finish
+    int materialsTranscoding = 0; // Uploaded materials waiting in the transcoding queue
+    uint64_t transcodePixelsPending = 0;
+};
+
+struct LatentStreamingStats
+{
+    int streamedMaterials = 0;
+    int materialsAtFinestMip = 0; // All mip levels are resident
+    int pendingReads = 0;
+    uint64_t residentLatentBytes = 0;
+    uint64_t fullLatentBytes = 0; // Latent size of the streamed materials with all mip levels resident
+    uint64_t poolBytes = 0;       // Reserved by the latent pool
+};
+
+struct WeightPoolStats
+{
+    int uniqueWeightSets = 0; // Converted and stored in the pool
+    int sharedWeightSets = 0; // Materials that reused weights already in the pool
+    int poolBuffers = 0;
+    uint64_t pooledBytes = 0;
+};
+
 class NtcMaterialLoader
 {
 public:
-    NtcMaterialLoader(nvrhi::IDevice* device)
+    NtcMaterialLoader(nvrhi::IDevice* device, std::shared_ptr<donut::engine::ShaderFactory> shaderFactory)
         : m_device(device)
+        , m_shaderFactory(shaderFactory)
     { }
+
+    ~NtcMaterialLoader();
     
-    bool Init(bool enableCoopVecInt8, bool enableCoopVecFP8, nvrhi::ITexture* dummyTexture);
+    // With enableCopyQueue, the constants and latents of the materials are uploaded on the copy queue
+    // when the device has one and IsCopyQueueUploadSupported allows it, which means DX12 only. The weights
+    // still go through the graphics queue because their conversion uses compute shaders.
+    bool Init(bool enableCoopVecInt8, bool enableCoopVecFP8, bool enableCopyQueue, nvrhi::ITexture* dummyTexture);
+
+    bool IsCopyQueueUsed() const { return m_copyCommandList != nullptr; }
 
     bool IsCooperativeVectorInt8Supported() const { return m_coopVecInt8; }
     
     bool IsCooperativeVectorFP8Supported() const { return m_coopVecFP8; }
 
+    // Makes the materials prefer the inference weight type that decompresses fastest on this GPU. The weight types
+    // enabled in Init(...) are timed on the first material that is loaded, and the winner is stored in 'cacheFile'
+    // under the adapter and driver version, so that later runs with the same GPU and driver skip the benchmark.
+    // Materials that don't support the preferred type fall back to the default order.
+    void EnableInferenceAutoTuning(std::filesystem::path const& cacheFile);
+
+    // Returns the weight type selected by auto-tuning, or Unknown if it's disabled or hasn't run yet.
+    ntc::InferenceWeightType GetPreferredWeightType() const { return m_preferredWeightType; }
+
+    // Loads all NTC materials for the scene and returns when they are ready for rendering.
     bool LoadMaterialsForScene(donut::engine::Scene& scene, std::filesystem::path const& materialDir, 
         bool enableInferenceOnLoad, bool enableBlockCompression, bool enableInferenceOnSample,
-        bool enableInferenceOnFeedback, std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager);
+        bool enableInferenceOnFeedback, std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager,
+        int ioThreadCount);
+
+    // Starts loading NTC materials for the scene on a pool of I/O threads and returns immediately.
+    // The materials can be rendered in the meantime, they use only their constant parameters
+    // until UpdateMaterialLoading(...) reports them as ready.
+    bool BeginLoadingMaterialsForScene(donut::engine::Scene& scene, std::filesystem::path const& materialDir, 
+        bool enableInferenceOnLoad, bool enableBlockCompression, bool enableInferenceOnSample,
+        bool enableInferenceOnFeedback, std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager,
+        int ioThreadCount);
+
+    // Processes the data read by the I/O threads since the last call: creates the GPU resources for new materials,
+    // copies the latents from the upload buffers and converts the weights. Then transcodes the uploaded materials
+    // until the transcode budget is spent, see SetTranscodeBudget(...).
+    // Appends the materials that became ready to outReadyMaterials. Must be called on the rendering thread.
+    void UpdateMaterialLoading(std::vector<std::shared_ptr<NtcMaterial>>& outReadyMaterials);
+
+    bool IsLoadingMaterials() const { return m_loadingJobCount != 0; }
+
+    MaterialLoadingStats const& GetMaterialLoadingStats() const { return m_loadingStats; }
+
+    // Limits the number of texels that UpdateMaterialLoading(...) transcodes for Inference on Load in one call,
+    // summed over all textures of the material. At least one region is transcoded per call. 0 means no limit.
+    void SetTranscodeBudget(uint64_t pixelsPerUpdate) { m_transcodeBudgetPixels = pixelsPerUpdate; }
+
+    // Enables trace scopes around the uploads and transcoding passes. The recorder may be null.
+    void SetTraceRecorder(TraceRecorder* traceRecorder) { m_traceRecorder = traceRecorder; }
+
+    // Makes the following scene loads read the materials that are found in the archive from it instead of
+    // the separate NTC files. Entries are matched by the material file paths relative to 'archiveDir'.
+    // The archive may be null.
+    void SetMaterialArchive(std::shared_ptr<TextureSetArchive> archive, std::filesystem::path const& archiveDir)
+    {
+        m_materialArchive = std::move(archive);
+        m_materialArchiveDir = archiveDir;
+    }
+
+    // Makes the following scene loads upload only the coarse mip levels of the Inference on Sample materials
+    // into pooled latent buffers, and stream the finer mips in and out as the shading passes request them,
+    // see UpdateLatentResidency(...). Cannot be combined with Inference on Load or on Feedback, which transcode
+    // from the latents of all mips, or with the copy queue uploads.
+    void SetLatentStreaming(bool enable) { m_latentStreaming = enable; }
 
+    // Makes the following scene loads skip the opacity textures that are otherwise transcoded for the depth
+    // pre-pass when Inference on Load and on Feedback are disabled. The pre-pass then has to evaluate
+    // the opacity of these materials with inference, see NtcForwardShadingPass::UsesAlphaTestInference(...)
+    void SetAlphaTestInference(bool enable) { m_alphaTestInference = enable; }
+
+    // Makes Inference on Load and on Feedback encode the BC1, BC4 and BC5 textures in the decompression dispatch,
+    // see NtcTranscodePass, instead of LibNTC's block compression pass. The fused encoder is faster but only fits
+    // the endpoints to the bounding box of every block, so it's not used for textures with the maximum BC quality.
+    void SetFusedBlockEncoding(bool enable) { m_fusedBlockEncoding = enable; }
+
+    // Reads the mip requests of the frame that finished on the GPU most recently, starts reading the finer mips
+    // that the materials need and drops the mips that were not requested for a while. Records the mip request
+    // readback and clear and the latent updates into commandList, after the shading passes of the frame.
+    // Appends the materials whose latent buffers changed to outChangedMaterials, their binding sets must be recreated.
+    void UpdateLatentResidency(nvrhi::ICommandList* commandList, nvrhi::IBuffer* mipRequestBuffer,
+        std::vector<std::shared_ptr<NtcMaterial>>& outChangedMaterials);
+
+    LatentStreamingStats const& GetLatentStreamingStats() const { return m_latentStreamingStats; }
+
+    // Reports all GPU resources created by the loader to the tracker. The tracker may be null.
+    // Call before Init(...) so that the staging resources are reported too.
+    void SetMemoryTracker(MemoryTracker* memoryTracker) { m_memoryTracker = memoryTracker; }
+
+    // Transcodes any number of feedback tiles. Tiles of the same material and mip are packed into
+    // the staging atlases and share the decompression and BCn compression dispatches.
     bool TranscodeTiles(const std::vector<TranscodeTileInfo>& tiles, nvrhi::ICommandList* commandList,
         bool enableBlockCompression);
 
+    // Advances the staging ring of the tile cache and stores the tiles read back a full ring ago.
+    // Call once per frame on the rendering thread, before UpdateMaterialLoading(...) and TranscodeTiles(...),
+    // which share the staging textures of the frame.
+    void BeginFrame();
+
+    // Makes TranscodeTiles(...) keep the block-compressed tiles in a host memory cache of up to 'memoryBudget'
+    // bytes, and restore the cached tiles with copies when they are requested again. When 'diskDirectory'
+    // is not empty, the tiles are also written there and can be restored by later runs.
+    // Returns false if the disk cache directory cannot be used, the host memory cache works anyway.
+    bool EnableFeedbackTileCache(uint64_t memoryBudget, std::filesystem::path const& diskDirectory);
+
+    // Can be called while TranscodeTiles(...) runs on another thread, returns the stats of its last call.
+    FeedbackTileCacheStats GetFeedbackTileCacheStats();
+
     WeightTypeHistogram const& GetWeightTypeHistogram() const { return m_weightTypeHistogram; }
 
+    WeightPoolStats const& GetWeightPoolStats() const { return m_weightPoolStats; }
+
+    PooledAllocatorStats GetHostMemoryStats() const { return m_allocator.GetStats(); }
+
 private:
     nvrhi::DeviceHandle m_device;
+    std::shared_ptr<donut::engine::ShaderFactory> m_shaderFactory;
     nvrhi::CommandListHandle m_commandList;
+    nvrhi::CommandListHandle m_copyCommandList; // Null when the uploads go through m_commandList
+    std::unique_ptr<GpuDecompressionQueue> m_gpuDecompressionQueue; // Only used with m_copyCommandList
 
+    // Declared before the context so that it's destroyed after the context releases its memory
+    PooledAllocator m_allocator;
     ntc::ContextWrapper m_ntcContext;
 
     bool m_coopVecInt8 = false;
     bool m_coopVecFP8 = false;
     WeightTypeHistogram m_weightTypeHistogram;
 
+    ntc::InferenceWeightType m_preferredWeightType = ntc::InferenceWeightType::Unknown;
+    std::filesystem::path m_autoTuningCacheFile;
+    std::string m_adapterIdentifier;
+    bool m_autoTuningPending = false; // The benchmark runs on the next material that gets its metadata
+
     std::shared_ptr<donut::engine::LoadedTexture> m_dummyTexture;
+    TraceRecorder* m_traceRecorder = nullptr;
+    MemoryTracker* m_memoryTracker = nullptr;
 
     std::shared_ptr<GraphicsDecompressionPass> m_graphicsDecompressionPass;
     std::shared_ptr<GraphicsBlockCompressionPass> m_graphicsBlockCompressionPass;
+    std::shared_ptr<NtcTranscodePass> m_transcodePass; // Fused decompression and encoding for BC1, BC4 and BC5
 
     nvrhi::BufferHandle m_weightUploadBuffer;
 
-    // Textures for tile-based decompression and recompression
-    uint32_t m_texTileColorR8Offset = 0;
-    uint32_t m_texTileColorRGBAOffset = 0;
-    uint32_t m_texTileBlocksRGOffset = 0;
-    uint32_t m_texTileBlocksRGBAOffset = 0;
-    std::vector<nvrhi::TextureHandle> m_texTranscodeTiles;
+    // Converted inference weights of all materials, sub-allocated from large buffers. Materials with
+    // identical weight payloads and weight types share one allocation.
+    struct WeightPoolEntry
+    {
+        ntc::InferenceWeightType weightType = ntc::InferenceWeightType::GenericInt8;
+        std::vector<uint8_t> weights; // Unconverted payload, to tell apart hash collisions
+        nvrhi::BufferHandle buffer;
+        nvrhi::BufferRange range;
+    };
+    std::unordered_multimap<uint64_t, WeightPoolEntry> m_weightPoolEntries;
+    nvrhi::BufferHandle m_weightPoolBuffer; // The buffer that new weights are allocated from
+    uint64_t m_weightPoolOffset = 0;
+    WeightPoolStats m_weightPoolStats;
 
-    bool TranscodeMaterial(ntc::IStream* ntcFile,
-        ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, nvrhi::ICommandList* commandList,
-        bool enableBlockCompression);
+    // Persistently mapped buffers that the I/O threads read the latents into
+    struct LatentUploadBuffer
+    {
+        nvrhi::BufferHandle buffer;
+        nvrhi::EventQueryHandle query;
+        uint8_t* mappedData = nullptr;
+        bool inFlight = false;
+    };
+    std::vector<LatentUploadBuffer> m_latentUploadBuffers;
+
+    // Materials whose last uploads were submitted to the copy queue with one UpdateMaterialLoading(...) call.
+    // They are handed over to the graphics queue when the query is signaled, in submission order.
+    struct CopyUploadBatch
+    {
+        nvrhi::EventQueryHandle query;
+        uint64_t gpuDecompressionFence = 0; // Also waits for the DirectStorage requests of the jobs when not 0
+        std::vector<MaterialLoadingJob*> jobs;
+    };
+    std::deque<CopyUploadBatch> m_copyUploadBatches;
+
+    // Asynchronous loading state. The job queue, the result queue and the free upload buffer list
+    // are shared with the I/O threads and protected by m_ioMutex.
+    std::vector<std::thread> m_ioThreads;
+    std::mutex m_ioMutex;
+    std::condition_variable m_ioResultCondition;
+    std::condition_variable m_uploadBufferCondition;
+    std::deque<MaterialLoadingJob*> m_ioJobs;
+    struct IoResult
+    {
+        // GpuLatents are whole pages of a GDeflate file, decompressed from the file mapping on the GPU
+        enum class Type { Metadata, Latents, GpuLatents, Failed };
+        Type type = Type::Metadata;
+        MaterialLoadingJob* job = nullptr;
+        int uploadBufferIndex = -1;
+        uint64_t latentOffset = 0;
+        uint64_t size = 0;
+        uint32_t firstPage = 0; // GpuLatents only
+        uint32_t pageCount = 0;
+        bool last = false; // No more results will be posted for this job
+    };
+    std::deque<IoResult> m_ioResults;
+    std::vector<int> m_freeLatentUploadBuffers;
+    bool m_stopIoThreads = false;
+
+    // Serializes the calls into the NTC context between the I/O threads and the rendering thread
+    std::mutex m_contextMutex;
+
+    // Protects the staging atlases and the tile cache state that TranscodeTiles(...) and the on-load transcoding
+    // share. Locked before m_contextMutex, which is only held while the NTC passes are recorded.
+    std::mutex m_transcodeAtlasMutex;
+
+    std::vector<std::shared_ptr<MaterialLoadingJob>> m_loadingJobs;
+    int m_loadingJobCount = 0;
+    MaterialLoadingStats m_loadingStats;
+    std::chrono::steady_clock::time_point m_loadingStartTime;
+    uint64_t m_loadingFileSize = 0;
+    uint64_t m_loadingPixels = 0;
+    bool m_enableInferenceOnLoad = false;
+    bool m_enableBlockCompression = false;
+    bool m_enableInferenceOnFeedback = false;
+    std::shared_ptr<nvfeedback::FeedbackManager> m_feedbackManager;
+    std::shared_ptr<TextureSetArchive> m_materialArchive;
+    std::filesystem::path m_materialArchiveDir;
+
+    // Uploaded materials that are transcoded a few regions per update, processed in order
+    std::deque<MaterialLoadingJob*> m_transcodeQueue;
+    uint64_t m_transcodeBudgetPixels = 0;
+
+    // Latent streaming state, the materials are indexed by their mip request slots. The mip requests are
+    // read back through a ring of buffers. The replaced latent allocations are collected until the next
+    // UpdateLatentResidency(...) call, where everything that could read them has been submitted, and go back
+    // to the pool when a query set on the graphics queue at that point is signaled.
+    struct MipRequestReadback
+    {
+        nvrhi::BufferHandle buffer;
+        uint32_t slotCount = 0; // Copied into the buffer, 0 when there is nothing to read
+    };
+    bool m_latentStreaming = false;
+    bool m_alphaTestInference = false;
+    bool m_fusedBlockEncoding = false;
+    std::unique_ptr<LatentBufferPool> m_latentPool;
+    std::vector<std::unique_ptr<LatentResidency>> m_latentResidency;
+    std::vector<MipRequestReadback> m_mipRequestReadbacks;
+    struct RetiredLatentBatch
+    {
+        nvrhi::EventQueryHandle query;
+        std::vector<LatentBufferPool::Allocation> allocations;
+    };
+    std::vector<LatentBufferPool::Allocation> m_retiredLatentAllocations;
+    std::deque<RetiredLatentBatch> m_retiredLatentBatches;
+    uint64_t m_residencyFrame = 0;
+    int m_pendingLatentReads = 0;
+    LatentStreamingStats m_latentStreamingStats;
+
+    // Staging atlases for tile-based decompression and recompression, one of each type per material texture
+    uint32_t m_texAtlasColorR8Offset = 0;
+    uint32_t m_texAtlasColorRGBAOffset = 0;
+    uint32_t m_texAtlasBlocksRGOffset = 0;
+    uint32_t m_texAtlasBlocksRGBAOffset = 0;
+    std::vector<nvrhi::TextureHandle> m_texTranscodeAtlases;
+
+    // Block-compressed tiles are read back into staging textures after transcoding and stored in the cache
+    // when the GPU is done with them. The cached tiles are restored through other staging textures.
+    // Each frame of the ring has a pair of staging textures for the RG and RGBA block formats, shared by all
+    // TranscodeTiles(...) calls between two BeginFrame() calls.
+    struct TileCachePlacement
+    {
+        int format = 0; // 0 for the RG blocks, 1 for RGBA
+        int x = 0;      // Position in the staging texture, in blocks
+        int y = 0;
+        int widthInBlocks = 0;
+        int heightInBlocks = 0;
+    };
+    struct TileCacheStore
+    {
+        FeedbackTileCacheKey key;
+        std::vector<TileCachePlacement> placements; // One per material texture
+    };
+    struct TileCacheShelf
+    {
+        int x = 0;
+        int y = 0;
+        int height = 0;
+
+        // Returns false when the rectangle doesn't fit into the rest of the staging texture
+        bool Allocate(int width, int height, int& outX, int& outY);
+    };
+    struct TileCacheFrame
+    {
+        std::array<nvrhi::StagingTextureHandle, 2> upload;
+        std::array<nvrhi::StagingTextureHandle, 2> readback;
+        std::vector<TileCacheStore> stores;
+    };
+    std::unique_ptr<FeedbackTileCache> m_tileCache;
+    std::vector<TileCacheFrame> m_tileCacheFrames;
+    std::array<TileCacheShelf, 2> m_tileCacheUploadShelves; // Allocation state of the current frame
+    std::array<TileCacheShelf, 2> m_tileCacheReadbackShelves;
+    uint64_t m_tileCacheFrame = 0;
+    std::mutex m_tileCacheStatsMutex;
+    FeedbackTileCacheStats m_tileCacheStats;
+
+    // A rectangle of adjacent tiles in one row that is decompressed into the atlases with one dispatch
+    struct AtlasRun
+    {
+        ntc::Rect srcRect;
+        int atlasX = 0;
+        int atlasY = 0;
+    };
+
+    // Location of a tile in the atlases, width and height are clamped to the mip dimensions
+    struct AtlasTile
+    {
+        nvfeedback::FeedbackTextureTileInfo tileInfo;
+        int atlasX = 0;
+        int atlasY = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    void IoThreadProc();
+    void ReadMaterialData(MaterialLoadingJob& job);
+    int AcquireLatentUploadBuffer();
+    void PostIoResult(IoResult const& result);
+    void RecycleLatentUploadBuffers(bool wait);
+    void ReleaseLatentUploadBuffers();
+    bool QueueMaterialForTranscoding(MaterialLoadingJob& job);
+    void RetireCopyUploadBatches();
+    void ProcessTranscodeQueue(std::vector<std::shared_ptr<NtcMaterial>>& outReadyMaterials);
+    bool FinishMaterial(MaterialLoadingJob& job, std::vector<std::shared_ptr<NtcMaterial>>& outReadyMaterials);
+    // Creates the textures of one material that occupies a rectangle of an atlas texture set,
+    // and copies its part of the textures that were transcoded for the whole atlas
+    bool CopyAtlasMaterialTextures(MaterialAtlasEntry const& atlasEntry, NtcMaterial const& atlasMaterial,
+        NtcMaterial& material);
+    void ReleaseLoadingJob(MaterialLoadingJob& job);
+    void StopIoThreads();
+    LatentResidency* CreateLatentResidency(MaterialLoadingJob& job, ntc::ITextureSetMetadata* textureSetMetadata);
+    void ReleaseLatentResidency();
+    void UpdateMaterialResidency(LatentResidency& residency, uint32_t requestedMip);
+    void StartLatentRead(LatentResidency& residency, int firstMip);
+    bool FinishLatentRead(LatentResidency& residency, nvrhi::ICommandList* commandList);
+
+    bool CreateTranscodedTextures(
+        ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, bool enableBlockCompression);
+
+    void GetTranscodeAtlasIndices(TextureTranscodeTask const& transcodeTask, int textureIndex,
+        uint32_t& outColorIndex, uint32_t& outBlockIndex) const;
+
+    bool UseFusedBlockEncoding(NtcMaterial const& material, TextureTranscodeTask const& transcodeTask) const;
+
+    bool TranscodeAtlas(NtcMaterial const& material, uint32_t mipLevel, std::vector<AtlasRun> const& runs,
+        std::vector<AtlasTile> const& atlasTiles, nvrhi::ICommandList* commandList, bool enableBlockCompression);
+
+    // Copies the cached tiles into their tiled textures through the upload staging textures of the current frame.
+    // Appends the tiles that must be transcoded to outMissedTiles.
+    bool RestoreCachedTiles(std::vector<TranscodeTileInfo> const& tiles, nvrhi::ICommandList* commandList,
+        std::vector<TranscodeTileInfo>& outMissedTiles);
+
+    // Copies the transcoded blocks of the atlas tiles into the readback staging textures, as long as they fit.
+    void ReadBackTilesForCache(NtcMaterial const& material, uint32_t mipLevel,
+        std::vector<AtlasTile> const& atlasTiles, uint32_t const* blockTextureIndices,
+        nvrhi::ICommandList* commandList);
+
+    bool TranscodeMaterialRegion(ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material,
+        int mipLevel, ntc::Rect const& rect, nvrhi::ICommandList* commandList);
+
+    // The constants are written with uploadCommandList, which is either the copy or the graphics command list,
+    // and the weights are uploaded and converted with commandList. With latent streaming, the latents are
+    // allocated from the pool and the constants refer to the residency slot, otherwise latentResidency is null.
+    bool PrepareMaterialForInferenceOnSample(ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material,
+        nvrhi::ICommandList* commandList, nvrhi::ICommandList* uploadCommandList, LatentResidency* latentResidency);
+
+    // Times the decompression of the first mip of the material with every enabled weight type that it supports
+    // and returns the fastest one in outFastestType, or Unknown if fewer than two types can be compared.
+    // Locks m_contextMutex while recording the passes and waits for them to finish on the GPU without it.
+    // The weights of every type go into temporary buffers, the pool only gets the winner's weights when the
+    // materials are prepared. Returns false if the benchmark cannot run.
+    bool RunInferenceBenchmark(ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial const& material,
+        ntc::InferenceWeightType& outFastestType);
+
+    // Finds the weights in the pool or converts them into a new pool allocation.
+    // outNewWeights is set when the weights were not in the pool before.
+    bool GetOrCreatePooledWeights(ntc::ITextureSetMetadata* textureSetMetadata, ntc::InferenceWeightType weightType,
+        void const* weightData, size_t weightSize, size_t convertedWeightSize, nvrhi::ICommandList* commandList,
+        nvrhi::BufferHandle& outBuffer, nvrhi::BufferRange& outRange, bool& outNewWeights);
 
-    bool PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFile,
-        ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, nvrhi::ICommandList* commandList);
+    // Uploads the weights into dstBuffer at dstOffset, converting them when convertedWeightSize is not 0
+    void WriteInferenceWeights(ntc::ITextureSetMetadata* textureSetMetadata, ntc::InferenceWeightType weightType,
+        void const* weightData, size_t weightSize, size_t convertedWeightSize, nvrhi::ICommandList* commandList,
+        nvrhi::IBuffer* dstBuffer, uint64_t dstOffset);
 
     bool PrepareFeedbackMaterial(std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager,
         ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, bool enableBlockCompression);
@@ -0,0 +1,214 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Material resources and NTC texture sampling shared by the forward and deferred shading passes.
+// The including shader declares g_Pass (NtcForwardShadingPassConstants) and includes the NTC inference
+// and STF headers, and u_MipRequests (RWByteAddressBuffer) for latent streaming. With BINDLESS_MATERIALS=1,
+// it also defines NTC_BINDLESS_MATERIAL_INDEX.
+
+#ifndef NTC_MATERIAL_SAMPLING_HLSLI
+#define NTC_MATERIAL_SAMPLING_HLSLI
+
+#if BINDLESS_MATERIALS
+// All NTC materials are stored in one descriptor table, and the draw or dispatch selects the material through
+// push constants. The table entries are written by NtcForwardShadingPass::GetOrCreateBindlessMaterialIndex(...)
+VK_BINDING(0, 0) ConstantBuffer<MaterialConstants> t_BindlessMaterialConstants[] : register(b0, space4);
+#define NTC_BINDLESS_INDEX(resource) (NTC_BINDLESS_MATERIAL_INDEX * NTC_BINDLESS_DESCRIPTORS_PER_MATERIAL + resource)
+#define g_Material t_BindlessMaterialConstants[NTC_BINDLESS_INDEX(NTC_BINDLESS_MATERIAL_CONSTANTS)]
+#else
+DECLARE_CBUFFER(MaterialConstants, g_Material, FORWARD_BINDING_MATERIAL_CONSTANTS, FORWARD_SPACE_MATERIAL);
+#endif
+
+#if NETWORK_VERSION != NTC_NETWORK_UNKNOWN
+
+#if BINDLESS_MATERIALS
+VK_BINDING(1, 0) ConstantBuffer<NtcMaterialConstants> t_BindlessNtcConstants[] : register(b0, space5);
+VK_BINDING(2, 0) ByteAddressBuffer t_BindlessBuffers[] : register(t0, space6);
+#define g_NtcMaterialConstants t_BindlessNtcConstants[NTC_BINDLESS_INDEX(NTC_BINDLESS_NTC_CONSTANTS)]
+#define t_InputFile t_BindlessBuffers[NTC_BINDLESS_INDEX(NTC_BINDLESS_LATENTS_BUFFER)]
+#define t_WeightBuffer t_BindlessBuffers[NTC_BINDLESS_INDEX(NTC_BINDLESS_WEIGHTS_BUFFER)]
+#else
+DECLARE_CBUFFER(NtcMaterialConstants, g_NtcMaterialConstants, FORWARD_BINDING_NTC_MATERIAL_CONSTANTS, FORWARD_SPACE_MATERIAL);
+ByteAddressBuffer t_InputFile    : REGISTER_SRV(FORWARD_BINDING_NTC_LATENTS_BUFFER, FORWARD_SPACE_MATERIAL);
+ByteAddressBuffer t_WeightBuffer : REGISTER_SRV(FORWARD_BINDING_NTC_WEIGHTS_BUFFER, FORWARD_SPACE_MATERIAL);
+#endif
+#define g_NtcMaterial g_NtcMaterialConstants.textureSet
+
+void GetSamplePositionWithSTF(inout HashBasedRNG rng, float2 uv, float2 uvDx, float2 uvDy,
+    out int2 texel, out int mipLevel)
+{
+    float4 random = rng.NextFloat4();
+    STF_SamplerState sampler = STF_SamplerState::Create(random);
+    sampler.SetAnisoMethod(STF_ANISO_LOD_METHOD_DEFAULT);
+    sampler.SetFilterType(g_Pass.stfFilterMode);
+
+    const int2 textureSize = NtcGetTextureDimensions(g_NtcMaterial, 0);
+    const int mipLevels = NtcGetTextureMipLevels(g_NtcMaterial);
+#if NTC_EXPLICIT_GRADIENTS
+    float3 samplePos = sampler.Texture2DGetSamplePosGrad(textureSize.x, textureSize.y, mipLevels, uv, uvDx, uvDy);
+#else
+    float3 samplePos = sampler.Texture2DGetSamplePos(textureSize.x, textureSize.y, mipLevels, uv);
+#endif
+    mipLevel = int(samplePos.z);
+
+    // Report the finest mip level that the wave needs to the latent streaming, and sample the finest
+    // resident mip instead of the ones that are not in memory. The slot is uniform for the draw or dispatch.
+    const uint mipRequestSlot = g_NtcMaterialConstants.mipRequestSlot;
+    if (mipRequestSlot != NTC_NO_MIP_REQUEST_SLOT)
+    {
+        const uint waveMipLevel = WaveActiveMin(uint(mipLevel));
+        if (WaveIsFirstLane())
+            u_MipRequests.InterlockedMin(mipRequestSlot * 4, waveMipLevel);
+
+        mipLevel = max(mipLevel, g_NtcMaterialConstants.firstResidentMip);
+    }
+
+    const int2 mipSize = NtcGetTextureDimensions(g_NtcMaterial, mipLevel);
+
+    bool border;
+    samplePos.xy = STF_ApplyAddressingMode2D(samplePos.xy, mipSize, STF_ADDRESS_MODE_WRAP, border);
+
+    texel = int2(floor(samplePos.xy * mipSize));
+}
+
+// Decompresses all channels of one texel, without converting the colors to linear space.
+void DecompressNtcTexel(int2 texel, int mipLevel, out float channels[NtcParams::OUTPUT_CHANNELS])
+{
+    const bool linearizeColorsOnSample = false;
+#ifdef USE_COOPVEC
+    #if USE_FP8
+        NtcSampleTextureSet_CoopVec_FP8<NETWORK_VERSION>(g_NtcMaterial, t_InputFile, 0,
+            t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
+    #else
+        NtcSampleTextureSet_CoopVec_Int8<NETWORK_VERSION>(g_NtcMaterial, t_InputFile, 0,
+            t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
+    #endif
+#else
+    NtcSampleTextureSet<NETWORK_VERSION>(g_NtcMaterial, t_InputFile, 0,
+        t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
+#endif
+}
+
+// Selects the texel that SampleNtcMaterial(...) decompresses for the pixel on this frame.
+// The UV gradients are only used when NTC_EXPLICIT_GRADIENTS is set, otherwise STF computes them from uv.
+void GetNtcMaterialSamplePosition(uint2 pixelPosition, float2 uv, float2 uvDx, float2 uvDy,
+    out int2 texel, out int mipLevel)
+{
+    HashBasedRNG rng = HashBasedRNG::Create2D(pixelPosition, g_Pass.frameIndex);
+    GetSamplePositionWithSTF(rng, uv, uvDx, uvDy, texel, mipLevel);
+
+#if QUAD_SHARED_INFERENCE
+    // Decompress the same texel for all pixels in the 2x2 quad, rotating through the quad pixels' STF samples
+    // over frames so that temporal AA can resolve them. The lanes in the quad then read the same latents,
+    // which reduces the memory traffic of the latent fetch by up to 4x at the cost of lower spatial detail.
+    const uint quadLane = g_Pass.frameIndex & 3;
+    texel = QuadReadLaneAt(texel, quadLane);
+    mipLevel = QuadReadLaneAt(mipLevel, quadLane);
+#endif
+}
+
+// Decompresses one texel and maps its channels to the material textures
+MaterialTextureSample DecompressNtcMaterial(int2 texel, int mipLevel)
+{
+    // The NtcSampleTextureSet... functions can convert all channels to linear color based on metadata stored
+    // in the constant buffer. But that can be relatively slow if not optimized away by the driver.
+    // Since we know the color spaces for all channels in advance, linearize explicitly below.
+    const bool linearizeColorsOnSample = false;
+
+    // Decompress the texel and get all the channels.
+    float channels[NtcParams::OUTPUT_CHANNELS];
+    DecompressNtcTexel(texel, mipLevel, channels);
+
+    // Initialize the 'textures' object with default values, just in case we miss something below.
+    MaterialTextureSample textures = DefaultMaterialTextures();
+
+    // Distribute the NTC channels into the MaterialTextureSample's fields using a fixed mapping.
+    // The mapping is enforced by the loader, see NtcMaterialLoader.cpp
+    // If some texture channels are not present in the NTC material file, they are replaced with constant values
+    // by the loader.
+    
+    textures.baseOrDiffuse.rgb = float3(
+        channels[CHANNEL_BASE_COLOR + 0],
+        channels[CHANNEL_BASE_COLOR + 1],
+        channels[CHANNEL_BASE_COLOR + 2]);
+
+
+    if (!linearizeColorsOnSample)
+        textures.baseOrDiffuse.rgb = NtcSrgbColorSpace::Decode(textures.baseOrDiffuse.rgb);
+
+    textures.opacity.r = channels[CHANNEL_OPACITY];
+
+    if ((g_Material.flags & MaterialFlags_UseSpecularGlossModel) != 0)
+    {
+        textures.metalRoughOrSpecular.rgb = float3(
+            channels[CHANNEL_SPECULAR_COLOR + 0],
+            channels[CHANNEL_SPECULAR_COLOR + 1],
+            channels[CHANNEL_SPECULAR_COLOR + 2]);
+            
+        if (!linearizeColorsOnSample)
+            textures.metalRoughOrSpecular.rgb = NtcSrgbColorSpace::Decode(textures.metalRoughOrSpecular.rgb);
+        
+        textures.metalRoughOrSpecular.a = channels[CHANNEL_GLOSSINESS];
+    }
+    else
+    {
+        textures.metalRoughOrSpecular.g = channels[CHANNEL_ROUGHNESS];
+        textures.metalRoughOrSpecular.r = channels[CHANNEL_METALNESS];
+    }
+
+    textures.normal.rgb = float3(
+        channels[CHANNEL_NORMAL + 0],
+        channels[CHANNEL_NORMAL + 1],
+        channels[CHANNEL_NORMAL + 2]);
+
+    textures.occlusion.r = channels[CHANNEL_OCCLUSION];
+
+    textures.emissive.rgb = float3(
+        channels[CHANNEL_EMISSIVE + 0],
+        channels[CHANNEL_EMISSIVE + 1],
+        channels[CHANNEL_EMISSIVE + 2]);
+
+    if (!linearizeColorsOnSample)
+        textures.emissive.rgb = NtcSrgbColorSpace::Decode(textures.emissive.rgb);
+    
+    textures.transmission.r = channels[CHANNEL_TRANSMISSION];
+    
+    return textures;
+}
+
+MaterialTextureSample SampleNtcMaterial(uint2 pixelPosition, float2 uv, float2 uvDx, float2 uvDy)
+{
+    int mipLevel;
+    int2 texel;
+    GetNtcMaterialSamplePosition(pixelPosition, uv, uvDx, uvDy, texel, mipLevel);
+    return DecompressNtcMaterial(texel, mipLevel);
+}
+
+// Returns only the opacity channel of the texel that SampleNtcMaterial(...) would decompress for the pixel
+// without quad-shared inference. This skips all shading, but not the network itself: the CoopVec output layer
+// computes all channels in one matrix multiplication, so only the generic path may lose the unused outputs.
+float SampleNtcMaterialOpacity(uint2 pixelPosition, float2 uv)
+{
+    HashBasedRNG rng = HashBasedRNG::Create2D(pixelPosition, g_Pass.frameIndex);
+
+    int mipLevel;
+    int2 texel;
+    GetSamplePositionWithSTF(rng, uv, 0, 0, texel, mipLevel);
+
+    float channels[NtcParams::OUTPUT_CHANNELS];
+    DecompressNtcTexel(texel, mipLevel, channels);
+
+    return channels[CHANNEL_OPACITY];
+}
+#endif
+
+#endif // NTC_MATERIAL_SAMPLING_HLSLI
@@ -32,6 +32,7 @@
 #include <nvrhi/utils.h>
 #include <ntc-utils/DeviceUtils.h>
 #include <ntc-utils/Misc.h>
+#include <ntc-utils/TextureSetArchive.h>
 #include <argparse.h>
 #include <sstream>
 #include <chrono>
@@ -41,13 +42,24 @@
 #include <sstream>
 #include <chrono>
 #include <algorithm>
+#include <unordered_set>
+#include <future>
+#include <thread>
+#include <GLFW/glfw3.h>
 
 #include "NtcMaterialLoader.h"
 #include "NtcMaterial.h"
 #include "NtcForwardShadingPass.h"
+#include "NtcDeferredShadingPass.h"
+#include "Benchmark.h"
+#include "MemoryTracker.h"
 #include "Profiler.h"
 #include "RenderTargets.h"
 
+#if NTC_WITH_DX12
+    #include "compiled_shaders/FeedbackReduce.dxil.h"
+#endif
+
 namespace fs = std::filesystem;
 
 using namespace donut;
@@ -58,6 +70,7 @@ struct
 {
     std::string scenePath;
     const char* materialDir = nullptr;
+    const char* materialArchive = nullptr;
     bool debug = false;
     bool useVulkan = false;
     bool useDX12 = false;
@@ -69,10 +82,121 @@ struct
     bool enableCoopVec = true;
     bool enableCoopVecInt8 = true;
     bool enableCoopVecFP8 = true;
+    bool autoTuneInference = false;
     bool enableDLSS = true;
+    bool asyncLoading = true;
+    bool copyQueueUploads = true;
+    bool latentStreaming = false;
+    bool alphaTestInference = false;
+    bool fusedBlockEncoding = false;
+    int ioThreads = 4;
+    float transcodeBudget = 4.f;
+    float feedbackTranscodeBudget = 1.f;
+    bool feedbackPrefetch = false;
+    int feedbackHeapBudget = 0;
+    bool feedbackOsBudget = true;
+    int feedbackTileCache = 0;
+    const char* feedbackTileCacheDir = nullptr;
+    bool feedbackBatchedReadback = true;
+    bool feedbackWorkerThread = true;
+    bool bindlessMaterials = true;
+    bool pipelineWarmUp = true;
+    bool quadSharedInference = false;
+    bool deferredShading = false;
+    bool materialCache = false;
+    int materialCacheRefresh = 8;
+    int hybridEstimatedMemoryBudget = 256;
+    float hybridTimeBudget = 0.f;
     int adapterIndex = -1;
+    const char* benchmarkOutput = nullptr;
+    const char* cameraPath = nullptr;
+    const char* benchmarkModes = "load,sample,feedback,hybrid";
+    const char* benchmarkFilters = "point,linear,cubic,gaussian";
+    const char* benchmarkAA = "off,taa,dlss";
+    int benchmarkFrames = 300;
+    int benchmarkWarmupFrames = 60;
+    const char* traceFile = nullptr;
 } g_options;
 
+static const char* g_benchmarkFilterNames[] = { "point", "linear", "cubic", "gaussian" }; // STF_FILTER_TYPE_...
+static const char* g_benchmarkAANames[] = { "off", "taa", "dlss" };
+
+// Splits a comma-separated list and checks that every item is one of the known names
+template<size_t N>
+static bool ParseBenchmarkList(char const* list, char const* const (&knownNames)[N], char const* optionName,
+    std::vector<std::string>& outItems)
+{
+    outItems.clear();
+    std::stringstream stream(list ? list : "");
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (item.empty())
+            continue;
+
+        if (std::find_if(std::begin(knownNames), std::end(knownNames),
+            [&item](char const* name) { return item == name; }) == std::end(knownNames))
+        {
+            log::error("Unknown item '%s' in %s.", item.c_str(), optionName);
+            return false;
+        }
+        outItems.push_back(item);
+    }
+    return true;
+}
+
+static char const* GetBenchmarkModeName(NtcMode mode)
+{
+    switch (mode)
+    {
+    case NtcMode::InferenceOnSample:
+        return "sample";
+    case NtcMode::InferenceOnLoad:
+        return "load";
+    case NtcMode::InferenceOnFeedback:
+        return "feedback";
+    case NtcMode::Hybrid:
+        return "hybrid";
+    }
+    return "";
+}
+
+static bool ParseBenchmarkModeName(std::string const& name, NtcMode& outMode)
+{
+    for (NtcMode mode : { NtcMode::InferenceOnSample, NtcMode::InferenceOnLoad, NtcMode::InferenceOnFeedback,
+        NtcMode::Hybrid })
+    {
+        if (name == GetBenchmarkModeName(mode))
+        {
+            outMode = mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Same as ParseBenchmarkList, for the --benchmarkModes option
+static bool ParseBenchmarkModes(char const* list, std::vector<NtcMode>& outModes)
+{
+    outModes.clear();
+    std::stringstream stream(list ? list : "");
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (item.empty())
+            continue;
+
+        NtcMode mode;
+        if (!ParseBenchmarkModeName(item, mode))
+        {
+            log::error("Unknown item '%s' in --benchmarkModes.", item.c_str());
+            return false;
+        }
+        outModes.push_back(mode);
+    }
+    return true;
+}
+
 bool ProcessCommandLine(int argc, const char** argv)
 {
     struct argparse_option options[] = {
@@ -92,9 +216,42 @@ bool ProcessCommandLine(int argc, const char** argv)
         OPT_BOOLEAN(0, "coopVec", &g_options.enableCoopVec, "Enable all CoopVec extensions (default on, use --no-coopVec)"),
         OPT_BOOLEAN(0, "coopVecFP8", &g_options.enableCoopVecFP8, "Enable CoopVec extensions for FP8 math (default on, use --no-coopVecFP8)"),
         OPT_BOOLEAN(0, "coopVecInt8", &g_options.enableCoopVecInt8, "Enable CoopVec extensions for Int8 math (default on, use --no-coopVecInt8)"),
+        OPT_BOOLEAN(0, "autoTuneInference", &g_options.autoTuneInference, "Time the enabled inference math versions on the first material and use the fastest one, the result is cached per GPU and driver"),
         OPT_BOOLEAN(0, "dlss", &g_options.enableDLSS, "Enable DLSS (default on, use --no-dlss)"),
+        OPT_BOOLEAN(0, "asyncLoading", &g_options.asyncLoading, "Load NTC materials in the background while rendering (default on, use --no-asyncLoading)"),
+        OPT_BOOLEAN(0, "copyQueueUploads", &g_options.copyQueueUploads, "Upload the NTC material latents and constants on a dedicated copy queue (default on, use --no-copyQueueUploads)"),
+        OPT_BOOLEAN(0, "latentStreaming", &g_options.latentStreaming, "Keep only the coarse mips of the Inference on Sample materials in memory and stream the finer mips as they are sampled, disables the other NTC modes"),
+        OPT_BOOLEAN(0, "alphaTestInference", &g_options.alphaTestInference, "Evaluate the opacity of alpha tested Inference on Sample materials with inference in the depth pre-pass instead of transcoding it on load"),
+        OPT_BOOLEAN(0, "fusedBlockEncoding", &g_options.fusedBlockEncoding, "Encode the BC1, BC4 and BC5 textures in the decompression shader for inference on load and on feedback, faster but less accurate than the LibNTC encoder"),
+        OPT_INTEGER(0, "ioThreads", &g_options.ioThreads, "Number of threads reading NTC material files (default 4)"),
+        OPT_FLOAT  (0, "transcodeBudget", &g_options.transcodeBudget, "Megapixels transcoded per frame for inference on load during async loading, 0 means no limit (default 4)"),
+        OPT_FLOAT  (0, "feedbackTranscodeBudget", &g_options.feedbackTranscodeBudget, "GPU time in milliseconds spent transcoding tiles per frame for inference on feedback, 8x after a camera cut (default 1)"),
+        OPT_BOOLEAN(0, "feedbackPrefetch", &g_options.feedbackPrefetch, "Prefetch feedback tiles for objects that are about to become visible based on camera motion"),
+        OPT_INTEGER(0, "feedbackHeapBudget", &g_options.feedbackHeapBudget, "Hard limit for the tile heap memory in inference on feedback mode, in MB, 0 means no limit (default 0)"),
+        OPT_BOOLEAN(0, "feedbackOsBudget", &g_options.feedbackOsBudget, "Limit the tile heap memory to the free part of the OS video memory budget (default on, use --no-feedbackOsBudget)"),
+        OPT_INTEGER(0, "feedbackTileCache", &g_options.feedbackTileCache, "Host memory in MB for caching the transcoded tiles in inference on feedback mode and restoring them without inference, 0 disables the cache (default 0)"),
+        OPT_STRING(0, "feedbackTileCacheDir", &g_options.feedbackTileCacheDir, "Also write the cached feedback tiles into this directory and restore them from there on later runs, requires --feedbackTileCache"),
+        OPT_BOOLEAN(0, "feedbackWorkerThread", &g_options.feedbackWorkerThread, "Record tile mapping and transcoding commands for inference on feedback on a worker thread (default on, use --no-feedbackWorkerThread)"),
+        OPT_INTEGER(0, "hybridEstimatedMemoryBudget", &g_options.hybridEstimatedMemoryBudget, "Limit for the estimated transcoded texture memory of the materials selected by the hybrid NTC mode, in MB, 0 means no limit (default 256). All transcoded textures stay loaded"),
+        OPT_FLOAT  (0, "hybridTimeBudget", &g_options.hybridTimeBudget, "Forward pass GPU time in milliseconds that the hybrid NTC mode tries to stay under, 0 means a fixed coverage threshold (default 0)"),
+        OPT_BOOLEAN(0, "pipelineWarmUp", &g_options.pipelineWarmUp, "Create the forward shading pipelines for all material and mode combinations after loading (default on, use --no-pipelineWarmUp)"),
+        OPT_BOOLEAN(0, "quadSharedInference", &g_options.quadSharedInference, "Decompress one texel per 2x2 pixel quad for Inference on Sample, rotating through the quad pixels over frames"),
+        OPT_BOOLEAN(0, "deferredShading", &g_options.deferredShading, "Shade opaque Inference on Sample materials in a compute pass after a thin G-buffer pass, running inference once per pixel"),
+        OPT_BOOLEAN(0, "materialCache", &g_options.materialCache, "With --deferredShading, reuse the material textures decompressed on the previous frame for the pixels that show the same surface"),
+        OPT_INTEGER(0, "materialCacheRefresh", &g_options.materialCacheRefresh, "Number of frames after which every pixel that uses the material cache runs inference again, 1-16 (default 8)"),
+        OPT_BOOLEAN(0, "bindlessMaterials", &g_options.bindlessMaterials, "Bind all materials through one descriptor table for Inference on Sample (default on, use --no-bindlessMaterials)"),
+        OPT_BOOLEAN(0, "feedbackBatchedReadback", &g_options.feedbackBatchedReadback, "Find the textures with feedback requests on the GPU and read back all feedback at once (default on, use --no-feedbackBatchedReadback)"),
         OPT_INTEGER(0, "adapter", &g_options.adapterIndex, "Index of the graphics adapter to use (use ntc-cli.exe --dx12|vk --listAdapters to find out)"),
         OPT_STRING(0, "materialDir", &g_options.materialDir, "Subdirectory near the scene file where NTC materials are located"),
+        OPT_STRING(0, "materialArchive", &g_options.materialArchive, "Load the NTC materials from the specified archive made with ntc-cli --saveArchive, when they are found there"),
+        OPT_STRING(0, "benchmark", &g_options.benchmarkOutput, "Run the benchmark with all combinations of the NTC modes, STF and AA settings, write the per-frame results into a CSV or JSON file, and exit"),
+        OPT_STRING(0, "trace", &g_options.traceFile, "Record CPU and GPU scopes of the renderer passes and save the last frames into a Chrome trace JSON file on exit"),
+        OPT_STRING(0, "cameraPath", &g_options.cameraPath, "Camera path file for the benchmark, also used to save camera keyframes from the UI (default: orbit around the scene)"),
+        OPT_STRING(0, "benchmarkModes", &g_options.benchmarkModes, "Comma-separated NTC modes for the benchmark: load, sample, feedback, hybrid (default all)"),
+        OPT_STRING(0, "benchmarkFilters", &g_options.benchmarkFilters, "Comma-separated STF filter modes for the benchmark: point, linear, cubic, gaussian (default all)"),
+        OPT_STRING(0, "benchmarkAA", &g_options.benchmarkAA, "Comma-separated anti-aliasing modes for the benchmark: off, taa, dlss (default all)"),
+        OPT_INTEGER(0, "benchmarkFrames", &g_options.benchmarkFrames, "Number of frames recorded for every benchmark run (default 300)"),
+        OPT_INTEGER(0, "benchmarkWarmupFrames", &g_options.benchmarkWarmupFrames, "Number of frames rendered before recording every benchmark run (default 60)"),
         OPT_END()
     };
 
@@ -200,6 +357,75 @@ bool ProcessCommandLine(int argc, const char** argv)
         g_options.inferenceOnFeedback = false;
     }
 
+    // The other modes transcode from the latents of all mips, and the pooled latents are written on the
+    // graphics queue only
+    if (g_options.latentStreaming)
+    {
+        if (!g_options.inferenceOnSample)
+        {
+            log::error("The option --latentStreaming requires Inference on Sample.");
+            return false;
+        }
+        g_options.inferenceOnLoad = false;
+        g_options.inferenceOnFeedback = false;
+        g_options.copyQueueUploads = false;
+    }
+
+    if (g_options.ioThreads < 1)
+    {
+        log::error("Invalid --ioThreads value (%d), must be 1 or more.", g_options.ioThreads);
+        return false;
+    }
+
+    if (g_options.transcodeBudget < 0.f)
+    {
+        log::error("Invalid --transcodeBudget value (%.2f), must be 0 or more.", g_options.transcodeBudget);
+        return false;
+    }
+
+    if (g_options.feedbackHeapBudget < 0)
+    {
+        log::error("Invalid --feedbackHeapBudget value (%d), must be 0 or more.", g_options.feedbackHeapBudget);
+        return false;
+    }
+
+    if (g_options.feedbackTileCache < 0)
+    {
+        log::error("Invalid --feedbackTileCache value (%d), must be 0 or more.", g_options.feedbackTileCache);
+        return false;
+    }
+
+    if (g_options.feedbackTileCacheDir && g_options.feedbackTileCache == 0)
+    {
+        log::error("The option --feedbackTileCacheDir requires --feedbackTileCache.");
+        return false;
+    }
+
+    if (g_options.feedbackTranscodeBudget <= 0.f)
+    {
+        log::error("Invalid --feedbackTranscodeBudget value (%.2f), must be more than 0.", g_options.feedbackTranscodeBudget);
+        return false;
+    }
+
+    if (g_options.benchmarkFrames < 1)
+    {
+        log::error("Invalid --benchmarkFrames value (%d), must be 1 or more.", g_options.benchmarkFrames);
+        return false;
+    }
+
+    if (g_options.benchmarkWarmupFrames < 0)
+    {
+        log::error("Invalid --benchmarkWarmupFrames value (%d), must be 0 or more.", g_options.benchmarkWarmupFrames);
+        return false;
+    }
+
+    std::vector<NtcMode> benchmarkModes;
+    std::vector<std::string> benchmarkItems;
+    if (!ParseBenchmarkModes(g_options.benchmarkModes, benchmarkModes) ||
+        !ParseBenchmarkList(g_options.benchmarkFilters, g_benchmarkFilterNames, "--benchmarkFilters", benchmarkItems) ||
+        !ParseBenchmarkList(g_options.benchmarkAA, g_benchmarkAANames, "--benchmarkAA", benchmarkItems))
+        return false;
+
     return true;
 }
 
@@ -229,6 +455,34 @@ public:
 #endif
 };
 
+// The regular depth pass, which skips the alpha tested materials that NtcForwardShadingPass draws into the depth
+// pre-pass with alpha test inference. Those materials have no transcoded opacity textures.
+class NtcDepthPass : public render::DepthPass
+{
+public:
+    using render::DepthPass::DepthPass;
+
+    void SetAlphaTestInference(bool enable, NtcMode ntcMode)
+    {
+        m_alphaTestInference = enable;
+        m_ntcMode = ntcMode;
+    }
+
+    bool SetupMaterial(render::GeometryPassContext& context, const engine::Material* material,
+        nvrhi::RasterCullMode cullMode, nvrhi::GraphicsState& state) override
+    {
+        if (m_alphaTestInference && NtcForwardShadingPass::UsesAlphaTestInference(
+            *static_cast<NtcMaterial const*>(material), m_ntcMode))
+            return false;
+
+        return render::DepthPass::SetupMaterial(context, material, cullMode, state);
+    }
+
+private:
+    bool m_alphaTestInference = false;
+    NtcMode m_ntcMode = NtcMode::InferenceOnSample;
+};
+
 enum class AntiAliasingMode
 {
     Off,
@@ -242,9 +496,81 @@ struct RequestedTile
 {
     nvfeedback::FeedbackTexture* texture;
     uint32_t tileIndex;
+
+    bool operator==(RequestedTile const& other) const
+    {
+        return texture == other.texture && tileIndex == other.tileIndex;
+    }
+};
+
+struct RequestedTileHash
+{
+    size_t operator()(RequestedTile const& tile) const
+    {
+        return std::hash<void*>()(tile.texture) ^ (size_t(tile.tileIndex) * 0x9e3779b97f4a7c15ull);
+    }
+};
+
+// State of a tile that is waiting in the queue to be mapped and transcoded
+struct RequestedTileState
+{
+    uint32_t mip = 0;
+    uint32_t firstRequestFrame = 0;
+    uint32_t requestCount = 0; // Number of times the feedback requested this tile while it was waiting
+    bool prefetch = false; // The tile was first requested by the prefetcher rather than the feedback
+};
+
+// Weights of the factors that determine the order in which the queued tiles are serviced.
+// Coarser mips cover more of the screen, and the shader falls back to them when the finer mips are not mapped,
+// so they are serviced first. Tiles that keep being requested are likely visible in a larger area of the screen.
+// The waiting time makes sure that every tile is serviced eventually.
+const float g_tilePriorityMipWeight = 1.f;
+const float g_tilePriorityRequestWeight = 0.5f; // Per doubling of the request count
+const float g_tilePriorityAgeWeight = 0.1f; // Per frame
+const float g_tilePriorityPrefetchPenalty = 4.f; // Prefetched tiles yield to the tiles requested by the feedback
+
+// Parameters of the feedback tile prefetcher, see PrefetchFeedbackTextures(...)
+const int g_prefetchFramesAhead = 8; // How far the camera motion is extrapolated, covers the feedback readback latency
+const float g_prefetchMipBias = 1.f; // Prefetch one mip coarser than estimated to spend less of the tile budget
+const uint32_t g_prefetchRepeatFrames = 60; // Don't prefetch a texture again sooner, unless a finer mip is needed
+
+// All feedback textures of a material
+static nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> NtcMaterial::* const g_feedbackTextureMembers[] = {
+    &NtcMaterial::baseOrDiffuseTextureFeedback,
+    &NtcMaterial::metalRoughOrSpecularTextureFeedback,
+    &NtcMaterial::normalTextureFeedback,
+    &NtcMaterial::emissiveTextureFeedback,
+    &NtcMaterial::occlusionTextureFeedback,
+    &NtcMaterial::transmissionTextureFeedback,
+    &NtcMaterial::opacityTextureFeedback
 };
 const uint32_t g_feedbackCameraCutFramesInit = 10;
 
+// Limits for the number of tiles transcoded per frame with inference on feedback. Within these limits,
+// the number is derived from the measured transcoding time and --feedbackTranscodeBudget.
+const uint32_t g_feedbackMinTilesPerFrame = 8;
+const uint32_t g_feedbackMaxTilesPerFrame = 4096;
+const uint32_t g_feedbackInitialTilesPerFrame = 32; // Used until the transcoding time is measured
+const float g_feedbackCameraCutBudgetScale = 8.f;
+const float g_feedbackCostSmoothing = 0.1f;
+
+// Number of most recent frames kept by the trace recorder, see --trace
+const size_t g_traceMaxFrames = 1000;
+
+// Benchmark mode, see UpdateBenchmark()
+const float g_benchmarkTimeStep = 1.f / 60.f;
+const int g_benchmarkOrbitKeyframes = 16;
+
+// Selection of Inference on Load or Sample per material in the hybrid mode, see UpdateHybridMaterialModes()
+const float g_hybridInitialCoverage = 0.02f; // Fraction of the screen above which materials are transcoded
+const float g_hybridMinCoverage = 0.001f;
+const float g_hybridMaxCoverage = 0.5f;
+const float g_hybridDemoteRatio = 0.5f; // Transcoded materials return to Sample below this fraction of the threshold
+const float g_hybridCoverageSmoothing = 0.1f;
+const float g_hybridThresholdStep = 1.25f; // Per update when the forward pass is over or well under the time budget
+const float g_hybridTimeHeadroom = 0.8f;
+const uint32_t g_hybridUpdateInterval = 30; // Frames between the selection updates
+
 class NtcSceneRenderer : public app::ImGui_Renderer
 {
 private:
@@ -253,8 +579,9 @@ private:
     RenderTargets m_renderTargets;
 
     
-    std::unique_ptr<render::DepthPass> m_depthPass;
+    std::unique_ptr<NtcDepthPass> m_depthPass;
     std::unique_ptr<NtcForwardShadingPass> m_ntcForwardShadingPass;
+    std::unique_ptr<NtcDeferredShadingPass> m_deferredShadingPass; // Null if bindless materials are not supported
     
     std::shared_ptr<engine::CommonRenderPasses> m_commonPasses;
     std::shared_ptr<engine::TextureCache> m_textureCache;
@@ -275,10 +602,24 @@ private:
 
     // Feedback mode related members
     std::shared_ptr<nvfeedback::FeedbackManager> m_feedbackManager;
+    nvrhi::ShaderHandle m_feedbackReduceShader;
     std::unordered_map<nvfeedback::FeedbackTexture*, donut::engine::LoadedTexture*> m_loadedTexturesByFeedback;
     std::unordered_map<nvfeedback::FeedbackTexture*, NtcMaterial*> m_materialsByFeedback;
-    std::queue<RequestedTile> m_requestedTiles;
+    std::unordered_map<RequestedTile, RequestedTileState, RequestedTileHash> m_requestedTiles;
+    uint32_t m_feedbackFrameCounter = 0;
     uint32_t m_feedbackCameraCutFrames = 0;
+    float m_feedbackTranscodingTimeAvg = 0.f; // Seconds per frame
+    float m_feedbackTilesScheduledAvg = 0.f; // Tiles per frame
+    struct FeedbackTileUpdates
+    {
+        nvfeedback::FeedbackTextureCollection tilesThisFrame;
+        std::unordered_map<NtcMaterial*, std::vector<nvfeedback::FeedbackTextureTileInfo>> materialsAndTiles;
+        uint32_t tilesScheduled = 0;
+        ProfilerRecord* profilerRecord = nullptr;
+    } m_feedbackTileUpdates; // Passed from ProcessInferenceOnFeedback to RecordFeedbackTileUpdates
+    nvrhi::CommandListHandle m_feedbackCommandList;
+    std::future<void> m_feedbackRecording;
+    bool m_feedbackCommandListRecorded = false;
 
     app::SwitchableCamera m_camera;
     engine::PlanarView m_view;
@@ -294,7 +635,27 @@ private:
     std::string m_screenshotFileName;
     bool m_screenshotWithUI = true;
     bool m_useDepthPrepass = true;
+    bool m_useBindlessMaterials = g_options.bindlessMaterials;
+    bool m_useQuadSharedInference = g_options.quadSharedInference;
+    bool m_useDeferredShading = g_options.deferredShading;
+    bool m_useMaterialCache = g_options.materialCache;
+    bool m_pipelineWarmUpPending = g_options.pipelineWarmUp;
+    std::unordered_map<NtcMaterial*, float> m_hybridCoverage; // Smoothed fraction of the screen, loaded materials only
+    float m_hybridCoverageThreshold = g_hybridInitialCoverage;
+    uint32_t m_hybridFramesSinceUpdate = 0;
+    // Transcoded textures of the selected materials, which is what an application would keep resident.
+    // The sample keeps the textures of all materials loaded, so the actual usage is higher.
+    size_t m_hybridEstimatedMemorySize = 0;
+    int m_hybridTranscodedMaterials = 0;
     bool m_enableStochasticFeedback = true;
+    bool m_enableFeedbackPrefetch = false;
+    float m_verticalFov = 0.f;
+    struct PrefetchRecord
+    {
+        uint32_t frameIndex = 0;
+        uint32_t mipLevel = 0;
+    };
+    std::unordered_map<nvfeedback::FeedbackTexture*, PrefetchRecord> m_feedbackPrefetchRecords;
     float m_feedbackThreshold = 0.005f;
 
     size_t m_ntcTextureMemorySize = 0;
@@ -302,6 +663,24 @@ private:
     size_t m_referenceTextureMemorySize = 0;
 
     Profiler m_profiler;
+    std::unique_ptr<TraceRecorder> m_traceRecorder; // Only created with --trace
+    std::unique_ptr<MemoryTracker> m_memoryTracker;
+
+    // Benchmark mode state, see UpdateBenchmark()
+    struct BenchmarkConfiguration
+    {
+        NtcMode ntcMode = NtcMode::InferenceOnSample;
+        bool useSTF = true;
+        int stfFilterMode = STF_FILTER_TYPE_CUBIC;
+        AntiAliasingMode aaMode = AntiAliasingMode::TAA;
+    };
+    std::vector<BenchmarkConfiguration> m_benchmarkConfigurations;
+    std::vector<BenchmarkRun> m_benchmarkRuns;
+    CameraPath m_cameraPath;
+    bool m_benchmarkStarted = false;
+    size_t m_benchmarkRunIndex = 0;
+    int m_benchmarkFrame = 0; // Negative during the warm-up frames of a run
+    int m_exitCode = 0;
 
 public:
     NtcSceneRenderer(app::DeviceManager *deviceManager)
@@ -315,7 +694,24 @@ public:
         m_shaderFactory = std::make_shared<engine::ShaderFactory>(GetDevice(), nullptr, fs::path());
         m_commonPasses = std::make_shared<engine::CommonRenderPasses>(GetDevice(), m_shaderFactory);
         m_bindingCache = std::make_unique<engine::BindingCache>(GetDevice());
-        m_materialLoader = std::make_unique<NtcMaterialLoader>(GetDevice());
+        m_materialLoader = std::make_unique<NtcMaterialLoader>(GetDevice(), m_shaderFactory);
+        m_memoryTracker = std::make_unique<MemoryTracker>(GetDevice());
+        m_materialLoader->SetMemoryTracker(m_memoryTracker.get());
+        m_materialLoader->SetLatentStreaming(g_options.latentStreaming);
+        m_materialLoader->SetAlphaTestInference(g_options.alphaTestInference);
+        m_materialLoader->SetFusedBlockEncoding(g_options.fusedBlockEncoding);
+        if (g_options.feedbackTileCache > 0 && g_options.inferenceOnFeedback)
+        {
+            m_materialLoader->EnableFeedbackTileCache(uint64_t(g_options.feedbackTileCache) << 20,
+                g_options.feedbackTileCacheDir ? fs::path(g_options.feedbackTileCacheDir) : fs::path());
+        }
+        m_enableFeedbackPrefetch = g_options.feedbackPrefetch;
+
+        if (g_options.traceFile)
+        {
+            m_traceRecorder = std::make_unique<TraceRecorder>(GetDevice(), g_traceMaxFrames);
+            m_materialLoader->SetTraceRecorder(m_traceRecorder.get());
+        }
 
 #if DONUT_WITH_DLSS
     if (g_options.enableDLSS)
@@ -334,6 +730,14 @@ public:
             nvfeedback::FeedbackManagerDesc fmDesc = {};
             fmDesc.heapSizeInTiles = 128;
             fmDesc.numFramesInFlight = GetDeviceManager()->GetBackBufferCount();
+            m_feedbackCommandList = GetDevice()->createCommandList(nvrhi::CommandListParameters()
+                .setEnableImmediateExecution(false));
+            if (g_options.feedbackBatchedReadback)
+            {
+                m_feedbackReduceShader = GetDevice()->createShader(nvrhi::ShaderDesc().setShaderType(nvrhi::ShaderType::Compute),
+                    g_FeedbackReduce_dxil, sizeof(g_FeedbackReduce_dxil));
+                fmDesc.feedbackReduceShader = m_feedbackReduceShader;
+            }
             m_feedbackManager = std::shared_ptr<nvfeedback::FeedbackManager>(
                 nvfeedback::CreateFeedbackManager(GetDevice(), fmDesc));
         }
@@ -342,6 +746,9 @@ public:
 
     ~NtcSceneRenderer()
     {
+        if (m_traceRecorder)
+            m_traceRecorder->WriteChromeTrace(g_options.traceFile);
+
         ImPlot::DestroyContext();
         m_scene.reset();
     }
@@ -414,6 +821,123 @@ public:
         return ss.str();
     }
 
+    // Accounts for the memory used by a material that is ready for rendering and registers its feedback textures.
+    void AddLoadedMaterial(NtcMaterial* material)
+    {
+        m_ntcTextureMemorySize += material->ntcMemorySize;
+        m_transcodedTextureMemorySize += material->transcodedMemorySize;
+
+        if (IsHybridModeAvailable())
+            m_hybridCoverage[material] = 0.f;
+
+        if (g_options.inferenceOnFeedback)
+        {
+            auto add_texture = [this](std::shared_ptr<donut::engine::LoadedTexture> loadedTexture, nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> feedbackTexture)
+                {
+                    m_loadedTexturesByFeedback[feedbackTexture.Get()] = loadedTexture.get();
+                };
+
+            add_texture(material->baseOrDiffuseTexture, material->baseOrDiffuseTextureFeedback);
+            add_texture(material->metalRoughOrSpecularTexture, material->metalRoughOrSpecularTextureFeedback);
+            add_texture(material->normalTexture, material->normalTextureFeedback);
+            add_texture(material->emissiveTexture, material->emissiveTextureFeedback);
+            add_texture(material->occlusionTexture, material->occlusionTextureFeedback);
+            add_texture(material->transmissionTexture, material->transmissionTextureFeedback);
+            add_texture(material->opacityTexture, material->opacityTextureFeedback);
+
+            auto add_material = [this](NtcMaterial* material, nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> feedbackTexture)
+                {
+                    m_materialsByFeedback[feedbackTexture.Get()] = material;
+                };
+
+            add_material(material, material->baseOrDiffuseTextureFeedback);
+            add_material(material, material->metalRoughOrSpecularTextureFeedback);
+            add_material(material, material->normalTextureFeedback);
+            add_material(material, material->emissiveTextureFeedback);
+            add_material(material, material->occlusionTextureFeedback);
+            add_material(material, material->transmissionTextureFeedback);
+            add_material(material, material->opacityTextureFeedback);
+
+            // Trigger camera cut
+            m_feedbackCameraCutFrames = g_feedbackCameraCutFramesInit;
+        }
+    }
+
+    // Picks up the materials that finished loading in the background since the last frame.
+    void UpdateMaterialLoading()
+    {
+        if (!m_materialLoader->IsLoadingMaterials())
+            return;
+
+        std::vector<std::shared_ptr<NtcMaterial>> readyMaterials;
+        m_materialLoader->UpdateMaterialLoading(readyMaterials);
+
+        if (readyMaterials.empty())
+            return;
+
+        for (std::shared_ptr<NtcMaterial> const& material : readyMaterials)
+            AddLoadedMaterial(material.get());
+
+        m_weightTypes = FormatWeightTypesText(m_materialLoader->GetWeightTypeHistogram());
+
+        // Update the material constants and drop the binding sets that refer to the placeholder resources
+        m_commandList->open();
+        m_scene->Refresh(m_commandList, GetFrameIndex());
+        m_commandList->close();
+        GetDevice()->executeCommandList(m_commandList);
+
+        m_ntcForwardShadingPass->ResetBindingCache();
+        m_depthPass->ResetBindingCache();
+
+        // The cached textures of the materials that were drawn with placeholders are stale
+        if (m_deferredShadingPass)
+            m_deferredShadingPass->InvalidateMaterialCache();
+    }
+
+    // Reads back the mip levels sampled by the recent frames and streams the material latents in or out.
+    // Recorded after the shading passes, so the changed latents are used starting with the next frame.
+    void UpdateLatentResidency()
+    {
+        std::vector<std::shared_ptr<NtcMaterial>> changedMaterials;
+        m_materialLoader->UpdateLatentResidency(m_commandList, m_ntcForwardShadingPass->GetMipRequestBuffer(),
+            changedMaterials);
+
+        // The binding sets and bindless descriptors of these materials refer to the replaced latent allocations
+        for (std::shared_ptr<NtcMaterial> const& material : changedMaterials)
+            m_ntcForwardShadingPass->ResetMaterialBindings(material.get());
+    }
+
+    // Creates the forward shading pipelines for all loaded materials before they are first drawn,
+    // so that the first frames and NTC mode switches don't stall on pipeline compilation.
+    void WarmUpPipelines()
+    {
+        if (!m_pipelineWarmUpPending || g_options.referenceMaterials || m_materialLoader->IsLoadingMaterials())
+            return;
+        m_pipelineWarmUpPending = false;
+
+        NtcForwardShadingPass::PipelineWarmUpDesc warmUpDesc;
+        for (std::shared_ptr<engine::Material> const& material : m_scene->GetSceneGraph()->GetMaterials())
+            warmUpDesc.materials.push_back(static_cast<NtcMaterial const*>(material.get()));
+        if (g_options.inferenceOnSample)
+            warmUpDesc.ntcModes.push_back(NtcMode::InferenceOnSample);
+        if (g_options.inferenceOnLoad)
+            warmUpDesc.ntcModes.push_back(NtcMode::InferenceOnLoad);
+        if (g_options.inferenceOnFeedback)
+            warmUpDesc.ntcModes.push_back(NtcMode::InferenceOnFeedback);
+        warmUpDesc.frontCounterClockwise = m_view.IsMirrored();
+        warmUpDesc.reverseDepth = m_view.IsReverseDepth();
+        warmUpDesc.bindlessMaterials = g_options.bindlessMaterials;
+        warmUpDesc.threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        auto startTime = std::chrono::steady_clock::now();
+        uint32_t const pipelineCount = m_ntcForwardShadingPass->PrecompilePipelines(warmUpDesc,
+            m_renderTargets.framebufferFactory->GetFramebuffer(m_view));
+        auto endTime = std::chrono::steady_clock::now();
+
+        log::info("Created %u forward shading pipelines in %.2f s using %u threads.", pipelineCount,
+            std::chrono::duration<float>(endTime - startTime).count(), warmUpDesc.threadCount);
+    }
+
     bool LoadScene(std::shared_ptr<vfs::IFileSystem> fs, const std::filesystem::path& sceneFileName) 
     {
         auto stf = std::make_shared<NtcSceneTypeFactory>();
@@ -426,9 +950,33 @@ public:
         {
             fs::path const materialDir = g_options.materialDir ? fs::path(g_options.materialDir) : fs::path();
 
-            if (!m_materialLoader->LoadMaterialsForScene(*m_scene, materialDir,
+            m_materialLoader->SetTranscodeBudget(uint64_t(double(g_options.transcodeBudget) * 1e6));
+
+            if (g_options.materialArchive)
+            {
+                std::string error;
+                std::shared_ptr<TextureSetArchive> archive = TextureSetArchive::Open(g_options.materialArchive, error);
+                if (!archive)
+                {
+                    log::error("%s", error.c_str());
+                    return false;
+                }
+                m_materialLoader->SetMaterialArchive(archive, fs::absolute(g_options.materialArchive).parent_path());
+            }
+
+            if (g_options.asyncLoading)
+            {
+                // Materials render as placeholders until UpdateMaterialLoading() reports them as ready
+                if (!m_materialLoader->BeginLoadingMaterialsForScene(*m_scene, materialDir,
+                    g_options.inferenceOnLoad, g_options.blockCompression, g_options.inferenceOnSample,
+                    g_options.inferenceOnFeedback, m_feedbackManager, g_options.ioThreads))
+                {
+                    return false;
+                }
+            }
+            else if (!m_materialLoader->LoadMaterialsForScene(*m_scene, materialDir,
                 g_options.inferenceOnLoad, g_options.blockCompression, g_options.inferenceOnSample,
-                g_options.inferenceOnFeedback, m_feedbackManager))
+                g_options.inferenceOnFeedback, m_feedbackManager, g_options.ioThreads))
             {
                 return false;
             }
@@ -450,54 +998,17 @@ public:
             for (auto it = m_textureCache->begin(); it != m_textureCache->end(); ++it)
             {
                 if (it->second->texture)
+                {
                     m_referenceTextureMemorySize += GetDevice()->getTextureMemoryRequirements(it->second->texture).size;
+                    m_memoryTracker->TrackTexture(it->second->texture, MemoryCategory::ReferenceTextures,
+                        it->first);
+                }
             }
         }
-        else
-        {
-            for (std::shared_ptr<engine::Material> const& material : m_scene->GetSceneGraph()->GetMaterials())
-            {
-                NtcMaterial const& ntcMaterial = static_cast<NtcMaterial const&>(*material);
-                m_ntcTextureMemorySize += ntcMaterial.ntcMemorySize;
-                m_transcodedTextureMemorySize += ntcMaterial.transcodedMemorySize;
-            }
-        }
-
-        if (g_options.inferenceOnFeedback)
+        else if (!m_materialLoader->IsLoadingMaterials())
         {
             for (std::shared_ptr<engine::Material> const& material : m_scene->GetSceneGraph()->GetMaterials())
-            {
-                NtcMaterial const& ntcMaterial = static_cast<NtcMaterial const&>(*material);
-                
-                auto add_texture = [this](std::shared_ptr<donut::engine::LoadedTexture> loadedTexture, nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> feedbackTexture)
-                    {
-                        m_loadedTexturesByFeedback[feedbackTexture.Get()] = loadedTexture.get();
-                    };
-
-                add_texture(ntcMaterial.baseOrDiffuseTexture, ntcMaterial.baseOrDiffuseTextureFeedback);
-                add_texture(ntcMaterial.metalRoughOrSpecularTexture, ntcMaterial.metalRoughOrSpecularTextureFeedback);
-                add_texture(ntcMaterial.normalTexture, ntcMaterial.normalTextureFeedback);
-                add_texture(ntcMaterial.emissiveTexture, ntcMaterial.emissiveTextureFeedback);
-                add_texture(ntcMaterial.occlusionTexture, ntcMaterial.occlusionTextureFeedback);
-                add_texture(ntcMaterial.transmissionTexture, ntcMaterial.transmissionTextureFeedback);
-                add_texture(ntcMaterial.opacityTexture, ntcMaterial.opacityTextureFeedback);
-
-                auto add_material = [this](NtcMaterial* material, nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> feedbackTexture)
-                    {
-                        m_materialsByFeedback[feedbackTexture.Get()] = material;
-                    };
-
-                NtcMaterial* materialPtr = static_cast<NtcMaterial*>(material.get());
-                add_material(materialPtr, ntcMaterial.baseOrDiffuseTextureFeedback);
-                add_material(materialPtr, ntcMaterial.metalRoughOrSpecularTextureFeedback);
-                add_material(materialPtr, ntcMaterial.normalTextureFeedback);
-                add_material(materialPtr, ntcMaterial.emissiveTextureFeedback);
-                add_material(materialPtr, ntcMaterial.occlusionTextureFeedback);
-                add_material(materialPtr, ntcMaterial.transmissionTextureFeedback);
-                add_material(materialPtr, ntcMaterial.opacityTextureFeedback);
-            }
-            // Trigger camera cut
-            m_feedbackCameraCutFrames = g_feedbackCameraCutFramesInit;
+                AddLoadedMaterial(static_cast<NtcMaterial*>(material.get()));
         }
 
         auto const& sceneCameras = m_scene->GetSceneGraph()->GetCameras();
@@ -540,9 +1051,12 @@ public:
     bool Init()
     {
         if (!m_materialLoader->Init(g_options.enableCoopVecInt8, g_options.enableCoopVecFP8,
-            m_commonPasses->m_BlackTexture))
+            g_options.copyQueueUploads, m_commonPasses->m_BlackTexture))
             return false;
 
+        if (g_options.autoTuneInference)
+            m_materialLoader->EnableInferenceAutoTuning(app::GetDirectoryWithExecutable() / "ntc-inference-tuning.txt");
+
         if (!ImGui_Renderer::Init(m_shaderFactory))
             return false;
 
@@ -565,10 +1079,22 @@ public:
         m_ntcForwardShadingPass = std::make_unique<NtcForwardShadingPass>(GetDevice(),
             m_shaderFactory, m_commonPasses);
 
-        if (!m_ntcForwardShadingPass->Init())
+        // One more than the back buffers, for the frame that is being recorded
+        if (!m_ntcForwardShadingPass->Init(GetDeviceManager()->GetBackBufferCount() + 1))
             return false;
+
+        m_deferredShadingPass = std::make_unique<NtcDeferredShadingPass>(GetDevice(), m_shaderFactory);
+        if (!m_deferredShadingPass->Init(*m_ntcForwardShadingPass))
+        {
+            if (m_useDeferredShading)
+                log::warning("Deferred shading requires bindless materials, which are not supported on this device.");
+            m_deferredShadingPass.reset();
+            m_useDeferredShading = false;
+        }
+        else
+            m_deferredShadingPass->SetMemoryTracker(m_memoryTracker.get());
         
-        m_depthPass = std::make_unique<render::DepthPass>(GetDevice(), m_commonPasses);
+        m_depthPass = std::make_unique<NtcDepthPass>(GetDevice(), m_commonPasses);
         render::DepthPass::CreateParameters depthParams;
         depthParams.numConstantBufferVersions = 128;
         m_depthPass->Init(*m_shaderFactory, depthParams);
@@ -599,11 +1125,21 @@ public:
             .setFormat(nvrhi::Format::D32)
             .setInitialState(nvrhi::ResourceStates::DepthWrite));
 
+        // The deferred shading pass writes the color through a UAV
         m_renderTargets.color = GetDevice()->createTexture(textureDesc
             .setDebugName("Color")
             .setFormat(nvrhi::Format::RGBA16_FLOAT)
+            .setIsUAV(true)
             .setInitialState(nvrhi::ResourceStates::RenderTarget));
 
+        m_renderTargets.gbuffer0 = GetDevice()->createTexture(textureDesc
+            .setDebugName("ThinGBuffer0")
+            .setFormat(nvrhi::Format::RGBA32_UINT)
+            .setIsUAV(false));
+
+        m_renderTargets.gbuffer1 = GetDevice()->createTexture(textureDesc
+            .setDebugName("ThinGBuffer1"));
+
         m_renderTargets.resolvedColor = GetDevice()->createTexture(textureDesc
             .setDebugName("ResolvedColor")
             .setFormat(nvrhi::Format::RGBA16_FLOAT)
@@ -631,12 +1167,24 @@ public:
             .setUseClearValue(false)
             .setInitialState(nvrhi::ResourceStates::RenderTarget));
 
+        for (nvrhi::ITexture* texture : { m_renderTargets.depth.Get(), m_renderTargets.color.Get(),
+            m_renderTargets.gbuffer0.Get(), m_renderTargets.gbuffer1.Get(), m_renderTargets.resolvedColor.Get(),
+            m_renderTargets.feedback1.Get(), m_renderTargets.feedback2.Get(), m_renderTargets.motionVectors.Get() })
+        {
+            m_memoryTracker->TrackTexture(texture, MemoryCategory::RenderTargets, "Renderer");
+        }
+
         m_renderTargets.depthFramebufferFactory = std::make_shared<engine::FramebufferFactory>(GetDevice());
         m_renderTargets.depthFramebufferFactory->DepthTarget = m_renderTargets.depth;
 
         m_renderTargets.framebufferFactory = std::make_shared<engine::FramebufferFactory>(GetDevice());
         m_renderTargets.framebufferFactory->RenderTargets.push_back(m_renderTargets.color);
         m_renderTargets.framebufferFactory->DepthTarget = m_renderTargets.depth;
+
+        m_renderTargets.gbufferFramebufferFactory = std::make_shared<engine::FramebufferFactory>(GetDevice());
+        m_renderTargets.gbufferFramebufferFactory->RenderTargets.push_back(m_renderTargets.gbuffer0);
+        m_renderTargets.gbufferFramebufferFactory->RenderTargets.push_back(m_renderTargets.gbuffer1);
+        m_renderTargets.gbufferFramebufferFactory->DepthTarget = m_renderTargets.depth;
     }
         
     void CreateRenderPasses()
@@ -692,10 +1240,286 @@ public:
         return true;
     }
 
+    // Updates the allocations that the memory tracker can't see as resources, and forgets the released resources.
+    void UpdateMemoryTracker()
+    {
+        if (m_feedbackManager)
+        {
+            nvfeedback::FeedbackManagerStats const stats = m_feedbackManager->GetStats();
+            m_memoryTracker->SetExternalAllocation(MemoryCategory::FeedbackTileHeaps, "Feedback Manager",
+                stats.heapAllocationInBytes);
+            m_memoryTracker->SetExternalAllocation(MemoryCategory::FeedbackBuffers, "Feedback Manager",
+                stats.bufferMemoryInBytes);
+        }
+
+        m_memoryTracker->Update();
+    }
+
+    size_t GetTextureMemorySize() const
+    {
+        if (g_options.referenceMaterials)
+            return m_referenceTextureMemorySize;
+
+        switch (m_ntcMode)
+        {
+        case NtcMode::InferenceOnSample:
+            return m_ntcTextureMemorySize;
+        case NtcMode::InferenceOnLoad:
+            return m_transcodedTextureMemorySize;
+        case NtcMode::InferenceOnFeedback:
+            return size_t(m_feedbackManager->GetStats().heapAllocationInBytes) + m_ntcTextureMemorySize;
+        case NtcMode::Hybrid:
+            return m_ntcTextureMemorySize + m_hybridEstimatedMemorySize;
+        }
+        return 0;
+    }
+
+    static char const* GetAntiAliasingModeName(AntiAliasingMode mode)
+    {
+        switch (mode)
+        {
+        case AntiAliasingMode::Off:
+            return "off";
+        case AntiAliasingMode::TAA:
+            return "taa";
+#if DONUT_WITH_DLSS
+        case AntiAliasingMode::DLSS:
+            return "dlss";
+#endif
+        }
+        return "";
+    }
+
+    // Makes the list of renderer configurations that the benchmark will go through, and the camera path.
+    bool StartBenchmark()
+    {
+        std::vector<NtcMode> modes;
+        std::vector<std::string> filters, aaModes;
+        ParseBenchmarkModes(g_options.benchmarkModes, modes);
+        ParseBenchmarkList(g_options.benchmarkFilters, g_benchmarkFilterNames, "--benchmarkFilters", filters);
+        ParseBenchmarkList(g_options.benchmarkAA, g_benchmarkAANames, "--benchmarkAA", aaModes);
+
+        auto contains = [](auto const& list, auto const& item)
+        {
+            return std::find(list.begin(), list.end(), item) != list.end();
+        };
+
+        std::vector<NtcMode> ntcModes;
+        if (g_options.referenceMaterials)
+            ntcModes.push_back(NtcMode::InferenceOnLoad); // Reference materials ignore the NTC mode, one pass is enough
+        else
+        {
+            if (g_options.inferenceOnLoad && contains(modes, NtcMode::InferenceOnLoad))
+                ntcModes.push_back(NtcMode::InferenceOnLoad);
+            if (g_options.inferenceOnSample && contains(modes, NtcMode::InferenceOnSample))
+                ntcModes.push_back(NtcMode::InferenceOnSample);
+            if (g_options.inferenceOnFeedback && contains(modes, NtcMode::InferenceOnFeedback))
+                ntcModes.push_back(NtcMode::InferenceOnFeedback);
+            if (IsHybridModeAvailable() && contains(modes, NtcMode::Hybrid))
+                ntcModes.push_back(NtcMode::Hybrid);
+        }
+
+        std::vector<AntiAliasingMode> antiAliasingModes;
+        if (contains(aaModes, "off"))
+            antiAliasingModes.push_back(AntiAliasingMode::Off);
+        if (contains(aaModes, "taa"))
+            antiAliasingModes.push_back(AntiAliasingMode::TAA);
+#if DONUT_WITH_DLSS
+        if (m_DLSS && contains(aaModes, "dlss"))
+            antiAliasingModes.push_back(AntiAliasingMode::DLSS);
+#endif
+
+        m_benchmarkConfigurations.clear();
+        for (NtcMode ntcMode : ntcModes)
+        {
+            for (AntiAliasingMode aaMode : antiAliasingModes)
+            {
+                BenchmarkConfiguration config;
+                config.ntcMode = ntcMode;
+                config.aaMode = aaMode;
+
+                // Inference on Sample always uses STF, the other modes are also measured with hardware filtering
+                if (ntcMode != NtcMode::InferenceOnSample)
+                {
+                    config.useSTF = false;
+                    m_benchmarkConfigurations.push_back(config);
+                }
+
+                config.useSTF = true;
+                for (int filterMode = 0; filterMode < int(std::size(g_benchmarkFilterNames)); ++filterMode)
+                {
+                    if (!contains(filters, g_benchmarkFilterNames[filterMode]))
+                        continue;
+                    config.stfFilterMode = filterMode;
+                    m_benchmarkConfigurations.push_back(config);
+                }
+            }
+        }
+
+        if (m_benchmarkConfigurations.empty())
+        {
+            log::error("None of the requested benchmark configurations are available.");
+            return false;
+        }
+
+        if (g_options.cameraPath)
+        {
+            if (!m_cameraPath.Load(g_options.cameraPath))
+                return false;
+        }
+        else
+        {
+            // No path provided, orbit around the scene at the same distance as the default third-person camera
+            auto sceneBoundingBox = m_scene->GetSceneGraph()->GetRootNode()->GetGlobalBoundingBox();
+            dm::float3 const center = sceneBoundingBox.center();
+            float const diagonalLength = length(sceneBoundingBox.diagonal());
+            for (int index = 0; index <= g_benchmarkOrbitKeyframes; ++index)
+            {
+                float const angle = dm::radians(-135.f) + 2.f * dm::PI_f * float(index) / float(g_benchmarkOrbitKeyframes);
+                dm::float3 const offset = dm::float3(cosf(angle), 0.35f, sinf(angle)) * diagonalLength * 0.5f;
+
+                CameraPath::Keyframe keyframe;
+                keyframe.position = center + offset;
+                keyframe.direction = normalize(-offset);
+                m_cameraPath.AddKeyframe(keyframe);
+            }
+        }
+
+        log::info("Starting the benchmark with %d configurations, %d frames each.",
+            int(m_benchmarkConfigurations.size()), g_options.benchmarkFrames);
+
+        m_camera.SwitchToFirstPerson();
+        m_benchmarkRunIndex = 0;
+        ApplyBenchmarkConfiguration();
+        return true;
+    }
+
+    void ApplyBenchmarkConfiguration()
+    {
+        BenchmarkConfiguration const& config = m_benchmarkConfigurations[m_benchmarkRunIndex];
+        m_ntcMode = config.ntcMode;
+        m_useSTF = config.useSTF;
+        m_stfFilterMode = config.stfFilterMode;
+        m_aaMode = config.aaMode;
+        m_previousFrameValid = false;
+        m_feedbackCameraCutFrames = g_feedbackCameraCutFramesInit;
+        m_hybridFramesSinceUpdate = g_hybridUpdateInterval;
+        m_benchmarkFrame = -g_options.benchmarkWarmupFrames;
+
+        // Drop the timings of the previous configuration, including the queries that are still in flight
+        m_prePassTimer.clearHistory();
+        m_renderPassTimer.clearHistory();
+        m_transcodingTimer.clearHistory();
+
+        BenchmarkRun& run = m_benchmarkRuns.emplace_back();
+        run.ntcMode = GetBenchmarkModeName(config.ntcMode);
+        run.useSTF = config.useSTF;
+        run.stfFilterMode = config.useSTF ? g_benchmarkFilterNames[config.stfFilterMode] : "";
+        run.frames.reserve(g_options.benchmarkFrames);
+    }
+
+    // Drives the benchmark mode: waits for the materials and pipelines to be ready, then renders every
+    // configuration along the camera path, and writes the results and exits after the last one.
+    void UpdateBenchmark()
+    {
+        if (!g_options.benchmarkOutput || !m_scene)
+            return;
+
+        if (!m_benchmarkStarted)
+        {
+            if (m_materialLoader->IsLoadingMaterials() || m_pipelineWarmUpPending && !g_options.referenceMaterials)
+                return;
+
+            m_benchmarkStarted = true;
+            if (!StartBenchmark())
+            {
+                m_exitCode = 1;
+                glfwSetWindowShouldClose(GetDeviceManager()->GetWindow(), true);
+                return;
+            }
+        }
+
+        if (m_benchmarkRunIndex >= m_benchmarkConfigurations.size())
+            return;
+
+        // The warm-up frames are rendered at the start of the path so that the history and caches settle
+        float const pathPosition = (m_benchmarkFrame <= 0 || g_options.benchmarkFrames < 2) ? 0.f
+            : float(m_benchmarkFrame) / float(g_options.benchmarkFrames - 1);
+        CameraPath::Keyframe const keyframe = m_cameraPath.Evaluate(pathPosition);
+        m_camera.GetFirstPersonCamera().LookTo(keyframe.position, keyframe.direction, keyframe.up);
+    }
+
+    // Called at the end of Render() to store the timings of the frame in the current benchmark run.
+    void RecordBenchmarkFrame()
+    {
+        if (!m_benchmarkStarted || m_benchmarkRunIndex >= m_benchmarkConfigurations.size())
+            return;
+
+        if (m_benchmarkFrame < 0)
+        {
+            ++m_benchmarkFrame;
+            return;
+        }
+
+        // The timer queries resolve a few frames later, so without warm-up frames the first frames of
+        // a configuration have no timings yet. Hold the camera at the start of the path until they do.
+        if (!m_renderPassTimer.getLatestAvailableTime() ||
+            m_useDepthPrepass && !m_prePassTimer.getLatestAvailableTime())
+            return;
+
+        ++m_benchmarkFrame;
+
+        BenchmarkRun& run = m_benchmarkRuns.back();
+        // DLSS can fall back to TAA on the first frame, so record the mode that was actually used
+        run.aaMode = GetAntiAliasingModeName(m_aaMode);
+
+        BenchmarkFrame& frame = run.frames.emplace_back();
+        frame.frameTime = g_benchmarkTimeStep;
+        frame.prePassTime = m_prePassTimer.getLatestAvailableTime().value_or(0.0);
+        frame.renderTime = m_renderPassTimer.getLatestAvailableTime().value_or(0.0);
+        frame.transcodingTime = m_transcodingTimer.getLatestAvailableTime().value_or(0.0);
+        frame.textureMemorySize = GetTextureMemorySize();
+        if (ProfilerRecord const* record = m_profiler.GetLastRecord())
+        {
+            frame.frameTime = record->frameTime;
+            frame.tilesTotal = record->tilesTotal;
+            frame.tilesAllocated = record->tilesAllocated;
+            frame.tilesStandby = record->tilesStandby;
+            frame.tilesTranscoded = record->tilesTranscoded;
+        }
+
+        if (m_benchmarkFrame < g_options.benchmarkFrames)
+            return;
+
+        if (++m_benchmarkRunIndex < m_benchmarkConfigurations.size())
+        {
+            ApplyBenchmarkConfiguration();
+            return;
+        }
+
+        LogBenchmarkSummary(m_benchmarkRuns);
+        m_memoryTracker->Dump();
+        if (!WriteBenchmarkResults(g_options.benchmarkOutput, g_options.scenePath, m_benchmarkRuns))
+            m_exitCode = 1;
+        else
+            log::info("Benchmark results saved to '%s'.", g_options.benchmarkOutput);
+        glfwSetWindowShouldClose(GetDeviceManager()->GetWindow(), true);
+    }
+
+    int GetExitCode() const
+    {
+        return m_exitCode;
+    }
+
     void Animate(float fElapsedTimeSeconds) override
     {
+        // The benchmark animates with a fixed time step so that every run renders the same sequence of frames
+        if (g_options.benchmarkOutput)
+            fElapsedTimeSeconds = g_benchmarkTimeStep;
+
         ImGui_Renderer::Animate(fElapsedTimeSeconds);
         m_camera.Animate(fElapsedTimeSeconds);
+        UpdateBenchmark();
 
         ProfilerRecord& record = m_profiler.AddRecord();
         record.frameTime = fElapsedTimeSeconds;
@@ -709,6 +1533,8 @@ public:
     { 
         ImGui_Renderer::BackBufferResizing();
         m_bindingCache->Clear();
+        if (m_deferredShadingPass)
+            m_deferredShadingPass->ResetBindingCache();
         m_renderTargets = RenderTargets();
     }
 
@@ -723,6 +1549,7 @@ public:
         m_camera.GetSceneCameraProjectionParams(verticalFov, zNear);
 
         dm::float4x4 const projMatrix = dm::perspProjD3DStyleReverse(verticalFov, aspectRatio, zNear);
+        m_verticalFov = verticalFov;
 
         m_view.SetMatrices(viewMatrix, projMatrix);
         m_view.SetViewport(nvrhi::Viewport(fbinfo.width, fbinfo.height));
@@ -743,35 +1570,79 @@ public:
 
         render::InstancedOpaqueDrawStrategy opaqueDrawStrategy;
         render::TransparentDrawStrategy transparentDrawStrategy;
+
+        // The pass constants are also used by the alpha test inference in the depth pre-pass
+        NtcForwardShadingPass::Context forwardContext;
+        m_ntcForwardShadingPass->PrepareLights(commandList, { m_light },
+            skyParameters.skyColor * skyParameters.brightness,
+            skyParameters.groundColor * skyParameters.brightness);
+        m_ntcForwardShadingPass->PreparePass(forwardContext, commandList, GetFrameIndex(),
+            m_useSTF, m_stfFilterMode, m_useDepthPrepass, m_ntcMode, m_enableStochasticFeedback ? m_feedbackThreshold : 1.0f,
+            m_useBindlessMaterials, m_useQuadSharedInference, m_useDeferredShading && m_deferredShadingPass);
+
+        // The material cache history is only usable when the previous frame went through the deferred pass
+        if (m_deferredShadingPass && (!forwardContext.deferredShading || !m_previousFrameValid))
+            m_deferredShadingPass->InvalidateMaterialCache();
 	
         if (m_useDepthPrepass)
         {
+            TraceScope traceScope(m_traceRecorder.get(), "Depth Pre-pass", commandList);
             m_prePassTimer.beginQuery(m_commandList);
 
+            m_depthPass->SetAlphaTestInference(g_options.alphaTestInference, m_ntcMode);
             render::DepthPass::Context depthContext;
             render::RenderCompositeView(commandList, &m_view, &m_view, *m_renderTargets.depthFramebufferFactory,
                 m_scene->GetSceneGraph()->GetRootNode(), opaqueDrawStrategy, *m_depthPass,
                 depthContext, "Depth Pre-pass");
 
+            // Alpha tested Inference on Sample materials decompress their opacity here
+            if (g_options.alphaTestInference)
+            {
+                NtcForwardShadingPass::Context alphaTestContext = forwardContext;
+                alphaTestContext.alphaTestPrepass = true;
+                render::RenderCompositeView(commandList, &m_view, &m_view, *m_renderTargets.depthFramebufferFactory,
+                    m_scene->GetSceneGraph()->GetRootNode(), opaqueDrawStrategy, *m_ntcForwardShadingPass,
+                    alphaTestContext, "Alpha Test Pre-pass");
+            }
+
             m_prePassTimer.endQuery(m_commandList);
         }
 
-        NtcForwardShadingPass::Context forwardContext;
-        m_ntcForwardShadingPass->PrepareLights(commandList, { m_light },
-            skyParameters.skyColor * skyParameters.brightness,
-            skyParameters.groundColor * skyParameters.brightness);
-        m_ntcForwardShadingPass->PreparePass(forwardContext, commandList, GetFrameIndex(),
-            m_useSTF, m_stfFilterMode, m_useDepthPrepass, m_ntcMode, m_enableStochasticFeedback ? m_feedbackThreshold : 1.0f);
-
+        TraceScope traceScope(m_traceRecorder.get(), "NTC Shading", commandList);
         m_renderPassTimer.beginQuery(m_commandList);
 
+        if (forwardContext.deferredShading)
+        {
+            // Pixels with a zero material word in gbuffer1 are not shaded by the deferred pass
+            commandList->clearTextureUInt(m_renderTargets.gbuffer1, nvrhi::AllSubresources, 0);
+
+            NtcForwardShadingPass::Context gbufferContext = forwardContext;
+            gbufferContext.thinGBufferPass = true;
+            BeginTraceScope(m_traceRecorder.get(), "Thin G-Buffer", commandList);
+            render::RenderCompositeView(commandList, &m_view, &m_view, *m_renderTargets.gbufferFramebufferFactory,
+                m_scene->GetSceneGraph()->GetRootNode(), opaqueDrawStrategy, *m_ntcForwardShadingPass,
+                gbufferContext, "Thin G-Buffer");
+            EndTraceScope(m_traceRecorder.get());
+
+            BeginTraceScope(m_traceRecorder.get(), "Deferred Shading", commandList);
+            m_deferredShadingPass->SetMaterialCache(m_useMaterialCache,
+                uint32_t(std::max(g_options.materialCacheRefresh, 1)));
+            m_deferredShadingPass->Render(commandList, *m_ntcForwardShadingPass, m_renderTargets.gbuffer0,
+                m_renderTargets.gbuffer1, m_renderTargets.depth, m_renderTargets.color, m_view, m_previousView);
+            EndTraceScope(m_traceRecorder.get());
+        }
+
+        BeginTraceScope(m_traceRecorder.get(), "Forward Opaque", commandList);
         render::RenderCompositeView(commandList, &m_view, &m_view, *m_renderTargets.framebufferFactory,
             m_scene->GetSceneGraph()->GetRootNode(), opaqueDrawStrategy, *m_ntcForwardShadingPass,
             forwardContext, "Opaque");
+        EndTraceScope(m_traceRecorder.get());
 
+        BeginTraceScope(m_traceRecorder.get(), "Forward Transparent", commandList);
         render::RenderCompositeView(commandList, &m_view, &m_view, *m_renderTargets.framebufferFactory,
             m_scene->GetSceneGraph()->GetRootNode(), transparentDrawStrategy, *m_ntcForwardShadingPass,
             forwardContext, "Transparent");
+        EndTraceScope(m_traceRecorder.get());
 
         m_renderPassTimer.endQuery(m_commandList);
     }
@@ -794,19 +1665,196 @@ public:
         return true;
     }
 
+    // Returns the number of tiles that fit into the transcoding time budget, based on the average cost of a tile
+    uint32_t GetFeedbackTileLimit(float budgetScale) const
+    {
+        if (m_feedbackTilesScheduledAvg < 1.f || m_feedbackTranscodingTimeAvg <= 0.f)
+            return uint32_t(float(g_feedbackInitialTilesPerFrame) * budgetScale);
+
+        float const timePerTile = m_feedbackTranscodingTimeAvg / m_feedbackTilesScheduledAvg;
+        float const budget = g_options.feedbackTranscodeBudget * 1e-3f * budgetScale;
+        return uint32_t(std::clamp(budget / timePerTile,
+            float(g_feedbackMinTilesPerFrame), float(g_feedbackMaxTilesPerFrame)));
+    }
+
+    // Extrapolates the camera motion to predict the view a few frames ahead, and prefetches the feedback textures
+    // of objects that are not visible now but will be in the predicted view. The mip level is estimated from
+    // the projected size of the object. This hides some of the latency of the feedback readback on fast camera motion.
+    void PrefetchFeedbackTextures(std::unordered_set<nvfeedback::FeedbackTexture*>& outPrefetchedTextures)
+    {
+        dm::affine3 const currentViewMatrix = m_view.GetViewMatrix();
+        dm::affine3 const frameMotion = dm::inverse(m_previousView.GetViewMatrix()) * currentViewMatrix;
+        dm::affine3 predictedViewMatrix = currentViewMatrix;
+        for (int frame = 0; frame < g_prefetchFramesAhead; ++frame)
+            predictedViewMatrix = predictedViewMatrix * frameMotion;
+
+        engine::PlanarView predictedView;
+        predictedView.SetViewport(m_view.GetViewport());
+        predictedView.SetMatrices(predictedViewMatrix, m_view.GetProjectionMatrix(false));
+        predictedView.UpdateCache();
+
+        dm::frustum const currentFrustum = m_view.GetViewFrustum();
+        dm::frustum const predictedFrustum = predictedView.GetViewFrustum();
+        dm::float3 const predictedOrigin = predictedView.GetViewOrigin();
+        float const pixelsPerUnitAtUnitDistance = m_view.GetViewport().height() / (2.f * tanf(m_verticalFov * 0.5f));
+        uint32_t const frameIndex = GetDeviceManager()->GetFrameIndex();
+
+        for (auto const& instance : m_scene->GetSceneGraph()->GetMeshInstances())
+        {
+            // Objects that are visible now are handled by the feedback
+            dm::box3 const bounds = instance->GetNode()->GetGlobalBoundingBox();
+            if (!predictedFrustum.intersectsWith(bounds) || currentFrustum.intersectsWith(bounds))
+                continue;
+
+            float const distance = std::max(dm::length(bounds.center() - predictedOrigin), 1e-3f);
+            float const projectedSize = dm::length(bounds.diagonal()) * pixelsPerUnitAtUnitDistance / distance;
+
+            for (auto const& geometry : instance->GetMesh()->geometries)
+            {
+                NtcMaterial* material = dynamic_cast<NtcMaterial*>(geometry->material.get());
+                if (!material)
+                    continue;
+
+                for (auto const member : g_feedbackTextureMembers)
+                {
+                    nvfeedback::FeedbackTexture* texture = (material->*member).Get();
+                    if (!texture || m_materialsByFeedback.find(texture) == m_materialsByFeedback.end())
+                        continue;
+
+                    nvrhi::TextureDesc const& desc = texture->GetReservedTexture()->getDesc();
+                    float const textureSize = float(std::max(desc.width, desc.height));
+                    uint32_t const mipLevel = uint32_t(std::max(
+                        log2f(textureSize / std::max(projectedSize, 1.f)) + g_prefetchMipBias, 0.f));
+
+                    auto [record, firstTime] = m_feedbackPrefetchRecords.try_emplace(texture);
+                    if (!firstTime && frameIndex - record->second.frameIndex < g_prefetchRepeatFrames
+                        && mipLevel >= record->second.mipLevel)
+                        continue;
+
+                    record->second.frameIndex = frameIndex;
+                    record->second.mipLevel = mipLevel;
+                    m_feedbackManager->PrefetchTexture(texture, mipLevel);
+                    outPrefetchedTextures.insert(texture);
+                }
+            }
+        }
+    }
+
+    static bool IsHybridModeAvailable()
+    {
+        return g_options.inferenceOnLoad && g_options.inferenceOnSample && !g_options.referenceMaterials;
+    }
+
+    // Estimates the fraction of the screen covered by every material from the projected bounds of the visible
+    // mesh instances, smoothed over time. Overlapping instances are counted separately, so this is an upper bound.
+    void MeasureMaterialCoverage()
+    {
+        dm::frustum const viewFrustum = m_view.GetViewFrustum();
+        dm::float3 const viewOrigin = m_view.GetViewOrigin();
+        float const viewportHeight = m_view.GetViewport().height();
+        float const viewportArea = m_view.GetViewport().width() * viewportHeight;
+        float const pixelsPerUnitAtUnitDistance = viewportHeight / (2.f * tanf(m_verticalFov * 0.5f));
+
+        std::unordered_map<NtcMaterial*, float> frameCoverage;
+        for (auto const& instance : m_scene->GetSceneGraph()->GetMeshInstances())
+        {
+            dm::box3 const bounds = instance->GetNode()->GetGlobalBoundingBox();
+            if (!viewFrustum.intersectsWith(bounds))
+                continue;
+
+            float coverage = 1.f;
+            if (!bounds.contains(viewOrigin))
+            {
+                float const distance = std::max(dm::length(bounds.center() - viewOrigin), 1e-3f);
+                float const projectedRadius = 0.5f * dm::length(bounds.diagonal()) * pixelsPerUnitAtUnitDistance / distance;
+                coverage = std::min(dm::PI_f * projectedRadius * projectedRadius / viewportArea, 1.f);
+            }
+
+            for (auto const& geometry : instance->GetMesh()->geometries)
+            {
+                NtcMaterial* material = dynamic_cast<NtcMaterial*>(geometry->material.get());
+                if (material)
+                    frameCoverage[material] += coverage;
+            }
+        }
+
+        for (auto& [material, coverage] : m_hybridCoverage)
+        {
+            auto found = frameCoverage.find(material);
+            float const current = (found != frameCoverage.end()) ? std::min(found->second, 1.f) : 0.f;
+            coverage += (current - coverage) * g_hybridCoverageSmoothing;
+        }
+    }
+
+    // Selects Inference on Load for the materials that cover the most of the screen, as long as their transcoded
+    // textures fit into the memory budget, and Inference on Sample for the rest. With a forward pass time budget,
+    // the coverage threshold follows the measured pass time: lower to transcode more materials when over budget,
+    // higher to keep more of them in NTC form when there is headroom.
+    void UpdateHybridMaterialModes()
+    {
+        MeasureMaterialCoverage();
+
+        if (++m_hybridFramesSinceUpdate < g_hybridUpdateInterval)
+            return;
+        m_hybridFramesSinceUpdate = 0;
+
+        auto renderTime = m_renderPassTimer.getAverageTime();
+        if (g_options.hybridTimeBudget > 0.f && renderTime.has_value())
+        {
+            float const timeBudget = g_options.hybridTimeBudget * 1e-3f;
+            if (renderTime.value() > timeBudget)
+                m_hybridCoverageThreshold /= g_hybridThresholdStep;
+            else if (renderTime.value() < timeBudget * g_hybridTimeHeadroom)
+                m_hybridCoverageThreshold *= g_hybridThresholdStep;
+            m_hybridCoverageThreshold = std::clamp(m_hybridCoverageThreshold, g_hybridMinCoverage, g_hybridMaxCoverage);
+        }
+
+        std::vector<std::pair<float, NtcMaterial*>> candidates;
+        for (auto const& [material, coverage] : m_hybridCoverage)
+        {
+            float const threshold = material->hybridTranscoded
+                ? m_hybridCoverageThreshold * g_hybridDemoteRatio
+                : m_hybridCoverageThreshold;
+
+            material->hybridTranscoded = false;
+            if (coverage >= threshold && material->transcodedMemorySize != 0)
+                candidates.push_back({ coverage, material });
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](auto const& a, auto const& b)
+            { return a.first > b.first; });
+
+        uint64_t const memoryBudget = uint64_t(std::max(g_options.hybridEstimatedMemoryBudget, 0)) << 20;
+        m_hybridEstimatedMemorySize = 0;
+        m_hybridTranscodedMaterials = 0;
+        for (auto const& [coverage, material] : candidates)
+        {
+            if (memoryBudget != 0 && m_hybridEstimatedMemorySize + material->transcodedMemorySize > memoryBudget)
+                continue;
+
+            material->hybridTranscoded = true;
+            m_hybridEstimatedMemorySize += material->transcodedMemorySize;
+            ++m_hybridTranscodedMaterials;
+        }
+    }
+
     void ProcessInferenceOnFeedback()
     {
-        nvfeedback::FeedbackTextureCollection tilesThisFrame;
-        std::unordered_map<NtcMaterial*, std::vector<nvfeedback::FeedbackTextureTileInfo>> materialsAndTiles;
+        m_feedbackTileUpdates = FeedbackTileUpdates();
+        nvfeedback::FeedbackTextureCollection& tilesThisFrame = m_feedbackTileUpdates.tilesThisFrame;
+        uint32_t& tilesScheduled = m_feedbackTileUpdates.tilesScheduled;
+        auto& materialsAndTiles = m_feedbackTileUpdates.materialsAndTiles;
 
         ProfilerRecord* profilerRecord = m_profiler.GetLastRecord();
+        m_feedbackTileUpdates.profilerRecord = profilerRecord;
             
         {
             // Phase 1: Begin frame, readback feedback
             
             m_commandList->open();
 
-            // Use 10% of the total number of managed tiles as the target number of extra standby tiles
+            // Use 10% of the total number of managed tiles as the target number of extra standby tiles.
+            // When there is a heap budget, the feedback manager sizes the standby pool from the budget instead.
             nvfeedback::FeedbackManagerStats const statsLastFrame = m_feedbackManager->GetStats();
             uint32_t standByTileCount = statsLastFrame.tilesTotal / 10;
 
@@ -817,8 +1865,8 @@ public:
                 profilerRecord->tilesStandby = statsLastFrame.tilesStandby;
             }
 
-            // Map and transcode only numTilesMax tiles per frame to reduce frametime spikes
-            uint32_t numTilesMax = MAX_TILES_PER_FRAME;
+            // Map and transcode only as many tiles per frame as fit into the time budget to reduce frametime spikes
+            uint32_t numTilesMax = GetFeedbackTileLimit(1.f);
 
             nvfeedback::FeedbackUpdateConfig fconfig = {};
             fconfig.frameIndex = GetDeviceManager()->GetCurrentBackBufferIndex();
@@ -827,20 +1875,30 @@ public:
             fconfig.defragmentHeaps = false;
             fconfig.releaseEmptyHeaps = false;
             fconfig.numExtraStandbyTiles = standByTileCount;
+            fconfig.heapBudgetInBytes = uint64_t(g_options.feedbackHeapBudget) << 20;
+            fconfig.useVideoMemoryBudget = g_options.feedbackOsBudget;
             if (m_feedbackCameraCutFrames > 0)
             {
                 // For a "camera cut" (or first frame or toggling feedback mode) we update and transcode more for a few frames
                 fconfig.maxTexturesToUpdate = 0;
-                numTilesMax = 256;
+                numTilesMax = GetFeedbackTileLimit(g_feedbackCameraCutBudgetScale);
                 m_feedbackCameraCutFrames--;
             }
+            // Prefetch requests are processed in BeginFrame, so the tiles of these textures that it returns
+            // are likely prefetched
+            std::unordered_set<nvfeedback::FeedbackTexture*> prefetchedTextures;
+            if (m_enableFeedbackPrefetch)
+                PrefetchFeedbackTextures(prefetchedTextures);
+
             nvfeedback::FeedbackTextureCollection updatedTextures = {};
             m_feedbackManager->BeginFrame(m_commandList, fconfig, &updatedTextures);
 
             // Requested packed tiles this frame, will always be mapped
             std::vector<RequestedTile> requestedPackedTiles;
 
-            // Collect all tiles and store them in the queue
+            // Collect all tiles and store them in the queue, merging repeated requests for tiles that are already queued
+            ++m_feedbackFrameCounter;
+            std::vector<nvfeedback::FeedbackTextureTileInfo> tileInfos;
             for (nvfeedback::FeedbackTextureUpdate& texUpdate : updatedTextures.textures)
             {
                 RequestedTile reqTile;
@@ -849,9 +1907,20 @@ public:
                 {
                     reqTile.tileIndex = texUpdate.tileIndices[i];
                     if (texUpdate.texture->IsTilePacked(reqTile.tileIndex))
+                    {
                         requestedPackedTiles.push_back(reqTile);
-                    else
-                        m_requestedTiles.push(reqTile);
+                        continue;
+                    }
+
+                    RequestedTileState& state = m_requestedTiles[reqTile];
+                    if (state.requestCount == 0)
+                    {
+                        texUpdate.texture->GetTileInfo(reqTile.tileIndex, tileInfos);
+                        state.mip = tileInfos.empty() ? 0 : tileInfos[0].mip;
+                        state.firstRequestFrame = m_feedbackFrameCounter;
+                        state.prefetch = prefetchedTextures.find(texUpdate.texture) != prefetchedTextures.end();
+                    }
+                    ++state.requestCount;
                 }
             }
 
@@ -861,43 +1930,62 @@ public:
             // Check the queue and figure out how many tiles we will mapped this frame
             if (!requestedPackedTiles.empty() || !m_requestedTiles.empty())
             {
-                // This schedules a tile to be mapped this frame
+                // This schedules a tile to be mapped this frame, ignoring duplicates
+                std::unordered_map<nvfeedback::FeedbackTexture*, size_t> textureUpdateIndices;
+                std::unordered_set<RequestedTile, RequestedTileHash> scheduledTiles;
                 auto scheduleTileToMap = [&](const RequestedTile& reqTile)
                     {
-                        // Find if we already have this texture in tilesThisFrame
-                        nvfeedback::FeedbackTextureUpdate* pTexUpdate = nullptr;
-                        for (uint32_t t = 0; t < tilesThisFrame.textures.size(); t++)
-                        {
-                            if (tilesThisFrame.textures[t].texture == reqTile.texture)
-                            {
-                                pTexUpdate = &tilesThisFrame.textures[t];
-                                break;
-                            }
-                        }
+                        if (!scheduledTiles.insert(reqTile).second)
+                            return;
 
-                        if (pTexUpdate == nullptr)
+                        // Find if we already have this texture in tilesThisFrame
+                        auto [it, firstTime] = textureUpdateIndices.try_emplace(reqTile.texture, tilesThisFrame.textures.size());
+                        if (firstTime)
                         {
                             // First time we see this texture this frame
                             nvfeedback::FeedbackTextureUpdate texUpdate;
                             texUpdate.texture = reqTile.texture;
                             tilesThisFrame.textures.push_back(texUpdate);
-                            pTexUpdate = &tilesThisFrame.textures.back();
                         }
 
-                        pTexUpdate->tileIndices.push_back(reqTile.tileIndex);
+                        tilesThisFrame.textures[it->second].tileIndices.push_back(reqTile.tileIndex);
                     };
 
-                uint32_t countThisFrame = std::min((uint32_t)m_requestedTiles.size(), numTilesMax);
+                // Select the numTilesMax queued tiles with the highest priority
+                struct PrioritizedTile
+                {
+                    float priority;
+                    RequestedTile tile;
+                };
+                std::vector<PrioritizedTile> prioritizedTiles;
+                prioritizedTiles.reserve(m_requestedTiles.size());
+                for (auto const& [reqTile, state] : m_requestedTiles)
+                {
+                    float const priority = float(state.mip) * g_tilePriorityMipWeight
+                        + log2f(float(state.requestCount)) * g_tilePriorityRequestWeight
+                        + float(m_feedbackFrameCounter - state.firstRequestFrame) * g_tilePriorityAgeWeight
+                        - (state.prefetch ? g_tilePriorityPrefetchPenalty : 0.f);
+                    prioritizedTiles.push_back({ priority, reqTile });
+                }
+
+                uint32_t countThisFrame = std::min((uint32_t)prioritizedTiles.size(), numTilesMax);
+                auto const byPriority = [](PrioritizedTile const& a, PrioritizedTile const& b)
+                    { return a.priority > b.priority; };
+                std::nth_element(prioritizedTiles.begin(), prioritizedTiles.begin() + countThisFrame,
+                    prioritizedTiles.end(), byPriority);
+
                 for (uint32_t i = 0; i < countThisFrame; i++)
                 {
-                    scheduleTileToMap(m_requestedTiles.front());
-                    m_requestedTiles.pop();
+                    scheduleTileToMap(prioritizedTiles[i].tile);
+                    m_requestedTiles.erase(prioritizedTiles[i].tile);
                 }
 
                 // Map and transcode all packed tiles this frame
                 for (auto& packedTile : requestedPackedTiles)
                     scheduleTileToMap(packedTile);
 
+                tilesScheduled = uint32_t(scheduledTiles.size());
+
                 // Collect a set of NtcMaterials and tiles as we will transcode all textures in a material simultaneously
                 std::vector<nvfeedback::FeedbackTextureTileInfo> tiles;
                 for (auto& textureUpdate : tilesThisFrame.textures)
@@ -930,25 +2018,39 @@ public:
             }
         }
 
+        // Phases 2 and 3 only depend on the tiles selected above, so they are recorded on a worker thread
+        // while the render thread records the scene. See SubmitFeedbackTileUpdates(...)
+        if (g_options.feedbackWorkerThread)
+            m_feedbackRecording = std::async(std::launch::async, &NtcSceneRenderer::RecordFeedbackTileUpdates, this);
+        else
+            RecordFeedbackTileUpdates();
+    }
+
+    // Records the tile mapping updates and transcoding for the tiles selected in ProcessInferenceOnFeedback
+    // into m_feedbackCommandList. Runs on a worker thread and must not touch the render thread's state.
+    void RecordFeedbackTileUpdates()
+    {
+        ProfilerRecord* profilerRecord = m_feedbackTileUpdates.profilerRecord;
+
+        m_feedbackCommandList->open();
+
         {
             // Phase 2: Update tile mappings
 
-            m_commandList->open();
-            m_feedbackManager->UpdateTileMappings(m_commandList, &tilesThisFrame);
-            m_commandList->close();
-            GetDevice()->executeCommandList(m_commandList);
+            TraceScope traceScope(m_traceRecorder.get(), "Update Tile Mappings", m_feedbackCommandList);
+            m_feedbackManager->UpdateTileMappings(m_feedbackCommandList, &m_feedbackTileUpdates.tilesThisFrame);
         }
 
         {
             // Phase 3: Decode NTC texture tiles
 
-            m_commandList->open();
-            m_transcodingTimer.beginQuery(m_commandList);
+            TraceScope traceScope(m_traceRecorder.get(), "Transcode Tiles", m_feedbackCommandList);
+            m_transcodingTimer.beginQuery(m_feedbackCommandList);
             std::vector<TranscodeTileInfo> tiles;
-            for (auto& pair : materialsAndTiles)
+            for (auto& pair : m_feedbackTileUpdates.materialsAndTiles)
             {
                 NtcMaterial* ntcmaterial = pair.first;
-                std::vector<nvfeedback::FeedbackTextureTileInfo> tileset = pair.second;
+                std::vector<nvfeedback::FeedbackTextureTileInfo> const& tileset = pair.second;
 
                 for (auto& tile : tileset)
                 {
@@ -956,10 +2058,15 @@ public:
                 }
             }
 
-            for (size_t i = 0; i < tiles.size(); i += TRANSCODE_BATCH_SIZE)
+            // All tiles are transcoded at once so that tiles of the same material and mip share the dispatches
+            m_materialLoader->TranscodeTiles(tiles, m_feedbackCommandList, g_options.blockCompression);
+
+            // Track the average transcoding cost to size the next frames' batches. The timer results arrive
+            // a few frames late, the moving averages smooth out the mismatch with the tile counts.
+            if (std::optional<float> transcodingTime = m_transcodingTimer.getLatestAvailableTime())
             {
-                auto batch = std::vector<TranscodeTileInfo>(tiles.begin() + i, tiles.begin() + std::min(i + TRANSCODE_BATCH_SIZE, tiles.size()));
-                m_materialLoader->TranscodeTiles(batch, m_commandList, g_options.blockCompression);
+                m_feedbackTranscodingTimeAvg += (*transcodingTime - m_feedbackTranscodingTimeAvg) * g_feedbackCostSmoothing;
+                m_feedbackTilesScheduledAvg += (float(m_feedbackTileUpdates.tilesScheduled) - m_feedbackTilesScheduledAvg) * g_feedbackCostSmoothing;
             }
 
             if (profilerRecord)
@@ -967,9 +2074,24 @@ public:
                 profilerRecord->tilesTranscoded = uint32_t(tiles.size());
             }
 
-            m_transcodingTimer.endQuery(m_commandList);
-            m_commandList->close();
-            GetDevice()->executeCommandList(m_commandList);
+            m_transcodingTimer.endQuery(m_feedbackCommandList);
+        }
+
+        m_feedbackCommandList->close();
+        m_feedbackCommandListRecorded = true;
+    }
+
+    // Waits until the worker thread finishes recording the feedback tile updates and submits them
+    // ahead of the scene, which samples the tiles mapped and transcoded on this frame.
+    void SubmitFeedbackTileUpdates()
+    {
+        if (m_feedbackRecording.valid())
+            m_feedbackRecording.get();
+
+        if (m_feedbackCommandListRecorded)
+        {
+            GetDevice()->executeCommandList(m_feedbackCommandList);
+            m_feedbackCommandListRecorded = false;
         }
     }
 
@@ -1008,12 +2130,29 @@ public:
         }
 #endif
 
+        if (m_traceRecorder)
+            m_traceRecorder->BeginFrame();
+
+        m_materialLoader->BeginFrame();
+
+        BeginTraceScope(m_traceRecorder.get(), "Material Loading");
+        UpdateMaterialLoading();
+        WarmUpPipelines();
+        EndTraceScope(m_traceRecorder.get());
+
         // Inference on Feedback mode
         if (m_ntcMode == NtcMode::InferenceOnFeedback)
         {
+            TraceScope traceScope(m_traceRecorder.get(), "Process Feedback");
             ProcessInferenceOnFeedback();
         }
 
+        if (m_ntcMode == NtcMode::Hybrid)
+        {
+            TraceScope traceScope(m_traceRecorder.get(), "Update Hybrid Modes");
+            UpdateHybridMaterialModes();
+        }
+
         // Scene rendering
         
         m_commandList->open();
@@ -1023,12 +2162,19 @@ public:
 
         RenderScene(m_commandList);
 
+        if (g_options.latentStreaming)
+        {
+            TraceScope traceScope(m_traceRecorder.get(), "Latent Residency", m_commandList);
+            UpdateLatentResidency();
+        }
+
         switch (m_aaMode)
         {
             case AntiAliasingMode::Off:
                 m_commonPasses->BlitTexture(m_commandList, framebuffer, m_renderTargets.color, m_bindingCache.get());
                 break;
             case AntiAliasingMode::TAA: {
+                TraceScope traceScope(m_traceRecorder.get(), "TAA", m_commandList);
                 m_taaPass->RenderMotionVectors(m_commandList, m_view, m_previousView);
                 donut::render::TemporalAntiAliasingParameters taaParams;
                 m_taaPass->TemporalResolve(m_commandList, taaParams, m_previousFrameValid, m_view, m_view);
@@ -1036,7 +2182,8 @@ public:
                 break;
             }
 #if DONUT_WITH_DLSS
-            case AntiAliasingMode::DLSS:
+            case AntiAliasingMode::DLSS: {
+                TraceScope traceScope(m_traceRecorder.get(), "DLSS", m_commandList);
                 m_taaPass->RenderMotionVectors(m_commandList, m_view, m_previousView);
 
                 render::DLSS::EvaluateParameters params;
@@ -1049,10 +2196,12 @@ public:
 
                 m_commonPasses->BlitTexture(m_commandList, framebuffer, m_renderTargets.resolvedColor, m_bindingCache.get());
                 break;
+            }
 #endif
         }
         
         m_commandList->close();
+        SubmitFeedbackTileUpdates();
         GetDevice()->executeCommandList(m_commandList);
 
         // Resolve feedback
@@ -1060,18 +2209,27 @@ public:
         {
             m_commandList->open();
 
+            BeginTraceScope(m_traceRecorder.get(), "Feedback Resolve", m_commandList);
             m_feedbackManager->ResolveFeedback(m_commandList);
+            EndTraceScope(m_traceRecorder.get());
             m_feedbackManager->EndFrame();
 
             m_commandList->close();
             GetDevice()->executeCommandList(m_commandList);
         }
 
+        if (m_traceRecorder)
+            m_traceRecorder->EndFrame();
+
+        UpdateMemoryTracker();
+
         m_prePassTimer.update();
         m_renderPassTimer.update();
         m_transcodingTimer.update();
         m_previousFrameValid = true;
 
+        RecordBenchmarkFrame();
+
         if (!m_screenshotFileName.empty() && !m_screenshotWithUI)
             SaveScreenshot();
 
@@ -1097,11 +2255,10 @@ public:
             ImGui::PushFont(m_largerFont->GetScaledFont());
 
             char const* textureType = "";
-            size_t textureMemorySize = 0;
+            size_t const textureMemorySize = GetTextureMemorySize();
             if (g_options.referenceMaterials)
             {
                 textureType = "Reference Textures (PNGs etc.)";
-                textureMemorySize = m_referenceTextureMemorySize;
             }
             else
             {
@@ -1109,24 +2266,56 @@ public:
                 {
                 case NtcMode::InferenceOnSample:
                     textureType = "NTC Inference on Sample";
-                    textureMemorySize = m_ntcTextureMemorySize;
                     break;
                 case NtcMode::InferenceOnLoad:
                     if (g_options.blockCompression)
                         textureType = "NTC Transcoded to BCn";
                     else
                         textureType = "NTC Decompressed on Load";
-                    textureMemorySize += m_transcodedTextureMemorySize;
                     break;
                 case NtcMode::InferenceOnFeedback:
                     textureType = "NTC Inference on Feedback";
-                    textureMemorySize = size_t(m_feedbackManager->GetStats().heapAllocationInBytes) + m_ntcTextureMemorySize;
+                    break;
+                case NtcMode::Hybrid:
+                    textureType = "NTC Hybrid Inference on Load and Sample";
                     break;
                 }
             }
 
             ImGui::TextUnformatted(textureType);
-            ImGui::Text("Texture Memory: %.2f MB", float(textureMemorySize) / 1048576.f);
+            if (m_ntcMode == NtcMode::Hybrid && !g_options.referenceMaterials)
+            {
+                ImGui::Text("Estimated Texture Memory: %.2f MB", float(textureMemorySize) / 1048576.f);
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip("NTC data of all materials and the transcoded textures of the selected ones.\n"
+                        "The transcoded textures of the other materials stay loaded for switching the modes.");
+            }
+            else
+                ImGui::Text("Texture Memory: %.2f MB", float(textureMemorySize) / 1048576.f);
+
+            if (ImGui::TreeNode("GPU Memory Breakdown"))
+            {
+                // Unlike the texture memory above, this includes all loaded versions of the materials
+                MemoryStats const memoryStats = m_memoryTracker->GetStats();
+                for (size_t index = 0; index < memoryStats.categories.size(); ++index)
+                {
+                    MemoryCategoryStats const& categoryStats = memoryStats.categories[index];
+                    if (categoryStats.resources != 0)
+                    {
+                        ImGui::Text("%s: %.2f MB", MemoryCategoryToString(MemoryCategory(index)),
+                            double(categoryStats.bytes) / 1048576.0);
+                    }
+                }
+                ImGui::Text("Total: %.2f MB", double(memoryStats.totalBytes) / 1048576.0);
+                if (ImGui::Button("Dump to Log"))
+                    m_memoryTracker->Dump();
+                ImGui::TreePop();
+            }
+            if (m_ntcMode == NtcMode::Hybrid)
+            {
+                ImGui::Text("Transcoded Materials: %d / %d (above %.1f%% of the screen)", m_hybridTranscodedMaterials,
+                    int(m_hybridCoverage.size()), m_hybridCoverageThreshold * 100.f);
+            }
             
             auto renderTime = m_renderPassTimer.getAverageTime();
             if (renderTime.has_value())
@@ -1136,6 +2325,48 @@ public:
             if (!g_options.referenceMaterials)
             {
                 ImGui::TextUnformatted(m_weightTypes.c_str());
+
+                WeightPoolStats const& weightPoolStats = m_materialLoader->GetWeightPoolStats();
+                if (weightPoolStats.uniqueWeightSets != 0)
+                {
+                    ImGui::Text("Unique Weight Sets: %d (%d shared, %.2f MB)", weightPoolStats.uniqueWeightSets,
+                        weightPoolStats.sharedWeightSets, double(weightPoolStats.pooledBytes) / 1048576.0);
+                }
+
+                PooledAllocatorStats const hostMemoryStats = m_materialLoader->GetHostMemoryStats();
+                ImGui::Text("NTC Host Memory: %.2f MB in %d allocations (peak %.2f MB, %.2f MB pooled)",
+                    double(hostMemoryStats.bytesAllocated) / 1048576.0, int(hostMemoryStats.liveAllocations),
+                    double(hostMemoryStats.peakBytesAllocated) / 1048576.0,
+                    double(hostMemoryStats.bytesPooled) / 1048576.0);
+
+                if (g_options.latentStreaming)
+                {
+                    LatentStreamingStats const& streamingStats = m_materialLoader->GetLatentStreamingStats();
+                    ImGui::Text("Resident Latents: %.1f / %.1f MB (%.1f MB pool), %d / %d materials at mip 0",
+                        double(streamingStats.residentLatentBytes) / 1048576.0,
+                        double(streamingStats.fullLatentBytes) / 1048576.0,
+                        double(streamingStats.poolBytes) / 1048576.0,
+                        streamingStats.materialsAtFinestMip, streamingStats.streamedMaterials);
+                    if (streamingStats.pendingReads != 0)
+                        ImGui::Text("Streaming latents: %d reads pending", streamingStats.pendingReads);
+                }
+
+                if (m_materialLoader->IsLoadingMaterials())
+                {
+                    MaterialLoadingStats const& loadingStats = m_materialLoader->GetMaterialLoadingStats();
+                    ImGui::Text("Loading Materials: %d / %d (%.1f MB uploaded)",
+                        loadingStats.materialsReady + loadingStats.materialsFailed, loadingStats.materialsTotal,
+                        double(loadingStats.latentBytesUploaded) / 1048576.0);
+
+                    if (loadingStats.materialsUploading != 0)
+                        ImGui::Text("Uploading on the copy queue: %d materials", loadingStats.materialsUploading);
+
+                    if (loadingStats.materialsTranscoding != 0)
+                    {
+                        ImGui::Text("Transcoding: %d materials, %.1f Mpix pending",
+                            loadingStats.materialsTranscoding, double(loadingStats.transcodePixelsPending) * 1e-6);
+                    }
+                }
             }
 
             ImGui::PopFont();
@@ -1217,8 +2448,18 @@ public:
                     m_feedbackCameraCutFrames = g_feedbackCameraCutFramesInit;
                 }
                 ImGui::EndDisabled();
+                ImGui::SameLine();
+                ImGui::BeginDisabled(!IsHybridModeAvailable());
+                if (ImGui::RadioButton("Hybrid", m_ntcMode == NtcMode::Hybrid))
+                {
+                    m_ntcMode = NtcMode::Hybrid;
+                    m_hybridFramesSinceUpdate = g_hybridUpdateInterval; // Select the modes on the next frame
+                }
+                ImGui::EndDisabled();
 
                 // Ensure we have selected an enabled mode
+                if (m_ntcMode == NtcMode::Hybrid && !IsHybridModeAvailable())
+                    m_ntcMode = NtcMode::InferenceOnSample;
                 if (m_ntcMode == NtcMode::InferenceOnFeedback && !g_options.inferenceOnFeedback)
                     m_ntcMode = NtcMode::InferenceOnSample;
                 if (m_ntcMode == NtcMode::InferenceOnSample && !g_options.inferenceOnSample)
@@ -1251,6 +2492,20 @@ public:
 
             ImGui::Checkbox("Depth Pre-pass", &m_useDepthPrepass);
 
+            if (m_ntcMode == NtcMode::InferenceOnSample || m_ntcMode == NtcMode::Hybrid)
+            {
+                ImGui::BeginDisabled(!m_ntcForwardShadingPass->IsBindlessMaterialsSupported());
+                ImGui::Checkbox("Bindless Materials", &m_useBindlessMaterials);
+                ImGui::EndDisabled();
+                ImGui::Checkbox("Quad-Shared Inference", &m_useQuadSharedInference);
+                ImGui::BeginDisabled(!m_deferredShadingPass);
+                ImGui::Checkbox("Deferred Shading", &m_useDeferredShading);
+                ImGui::EndDisabled();
+                ImGui::BeginDisabled(!m_deferredShadingPass || !m_useDeferredShading);
+                ImGui::Checkbox("Temporal Material Cache", &m_useMaterialCache);
+                ImGui::EndDisabled();
+            }
+
             ImGui::TextUnformatted("Anti-aliasing:");
             if (ImGui::RadioButton("Off", m_aaMode == AntiAliasingMode::Off))
             {
@@ -1287,11 +2542,32 @@ public:
                 ImGui::Text("Tiles Standby: %d (%.0f MB)", stats.tilesStandby, double(uint64_t(stats.tilesStandby) * tileSizeInBytes) / megabyte);
                 double tilesHeapAllocatedMb = double(stats.heapAllocationInBytes) / megabyte;
                 ImGui::Text("Heap Allocation: %.0f MB", tilesHeapAllocatedMb);
+                if (stats.heapBudgetInBytes)
+                    ImGui::Text("Heap Budget: %.0f MB", double(stats.heapBudgetInBytes) / megabyte);
+                else
+                    ImGui::TextUnformatted("Heap Budget: unlimited");
+                ImGui::Text("Feedback Textures Processed: %u / %u", stats.texturesProcessed, stats.texturesReadBack);
                 double ntcMemoryMb = double(m_ntcTextureMemorySize) / megabyte;
                 ImGui::Text("NTC Memory: %.0f MB", ntcMemoryMb);
                 double plusNtcMemory = tilesHeapAllocatedMb + ntcMemoryMb;
                 ImGui::Text("Net Memory Savings: %.2fx (%.0f MB)", tilesTotalMb / plusNtcMemory, tilesTotalMb - plusNtcMemory);
                 ImGui::Checkbox("Enable Stochastic Feedback", &m_enableStochasticFeedback);
+                ImGui::Checkbox("Enable Prefetch", &m_enableFeedbackPrefetch);
+                uint32_t const prefetchesResolved = stats.prefetchHits + stats.prefetchMisses;
+                ImGui::Text("Prefetch: %u textures, %.0f%% hit rate", stats.prefetchRequests,
+                    prefetchesResolved ? 100.0 * double(stats.prefetchHits) / double(prefetchesResolved) : 0.0);
+                if (g_options.feedbackTileCache > 0)
+                {
+                    FeedbackTileCacheStats const cacheStats = m_materialLoader->GetFeedbackTileCacheStats();
+                    uint64_t const cacheHits = cacheStats.memoryHits + cacheStats.diskHits;
+                    uint64_t const cacheLookups = cacheHits + cacheStats.misses;
+                    ImGui::Text("Tile Cache: %u tiles (%.0f MB), %.0f%% hit rate", cacheStats.tilesInMemory,
+                        double(cacheStats.memoryBytes) / megabyte,
+                        cacheLookups ? 100.0 * double(cacheHits) / double(cacheLookups) : 0.0);
+                    if (g_options.feedbackTileCacheDir)
+                        ImGui::Text("Tile Cache Disk: %u tiles, %llu hits", cacheStats.tilesOnDisk,
+                            (unsigned long long)cacheStats.diskHits);
+                }
             }
 
             ImGui::Separator();
@@ -1304,6 +2580,21 @@ public:
             }
             ImGui::SameLine();
             ImGui::Checkbox("Include UI", &m_screenshotWithUI);
+
+            if (m_traceRecorder && ImGui::Button("Save Trace"))
+                m_traceRecorder->WriteChromeTrace(g_options.traceFile);
+
+            if (g_options.cameraPath && !g_options.benchmarkOutput)
+            {
+                if (ImGui::Button("Save Camera Keyframe"))
+                {
+                    CameraPath::Keyframe keyframe;
+                    keyframe.position = m_view.GetViewOrigin();
+                    keyframe.direction = m_view.GetViewDirection();
+                    keyframe.up = m_view.GetInverseViewMatrix().m_linear.row1;
+                    CameraPath::AppendKeyframe(g_options.cameraPath, keyframe);
+                }
+            }
         }
         ImGui::End();
         
@@ -1355,6 +2646,8 @@ int main(int __argc, const char** __argv)
     deviceParams.enableNvrhiValidationLayer = g_options.debug;
     deviceParams.enablePerMonitorDPI = true;
     deviceParams.supportExplicitDisplayScaling = true;
+    // Copy queue uploads are only used on DX12, see IsCopyQueueUploadSupported
+    deviceParams.enableCopyQueue = g_options.copyQueueUploads && graphicsApi == nvrhi::GraphicsAPI::D3D12;
 
     SetNtcGraphicsDeviceParameters(deviceParams, graphicsApi, false, g_ApplicationName);
 #if DONUT_WITH_DLSS && NTC_WITH_VULKAN
@@ -1375,6 +2668,7 @@ int main(int __argc, const char** __argv)
         nvrhi::utils::GraphicsAPIToString(graphicsApi), deviceManager->GetRendererString());
     deviceManager->SetWindowTitle(windowTitle);
 
+    int exitCode = 0;
     {
         NtcSceneRenderer example(deviceManager.get());
         if (example.Init())
@@ -1382,10 +2676,13 @@ int main(int __argc, const char** __argv)
             deviceManager->AddRenderPassToBack(&example);
             deviceManager->RunMessageLoop();
             deviceManager->RemoveRenderPass(&example);
+            exitCode = example.GetExitCode();
         }
+        else if (g_options.benchmarkOutput)
+            exitCode = 1;
     }
 
     deviceManager->Shutdown();
 
-    return 0;
+    return exitCode;
 }
@@ -0,0 +1,84 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+
+// Encoding of the thin G-buffer used by the deferred NTC shading path:
+//   GBuffer0 (RGBA32_UINT): asuint(uv.x), asuint(uv.y), half2 ddx(uv), half2 ddy(uv)
+//   GBuffer1 (RGBA32_UINT): octahedral normal, octahedral tangent, flags and material index, 0
+// World position is reconstructed from depth.
+
+#ifndef NTC_THIN_GBUFFER_HLSLI
+#define NTC_THIN_GBUFFER_HLSLI
+
+#include "donut/shaders/packing.hlsli"
+#include "NtcForwardShadingPassConstants.h"
+
+struct ThinGBufferSurface
+{
+    float2 texCoord;
+    float2 texCoordDx;
+    float2 texCoordDy;
+    float3 normal;
+    float4 tangent;
+    bool isFrontFace;
+    uint materialIndex;
+};
+
+uint PackHalf2(float2 value)
+{
+    return f32tof16(value.x) | (f32tof16(value.y) << 16);
+}
+
+float2 UnpackHalf2(uint value)
+{
+    return f16tof32(uint2(value, value >> 16));
+}
+
+void EncodeThinGBuffer(ThinGBufferSurface surface, out uint4 gbuffer0, out uint4 gbuffer1)
+{
+    gbuffer0.xy = asuint(surface.texCoord);
+    gbuffer0.z = PackHalf2(surface.texCoordDx);
+    gbuffer0.w = PackHalf2(surface.texCoordDy);
+
+    gbuffer1.x = ndirToOctUnorm32(normalize(surface.normal));
+    gbuffer1.y = ndirToOctUnorm32(normalize(surface.tangent.xyz));
+    gbuffer1.z = (surface.materialIndex + 1) & NTC_GBUFFER_MATERIAL_MASK;
+    if (surface.isFrontFace)
+        gbuffer1.z |= NTC_GBUFFER_FRONT_FACE;
+    if (surface.tangent.w < 0)
+        gbuffer1.z |= NTC_GBUFFER_TANGENT_FLIP;
+    gbuffer1.w = 0;
+}
+
+// Returns false if the pixel has no surface for the deferred pass
+bool DecodeThinGBufferMaterial(uint4 gbuffer1, out uint materialIndex)
+{
+    uint const encodedMaterial = gbuffer1.z & NTC_GBUFFER_MATERIAL_MASK;
+    materialIndex = encodedMaterial - 1;
+    return encodedMaterial != 0;
+}
+
+ThinGBufferSurface DecodeThinGBuffer(uint4 gbuffer0, uint4 gbuffer1)
+{
+    ThinGBufferSurface surface;
+    surface.texCoord = asfloat(gbuffer0.xy);
+    surface.texCoordDx = UnpackHalf2(gbuffer0.z);
+    surface.texCoordDy = UnpackHalf2(gbuffer0.w);
+    surface.normal = octToNdirUnorm32(gbuffer1.x);
+    surface.tangent.xyz = octToNdirUnorm32(gbuffer1.y);
+    surface.tangent.w = (gbuffer1.z & NTC_GBUFFER_TANGENT_FLIP) ? -1.0 : 1.0;
+    surface.isFrontFace = (gbuffer1.z & NTC_GBUFFER_FRONT_FACE) != 0;
+    DecodeThinGBufferMaterial(gbuffer1, surface.materialIndex);
+    return surface;
+}
+
+#endif // NTC_THIN_GBUFFER_HLSLI
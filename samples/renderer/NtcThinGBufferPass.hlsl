@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+
+// Writes the surface attributes of opaque NTC materials into the thin G-buffer, see NtcThinGBuffer.hlsli.
+// No inference happens here, the deferred shading pass runs it once per visible pixel.
+
+#include "donut/shaders/forward_cb.h"
+#include "donut/shaders/forward_vertex.hlsli"
+#include "donut/shaders/binding_helpers.hlsli"
+#include "NtcThinGBuffer.hlsli"
+
+DECLARE_PUSH_CONSTANTS(NtcForwardPushConstants, g_NtcPush, FORWARD_BINDING_PUSH_CONSTANTS, FORWARD_SPACE_INPUT);
+
+[earlydepthstencil]
+void main(
+    in float4 i_position : SV_Position,
+    in SceneVertex i_vtx,
+    in bool i_isFrontFace : SV_IsFrontFace,
+    out uint4 o_gbuffer0 : SV_Target0,
+    out uint4 o_gbuffer1 : SV_Target1
+)
+{
+    ThinGBufferSurface surface;
+    surface.texCoord = i_vtx.texCoord;
+    surface.texCoordDx = ddx(i_vtx.texCoord);
+    surface.texCoordDy = ddy(i_vtx.texCoord);
+    surface.normal = i_vtx.normal;
+    surface.tangent = i_vtx.tangent;
+    surface.isFrontFace = i_isFrontFace;
+    surface.materialIndex = g_NtcPush.materialIndex;
+
+    EncodeThinGBuffer(surface, o_gbuffer0, o_gbuffer1);
+}
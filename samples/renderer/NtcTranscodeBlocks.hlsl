@@ -0,0 +1,258 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Decompresses regions of NTC textures and encodes them into BC1, BC4 or BC5 blocks in the same dispatch.
+// Every layer of groups processes one job from g_Batch, the dispatch covers the largest region of the batch.
+// Every thread runs inference for one texel and stores the channels of the texture in shared memory, then
+// one thread per 4x4 block fits the endpoints to the block's range and writes the block into the output.
+// The endpoint fit is simpler than the one in LibNTC's block compression passes, which are still used for
+// BC6H and BC7, for the textures that this shader doesn't support, and for all textures unless the loader
+// enables the fused encoding, see NtcMaterialLoader::SetFusedBlockEncoding(...).
+
+#include "donut/shaders/binding_helpers.hlsli"
+
+#include "libntc/shaders/InferenceConstants.h"
+#include "libntc/shaders/Inference.hlsli"
+typedef NtcNetworkParams<NETWORK_VERSION> NtcParams;
+
+#include "NtcForwardShadingPassConstants.h"
+
+DECLARE_CBUFFER(NtcMaterialConstants, g_NtcMaterialConstants, TRANSCODE_BINDING_NTC_MATERIAL_CONSTANTS, 0);
+DECLARE_PUSH_CONSTANTS(NtcTranscodePushConstants, g_Push, TRANSCODE_BINDING_PUSH_CONSTANTS, 0);
+DECLARE_CBUFFER(NtcTranscodeBatchConstants, g_Batch, TRANSCODE_BINDING_JOB_CONSTANTS, 0);
+#define g_NtcMaterial g_NtcMaterialConstants.textureSet
+
+ByteAddressBuffer t_InputFile    : REGISTER_SRV(TRANSCODE_BINDING_NTC_LATENTS_BUFFER, 0);
+ByteAddressBuffer t_WeightBuffer : REGISTER_SRV(TRANSCODE_BINDING_NTC_WEIGHTS_BUFFER, 0);
+
+// The block textures of all formats are in one descriptor table, in the space TRANSCODE_SPACE_BLOCKS_OUTPUT.
+// The jobs of a dispatch only select the textures of its format.
+#if ENCODE_FORMAT == TRANSCODE_FORMAT_BC5
+VK_BINDING(0, 1) RWTexture2D<uint4> u_Blocks[] : register(u0, space1);
+#else
+VK_BINDING(0, 1) RWTexture2D<uint2> u_Blocks[] : register(u0, space1);
+#endif
+
+groupshared float3 s_Texels[TRANSCODE_GROUP_SIZE][TRANSCODE_GROUP_SIZE];
+
+// Selects a channel with a uniform index without dynamic indexing of the channel array,
+// which would place the array in local memory.
+float GetChannel(float channels[NtcParams::OUTPUT_CHANNELS], uint index)
+{
+    float result = 0;
+    [unroll]
+    for (uint channel = 0; channel < NtcParams::OUTPUT_CHANNELS; ++channel)
+    {
+        if (channel == index)
+            result = channels[channel];
+    }
+    return result;
+}
+
+// Writes a group of index bits into a 64-bit block stored as two uints
+void SetBlockBits(inout uint2 block, uint position, uint value)
+{
+    if (position < 32)
+    {
+        block.x |= value << position;
+        if (position > 29)
+            block.y |= value >> (32 - position);
+    }
+    else
+        block.y |= value << (position - 32);
+}
+
+// BC4 block with the 8-value interpolation mode between the block's minimum and maximum
+uint2 EncodeBC4(uint2 blockOrigin, uint component)
+{
+    float minValue = 1;
+    float maxValue = 0;
+    [unroll]
+    for (uint texel = 0; texel < 16; ++texel)
+    {
+        float const value = saturate(s_Texels[blockOrigin.y + texel / 4][blockOrigin.x + texel % 4][component]);
+        minValue = min(minValue, value);
+        maxValue = max(maxValue, value);
+    }
+
+    uint const endpoint0 = uint(round(maxValue * 255));
+    uint const endpoint1 = uint(round(minValue * 255));
+
+    uint2 block = uint2(endpoint0 | (endpoint1 << 8), 0);
+    if (endpoint0 == endpoint1)
+        return block;
+
+    float const scale = 7.0 / float(endpoint0 - endpoint1);
+    [unroll]
+    for (uint texel = 0; texel < 16; ++texel)
+    {
+        float const value = saturate(s_Texels[blockOrigin.y + texel / 4][blockOrigin.x + texel % 4][component]);
+
+        // Position between endpoint1 (0) and endpoint0 (7), and the index of the palette entry at that position
+        uint const step = uint(clamp(round((value * 255 - float(endpoint1)) * scale), 0, 7));
+        uint const index = (step == 7) ? 0 : (step == 0) ? 1 : 8 - step;
+        SetBlockBits(block, 16 + texel * 3, index);
+    }
+
+    return block;
+}
+
+static const float3 c_BC1QuantScale = float3(31, 63, 31);
+
+// Opaque BC1 block with the 4-color mode between two quantized colors, also returns the squared error of the block
+uint2 EncodeBC1Endpoints(uint2 blockOrigin, uint3 color0565, uint3 color1565, out float error)
+{
+    uint endpoint0 = (color0565.r << 11) | (color0565.g << 5) | color0565.b;
+    uint endpoint1 = (color1565.r << 11) | (color1565.g << 5) | color1565.b;
+
+    // The 4-color mode requires endpoint0 > endpoint1, swap the colors otherwise
+    if (endpoint0 < endpoint1)
+    {
+        uint const endpoint = endpoint0;
+        endpoint0 = endpoint1;
+        endpoint1 = endpoint;
+        uint3 const color565 = color0565;
+        color0565 = color1565;
+        color1565 = color565;
+    }
+
+    uint2 block = uint2(endpoint0 | (endpoint1 << 16), 0);
+
+    float3 const color0 = float3(color0565) / c_BC1QuantScale;
+    float3 const color1 = float3(color1565) / c_BC1QuantScale;
+    float3 const axis = color0 - color1;
+
+    // Equal endpoints select the 3-color mode, where index 1 still decodes to endpoint1
+    float const scale = (endpoint0 == endpoint1) ? 0 : 3.0 / dot(axis, axis);
+
+    error = 0;
+    [unroll]
+    for (uint texel = 0; texel < 16; ++texel)
+    {
+        float3 const color = saturate(s_Texels[blockOrigin.y + texel / 4][blockOrigin.x + texel % 4]);
+
+        // Position between color1 (0) and color0 (3), and the index of the palette entry at that position
+        uint const step = uint(clamp(round(dot(color - color1, axis) * scale), 0, 3));
+        uint const index = (step == 3) ? 0 : (step == 0) ? 1 : 4 - step;
+        block.y |= index << (texel * 2);
+
+        float3 const difference = lerp(color1, color0, float(step) / 3) - color;
+        error += dot(difference, difference);
+    }
+
+    return block;
+}
+
+// Opaque BC1 block with the 4-color mode, endpoints at two opposite corners of the block's color bounding box.
+// The colors of a block are often anti-correlated in some channels, so all four diagonals of the box are tried,
+// and the one with the smallest error is used.
+uint2 EncodeBC1(uint2 blockOrigin)
+{
+    float3 minColor = 1;
+    float3 maxColor = 0;
+    [unroll]
+    for (uint texel = 0; texel < 16; ++texel)
+    {
+        float3 const color = saturate(s_Texels[blockOrigin.y + texel / 4][blockOrigin.x + texel % 4]);
+        minColor = min(minColor, color);
+        maxColor = max(maxColor, color);
+    }
+
+    uint3 const max565 = uint3(round(maxColor * c_BC1QuantScale));
+    uint3 const min565 = uint3(round(minColor * c_BC1QuantScale));
+
+    float bestError;
+    uint2 bestBlock = EncodeBC1Endpoints(blockOrigin, max565, min565, bestError);
+
+    [unroll]
+    for (uint diagonal = 1; diagonal < 4; ++diagonal)
+    {
+        // Bit 0 reverses the green range, bit 1 reverses the blue range. Reversing an empty range
+        // gives the same endpoints as one of the previous diagonals.
+        bool const reverseGreen = (diagonal & 1) != 0;
+        bool const reverseBlue = (diagonal & 2) != 0;
+        if ((reverseGreen && max565.g == min565.g) || (reverseBlue && max565.b == min565.b))
+            continue;
+
+        uint3 const color0565 = uint3(max565.r, reverseGreen ? min565.g : max565.g, reverseBlue ? min565.b : max565.b);
+        uint3 const color1565 = uint3(min565.r, reverseGreen ? max565.g : min565.g, reverseBlue ? max565.b : min565.b);
+
+        float error;
+        uint2 const block = EncodeBC1Endpoints(blockOrigin, color0565, color1565, error);
+        if (error < bestError)
+        {
+            bestBlock = block;
+            bestError = error;
+        }
+    }
+
+    return bestBlock;
+}
+
+[numthreads(TRANSCODE_GROUP_SIZE, TRANSCODE_GROUP_SIZE, 1)]
+void main(uint3 groupIndex : SV_GroupID, uint2 threadIndex : SV_GroupThreadID)
+{
+    // The whole group exits when it's outside of its job's region, before the group barrier
+    NtcTranscodeJobConstants const job = g_Batch.jobs[groupIndex.z];
+    if (any(int2(groupIndex.xy * TRANSCODE_GROUP_SIZE) >= job.srcSize))
+        return;
+
+    // Decompress one texel per thread, the texels of the edge blocks that are outside of the region
+    // repeat the last row or column of the region.
+    int2 const localTexel = min(int2(groupIndex.xy * TRANSCODE_GROUP_SIZE + threadIndex), job.srcSize - 1);
+    int2 const texel = job.srcOrigin + localTexel;
+
+    // Convert all channels to linear space, same as the decompression pass does for linear output textures
+    const bool linearizeColorsOnSample = true;
+
+    float channels[NtcParams::OUTPUT_CHANNELS];
+#ifdef USE_COOPVEC
+    #if USE_FP8
+        NtcSampleTextureSet_CoopVec_FP8<NETWORK_VERSION>(g_NtcMaterial, t_InputFile, 0,
+            t_WeightBuffer, 0, texel, g_Push.mipLevel, linearizeColorsOnSample, channels);
+    #else
+        NtcSampleTextureSet_CoopVec_Int8<NETWORK_VERSION>(g_NtcMaterial, t_InputFile, 0,
+            t_WeightBuffer, 0, texel, g_Push.mipLevel, linearizeColorsOnSample, channels);
+    #endif
+#else
+    NtcSampleTextureSet<NETWORK_VERSION>(g_NtcMaterial, t_InputFile, 0,
+        t_WeightBuffer, 0, texel, g_Push.mipLevel, linearizeColorsOnSample, channels);
+#endif
+
+    s_Texels[threadIndex.y][threadIndex.x] = float3(
+        GetChannel(channels, job.firstChannel + 0),
+        GetChannel(channels, job.firstChannel + 1),
+        GetChannel(channels, job.firstChannel + 2));
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Encode the 2x2 blocks of the group in the first 4 threads
+    uint const blockInGroupIndex = threadIndex.y * TRANSCODE_GROUP_SIZE + threadIndex.x;
+    if (blockInGroupIndex >= 4)
+        return;
+
+    uint2 const blockInGroup = uint2(blockInGroupIndex & 1, blockInGroupIndex >> 1);
+    uint2 const localBlock = groupIndex.xy * (TRANSCODE_GROUP_SIZE / 4) + blockInGroup;
+    int2 const blockCount = (job.srcSize + 3) / 4;
+    if (any(localBlock >= uint2(blockCount)))
+        return;
+
+    uint2 const blockOrigin = blockInGroup * 4;
+    uint2 const dstBlock = job.dstBlockOrigin + localBlock;
+#if ENCODE_FORMAT == TRANSCODE_FORMAT_BC1
+    u_Blocks[job.outputIndex][dstBlock] = EncodeBC1(blockOrigin);
+#elif ENCODE_FORMAT == TRANSCODE_FORMAT_BC4
+    u_Blocks[job.outputIndex][dstBlock] = EncodeBC4(blockOrigin, 0);
+#else
+    u_Blocks[job.outputIndex][dstBlock] = uint4(EncodeBC4(blockOrigin, 0), EncodeBC4(blockOrigin, 1));
+#endif
+}
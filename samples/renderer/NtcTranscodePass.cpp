@@ -0,0 +1,242 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "NtcTranscodePass.h"
+#include "NtcMaterial.h"
+#include <donut/core/log.h>
+#include <donut/engine/ShaderFactory.h>
+#include <algorithm>
+#include <cassert>
+
+#if NTC_WITH_DX12
+    #include "compiled_shaders/NtcTranscodeBlocks.dxil.h"
+    #include "compiled_shaders/NtcTranscodeBlocks_CoopVec.dxil.h"
+#endif
+
+#if NTC_WITH_VULKAN
+    #include "compiled_shaders/NtcTranscodeBlocks.spirv.h"
+    #include "compiled_shaders/NtcTranscodeBlocks_CoopVec.spirv.h"
+#endif
+
+using namespace donut::math;
+#include "NtcForwardShadingPassConstants.h"
+
+using namespace donut;
+
+static_assert(TRANSCODE_GROUP_SIZE % 4 == 0, "The transcoding groups must consist of whole blocks");
+
+bool NtcTranscodePass::Init()
+{
+    auto layoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .addItem(nvrhi::BindingLayoutItem::ConstantBuffer(TRANSCODE_BINDING_NTC_MATERIAL_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::PushConstants(TRANSCODE_BINDING_PUSH_CONSTANTS, sizeof(NtcTranscodePushConstants)))
+        .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(TRANSCODE_BINDING_JOB_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(TRANSCODE_BINDING_NTC_LATENTS_BUFFER))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(TRANSCODE_BINDING_NTC_WEIGHTS_BUFFER));
+
+    m_bindingLayout = m_device->createBindingLayout(layoutDesc);
+    if (!m_bindingLayout)
+        return false;
+
+    auto bindlessLayoutDesc = nvrhi::BindlessLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .setMaxCapacity(m_descriptorTableSize)
+        .addRegisterSpace(nvrhi::BindingLayoutItem::Texture_UAV(TRANSCODE_SPACE_BLOCKS_OUTPUT));
+
+    m_bindlessLayout = m_device->createBindlessLayout(bindlessLayoutDesc);
+    if (!m_bindlessLayout)
+        return false;
+
+    m_descriptorTable = m_device->createDescriptorTable(m_bindlessLayout);
+    if (!m_descriptorTable)
+        return false;
+
+    m_device->resizeDescriptorTable(m_descriptorTable, m_descriptorTableSize, false);
+
+    // A few versions allow several batches per command list without waiting on Vulkan
+    auto constantBufferDesc = nvrhi::BufferDesc()
+        .setByteSize(sizeof(NtcTranscodeBatchConstants))
+        .setDebugName("TranscodeBatchConstants")
+        .setIsConstantBuffer(true)
+        .setIsVolatile(true)
+        .setMaxVersions(64);
+
+    m_jobConstantBuffer = m_device->createBuffer(constantBufferDesc);
+
+    return m_jobConstantBuffer != nullptr;
+}
+
+void NtcTranscodePass::WriteDescriptor(nvrhi::BindingSetItem item)
+{
+    m_device->writeDescriptorTable(m_descriptorTable, item);
+}
+
+bool NtcTranscodePass::IsTextureSupported(NtcMaterial const& material, TextureTranscodeTask const& transcodeTask)
+{
+    if (transcodeTask.sRGB || material.networkVersion == NTC_NETWORK_UNKNOWN)
+        return false;
+
+    if (ntc::InferenceWeightType(material.weightType) == ntc::InferenceWeightType::GenericFP8)
+        return false;
+
+    switch (transcodeTask.bcFormat)
+    {
+        case ntc::BlockCompressedFormat::BC1:
+            return transcodeTask.numChannels == 3;
+        case ntc::BlockCompressedFormat::BC4:
+            return transcodeTask.numChannels == 1;
+        case ntc::BlockCompressedFormat::BC5:
+            return transcodeTask.numChannels == 2;
+        default:
+            return false;
+    }
+}
+
+nvrhi::ComputePipelineHandle NtcTranscodePass::GetOrCreatePipeline(PipelineKey const& key)
+{
+    auto it = m_pipelines.find(key);
+    if (it != m_pipelines.end())
+        return it->second;
+
+    // Same shader selection as in NtcForwardShadingPass::GetOrCreatePixelShader
+    ntc::InferenceWeightType weightType = ntc::InferenceWeightType(key.weightType);
+    bool const useCoopVec = weightType == ntc::InferenceWeightType::CoopVecInt8 ||
+                            weightType == ntc::InferenceWeightType::CoopVecFP8;
+
+    char const* encodeFormat = "TRANSCODE_FORMAT_BC1";
+    if (key.format == ntc::BlockCompressedFormat::BC4)
+        encodeFormat = "TRANSCODE_FORMAT_BC4";
+    else if (key.format == ntc::BlockCompressedFormat::BC5)
+        encodeFormat = "TRANSCODE_FORMAT_BC5";
+
+    std::vector<engine::ShaderMacro> defines;
+    defines.push_back({ "NETWORK_VERSION", ntc::NetworkVersionToString(key.networkVersion) });
+    defines.push_back({ "ENCODE_FORMAT", encodeFormat });
+    if (useCoopVec)
+        defines.push_back({ "USE_FP8", weightType == ntc::InferenceWeightType::CoopVecFP8 ? "1" : "0"});
+
+    nvrhi::ShaderHandle shader;
+    if (useCoopVec)
+    {
+        shader = m_shaderFactory->CreateStaticPlatformShader(
+            DONUT_MAKE_PLATFORM_SHADER(g_NtcTranscodeBlocks_CoopVec), &defines, nvrhi::ShaderType::Compute);
+    }
+    else
+    {
+        shader = m_shaderFactory->CreateStaticPlatformShader(
+            DONUT_MAKE_PLATFORM_SHADER(g_NtcTranscodeBlocks), &defines, nvrhi::ShaderType::Compute);
+    }
+
+    nvrhi::ComputePipelineHandle pipeline;
+    if (shader)
+    {
+        auto pipelineDesc = nvrhi::ComputePipelineDesc()
+            .setComputeShader(shader)
+            .addBindingLayout(m_bindingLayout)
+            .addBindingLayout(m_bindlessLayout);
+
+        pipeline = m_device->createComputePipeline(pipelineDesc);
+    }
+
+    // Store the failures too, so that the shader is not created again for every region
+    m_pipelines[key] = pipeline;
+    return pipeline;
+}
+
+bool NtcTranscodePass::ExecuteBatch(nvrhi::ICommandList* commandList, NtcMaterial const& material, int mipLevel,
+    std::vector<NtcTranscodeJob> const& jobs)
+{
+    if (jobs.empty())
+        return true;
+
+    // Every format is a different shader, the jobs of the same format are dispatched together
+    std::vector<NtcTranscodeJob const*> sortedJobs;
+    sortedJobs.reserve(jobs.size());
+    for (NtcTranscodeJob const& job : jobs)
+    {
+        assert(IsTextureSupported(material, *job.transcodeTask));
+        sortedJobs.push_back(&job);
+    }
+    std::stable_sort(sortedJobs.begin(), sortedJobs.end(), [](NtcTranscodeJob const* a, NtcTranscodeJob const* b)
+    {
+        return a->transcodeTask->bcFormat < b->transcodeTask->bcFormat;
+    });
+
+    auto bindingSetDesc = nvrhi::BindingSetDesc()
+        .addItem(nvrhi::BindingSetItem::ConstantBuffer(TRANSCODE_BINDING_NTC_MATERIAL_CONSTANTS, material.ntcConstantBuffer))
+        .addItem(nvrhi::BindingSetItem::PushConstants(TRANSCODE_BINDING_PUSH_CONSTANTS, sizeof(NtcTranscodePushConstants)))
+        .addItem(nvrhi::BindingSetItem::ConstantBuffer(TRANSCODE_BINDING_JOB_CONSTANTS, m_jobConstantBuffer))
+        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(TRANSCODE_BINDING_NTC_LATENTS_BUFFER, material.ntcLatentsBuffer, material.ntcLatentsRange))
+        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(TRANSCODE_BINDING_NTC_WEIGHTS_BUFFER, material.ntcWeightsBuffer, material.ntcWeightsRange));
+
+    nvrhi::BindingSetHandle bindingSet = m_bindingCache.GetOrCreateBindingSet(bindingSetDesc, m_bindingLayout);
+    if (!bindingSet)
+        return false;
+
+    NtcTranscodePushConstants pushConstants {};
+    pushConstants.mipLevel = mipLevel;
+
+    NtcTranscodeBatchConstants batchConstants {};
+    for (size_t firstJob = 0; firstJob < sortedJobs.size(); )
+    {
+        ntc::BlockCompressedFormat const format = sortedJobs[firstJob]->transcodeTask->bcFormat;
+
+        PipelineKey key;
+        key.networkVersion = material.networkVersion;
+        key.weightType = material.weightType;
+        key.format = format;
+
+        nvrhi::ComputePipelineHandle pipeline = GetOrCreatePipeline(key);
+        if (!pipeline)
+        {
+            log::warning("Failed to create the transcoding pipeline for material '%s'.", material.name.c_str());
+            return false;
+        }
+
+        // Fill the job constants until the format changes or the array is full
+        uint32_t jobCount = 0;
+        int maxWidth = 0;
+        int maxHeight = 0;
+        for (; firstJob + jobCount < sortedJobs.size() && jobCount < TRANSCODE_MAX_BATCH_JOBS; ++jobCount)
+        {
+            NtcTranscodeJob const& job = *sortedJobs[firstJob + jobCount];
+            if (job.transcodeTask->bcFormat != format)
+                break;
+
+            NtcTranscodeJobConstants& jobConstants = batchConstants.jobs[jobCount];
+            jobConstants.srcOrigin = int2(job.srcRect.left, job.srcRect.top);
+            jobConstants.srcSize = int2(job.srcRect.width, job.srcRect.height);
+            jobConstants.dstBlockOrigin = uint2(job.dstBlockX, job.dstBlockY);
+            jobConstants.firstChannel = job.transcodeTask->firstChannel;
+            jobConstants.outputIndex = job.outputDescriptorIndex;
+            maxWidth = std::max(maxWidth, job.srcRect.width);
+            maxHeight = std::max(maxHeight, job.srcRect.height);
+        }
+        firstJob += jobCount;
+
+        commandList->writeBuffer(m_jobConstantBuffer, &batchConstants, sizeof(batchConstants));
+
+        nvrhi::ComputeState state;
+        state.pipeline = pipeline;
+        state.bindings = { bindingSet, m_descriptorTable };
+        commandList->setComputeState(state);
+        commandList->setPushConstants(&pushConstants, sizeof(pushConstants));
+
+        commandList->dispatch(
+            (maxWidth + TRANSCODE_GROUP_SIZE - 1) / TRANSCODE_GROUP_SIZE,
+            (maxHeight + TRANSCODE_GROUP_SIZE - 1) / TRANSCODE_GROUP_SIZE,
+            jobCount);
+    }
+
+    return true;
+}
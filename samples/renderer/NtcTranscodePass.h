@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <libntc/ntc.h>
+#include <donut/engine/BindingCache.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace donut::engine
+{
+    class ShaderFactory;
+}
+
+struct NtcMaterial;
+struct TextureTranscodeTask;
+
+// One region of a material texture to transcode, see NtcTranscodePass::ExecuteBatch(...)
+struct NtcTranscodeJob
+{
+    TextureTranscodeTask const* transcodeTask = nullptr;
+    ntc::Rect srcRect;
+    int dstBlockX = 0;
+    int dstBlockY = 0;
+    uint32_t outputDescriptorIndex = 0; // Block texture in the descriptor table, see WriteDescriptor(...)
+};
+
+// Transcodes the linear BC1, BC4 and BC5 textures of NTC materials. The shader decompresses the texels and encodes
+// the blocks directly into the block staging textures, so these textures skip the staging color texture and the
+// separate block compression pass. The other textures, such as BC6H, BC7 and sRGB ones, still go through
+// GraphicsDecompressionPass and GraphicsBlockCompressionPass.
+// The block textures are accessed through a descriptor table, and the regions are described by an array of
+// per-job constants indexed by the group Z coordinate, so all regions with the same format share one dispatch.
+class NtcTranscodePass
+{
+private:
+    struct PipelineKey
+    {
+        int networkVersion = 0;
+        int weightType = 0;
+        ntc::BlockCompressedFormat format = ntc::BlockCompressedFormat::None;
+
+        bool operator==(PipelineKey const& other) const
+        {
+            return networkVersion == other.networkVersion && weightType == other.weightType
+                && format == other.format;
+        }
+    };
+
+    struct PipelineKeyHash
+    {
+        size_t operator()(PipelineKey const& s) const
+        {
+            size_t hash = 0;
+            nvrhi::hash_combine(hash, s.networkVersion);
+            nvrhi::hash_combine(hash, s.weightType);
+            nvrhi::hash_combine(hash, int(s.format));
+            return hash;
+        }
+    };
+
+    nvrhi::DeviceHandle m_device;
+    std::shared_ptr<donut::engine::ShaderFactory> m_shaderFactory;
+    nvrhi::BindingLayoutHandle m_bindingLayout;
+    nvrhi::BindingLayoutHandle m_bindlessLayout;
+    nvrhi::DescriptorTableHandle m_descriptorTable;
+    nvrhi::BufferHandle m_jobConstantBuffer;
+    donut::engine::BindingCache m_bindingCache;
+    int m_descriptorTableSize;
+    std::unordered_map<PipelineKey, nvrhi::ComputePipelineHandle, PipelineKeyHash> m_pipelines;
+
+    nvrhi::ComputePipelineHandle GetOrCreatePipeline(PipelineKey const& key);
+
+public:
+    NtcTranscodePass(nvrhi::IDevice* device, std::shared_ptr<donut::engine::ShaderFactory> shaderFactory,
+        int descriptorTableSize)
+        : m_device(device)
+        , m_shaderFactory(shaderFactory)
+        , m_bindingCache(device)
+        , m_descriptorTableSize(descriptorTableSize)
+    { }
+
+    bool Init();
+
+    // Writes a block texture UAV into the descriptor table, the item's slot is the descriptor index
+    void WriteDescriptor(nvrhi::BindingSetItem item);
+
+    // Returns true if the texture of the material can be transcoded by this pass. The shader only produces
+    // linear colors, and it doesn't support the generic FP8 weights, same as the shading passes.
+    static bool IsTextureSupported(NtcMaterial const& material, TextureTranscodeTask const& transcodeTask);
+
+    // For every job, decompresses the texels of 'srcRect' in the material's mip level and writes the blocks into
+    // the job's output texture, which is a RG32_UINT (BC1, BC4) or RGBA32_UINT (BC5) UAV, starting at the block
+    // 'dstBlockX, dstBlockY'. Records one dispatch per format and TRANSCODE_MAX_BATCH_JOBS jobs. The textures
+    // must be in the UAV state, and the jobs must not overlap because there are no UAV barriers between them.
+    // Returns false if the pipeline cannot be created.
+    bool ExecuteBatch(nvrhi::ICommandList* commandList, NtcMaterial const& material, int mipLevel,
+        std::vector<NtcTranscodeJob> const& jobs);
+
+    void ClearBindingSetCache() { m_bindingCache.Clear(); }
+};
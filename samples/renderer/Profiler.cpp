@@ -11,8 +11,11 @@
  */
 
 #include "Profiler.h"
+#include <donut/core/log.h>
 #include <imgui.h>
 #include <implot.h>
+#include <algorithm>
+#include <cstdio>
 
 void AveragingTimerQuery::beginQuery(nvrhi::ICommandList* commandList)
 {
@@ -47,7 +50,10 @@ void AveragingTimerQuery::update()
         if (m_device->pollTimerQuery(query))
         {
             float time = m_device->getTimerQueryTime(query);
-            m_history.push_back(time);
+            if (m_staleQueries > 0)
+                --m_staleQueries;
+            else
+                m_history.push_back(time);
             m_activeQueries.pop();
             m_idleQueries.push(query);
         }
@@ -82,6 +88,7 @@ void AveragingTimerQuery::setUpdateInterval(float seconds)
 void AveragingTimerQuery::clearHistory()
 {
     m_history.clear();
+    m_staleQueries = m_activeQueries.size();
     m_lastUpdateTime = std::chrono::steady_clock::now();
 }
 
@@ -272,3 +279,221 @@ void Profiler::BuildUI(bool enableFeedbackStats)
         ImPlot::EndPlot();
     }
 }
+
+double TraceRecorder::GetTime() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+TraceRecorder::ThreadState& TraceRecorder::GetThreadState()
+{
+    auto [it, inserted] = m_threads.try_emplace(std::this_thread::get_id());
+    if (inserted)
+    {
+        if (m_freeThreadIndices.empty())
+            it->second.index = m_threadCount++;
+        else
+        {
+            it->second.index = m_freeThreadIndices.back();
+            m_freeThreadIndices.pop_back();
+        }
+    }
+    return it->second;
+}
+
+void TraceRecorder::BeginFrame()
+{
+    {
+        std::lock_guard lockGuard(m_mutex);
+        m_currentFrame = Frame();
+        m_currentFrame.index = m_frameIndex++;
+        m_currentFrame.cpuBegin = GetTime();
+    }
+
+    BeginScope("Frame");
+}
+
+void TraceRecorder::EndFrame()
+{
+    EndScope();
+
+    std::lock_guard lockGuard(m_mutex);
+
+    m_pendingFrames.push_back(std::move(m_currentFrame));
+    m_currentFrame = Frame();
+
+    // Frames complete in order, stop at the first one that still has queries in flight
+    while (!m_pendingFrames.empty())
+    {
+        Frame& frame = m_pendingFrames.front();
+        bool const available = std::all_of(frame.scopes.begin(), frame.scopes.end(), [this](Scope const& scope)
+            { return !scope.query || m_device->pollTimerQuery(scope.query); });
+
+        if (!available)
+            break;
+
+        ResolveFrame(frame);
+        m_completedFrames.push_back(std::move(frame));
+        m_pendingFrames.pop_front();
+    }
+
+    while (m_completedFrames.size() > m_maxFrames)
+        m_completedFrames.pop_front();
+}
+
+void TraceRecorder::BeginScope(char const* name, nvrhi::ICommandList* commandList)
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    ThreadState& thread = GetThreadState();
+
+    Scope& scope = m_currentFrame.scopes.emplace_back();
+    scope.name = name;
+    scope.threadIndex = thread.index;
+    scope.cpuBegin = GetTime();
+
+    if (commandList)
+    {
+        if (m_idleQueries.empty())
+            scope.query = m_device->createTimerQuery();
+        else
+        {
+            scope.query = m_idleQueries.front();
+            m_idleQueries.pop();
+        }
+
+        scope.commandList = commandList;
+        scope.gpuDepth = thread.openGpuScopes++;
+        commandList->beginTimerQuery(scope.query);
+    }
+
+    thread.openScopes.push_back(m_currentFrame.scopes.size() - 1);
+}
+
+void TraceRecorder::EndScope()
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    ThreadState& thread = GetThreadState();
+    assert(!thread.openScopes.empty());
+    if (thread.openScopes.empty())
+        return;
+
+    Scope& scope = m_currentFrame.scopes[thread.openScopes.back()];
+    thread.openScopes.pop_back();
+
+    scope.cpuEnd = GetTime();
+    if (scope.query)
+    {
+        scope.commandList->endTimerQuery(scope.query);
+        scope.commandList = nullptr;
+        --thread.openGpuScopes;
+    }
+
+    if (thread.openScopes.empty() && thread.index != 0)
+    {
+        m_freeThreadIndices.push_back(thread.index);
+        m_threads.erase(std::this_thread::get_id());
+    }
+}
+
+void TraceRecorder::ResolveFrame(Frame& frame)
+{
+    // Place the GPU scopes of every thread back to back: top-level scopes follow each other,
+    // and nested scopes start where their parent starts.
+    std::vector<std::vector<double>> cursors; // [threadIndex][gpuDepth]
+
+    for (Scope& scope : frame.scopes)
+    {
+        if (!scope.query)
+            continue;
+
+        scope.gpuDuration = m_device->getTimerQueryTime(scope.query);
+        m_idleQueries.push(scope.query);
+        scope.query = nullptr;
+
+        if (scope.threadIndex >= cursors.size())
+            cursors.resize(scope.threadIndex + 1);
+        if (scope.threadIndex >= m_gpuTrackEnd.size())
+            m_gpuTrackEnd.resize(scope.threadIndex + 1, 0.0);
+
+        std::vector<double>& cursor = cursors[scope.threadIndex];
+        if (cursor.empty())
+            cursor.push_back(std::max(frame.cpuBegin, m_gpuTrackEnd[scope.threadIndex]));
+        if (scope.gpuDepth >= cursor.size())
+            cursor.resize(scope.gpuDepth + 1, cursor.back());
+
+        scope.gpuBegin = cursor[scope.gpuDepth];
+        cursor[scope.gpuDepth] += scope.gpuDuration;
+        cursor.resize(scope.gpuDepth + 2);
+        cursor[scope.gpuDepth + 1] = scope.gpuBegin;
+
+        if (scope.gpuDepth == 0)
+            m_gpuTrackEnd[scope.threadIndex] = cursor[0];
+    }
+}
+
+bool TraceRecorder::WriteChromeTrace(std::string const& fileName)
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    FILE* file = fopen(fileName.c_str(), "w");
+    if (!file)
+    {
+        donut::log::error("Cannot open the trace file '%s' for writing.", fileName.c_str());
+        return false;
+    }
+
+    // Chrome trace timestamps are in microseconds. CPU threads use their own index as the tid,
+    // and the GPU scopes recorded by each thread go onto a separate track.
+    constexpr double secondsToUs = 1e6;
+    constexpr uint32_t gpuTrackOffset = 1000;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    auto separator = [&first]() { char const* s = first ? "" : ",\n"; first = false; return s; };
+
+    for (uint32_t threadIndex = 0; threadIndex < m_threadCount; ++threadIndex)
+    {
+        char threadName[64];
+        if (threadIndex == 0)
+            snprintf(threadName, sizeof threadName, "Render Thread");
+        else
+            snprintf(threadName, sizeof threadName, "Worker Thread %u", threadIndex);
+
+        fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+            separator(), threadIndex, threadName);
+        fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"GPU (%s)\"}}",
+            separator(), threadIndex + gpuTrackOffset, threadName);
+    }
+
+    for (Frame const& frame : m_completedFrames)
+    {
+        for (Scope const& scope : frame.scopes)
+        {
+            fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"frame\":%llu}}",
+                separator(), scope.threadIndex, scope.name, scope.cpuBegin * secondsToUs,
+                (scope.cpuEnd - scope.cpuBegin) * secondsToUs, (unsigned long long)frame.index);
+
+            if (scope.gpuDuration > 0)
+            {
+                fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"frame\":%llu}}",
+                    separator(), scope.threadIndex + gpuTrackOffset, scope.name, scope.gpuBegin * secondsToUs,
+                    scope.gpuDuration * secondsToUs, (unsigned long long)frame.index);
+            }
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    bool const success = !ferror(file);
+    fclose(file);
+
+    if (success)
+        donut::log::info("Saved %d frames of trace data to '%s'.", int(m_completedFrames.size()), fileName.c_str());
+    else
+        donut::log::error("Failed to write the trace file '%s'.", fileName.c_str());
+
+    return success;
+}
@@ -14,8 +14,13 @@
 
 #include <nvrhi/nvrhi.h>
 #include <chrono>
+#include <deque>
+#include <mutex>
 #include <optional>
 #include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 // The AveragingTimerQuery class implements a timer query that is non-blocking using a pool of
 // regular NVRHI TimerQueries, and that accumulates the timing results over a set time interval.
@@ -26,6 +31,7 @@ private:
     std::queue<nvrhi::TimerQueryHandle> m_idleQueries;
     std::queue<nvrhi::TimerQueryHandle> m_activeQueries;
     nvrhi::TimerQueryHandle m_openQuery;
+    size_t m_staleQueries = 0; // Number of the oldest active queries whose results are dropped
 
     std::vector<float> m_history;
     float m_updateIntervalSeconds = 0.5f;
@@ -50,7 +56,8 @@ public:
     // Sets the time interval between updating average time values.
     void setUpdateInterval(float seconds);
 
-    // Clears the history, such as when changing rendering algorithms.
+    // Clears the history, such as when changing rendering algorithms. The results of the queries that are
+    // still in flight are dropped as well.
     void clearHistory();
 
     // Returns the latest directly measured time, if any.
@@ -103,4 +110,117 @@ private:
     SmoothAxisLimit m_timePlotLimit;
     SmoothAxisLimit m_tilesPlotLimit;
     double m_profilerHistoryDuration = 2.0;
+};
+
+// The TraceRecorder class records nested CPU scopes and, when a command list is provided, GPU scopes
+// for every frame, and exports the last frames as a Chrome trace JSON file that can be opened in
+// chrome://tracing or ui.perfetto.dev. Scopes can be recorded on any thread.
+// GPU times come from a pool of timer queries that are polled without waiting, same as AveragingTimerQuery.
+// NVRHI timer queries only measure durations, so the GPU scopes of every recording thread are placed
+// back to back in their recording order, starting when the frame began on the CPU or when the previous
+// frame's GPU scopes ended. Idle time between the passes is therefore not visible in the trace.
+class TraceRecorder
+{
+public:
+    TraceRecorder(nvrhi::IDevice* device, size_t maxFrames)
+        : m_device(device)
+        , m_maxFrames(maxFrames)
+    { }
+
+    // Opens the implicit "Frame" scope on the calling thread.
+    void BeginFrame();
+
+    // Closes the "Frame" scope, and polls the timer queries of the previous frames.
+    void EndFrame();
+
+    // The name must be a string literal or otherwise outlive the recorder.
+    void BeginScope(char const* name, nvrhi::ICommandList* commandList = nullptr);
+
+    // Closes the last scope opened on the calling thread, with the command list passed to BeginScope.
+    void EndScope();
+
+    // Writes all completed frames into a file. Frames with GPU queries still in flight are not included.
+    bool WriteChromeTrace(std::string const& fileName);
+
+private:
+    struct Scope
+    {
+        char const* name = nullptr;
+        uint32_t threadIndex = 0;
+        uint32_t gpuDepth = 0;
+        double cpuBegin = 0;
+        double cpuEnd = 0;
+        nvrhi::ICommandList* commandList = nullptr;
+        nvrhi::TimerQueryHandle query;
+        double gpuBegin = 0;
+        double gpuDuration = 0;
+    };
+
+    struct Frame
+    {
+        uint64_t index = 0;
+        double cpuBegin = 0;
+        std::vector<Scope> scopes;
+    };
+
+    struct ThreadState
+    {
+        uint32_t index = 0;
+        std::vector<size_t> openScopes; // Indices into m_currentFrame.scopes
+        uint32_t openGpuScopes = 0;
+    };
+
+    nvrhi::DeviceHandle m_device;
+    size_t m_maxFrames;
+    std::mutex m_mutex;
+    std::chrono::steady_clock::time_point m_startTime = std::chrono::steady_clock::now();
+    // Threads without open scopes are forgotten, except the first one, and their index is given to the next new
+    // thread. This keeps the number of tracks small when the workers are short-lived, e.g. with std::async.
+    std::unordered_map<std::thread::id, ThreadState> m_threads;
+    std::vector<uint32_t> m_freeThreadIndices;
+    uint32_t m_threadCount = 0;
+    std::queue<nvrhi::TimerQueryHandle> m_idleQueries;
+    Frame m_currentFrame;
+    uint64_t m_frameIndex = 0;
+    std::deque<Frame> m_pendingFrames; // Waiting for the GPU queries
+    std::deque<Frame> m_completedFrames;
+    std::vector<double> m_gpuTrackEnd; // Per thread index
+
+    double GetTime() const;
+    ThreadState& GetThreadState();
+    void ResolveFrame(Frame& frame);
+};
+
+// Null-safe wrappers for code where tracing is optional.
+inline void BeginTraceScope(TraceRecorder* recorder, char const* name, nvrhi::ICommandList* commandList = nullptr)
+{
+    if (recorder)
+        recorder->BeginScope(name, commandList);
+}
+
+inline void EndTraceScope(TraceRecorder* recorder)
+{
+    if (recorder)
+        recorder->EndScope();
+}
+
+class TraceScope
+{
+public:
+    TraceScope(TraceRecorder* recorder, char const* name, nvrhi::ICommandList* commandList = nullptr)
+        : m_recorder(recorder)
+    {
+        BeginTraceScope(m_recorder, name, commandList);
+    }
+
+    ~TraceScope()
+    {
+        EndTraceScope(m_recorder);
+    }
+
+    TraceScope(TraceScope const&) = delete;
+    TraceScope& operator=(TraceScope const&) = delete;
+
+private:
+    TraceRecorder* m_recorder;
 };
\ No newline at end of file
@@ -24,7 +24,10 @@ struct RenderTargets
     nvrhi::TextureHandle feedback1;
     nvrhi::TextureHandle feedback2;
     nvrhi::TextureHandle motionVectors;
+    nvrhi::TextureHandle gbuffer0; // See NtcThinGBuffer.hlsli
+    nvrhi::TextureHandle gbuffer1;
 
     std::shared_ptr<donut::engine::FramebufferFactory> depthFramebufferFactory;
     std::shared_ptr<donut::engine::FramebufferFactory> framebufferFactory;
+    std::shared_ptr<donut::engine::FramebufferFactory> gbufferFramebufferFactory;
 };
@@ -52,6 +52,10 @@ namespace nvfeedback
         virtual bool IsTilePacked(uint32_t tileIndex) = 0;
         virtual void GetTileInfo(uint32_t tileIndex, std::vector<FeedbackTextureTileInfo>& tiles) = 0;
 
+        // Returns the subresources of the packed MIP tail, empty if the texture has no packed mips.
+        // The packed tiles are mapped when the texture is created and stay mapped for its lifetime.
+        virtual void GetPackedTileInfo(std::vector<FeedbackTextureTileInfo>& tiles) = 0;
+
         virtual uint32_t GetNumTextureSets() const = 0;
         virtual FeedbackTextureSet* GetTextureSet(uint32_t index) const = 0;
     };
@@ -81,6 +85,14 @@ namespace nvfeedback
         uint32_t tilesTotal;            // Total number of tiles tracked in all textures
         uint32_t tilesAllocated;        // Number of tiles allocated in heaps
         uint32_t tilesStandby;          // Number of tiles in the standby queue
+        uint64_t heapBudgetInBytes;     // Effective heap budget on the last frame, 0 if unlimited
+        uint64_t bufferMemoryInBytes;   // Size of the feedback resolve, batching and readback buffers
+        uint32_t texturesReadBack;      // Number of textures whose feedback was read back on the last frame
+        uint32_t texturesProcessed;     // Number of textures whose feedback was processed on the CPU on the last frame
+
+        uint32_t prefetchRequests;      // Total number of textures requested through PrefetchTexture
+        uint32_t prefetchHits;          // Prefetched textures that were sampled before the request timed out
+        uint32_t prefetchMisses;        // Prefetched textures that were not sampled before the request timed out
 
         double cputimeBeginFrame;
         double cputimeUpdateTileMappings;
@@ -95,7 +107,9 @@ namespace nvfeedback
         bool defragmentHeaps; // Enable defragmentation of heaps
         bool trimStandbyTiles; // Enables trimming of standby tiles to the target number
         bool releaseEmptyHeaps; // Release empty heaps
-        uint32_t numExtraStandbyTiles; // Target number of tiles to keep in standby before being evicted
+        uint32_t numExtraStandbyTiles; // Target number of tiles to keep in standby before being evicted, ignored when there is a heap budget
+        uint64_t heapBudgetInBytes; // Hard limit for the heap allocation, 0=unlimited
+        bool useVideoMemoryBudget; // Also limit the heap allocation to the part of the OS video memory budget not used by other resources
     };
 
     struct FeedbackTextureUpdate
@@ -113,6 +127,7 @@ namespace nvfeedback
     {
         uint32_t numFramesInFlight; // Number of frames in flight, affects the latency of readback
         uint32_t heapSizeInTiles; // The size of each heap in tiles
+        nvrhi::IShader* feedbackReduceShader; // Optional compute shader from FeedbackReduce.hlsl that enables batched readback
     };
 
     // FeedbackManager interfaces between application code using NVRHI and the RTXTS library
@@ -130,6 +145,11 @@ namespace nvfeedback
         // Call at the beginning of the frame. Reads back the feedback resources from N frames ago.
         virtual void BeginFrame(nvrhi::ICommandList* commandList, const FeedbackUpdateConfig& config, FeedbackTextureCollection* results) = 0;
 
+        // Requests the tiles of a texture at mipLevel and all coarser mips as if the whole texture was sampled at that level,
+        // without waiting for the sampler feedback. The request is processed in the next BeginFrame,
+        // and the tiles are returned together with the tiles requested by the feedback.
+        virtual void PrefetchTexture(FeedbackTexture* texture, uint32_t mipLevel) = 0;
+
         // Call for tiles which ready to have their data filled on this frame's GPU timeline
         virtual void UpdateTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesReady) = 0;
 
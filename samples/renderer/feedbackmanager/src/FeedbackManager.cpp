@@ -32,7 +32,54 @@ namespace nvfeedback
 
         rtxts::TiledTextureManagerDesc tiledTextureManagerDesc = {};
         tiledTextureManagerDesc.heapTilesCapacity = desc.heapSizeInTiles;
+        // The packed tiles are requested when a texture is added and never unmapped, see MapPackedTiles(...)
+        tiledTextureManagerDesc.alwaysMapPackedTiles = true;
         m_tiledTextureManager = std::shared_ptr<rtxts::TiledTextureManager>(CreateTiledTextureManager(tiledTextureManagerDesc));
+
+        if (desc.feedbackReduceShader)
+        {
+            nvrhi::BindingLayoutDesc layoutDesc;
+            layoutDesc.visibility = nvrhi::ShaderType::Compute;
+            layoutDesc.bindings = {
+                nvrhi::BindingLayoutItem::PushConstants(0, sizeof(uint32_t)),
+                nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0),
+                nvrhi::BindingLayoutItem::RawBuffer_SRV(1),
+                nvrhi::BindingLayoutItem::RawBuffer_UAV(0)
+            };
+            m_reduceBindingLayout = m_device->createBindingLayout(layoutDesc);
+
+            nvrhi::ComputePipelineDesc pipelineDesc;
+            pipelineDesc.CS = desc.feedbackReduceShader;
+            pipelineDesc.bindingLayouts = { m_reduceBindingLayout };
+            m_reducePipeline = m_device->createComputePipeline(pipelineDesc);
+
+            m_batchedReadbacks.resize(m_numFramesInFlight);
+        }
+
+        // Find the DXGI adapter for the device to query the video memory budget
+        ID3D12Device* d3dDevice = m_device->getNativeObject(nvrhi::ObjectTypes::D3D12_Device);
+        ComPtr<IDXGIFactory4> dxgiFactory;
+        if (d3dDevice && SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&dxgiFactory))))
+            dxgiFactory->EnumAdapterByLuid(d3dDevice->GetAdapterLuid(), IID_PPV_ARGS(&m_dxgiAdapter));
+    }
+
+    uint64_t FeedbackManagerImpl::GetVideoMemoryBudgetForHeaps()
+    {
+        if (!m_dxgiAdapter)
+            return 0;
+
+        DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+        if (FAILED(m_dxgiAdapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo)))
+            return 0;
+
+        // The heaps may use what's left of the budget after all other resources, minus some headroom for
+        // allocations made by the application between the updates
+        uint64_t const headroom = memoryInfo.Budget / 16;
+        uint64_t const heapBytes = m_heapAllocator->GetTotalAllocatedBytes();
+        uint64_t const otherUsage = memoryInfo.CurrentUsage > heapBytes ? memoryInfo.CurrentUsage - heapBytes : 0;
+        if (memoryInfo.Budget <= otherUsage + headroom)
+            return 1; // Non-zero to keep the budget enforced
+        return memoryInfo.Budget - otherUsage - headroom;
     }
 
     FeedbackManagerImpl::~FeedbackManagerImpl()
@@ -41,13 +88,40 @@ namespace nvfeedback
 
     bool FeedbackManagerImpl::CreateTexture(const nvrhi::TextureDesc& desc, FeedbackTexture** ppTex)
     {
-        FeedbackTextureImpl* feedbackTexture = new FeedbackTextureImpl(desc, this, m_tiledTextureManager.get(), m_device, m_numFramesInFlight);
+        FeedbackTextureImpl* feedbackTexture = new FeedbackTextureImpl(desc, this, m_tiledTextureManager.get(), m_device, m_numFramesInFlight, m_reducePipeline != nullptr);
         m_textures.push_back(feedbackTexture);
         m_texturesRingbuffer.push_back(feedbackTexture);
+        MapPackedTiles(feedbackTexture);
         *ppTex = feedbackTexture;
         return true;
     }
 
+    void FeedbackManagerImpl::MapPackedTiles(FeedbackTextureImpl* texture)
+    {
+        if (texture->GetPackedMipInfo().numPackedMips == 0)
+            return;
+
+        // The packed tiles don't count against the heap budget, the texture cannot be sampled without them
+        uint32_t const numRequiredHeaps = m_tiledTextureManager->GetNumDesiredHeaps();
+        while (m_heapAllocator->GetNumHeaps() < numRequiredHeaps)
+        {
+            uint32_t heapId;
+            m_heapAllocator->AllocateHeap(heapId);
+            m_tiledTextureManager->AddHeap(heapId);
+        }
+
+        // This also allocates the tiles requested by the feedback of other textures,
+        // those are returned by the next BeginFrame as usual
+        m_tiledTextureManager->AllocateRequestedTiles();
+
+        std::vector<uint32_t> tilesToMap;
+        m_tiledTextureManager->GetTilesToMap(texture->GetTiledTextureId(), tilesToMap);
+        tilesToMap.erase(std::remove_if(tilesToMap.begin(), tilesToMap.end(),
+            [texture](uint32_t tileIndex) { return !texture->IsTilePacked(tileIndex); }), tilesToMap.end());
+
+        MapTiles(texture, tilesToMap);
+    }
+
     bool FeedbackManagerImpl::CreateTextureSet(FeedbackTextureSet** ppTexSet)
     {
         if (!ppTexSet)
@@ -77,6 +151,25 @@ namespace nvfeedback
         auto it = std::find(m_minMipDirtyTextures.begin(), m_minMipDirtyTextures.end(), feedbackTexture);
         if (it != m_minMipDirtyTextures.end())
             m_minMipDirtyTextures.erase(it);
+
+        m_pendingPrefetches.erase(feedbackTexture);
+        m_activePrefetches.erase(feedbackTexture);
+        m_texturesWithRequests.erase(feedbackTexture);
+
+        for (auto& batch : m_batchedReadbacks)
+            std::replace(batch.textures.begin(), batch.textures.end(), feedbackTexture, (FeedbackTextureImpl*)nullptr);
+    }
+
+    void FeedbackManagerImpl::PrefetchTexture(FeedbackTexture* texture, uint32_t mipLevel)
+    {
+        FeedbackTextureImpl* textureImpl = static_cast<FeedbackTextureImpl*>(texture);
+
+        // Keep the finest mip if the texture is prefetched several times before the next BeginFrame
+        auto it = m_pendingPrefetches.find(textureImpl);
+        if (it == m_pendingPrefetches.end())
+            m_pendingPrefetches[textureImpl] = mipLevel;
+        else
+            it->second = std::min(it->second, mipLevel);
     }
 
     void FeedbackManagerImpl::UpdateTextureRingBufferState(FeedbackTextureImpl* pTex, bool includeInRingBuffer)
@@ -92,6 +185,112 @@ namespace nvfeedback
         }
     }
 
+    void FeedbackManagerImpl::ProcessTextureFeedback(FeedbackTextureImpl* texture, const uint8_t* pFeedbackData, uint64_t feedbackSize, float timeStamp)
+    {
+        ++m_texturesProcessed;
+
+        // A prefetch is a hit if the texture was sampled at all before the request timed out.
+        // Unsampled regions are decoded as 0xFF.
+        auto activePrefetch = m_activePrefetches.find(texture);
+        if (activePrefetch != m_activePrefetches.end())
+        {
+            if (std::any_of(pFeedbackData, pFeedbackData + feedbackSize, [](uint8_t minMip) { return minMip != 0xFF; }))
+            {
+                ++m_prefetchHits;
+                m_activePrefetches.erase(activePrefetch);
+            }
+        }
+
+        rtxts::SamplerFeedbackDesc samplerFeedbackDesc = {};
+        samplerFeedbackDesc.pMinMipData = (uint8_t*)(pFeedbackData);
+        m_tiledTextureManager->UpdateWithSamplerFeedback(texture->GetTiledTextureId(), samplerFeedbackDesc, timeStamp, m_updateConfigThisFrame.tileTimeoutSeconds);
+
+        // If this is a primary texture, make followers match its state
+        if (texture->IsPrimaryTexture())
+        {
+            auto textureSets = texture->GetPrimaryTextureSets();
+            for (auto textureSet : textureSets)
+            {
+                uint32_t numTextures = textureSet->GetNumTextures();
+                uint32_t primaryTextureIndex = textureSet->GetPrimaryTextureIndex();
+                for (uint32_t iTextureSet = 0; iTextureSet < numTextures; ++iTextureSet)
+                {
+                    if (iTextureSet == primaryTextureIndex)
+                        continue;
+
+                    // Make the follower texture match the primary texture requested tile state
+                    FeedbackTexture* follower = textureSet->GetTexture(iTextureSet);
+                    FeedbackTextureImpl* followerImpl = static_cast<FeedbackTextureImpl*>(follower);
+                    m_tiledTextureManager->MatchPrimaryTexture(
+                        texture->GetTiledTextureId(),
+                        followerImpl->GetTiledTextureId(),
+                        timeStamp,
+                        m_updateConfigThisFrame.tileTimeoutSeconds);
+                }
+            }
+        }
+    }
+
+    void FeedbackManagerImpl::ProcessBatchedReadback(float timeStamp)
+    {
+        auto& batch = m_batchedReadbacks[m_frameIndex];
+        if (batch.textures.empty())
+            return;
+
+        uint32_t const batchTexturesNum = uint32_t(batch.textures.size());
+        std::vector<bool> processedTextures(batchTexturesNum, false);
+
+        // Only the textures listed by the reduction shader have any sampled regions
+        uint32_t const* pRequestList = (uint32_t const*)m_device->mapBuffer(batch.requestListReadback, nvrhi::CpuAccessMode::Read);
+        uint8_t const* pFeedbackData = (uint8_t const*)m_device->mapBuffer(batch.feedbackDataReadback, nvrhi::CpuAccessMode::Read);
+
+        uint32_t const requestsNum = std::min(pRequestList[0], batchTexturesNum);
+        for (uint32_t iRequest = 0; iRequest < requestsNum; ++iRequest)
+        {
+            uint32_t const textureIndex = pRequestList[1 + iRequest];
+            if (textureIndex >= batchTexturesNum || !batch.textures[textureIndex])
+                continue;
+
+            FeedbackTextureImpl* texture = batch.textures[textureIndex];
+            ProcessTextureFeedback(texture, pFeedbackData + batch.textureOffsets[textureIndex],
+                texture->GetFeedbackResolveBuffer(0)->getDesc().byteSize, timeStamp);
+
+            processedTextures[textureIndex] = true;
+            m_texturesWithRequests[texture] = timeStamp;
+        }
+
+        m_device->unmapBuffer(batch.requestListReadback);
+        m_device->unmapBuffer(batch.feedbackDataReadback);
+
+        // Textures that were sampled recently but not on this frame still need empty updates so that their tiles
+        // can time out. Once all their tiles are past the timeout, they're skipped until sampled again.
+        for (uint32_t textureIndex = 0; textureIndex < batchTexturesNum; ++textureIndex)
+        {
+            FeedbackTextureImpl* texture = batch.textures[textureIndex];
+            if (!texture || processedTextures[textureIndex])
+                continue;
+
+            auto textureWithRequests = m_texturesWithRequests.find(texture);
+            if (textureWithRequests == m_texturesWithRequests.end())
+                continue;
+
+            if (timeStamp - textureWithRequests->second > 2.f * m_updateConfigThisFrame.tileTimeoutSeconds)
+            {
+                m_texturesWithRequests.erase(textureWithRequests);
+                continue;
+            }
+
+            size_t const feedbackSize = size_t(texture->GetFeedbackResolveBuffer(0)->getDesc().byteSize);
+            if (m_emptyFeedback.size() < feedbackSize)
+                m_emptyFeedback.resize(feedbackSize, 0xFF);
+
+            ProcessTextureFeedback(texture, m_emptyFeedback.data(), feedbackSize, timeStamp);
+        }
+
+        // This slot is written again by the next ResolveFeedback, if it has any textures to read back
+        batch.textures.clear();
+    }
+
     void FeedbackManagerImpl::BeginFrame(nvrhi::ICommandList* commandList, const FeedbackUpdateConfig& config, FeedbackTextureCollection* results)
     {
         m_timerBeginFrame.Begin();
@@ -100,50 +299,91 @@ namespace nvfeedback
 
         m_updateConfigThisFrame = config;
 
+        // Derive the heap budget for this frame
+        m_heapBudgetInBytes = config.heapBudgetInBytes;
+        if (config.useVideoMemoryBudget)
+        {
+            uint64_t const videoMemoryBudget = GetVideoMemoryBudgetForHeaps();
+            if (videoMemoryBudget != 0)
+                m_heapBudgetInBytes = m_heapBudgetInBytes ? std::min(m_heapBudgetInBytes, videoMemoryBudget) : videoMemoryBudget;
+        }
+
         rtxts::TiledTextureManagerConfig tiledTextureManagerConfig = {};
         tiledTextureManagerConfig.numExtraStandbyTiles = config.numExtraStandbyTiles;
+        if (m_heapBudgetInBytes != 0)
+        {
+            // With a budget, the standby pool takes all the budget that the tiles in use leave free.
+            // When the budget is exceeded, the least recently used standby tiles are evicted and empty heaps released.
+            rtxts::Statistics const statistics = m_tiledTextureManager->GetStatistics();
+            uint64_t const budgetTiles = m_heapBudgetInBytes / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+            uint64_t const tilesInUse = statistics.allocatedTilesNum - statistics.standbyTilesNum;
+            tiledTextureManagerConfig.numExtraStandbyTiles = uint32_t(budgetTiles > tilesInUse ? budgetTiles - tilesInUse : 0);
+
+            if (statistics.allocatedTilesNum > budgetTiles)
+            {
+                m_updateConfigThisFrame.trimStandbyTiles = true;
+                m_updateConfigThisFrame.releaseEmptyHeaps = true;
+            }
+        }
         m_tiledTextureManager->SetConfig(tiledTextureManagerConfig);
 
         auto& readbackTextures = m_texturesToReadback[m_frameIndex];
-        if (!readbackTextures.empty())
+        m_texturesReadBack = uint32_t(readbackTextures.size());
+        m_texturesProcessed = 0;
+        if (m_reducePipeline)
+        {
+            ProcessBatchedReadback(float(GetTickCount64()) / 1000.0f);
+        }
+        else if (!readbackTextures.empty())
         {
             float timeStamp = float(GetTickCount64()) / 1000.0f;
             uint32_t texturesNum = uint32_t(readbackTextures.size());
             for (uint32_t iReadbackTexture = 0; iReadbackTexture < texturesNum; ++iReadbackTexture)
             {
                 FeedbackTextureImpl* readbackTexture = readbackTextures[iReadbackTexture];
-                uint8_t* pReadbackData = (uint8_t*)m_device->mapBuffer(readbackTexture->GetFeedbackResolveBuffer(m_frameIndex), nvrhi::CpuAccessMode::Read);
+                nvrhi::IBuffer* resolveBuffer = readbackTexture->GetFeedbackResolveBuffer(m_frameIndex);
+                uint8_t* pReadbackData = (uint8_t*)m_device->mapBuffer(resolveBuffer, nvrhi::CpuAccessMode::Read);
+
+                ProcessTextureFeedback(readbackTexture, pReadbackData, resolveBuffer->getDesc().byteSize, timeStamp);
+
+                m_device->unmapBuffer(resolveBuffer);
+            }
+        }
+
+        // Process the prefetch requests by feeding the tiled texture manager a synthetic feedback
+        // that samples the entire texture at the requested mip level
+        if (!m_pendingPrefetches.empty() || !m_activePrefetches.empty())
+        {
+            float timeStamp = float(GetTickCount64()) / 1000.0f;
+            std::vector<uint8_t> prefetchData;
+            for (auto& [texture, mipLevel] : m_pendingPrefetches)
+            {
+                uint32_t const lastMipLevel = texture->GetReservedTexture()->getDesc().mipLevels - 1;
+                prefetchData.assign(size_t(texture->GetFeedbackResolveBuffer(0)->getDesc().byteSize), uint8_t(std::min(mipLevel, lastMipLevel)));
 
                 rtxts::SamplerFeedbackDesc samplerFeedbackDesc = {};
-                samplerFeedbackDesc.pMinMipData = (uint8_t*)(pReadbackData);
-                m_tiledTextureManager->UpdateWithSamplerFeedback(readbackTexture->GetTiledTextureId(), samplerFeedbackDesc, timeStamp, m_updateConfigThisFrame.tileTimeoutSeconds);
+                samplerFeedbackDesc.pMinMipData = prefetchData.data();
+                m_tiledTextureManager->UpdateWithSamplerFeedback(texture->GetTiledTextureId(), samplerFeedbackDesc, timeStamp, m_updateConfigThisFrame.tileTimeoutSeconds);
+
+                m_activePrefetches[texture] = timeStamp;
+                ++m_prefetchRequests;
 
-                m_device->unmapBuffer(readbackTexture->GetFeedbackResolveBuffer(m_frameIndex));
+                // The batched readback only sends the empty updates that time out the tiles to the textures
+                // with recent requests, which includes the prefetched ones even if they're never sampled
+                m_texturesWithRequests[texture] = timeStamp;
+            }
+            m_pendingPrefetches.clear();
 
-                // If this is a primary texture, make followers match its state
-                if (readbackTexture->IsPrimaryTexture())
+            // Count the prefetches that were not sampled before their tiles could be evicted as misses
+            for (auto it = m_activePrefetches.begin(); it != m_activePrefetches.end(); )
+            {
+                if (timeStamp - it->second > m_updateConfigThisFrame.tileTimeoutSeconds)
                 {
-                    auto textureSets = readbackTexture->GetPrimaryTextureSets();
-                    for (auto textureSet : textureSets)
-                    {
-                        uint32_t numTextures = textureSet->GetNumTextures();
-                        uint32_t primaryTextureIndex = textureSet->GetPrimaryTextureIndex();
-                        for (uint32_t iTextureSet = 0; iTextureSet < numTextures; ++iTextureSet)
-                        {
-                            if (iTextureSet == primaryTextureIndex)
-                                continue;
-
-                            // Make the follower texture match the primary texture requested tile state
-                            FeedbackTexture* follower = textureSet->GetTexture(iTextureSet);
-                            FeedbackTextureImpl* followerImpl = static_cast<FeedbackTextureImpl*>(follower);
-                            m_tiledTextureManager->MatchPrimaryTexture(
-                                readbackTexture->GetTiledTextureId(),
-                                followerImpl->GetTiledTextureId(),
-                                timeStamp,
-                                m_updateConfigThisFrame.tileTimeoutSeconds);
-                        }
-                    }
+                    ++m_prefetchMisses;
+                    it = m_activePrefetches.erase(it);
                 }
+                else
+                    ++it;
             }
         }
 
@@ -169,6 +409,13 @@ namespace nvfeedback
 
         // Now check how many heaps the tiled texture manager needs
         uint32_t numRequiredHeaps = m_tiledTextureManager->GetNumDesiredHeaps();
+        if (m_heapBudgetInBytes != 0)
+        {
+            // Don't grow the heaps past the budget, the tiles that don't fit stay unmapped
+            uint64_t const heapSizeInBytes = uint64_t(m_desc.heapSizeInTiles) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+            uint32_t const maxHeaps = std::max(uint32_t(m_heapBudgetInBytes / heapSizeInBytes), 1u);
+            numRequiredHeaps = std::min(numRequiredHeaps, std::max(maxHeaps, m_heapAllocator->GetNumHeaps()));
+        }
         if (numRequiredHeaps > m_heapAllocator->GetNumHeaps())
         {
             while (m_heapAllocator->GetNumHeaps() < numRequiredHeaps)
@@ -218,7 +465,10 @@ namespace nvfeedback
                 uint32_t tilesProcessedNum = 0;
                 for (auto& tileIndex : tilesToUnmap)
                 {
-                    // Process only unpacked tiles
+                    // Process only unpacked tiles, the packed ones stay mapped for the lifetime of the texture
+                    if (feedbackTexture->IsTilePacked(tileIndex))
+                        continue;
+
                     nvrhi::TiledTextureCoordinate& tiledTextureCoordinate = tiledTextureCoordinates[tilesProcessedNum];
                     tiledTextureCoordinate.mipLevel = tilesCoordinates[tileIndex].mipLevel;
                     tiledTextureCoordinate.arrayLevel = 0;
@@ -229,9 +479,13 @@ namespace nvfeedback
                     tilesProcessedNum++;
                 }
 
-                m_device->updateTextureTileMappings(feedbackTexture->GetReservedTexture(), &textureTilesMapping, 1);
+                textureTilesMapping.numTextureRegions = tilesProcessedNum;
+                if (tilesProcessedNum != 0)
+                {
+                    m_device->updateTextureTileMappings(feedbackTexture->GetReservedTexture(), &textureTilesMapping, 1);
 
-                m_minMipDirtyTextures.insert(feedbackTexture);
+                    m_minMipDirtyTextures.insert(feedbackTexture);
+                }
             }
 
             // Collect new tiles to stream in
@@ -262,68 +516,76 @@ namespace nvfeedback
         m_timerBeginFrame.End();
     }
 
-    void FeedbackManagerImpl::UpdateTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesReady)
+    void FeedbackManagerImpl::MapTiles(FeedbackTextureImpl* texture, const std::vector<uint32_t>& tileIndices)
     {
-        m_timerUpdateTileMappings.Begin();
+        if (tileIndices.empty())
+            return;
 
-        for (auto& texUpdate : tilesReady->textures)
-        {
-            FeedbackTextureImpl* texture = dynamic_cast<FeedbackTextureImpl*>(texUpdate.texture);
-            m_minMipDirtyTextures.insert(texture);
+        m_minMipDirtyTextures.insert(texture);
 
-            uint32_t tiledTextureId = texture->GetTiledTextureId();
-            m_tiledTextureManager->UpdateTilesMapping(tiledTextureId, texUpdate.tileIndices);
+        uint32_t tiledTextureId = texture->GetTiledTextureId();
+        m_tiledTextureManager->UpdateTilesMapping(tiledTextureId, tileIndices);
 
-            const auto& tilesCoordinates = m_tiledTextureManager->GetTileCoordinates(tiledTextureId);
-            const auto& tilesAllocations = m_tiledTextureManager->GetTileAllocations(tiledTextureId);
+        const auto& tilesCoordinates = m_tiledTextureManager->GetTileCoordinates(tiledTextureId);
+        const auto& tilesAllocations = m_tiledTextureManager->GetTileAllocations(tiledTextureId);
 
-            std::map<nvrhi::HeapHandle, std::vector<uint32_t>> heapTilesMapping;
-            for (auto tileIndex : texUpdate.tileIndices)
-            {
-                nvrhi::HeapHandle heap = m_heapAllocator->GetHeapHandle(tilesAllocations[tileIndex].heapId);
-                if (heapTilesMapping.find(heap) == heapTilesMapping.end())
-                    heapTilesMapping[heap] = std::vector<uint32_t>();
-                heapTilesMapping[heap].push_back(tileIndex);
-            }
+        std::map<nvrhi::HeapHandle, std::vector<uint32_t>> heapTilesMapping;
+        for (auto tileIndex : tileIndices)
+        {
+            nvrhi::HeapHandle heap = m_heapAllocator->GetHeapHandle(tilesAllocations[tileIndex].heapId);
+            if (heapTilesMapping.find(heap) == heapTilesMapping.end())
+                heapTilesMapping[heap] = std::vector<uint32_t>();
+            heapTilesMapping[heap].push_back(tileIndex);
+        }
 
-            // Now loop heaps
-            for (auto& pair : heapTilesMapping)
+        // Now loop heaps
+        for (auto& pair : heapTilesMapping)
+        {
+            nvrhi::HeapHandle heap = pair.first;
+            auto& heapTiles = pair.second;
+            uint32_t numTiles = (uint32_t)heapTiles.size();
+
+            std::vector<nvrhi::TiledTextureCoordinate> tiledTextureCoordinates;
+            std::vector<nvrhi::TiledTextureRegion> tiledTextureRegions;
+            std::vector<uint64_t> byteOffsets;
+
+            for (UINT i = 0; i < numTiles; i++)
             {
-                nvrhi::HeapHandle heap = pair.first;
-                auto& heapTiles = pair.second;
-                uint32_t numTiles = (uint32_t)heapTiles.size();
+                uint32_t tileIndex = heapTiles[i];
 
-                std::vector<nvrhi::TiledTextureCoordinate> tiledTextureCoordinates;
-                std::vector<nvrhi::TiledTextureRegion> tiledTextureRegions;
-                std::vector<uint64_t> byteOffsets;
+                nvrhi::TiledTextureCoordinate tiledTextureCoordinate = {};
+                tiledTextureCoordinate.mipLevel = tilesCoordinates[tileIndex].mipLevel;
+                tiledTextureCoordinate.x = tilesCoordinates[tileIndex].x;
+                tiledTextureCoordinate.y = tilesCoordinates[tileIndex].y;
+                tiledTextureCoordinate.z = 0;
+                tiledTextureCoordinates.push_back(tiledTextureCoordinate);
 
-                for (UINT i = 0; i < numTiles; i++)
-                {
-                    uint32_t tileIndex = heapTiles[i];
+                nvrhi::TiledTextureRegion tiledTextureRegion = {};
+                tiledTextureRegion.tilesNum = 1;
+                tiledTextureRegions.push_back(tiledTextureRegion);
 
-                    nvrhi::TiledTextureCoordinate tiledTextureCoordinate = {};
-                    tiledTextureCoordinate.mipLevel = tilesCoordinates[tileIndex].mipLevel;
-                    tiledTextureCoordinate.x = tilesCoordinates[tileIndex].x;
-                    tiledTextureCoordinate.y = tilesCoordinates[tileIndex].y;
-                    tiledTextureCoordinate.z = 0;
-                    tiledTextureCoordinates.push_back(tiledTextureCoordinate);
+                byteOffsets.push_back(tilesAllocations[tileIndex].heapTileIndex * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+            }
 
-                    nvrhi::TiledTextureRegion tiledTextureRegion = {};
-                    tiledTextureRegion.tilesNum = 1;
-                    tiledTextureRegions.push_back(tiledTextureRegion);
+            nvrhi::TextureTilesMapping textureTilesMapping = {};
+            textureTilesMapping.numTextureRegions = (uint32_t)tiledTextureCoordinates.size();
+            textureTilesMapping.tiledTextureCoordinates = tiledTextureCoordinates.data();
+            textureTilesMapping.tiledTextureRegions = tiledTextureRegions.data();
+            textureTilesMapping.byteOffsets = byteOffsets.data();
+            textureTilesMapping.heap = heap;
 
-                    byteOffsets.push_back(tilesAllocations[tileIndex].heapTileIndex * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
-                }
+            m_device->updateTextureTileMappings(texture->GetReservedTexture(), &textureTilesMapping, 1);
+        }
+    }
 
-                nvrhi::TextureTilesMapping textureTilesMapping = {};
-                textureTilesMapping.numTextureRegions = (uint32_t)tiledTextureCoordinates.size();
-                textureTilesMapping.tiledTextureCoordinates = tiledTextureCoordinates.data();
-                textureTilesMapping.tiledTextureRegions = tiledTextureRegions.data();
-                textureTilesMapping.byteOffsets = byteOffsets.data();
-                textureTilesMapping.heap = heap;
+    void FeedbackManagerImpl::UpdateTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesReady)
+    {
+        m_timerUpdateTileMappings.Begin();
 
-                m_device->updateTextureTileMappings(texture->GetReservedTexture(), &textureTilesMapping, 1);
-            }
+        for (auto& texUpdate : tilesReady->textures)
+        {
+            FeedbackTextureImpl* texture = dynamic_cast<FeedbackTextureImpl*>(texUpdate.texture);
+            MapTiles(texture, texUpdate.tileIndices);
         }
 
         if (!m_minMipDirtyTextures.empty())
@@ -407,9 +669,114 @@ namespace nvfeedback
         // Restore the automatic barriers mode
         commandList->setEnableAutomaticBarriers(true);
 
+        if (m_reducePipeline)
+            ResolveFeedbackBatched(commandList);
+
         m_timerResolve.End();
     }
 
+    void FeedbackManagerImpl::ResolveFeedbackBatched(nvrhi::ICommandList* commandList)
+    {
+        auto& readbackTextures = m_texturesToReadback[m_frameIndex];
+        auto& batch = m_batchedReadbacks[m_frameIndex];
+
+        // Pack the decoded feedback of all textures into one buffer, each texture aligned to 4 bytes for the shader
+        struct TextureRange
+        {
+            uint32_t offset;
+            uint32_t size;
+        };
+        std::vector<TextureRange> textureRanges;
+        textureRanges.reserve(readbackTextures.size());
+        batch.textures = readbackTextures;
+        batch.textureOffsets.clear();
+
+        uint64_t feedbackSize = 0;
+        for (FeedbackTextureImpl* texture : readbackTextures)
+        {
+            uint32_t const textureFeedbackSize = uint32_t(texture->GetFeedbackResolveBuffer(m_frameIndex)->getDesc().byteSize);
+            textureRanges.push_back({ uint32_t(feedbackSize), textureFeedbackSize });
+            batch.textureOffsets.push_back(uint32_t(feedbackSize));
+            feedbackSize += (textureFeedbackSize + 3) & ~3u;
+        }
+        uint32_t const texturesNum = uint32_t(readbackTextures.size());
+
+        // Grow the buffers when needed
+        if (feedbackSize > batch.feedbackCapacity || texturesNum > batch.textureCapacity)
+        {
+            batch.feedbackCapacity = std::max(feedbackSize, batch.feedbackCapacity * 2);
+            batch.textureCapacity = std::max(texturesNum, batch.textureCapacity * 2);
+
+            nvrhi::BufferDesc bufferDesc;
+            bufferDesc.byteSize = batch.feedbackCapacity;
+            bufferDesc.canHaveRawViews = true;
+            bufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = "Batched Feedback Data";
+            batch.feedbackData = m_device->createBuffer(bufferDesc);
+
+            bufferDesc.canHaveRawViews = false;
+            bufferDesc.cpuAccess = nvrhi::CpuAccessMode::Read;
+            bufferDesc.initialState = nvrhi::ResourceStates::CopyDest;
+            bufferDesc.debugName = "Batched Feedback Readback";
+            batch.feedbackDataReadback = m_device->createBuffer(bufferDesc);
+
+            bufferDesc = nvrhi::BufferDesc();
+            bufferDesc.byteSize = batch.textureCapacity * sizeof(TextureRange);
+            bufferDesc.structStride = sizeof(TextureRange);
+            bufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = "Batched Feedback Ranges";
+            batch.textureRanges = m_device->createBuffer(bufferDesc);
+
+            // The request list is the number of textures with sampled regions followed by their indices
+            bufferDesc = nvrhi::BufferDesc();
+            bufferDesc.byteSize = (batch.textureCapacity + 1) * sizeof(uint32_t);
+            bufferDesc.canHaveUAVs = true;
+            bufferDesc.canHaveRawViews = true;
+            bufferDesc.initialState = nvrhi::ResourceStates::UnorderedAccess;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = "Batched Feedback Requests";
+            batch.requestList = m_device->createBuffer(bufferDesc);
+
+            bufferDesc.canHaveUAVs = false;
+            bufferDesc.canHaveRawViews = false;
+            bufferDesc.cpuAccess = nvrhi::CpuAccessMode::Read;
+            bufferDesc.initialState = nvrhi::ResourceStates::CopyDest;
+            bufferDesc.debugName = "Batched Feedback Requests Readback";
+            batch.requestListReadback = m_device->createBuffer(bufferDesc);
+
+            nvrhi::BindingSetDesc bindingSetDesc;
+            bindingSetDesc.bindings = {
+                nvrhi::BindingSetItem::PushConstants(0, sizeof(uint32_t)),
+                nvrhi::BindingSetItem::StructuredBuffer_SRV(0, batch.textureRanges),
+                nvrhi::BindingSetItem::RawBuffer_SRV(1, batch.feedbackData),
+                nvrhi::BindingSetItem::RawBuffer_UAV(0, batch.requestList)
+            };
+            batch.bindingSet = m_device->createBindingSet(bindingSetDesc, m_reduceBindingLayout);
+        }
+
+        for (uint32_t i = 0; i < texturesNum; ++i)
+        {
+            nvrhi::IBuffer* resolveBuffer = readbackTextures[i]->GetFeedbackResolveBuffer(m_frameIndex);
+            commandList->copyBuffer(batch.feedbackData, textureRanges[i].offset, resolveBuffer, 0, textureRanges[i].size);
+        }
+
+        uint32_t const zero = 0;
+        commandList->writeBuffer(batch.textureRanges, textureRanges.data(), textureRanges.size() * sizeof(TextureRange));
+        commandList->writeBuffer(batch.requestList, &zero, sizeof(zero));
+
+        nvrhi::ComputeState state;
+        state.pipeline = m_reducePipeline;
+        state.bindings = { batch.bindingSet };
+        commandList->setComputeState(state);
+        commandList->setPushConstants(&texturesNum, sizeof(texturesNum));
+        commandList->dispatch((texturesNum + 63) / 64);
+
+        commandList->copyBuffer(batch.requestListReadback, 0, batch.requestList, 0, (texturesNum + 1) * sizeof(uint32_t));
+        commandList->copyBuffer(batch.feedbackDataReadback, 0, batch.feedbackData, 0, feedbackSize);
+    }
+
     void FeedbackManagerImpl::EndFrame()
     {
         // Cycle textures which were updated in this frame to the back of the ringbuffer
@@ -426,6 +793,28 @@ namespace nvfeedback
 
         // Save stats
         m_statsLastFrame.heapAllocationInBytes = m_heapAllocator->GetTotalAllocatedBytes();
+        m_statsLastFrame.heapBudgetInBytes = m_heapBudgetInBytes;
+
+        uint64_t bufferMemory = 0;
+        for (FeedbackTextureImpl* texture : m_textures)
+            bufferMemory += texture->GetResolveBufferBytes();
+        for (BatchedReadback const& batch : m_batchedReadbacks)
+        {
+            for (nvrhi::IBuffer* buffer : { batch.feedbackData.Get(), batch.feedbackDataReadback.Get(),
+                batch.textureRanges.Get(), batch.requestList.Get(), batch.requestListReadback.Get() })
+            {
+                if (buffer)
+                    bufferMemory += buffer->getDesc().byteSize;
+            }
+        }
+        m_statsLastFrame.bufferMemoryInBytes = bufferMemory;
+
+        m_statsLastFrame.prefetchRequests = m_prefetchRequests;
+        m_statsLastFrame.prefetchHits = m_prefetchHits;
+        m_statsLastFrame.prefetchMisses = m_prefetchMisses;
+
+        m_statsLastFrame.texturesReadBack = m_texturesReadBack;
+        m_statsLastFrame.texturesProcessed = m_texturesProcessed;
 
         m_statsLastFrame.cputimeBeginFrame = m_timerBeginFrame.GetTime();
         m_statsLastFrame.cputimeUpdateTileMappings = m_timerUpdateTileMappings.GetTime();
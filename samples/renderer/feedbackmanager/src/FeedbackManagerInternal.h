@@ -31,6 +31,7 @@
 #include "rtxts-ttm/TiledTextureManager.h"
 
 #include <d3d12.h>
+#include <dxgi1_4.h>
 #include <nvrhi/nvrhi.h>
 
 using namespace Microsoft::WRL;
@@ -118,6 +119,7 @@ namespace nvfeedback
         bool CreateTexture(const nvrhi::TextureDesc& desc, FeedbackTexture** ppTex) override;
         bool CreateTextureSet(FeedbackTextureSet** ppTexSet) override;
         void BeginFrame(nvrhi::ICommandList* commandList, const FeedbackUpdateConfig& config, FeedbackTextureCollection* results) override;
+        void PrefetchTexture(FeedbackTexture* texture, uint32_t mipLevel) override;
         void UpdateTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesReady) override;
         void ResolveFeedback(nvrhi::ICommandList* commandList) override;
         void EndFrame() override;
@@ -130,6 +132,21 @@ namespace nvfeedback
 
         void UpdateTextureRingBufferState(FeedbackTextureImpl* pTex, bool includeInRingBuffer);
 
+        // Returns the number of bytes the heaps may use according to the video memory budget, or 0 if not available
+        uint64_t GetVideoMemoryBudgetForHeaps();
+
+        // Passes the feedback of one texture to the tiled texture manager and updates the followers in its texture sets
+        void ProcessTextureFeedback(FeedbackTextureImpl* texture, const uint8_t* pFeedbackData, uint64_t feedbackSize, float timeStamp);
+
+        void ProcessBatchedReadback(float timeStamp);
+
+        // Maps the packed MIP tail of a new texture right away, so that it can be filled before the first feedback
+        void MapPackedTiles(FeedbackTextureImpl* texture);
+
+        // Maps the tiles that the tiled texture manager has allocated for the texture to its heap locations
+        void MapTiles(FeedbackTextureImpl* texture, const std::vector<uint32_t>& tileIndices);
+        void ResolveFeedbackBatched(nvrhi::ICommandList* commandList);
+
         rtxts::TiledTextureManager* GetTiledTextureManager() { return m_tiledTextureManager.get(); }
 
     private:
@@ -154,5 +171,38 @@ namespace nvfeedback
         std::shared_ptr<HeapAllocator> m_heapAllocator;
         std::shared_ptr<rtxts::TiledTextureManager> m_tiledTextureManager;
         std::set<FeedbackTextureImpl*> m_minMipDirtyTextures;
+
+        ComPtr<IDXGIAdapter3> m_dxgiAdapter;
+
+        // Batched readback: the feedback of all resolved textures is copied into one buffer, and a compute shader
+        // builds the list of textures that have any sampled regions. The CPU only processes the textures in the list.
+        struct BatchedReadback
+        {
+            nvrhi::BufferHandle feedbackData;
+            nvrhi::BufferHandle feedbackDataReadback;
+            nvrhi::BufferHandle textureRanges;
+            nvrhi::BufferHandle requestList;
+            nvrhi::BufferHandle requestListReadback;
+            nvrhi::BindingSetHandle bindingSet;
+            uint64_t feedbackCapacity = 0;
+            uint32_t textureCapacity = 0;
+            std::vector<FeedbackTextureImpl*> textures; // Entries for the unregistered textures are nullptr
+            std::vector<uint32_t> textureOffsets;
+        };
+        nvrhi::BindingLayoutHandle m_reduceBindingLayout;
+        nvrhi::ComputePipelineHandle m_reducePipeline;
+        std::vector<BatchedReadback> m_batchedReadbacks;
+        std::map<FeedbackTextureImpl*, float> m_texturesWithRequests; // Textures sampled recently, and when
+        std::vector<uint8_t> m_emptyFeedback;
+        uint32_t m_texturesReadBack = 0;
+        uint32_t m_texturesProcessed = 0;
+        uint64_t m_heapBudgetInBytes = 0;
+
+        // Prefetch requests waiting for the next BeginFrame, and the time when the active requests were processed
+        std::map<FeedbackTextureImpl*, uint32_t> m_pendingPrefetches;
+        std::map<FeedbackTextureImpl*, float> m_activePrefetches;
+        uint32_t m_prefetchRequests = 0;
+        uint32_t m_prefetchHits = 0;
+        uint32_t m_prefetchMisses = 0;
     };
 }
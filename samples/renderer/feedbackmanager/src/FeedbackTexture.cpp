@@ -18,7 +18,7 @@
 
 namespace nvfeedback
 {
-    FeedbackTextureImpl::FeedbackTextureImpl(const nvrhi::TextureDesc& desc, FeedbackManagerImpl* pFeedbackManager, rtxts::TiledTextureManager* tiledTextureManager, nvrhi::IDevice* device, uint32_t numReadbacks) :
+    FeedbackTextureImpl::FeedbackTextureImpl(const nvrhi::TextureDesc& desc, FeedbackManagerImpl* pFeedbackManager, rtxts::TiledTextureManager* tiledTextureManager, nvrhi::IDevice* device, uint32_t numReadbacks, bool batchedReadback) :
         m_pFeedbackManager(pFeedbackManager),
         m_refCount(1)
     {
@@ -73,9 +73,10 @@ namespace nvfeedback
             m_feedbackTexture = deviceD3D12->createSamplerFeedbackTexture(m_reservedTexture, samplerFeedbackTextureDesc);
         }
 
-        // Resolve / Readback buffer
+        // Resolve / Readback buffer. With batched readback, the feedback is resolved into a GPU-local buffer
+        // and then copied into the shared readback buffer by the feedback manager.
         uint32_t readbackBuffersNum = 1;
-        readbackBuffersNum = numReadbacks;
+        readbackBuffersNum = batchedReadback ? 1 : numReadbacks;
         m_feedbackResolveBuffers.resize(readbackBuffersNum);
         for (uint32_t i = 0; i < readbackBuffersNum; i++)
         {
@@ -84,8 +85,9 @@ namespace nvfeedback
 
             nvrhi::BufferDesc bufferDesc = {};
             bufferDesc.byteSize = feedbackTilesX * feedbackTilesY;
-            bufferDesc.cpuAccess = nvrhi::CpuAccessMode::Read;
+            bufferDesc.cpuAccess = batchedReadback ? nvrhi::CpuAccessMode::None : nvrhi::CpuAccessMode::Read;
             bufferDesc.initialState = nvrhi::ResourceStates::ResolveDest;
+            bufferDesc.keepInitialState = batchedReadback;
             bufferDesc.debugName = "Resolve Buffer";
             m_feedbackResolveBuffers[i] = device->createBuffer(bufferDesc);
         }
@@ -135,6 +137,13 @@ namespace nvfeedback
         return tileIndex >= GetPackedMipInfo().startTileIndexInOverallResource;
     }
 
+    void FeedbackTextureImpl::GetPackedTileInfo(std::vector<FeedbackTextureTileInfo>& tiles)
+    {
+        tiles.clear();
+        if (GetPackedMipInfo().numPackedMips != 0)
+            GetTileInfo(GetPackedMipInfo().startTileIndexInOverallResource, tiles);
+    }
+
     void FeedbackTextureImpl::GetTileInfo(uint32_t tileIndex, std::vector<FeedbackTextureTileInfo>& tiles)
     {
         tiles.clear();
@@ -61,14 +61,24 @@ namespace nvfeedback
         nvrhi::TextureHandle GetMinMipTexture() override;
         bool IsTilePacked(uint32_t tileIndex) override;
         void GetTileInfo(uint32_t tileIndex, std::vector<FeedbackTextureTileInfo>& tiles) override;
+        void GetPackedTileInfo(std::vector<FeedbackTextureTileInfo>& tiles) override;
         uint32_t GetNumTextureSets() const override;
         FeedbackTextureSet* GetTextureSet(uint32_t index) const override;
 
         // Internal methods
-        FeedbackTextureImpl(const nvrhi::TextureDesc& desc, FeedbackManagerImpl* pFeedbackManager, rtxts::TiledTextureManager* tiledTextureManager, nvrhi::IDevice* device, uint32_t numReadbacks);
+        FeedbackTextureImpl(const nvrhi::TextureDesc& desc, FeedbackManagerImpl* pFeedbackManager, rtxts::TiledTextureManager* tiledTextureManager, nvrhi::IDevice* device, uint32_t numReadbacks, bool batchedReadback);
         ~FeedbackTextureImpl();
 
-        nvrhi::BufferHandle GetFeedbackResolveBuffer(uint32_t frameIndex) { return m_feedbackResolveBuffers[frameIndex]; }
+        // With batched readback, there is only one GPU-local resolve buffer
+        nvrhi::BufferHandle GetFeedbackResolveBuffer(uint32_t frameIndex) { return m_feedbackResolveBuffers[frameIndex % m_feedbackResolveBuffers.size()]; }
+
+        uint64_t GetResolveBufferBytes() const
+        {
+            uint64_t bytes = 0;
+            for (nvrhi::IBuffer* buffer : m_feedbackResolveBuffers)
+                bytes += buffer->getDesc().byteSize;
+            return bytes;
+        }
 
         uint32_t GetNumTiles() { return m_numTiles; }
         const nvrhi::TileShape& GetTileShape() const { return m_tileShape; }
@@ -17,8 +17,12 @@
 #include <donut/app/DeviceManager.h>
 #include <donut/engine/ShaderFactory.h>
 #include <nvrhi/utils.h>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <csignal>
+#include <mutex>
 #include <queue>
 #include <thread>
 #include <fstream>
@@ -28,6 +32,7 @@
 #include <ntc-utils/GraphicsBlockCompressionPass.h>
 #include <ntc-utils/Manifest.h>
 #include <ntc-utils/DDSHeader.h>
+#include <ntc-utils/DeviceUtils.h>
 
 #if NTC_WITH_NVTT
 #include <nvtt/nvtt.h>
@@ -56,9 +61,38 @@ struct
     bool nvtt = true;
 #endif
     int adapterIndex = -1;
+    const char* adapters = nullptr;
+    const char* bcQuality = nullptr;
     int threads = 0;
+
+    std::vector<int> adapterIndices; // Parsed from 'adapters', or just 'adapterIndex'
+    std::vector<int> bcQualityLevels; // Parsed from 'bcQuality', or just -1 meaning the default quality
 } g_options;
 
+// Parses a comma separated list of integers, returns false if any item is not a number in the [min, max] range.
+bool ParseIntegerList(char const* s, int min, int max, std::vector<int>& outValues)
+{
+    outValues.clear();
+    std::string const str = s;
+    size_t start = 0;
+    while (start <= str.size())
+    {
+        size_t comma = str.find(',', start);
+        if (comma == std::string::npos)
+            comma = str.size();
+
+        std::string const item = str.substr(start, comma - start);
+        char* end = nullptr;
+        long const value = strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != 0 || value < min || value > max)
+            return false;
+
+        outValues.push_back(int(value));
+        start = comma + 1;
+    }
+    return !outValues.empty();
+}
+
 bool ProcessCommandLine(int argc, const char** argv)
 {
     struct argparse_option options[] = {
@@ -81,6 +115,8 @@ bool ProcessCommandLine(int argc, const char** argv)
         OPT_BOOLEAN(0, "modeStats", &g_options.modeStats, "Enable collection and reporting of BC7 mode statistics"),
         OPT_BOOLEAN(0, "debug", &g_options.debug, "Enable debug features such as Vulkan validation layer or D3D12 debug runtime"),
         OPT_INTEGER(0, "adapter", &g_options.adapterIndex, "Index of the graphics adapter to use"),
+        OPT_STRING(0, "adapters", &g_options.adapters, "Comma separated list of graphics adapters to run the tests on in parallel, overrides --adapter"),
+        OPT_STRING(0, "bcQuality", &g_options.bcQuality, "Comma separated list of BC7 quality levels [0, 255] to test, each image is encoded at every level"),
         OPT_INTEGER(0, "threads", &g_options.threads, "Number of threads to use for preloading images"),
         OPT_END()
     };
@@ -130,6 +166,28 @@ bool ProcessCommandLine(int argc, const char** argv)
         return false;
     }
 
+    if (g_options.adapters)
+    {
+        if (!ParseIntegerList(g_options.adapters, 0, 255, g_options.adapterIndices))
+        {
+            fprintf(stderr, "Invalid --adapters value '%s'.\n", g_options.adapters);
+            return false;
+        }
+    }
+    else
+        g_options.adapterIndices.push_back(g_options.adapterIndex);
+
+    if (g_options.bcQuality)
+    {
+        if (!ParseIntegerList(g_options.bcQuality, 0, 255, g_options.bcQualityLevels))
+        {
+            fprintf(stderr, "Invalid --bcQuality value '%s'.\n", g_options.bcQuality);
+            return false;
+        }
+    }
+    else
+        g_options.bcQualityLevels.push_back(-1);
+
     return true;
 }
 
@@ -190,17 +248,20 @@ BcFormatDefinition const* GetFormatDef(ntc::BlockCompressedFormat format)
     return nullptr;
 }
 
-donut::app::DeviceCreationParameters GetGraphicsDeviceParameters()
+donut::app::DeviceCreationParameters GetGraphicsDeviceParameters(int adapterIndex)
 {
     donut::app::DeviceCreationParameters deviceParams;
     deviceParams.infoLogSeverity = donut::log::Severity::None;
-    deviceParams.adapterIndex = g_options.adapterIndex;
+    deviceParams.adapterIndex = adapterIndex;
     deviceParams.enableDebugRuntime = g_options.debug;
     deviceParams.enableNvrhiValidationLayer = g_options.debug;
+    // The copy queue is used to upload the next image while the current one is being encoded,
+    // on DX12 only, see IsCopyQueueUploadSupported
+    deviceParams.enableCopyQueue = !g_options.useVulkan;
     return deviceParams;
 }
 
-std::unique_ptr<donut::app::DeviceManager> InitGraphicsDevice()
+std::unique_ptr<donut::app::DeviceManager> InitGraphicsDevice(int adapterIndex)
 {
     using namespace donut::app;
 
@@ -210,7 +271,7 @@ std::unique_ptr<donut::app::DeviceManager> InitGraphicsDevice()
     
     auto deviceManager = std::unique_ptr<DeviceManager>(DeviceManager::Create(graphicsApi));
 
-    DeviceCreationParameters const deviceParams = GetGraphicsDeviceParameters();
+    DeviceCreationParameters const deviceParams = GetGraphicsDeviceParameters(adapterIndex);
 
     if (!deviceManager->CreateHeadlessDevice(deviceParams))
     {
@@ -266,6 +327,36 @@ std::vector<fs::path> EnumerateSourceFiles()
     return result;
 }
 
+// A graphics device with the objects needed to run the tests on it. Each device is driven by its own thread.
+struct TestDevice
+{
+    int adapterIndex = -1;
+    std::unique_ptr<donut::app::DeviceManager> deviceManager;
+    nvrhi::IDevice* device = nullptr;
+    ntc::ContextWrapper context;
+    std::unique_ptr<GraphicsBlockCompressionPass> blockCompressionPass;
+    std::unique_ptr<GraphicsImageDifferencePass> imageDifferencePass;
+    nvrhi::CommandListHandle commandList;
+    nvrhi::CommandListHandle uploadCommandList;
+    nvrhi::CommandQueue uploadQueue = nvrhi::CommandQueue::Graphics;
+    nvrhi::EventQueryHandle graphicsQuery;
+    nvrhi::EventQueryHandle uploadQuery;
+    nvrhi::TimerQueryHandle timerQuery;
+    nvrhi::BufferHandle accelerationBuffer;
+    std::vector<uint32_t> nvttModeStats;
+    uint64_t encodedPixels = 0;
+
+    // Executes the main command list and waits for it to finish, without waiting for the uploads on the copy queue.
+    void ExecuteAndWait()
+    {
+        device->executeCommandList(commandList);
+        device->resetEventQuery(graphicsQuery);
+        device->setEventQuery(graphicsQuery, nvrhi::CommandQueue::Graphics);
+        device->waitEventQuery(graphicsQuery);
+        device->runGarbageCollection();
+    }
+};
+
 struct ImageData
 {
     int width = 0;
@@ -295,8 +386,12 @@ struct ImageData
         data = nullptr;
     }
 
-    bool InitTextures(nvrhi::IDevice* device, nvrhi::ICommandList* commandList, BcFormatDefinition const& formatDef)
+    // Creates the textures and starts uploading the image data on the upload queue of the device.
+    // Wait for testDevice.uploadQuery before using the textures.
+    bool InitTextures(TestDevice& testDevice, BcFormatDefinition const& formatDef)
     {
+        nvrhi::IDevice* device = testDevice.device;
+
         nvrhi::TextureDesc originalTextureDesc = nvrhi::TextureDesc()
             .setDebugName(name.generic_string())
             .setWidth(width)
@@ -339,11 +434,13 @@ struct ImageData
 
         size_t const bytesPerPixel = isHDR ? 16 : 4;
 
+        nvrhi::ICommandList* commandList = testDevice.uploadCommandList;
         commandList->open();
         commandList->writeTexture(originalTexture, 0, 0, data, width * bytesPerPixel);
         commandList->close();
-        device->executeCommandList(commandList);
-        device->waitForIdle();
+        device->executeCommandList(commandList, testDevice.uploadQueue);
+        device->resetEventQuery(testDevice.uploadQuery);
+        device->setEventQuery(testDevice.uploadQuery, testDevice.uploadQueue);
 
         return true;
     }
@@ -469,18 +566,20 @@ bool WriteDdsFile(fs::path const& outputFileName, int width, int height, BcForma
 bool CompressWithNtc(
     ImageData const& imageData,
     BcFormatDefinition const& formatDef,
-    ntc::IContext* context,
-    GraphicsBlockCompressionPass& blockCompressionPass,
-    GraphicsImageDifferencePass& imageDifferencePass,
-    nvrhi::IDevice* device,
-    nvrhi::ICommandList* commandList,
-    nvrhi::ITimerQuery* timerQuery,
-    nvrhi::IBuffer* accelerationBuffer,
+    TestDevice& testDevice,
+    int bcQuality,
     float& outPsnr,
     float& outRmse,
     float& outGPixelsPerSecond)
 {
     float const alphaThreshold = 1.f / 255.f;
+    ntc::IContext* context = testDevice.context;
+    nvrhi::IDevice* device = testDevice.device;
+    nvrhi::ICommandList* commandList = testDevice.commandList;
+    nvrhi::ITimerQuery* timerQuery = testDevice.timerQuery;
+    nvrhi::IBuffer* accelerationBuffer = testDevice.accelerationBuffer;
+    GraphicsBlockCompressionPass& blockCompressionPass = *testDevice.blockCompressionPass;
+    GraphicsImageDifferencePass& imageDifferencePass = *testDevice.imageDifferencePass;
 
     ntc::MakeBlockCompressionComputePassParameters compressionParams;
     compressionParams.srcRect.width = imageData.width;
@@ -488,6 +587,8 @@ bool CompressWithNtc(
     compressionParams.dstFormat = formatDef.ntcFormat;
     compressionParams.alphaThreshold = alphaThreshold;
     compressionParams.writeAccelerationData = accelerationBuffer != nullptr;
+    if (bcQuality >= 0)
+        compressionParams.quality = uint8_t(bcQuality);
     ntc::ComputePassDesc blockCompressionComputePass;
     ntc::Status ntcStatus = context->MakeBlockCompressionComputePass(compressionParams, &blockCompressionComputePass);
     CHECK_NTC_RESULT(MakeBlockCompressionComputePass)
@@ -526,9 +627,7 @@ bool CompressWithNtc(
     commandList->copyTexture(imageData.stagingTexture, nvrhi::TextureSlice(), imageData.blockTexture, nvrhi::TextureSlice());
     commandList->close();
 
-    device->executeCommandList(commandList);
-    device->waitForIdle();
-    device->runGarbageCollection();
+    testDevice.ExecuteAndWait();
 
     float const timeSeconds = device->getTimerQueryTime(timerQuery);
     if (timeSeconds > 0.f)
@@ -546,13 +645,20 @@ bool CompressWithNtc(
     // Also, they are calculated as if the maximum value of log(color + 1) was 1.0, and it's actually 11.09 for FP16/BC6.
     // This way, we're getting "sane" dB values like 40, but they're only useful for relative comparison in the same
     // framework.
-    printf("[NTC]  %s: %.2f %sdB, %.3f Gpix/s\n", imageData.name.generic_string().c_str(),
+    char qualityLabel[16] = "";
+    if (bcQuality >= 0)
+        snprintf(qualityLabel, sizeof qualityLabel, " q%d", bcQuality);
+    printf("[NTC]  %s%s: %.2f %sdB, %.3f Gpix/s\n", imageData.name.generic_string().c_str(), qualityLabel,
         outPsnr, imageData.isHDR ? "false " : "", outGPixelsPerSecond);
 
     if (g_options.outputPath)
     {
+        // Add the quality level into the file names when testing several levels to keep them apart
+        std::string suffix = std::string(".") + g_options.format;
+        if (g_options.bcQualityLevels.size() > 1)
+            suffix += ".q" + std::to_string(bcQuality);
         fs::path ddsName = imageData.name;
-        ddsName.replace_extension(std::string(".") + g_options.format + ".NTC.dds");
+        ddsName.replace_extension(suffix + ".NTC.dds");
         fs::path outputFileName = fs::path(g_options.outputPath) / ddsName;
         size_t rowPitch;
         uint8_t const* compressedData = (uint8_t const*)device->mapStagingTexture(imageData.stagingTexture, nvrhi::TextureSlice(), nvrhi::CpuAccessMode::Read, &rowPitch);
@@ -600,15 +706,15 @@ void ExtractModeStats(
 bool CompressWithNvtt(
     ImageData const& imageData,
     BcFormatDefinition const& formatDef,
-    ntc::IContext* context,
-    GraphicsImageDifferencePass& imageDifferencePass,
-    nvrhi::IDevice* device,
-    nvrhi::ICommandList* commandList,
+    TestDevice& testDevice,
     float& outPsnr,
-    float& outRmse,
-    std::vector<uint32_t>& modeStats)
+    float& outRmse)
 {
     float const alphaThreshold = 1.f / 255.f;
+    ntc::IContext* context = testDevice.context;
+    nvrhi::ICommandList* commandList = testDevice.commandList;
+    GraphicsImageDifferencePass& imageDifferencePass = *testDevice.imageDifferencePass;
+    std::vector<uint32_t>& modeStats = testDevice.nvttModeStats;
 
     nvtt::RefImage image;
     image.width = imageData.width;
@@ -659,9 +765,7 @@ bool CompressWithNvtt(
     }
     commandList->close();
 
-    device->executeCommandList(commandList);
-    device->waitForIdle();
-    device->runGarbageCollection();
+    testDevice.ExecuteAndWait();
     
     float mse = 0.f;
     imageDifferencePass.ReadResults();
@@ -699,6 +803,7 @@ struct Result
     float nvttPsnr = 0;
     float nvttRmse = 0;
     float ntcGPixelsPerSecond = 0;
+    int bcQuality = -1; // -1 means the default quality of the encoder
 };
 
 // Splits the comma separated string into a vector of its components.
@@ -752,6 +857,7 @@ bool LoadBaseline(char const* fileName, std::vector<Result>& outResults)
     int nvttCol = -1;
     int ntcCol = -1;
     int ntcPerfCol = -1;
+    int bcQualityCol = -1;
     while (std::getline(file, line))
     {
         ++lineno;
@@ -763,6 +869,7 @@ bool LoadBaseline(char const* fileName, std::vector<Result>& outResults)
             nvttCol = FindColumn(parts, "NVTT dB");
             ntcCol = FindColumn(parts, "NTC dB");
             ntcPerfCol = FindColumn(parts, "NTC Gpix/s");
+            bcQualityCol = FindColumn(parts, "BC Quality");
             if (nameCol < 0)
             {
                 fprintf(stderr, "There is no Name column in the input CSV file '%s'", fileName);
@@ -780,6 +887,8 @@ bool LoadBaseline(char const* fileName, std::vector<Result>& outResults)
                 result.ntcPsnr = ParseFloatInf(parts[ntcCol].c_str());
             if (ntcPerfCol >= 0 && ntcPerfCol < int(parts.size()))
                 result.ntcGPixelsPerSecond = ParseFloatInf(parts[ntcPerfCol].c_str());
+            if (bcQualityCol >= 0 && bcQualityCol < int(parts.size()))
+                result.bcQuality = atoi(parts[bcQualityCol].c_str());
             outResults.push_back(std::move(result));
         }
     }
@@ -905,10 +1014,12 @@ void ReportModeStatistics(
     }
 }
 
-void ReportModeStatisticsFromBuffer(
+// Reads the BC7 mode statistics collected by the NTC encoder on a device and adds them to modeStats.
+void ReadModeStatisticsFromBuffer(
     nvrhi::IDevice* device,
     nvrhi::ICommandList* commandList,
-    nvrhi::IBuffer* accelerationBuffer)
+    nvrhi::IBuffer* accelerationBuffer,
+    std::vector<uint32_t>& modeStats)
 {
     // Create a staging buffer to read the data from device
     nvrhi::BufferDesc accelerationStagingBufferDesc = nvrhi::BufferDesc()
@@ -932,54 +1043,208 @@ void ReportModeStatisticsFromBuffer(
 
     if (accelerationData)
     {
-        ReportModeStatistics(accelerationData, "NTC");
+        for (size_t i = 0; i < modeStats.size(); ++i)
+            modeStats[i] += accelerationData[i];
         device->unmapBuffer(accelerationStagingBuffer);
     }
 }
 
-bool RunTests(std::vector<fs::path> sourceFiles, std::vector<Result>& results, ntc::IContext* context, nvrhi::IDevice* device)
+// A queue with a fixed capacity that blocks the producers when it's full and the consumers when it's empty.
+// After Close(), the consumers get the remaining items and then Pop() fails instead of blocking,
+// and Push() fails immediately.
+template<typename T>
+class BlockingQueue
 {
-    ntc::BlockCompressedFormat format = ParseBlockCompressedFormat(g_options.format).value_or(ntc::BlockCompressedFormat::None);
-    BcFormatDefinition const* pFormatDef = GetFormatDef(format);
+public:
+    BlockingQueue(size_t capacity)
+        : m_capacity(capacity)
+    { }
+
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this]() { return m_items.size() < m_capacity || m_closed; });
+        if (m_closed)
+            return false;
+        m_items.push(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    bool Pop(T& outItem)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this]() { return !m_items.empty() || m_closed; });
+        return PopLocked(outItem);
+    }
+
+    // Same as Pop(), but returns false instead of waiting when the queue is empty.
+    bool TryPop(T& outItem)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return PopLocked(outItem);
+    }
+
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    std::queue<T> m_items;
+    size_t m_capacity;
+    bool m_closed = false;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+
+    bool PopLocked(T& outItem)
+    {
+        if (m_items.empty())
+            return false;
+        outItem = std::move(m_items.front());
+        m_items.pop();
+        m_notFull.notify_one();
+        return true;
+    }
+};
+
+bool InitTestDevice(TestDevice& testDevice)
+{
+    testDevice.deviceManager = InitGraphicsDevice(testDevice.adapterIndex);
+    if (!testDevice.deviceManager)
+        return false;
+
+    nvrhi::IDevice* device = testDevice.deviceManager->GetDevice();
+    testDevice.device = device;
+
+    if (!InitNtcContext(device, testDevice.context))
+        return false;
 
     // Pre-initialize shared graphics passes
 
-    GraphicsBlockCompressionPass blockCompressionPass(device, true);
-    if (!blockCompressionPass.Init())
+    testDevice.blockCompressionPass = std::make_unique<GraphicsBlockCompressionPass>(device, true);
+    if (!testDevice.blockCompressionPass->Init())
         return false;
 
-    GraphicsImageDifferencePass imageDifferencePass(device);
-    if (!imageDifferencePass.Init())
+    testDevice.imageDifferencePass = std::make_unique<GraphicsImageDifferencePass>(device);
+    if (!testDevice.imageDifferencePass->Init())
         return false;
 
-    nvrhi::CommandListHandle commandList = device->createCommandList();
-    nvrhi::TimerQueryHandle timerQuery = device->createTimerQuery();
-    nvrhi::BufferHandle accelerationBuffer = CreateAndClearAccelerationBuffer(device, commandList);
-    std::vector<uint32_t> nvttModeStats(ntc::BlockCompressionAccelerationBufferSize / sizeof(uint32_t));
+    if (IsCopyQueueUploadSupported(device))
+        testDevice.uploadQueue = nvrhi::CommandQueue::Copy;
+
+    testDevice.commandList = device->createCommandList();
+    testDevice.uploadCommandList = device->createCommandList(nvrhi::CommandListParameters()
+        .setEnableImmediateExecution(false)
+        .setQueueType(testDevice.uploadQueue));
+    testDevice.graphicsQuery = device->createEventQuery();
+    testDevice.uploadQuery = device->createEventQuery();
+    testDevice.timerQuery = device->createTimerQuery();
+    testDevice.accelerationBuffer = CreateAndClearAccelerationBuffer(device, testDevice.commandList);
+    testDevice.nvttModeStats.resize(ntc::BlockCompressionAccelerationBufferSize / sizeof(uint32_t));
+
+    return true;
+}
+
+void TestImage(TestDevice& testDevice, ImageData const& imageData, BcFormatDefinition const& formatDef,
+    std::vector<Result>& results)
+{
+#if NTC_WITH_NVTT
+    // NVTT has no matching quality knob, so it only runs once per image, and its result goes into the rows
+    // of all quality levels so that every level is compared with it
+    float nvttPsnr = 0.f;
+    float nvttRmse = 0.f;
+    if (g_options.nvtt)
+        CompressWithNvtt(imageData, formatDef, testDevice, nvttPsnr, nvttRmse);
+#endif
+
+    for (int bcQuality : g_options.bcQualityLevels)
+    {
+        Result result;
+        result.name = imageData.name;
+        result.bcQuality = bcQuality;
+
+        if (g_options.ntc)
+        {
+            if (CompressWithNtc(imageData, formatDef, testDevice, bcQuality, result.ntcPsnr, result.ntcRmse,
+                result.ntcGPixelsPerSecond))
+            {
+                testDevice.encodedPixels += uint64_t(imageData.width) * uint64_t(imageData.height);
+            }
+        }
+
+#if NTC_WITH_NVTT
+        result.nvttPsnr = nvttPsnr;
+        result.nvttRmse = nvttRmse;
+#endif
+
+        results.push_back(result);
+    }
+}
+
+// Pulls the decoded images from imageQueue and runs the tests on one device. The upload of the next image
+// on the copy queue overlaps with the encoding of the current image on the graphics queue.
+void RunDeviceTests(TestDevice& testDevice, BlockingQueue<std::shared_ptr<ImageData>>& imageQueue,
+    BcFormatDefinition const& formatDef, std::vector<Result>& results)
+{
+    std::shared_ptr<ImageData> currentImage;
+    while (!g_Terminate)
+    {
+        // Don't wait for the decoders while there is an uploaded image ready to go
+        std::shared_ptr<ImageData> nextImage;
+        bool const haveNextImage = currentImage ? imageQueue.TryPop(nextImage) : imageQueue.Pop(nextImage);
+        if (!haveNextImage && !currentImage)
+            break;
+
+        // Create the graphics texture objects and start uploading data to the GPU
+        if (nextImage && !nextImage->InitTextures(testDevice, formatDef))
+            nextImage = nullptr;
+
+        if (currentImage)
+            TestImage(testDevice, *currentImage, formatDef, results);
+
+        if (nextImage)
+            testDevice.device->waitEventQuery(testDevice.uploadQuery);
+
+        currentImage = nextImage;
+    }
+}
+
+bool RunTests(std::vector<fs::path> sourceFiles, std::vector<Result>& results,
+    std::vector<std::unique_ptr<TestDevice>>& testDevices)
+{
+    ntc::BlockCompressedFormat format = ParseBlockCompressedFormat(g_options.format).value_or(ntc::BlockCompressedFormat::None);
+    BcFormatDefinition const* pFormatDef = GetFormatDef(format);
 
     // The runner uses multiple threads to load source images because decoding PNG or JPG takes a long time.
     // The source image paths are placed into sourceFileQueue, and the threads pull tasks from that queue.
-    // Once loaded, ImageData objects are placed into imageQueue. The main thread pulls images from that queue.
+    // Once loaded, ImageData objects are placed into imageQueue, which is bounded to limit the memory used by
+    // the decoded images. Every device has a thread that pulls images from that queue.
 
     std::queue<fs::path> sourceFileQueue;
     for (fs::path const& path : sourceFiles)
         sourceFileQueue.push(path);
-    std::queue<std::shared_ptr<ImageData>> imageQueue;
     std::mutex sourceMutex;
-    std::mutex imageMutex;
 
     std::vector<std::shared_ptr<std::thread>> threads;
     int numThreads = g_options.threads > 0 ? g_options.threads : std::thread::hardware_concurrency();
-    numThreads = std::min(int(sourceFiles.size()), numThreads);
+    numThreads = std::max(std::min(int(sourceFiles.size()), numThreads), 1);
 
-    // Using a live thread counter to find out when all files have been processed.
-    // This can't be done by just looking at either queue because a task can be in-flight when both queues are empty.
+    BlockingQueue<std::shared_ptr<ImageData>> imageQueue(size_t(numThreads) + testDevices.size() * 2);
+
+    // Using a live thread counter to find out when all files have been processed, and close the queue then.
     std::atomic<int> liveThreads = numThreads;
 
+    auto const startTime = std::chrono::steady_clock::now();
+
     // Start the decoding threads
     for (int i = 0; i < numThreads; ++i)
     {
-        auto thread = std::make_shared<std::thread>([&sourceFileQueue, &sourceMutex, &imageQueue, &imageMutex, &liveThreads]()
+        auto thread = std::make_shared<std::thread>([&sourceFileQueue, &sourceMutex, &imageQueue, &liveThreads]()
         {
             while(!g_Terminate)
             {
@@ -996,80 +1261,84 @@ bool RunTests(std::vector<fs::path> sourceFiles, std::vector<Result>& results, n
                 // Process the task
                 std::shared_ptr<ImageData> imageData = LoadImage(fileName);
 
-                // If decoding was successful, put the image data into imageQueue
-                if (imageData)
-                {
-                    std::lock_guard<std::mutex> lock(imageMutex);
-                    imageQueue.push(imageData);
-                }
+                // If decoding was successful, put the image data into imageQueue.
+                // A failed push means the queue was closed because the tests are stopping.
+                if (imageData && !imageQueue.Push(imageData))
+                    break;
             }
-            --liveThreads;
+            if (--liveThreads == 0)
+                imageQueue.Close();
         });
         threads.push_back(thread);
     }
 
-    // Main loop that pulls images from imageQueue and runs the compression tests on them
-    while (!g_Terminate)
+    // Start the device threads
+    std::vector<std::vector<Result>> deviceResults(testDevices.size());
+    std::vector<std::thread> deviceThreads;
+    for (size_t index = 0; index < testDevices.size(); ++index)
     {
-        std::shared_ptr<ImageData> imageData;
+        deviceThreads.emplace_back([&testDevices, &imageQueue, pFormatDef, &deviceResults, index]()
         {
-            std::lock_guard<std::mutex> lock(imageMutex);
-            if (!imageQueue.empty())
-            {
-                imageData = imageQueue.front();
-                imageQueue.pop();
-            }
-        }
+            RunDeviceTests(*testDevices[index], imageQueue, *pFormatDef, deviceResults[index]);
+        });
+    }
 
-        // If we couldn't pull a task from the queue, it means either something is still decoding or we're done
-        if (!imageData)
-        {
-            // All the threads finished means there are no more tasks
-            if (liveThreads <= 0)
-                break;
+    for (auto& thread : deviceThreads)
+        thread.join();
 
-            // There are more tasks: sleep a bit and try again
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            continue;
-        }
-        
-        // Create the graphics texture objects and upload data to the GPU
-        if (!imageData->InitTextures(device, commandList, *pFormatDef))
-            continue;
+    // Release the decoders if the device threads stopped early
+    imageQueue.Close();
 
-        Result result;
-        result.name = imageData->name;
+    // Wait until all threads have finished
+    for (auto& thread : threads)
+        thread->join();
 
-        if (g_options.ntc)
-        {
-            CompressWithNtc(*imageData, *pFormatDef, context, blockCompressionPass, imageDifferencePass,
-                device, commandList, timerQuery, accelerationBuffer, result.ntcPsnr, result.ntcRmse,
-                result.ntcGPixelsPerSecond);
-        }
+    double const elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
 
-#if NTC_WITH_NVTT
-        if (g_options.nvtt)
+    // End-to-end throughput including decoding and uploads, as opposed to the GPU-only numbers in the results
+    uint64_t totalPixels = 0;
+    for (size_t index = 0; index < testDevices.size(); ++index)
+    {
+        TestDevice const& testDevice = *testDevices[index];
+        totalPixels += testDevice.encodedPixels;
+        if (testDevices.size() > 1)
         {
-            CompressWithNvtt(*imageData, *pFormatDef, context, imageDifferencePass,
-                device, commandList, result.nvttPsnr, result.nvttRmse, nvttModeStats);
+            printf("Adapter %d: %d results, %.3f Gpix encoded with NTC\n", testDevice.adapterIndex,
+                int(deviceResults[index].size()), double(testDevice.encodedPixels) * 1e-9);
         }
-#endif
-
-        results.push_back(result);
+        results.insert(results.end(), deviceResults[index].begin(), deviceResults[index].end());
+    }
+    if (totalPixels != 0 && elapsedSeconds > 0.0)
+    {
+        printf("Encoded %.3f Gpix with NTC in %.2f s on %d device(s): %.3f Gpix/s end-to-end\n",
+            double(totalPixels) * 1e-9, elapsedSeconds, int(testDevices.size()),
+            double(totalPixels) * 1e-9 / elapsedSeconds);
     }
-
-    // Wait until all threads have finished
-    for (auto& thread : threads)
-        thread->join();
 
     if (g_options.modeStats && format == ntc::BlockCompressedFormat::BC7)
     {
         if (g_options.ntc)
-            ReportModeStatisticsFromBuffer(device, commandList, accelerationBuffer);
+        {
+            std::vector<uint32_t> ntcModeStats(ntc::BlockCompressionAccelerationBufferSize / sizeof(uint32_t));
+            for (auto& testDevice : testDevices)
+            {
+                ReadModeStatisticsFromBuffer(testDevice->device, testDevice->commandList,
+                    testDevice->accelerationBuffer, ntcModeStats);
+            }
+            ReportModeStatistics(ntcModeStats.data(), "NTC");
+        }
 
 #if NTC_WITH_NVTT
         if (g_options.nvtt)
+        {
+            std::vector<uint32_t> nvttModeStats(ntc::BlockCompressionAccelerationBufferSize / sizeof(uint32_t));
+            for (auto& testDevice : testDevices)
+            {
+                for (size_t i = 0; i < nvttModeStats.size(); ++i)
+                    nvttModeStats[i] += testDevice->nvttModeStats[i];
+            }
             ReportModeStatistics(nvttModeStats.data(), "NVTT");
+        }
 #endif
     }
 
@@ -1093,7 +1362,9 @@ bool ProcessResults(std::vector<Result> const& baselineResults, std::vector<Resu
 {
     std::sort(results.begin(), results.end(), [](Result const& a, Result const& b)
     {
-        return a.name < b.name;
+        if (a.name != b.name)
+            return a.name < b.name;
+        return a.bcQuality < b.bcQuality;
     });
 
 
@@ -1111,7 +1382,7 @@ bool ProcessResults(std::vector<Result> const& baselineResults, std::vector<Resu
         {
             auto baselineResult = std::find_if(baselineResults.begin(), baselineResults.end(), [&result](Result const& a)
             {
-                return a.name == result.name;
+                return a.name == result.name && a.bcQuality == result.bcQuality;
             });
 
             if (baselineResult != baselineResults.end())
@@ -1151,6 +1422,36 @@ bool ProcessResults(std::vector<Result> const& baselineResults, std::vector<Resu
     if (!currentNtcGpixPerSecond.empty())
         printf("Average NTC encoding perf: %.3f Gpix/s\n", meanNtcGpixPerSecond);
 
+    // Report the distribution of the per-image GPU encoding perf for every quality level
+    if (g_options.ntc)
+    {
+        for (int bcQuality : g_options.bcQualityLevels)
+        {
+            std::vector<float> gpixPerSecond;
+            for (Result const& result : results)
+            {
+                if (result.bcQuality == bcQuality && result.ntcGPixelsPerSecond > 0.f)
+                    gpixPerSecond.push_back(result.ntcGPixelsPerSecond);
+            }
+            if (gpixPerSecond.empty())
+                continue;
+
+            std::sort(gpixPerSecond.begin(), gpixPerSecond.end());
+            auto percentile = [&gpixPerSecond](float p)
+            {
+                size_t const rank = size_t(ceilf(p * float(gpixPerSecond.size())));
+                return gpixPerSecond[std::min(std::max(rank, size_t(1)), gpixPerSecond.size()) - 1];
+            };
+
+            char qualityLabel[16] = "default";
+            if (bcQuality >= 0)
+                snprintf(qualityLabel, sizeof qualityLabel, "%d", bcQuality);
+            printf("NTC %s quality %s: P10 = %.3f, P50 = %.3f, P90 = %.3f, P99 = %.3f Gpix/s over %d images\n",
+                g_options.format, qualityLabel, percentile(0.1f), percentile(0.5f), percentile(0.9f), percentile(0.99f),
+                int(gpixPerSecond.size()));
+        }
+    }
+
     // Print out the quality statistics
     if (!ntcBaselineDiff.Empty())
     {
@@ -1184,13 +1485,13 @@ bool ProcessResults(std::vector<Result> const& baselineResults, std::vector<Resu
         FILE* csvFile = fopen(g_options.csvOutputPath, "w");
         if (csvFile)
         {
-            fprintf(csvFile, "Name,NTC dB,NTC RMS(L)E,NTC Gpix/s,Baseline NTC dB,NVTT dB,NVTT RMS(L)E,NTC - NVTT dB,NTC Improvement dB\n");
+            fprintf(csvFile, "Name,NTC dB,NTC RMS(L)E,NTC Gpix/s,Baseline NTC dB,NVTT dB,NVTT RMS(L)E,NTC - NVTT dB,NTC Improvement dB,BC Quality\n");
             for (Result const& result : results)
             {
-                fprintf(csvFile, "%s,%.3f,%.5f,%.3f,%.3f,%.3f,%.5f,%.3f,%.3f\n", result.name.generic_string().c_str(),
+                fprintf(csvFile, "%s,%.3f,%.5f,%.3f,%.3f,%.3f,%.5f,%.3f,%.3f,%d\n", result.name.generic_string().c_str(),
                     result.ntcPsnr, result.ntcRmse, result.ntcGPixelsPerSecond, result.baselineNtcPsnr,
                     result.nvttPsnr, result.nvttRmse,
-                    result.ntcPsnr - result.nvttPsnr, result.ntcPsnr - result.baselineNtcPsnr);
+                    result.ntcPsnr - result.nvttPsnr, result.ntcPsnr - result.baselineNtcPsnr, result.bcQuality);
             }
             fclose(csvFile);
         }
@@ -1221,19 +1522,21 @@ int main(int argc, const char** argv)
         printf("Loaded %d baseline results from '%s'\n", int(baselineResults.size()), g_options.loadBaselinePath);
     }
 
-    std::unique_ptr<donut::app::DeviceManager> deviceManager = InitGraphicsDevice();
-    if (!deviceManager)
-        return 1;
-
-    ntc::ContextWrapper context;
-    if (!InitNtcContext(deviceManager->GetDevice(), context))
-        return 1;
+    std::vector<std::unique_ptr<TestDevice>> testDevices;
+    for (int adapterIndex : g_options.adapterIndices)
+    {
+        auto testDevice = std::make_unique<TestDevice>();
+        testDevice->adapterIndex = adapterIndex;
+        if (!InitTestDevice(*testDevice))
+            return 1;
+        testDevices.push_back(std::move(testDevice));
+    }
 
     signal(SIGINT, SigintHandler);
 
     std::vector<fs::path> sourceFiles = EnumerateSourceFiles();
     std::vector<Result> results;
-    if (!RunTests(sourceFiles, results, context, deviceManager->GetDevice()))
+    if (!RunTests(sourceFiles, results, testDevices))
         return 1;
 
     if (!ProcessResults(baselineResults, results))
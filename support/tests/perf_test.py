@@ -0,0 +1,264 @@
+#!/usr/bin/python
+
+# SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+# SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+#
+# NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+# property and proprietary rights in and to this material, related
+# documentation and any modifications thereto. Any use, reproduction,
+# disclosure or distribution of this material and related documentation
+# without an express license agreement from NVIDIA CORPORATION or
+# its affiliates is strictly prohibited.
+
+"""
+Performance regression tests for ntc-cli. Every test runs the tool several times, collects the timing
+and memory samples from its telemetry, and compares them with the baseline samples recorded on the same GPU model.
+A test fails when the median is worse than the baseline by more than the threshold, and a one-sided
+Mann-Whitney U test confirms that the difference is significant. Peak memory is compared with the baseline maximum.
+
+Run make_test_ntc_files.py first, then record the baselines with --update on a known good build:
+
+  python perf_test.py --update
+  python perf_test.py
+"""
+
+import argparse
+import json
+import math
+import os
+import shutil
+import sys
+import unittest
+
+# add ../../libraries to the path to import ntc
+sdkroot = os.path.dirname(os.path.dirname(os.path.dirname(os.path.realpath(__file__))))
+sys.path.append(os.path.join(sdkroot, 'libraries'))
+
+import ntc
+
+sourceDir = os.path.join(sdkroot, 'assets/materials')
+testFilesDir = os.path.join(sdkroot, 'assets/testfiles')
+scratchDir = os.path.join(sdkroot, 'assets/testscratch')
+defaultBaselineFile = os.path.join(os.path.dirname(os.path.realpath(__file__)), 'perf_baselines.json')
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--tool', default = ntc.get_default_tool_path(), help = 'Path to the ntc-cli executable')
+parser.add_argument('--baselines', default = defaultBaselineFile, help = f'Baseline file, defaults to {defaultBaselineFile}')
+parser.add_argument('--update', action = 'store_true', help = 'Replace the baselines for the current GPU with the new measurements instead of comparing')
+parser.add_argument('--repeats', type = int, default = 5, help = 'Number of times every test runs the tool, default is 5')
+parser.add_argument('--threshold', type = float, default = 5, help = 'Allowed slowdown of the median, in percent, default is 5')
+parser.add_argument('--memoryThreshold', type = float, default = 10, help = 'Allowed increase of peak memory, in percent, default is 10')
+parser.add_argument('--confidence', type = float, default = 0.95, help = 'Confidence level for the regression test, default is 0.95')
+args = parser.parse_args()
+
+
+def _median(samples):
+    ordered = sorted(samples)
+    middle = len(ordered) // 2
+    return ordered[middle] if len(ordered) % 2 else 0.5 * (ordered[middle - 1] + ordered[middle])
+
+def _mann_whitney_p_value(baseline, current):
+    """
+    Returns the p-value of the one-sided Mann-Whitney U test for the hypothesis that the 'current' samples
+    tend to be larger than the 'baseline' samples, using the normal approximation with tie correction.
+    """
+    n1, n2 = len(baseline), len(current)
+    combined = sorted([(value, 0) for value in baseline] + [(value, 1) for value in current])
+
+    # Assign average ranks to the tied values
+    ranks = [0.0] * len(combined)
+    tieCorrection = 0.0
+    i = 0
+    while i < len(combined):
+        j = i
+        while j + 1 < len(combined) and combined[j + 1][0] == combined[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = 0.5 * (i + j) + 1
+        ties = j - i + 1
+        tieCorrection += ties ** 3 - ties
+        i = j + 1
+
+    currentRankSum = sum(rank for rank, (value, group) in zip(ranks, combined) if group == 1)
+    u = currentRankSum - n2 * (n2 + 1) / 2
+    mean = n1 * n2 / 2
+    n = n1 + n2
+    variance = n1 * n2 / 12 * ((n + 1) - tieCorrection / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+
+    z = (u - mean - 0.5) / math.sqrt(variance) # with continuity correction
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+class Baselines:
+    "Baseline samples stored in a JSON file: { gpu name: { metric name: [samples] } }"
+
+    def __init__(self, fileName: str):
+        self.fileName = fileName
+        self.data = {}
+        if os.path.exists(fileName):
+            with open(fileName, 'r') as file:
+                self.data = json.load(file)
+
+    def get(self, gpuName: str, metric: str):
+        return self.data.get(gpuName, {}).get(metric)
+
+    def set(self, gpuName: str, metric: str, samples):
+        self.data.setdefault(gpuName, {})[metric] = samples
+
+    def save(self):
+        with open(self.fileName, 'w') as file:
+            json.dump(self.data, file, indent = 2, sort_keys = True)
+
+baselines = Baselines(args.baselines)
+
+
+class PerformanceTestCase(unittest.TestCase):
+
+    def setUp(self):
+        self.tool = args.tool
+        if os.path.exists(scratchDir):
+            shutil.rmtree(scratchDir)
+        os.makedirs(scratchDir)
+
+    def runRepeatedly(self, ntcArgs: ntc.Arguments, measure):
+        """
+        Runs the tool 'args.repeats' times and returns the GPU name and a dict { metric: [samples] }.
+        The 'measure' function receives the Result and returns a dict { metric: value } for one run.
+        """
+        gpuName = None
+        samples = {}
+        for _ in range(args.repeats):
+            result = ntc.run(ntcArgs)
+            gpuName = gpuName or result.gpuName
+            for metric, value in measure(result).items():
+                if value is not None:
+                    samples.setdefault(metric, []).append(value)
+        self.assertTrue(gpuName, 'The tool did not report the GPU name')
+        return gpuName, samples
+
+    def checkSamples(self, gpuName: str, samples):
+        """
+        Compares the samples with the baselines, or stores them with --update. Lower values are better.
+        All metrics that have baselines are checked, even when some others don't have them and the test is skipped.
+        """
+
+        missing = []
+        failures = []
+        for metric, current in sorted(samples.items()):
+            if args.update:
+                baselines.set(gpuName, metric, current)
+                print(f'\n  {metric}: median {_median(current):.4g} (baseline updated)', end = '')
+                continue
+
+            baseline = baselines.get(gpuName, metric)
+            if not baseline:
+                print(f'\n  {metric}: no baseline', end = '')
+                missing.append(metric)
+                continue
+
+            if metric.endswith('Bytes'):
+                limit = max(baseline) * (1 + args.memoryThreshold / 100)
+                print(f'\n  {metric}: {max(current)} bytes, baseline {max(baseline)}', end = '')
+                if max(current) > limit:
+                    failures.append(f'{metric} regressed: {max(current)} bytes, '
+                                    f'baseline {max(baseline)} bytes on {gpuName}')
+                continue
+
+            currentMedian = _median(current)
+            baselineMedian = _median(baseline)
+            change = (currentMedian / baselineMedian - 1) * 100 if baselineMedian > 0 else 0
+            pValue = _mann_whitney_p_value(baseline, current)
+            print(f'\n  {metric}: median {currentMedian:.4g}, baseline {baselineMedian:.4g} ({change:+.1f}%, p = {pValue:.3f})', end = '')
+
+            if change > args.threshold and pValue < 1 - args.confidence:
+                failures.append(f'{metric} regressed by {change:.1f}% on {gpuName} '
+                                f'(median {currentMedian:.4g} vs {baselineMedian:.4g}, p = {pValue:.3f})')
+
+        if failures:
+            raise self.failureException('\n'.join(failures))
+        if missing:
+            self.skipTest(f"No baselines for {', '.join(missing)} on {gpuName}, run with --update")
+
+
+class CompressionPerfTestCase(PerformanceTestCase):
+
+    def __str__(self):
+        return 'Compression performance'
+
+    def runTest(self):
+        ntcArgs = ntc.Arguments(
+            tool=self.tool,
+            loadImages=os.path.join(sourceDir, 'PavingStones070'),
+            compress=True,
+            bitsPerPixel=4.0,
+            stepsPerIteration=1000,
+            trainingSteps=10000,
+            randomSeed=1
+        )
+
+        def measure(result: ntc.Result):
+            # The first interval includes the warm-up of the training kernels
+            curve = result.compressionRuns[0].learningCurve[1:]
+            return {
+                'compressionMsPerStep': _median([msPerStep for step, msPerStep, psnr in curve]),
+                'compressionGpuBytes': result.gpuMemoryUsed,
+                'compressionHostBytes': result.hostMemoryPeak
+            }
+
+        self.checkSamples(*self.runRepeatedly(ntcArgs, measure))
+
+
+class DecompressionPerfTestCase(PerformanceTestCase):
+
+    def __init__(self, api: str, networkVersion: str) -> None:
+        super().__init__()
+        self.api = api
+        self.networkVersion = networkVersion
+
+    def __str__(self):
+        return f'Decompression performance ({self.api}, {self.networkVersion} network)'
+
+    def runTest(self):
+        if self.api == 'dx12' and os.name != 'nt':
+            self.skipTest('DX12 is only available on Windows')
+
+        ntcFileName = os.path.join(testFilesDir, f'PavingStones070_4bpp_{self.networkVersion}.ntc')
+        if not os.path.exists(ntcFileName):
+            self.skipTest(f"'{ntcFileName}' does not exist, run make_test_ntc_files.py")
+
+        isCuda = self.api == 'cuda'
+        ntcArgs = ntc.Arguments(
+            tool=self.tool,
+            loadCompressed=ntcFileName,
+            decompress=True,
+            graphicsApi='' if isCuda else self.api,
+            benchmark=None if isCuda else 20
+        )
+
+        prefix = f'decompression.{self.api}.{self.networkVersion}'
+        def measure(result: ntc.Result):
+            return {
+                f'{prefix}.gpuMs': result.decompressionTime,
+                f'{prefix}.hostBytes': result.hostMemoryPeak
+            }
+
+        self.checkSamples(*self.runRepeatedly(ntcArgs, measure))
+
+
+if __name__ == '__main__':
+    suite = unittest.TestSuite()
+    suite.addTest(CompressionPerfTestCase())
+    for api in ('cuda', 'vk', 'dx12'):
+        for networkVersion in ('small', 'medium', 'large', 'xlarge'):
+            suite.addTest(DecompressionPerfTestCase(api=api, networkVersion=networkVersion))
+
+    runner = unittest.TextTestRunner(verbosity=2)
+    testResult = runner.run(suite)
+
+    if args.update:
+        baselines.save()
+        print(f"Baselines saved into '{args.baselines}'.")
+
+    sys.exit(0 if testResult.wasSuccessful() else 1)
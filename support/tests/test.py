@@ -230,6 +230,130 @@ class CompressionTestCase(TestCase):
         self.compareOutputImages(sourceMaterialDir, decompressedDir, (33, 29, 39, 28, 35), toleranceDb=2.0)
 
 
+class BatchCompressionTestCase(TestCase):
+
+    def __str__(self):
+        return 'Batch Compression'
+    
+    def runTest(self):
+        materials = ('PavingStones070', 'MetalPlates013')
+        batchFileName = os.path.join(scratchDir, 'jobs.txt')
+        reportFileName = os.path.join(scratchDir, 'report.csv')
+
+        with open(batchFileName, 'w') as batchFile:
+            batchFile.write('# Test batch\n')
+            for material in materials:
+                ntcFileName = os.path.join(scratchDir, f'{material}.ntc')
+                batchFile.write(f'{os.path.join(sourceDir, material)}\t{ntcFileName}\n')
+
+        args = ntc.Arguments(
+            tool=self.tool,
+            batch=batchFileName,
+            batchReport=reportFileName,
+            compress=True,
+            decompress=True,
+            bitsPerPixel=4.0,
+            stepsPerIteration=1000,
+            trainingSteps=10000
+        )
+
+        ntc.run(args)
+
+        self.assertFileExists(reportFileName)
+        with open(reportFileName, 'r') as reportFile:
+            lines = reportFile.read().splitlines()
+        self.assertEqual(len(lines), len(materials) + 1) # header + one line per job
+        
+        for material, line in zip(materials, lines[1:]):
+            self.assertFileExists(os.path.join(scratchDir, f'{material}.ntc'))
+            fields = line.split(',')
+            self.assertEqual(fields[2], 'OK')
+            self.assertBetween(float(fields[8]), 25, 40)
+
+
+class CompressionCacheTestCase(TestCase):
+
+    def __str__(self):
+        return 'Compression Cache'
+    
+    def runTest(self):
+        sourceMaterialDir = os.path.join(sourceDir, 'PavingStones070')
+        cacheDir = os.path.join(scratchDir, 'cache')
+        ntcFileName = os.path.join(scratchDir, 'PavingStones070-cached.ntc')
+
+        args = ntc.Arguments(
+            tool=self.tool,
+            loadImages=sourceMaterialDir,
+            compress=True,
+            bitsPerPixel=4.0,
+            stepsPerIteration=1000,
+            trainingSteps=10000,
+            saveCompressed=ntcFileName,
+            cache=cacheDir
+        )
+
+        # The first run compresses the material and stores the result, the second one reuses it
+        firstResult = ntc.run(args)
+        self.assertFalse(firstResult.cacheHit)
+        self.assertIsNotNone(firstResult.compressionRuns)
+
+        secondResult = ntc.run(args)
+        self.assertTrue(secondResult.cacheHit)
+        self.assertIsNone(secondResult.compressionRuns)
+        self.assertEqual(firstResult.savedFileSize, secondResult.savedFileSize)
+
+        # Changing the settings must not reuse the cached result
+        args.trainingSteps = 5000
+        thirdResult = ntc.run(args)
+        self.assertFalse(thirdResult.cacheHit)
+
+
+class WarmStartTestCase(TestCase):
+
+    def __str__(self):
+        return 'Warm Start'
+    
+    def runTest(self):
+        sourceMaterialDir = os.path.join(sourceDir, 'PavingStones070')
+        ntcFileName = os.path.join(scratchDir, 'PavingStones070.ntc')
+        warmFileName = os.path.join(scratchDir, 'PavingStones070-warm.ntc')
+
+        args = ntc.Arguments(
+            tool=self.tool,
+            loadImages=sourceMaterialDir,
+            compress=True,
+            decompress=True,
+            bitsPerPixel=4.0,
+            stepsPerIteration=500,
+            trainingSteps=10000,
+            saveCompressed=ntcFileName
+        )
+
+        fullResult = ntc.run(args)
+
+        # Fine-tuning the result on the same images starts from its PSNR and runs 1/4 of the steps
+        args.warmStart = ntcFileName
+        args.saveCompressed = warmFileName
+        warmResult = ntc.run(args)
+
+        self.assertTrue(warmResult.warmStartRetained)
+        self.assertBetween(warmResult.warmStartPsnr, fullResult.overallPsnr - 1, fullResult.overallPsnr + 1)
+        self.assertEqual(len(warmResult.compressionRuns), 1)
+        learningCurve = warmResult.compressionRuns[0].learningCurve
+        self.assertEqual(len(learningCurve), args.trainingSteps / 4 / args.stepsPerIteration)
+        self.assertGreater(learningCurve[0][2], warmResult.warmStartPsnr - 5)
+        self.assertGreater(warmResult.overallPsnr, fullResult.overallPsnr - 1)
+
+        # A file with a different latent shape cannot be used, and the tool falls back to full training
+        args.bitsPerPixel = 2.0
+        fallbackResult = ntc.run(args)
+
+        self.assertIsNone(fallbackResult.warmStartPsnr)
+        self.assertEqual(len(fallbackResult.compressionRuns), 1)
+        self.assertEqual(len(fallbackResult.compressionRuns[0].learningCurve),
+            args.trainingSteps / args.stepsPerIteration)
+
+
 class HdrCompressionTestCase(TestCase):
 
     def __str__(self):
@@ -350,11 +474,71 @@ class DecompressionTestCase(TestCase):
         self.compareOutputImages(sourceMaterialDir, decompressedDir, expectedPsnr, toleranceDb=1.5, ignoreExtraChannels=not isCuda)
         
 
+class CpuAdapterDecompressionTestCase(TestCase):
+
+    def __init__(self, api: str) -> None:
+        super().__init__()
+        self.api = api
+
+    def __str__(self):
+        return f'Decompression on a software adapter ({self.api})'
+
+    def runTest(self):
+        if self.api == 'dx12' and os.name != 'nt':
+            self.skipTest('DX12 is only available on Windows')
+
+        ntcFileName = os.path.join(testFilesDir, 'PavingStones070_4bpp_medium.ntc')
+        gpuDir = os.path.join(scratchDir, 'gpu')
+        cpuDir = os.path.join(scratchDir, 'cpu')
+
+        # Use the same weight type and math on both adapters: software adapters have no CoopVec,
+        # and FP16 math would be compared with FP32 math where only one of the adapters supports it
+        def makeArgs(outputDir, cpuAdapter):
+            return ntc.Arguments(
+                tool=self.tool,
+                loadCompressed=ntcFileName,
+                decompress=True,
+                saveImages=outputDir,
+                imageFormat='tga',
+                bcFormat='none',
+                graphicsApi=self.api,
+                cpuAdapter=cpuAdapter,
+                noCoopVec=True,
+                noFloat16=True)
+
+        ntc.run(makeArgs(gpuDir, cpuAdapter=False))
+
+        try:
+            ntc.run(makeArgs(cpuDir, cpuAdapter=True))
+        except RuntimeError as e:
+            stderr = e.args[3]
+            if 'Cannot find a software' in stderr or 'not supported on the software adapter' in stderr:
+                self.skipTest(stderr.strip())
+            raise
+
+        # Both adapters run the same shaders, so the outputs may only differ by rounding
+        for name in ('AmbientOcclusion', 'Color', 'Displacement', 'NormalDX', 'Roughness'):
+            gpuImageFileName = os.path.join(gpuDir, f'{name}.tga')
+            cpuImageFileName = os.path.join(cpuDir, f'{name}.tga')
+            self.assertFileExists(gpuImageFileName)
+            self.assertFileExists(cpuImageFileName)
+
+            gpuImage = _loadPillowImage(gpuImageFileName)
+            cpuImage = _loadPillowImage(cpuImageFileName)
+            self.assertEqual(gpuImage.shape, cpuImage.shape)
+            
+            maxDifference = numpy.max(numpy.abs(gpuImage - cpuImage))
+            self.assertLessEqual(maxDifference, 2, f'{name}: the outputs differ by up to {maxDifference} steps')
+
+
 if __name__ == '__main__':
     suite = unittest.TestSuite()
     # Describe should go first because it also queries the GPU capabilities
     suite.addTest(DescribeTestCase())
     suite.addTest(CompressionTestCase())
+    suite.addTest(BatchCompressionTestCase())
+    suite.addTest(CompressionCacheTestCase())
+    suite.addTest(WarmStartTestCase())
     suite.addTest(HdrCompressionTestCase())
 
     for api in ('cuda', 'vk', 'dx12'):
@@ -365,5 +549,8 @@ if __name__ == '__main__':
                 for featureLevel in (FL_LEGACY, FL_DP4A, FL_FP16, FL_COOPVEC_INT8, FL_COOPVEC_FP8):
                     suite.addTest(DecompressionTestCase(api=api, networkVersion=networkVersion, featureLevel=featureLevel))
 
+    for api in ('vk', 'dx12'):
+        suite.addTest(CpuAdapterDecompressionTestCase(api=api))
+
     runner = unittest.TextTestRunner(verbosity=2)
     runner.run(suite)
@@ -56,6 +56,7 @@ parser.add_argument('--curve', action = 'store_true', help = 'Record the PSNR cu
 parser.add_argument('--trainingSteps', type = int, default = 100000, help = 'Total number of training steps.')
 parser.add_argument('--stepsPerIteration', type = int, default = 1000, help = 'Number of training steps between each PSNR measurement.')
 parser.add_argument('--devices', nargs = '*', default = [0], type = int, help = 'List of CUDA devices to use')
+parser.add_argument('--cancelBelowPsnr', type = float, help = 'Cancel the experiments whose PSNR is below this value halfway through training.')
 parser.add_argument('--output', help = 'Path to the output CSV file')
 args = parser.parse_args()
 
@@ -172,14 +173,30 @@ def task_ready(task, result: ntc.Result, originalTaskCount: int, completedTaskCo
         print(f'\rDone: {completedTaskCount} / {originalTaskCount}, ETA: {etaString}', end = '', flush = True)
 
 
+cancelledTasks = []
+
+def task_event(task, event: dict, device: int):
+    if args.cancelBelowPsnr is None or event['event'] != 'trainingStep':
+        return True
+    if event['step'] * 2 < event['totalSteps'] or event['psnr'] >= args.cancelBelowPsnr:
+        return True
+
+    ntcArgs, shortDirname, experimentName = task
+    print(f'\nCancelled {shortDirname} {experimentName}: {event["psnr"]:.2f} dB after {event["step"]} steps', file = sys.stderr)
+    cancelledTasks.append(task)
+    return False
+
+
 if args.output is not None:
     print('Starting tests...', end = '', flush = True)
 
-terminated = ntc.process_concurrent_tasks(tasks, args.devices, task_ready)
+terminated = ntc.process_concurrent_tasks(tasks, args.devices, task_ready, task_event)
 
 if args.output is not None:
     outputFile.close()
     print('')
+    if cancelledTasks:
+        print(f'{len(cancelledTasks)} experiment(s) cancelled below {args.cancelBelowPsnr} dB.')
     if terminated:
         print('Test aborted.')
         sys.exit(2)
@@ -0,0 +1,194 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "CompressionCache.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+void CacheKeyBuilder::AddString(std::string const& s)
+{
+    AddValue(uint64_t(s.size()));
+    AddBytes(s.data(), s.size());
+}
+
+bool CacheKeyBuilder::AddFileContents(char const* fileName)
+{
+    FILE* file = fopen(fileName, "rb");
+    if (!file)
+        return false;
+
+    std::vector<uint8_t> buffer(1 << 20);
+    uint64_t totalSize = 0;
+    while (size_t const bytesRead = fread(buffer.data(), 1, buffer.size(), file))
+    {
+        AddBytes(buffer.data(), bytesRead);
+        totalSize += bytesRead;
+    }
+
+    bool const success = !ferror(file);
+    fclose(file);
+
+    AddValue(totalSize);
+    return success;
+}
+
+std::string CacheKeyBuilder::GetKey() const
+{
+    char key[17];
+    snprintf(key, sizeof(key), "%016" PRIx64, m_hash.Get());
+    return key;
+}
+
+CompressionCache::CompressionCache(std::string const& directory, uint64_t sizeLimit)
+    : m_directory(directory)
+    , m_sizeLimit(sizeLimit)
+{ }
+
+bool CompressionCache::Init()
+{
+    std::error_code ec;
+    if (!fs::is_directory(m_directory) && !fs::create_directories(m_directory, ec))
+    {
+        fprintf(stderr, "Failed to create the cache directory '%s'.\n", m_directory.c_str());
+        return false;
+    }
+
+    std::lock_guard lockGuard(m_mutex);
+    Trim(std::string());
+    return true;
+}
+
+std::string CompressionCache::GetEntryFileName(std::string const& key) const
+{
+    return (fs::path(m_directory) / (key + ".ntc")).generic_string();
+}
+
+bool CompressionCache::Lookup(std::string const& key, std::string& outFileName)
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    std::string const fileName = GetEntryFileName(key);
+    std::error_code ec;
+    if (!fs::is_regular_file(fileName, ec))
+    {
+        ++m_missCount;
+        return false;
+    }
+
+    // Refresh the access time so that the entry is trimmed last
+    fs::last_write_time(fileName, fs::file_time_type::clock::now(), ec);
+
+    outFileName = fileName;
+    return true;
+}
+
+void CompressionCache::RecordLoadResult(bool loaded)
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    if (loaded)
+        ++m_hitCount;
+    else
+        ++m_missCount;
+}
+
+void CompressionCache::Store(std::string const& key, char const* fileName)
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    // Copy into a temporary file first and rename it, so that an interrupted copy never looks like a valid entry
+    std::string const entryFileName = GetEntryFileName(key);
+    std::string const tempFileName = entryFileName + ".tmp" + std::to_string(++m_tempFileCounter);
+
+    std::error_code ec;
+    fs::copy_file(fileName, tempFileName, fs::copy_options::overwrite_existing, ec);
+    if (!ec)
+        fs::rename(tempFileName, entryFileName, ec);
+
+    if (ec)
+    {
+        printf("Warning: Failed to store '%s' in the compression cache: %s\n", fileName, ec.message().c_str());
+        fs::remove(tempFileName, ec);
+        return;
+    }
+
+    Trim(key);
+}
+
+void CompressionCache::Trim(std::string const& keepKey)
+{
+    if (m_sizeLimit == 0)
+        return;
+
+    struct Entry
+    {
+        fs::path path;
+        fs::file_time_type lastUsed;
+        uint64_t size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+    std::error_code ec;
+    for (fs::directory_entry const& dirEntry : fs::directory_iterator(m_directory, ec))
+    {
+        if (!dirEntry.is_regular_file(ec) || dirEntry.path().extension() != ".ntc")
+            continue;
+
+        Entry entry;
+        entry.path = dirEntry.path();
+        entry.lastUsed = dirEntry.last_write_time(ec);
+        entry.size = dirEntry.file_size(ec);
+        if (ec)
+            continue;
+
+        totalSize += entry.size;
+        entries.push_back(entry);
+    }
+
+    if (totalSize <= m_sizeLimit)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b)
+        { return a.lastUsed < b.lastUsed; });
+
+    std::string const keepFileName = keepKey.empty() ? std::string() : keepKey + ".ntc";
+    for (Entry const& entry : entries)
+    {
+        if (totalSize <= m_sizeLimit)
+            break;
+
+        // Never remove the entry that was just stored, even if it alone exceeds the limit
+        if (entry.path.filename() == keepFileName)
+            continue;
+
+        if (fs::remove(entry.path, ec))
+            totalSize -= entry.size;
+    }
+}
+
+int CompressionCache::GetHitCount()
+{
+    std::lock_guard lockGuard(m_mutex);
+    return m_hitCount;
+}
+
+int CompressionCache::GetMissCount()
+{
+    std::lock_guard lockGuard(m_mutex);
+    return m_missCount;
+}
@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <ntc-utils/Hash.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Accumulates a 64-bit FNV-1a hash over all inputs that affect a compression result.
+class CacheKeyBuilder
+{
+public:
+    void AddBytes(void const* data, size_t size) { m_hash.AddBytes(data, size); }
+
+    template<typename T>
+    void AddValue(T const& value) { m_hash.AddValue(value); }
+
+    // Strings are length-prefixed so that adjacent strings can't produce the same byte sequence.
+    void AddString(std::string const& s);
+
+    bool AddFileContents(char const* fileName);
+
+    std::string GetKey() const;
+
+private:
+    Fnv1aHash m_hash;
+};
+
+// Directory-backed store of compressed texture sets addressed by CacheKeyBuilder keys.
+// Each entry is a <key>.ntc file, and the file modification time is used as the last access time
+// for trimming the least recently used entries when the total size exceeds the limit.
+// All methods are thread-safe.
+class CompressionCache
+{
+public:
+    // A zero size limit means the cache is never trimmed.
+    CompressionCache(std::string const& directory, uint64_t sizeLimit);
+
+    bool Init();
+
+    // Returns true and the name of the cached file if an entry with the key exists,
+    // and marks that entry as recently used. Counts a miss if it doesn't exist. A found entry is not
+    // counted until the caller reports whether it could be loaded with RecordLoadResult.
+    bool Lookup(std::string const& key, std::string& outFileName);
+
+    // Counts a found entry as a hit if it was loaded, or as a miss if it was damaged or has disappeared.
+    void RecordLoadResult(bool loaded);
+
+    // Copies the file into the cache under the key and trims the cache if necessary.
+    // Failures to store are reported as warnings because the compression result itself is valid.
+    void Store(std::string const& key, char const* fileName);
+
+    int GetHitCount();
+    int GetMissCount();
+
+private:
+    std::string GetEntryFileName(std::string const& key) const;
+    void Trim(std::string const& keepKey);
+
+    std::mutex m_mutex;
+    std::string m_directory;
+    uint64_t m_sizeLimit;
+    int m_hitCount = 0;
+    int m_missCount = 0;
+    int m_tempFileCounter = 0;
+};
@@ -0,0 +1,503 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "DecompressionBenchmark.h"
+#include "GraphicsPasses.h"
+#include "Utils.h"
+#include <ntc-utils/CompressedFileStream.h>
+#include <ntc-utils/DeviceUtils.h>
+#include <ntc-utils/GraphicsBlockCompressionPass.h>
+#include <ntc-utils/GraphicsDecompressionPass.h>
+#include <nvrhi/utils.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // One context configuration and the weight types measured with it
+    struct MathVersion
+    {
+        bool dp4a = false;
+        bool float16 = false;
+        bool coopVec = false;
+        std::vector<ntc::InferenceWeightType> weightTypes;
+    };
+
+    struct TimingStatistics
+    {
+        bool valid = false;
+        double medianMs = 0;
+        double p95Ms = 0;
+        double minMs = 0;
+        double gpixelsPerSecond = 0; // From the median time
+    };
+
+    struct TextureResult
+    {
+        std::string name;
+        ntc::BlockCompressedFormat bcFormat = ntc::BlockCompressedFormat::None;
+        TimingStatistics decompress;
+        TimingStatistics decompressAndEncode; // Only for the textures with a BCn format
+    };
+
+    struct MipResult
+    {
+        int width = 0;
+        int height = 0;
+        TimingStatistics allTextures;
+        std::vector<TextureResult> textures;
+    };
+
+    struct ConfigurationResult
+    {
+        ntc::InferenceWeightType weightType = ntc::InferenceWeightType::Unknown;
+        bool dp4a = false;
+        bool float16 = false;
+        bool skipped = false; // The weight type is not supported by the texture set or the device
+        std::vector<MipResult> mips;
+    };
+
+    char const* GetWeightTypeName(ntc::InferenceWeightType weightType)
+    {
+        switch (weightType)
+        {
+        case ntc::InferenceWeightType::GenericInt8: return "GenericInt8";
+        case ntc::InferenceWeightType::GenericFP8: return "GenericFP8";
+        case ntc::InferenceWeightType::CoopVecInt8: return "CoopVecInt8";
+        case ntc::InferenceWeightType::CoopVecFP8: return "CoopVecFP8";
+        default: return "Unknown";
+        }
+    }
+
+    std::string EscapeJsonString(std::string const& s)
+    {
+        std::string result;
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+            {
+                result += '\\';
+                result += c;
+            }
+            else if (uint8_t(c) < 0x20)
+            {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", uint32_t(uint8_t(c)));
+                result += escape;
+            }
+            else
+                result += c;
+        }
+        return result;
+    }
+
+    TimingStatistics GetTimingStatistics(std::vector<float>& times, int pixels)
+    {
+        TimingStatistics stats;
+        if (times.empty())
+            return stats;
+
+        std::sort(times.begin(), times.end());
+        stats.valid = true;
+        stats.medianMs = times[times.size() / 2] * 1e3;
+        stats.p95Ms = times[std::min(times.size() - 1, size_t(std::ceil(double(times.size()) * 0.95)) - 1)] * 1e3;
+        stats.minMs = times.front() * 1e3;
+        stats.gpixelsPerSecond = stats.medianMs > 0 ? double(pixels) / (stats.medianMs * 1e-3) * 1e-9 : 0;
+        return stats;
+    }
+
+    void WriteJsonStatistics(FILE* file, char const* name, TimingStatistics const& stats)
+    {
+        fprintf(file, "\"%s\": { \"medianMs\": %.6f, \"p95Ms\": %.6f, \"minMs\": %.6f, \"gpixelsPerSecond\": %.4f }",
+            name, stats.medianMs, stats.p95Ms, stats.minMs, stats.gpixelsPerSecond);
+    }
+
+    // Records the passes into separate submissions, waits for each of them, and returns the GPU times
+    // of the submissions after the warm-up ones.
+    bool MeasurePasses(nvrhi::IDevice* device, nvrhi::ICommandList* commandList, nvrhi::ITimerQuery* timerQuery,
+        DecompressionBenchmarkSettings const& settings, std::function<bool(nvrhi::ICommandList*)> const& recordPasses,
+        std::vector<float>& outTimes)
+    {
+        outTimes.clear();
+        for (int iteration = 0; iteration < settings.warmupIterations + settings.iterations; ++iteration)
+        {
+            commandList->open();
+            commandList->beginTimerQuery(timerQuery);
+            bool const success = recordPasses(commandList);
+            commandList->endTimerQuery(timerQuery);
+            commandList->close();
+
+            if (!success)
+                return false;
+
+            device->executeCommandList(commandList);
+            device->waitForIdle();
+            device->runGarbageCollection();
+
+            if (iteration >= settings.warmupIterations)
+                outTimes.push_back(device->getTimerQueryTime(timerQuery));
+        }
+        return true;
+    }
+
+    bool BenchmarkWeightType(ntc::IContext* context, ntc::ITextureSetMetadata* metadata, nvrhi::IDevice* device,
+        nvrhi::ICommandList* commandList, nvrhi::ITimerQuery* timerQuery, GraphicsDecompressionPass& gdp,
+        GraphicsBlockCompressionPass& blockCompressionPass, GraphicsResourcesForTextureSet const& graphicsResources,
+        ntc::StreamRange streamRange, DecompressionBenchmarkSettings const& settings, ConfigurationResult& result)
+    {
+        commandList->open();
+        bool const weightsSet = gdp.SetWeightsFromTextureSet(commandList, metadata, result.weightType);
+        commandList->close();
+        if (!weightsSet)
+        {
+            fprintf(stderr, "GraphicsDecompressionPass::SetWeightsFromTextureSet failed.\n");
+            return false;
+        }
+        device->executeCommandList(commandList);
+
+        ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
+        int const numTextures = int(graphicsResources.perTexture.size());
+        std::vector<float> times;
+
+        for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+        {
+            MipResult& mipResult = result.mips.emplace_back();
+            mipResult.width = std::max(textureSetDesc.width >> mipLevel, 1);
+            mipResult.height = std::max(textureSetDesc.height >> mipLevel, 1);
+            int const mipPixels = mipResult.width * mipResult.height;
+
+            ntc::MakeDecompressionComputePassParameters params;
+            params.textureSetMetadata = metadata;
+            params.latentStreamRange = streamRange;
+            params.mipLevel = mipLevel;
+            params.firstOutputDescriptorIndex = mipLevel * numTextures;
+            params.weightType = result.weightType;
+            ntc::ComputePassDesc allTexturesPass{};
+            ntc::Status ntcStatus = context->MakeDecompressionComputePass(params, &allTexturesPass);
+            CHECK_NTC_RESULT("MakeDecompressionComputePass");
+
+            if (!MeasurePasses(device, commandList, timerQuery, settings,
+                [&](nvrhi::ICommandList* passCommandList)
+                { return gdp.ExecuteComputePass(passCommandList, allTexturesPass); },
+                times))
+                return false;
+            mipResult.allTextures = GetTimingStatistics(times, mipPixels);
+
+            for (int textureIndex = 0; textureIndex < numTextures; ++textureIndex)
+            {
+                ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(textureIndex);
+                GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[textureIndex];
+                TextureResult& textureResult = mipResult.textures.emplace_back();
+                textureResult.name = textureMetadata->GetName();
+                textureResult.bcFormat = textureMetadata->GetBlockCompressedFormat();
+
+                // The descriptors for all textures are already in the table, use the one for this texture only
+                ntc::OutputTextureDesc outputDesc;
+                textureMetadata->GetChannels(outputDesc.firstChannel, outputDesc.numChannels);
+                outputDesc.descriptorIndex = mipLevel * numTextures + textureIndex;
+                outputDesc.rgbColorSpace = textureMetadata->GetRgbColorSpace();
+
+                params.firstOutputDescriptorIndex = 0;
+                params.pOutputTextures = &outputDesc;
+                params.numOutputTextures = 1;
+                ntc::ComputePassDesc texturePass{};
+                ntcStatus = context->MakeDecompressionComputePass(params, &texturePass);
+                CHECK_NTC_RESULT("MakeDecompressionComputePass");
+
+                if (!MeasurePasses(device, commandList, timerQuery, settings,
+                    [&](nvrhi::ICommandList* passCommandList)
+                    { return gdp.ExecuteComputePass(passCommandList, texturePass); },
+                    times))
+                    return false;
+                textureResult.decompress = GetTimingStatistics(times, mipPixels);
+
+                if (textureResult.bcFormat == ntc::BlockCompressedFormat::None)
+                    continue;
+
+                ntc::MakeBlockCompressionComputePassParameters bcParams;
+                bcParams.srcRect.width = mipResult.width;
+                bcParams.srcRect.height = mipResult.height;
+                bcParams.dstFormat = textureResult.bcFormat;
+                bcParams.alphaThreshold = 1.f / 255.f;
+                bcParams.texture = textureMetadata;
+                bcParams.quality = textureMetadata->GetBlockCompressionQuality();
+                ntc::ComputePassDesc blockCompressionComputePass{};
+                ntcStatus = context->MakeBlockCompressionComputePass(bcParams, &blockCompressionComputePass);
+                CHECK_NTC_RESULT("MakeBlockCompressionComputePass");
+
+                if (!MeasurePasses(device, commandList, timerQuery, settings,
+                    [&](nvrhi::ICommandList* passCommandList)
+                    {
+                        return gdp.ExecuteComputePass(passCommandList, texturePass) &&
+                            blockCompressionPass.ExecuteComputePass(passCommandList, blockCompressionComputePass,
+                                textureResources.color, nvrhi::Format::UNKNOWN, mipLevel,
+                                textureResources.blocks, 0, nullptr);
+                    },
+                    times))
+                    return false;
+                textureResult.decompressAndEncode = GetTimingStatistics(times, mipPixels);
+            }
+        }
+
+        return true;
+    }
+
+    bool WriteResultsJson(FILE* file, char const* inputFileName, nvrhi::IDevice* device,
+        ntc::TextureSetDesc const& desc, int networkVersion, DecompressionBenchmarkSettings const& settings,
+        std::vector<ConfigurationResult> const& results)
+    {
+        fprintf(file, "{\n");
+        fprintf(file, "  \"file\": \"%s\",\n", EscapeJsonString(inputFileName).c_str());
+        fprintf(file, "  \"graphicsApi\": \"%s\",\n", nvrhi::utils::GraphicsAPIToString(device->getGraphicsAPI()));
+        fprintf(file, "  \"adapter\": \"%s\",\n", EscapeJsonString(GetAdapterIdentifier(device)).c_str());
+        fprintf(file, "  \"networkVersion\": \"%s\",\n", ntc::NetworkVersionToString(networkVersion));
+        fprintf(file, "  \"width\": %d,\n  \"height\": %d,\n  \"mips\": %d,\n", desc.width, desc.height, desc.mips);
+        fprintf(file, "  \"warmupIterations\": %d,\n  \"iterations\": %d,\n",
+            settings.warmupIterations, settings.iterations);
+        fprintf(file, "  \"configurations\": [\n");
+
+        for (size_t resultIndex = 0; resultIndex < results.size(); ++resultIndex)
+        {
+            ConfigurationResult const& result = results[resultIndex];
+            double totalMs = 0;
+            for (MipResult const& mip : result.mips)
+                totalMs += mip.allTextures.medianMs;
+
+            fprintf(file, "    {\n");
+            fprintf(file, "      \"weightType\": \"%s\",\n", GetWeightTypeName(result.weightType));
+            fprintf(file, "      \"dp4a\": %s,\n", result.dp4a ? "true" : "false");
+            fprintf(file, "      \"float16\": %s,\n", result.float16 ? "true" : "false");
+            if (result.skipped)
+            {
+                fprintf(file, "      \"skipped\": true\n    }%s\n", resultIndex + 1 < results.size() ? "," : "");
+                continue;
+            }
+            fprintf(file, "      \"mipChainMedianMs\": %.6f,\n", totalMs);
+            fprintf(file, "      \"mips\": [\n");
+
+            for (size_t mipLevel = 0; mipLevel < result.mips.size(); ++mipLevel)
+            {
+                MipResult const& mip = result.mips[mipLevel];
+                fprintf(file, "        {\n");
+                fprintf(file, "          \"mip\": %zu, \"width\": %d, \"height\": %d,\n",
+                    mipLevel, mip.width, mip.height);
+                fprintf(file, "          ");
+                WriteJsonStatistics(file, "allTextures", mip.allTextures);
+                fprintf(file, ",\n          \"textures\": [\n");
+
+                for (size_t textureIndex = 0; textureIndex < mip.textures.size(); ++textureIndex)
+                {
+                    TextureResult const& texture = mip.textures[textureIndex];
+                    fprintf(file, "            { \"name\": \"%s\", \"bcFormat\": \"%s\", ",
+                        EscapeJsonString(texture.name).c_str(), ntc::BlockCompressedFormatToString(texture.bcFormat));
+                    WriteJsonStatistics(file, "decompress", texture.decompress);
+                    if (texture.decompressAndEncode.valid)
+                    {
+                        fprintf(file, ", ");
+                        WriteJsonStatistics(file, "decompressAndEncode", texture.decompressAndEncode);
+                    }
+                    fprintf(file, " }%s\n", textureIndex + 1 < mip.textures.size() ? "," : "");
+                }
+
+                fprintf(file, "          ]\n        }%s\n", mipLevel + 1 < result.mips.size() ? "," : "");
+            }
+
+            fprintf(file, "      ]\n    }%s\n", resultIndex + 1 < results.size() ? "," : "");
+        }
+
+        fprintf(file, "  ]\n}\n");
+        return !ferror(file);
+    }
+}
+
+bool RunDecompressionBenchmark(
+    ntc::ContextParameters const& contextParams,
+    nvrhi::IDevice* device,
+    nvrhi::ICommandList* commandList,
+    nvrhi::ITimerQuery* timerQuery,
+    char const* inputFileName,
+    char const* outputFileName,
+    DecompressionBenchmarkSettings const& settings)
+{
+    // The generic weights are measured with every combination of the enabled math features,
+    // and the CoopVec weights once, with all features enabled. DP4a and FP16 are selected by the context.
+    std::vector<MathVersion> mathVersions;
+    for (int dp4a = contextParams.graphicsDeviceSupportsDP4a ? 1 : 0; dp4a >= 0; --dp4a)
+    {
+        for (int float16 = contextParams.graphicsDeviceSupportsFloat16 ? 1 : 0; float16 >= 0; --float16)
+        {
+            MathVersion& version = mathVersions.emplace_back();
+            version.dp4a = dp4a != 0;
+            version.float16 = float16 != 0;
+            version.weightTypes = { ntc::InferenceWeightType::GenericInt8, ntc::InferenceWeightType::GenericFP8 };
+        }
+    }
+    if (contextParams.enableCooperativeVectorInt8 || contextParams.enableCooperativeVectorFP8)
+    {
+        MathVersion& version = mathVersions.emplace_back();
+        version.dp4a = contextParams.graphicsDeviceSupportsDP4a;
+        version.float16 = contextParams.graphicsDeviceSupportsFloat16;
+        version.coopVec = true;
+        version.weightTypes = { ntc::InferenceWeightType::CoopVecInt8, ntc::InferenceWeightType::CoopVecFP8 };
+    }
+
+    std::vector<ConfigurationResult> results;
+    ntc::TextureSetDesc textureSetDesc{};
+    int networkVersion = NTC_NETWORK_UNKNOWN;
+
+    for (MathVersion const& version : mathVersions)
+    {
+        ntc::ContextParameters versionParams = contextParams;
+        versionParams.graphicsDeviceSupportsDP4a = version.dp4a;
+        versionParams.graphicsDeviceSupportsFloat16 = version.float16;
+        versionParams.enableCooperativeVectorInt8 = version.coopVec && contextParams.enableCooperativeVectorInt8;
+        versionParams.enableCooperativeVectorFP8 = version.coopVec && contextParams.enableCooperativeVectorFP8;
+
+        ntc::ContextWrapper context;
+        ntc::Status ntcStatus = ntc::CreateContext(context.ptr(), versionParams);
+        if (ntcStatus != ntc::Status::Ok && ntcStatus != ntc::Status::CudaUnavailable)
+        {
+            fprintf(stderr, "Failed to create an NTC context, code = %s: %s\n",
+                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
+
+        std::string openError;
+        std::unique_ptr<ntc::IStream> inputFile = OpenTextureSetFile(inputFileName, &openError);
+        if (!inputFile)
+        {
+            fprintf(stderr, "Failed to open input file '%s': %s\n", inputFileName, openError.c_str());
+            return false;
+        }
+
+        ntc::TextureSetMetadataWrapper metadata(context);
+        ntcStatus = context->CreateTextureSetMetadataFromStream(inputFile.get(), metadata.ptr());
+        CHECK_NTC_RESULT("CreateTextureSetMetadataFromStream");
+
+        textureSetDesc = metadata->GetDesc();
+        networkVersion = metadata->GetNetworkVersion();
+
+        // Types that can't run with this context, such as GenericFP8 on most devices, are listed as skipped
+        std::vector<ntc::InferenceWeightType> weightTypes;
+        for (ntc::InferenceWeightType weightType : version.weightTypes)
+        {
+            if (metadata->IsInferenceWeightTypeSupported(weightType))
+            {
+                weightTypes.push_back(weightType);
+                continue;
+            }
+
+            ConfigurationResult& result = results.emplace_back();
+            result.weightType = weightType;
+            result.dp4a = version.dp4a;
+            result.float16 = version.float16;
+            result.skipped = true;
+            printf("%s weights, DP4a [%c], FP16 [%c]: skipped, not supported by the texture set or the device\n",
+                GetWeightTypeName(weightType), version.dp4a ? 'Y' : 'N', version.float16 ? 'Y' : 'N');
+        }
+
+        if (weightTypes.empty())
+            continue;
+
+        // Resources that refer to the context are declared after it, so that they are released first
+        GraphicsResourcesForTextureSet graphicsResources;
+        if (!CreateGraphicsResourcesFromMetadata(context, device, metadata, textureSetDesc.mips, false,
+            graphicsResources))
+            return false;
+
+        GraphicsDecompressionPass gdp(device, NTC_MAX_CHANNELS * NTC_MAX_MIPS);
+        GraphicsBlockCompressionPass blockCompressionPass(device, false, 2);
+        if (!gdp.Init() || !blockCompressionPass.Init())
+        {
+            fprintf(stderr, "Failed to initialize the graphics passes.\n");
+            return false;
+        }
+
+        ntc::StreamRange streamRange;
+        ntcStatus = metadata->GetStreamRangeForLatents(0, textureSetDesc.mips, streamRange);
+        CHECK_NTC_RESULT("GetStreamRangeForLatents");
+
+        int const numTextures = int(graphicsResources.perTexture.size());
+        for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+        {
+            for (int index = 0; index < numTextures; ++index)
+            {
+                gdp.WriteDescriptor(nvrhi::BindingSetItem::Texture_UAV(
+                    mipLevel * numTextures + index,
+                    graphicsResources.perTexture[index].color,
+                    nvrhi::Format::UNKNOWN,
+                    nvrhi::TextureSubresourceSet(mipLevel, 1, 0, 1)));
+            }
+        }
+
+        commandList->open();
+        bool const uploaded = gdp.SetInputData(commandList, inputFile.get(), streamRange);
+        commandList->close();
+        if (!uploaded)
+        {
+            fprintf(stderr, "GraphicsDecompressionPass::SetInputData failed.\n");
+            return false;
+        }
+        device->executeCommandList(commandList);
+
+        for (ntc::InferenceWeightType weightType : weightTypes)
+        {
+            ConfigurationResult& result = results.emplace_back();
+            result.weightType = weightType;
+            result.dp4a = version.dp4a;
+            result.float16 = version.float16;
+
+            if (!BenchmarkWeightType(context, metadata, device, commandList, timerQuery, gdp, blockCompressionPass,
+                graphicsResources, streamRange, settings, result))
+                return false;
+
+            double totalMs = 0;
+            for (MipResult const& mip : result.mips)
+                totalMs += mip.allTextures.medianMs;
+            printf("%s weights, DP4a [%c], FP16 [%c]: %.3f ms for all %d mips (median)\n",
+                GetWeightTypeName(weightType), version.dp4a ? 'Y' : 'N', version.float16 ? 'Y' : 'N',
+                totalMs, textureSetDesc.mips);
+        }
+    }
+
+    if (std::all_of(results.begin(), results.end(), [](ConfigurationResult const& result) { return result.skipped; }))
+    {
+        fprintf(stderr, "The texture set does not provide any weights compatible with the current device.\n");
+        return false;
+    }
+
+    FILE* file = fopen(outputFileName, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Cannot open '%s' for writing: %s\n", outputFileName, strerror(errno));
+        return false;
+    }
+
+    bool const success = WriteResultsJson(file, inputFileName, device, textureSetDesc, networkVersion, settings,
+        results);
+    fclose(file);
+
+    if (!success)
+    {
+        fprintf(stderr, "Failed to write '%s'.\n", outputFileName);
+        return false;
+    }
+
+    printf("Benchmark results saved to '%s'.\n", outputFileName);
+    return true;
+}
@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <libntc/ntc.h>
+
+struct DecompressionBenchmarkSettings
+{
+    int warmupIterations = 3; // Submissions per measurement that are not timed
+    int iterations = 20;      // Timed submissions per measurement
+};
+
+// Times the graphics API decompression of the texture set in 'inputFileName' for every math version that
+// the device supports: the generic weight types with all available combinations of DP4a and FP16, and the
+// CoopVec weight types. Every measurement covers one mip level of one texture, or all textures of the mip,
+// with and without BCn encoding. The statistics are written into 'outputFileName' as JSON.
+// 'contextParams' describe the graphics device and the math features allowed on the command line,
+// a separate context is created for every combination.
+bool RunDecompressionBenchmark(
+    ntc::ContextParameters const& contextParams,
+    nvrhi::IDevice* device,
+    nvrhi::ICommandList* commandList,
+    nvrhi::ITimerQuery* timerQuery,
+    char const* inputFileName,
+    char const* outputFileName,
+    DecompressionBenchmarkSettings const& settings);
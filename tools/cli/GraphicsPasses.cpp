@@ -11,6 +11,7 @@
  */
 
 #include "GraphicsPasses.h"
+#include "Telemetry.h"
 #include "Utils.h"
 #include <ntc-utils/GraphicsDecompressionPass.h>
 #include <ntc-utils/GraphicsImageDifferencePass.h>
@@ -19,27 +20,110 @@
 #include <tinyexr.h>
 #include <filesystem>
 #include <donut/core/log.h>
+#include <algorithm>
+#include <array>
 #include <numeric>
 #include <memory>
 #include <mutex>
 
 namespace fs = std::filesystem;
 
-bool CreateGraphicsResourcesFromMetadata(
+static void GetColorTextureFormat(ntc::ChannelFormat channelFormat, nvrhi::Format& outColorFormat,
+    ntc::ChannelFormat& outSharedFormat)
+{
+    switch (channelFormat)
+    {
+        case ntc::ChannelFormat::UNORM8:
+            outColorFormat = nvrhi::Format::RGBA8_UNORM;
+            outSharedFormat = ntc::ChannelFormat::UNORM8;
+            break;
+        case ntc::ChannelFormat::UNORM16:
+            // Note: graphics passes don't support saving 16-bit PNGs at this time, so cast to u8
+            outColorFormat = nvrhi::Format::RGBA8_UNORM;
+            outSharedFormat = ntc::ChannelFormat::UNORM8;
+            break;
+        case ntc::ChannelFormat::FLOAT16:
+        case ntc::ChannelFormat::FLOAT32:
+            outColorFormat = nvrhi::Format::RGBA32_FLOAT;
+            outSharedFormat = ntc::ChannelFormat::FLOAT32;
+            break;
+        case ntc::ChannelFormat::UINT32:
+            outColorFormat = nvrhi::Format::R32_UINT;
+            outSharedFormat = ntc::ChannelFormat::UINT32;
+            break;
+        default:
+            outColorFormat = nvrhi::Format::UNKNOWN;
+            outSharedFormat = ntc::ChannelFormat::UNKNOWN;
+            break;
+    }
+}
+
+bool AreGraphicsResourcesCompatible(
+    ntc::ITextureSetMetadata* metadata,
+    int mipLevels,
+    bool enableCudaSharing,
+    GraphicsResourcesForTextureSet const& resources)
+{
+    int const numTextures = metadata->GetTextureCount();
+    if (int(resources.perTexture.size()) != numTextures || !resources.accelerationBuffer)
+        return false;
+
+    ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
+
+    for (int i = 0; i < numTextures; ++i)
+    {
+        ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(i);
+        GraphicsResourcesForTexture const& textureResources = resources.perTexture[i];
+        if (!textureResources.color)
+            return false;
+
+        nvrhi::Format colorFormat = nvrhi::Format::UNKNOWN;
+        ntc::ChannelFormat sharedFormat = ntc::ChannelFormat::UNKNOWN;
+        GetColorTextureFormat(textureMetadata->GetChannelFormat(), colorFormat, sharedFormat);
+
+        nvrhi::TextureDesc const& colorDesc = textureResources.color->getDesc();
+        if (colorDesc.width != uint32_t(textureSetDesc.width) ||
+            colorDesc.height != uint32_t(textureSetDesc.height) ||
+            colorDesc.mipLevels != uint32_t(mipLevels) ||
+            colorDesc.format != colorFormat)
+            return false;
+
+        if (enableCudaSharing != bool(textureResources.sharedTexture.Get()))
+            return false;
+
+        ntc::BlockCompressedFormat const bcFormat = textureMetadata->GetBlockCompressedFormat();
+        if (bcFormat == ntc::BlockCompressedFormat::None)
+        {
+            if (textureResources.bc)
+                return false;
+        }
+        else
+        {
+            if (!textureResources.bc || textureResources.bc->getDesc().format != GetBcFormatDefinition(bcFormat)->nvrhiFormat)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static bool CreateGraphicsResources(
     ntc::IContext* context,
     nvrhi::IDevice* device,
     ntc::ITextureSetMetadata* metadata,
+    int width,
+    int height,
     int mipLevels,
+    GraphicsDecompressionRegion const* region,
     bool enableCudaSharing,
     GraphicsResourcesForTextureSet& resources)
 {
     int const maxImageDimension = 16384;
-    ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
-    if (textureSetDesc.width > maxImageDimension || textureSetDesc.height > maxImageDimension)
+    if (width > maxImageDimension || height > maxImageDimension)
     {
         donut::log::error("Cannot perform any graphics API based processing on the texture set because it is too large. "
             "The texture set is %dx%d pixels, and maximum supported size is %dx%d.",
-            textureSetDesc.width, textureSetDesc.height, maxImageDimension, maxImageDimension);
+            width, height, maxImageDimension, maxImageDimension);
         return false;
     }
 
@@ -51,6 +135,15 @@ bool CreateGraphicsResourcesFromMetadata(
         assert(textureMetadata);
 
         char const* name = textureMetadata->GetName();
+
+        // Unselected textures keep their place in the array so that the indices match the metadata
+        if (region && !region->IsTextureSelected(i))
+        {
+            GraphicsResourcesForTexture& textureResources = resources.perTexture.emplace_back(context);
+            textureResources.name = name;
+            continue;
+        }
+
         int firstChannel, numChannels;
         textureMetadata->GetChannels(firstChannel, numChannels);
         ntc::ChannelFormat const channelFormat = textureMetadata->GetChannelFormat();
@@ -58,27 +151,7 @@ bool CreateGraphicsResourcesFromMetadata(
 
         nvrhi::Format colorFormat = nvrhi::Format::UNKNOWN;
         ntc::ChannelFormat sharedFormat = ntc::ChannelFormat::UNKNOWN;
-        switch (channelFormat)
-        {
-            case ntc::ChannelFormat::UNORM8:
-                colorFormat = nvrhi::Format::RGBA8_UNORM;
-                sharedFormat = ntc::ChannelFormat::UNORM8;
-                break;
-            case ntc::ChannelFormat::UNORM16:
-                // Note: graphics passes don't support saving 16-bit PNGs at this time, so cast to u8
-                colorFormat = nvrhi::Format::RGBA8_UNORM;
-                sharedFormat = ntc::ChannelFormat::UNORM8;
-                break;
-            case ntc::ChannelFormat::FLOAT16:
-            case ntc::ChannelFormat::FLOAT32:
-                colorFormat = nvrhi::Format::RGBA32_FLOAT;
-                sharedFormat = ntc::ChannelFormat::FLOAT32;
-                break;
-            case ntc::ChannelFormat::UINT32:
-                colorFormat = nvrhi::Format::R32_UINT;
-                sharedFormat = ntc::ChannelFormat::UINT32;
-                break;
-        }
+        GetColorTextureFormat(channelFormat, colorFormat, sharedFormat);
 
         GraphicsResourcesForTexture textureResources(context);
         textureResources.name = name;
@@ -86,8 +159,8 @@ bool CreateGraphicsResourcesFromMetadata(
         auto colorTextureDesc = nvrhi::TextureDesc()
             .setDebugName(name)
             .setFormat(colorFormat)
-            .setWidth(textureSetDesc.width)
-            .setHeight(textureSetDesc.height)
+            .setWidth(width)
+            .setHeight(height)
             .setMipLevels(mipLevels)
             .setDimension(nvrhi::TextureDimension::Texture2D)
             .setIsUAV(true)
@@ -137,8 +210,8 @@ bool CreateGraphicsResourcesFromMetadata(
         {
             BcFormatDefinition const* bcFormatDef = GetBcFormatDefinition(bcFormat);
 
-            int const widthBlocks = (metadata->GetDesc().width + 3) / 4;
-            int const heightBlocks = (metadata->GetDesc().height + 3) / 4;
+            int const widthBlocks = (width + 3) / 4;
+            int const heightBlocks = (height + 3) / 4;
             auto blockTextureDesc = nvrhi::TextureDesc()
                 .setDebugName(name)
                 .setFormat(bcFormatDef->bytesPerBlock == 8 ? nvrhi::Format::RG32_UINT : nvrhi::Format::RGBA32_UINT)
@@ -164,8 +237,8 @@ bool CreateGraphicsResourcesFromMetadata(
                 .setDebugName(name)
                 .setFormat(bcFormatDef->nvrhiFormat)
                 .setDimension(nvrhi::TextureDimension::Texture2D)
-                .setWidth(metadata->GetDesc().width)
-                .setHeight(metadata->GetDesc().height)
+                .setWidth(width)
+                .setHeight(height)
                 .setMipLevels(mipLevels)
                 .setInitialState(nvrhi::ResourceStates::CopyDest)
                 .setKeepInitialState(true);
@@ -200,6 +273,39 @@ bool CreateGraphicsResourcesFromMetadata(
     return true;
 }
 
+bool CreateGraphicsResourcesFromMetadata(
+    ntc::IContext* context,
+    nvrhi::IDevice* device,
+    ntc::ITextureSetMetadata* metadata,
+    int mipLevels,
+    bool enableCudaSharing,
+    GraphicsResourcesForTextureSet& resources)
+{
+    ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
+    return CreateGraphicsResources(context, device, metadata, textureSetDesc.width, textureSetDesc.height,
+        mipLevels, nullptr, enableCudaSharing, resources);
+}
+
+bool CreateGraphicsResourcesForRegion(
+    ntc::IContext* context,
+    nvrhi::IDevice* device,
+    ntc::ITextureSetMetadata* metadata,
+    GraphicsDecompressionRegion const& region,
+    GraphicsResourcesForTextureSet& resources)
+{
+    ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
+    int width = std::max(textureSetDesc.width >> region.firstMip, 1);
+    int height = std::max(textureSetDesc.height >> region.firstMip, 1);
+    if (region.rect.width > 0 && region.rect.height > 0)
+    {
+        width = region.rect.width;
+        height = region.rect.height;
+    }
+
+    return CreateGraphicsResources(context, device, metadata, width, height, region.mipCount, &region,
+        /* enableCudaSharing = */ false, resources);
+}
+
 bool DecompressTextureSetWithGraphicsAPI(
     nvrhi::ICommandList* commandList,
     nvrhi::ITimerQuery* timerQuery,
@@ -207,12 +313,12 @@ bool DecompressTextureSetWithGraphicsAPI(
     ntc::IContext* context,
     ntc::ITextureSetMetadata* metadata,
     ntc::IStream* inputFile,
-    int mipLevels,
+    GraphicsDecompressionRegion const& region,
     GraphicsResourcesForTextureSet const& graphicsResources)
 {
-    // Request the stream range for the entire mip chain.
+    // Request the stream range for the decompressed mip levels only, the latents for other mips are not read.
     ntc::StreamRange streamRange;
-    ntc::Status ntcStatus = metadata->GetStreamRangeForLatents(0, mipLevels, streamRange);
+    ntc::Status ntcStatus = metadata->GetStreamRangeForLatents(region.firstMip, region.mipCount, streamRange);
     if (ntcStatus != ntc::Status::Ok)
     {
         fprintf(stderr, "Call to GetStreamRangeForLatents failed, code = %s: %s\n",
@@ -231,12 +337,17 @@ bool DecompressTextureSetWithGraphicsAPI(
     }
 
     int const numTextures = int(graphicsResources.perTexture.size());
+    int const mipLevels = region.mipCount;
+    bool const allTextures = std::find(region.textures.begin(), region.textures.end(), false) == region.textures.end();
     
     // Write UAV descriptors for all necessary mip levels into the descriptor table
     for (int mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
     {
         for (int index = 0; index < numTextures; ++index)
         {
+            if (!graphicsResources.perTexture[index].color)
+                continue;
+
             const auto bindingSetItem = nvrhi::BindingSetItem::Texture_UAV(
                 mipLevel * numTextures + index,
                 graphicsResources.perTexture[index].color,
@@ -260,6 +371,10 @@ bool DecompressTextureSetWithGraphicsAPI(
         return false;
     }
 
+    ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
+    bool const useRect = region.rect.width > 0 && region.rect.height > 0;
+    std::vector<ntc::OutputTextureDesc> outputTextures;
+
     commandList->beginTimerQuery(timerQuery);
 
     // Decompress each mip level in a loop
@@ -269,9 +384,47 @@ bool DecompressTextureSetWithGraphicsAPI(
         ntc::MakeDecompressionComputePassParameters params;
         params.textureSetMetadata = metadata;
         params.latentStreamRange = streamRange;
-        params.mipLevel = mipLevel;
+        params.mipLevel = region.firstMip + mipLevel;
         params.firstOutputDescriptorIndex = mipLevel * numTextures;
         params.weightType = weightType;
+
+        // With a subset of the textures, list the outputs explicitly using absolute descriptor indices
+        if (!allTextures)
+        {
+            outputTextures.clear();
+            for (int index = 0; index < numTextures; ++index)
+            {
+                if (!region.IsTextureSelected(index))
+                    continue;
+
+                ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(index);
+                ntc::OutputTextureDesc& outputDesc = outputTextures.emplace_back();
+                textureMetadata->GetChannels(outputDesc.firstChannel, outputDesc.numChannels);
+                outputDesc.descriptorIndex = mipLevel * numTextures + index;
+                outputDesc.rgbColorSpace = textureMetadata->GetRgbColorSpace();
+            }
+            params.firstOutputDescriptorIndex = 0;
+            params.pOutputTextures = outputTextures.data();
+            params.numOutputTextures = int(outputTextures.size());
+        }
+
+        // Scale the rectangle down to this mip level and write it into the top left corner of the outputs
+        ntc::Rect srcRect{};
+        ntc::Point dstOffset{};
+        if (useRect)
+        {
+            int const srcMipWidth = std::max(textureSetDesc.width >> params.mipLevel, 1);
+            int const srcMipHeight = std::max(textureSetDesc.height >> params.mipLevel, 1);
+            // With odd level sizes, the shifted corner can land past the last pixel of the level,
+            // keep at least the last row and column in the rectangle
+            srcRect.left = std::min(region.rect.left >> mipLevel, srcMipWidth - 1);
+            srcRect.top = std::min(region.rect.top >> mipLevel, srcMipHeight - 1);
+            srcRect.width = std::min(std::max(region.rect.width >> mipLevel, 1), srcMipWidth - srcRect.left);
+            srcRect.height = std::min(std::max(region.rect.height >> mipLevel, 1), srcMipHeight - srcRect.top);
+            params.pSrcRect = &srcRect;
+            params.pDstOffset = &dstOffset;
+        }
+
         ntc::ComputePassDesc computePass{};
         ntc::Status ntcStatus = context->MakeDecompressionComputePass(params, &computePass);
         CHECK_NTC_RESULT("MakeDecompressionComputePass");
@@ -290,6 +443,9 @@ bool DecompressTextureSetWithGraphicsAPI(
     {
         for (int index = 0; index < numTextures; ++index)
         {
+            if (!graphicsResources.perTexture[index].color)
+                continue;
+
             auto const slice = nvrhi::TextureSlice().setMipLevel(mipLevel);
             commandList->copyTexture(graphicsResources.perTexture[index].stagingColor, slice,
                 graphicsResources.perTexture[index].color, slice);
@@ -346,6 +502,8 @@ bool SaveGraphicsStagingTextures(
     char const* savePath,
     ImageContainer const userProvidedContainer,
     bool saveMips,
+    int firstMip,
+    int pngCompressionLevel,
     GraphicsResourcesForTextureSet const& graphicsResources)
 {
     fs::path const outputPath = fs::path(savePath);
@@ -358,11 +516,14 @@ bool SaveGraphicsStagingTextures(
     {
         ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(index);
         ntc::BlockCompressedFormat bcFormat = textureMetadata->GetBlockCompressedFormat();
+        GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[index];
 
-        if (bcFormat != ntc::BlockCompressedFormat::None)
+        if (bcFormat != ntc::BlockCompressedFormat::None || !textureResources.stagingColor)
             continue;
 
-        if (!mipsDirCreated && saveMips && metadata->GetDesc().mips > 1)
+        nvrhi::TextureDesc const& textureDesc = textureResources.stagingColor->getDesc();
+
+        if (!mipsDirCreated && saveMips && textureDesc.mipLevels > 1)
         {
             fs::path mipsPath = outputPath / "mips";
             if (!fs::is_directory(mipsPath) && !fs::create_directories(mipsPath))
@@ -372,9 +533,6 @@ bool SaveGraphicsStagingTextures(
             }
             mipsDirCreated = true;
         }
-        
-        GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[index];
-        nvrhi::TextureDesc const& textureDesc = textureResources.stagingColor->getDesc();
 
         ImageContainer container = userProvidedContainer;
 
@@ -385,7 +543,7 @@ bool SaveGraphicsStagingTextures(
         {
             if (container != ImageContainer::EXR && container != ImageContainer::Auto)
             {
-                printf("Warning: Cannot save texture '%s' as %s in this mode, using EXR instead.\n",
+                PrintOutput("Warning: Cannot save texture '%s' as %s in this mode, using EXR instead.\n",
                     textureResources.name.c_str(), GetContainerExtension(container));
             }
 
@@ -393,7 +551,7 @@ bool SaveGraphicsStagingTextures(
         }
         else if (container == ImageContainer::EXR)
         {
-            printf("Warning: Cannot save texture '%s' as EXR in this mode, using BMP instead.\n",
+            PrintOutput("Warning: Cannot save texture '%s' as EXR in this mode, using BMP instead.\n",
                 textureResources.name.c_str());
 
             container = ImageContainer::BMP;
@@ -406,7 +564,7 @@ bool SaveGraphicsStagingTextures(
         // Fallback from PNG16 to regular PNG, 16-bit support not implemented here
         if (container == ImageContainer::PNG16)
         {
-            printf("Warning: Cannot save texture '%s' as PNG16 in this mode, using regular PNG instead.\n",
+            PrintOutput("Warning: Cannot save texture '%s' as PNG16 in this mode, using regular PNG instead.\n",
                 textureResources.name.c_str());
             
             container = ImageContainer::PNG;
@@ -446,8 +604,9 @@ bool SaveGraphicsStagingTextures(
             {
                 outputFileName = (outputPath / "mips" / textureResources.name).generic_string();
 
+                // The staging texture starts at 'firstMip', name the files after the mip levels of the texture set
                 char mipStr[8];
-                snprintf(mipStr, sizeof(mipStr), ".%02d", mipLevel);
+                snprintf(mipStr, sizeof(mipStr), ".%02d", firstMip + mipLevel);
                 outputFileName += mipStr;
             }
             else
@@ -457,12 +616,13 @@ bool SaveGraphicsStagingTextures(
                         
             outputFileName += GetContainerExtension(container);
 
-            StartAsyncTask([&anyErrors, &mutex, container, outputFileName, textureData, textureDesc, mipWidth, mipHeight]()
+            StartAsyncTask([&anyErrors, &mutex, container, outputFileName, textureData, textureDesc, mipWidth, mipHeight,
+                pngCompressionLevel]()
             {
                 int const numChannels = 4; // Lower channel counts not currently supported
 
                 bool success = SaveImageToContainer(container, textureData.get(), mipWidth, mipHeight,
-                    numChannels, outputFileName.c_str());
+                    numChannels, outputFileName.c_str(), pngCompressionLevel);
 
                 auto lockGuard = std::lock_guard(mutex);
 
@@ -473,7 +633,7 @@ bool SaveGraphicsStagingTextures(
                 }
                 else
                 {
-                    printf("Saved image '%s': %dx%d pixels, %d channels.\n", outputFileName.c_str(),
+                    PrintOutput("Saved image '%s': %dx%d pixels, %d channels.\n", outputFileName.c_str(),
                         mipWidth, mipHeight, numChannels);
                 }
             });
@@ -558,6 +718,306 @@ bool ComputeBlockCompressedImageError(
     return true;
 }
 
+// One of the two sets of readback resources used by BlockCompressAndSaveGraphicsTexturesPipelined.
+// While the GPU encodes a texture into one slot, the CPU reads back and saves the texture from the other slot.
+struct BlockCompressionReadbackSlot
+{
+    nvrhi::StagingTextureHandle staging;
+    nvrhi::EventQueryHandle eventQuery;
+    nvrhi::TimerQueryHandle timerQuery;
+    std::unique_ptr<GraphicsImageDifferencePass> compareImagesPass;
+    int textureIndex = -1; // Texture that is being encoded into this slot, or -1 if the slot is free
+};
+
+// Encodes all mips of each texture and reads them back in a single submission per texture, without waiting
+// for the GPU to go idle. The DDS files are written by async tasks.
+static bool BlockCompressAndSaveGraphicsTexturesPipelined(
+    ntc::IContext* context,
+    ntc::ITextureSetMetadata* metadata,
+    nvrhi::IDevice* device,
+    nvrhi::ICommandList* commandList,
+    char const* savePath,
+    int userProvidedBcQuality,
+    GraphicsResourcesForTextureSet const& graphicsResources)
+{
+    std::array<BlockCompressionReadbackSlot, 2> slots;
+
+    // The compression constants are written once per mip, and two submissions can be in flight
+    uint32_t maxMipLevels = 1;
+    for (GraphicsResourcesForTexture const& textureResources : graphicsResources.perTexture)
+    {
+        if (textureResources.color)
+            maxMipLevels = std::max(maxMipLevels, textureResources.color->getDesc().mipLevels);
+    }
+
+    GraphicsBlockCompressionPass blockCompressionPass(device, false, int(maxMipLevels) * int(slots.size()));
+    if (!blockCompressionPass.Init())
+        return false;
+
+    for (BlockCompressionReadbackSlot& slot : slots)
+    {
+        slot.eventQuery = device->createEventQuery();
+        slot.timerQuery = device->createTimerQuery();
+        slot.compareImagesPass = std::make_unique<GraphicsImageDifferencePass>(device);
+        if (!slot.eventQuery || !slot.timerQuery || !slot.compareImagesPass->Init())
+            return false;
+    }
+
+    float const alphaThreshold = 1.f / 255.f;
+
+    std::mutex mutex;
+    bool anyErrors = false;
+
+    // The files are written by the tasks but closed here, after WaitForAllTasks, because closing calls the context
+    std::vector<std::shared_ptr<ntc::FileStreamWrapper>> outputFiles;
+
+    // Waits for the slot's submission, copies the blocks into a buffer laid out like the DDS file data,
+    // and starts a task that writes the file. The slot can be reused right after that.
+    auto readBackSlot = [context, metadata, device, savePath, &graphicsResources, &mutex, &anyErrors, &outputFiles]
+        (BlockCompressionReadbackSlot& slot)
+    {
+        if (slot.textureIndex < 0)
+            return true;
+
+        int const textureIndex = slot.textureIndex;
+        slot.textureIndex = -1;
+
+        device->waitEventQuery(slot.eventQuery);
+        device->resetEventQuery(slot.eventQuery);
+
+        GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[textureIndex];
+        ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(textureIndex);
+        ntc::BlockCompressedFormat const bcFormat = textureMetadata->GetBlockCompressedFormat();
+        BcFormatDefinition const* bcFormatDef = GetBcFormatDefinition(bcFormat);
+        nvrhi::TextureDesc const textureDesc = textureResources.color->getDesc();
+        bool const useMSLE = bcFormat == ntc::BlockCompressedFormat::BC6;
+
+        float const mipChainCompressionTimeMs = device->getTimerQueryTime(slot.timerQuery) * 1e3f;
+
+        float mipZeroMSE = 0;
+        float mipZeroPSNR = 0;
+        if (!slot.compareImagesPass->ReadResults() ||
+            !slot.compareImagesPass->GetQueryResult(0, nullptr, &mipZeroMSE, &mipZeroPSNR, bcFormatDef->channels))
+            return false;
+
+        std::shared_ptr<std::vector<uint8_t>> ddsData = std::make_shared<std::vector<uint8_t>>();
+        for (int mipLevel = 0; mipLevel < int(textureDesc.mipLevels); ++mipLevel)
+        {
+            uint32_t const mipWidthBlocks = (std::max(textureDesc.width >> mipLevel, 1u) + 3) / 4;
+            uint32_t const mipHeightBlocks = (std::max(textureDesc.height >> mipLevel, 1u) + 3) / 4;
+            size_t const rowSize = size_t(mipWidthBlocks) * bcFormatDef->bytesPerBlock;
+
+            size_t rowPitch = 0;
+            uint8_t const* mappedData = static_cast<uint8_t const*>(device->mapStagingTexture(slot.staging,
+                nvrhi::TextureSlice().setMipLevel(mipLevel), nvrhi::CpuAccessMode::Read, &rowPitch));
+            if (!mappedData)
+            {
+                fprintf(stderr, "Failed to map texture '%s' mip level %d.\n", textureResources.name.c_str(), mipLevel);
+                return false;
+            }
+
+            size_t const offset = ddsData->size();
+            ddsData->resize(offset + rowSize * mipHeightBlocks);
+            for (uint32_t row = 0; row < mipHeightBlocks; ++row)
+            {
+                memcpy(ddsData->data() + offset + rowSize * row, mappedData + rowPitch * row, rowSize);
+            }
+
+            device->unmapStagingTexture(slot.staging);
+        }
+
+        std::string outputFileName = (fs::path(savePath) / fs::path(textureResources.name)).generic_string() + ".dds";
+        std::shared_ptr<ntc::FileStreamWrapper> outputFile = std::make_shared<ntc::FileStreamWrapper>(context);
+        ntc::Status ntcStatus = context->OpenFile(outputFileName.c_str(), true, outputFile->ptr());
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to open output file '%s', code = %s: %s\n", outputFileName.c_str(),
+                StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
+        outputFiles.push_back(outputFile);
+
+        char errorString[16];
+        if (useMSLE)
+            snprintf(errorString, sizeof errorString, "RMSLE: %.4f", sqrtf(mipZeroMSE));
+        else
+            snprintf(errorString, sizeof errorString, "PSNR: %.2f dB", mipZeroPSNR);
+        std::string const errorText = errorString;
+
+        ntc::ColorSpace const rgbColorSpace = textureMetadata->GetRgbColorSpace();
+
+        StartAsyncTask([&mutex, &anyErrors, outputFile, outputFileName, ddsData, textureDesc, bcFormatDef,
+            rgbColorSpace, mipChainCompressionTimeMs, errorText]()
+        {
+            bool const success = WriteDdsHeader(*outputFile, textureDesc.width, textureDesc.height,
+                textureDesc.mipLevels, bcFormatDef, rgbColorSpace) &&
+                (*outputFile)->Write(ddsData->data(), ddsData->size());
+
+            auto lockGuard = std::lock_guard(mutex);
+
+            if (!success)
+            {
+                fprintf(stderr, "Failed to write into output file '%s': %s.\n", outputFileName.c_str(),
+                    strerror(errno));
+                anyErrors = true;
+            }
+            else
+            {
+                PrintOutput("Saved image '%s': %dx%d pixels, %d mips, %s (Encoding time: %.2f ms, MIP0 %s)\n",
+                    outputFileName.c_str(), textureDesc.width, textureDesc.height, textureDesc.mipLevels,
+                    ntc::BlockCompressedFormatToString(bcFormatDef->ntcFormat),
+                    mipChainCompressionTimeMs, errorText.c_str());
+            }
+        });
+
+        return true;
+    };
+
+    bool success = true;
+    int nextSlot = 0;
+    
+    for (int index = 0; index < int(graphicsResources.perTexture.size()) && success; ++index)
+    {
+        GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[index];
+        ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(index);
+        ntc::BlockCompressedFormat bcFormat = textureMetadata->GetBlockCompressedFormat();
+
+        // Textures that were not decompressed have no resources
+        if (bcFormat == ntc::BlockCompressedFormat::None || !textureResources.color)
+            continue;
+
+        // Finish the texture that was encoded into this slot two textures ago.
+        // The previous texture is still being encoded in the other slot at this point.
+        BlockCompressionReadbackSlot& slot = slots[nextSlot];
+        nextSlot = (nextSlot + 1) % int(slots.size());
+        if (!readBackSlot(slot))
+        {
+            success = false;
+            break;
+        }
+
+        nvrhi::TextureDesc const& textureDesc = textureResources.color->getDesc();
+        nvrhi::TextureDesc const& bcTextureDesc = textureResources.bc->getDesc();
+
+        // Reuse the staging texture from the previous texture in this slot if it has the same shape
+        if (!slot.staging ||
+            slot.staging->getDesc().width != bcTextureDesc.width ||
+            slot.staging->getDesc().height != bcTextureDesc.height ||
+            slot.staging->getDesc().mipLevels != bcTextureDesc.mipLevels ||
+            slot.staging->getDesc().format != bcTextureDesc.format)
+        {
+            nvrhi::TextureDesc stagingDesc = bcTextureDesc;
+            stagingDesc.setInitialState(nvrhi::ResourceStates::CopyDest);
+            slot.staging = device->createStagingTexture(stagingDesc, nvrhi::CpuAccessMode::Read);
+            if (!slot.staging)
+            {
+                success = false;
+                break;
+            }
+        }
+
+        uint8_t const bcQuality = userProvidedBcQuality >= 0
+            ? uint8_t(userProvidedBcQuality)
+            : textureMetadata->GetBlockCompressionQuality();
+
+        commandList->open();
+        commandList->beginTimerQuery(slot.timerQuery);
+
+        for (int mipLevel = 0; mipLevel < int(textureDesc.mipLevels) && success; ++mipLevel)
+        {
+            uint32_t const mipWidth = std::max(textureDesc.width >> mipLevel, 1u);
+            uint32_t const mipHeight = std::max(textureDesc.height >> mipLevel, 1u);
+
+            ntc::MakeBlockCompressionComputePassParameters params;
+            params.srcRect.width = int(mipWidth);
+            params.srcRect.height = int(mipHeight);
+            params.dstFormat = bcFormat;
+            params.alphaThreshold = alphaThreshold;
+            params.texture = textureMetadata;
+            params.quality = bcQuality;
+            ntc::ComputePassDesc computePass{};
+            ntc::Status ntcStatus = context->MakeBlockCompressionComputePass(params, &computePass);
+            if (ntcStatus != ntc::Status::Ok)
+            {
+                fprintf(stderr, "Call to MakeBlockCompressionComputePass failed, code = %s\n%s\n",
+                    ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+                success = false;
+                break;
+            }
+
+            // The block texture is reused for all mips, the copy below is ordered before the next mip's encoding
+            // by the state transitions.
+            if (!blockCompressionPass.ExecuteComputePass(commandList, computePass,
+                textureResources.color, nvrhi::Format::UNKNOWN, mipLevel, textureResources.blocks, 0, nullptr))
+            {
+                success = false;
+                break;
+            }
+
+            auto srcSlice = nvrhi::TextureSlice().setWidth((mipWidth + 3) / 4).setHeight((mipHeight + 3) / 4);
+            auto dstSlice = nvrhi::TextureSlice().setWidth(mipWidth).setHeight(mipHeight).setMipLevel(mipLevel);
+            commandList->copyTexture(textureResources.bc, dstSlice, textureResources.blocks, srcSlice);
+        }
+
+        commandList->endTimerQuery(slot.timerQuery);
+
+        if (success)
+        {
+            // Compute the compression error for mip 0 only (for simplicity/performance)
+            ntc::MakeImageDifferenceComputePassParameters params;
+            params.extent.width = int(textureDesc.width);
+            params.extent.height = int(textureDesc.height);
+            params.useAlphaThreshold = bcFormat == ntc::BlockCompressedFormat::BC1;
+            params.alphaThreshold = alphaThreshold;
+            params.useMSLE = bcFormat == ntc::BlockCompressedFormat::BC6;
+            ntc::ComputePassDesc computePass{};
+            ntc::Status ntcStatus = context->MakeImageDifferenceComputePass(params, &computePass);
+            if (ntcStatus != ntc::Status::Ok)
+            {
+                fprintf(stderr, "Call to MakeImageDifferenceComputePass failed, code = %s\n%s\n",
+                    ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+                success = false;
+            }
+            else
+            {
+                success = slot.compareImagesPass->ExecuteComputePass(commandList, computePass,
+                    textureResources.bc, 0, textureResources.color, 0, 0);
+            }
+        }
+
+        for (int mipLevel = 0; mipLevel < int(textureDesc.mipLevels) && success; ++mipLevel)
+        {
+            auto const slice = nvrhi::TextureSlice().setMipLevel(mipLevel);
+            commandList->copyTexture(slot.staging, slice, textureResources.bc, slice);
+        }
+        
+        commandList->close();
+
+        if (!success)
+            break;
+
+        device->executeCommandList(commandList);
+        device->setEventQuery(slot.eventQuery, nvrhi::CommandQueue::Graphics);
+        slot.textureIndex = index;
+    }
+
+    // Finish the remaining textures in the order they were submitted
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        BlockCompressionReadbackSlot& slot = slots[(nextSlot + i) % slots.size()];
+        if (success)
+            success = readBackSlot(slot);
+        else if (slot.textureIndex >= 0)
+            device->waitEventQuery(slot.eventQuery);
+    }
+
+    WaitForAllTasks();
+    outputFiles.clear();
+    device->runGarbageCollection();
+
+    return success && !anyErrors;
+}
+
 bool BlockCompressAndSaveGraphicsTextures(
     ntc::IContext* context,
     ntc::ITextureSetMetadata* metadata,
@@ -569,6 +1029,13 @@ bool BlockCompressAndSaveGraphicsTextures(
     int benchmarkIterations,
     GraphicsResourcesForTextureSet const& graphicsResources)
 {
+    // Benchmarking needs every mip encoded in isolation, otherwise use the pipelined path
+    if (benchmarkIterations <= 1)
+    {
+        return BlockCompressAndSaveGraphicsTexturesPipelined(context, metadata, device, commandList, savePath,
+            userProvidedBcQuality, graphicsResources);
+    }
+
     GraphicsBlockCompressionPass blockCompressionPass(device, false, 2);
     if (!blockCompressionPass.Init())
         return false;
@@ -587,7 +1054,8 @@ bool BlockCompressAndSaveGraphicsTextures(
         ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(index);
         ntc::BlockCompressedFormat bcFormat = textureMetadata->GetBlockCompressedFormat();
 
-        if (bcFormat == ntc::BlockCompressedFormat::None)
+        // Textures that were not decompressed have no resources
+        if (bcFormat == ntc::BlockCompressedFormat::None || !textureResources.color)
             continue;
 
         bool const useAlphaThreshold = bcFormat == ntc::BlockCompressedFormat::BC1;
@@ -716,7 +1184,7 @@ bool BlockCompressAndSaveGraphicsTextures(
         else
             snprintf(errorString, sizeof errorString, "PSNR: %.2f dB", mipZeroPSNR);
         
-        printf("Saved image '%s': %dx%d pixels, %d mips, %s (Encoding time: %.2f ms, MIP0 %s)\n",
+        PrintOutput("Saved image '%s': %dx%d pixels, %d mips, %s (Encoding time: %.2f ms, MIP0 %s)\n",
             outputFileName.c_str(), textureDesc.width, textureDesc.height, textureDesc.mipLevels,
             ntc::BlockCompressedFormatToString(bcFormatDef->ntcFormat),
             mipChainCompressionTimeMs, errorString);
@@ -725,6 +1193,10 @@ bool BlockCompressAndSaveGraphicsTextures(
     return true;
 }
 
+// Number of quality levels evaluated per submission by OptimizeBlockCompression.
+// 7 candidates split the 0-255 range in 3 rounds, where a binary search needs 8.
+static const int g_bcOptimizationCandidates = 7;
+
 bool OptimizeBlockCompression(
     ntc::IContext* context,
     ntc::ITextureSetMetadata* textureSetMetadata,
@@ -753,7 +1225,7 @@ bool OptimizeBlockCompression(
     if (!timerQuery)
         return false;
 
-    GraphicsBlockCompressionPass blockCompressionPass(device, true);
+    GraphicsBlockCompressionPass blockCompressionPass(device, true, g_bcOptimizationCandidates);
     if (!blockCompressionPass.Init())
         return false;
 
@@ -761,6 +1233,17 @@ bool OptimizeBlockCompression(
     if (!compareImagesPass.Init())
         return false;
 
+    GraphicsImageDifferencePass candidateCompareImagesPass(device, g_bcOptimizationCandidates);
+    if (!candidateCompareImagesPass.Init())
+        return false;
+
+    struct CandidateTargets
+    {
+        nvrhi::TextureHandle blocks;
+        nvrhi::TextureHandle bc;
+    };
+    std::vector<CandidateTargets> candidateTargets;
+
     for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
     {
         ntc::ITextureMetadata* textureMetadata = textureSetMetadata->GetTexture(textureIndex);
@@ -819,8 +1302,33 @@ bool OptimizeBlockCompression(
         ComputeBlockCompressedImageError(context, compareImagesPass, device, commandList, textureResources, 
             textureDesc.width, textureDesc.height, false, false, 0.f, false, nullptr, &basePassPsnr);
         
-        printf("Optimizing texture '%s'...\n", textureMetadata->GetName());
-        printf("  MAX PSNR: %5.2f dB, t = %.3f ms\n", basePassPsnr, basePassTimeSeconds * 1e3f);
+        PrintOutput("Optimizing texture '%s'...\n", textureMetadata->GetName());
+        PrintOutput("  MAX PSNR: %5.2f dB, t = %.3f ms\n", basePassPsnr, basePassTimeSeconds * 1e3f);
+
+        // Create the targets for the candidate encodings, or reuse them from the previous texture
+        if (!candidateTargets.empty() && (
+            candidateTargets[0].blocks->getDesc().width != textureResources.blocks->getDesc().width ||
+            candidateTargets[0].blocks->getDesc().height != textureResources.blocks->getDesc().height ||
+            candidateTargets[0].bc->getDesc().format != textureResources.bc->getDesc().format))
+        {
+            candidateTargets.clear();
+        }
+
+        if (candidateTargets.empty())
+        {
+            nvrhi::TextureDesc blockTextureDesc = textureResources.blocks->getDesc();
+            nvrhi::TextureDesc bcTextureDesc = textureResources.bc->getDesc();
+            bcTextureDesc.setMipLevels(1);
+
+            candidateTargets.resize(g_bcOptimizationCandidates);
+            for (CandidateTargets& targets : candidateTargets)
+            {
+                targets.blocks = device->createTexture(blockTextureDesc);
+                targets.bc = device->createTexture(bcTextureDesc);
+                if (!targets.blocks || !targets.bc)
+                    return false;
+            }
+        }
 
         int qualityLow = 0;
         int qualityHigh = 255;
@@ -828,48 +1336,110 @@ bool OptimizeBlockCompression(
         float psnrLow = 0.f; // we don't really know but assume it's bad for q=0
         float psnrHigh = basePassPsnr;
 
+        // Search for the lowest quality that doesn't lose more than psnrThreshold, splitting the remaining range
+        // with several candidates per submission instead of one. Every candidate is encoded into its own targets,
+        // so the encoding and comparison passes for different candidates don't depend on each other.
         while (qualityLow + 1 < qualityHigh)
         {
-            int quality = (qualityLow + qualityHigh) / 2;
-
-            compressionParams.writeAccelerationData = false;
-            compressionParams.quality = uint8_t(quality);
-            ntcStatus = context->MakeBlockCompressionComputePass(compressionParams, &blockCompressionComputePass);
-            CHECK_NTC_RESULT("MakeBlockCompressionComputePass");
+            int const candidateCount = std::min(g_bcOptimizationCandidates, qualityHigh - qualityLow - 1);
+            std::array<int, g_bcOptimizationCandidates> candidateQualities;
+            for (int candidate = 0; candidate < candidateCount; ++candidate)
+            {
+                candidateQualities[candidate] = qualityLow
+                    + (qualityHigh - qualityLow) * (candidate + 1) / (candidateCount + 1);
+            }
 
             commandList->open();
             commandList->beginTimerQuery(timerQuery);
 
-            if (!blockCompressionPass.ExecuteComputePass(commandList, blockCompressionComputePass,
-                textureResources.color, nvrhi::Format::UNKNOWN, /* inputMipLevel = */ 0,
-                textureResources.blocks, /* outputMipLevel = */ 0, graphicsResources.accelerationBuffer))
+            // The candidate passes only read the acceleration data
+            commandList->setEnableUavBarriersForBuffer(graphicsResources.accelerationBuffer, false);
+
+            bool success = true;
+            for (int candidate = 0; candidate < candidateCount && success; ++candidate)
             {
-                commandList->close();
-                return false;
+                CandidateTargets const& targets = candidateTargets[candidate];
+
+                compressionParams.writeAccelerationData = false;
+                compressionParams.quality = uint8_t(candidateQualities[candidate]);
+                ntcStatus = context->MakeBlockCompressionComputePass(compressionParams, &blockCompressionComputePass);
+                if (ntcStatus != ntc::Status::Ok)
+                {
+                    fprintf(stderr, "Call to MakeBlockCompressionComputePass failed, code = %s\n%s\n",
+                        ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+                    success = false;
+                    break;
+                }
+
+                success = blockCompressionPass.ExecuteComputePass(commandList, blockCompressionComputePass,
+                    textureResources.color, nvrhi::Format::UNKNOWN, /* inputMipLevel = */ 0,
+                    targets.blocks, /* outputMipLevel = */ 0, graphicsResources.accelerationBuffer);
+                if (!success)
+                    break;
+
+                auto srcSlice = nvrhi::TextureSlice()
+                    .setWidth((textureDesc.width + 3) / 4)
+                    .setHeight((textureDesc.height + 3) / 4);
+                auto dstSlice = nvrhi::TextureSlice().setWidth(textureDesc.width).setHeight(textureDesc.height);
+                commandList->copyTexture(targets.bc, dstSlice, targets.blocks, srcSlice);
+
+                ntc::MakeImageDifferenceComputePassParameters differenceParams;
+                differenceParams.extent.width = int(textureDesc.width);
+                differenceParams.extent.height = int(textureDesc.height);
+                differenceParams.outputOffset = candidateCompareImagesPass.GetOffsetForQuery(candidate);
+                ntc::ComputePassDesc differenceComputePass{};
+                ntcStatus = context->MakeImageDifferenceComputePass(differenceParams, &differenceComputePass);
+                if (ntcStatus != ntc::Status::Ok)
+                {
+                    fprintf(stderr, "Call to MakeImageDifferenceComputePass failed, code = %s\n%s\n",
+                        ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+                    success = false;
+                    break;
+                }
+
+                success = candidateCompareImagesPass.ExecuteComputePass(commandList, differenceComputePass,
+                    targets.bc, 0, textureResources.color, 0, candidate);
             }
             
+            commandList->setEnableUavBarriersForBuffer(graphicsResources.accelerationBuffer, true);
             commandList->endTimerQuery(timerQuery);
             commandList->close();
+
+            if (!success)
+                return false;
+
             device->executeCommandList(commandList);
-            
-            float psnr;
-            ComputeBlockCompressedImageError(context, compareImagesPass, device, commandList, textureResources,
-                textureDesc.width, textureDesc.height, false, false, 0.f, false, nullptr, &psnr);
-            
-            float optimizedPassTimeSeconds = device->getTimerQueryTime(timerQuery);
+            device->waitForIdle();
+            device->runGarbageCollection();
 
-            printf("q=%3d PSNR: %5.2f dB, time: %.3f ms\n", quality, psnr, optimizedPassTimeSeconds * 1e3f);
+            if (!candidateCompareImagesPass.ReadResults())
+                return false;
 
-            if (psnr < targetPsnr)
-            {
-                qualityLow = quality;
-                psnrLow = psnr;
-            }
-            else
+            float const roundTimeSeconds = device->getTimerQueryTime(timerQuery);
+
+            // Narrow the range down to the pair of adjacent candidates around the target PSNR
+            for (int candidate = 0; candidate < candidateCount; ++candidate)
             {
-                qualityHigh = quality;
-                psnrHigh = psnr;
+                int const quality = candidateQualities[candidate];
+                float psnr;
+                candidateCompareImagesPass.GetQueryResult(candidate, nullptr, nullptr, &psnr);
+
+                PrintOutput("q=%3d PSNR: %5.2f dB\n", quality, psnr);
+
+                if (psnr < targetPsnr)
+                {
+                    qualityLow = quality;
+                    psnrLow = psnr;
+                }
+                else
+                {
+                    qualityHigh = quality;
+                    psnrHigh = psnr;
+                    break;
+                }
             }
+
+            PrintOutput("  %d candidates, time: %.3f ms\n", candidateCount, roundTimeSeconds * 1e3f);
         }
 
         int selectedQuality;
@@ -885,7 +1455,7 @@ bool OptimizeBlockCompression(
             selectedPsnr = psnrHigh;
         }
 
-        printf("Selected q=%d with PSNR loss of %.2f dB.\n", selectedQuality, basePassPsnr - selectedPsnr);
+        PrintOutput("Selected q=%d with PSNR loss of %.2f dB.\n", selectedQuality, basePassPsnr - selectedPsnr);
         textureMetadata->SetBlockCompressionQuality(uint8_t(selectedQuality));
     }
     
@@ -994,7 +1564,7 @@ bool ComputePsnrForBlockCompressedTextureSet(
         for (int ch = 0; ch < numChannels; ++ch)
             perChannelMSE.push_back(mse[ch]);
 
-        printf("Compressed texture '%s' as %s, PSNR = %.2f dB.\n", textureResources.name.c_str(),
+        PrintOutput("Compressed texture '%s' as %s, PSNR = %.2f dB.\n", textureResources.name.c_str(),
             ntc::BlockCompressedFormatToString(bcFormat), psnr);
     }
 
@@ -1003,8 +1573,13 @@ bool ComputePsnrForBlockCompressedTextureSet(
     float const overallMSE = std::accumulate(perChannelMSE.begin(), perChannelMSE.end(), 0.f) / totalChannels;
     float const overallPSNR = ntc::LossToPSNR(overallMSE);
 
-    printf("Combined BCn PSNR: %.2f dB, bit rate: %.1f bpp.\n", overallPSNR, combinedBcBitsPerPixel);
+    PrintOutput("Combined BCn PSNR: %.2f dB, bit rate: %.1f bpp.\n", overallPSNR, combinedBcBitsPerPixel);
     outTargetPsnr = overallPSNR;
+
+    Json::Value event(Json::objectValue);
+    event["psnr"] = overallPSNR;
+    event["bitsPerPixel"] = combinedBcBitsPerPixel;
+    EmitTelemetryEvent("bcQuality", std::move(event));
     
     return true;
 }
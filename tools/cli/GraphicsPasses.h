@@ -38,6 +38,18 @@ struct GraphicsResourcesForTextureSet
     nvrhi::BufferHandle accelerationStagingBuffer;
 };
 
+// Part of a texture set that DecompressTextureSetWithGraphicsAPI produces: a range of mip levels, a rectangle
+// and a subset of the textures. The output textures start at 'firstMip', so their mip 0 holds 'rect' of that level.
+struct GraphicsDecompressionRegion
+{
+    int firstMip = 0;
+    int mipCount = 1;
+    ntc::Rect rect{};           // In the pixels of 'firstMip', an empty rectangle means the entire level
+    std::vector<bool> textures; // Indexed like the textures in the metadata, empty means all textures
+
+    bool IsTextureSelected(int index) const { return textures.empty() || textures[index]; }
+};
+
 class GraphicsDecompressionPass;
 
 bool CreateGraphicsResourcesFromMetadata(
@@ -48,6 +60,23 @@ bool CreateGraphicsResourcesFromMetadata(
     bool enableCudaSharing,
     GraphicsResourcesForTextureSet& resources);
 
+// Creates the output textures for decompressing only the provided region: they have the size of the rectangle
+// and the region's mip count, and the textures that are not selected get no resources, only a name.
+bool CreateGraphicsResourcesForRegion(
+    ntc::IContext* context,
+    nvrhi::IDevice* device,
+    ntc::ITextureSetMetadata* metadata,
+    GraphicsDecompressionRegion const& region,
+    GraphicsResourcesForTextureSet& resources);
+
+// Returns true if the resources created for a previous texture set can be reused for the provided one,
+// i.e. if all the textures have matching dimensions, formats and sharing modes.
+bool AreGraphicsResourcesCompatible(
+    ntc::ITextureSetMetadata* metadata,
+    int mipLevels,
+    bool enableCudaSharing,
+    GraphicsResourcesForTextureSet const& resources);
+
 bool DecompressTextureSetWithGraphicsAPI(
     nvrhi::ICommandList* commandList,
     nvrhi::ITimerQuery* timerQuery,
@@ -55,7 +84,7 @@ bool DecompressTextureSetWithGraphicsAPI(
     ntc::IContext* context,
     ntc::ITextureSetMetadata* metadata,
     ntc::IStream* inputFile,
-    int mipLevels,
+    GraphicsDecompressionRegion const& region,
     GraphicsResourcesForTextureSet const& graphicsResources);
 
 bool CopyTextureSetDataIntoGraphicsTextures(
@@ -72,6 +101,8 @@ bool SaveGraphicsStagingTextures(
     char const* savePath,
     ImageContainer const userProvidedContainer,
     bool saveMips,
+    int firstMip,
+    int pngCompressionLevel,
     GraphicsResourcesForTextureSet const& graphicsResources);
 
 bool BlockCompressAndSaveGraphicsTextures(
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Separable resampling filter for --generateMips with the Kaiser and Lanczos filters. The taps are computed
+// on the CPU by MipGeneration.cpp, the horizontal pass resamples the rows and the vertical pass the columns.
+
+#include "MipFilterConstants.h"
+#include <donut/shaders/binding_helpers.hlsli>
+
+VK_PUSH_CONSTANT ConstantBuffer<MipFilterConstants> g_Const : register(b0);
+
+Texture2D<float4> t_Source : register(t0);
+StructuredBuffer<uint2> t_TapRanges : register(t1);
+StructuredBuffer<MipFilterTap> t_Taps : register(t2);
+RWTexture2D<float4> u_Dest : register(u0);
+
+float4 ApplyFilter(uint destIndex, uint2 sourcePosition, uint2 tapDirection)
+{
+    uint2 const range = t_TapRanges[destIndex];
+    float4 result = 0;
+    for (uint tapIndex = range.x; tapIndex < range.x + range.y; ++tapIndex)
+    {
+        MipFilterTap const tap = t_Taps[tapIndex];
+        result += t_Source[sourcePosition + tapDirection * tap.index] * tap.weight;
+    }
+    return result;
+}
+
+[numthreads(MIP_FILTER_GROUP_SIZE, MIP_FILTER_GROUP_SIZE, 1)]
+void HorizontalCS(uint2 pixelPosition : SV_DispatchThreadID)
+{
+    if (any(pixelPosition >= g_Const.destSize))
+        return;
+
+    u_Dest[pixelPosition] = ApplyFilter(pixelPosition.x, uint2(0, pixelPosition.y), uint2(1, 0));
+}
+
+[numthreads(MIP_FILTER_GROUP_SIZE, MIP_FILTER_GROUP_SIZE, 1)]
+void VerticalCS(uint2 pixelPosition : SV_DispatchThreadID)
+{
+    if (any(pixelPosition >= g_Const.destSize))
+        return;
+
+    float4 pixel = ApplyFilter(pixelPosition.y, uint2(pixelPosition.x, 0), uint2(0, 1));
+
+    // Same post-processing as in GenerateMipsWithFilter
+    if (g_Const.normalChannelsXY.x >= 0)
+    {
+        float3 normal = float3(pixel[g_Const.normalChannelsXY.x], pixel[g_Const.normalChannelsXY.y],
+            pixel[g_Const.normalChannelZ]) * 2.0 - 1.0;
+        float const normalLength = length(normal);
+        if (normalLength > 0)
+        {
+            normal = normal / normalLength * 0.5 + 0.5;
+            pixel[g_Const.normalChannelsXY.x] = normal.x;
+            pixel[g_Const.normalChannelsXY.y] = normal.y;
+            pixel[g_Const.normalChannelZ] = normal.z;
+        }
+    }
+
+    if (g_Const.clampToUnitRange)
+        pixel = saturate(pixel);
+
+    u_Dest[pixelPosition] = pixel;
+}
@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#ifndef MIP_FILTER_CONSTANTS_H
+#define MIP_FILTER_CONSTANTS_H
+
+#define MIP_FILTER_GROUP_SIZE 8 // 8x8 pixels
+
+struct MipFilterConstants
+{
+    uint2 destSize;
+    int2 normalChannelsXY; // Channels with the XYZ components of a normal map, or -1 if there is no normal map
+    int normalChannelZ;
+    uint clampToUnitRange;
+};
+
+// One filter tap, the destination column or row 'i' uses the taps [ranges[i].x, ranges[i].x + ranges[i].y)
+struct MipFilterTap
+{
+    uint index;
+    float weight;
+};
+
+#endif // MIP_FILTER_CONSTANTS_H
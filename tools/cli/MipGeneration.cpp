@@ -0,0 +1,584 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "MipGeneration.h"
+#include "Utils.h"
+#include <donut/engine/ShaderFactory.h>
+#include <ntc-utils/Manifest.h>
+#include <nvrhi/utils.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+#if NTC_WITH_DX12
+#include "compiled_shaders/MipFilter_HorizontalCS.dxil.h"
+#include "compiled_shaders/MipFilter_VerticalCS.dxil.h"
+#endif
+#if NTC_WITH_VULKAN
+#include "compiled_shaders/MipFilter_HorizontalCS.spirv.h"
+#include "compiled_shaders/MipFilter_VerticalCS.spirv.h"
+#endif
+
+using namespace donut::math;
+
+#include "MipFilterConstants.h"
+
+namespace
+{
+    constexpr float c_Pi = 3.14159265358979f;
+
+    // Filter parameters, same as the defaults in NVTT
+    constexpr float c_KaiserWidth = 3.f;
+    constexpr float c_KaiserAlpha = 4.f;
+    constexpr float c_LanczosWidth = 3.f;
+
+    float Sinc(float x)
+    {
+        if (fabsf(x) < 1e-6f)
+            return 1.f;
+        x *= c_Pi;
+        return sinf(x) / x;
+    }
+
+    // Zeroth order modified Bessel function of the first kind, used by the Kaiser window
+    float BesselI0(float x)
+    {
+        float const halfX = x * 0.5f;
+        float sum = 1.f;
+        float term = 1.f;
+        for (int k = 1; k < 32 && term > sum * 1e-8f; ++k)
+        {
+            term *= (halfX / float(k)) * (halfX / float(k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    float GetFilterWidth(MipFilter filter)
+    {
+        switch (filter)
+        {
+        case MipFilter::Kaiser:  return c_KaiserWidth;
+        case MipFilter::Lanczos: return c_LanczosWidth;
+        default:                 return 0.5f;
+        }
+    }
+
+    // Evaluates the filter at 'x' destination pixels from the destination pixel center
+    float EvaluateFilter(MipFilter filter, float x)
+    {
+        float const width = GetFilterWidth(filter);
+        if (fabsf(x) >= width)
+            return 0.f;
+
+        switch (filter)
+        {
+        case MipFilter::Kaiser: {
+            float const t = x / width;
+            return Sinc(x) * BesselI0(c_KaiserAlpha * sqrtf(1.f - t * t)) / BesselI0(c_KaiserAlpha);
+        }
+        case MipFilter::Lanczos:
+            return Sinc(x) * Sinc(x / width);
+        default:
+            return 1.f;
+        }
+    }
+
+    struct FilterTap
+    {
+        int index;
+        float weight;
+    };
+
+    // Computes the normalized filter taps for resampling 'srcSize' pixels into 'dstSize' pixels.
+    // Pixels outside of the image are clamped to the edge, and their weights are merged into the edge taps.
+    std::vector<std::vector<FilterTap>> ComputeFilterTaps(MipFilter filter, int srcSize, int dstSize)
+    {
+        float const scale = float(srcSize) / float(dstSize);
+        float const radius = GetFilterWidth(filter) * scale;
+
+        std::vector<std::vector<FilterTap>> result(dstSize);
+        for (int dstIndex = 0; dstIndex < dstSize; ++dstIndex)
+        {
+            std::vector<FilterTap>& taps = result[dstIndex];
+            float const center = (float(dstIndex) + 0.5f) * scale;
+            int const first = int(floorf(center - radius));
+            int const last = int(ceilf(center + radius));
+
+            float totalWeight = 0.f;
+            for (int srcIndex = first; srcIndex <= last; ++srcIndex)
+            {
+                float const weight = EvaluateFilter(filter, (float(srcIndex) + 0.5f - center) / scale);
+                if (weight == 0.f)
+                    continue;
+
+                int const clampedIndex = std::clamp(srcIndex, 0, srcSize - 1);
+                if (!taps.empty() && taps.back().index == clampedIndex)
+                    taps.back().weight += weight;
+                else
+                    taps.push_back({ clampedIndex, weight });
+                totalWeight += weight;
+            }
+
+            if (totalWeight != 0.f)
+            {
+                for (FilterTap& tap : taps)
+                    tap.weight /= totalWeight;
+            }
+        }
+        return result;
+    }
+
+    // Calls 'function(firstRow, lastRow)' for bands of rows in parallel tasks
+    template<typename F>
+    void ParallelForRowBands(int rows, F const& function)
+    {
+        int const rowsPerTask = 32;
+        for (int firstRow = 0; firstRow < rows; firstRow += rowsPerTask)
+        {
+            int const lastRow = std::min(rows, firstRow + rowsPerTask);
+            StartAsyncTask([&function, firstRow, lastRow]()
+            {
+                function(firstRow, lastRow);
+            });
+        }
+        WaitForAllTasks();
+    }
+
+    bool HasNormalChannels(MipGenerationTexture const& texture)
+    {
+        return std::all_of(texture.normalChannels.begin(), texture.normalChannels.end(),
+            [&texture](int channel) { return channel >= 0 && channel < texture.numChannels; });
+    }
+
+    // Renormalizes the normals and clamps the values of one filtered row, same as MipFilter.hlsl
+    void PostProcessRow(MipGenerationTexture const& texture, bool hasNormals, float* row, int width)
+    {
+        int const channels = texture.numChannels;
+        for (int x = 0; x < width; ++x)
+        {
+            float* pixel = row + x * channels;
+
+            if (hasNormals)
+            {
+                float normal[3];
+                for (int i = 0; i < 3; ++i)
+                    normal[i] = pixel[texture.normalChannels[i]] * 2.f - 1.f;
+                float const length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                if (length > 0.f)
+                {
+                    for (int i = 0; i < 3; ++i)
+                        pixel[texture.normalChannels[i]] = normal[i] / length * 0.5f + 0.5f;
+                }
+            }
+
+            if (texture.clampToUnitRange)
+            {
+                for (int ch = 0; ch < channels; ++ch)
+                    pixel[ch] = std::clamp(pixel[ch], 0.f, 1.f);
+            }
+        }
+    }
+
+    bool WriteFilteredLevel(ntc::ITextureSet* textureSet, MipGenerationTexture const& texture, int mip,
+        void const* data, int width, int height, size_t pixelStride, size_t rowPitch)
+    {
+        ntc::ColorSpace const linearColorSpaces[4] = {
+            ntc::ColorSpace::Linear, ntc::ColorSpace::Linear, ntc::ColorSpace::Linear, ntc::ColorSpace::Linear };
+
+        ntc::WriteChannelsParameters writeParams;
+        writeParams.mipLevel = mip;
+        writeParams.firstChannel = texture.firstChannel;
+        writeParams.numChannels = texture.numChannels;
+        writeParams.pData = data;
+        writeParams.addressSpace = ntc::AddressSpace::Host;
+        writeParams.width = width;
+        writeParams.height = height;
+        writeParams.pixelStride = pixelStride;
+        writeParams.rowPitch = rowPitch;
+        writeParams.channelFormat = ntc::ChannelFormat::FLOAT32;
+        writeParams.srcColorSpaces = linearColorSpaces;
+        writeParams.dstColorSpaces = texture.colorSpaces.data();
+
+        ntc::Status const ntcStatus = textureSet->WriteChannels(writeParams);
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to write MIP %d for channels %d-%d, code = %s\n%s\n", mip,
+                texture.firstChannel, texture.firstChannel + texture.numChannels - 1,
+                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
+        return true;
+    }
+
+    // Creates the structured buffers with the tap ranges and the taps for one filter direction
+    void CreateTapBuffers(nvrhi::IDevice* device, nvrhi::ICommandList* commandList,
+        std::vector<std::vector<FilterTap>> const& taps, nvrhi::BufferHandle& outRanges, nvrhi::BufferHandle& outTaps)
+    {
+        std::vector<uint2> ranges;
+        std::vector<MipFilterTap> flatTaps;
+        ranges.reserve(taps.size());
+        for (std::vector<FilterTap> const& destTaps : taps)
+        {
+            ranges.push_back(uint2(uint32_t(flatTaps.size()), uint32_t(destTaps.size())));
+            for (FilterTap const& tap : destTaps)
+                flatTaps.push_back({ uint32_t(tap.index), tap.weight });
+        }
+        if (flatTaps.empty())
+            flatTaps.push_back({ 0, 0.f });
+
+        auto bufferDesc = nvrhi::BufferDesc()
+            .setStructStride(sizeof(uint2))
+            .setByteSize(ranges.size() * sizeof(uint2))
+            .setInitialState(nvrhi::ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName("MipFilterTapRanges");
+        outRanges = device->createBuffer(bufferDesc);
+
+        bufferDesc
+            .setStructStride(sizeof(MipFilterTap))
+            .setByteSize(flatTaps.size() * sizeof(MipFilterTap))
+            .setDebugName("MipFilterTaps");
+        outTaps = device->createBuffer(bufferDesc);
+
+        commandList->writeBuffer(outRanges, ranges.data(), ranges.size() * sizeof(uint2));
+        commandList->writeBuffer(outTaps, flatTaps.data(), flatTaps.size() * sizeof(MipFilterTap));
+    }
+}
+
+std::optional<MipFilter> ParseMipFilter(char const* filter)
+{
+    if (!filter || !filter[0])
+        return MipFilter::Box;
+
+    std::string uppercaseFilter = filter;
+    UppercaseString(uppercaseFilter);
+
+    if (uppercaseFilter == "BOX")
+        return MipFilter::Box;
+    if (uppercaseFilter == "KAISER")
+        return MipFilter::Kaiser;
+    if (uppercaseFilter == "LANCZOS")
+        return MipFilter::Lanczos;
+
+    return std::optional<MipFilter>();
+}
+
+bool GenerateMipsWithFilter(ntc::ITextureSet* textureSet, std::vector<MipGenerationTexture> const& textures,
+    MipFilter filter)
+{
+    ntc::TextureSetDesc const& desc = textureSet->GetDesc();
+    ntc::ColorSpace const linearColorSpaces[4] = {
+        ntc::ColorSpace::Linear, ntc::ColorSpace::Linear, ntc::ColorSpace::Linear, ntc::ColorSpace::Linear };
+
+    for (MipGenerationTexture const& texture : textures)
+    {
+        int const channels = texture.numChannels;
+        size_t const pixelStride = sizeof(float) * size_t(channels);
+        int width = desc.width;
+        int height = desc.height;
+
+        std::vector<float> level(size_t(width) * size_t(height) * size_t(channels));
+
+        ntc::ReadChannelsParameters readParams;
+        readParams.page = ntc::TextureDataPage::Reference;
+        readParams.mipLevel = 0;
+        readParams.firstChannel = texture.firstChannel;
+        readParams.numChannels = channels;
+        readParams.pOutData = level.data();
+        readParams.addressSpace = ntc::AddressSpace::Host;
+        readParams.width = width;
+        readParams.height = height;
+        readParams.pixelStride = pixelStride;
+        readParams.rowPitch = pixelStride * size_t(width);
+        readParams.channelFormat = ntc::ChannelFormat::FLOAT32;
+        readParams.dstColorSpaces = linearColorSpaces;
+        readParams.useDithering = false;
+
+        ntc::Status ntcStatus = textureSet->ReadChannels(readParams);
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to read channels %d-%d for MIP generation, code = %s\n%s\n",
+                texture.firstChannel, texture.firstChannel + channels - 1,
+                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
+
+        bool const hasNormals = HasNormalChannels(texture);
+
+        std::vector<float> next;
+        for (int mip = 1; mip < desc.mips; ++mip)
+        {
+            int const nextWidth = std::max(1, desc.width >> mip);
+            int const nextHeight = std::max(1, desc.height >> mip);
+
+            std::vector<std::vector<FilterTap>> const tapsX = ComputeFilterTaps(filter, width, nextWidth);
+            std::vector<std::vector<FilterTap>> const tapsY = ComputeFilterTaps(filter, height, nextHeight);
+
+            // Separable filter: every band of destination rows resamples the source rows that it uses first,
+            // then the columns. The bands overlap by the filter radius, which is cheaper than keeping
+            // the horizontally resampled level in memory.
+            next.assign(size_t(nextWidth) * size_t(nextHeight) * size_t(channels), 0.f);
+            ParallelForRowBands(nextHeight, [&](int firstRow, int lastRow)
+            {
+                int firstSourceRow = height;
+                int lastSourceRow = -1;
+                for (int row = firstRow; row < lastRow; ++row)
+                {
+                    for (FilterTap const& tap : tapsY[row])
+                    {
+                        firstSourceRow = std::min(firstSourceRow, tap.index);
+                        lastSourceRow = std::max(lastSourceRow, tap.index);
+                    }
+                }
+                if (lastSourceRow < firstSourceRow)
+                    return;
+
+                size_t const horizontalRowSize = size_t(nextWidth) * size_t(channels);
+                std::vector<float> horizontal(size_t(lastSourceRow - firstSourceRow + 1) * horizontalRowSize, 0.f);
+                for (int sourceRow = firstSourceRow; sourceRow <= lastSourceRow; ++sourceRow)
+                {
+                    float const* src = level.data() + size_t(sourceRow) * size_t(width) * size_t(channels);
+                    float* dst = horizontal.data() + size_t(sourceRow - firstSourceRow) * horizontalRowSize;
+                    for (int x = 0; x < nextWidth; ++x)
+                    {
+                        for (FilterTap const& tap : tapsX[x])
+                        {
+                            for (int ch = 0; ch < channels; ++ch)
+                                dst[x * channels + ch] += src[tap.index * channels + ch] * tap.weight;
+                        }
+                    }
+                }
+
+                for (int row = firstRow; row < lastRow; ++row)
+                {
+                    float* dst = next.data() + size_t(row) * horizontalRowSize;
+                    for (FilterTap const& tap : tapsY[row])
+                    {
+                        float const* src = horizontal.data() + size_t(tap.index - firstSourceRow) * horizontalRowSize;
+                        for (size_t index = 0; index < horizontalRowSize; ++index)
+                            dst[index] += src[index] * tap.weight;
+                    }
+
+                    PostProcessRow(texture, hasNormals, dst, nextWidth);
+                }
+            });
+
+            if (!WriteFilteredLevel(textureSet, texture, mip, next.data(), nextWidth, nextHeight,
+                pixelStride, pixelStride * size_t(nextWidth)))
+                return false;
+
+            std::swap(level, next);
+            width = nextWidth;
+            height = nextHeight;
+        }
+    }
+
+    return true;
+}
+
+bool GenerateMipsWithFilterOnDevice(nvrhi::IDevice* device, ntc::ITextureSet* textureSet,
+    std::vector<MipGenerationTexture> const& textures, MipFilter filter)
+{
+    // Batch mode loads texture sets on several threads, and they all share the graphics device
+    static std::mutex deviceMutex;
+    std::lock_guard lock(deviceMutex);
+
+    donut::engine::ShaderFactory shaderFactory(device, nullptr, std::filesystem::path());
+    nvrhi::ShaderHandle horizontalShader = shaderFactory.CreateStaticPlatformShader(
+        DONUT_MAKE_PLATFORM_SHADER(g_MipFilter_HorizontalCS), nullptr,
+        nvrhi::ShaderDesc().setShaderType(nvrhi::ShaderType::Compute).setEntryName("HorizontalCS"));
+    nvrhi::ShaderHandle verticalShader = shaderFactory.CreateStaticPlatformShader(
+        DONUT_MAKE_PLATFORM_SHADER(g_MipFilter_VerticalCS), nullptr,
+        nvrhi::ShaderDesc().setShaderType(nvrhi::ShaderType::Compute).setEntryName("VerticalCS"));
+
+    auto bindingLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .addItem(nvrhi::BindingLayoutItem::PushConstants(0, sizeof(MipFilterConstants)))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(0))
+        .addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(1))
+        .addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(2))
+        .addItem(nvrhi::BindingLayoutItem::Texture_UAV(0));
+    nvrhi::BindingLayoutHandle bindingLayout = device->createBindingLayout(bindingLayoutDesc);
+
+    nvrhi::ComputePipelineHandle horizontalPipeline;
+    nvrhi::ComputePipelineHandle verticalPipeline;
+    if (horizontalShader && verticalShader && bindingLayout)
+    {
+        horizontalPipeline = device->createComputePipeline(nvrhi::ComputePipelineDesc()
+            .setComputeShader(horizontalShader)
+            .addBindingLayout(bindingLayout));
+        verticalPipeline = device->createComputePipeline(nvrhi::ComputePipelineDesc()
+            .setComputeShader(verticalShader)
+            .addBindingLayout(bindingLayout));
+    }
+
+    if (!horizontalPipeline || !verticalPipeline)
+    {
+        fprintf(stderr, "Failed to create the MIP filter pipelines.\n");
+        return false;
+    }
+
+    nvrhi::CommandListHandle commandList = device->createCommandList();
+    ntc::TextureSetDesc const& desc = textureSet->GetDesc();
+    ntc::ColorSpace const linearColorSpaces[4] = {
+        ntc::ColorSpace::Linear, ntc::ColorSpace::Linear, ntc::ColorSpace::Linear, ntc::ColorSpace::Linear };
+
+    for (MipGenerationTexture const& texture : textures)
+    {
+        int const channels = texture.numChannels;
+        int width = desc.width;
+        int height = desc.height;
+
+        // UNORM data is read in linear space, so UNORM16 keeps the precision of 8-bit sRGB inputs
+        bool const isUnorm = texture.clampToUnitRange;
+        size_t const uploadPixelStride = sizeof(uint16_t) * 4;
+        std::vector<uint16_t> uploadData(size_t(width) * size_t(height) * 4, 0);
+
+        ntc::ReadChannelsParameters readParams;
+        readParams.page = ntc::TextureDataPage::Reference;
+        readParams.mipLevel = 0;
+        readParams.firstChannel = texture.firstChannel;
+        readParams.numChannels = channels;
+        readParams.pOutData = uploadData.data();
+        readParams.addressSpace = ntc::AddressSpace::Host;
+        readParams.width = width;
+        readParams.height = height;
+        readParams.pixelStride = uploadPixelStride;
+        readParams.rowPitch = uploadPixelStride * size_t(width);
+        readParams.channelFormat = isUnorm ? ntc::ChannelFormat::UNORM16 : ntc::ChannelFormat::FLOAT16;
+        readParams.dstColorSpaces = linearColorSpaces;
+        readParams.useDithering = false;
+
+        ntc::Status const ntcStatus = textureSet->ReadChannels(readParams);
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to read channels %d-%d for MIP generation, code = %s\n%s\n",
+                texture.firstChannel, texture.firstChannel + channels - 1,
+                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
+
+        auto textureDesc = nvrhi::TextureDesc()
+            .setWidth(width)
+            .setHeight(height)
+            .setFormat(isUnorm ? nvrhi::Format::RGBA16_UNORM : nvrhi::Format::RGBA16_FLOAT)
+            .setInitialState(nvrhi::ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName("MipFilterSource");
+        nvrhi::TextureHandle source = device->createTexture(textureDesc);
+        if (!source)
+        {
+            fprintf(stderr, "Failed to create the MIP filter source texture.\n");
+            return false;
+        }
+
+        commandList->open();
+        commandList->writeTexture(source, 0, 0, uploadData.data(), readParams.rowPitch);
+        commandList->close();
+        device->executeCommandList(commandList);
+        std::vector<uint16_t>().swap(uploadData);
+
+        bool const hasNormals = HasNormalChannels(texture);
+        MipFilterConstants constants {};
+        constants.normalChannelsXY = hasNormals ? int2(texture.normalChannels[0], texture.normalChannels[1]) : int2(-1);
+        constants.normalChannelZ = hasNormals ? texture.normalChannels[2] : -1;
+        constants.clampToUnitRange = texture.clampToUnitRange;
+
+        for (int mip = 1; mip < desc.mips; ++mip)
+        {
+            int const nextWidth = std::max(1, desc.width >> mip);
+            int const nextHeight = std::max(1, desc.height >> mip);
+
+            textureDesc
+                .setWidth(nextWidth)
+                .setHeight(height)
+                .setFormat(nvrhi::Format::RGBA32_FLOAT)
+                .setIsUAV(true)
+                .setDebugName("MipFilterHorizontal");
+            nvrhi::TextureHandle horizontal = device->createTexture(textureDesc);
+
+            textureDesc
+                .setHeight(nextHeight)
+                .setDebugName("MipFilterDest");
+            nvrhi::TextureHandle dest = device->createTexture(textureDesc);
+            nvrhi::StagingTextureHandle staging = device->createStagingTexture(textureDesc, nvrhi::CpuAccessMode::Read);
+
+            if (!horizontal || !dest || !staging)
+            {
+                fprintf(stderr, "Failed to create the MIP filter textures for MIP %d.\n", mip);
+                return false;
+            }
+
+            commandList->open();
+
+            nvrhi::BufferHandle rangesX, tapsX, rangesY, tapsY;
+            CreateTapBuffers(device, commandList, ComputeFilterTaps(filter, width, nextWidth), rangesX, tapsX);
+            CreateTapBuffers(device, commandList, ComputeFilterTaps(filter, height, nextHeight), rangesY, tapsY);
+
+            auto filterPass = [&](nvrhi::IComputePipeline* pipeline, nvrhi::ITexture* input, nvrhi::IBuffer* ranges,
+                nvrhi::IBuffer* taps, nvrhi::ITexture* output, int outputWidth, int outputHeight)
+            {
+                auto bindingSetDesc = nvrhi::BindingSetDesc()
+                    .addItem(nvrhi::BindingSetItem::PushConstants(0, sizeof(MipFilterConstants)))
+                    .addItem(nvrhi::BindingSetItem::Texture_SRV(0, input))
+                    .addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(1, ranges))
+                    .addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(2, taps))
+                    .addItem(nvrhi::BindingSetItem::Texture_UAV(0, output));
+                nvrhi::BindingSetHandle bindingSet = device->createBindingSet(bindingSetDesc, bindingLayout);
+
+                commandList->setComputeState(nvrhi::ComputeState()
+                    .setPipeline(pipeline)
+                    .addBindingSet(bindingSet));
+
+                constants.destSize = uint2(outputWidth, outputHeight);
+                commandList->setPushConstants(&constants, sizeof(constants));
+                commandList->dispatch((outputWidth + MIP_FILTER_GROUP_SIZE - 1) / MIP_FILTER_GROUP_SIZE,
+                    (outputHeight + MIP_FILTER_GROUP_SIZE - 1) / MIP_FILTER_GROUP_SIZE);
+            };
+
+            filterPass(horizontalPipeline, source, rangesX, tapsX, horizontal, nextWidth, height);
+            filterPass(verticalPipeline, horizontal, rangesY, tapsY, dest, nextWidth, nextHeight);
+
+            nvrhi::TextureSlice const slice;
+            commandList->copyTexture(staging, slice, dest, slice);
+            commandList->close();
+            device->executeCommandList(commandList);
+            device->waitForIdle();
+
+            size_t rowPitch = 0;
+            void const* mappedData = device->mapStagingTexture(staging, slice, nvrhi::CpuAccessMode::Read, &rowPitch);
+            if (!mappedData)
+            {
+                fprintf(stderr, "Failed to map the MIP filter staging texture for MIP %d.\n", mip);
+                return false;
+            }
+
+            bool const written = WriteFilteredLevel(textureSet, texture, mip, mappedData, nextWidth, nextHeight,
+                sizeof(float) * 4, rowPitch);
+            device->unmapStagingTexture(staging);
+            if (!written)
+                return false;
+
+            // Only the last filtered level stays on the device as the source of the next one
+            source = dest;
+            width = nextWidth;
+            height = nextHeight;
+            device->runGarbageCollection();
+        }
+    }
+
+    return true;
+}
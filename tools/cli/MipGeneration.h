@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <libntc/ntc.h>
+#include <nvrhi/nvrhi.h>
+#include <array>
+#include <optional>
+#include <vector>
+
+enum class MipFilter
+{
+    Box,     // Uses ITextureSet::GenerateMips
+    Kaiser,
+    Lanczos,
+};
+
+std::optional<MipFilter> ParseMipFilter(char const* filter);
+
+// Describes a range of texture set channels that are filtered together.
+struct MipGenerationTexture
+{
+    int firstChannel = 0;
+    int numChannels = 0;
+    // Color spaces that the channels are stored in. Filtering happens in linear space,
+    // so sRGB data is decoded before filtering and encoded again afterwards.
+    std::array<ntc::ColorSpace, 4> colorSpaces = {
+        ntc::ColorSpace::Linear, ntc::ColorSpace::Linear, ntc::ColorSpace::Linear, ntc::ColorSpace::Linear };
+    // Offsets of the channels that contain the XYZ components of a normal map, relative to 'firstChannel',
+    // or -1 if there is no normal map. Normal vectors are renormalized after filtering.
+    std::array<int, 3> normalChannels = { -1, -1, -1 };
+    // Keep the filtered values in the [0, 1] range, used for UNORM data because Kaiser and Lanczos filters overshoot.
+    bool clampToUnitRange = true;
+};
+
+// Generates mip levels 1 and above from mip 0 in the reference page of the texture set using a windowed sinc
+// filter. Textures are processed one at a time, and the bands of rows of each level are filtered in parallel tasks,
+// so only the source and destination levels of one texture are kept in memory.
+bool GenerateMipsWithFilter(ntc::ITextureSet* textureSet, std::vector<MipGenerationTexture> const& textures,
+    MipFilter filter);
+
+// Same as GenerateMipsWithFilter, but the filter runs in compute shaders on the graphics device. Mip 0 is read into
+// host memory in a 16-bit format for the upload, and every filtered level is read back and written into
+// the texture set before the next one is filtered from its device copy.
+bool GenerateMipsWithFilterOnDevice(nvrhi::IDevice* device, ntc::ITextureSet* textureSet,
+    std::vector<MipGenerationTexture> const& textures, MipFilter filter);
@@ -10,22 +10,46 @@
  * its affiliates is strictly prohibited.
  */
 
+#include <algorithm>
 #include <argparse.h>
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include <cmath>
+#include <condition_variable>
 #include <cuda_runtime_api.h>
+#include <deque>
 #include <donut/app/DeviceManager.h>
 #include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <json/value.h>
+#include <json/writer.h>
 #include <libntc/ntc.h>
+#include <mutex>
+#include <ntc-utils/CompressedFileStream.h>
 #include <ntc-utils/DeviceUtils.h>
 #include <ntc-utils/GraphicsDecompressionPass.h>
 #include <ntc-utils/Manifest.h>
+#include <ntc-utils/ManifestIndex.h>
+#include <ntc-utils/MappedFileStream.h>
+#include <ntc-utils/MaterialAtlas.h>
 #include <ntc-utils/Misc.h>
+#include <ntc-utils/PooledAllocator.h>
 #include <ntc-utils/Semantics.h>
+#include <ntc-utils/TextureContainer.h>
+#include <ntc-utils/TextureSetArchive.h>
+#include <ntc-utils/TextureSetDescriptor.h>
 #include <nvrhi/utils.h>
+#include <sstream>
 #include <stb_image.h>
+#include <thread>
 #include <tinyexr.h>
+#include "CompressionCache.h"
+#include "DecompressionBenchmark.h"
 #include "GraphicsPasses.h"
+#include "MipGeneration.h"
+#include "Telemetry.h"
 #include "Utils.h"
 
 namespace fs = std::filesystem;
@@ -37,23 +61,40 @@ struct
     const char* saveImagesPath = nullptr;
     const char* loadCompressedFileName = nullptr;
     const char* saveCompressedFileName = nullptr;
+    const char* batchFileName = nullptr;
+    const char* batchReportFileName = nullptr;
+    const char* telemetryFileName = nullptr;
+    const char* batchIndexFileName = nullptr;
+    const char* saveArchiveFileName = nullptr;
+    const char* packArchivePath = nullptr;
+    const char* describeJsonPath = nullptr;
+    const char* cacheDirectory = nullptr;
+    const char* warmStartFileName = nullptr;
     ToolInputType inputType = ToolInputType::None;
     std::vector<char const*> loadImagesList;
+    std::vector<char const*> materialInputs; // Manifests and image directories, in the order they were specified
+    std::vector<int> batchCudaDevices;
     std::optional<ntc::BlockCompressedFormat> bcFormat;
     ImageContainer imageFormat = ImageContainer::Auto;
+    MipFilter mipFilter = MipFilter::Box;
     int networkVersion = NTC_NETWORK_UNKNOWN;
     bool compress = false;
     bool decompress = false;
     bool loadMips = false;
+    bool atlas = false;
     bool saveMips = false;
+    bool compressFile = false;
+    CompressedFilePageFormat compressFileFormat = CompressedFilePageFormat::Deflate;
     bool generateMips = false;
     bool optimizeBC = false;
     bool useVulkan = false;
     bool useDX12 = false;
     bool debug = false;
     bool listAdapters = false;
+    bool cpuAdapter = false;
     bool listCudaDevices = false;
     bool describe = false;
+    bool allocatorStats = false;
     bool discardMaskedOutPixels = false;
     bool enableCoopVec = true;
     bool enableCoopVecInt8 = true;
@@ -69,10 +110,21 @@ struct
     int adapterIndex = -1;
     int cudaDevice = 0;
     int benchmarkIterations = 1;
+    int benchmarkWarmup = 3;
+    const char* benchmarkJsonFileName = nullptr;
+    int parallelSearch = 1;
+    int loadMemoryBudgetMB = 2048;
+    int cacheSizeLimitMB = 0;
+    int pngCompressionLevel = c_DefaultPngCompressionLevel;
     float experimentalKnob = 0.f;
     float bitsPerPixel = NAN; // Use an "undefined" value to tell if something came from the command line
     float targetPsnr = NAN;
     float maxBitsPerPixel = NAN;
+    float earlyStopPsnr = NAN;
+    float earlyStopMargin = 0.f;
+    int plateauIterations = 0;
+    float plateauThreshold = 0.05f;
+    int warmStartSteps = 0;
     bool matchBcPsnr = false;
     float minBcPsnr = 0.f;
     float maxBcPsnr = INFINITY;
@@ -81,28 +133,104 @@ struct
     float bcPsnrThreshold = 0.2f;
     std::optional<int> customWidth;
     std::optional<int> customHeight;
+    std::vector<std::string> decompressTextureNames; // Empty means all textures
+    int decompressFirstMip = 0;
+    int decompressLastMip = -1; // Negative means no --mipRange
+    ntc::Rect decompressRegion{}; // Empty means the entire image
     ntc::CompressionSettings compressionSettings;
 } g_options;
 
+// Graphics device for the compute passes that run while the images are loaded, such as the --mipFilter filters.
+// Null when the tool runs without --vk or --dx12.
+static nvrhi::IDevice* g_imageProcessingDevice = nullptr;
+
+// Parses the --cudaDevices value: either "all" or a comma-separated list of device indices.
+static bool ParseCudaDeviceList(char const* devicesString, std::vector<int>& outDevices)
+{
+    int count = 0;
+    cudaError_t const err = cudaGetDeviceCount(&count);
+    if (err != cudaSuccess)
+    {
+        fprintf(stderr, "Call to cudaGetDeviceCount failed, error code = %s.\n", cudaGetErrorName(err));
+        return false;
+    }
+
+    outDevices.clear();
+    if (!strcmp(devicesString, "all"))
+    {
+        for (int device = 0; device < count; ++device)
+            outDevices.push_back(device);
+    }
+    else
+    {
+        std::istringstream stream(devicesString);
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            char* end = nullptr;
+            long const device = strtol(item.c_str(), &end, 10);
+            if (item.empty() || *end != 0 || device < 0 || device >= count)
+            {
+                fprintf(stderr, "Invalid CUDA device '%s' in --cudaDevices, must be between 0 and %d.\n",
+                    item.c_str(), count - 1);
+                return false;
+            }
+
+            if (std::find(outDevices.begin(), outDevices.end(), int(device)) != outDevices.end())
+            {
+                fprintf(stderr, "CUDA device %ld is listed in --cudaDevices more than once.\n", device);
+                return false;
+            }
+
+            outDevices.push_back(int(device));
+        }
+    }
+
+    if (outDevices.empty())
+    {
+        fprintf(stderr, "No CUDA devices selected with --cudaDevices.\n");
+        return false;
+    }
+
+    return true;
+}
+
 bool ProcessCommandLine(int argc, const char** argv)
 {
     const char* bcFormatString = nullptr;
     const char* imageFormatString = nullptr;
     const char* networkVersionString = nullptr;
+    const char* mipFilterString = nullptr;
+    const char* compressFileFormatString = nullptr;
     const char* dimensionsString = nullptr;
+    const char* cudaDevicesString = nullptr;
+    const char* texturesString = nullptr;
+    const char* mipRangeString = nullptr;
+    const char* regionString = nullptr;
 
     struct argparse_option options[] = {
         OPT_GROUP("Actions:"),
+        OPT_STRING (0,   "batch", &g_options.batchFileName, "Process multiple manifests or image directories listed in the specified file ('-' for stdin), one job per line, or found anywhere under the specified directory"),
+        OPT_STRING (0,   "batchIndex", &g_options.batchIndexFileName, "When using --batch with a directory, cache the directory listings in the specified file to speed up the next scan"),
+        OPT_STRING (0,   "batchReport", &g_options.batchReportFileName, "When using --batch, write per-job timings and results into the specified CSV file"),
+        OPT_STRING (0,   "saveArchive", &g_options.saveArchiveFileName, "Pack the texture sets produced by --batch or found by --packArchive into the specified archive file"),
+        OPT_STRING (0,   "packArchive", &g_options.packArchivePath, "Pack all .ntc files found anywhere under the specified directory into the --saveArchive file"),
+        OPT_STRING (0,   "cache", &g_options.cacheDirectory, "Reuse compression results stored in the specified directory when the inputs and settings match, and store new results there"),
         OPT_BOOLEAN('c', "compress", &g_options.compress, "Perform NTC compression"),
         OPT_BOOLEAN('D', "decompress", &g_options.decompress, "Perform NTC decompression (implied when needed)"),
         OPT_BOOLEAN('d', "describe", &g_options.describe, "Describe the contents of a compressed texture set"),
+        OPT_STRING (0,   "describeJson", &g_options.describeJsonPath, "Print the metadata of the specified .ntc file, or of all .ntc files found anywhere under the specified directory, as JSON lines, without using the GPU"),
         OPT_BOOLEAN('g', "generateMips", &g_options.generateMips, "Generate MIP level images before compression"),
+        OPT_STRING (0,   "mipFilter", &mipFilterString, "Filter for --generateMips: box (default), kaiser, lanczos"),
         OPT_STRING (0,   "loadCompressed", &g_options.loadCompressedFileName, "Load compressed texture set from the specified file"),
         OPT_STRING (0,   "loadImages", &g_options.loadImagesPath, "Load channel images from the specified folder"),
         OPT_STRING (0,   "loadManifest", &g_options.loadManifestFileName, "Load channel images and their parameters using the specified JSON manifest file"),
+        OPT_BOOLEAN(0,   "atlas", &g_options.atlas, "Pack the materials from multiple manifests or image directories into one texture set with a shared network, and save their locations into <saveCompressed>.atlas.json"),
         OPT_BOOLEAN(0,   "loadMips", &g_options.loadMips, "Load MIP level images from <loadImages>/mips/<texture>.<mip>.<ext> before compression"),
         OPT_BOOLEAN(0,   "optimizeBC", &g_options.optimizeBC, "Run slow BC compression and store acceleration info in the NTC package"),
         OPT_STRING ('o', "saveCompressed", &g_options.saveCompressedFileName, "Save compressed texture set into the specified file"),
+        OPT_BOOLEAN(0,   "compressFile", &g_options.compressFile, "Deflate the saved texture set file in 64 KB pages to make it smaller on disk"),
+        OPT_STRING (0,   "compressFileFormat", &compressFileFormatString, "Page format for --compressFile: zlib (default), gdeflate. GDeflate needs a build with DirectStorage, otherwise zlib is used"),
         OPT_STRING ('i', "saveImages", &g_options.saveImagesPath, "Save channel images into the specified folder"),
         OPT_BOOLEAN(0,   "saveMips", &g_options.saveMips, "Save MIP level images into <saveImages>/mips/ after decompression"),
         OPT_BOOLEAN(0,   "version", &g_options.printVersion, "Print version information and exit"),
@@ -121,38 +249,57 @@ bool ProcessCommandLine(int argc, const char** argv)
         OPT_INTEGER(0, "lowResQuantBits", &g_options.lowResQuantBits, "Number of bits to use for encoding of low-resolution features"),
         
         OPT_GROUP("Training process controls:"),
+        OPT_FLOAT  (0,   "earlyStopMargin", &g_options.earlyStopMargin, "When using --targetPsnr or --matchBcPsnr, stop experiments that are this many dB above or below the target"),
+        OPT_FLOAT  (0,   "earlyStopPsnr", &g_options.earlyStopPsnr, "Stop training when the intermediate PSNR reaches the provided value"),
         OPT_FLOAT  (0,   "gridLearningRate", &g_options.compressionSettings.gridLearningRate, "Maximum learning rate for the feature grid"),
         OPT_INTEGER(0,   "kPixelsPerBatch", &g_options.compressionSettings.kPixelsPerBatch, "Number of kilopixels from the image to process in one training step"),
         OPT_FLOAT  (0,   "networkLearningRate", &g_options.compressionSettings.networkLearningRate, "Maximum learning rate for the MLP weights"),
+        OPT_INTEGER(0,   "plateauIterations", &g_options.plateauIterations, "Stop training when the PSNR improves by less than --plateauThreshold over this many iterations"),
+        OPT_FLOAT  (0,   "plateauThreshold", &g_options.plateauThreshold, "PSNR improvement in dB that --plateauIterations considers a plateau, default value is 0.05"),
         OPT_INTEGER(0,   "randomSeed", &g_options.compressionSettings.randomSeed, "Random seed, set to a nonzero value to get more stable compression results"),
         OPT_BOOLEAN(0,   "stableTraining", &g_options.compressionSettings.stableTraining, "Use a more expensive but more numerically stable training algorithm for reproducible results"),
         OPT_INTEGER(0,   "stepsPerIteration", &g_options.compressionSettings.stepsPerIteration, "Training steps between progress reports"),
         OPT_INTEGER('S', "trainingSteps", &g_options.compressionSettings.trainingSteps, "Total training step count"),
+        OPT_STRING (0,   "warmStart", &g_options.warmStartFileName, "Initialize the latents and weights from the specified compressed texture set and fine-tune them"),
+        OPT_INTEGER(0,   "warmStartSteps", &g_options.warmStartSteps, "Training step count when using --warmStart, default is 1/4 of --trainingSteps"),
         OPT_BOOLEAN(0,   "fp8weights", &g_options.compressionSettings.trainFP8Weights, "Train a separate set of weights for FP8 inference (default on, use --no-fp8weights)"),
         
         OPT_GROUP("Output settings:"),
         OPT_STRING ('B', "bcFormat", &bcFormatString, "Set or override the BCn encoding format, BC1-BC7"),
         OPT_STRING ('F', "imageFormat", &imageFormatString, "Set the output file format for color images: Auto (default), BMP, JPG, TGA, PNG, PNG16, EXR"),
+        OPT_INTEGER(0,   "pngCompression", &g_options.pngCompressionLevel, "Compression level for PNG output, [0, 9], lower is faster, default is 4"),
         OPT_STRING (0,   "dimensions", &dimensionsString, "Set the dimensions of the NTC texture set before compression, in the 'WxH' format"),
+        OPT_STRING (0,   "textures", &texturesString, "With graphics API decompression, decompress only the textures with the specified comma-separated names"),
+        OPT_STRING (0,   "mipRange", &mipRangeString, "With graphics API decompression, decompress only the MIP levels in the specified range, 'N' or 'First-Last'"),
+        OPT_STRING (0,   "region", &regionString, "With graphics API decompression, decompress only the specified rectangle, 'X,Y,WxH' in the pixels of the first decompressed MIP level"),
         
         OPT_GROUP("Advanced settings:"),
+        OPT_STRING (0,   "telemetry", &g_options.telemetryFileName, "Write progress and results as versioned JSON lines into the specified file, or '-' for stdout mixed with the regular output"),
+        OPT_BOOLEAN(0,   "allocatorStats", &g_options.allocatorStats, "Print the host memory allocation statistics of the NTC library at exit, and per device with --batch"),
         OPT_FLOAT  (0,   "bcPsnrThreshold", &g_options.bcPsnrThreshold, "PSNR loss threshold for BC7 optimization, in dB, default value is 0.2"),
         OPT_INTEGER(0,   "bcQuality", &g_options.bcQuality, "Quality knob for BC7 compression, [0, 255]"),
         OPT_INTEGER(0,   "benchmark", &g_options.benchmarkIterations, "Number of iterations to run over compute passes for benchmarking"),
+        OPT_STRING (0,   "benchmarkJson", &g_options.benchmarkJsonFileName, "Time graphics API decompression of the loaded texture set per mip, texture and math version, and save the statistics into a JSON file"),
+        OPT_INTEGER(0,   "benchmarkWarmup", &g_options.benchmarkWarmup, "With --benchmarkJson, number of untimed iterations before each measurement, default is 3"),
+        OPT_INTEGER(0,   "cacheSizeLimit", &g_options.cacheSizeLimitMB, "Maximum size of the --cache directory in MB, least recently used results are removed first, 0 for unlimited"),
         OPT_BOOLEAN(0,   "discardMaskedOutPixels", &g_options.discardMaskedOutPixels, "Ignore contents of pixels where alpha mask is 0.0 (requires the AlphaMask semantic)"),
         OPT_FLOAT  (0,   "experimentalKnob", &g_options.experimentalKnob, "A parameter for NTC development, normally has no effect"),
+        OPT_INTEGER(0,   "loadMemoryBudget", &g_options.loadMemoryBudgetMB, "Maximum amount of decoded image data kept in memory while loading images, in MB, 0 for unlimited, default is 2048"),
         OPT_BOOLEAN(0,   "matchBcPsnr", &g_options.matchBcPsnr, "Perform compression parameter search to reach the PSNR value that BCn encoding provides"),
         OPT_FLOAT  (0,   "minBcPsnr", &g_options.minBcPsnr, "When using --matchBcPsnr, minimum PSNR value to use for NTC compression"),
         OPT_FLOAT  (0,   "maxBcPsnr", &g_options.maxBcPsnr, "When using --matchBcPsnr, maximum PSNR value to use for NTC compression"),
         OPT_FLOAT  (0,   "bcPsnrOffset", &g_options.bcPsnrOffset, "When using --matchBcPsnr, offset to apply to BCn PSNR value before NTC compression"),
         OPT_STRING ('V', "networkVersion", &networkVersionString, "Network version to use for compression: auto, small, medium, large, xlarge"),
+        OPT_INTEGER(0,   "parallelSearch", &g_options.parallelSearch, "When using --targetPsnr or --matchBcPsnr, number of experiments to train at the same time, default is 1"),
         
         OPT_GROUP("GPU and Graphics API settings:"),
         OPT_INTEGER(0, "adapter", &g_options.adapterIndex, "Index of the graphics adapter to use"),
+        OPT_BOOLEAN(0, "cpuAdapter", &g_options.cpuAdapter, "Use a software implementation of the graphics API that runs on the CPU, such as WARP or llvmpipe"),
         OPT_BOOLEAN(0, "coopVec", &g_options.enableCoopVec, "Enable all CoopVec extensions (default on, use --no-coopVec)"),
         OPT_BOOLEAN(0, "coopVecFP8", &g_options.enableCoopVecFP8, "Enable CoopVec extensions for FP8 math (default on, use --no-coopVecFP8)"),
         OPT_BOOLEAN(0, "coopVecInt8", &g_options.enableCoopVecInt8, "Enable CoopVec extensions for Int8 math (default on, use --no-coopVecInt8)"),
         OPT_INTEGER(0, "cudaDevice", &g_options.cudaDevice, "Index of the CUDA device to use"),
+        OPT_STRING (0, "cudaDevices", &cudaDevicesString, "With --batch, distribute the jobs across a comma-separated list of CUDA devices, or 'all'"),
         OPT_BOOLEAN(0, "debug", &g_options.debug, "Enable debug features such as Vulkan validation layer or D3D12 debug runtime"),
         OPT_BOOLEAN(0, "dp4a", &g_options.enableDP4a, "Enable DP4a instructions (default on, use --no-dp4a)"),
 #if NTC_WITH_DX12
@@ -207,6 +354,12 @@ bool ProcessCommandLine(int argc, const char** argv)
         return false;
     }
 
+    if (g_options.cpuAdapter && (!useGapi || g_options.adapterIndex >= 0))
+    {
+        fprintf(stderr, "Option --cpuAdapter requires either --dx12 or --vk, and cannot be used with --adapter.\n");
+        return false;
+    }
+
     if (!g_options.enableCoopVec)
     {
         g_options.enableCoopVecInt8 = false;
@@ -224,6 +377,7 @@ bool ProcessCommandLine(int argc, const char** argv)
         }
 
         UpdateToolInputType(g_options.inputType, ToolInputType::Directory);
+        g_options.materialInputs.push_back(g_options.loadImagesPath);
     }
 
     if (g_options.loadManifestFileName)
@@ -235,6 +389,7 @@ bool ProcessCommandLine(int argc, const char** argv)
         }
 
         UpdateToolInputType(g_options.inputType, ToolInputType::Manifest);
+        g_options.materialInputs.push_back(g_options.loadManifestFileName);
     }
 
     if (g_options.loadCompressedFileName)
@@ -260,6 +415,7 @@ bool ProcessCommandLine(int argc, const char** argv)
         {
             UpdateToolInputType(g_options.inputType, ToolInputType::Directory);
             g_options.loadImagesPath = arg;
+            g_options.materialInputs.push_back(arg);
         }
         else if (fs::exists(argPath))
         {
@@ -270,13 +426,14 @@ bool ProcessCommandLine(int argc, const char** argv)
             {
                 UpdateToolInputType(g_options.inputType, ToolInputType::Manifest);
                 g_options.loadManifestFileName = arg;
+                g_options.materialInputs.push_back(arg);
             }
             else if (extension == ".ntc")
             {
                 UpdateToolInputType(g_options.inputType, ToolInputType::CompressedTextureSet);
                 g_options.loadCompressedFileName = arg;
             }
-            else if (IsSupportedImageFileExtension(extension))
+            else if (IsSupportedImageFileExtension(extension) || IsTextureContainerFileExtension(extension))
             {
                 UpdateToolInputType(g_options.inputType, ToolInputType::Images);
                 g_options.loadImagesList.push_back(arg);
@@ -294,7 +451,121 @@ bool ProcessCommandLine(int argc, const char** argv)
         }
     }
 
-    if (g_options.inputType == ToolInputType::None)
+    if (g_options.atlas)
+    {
+        // Multiple manifests or directories are normally rejected as mixed inputs, but here each one is a material
+        if (!g_options.loadImagesList.empty() || g_options.loadCompressedFileName || g_options.batchFileName ||
+            g_options.materialInputs.size() < 2)
+        {
+            fprintf(stderr, "Option --atlas requires two or more manifests or image directories as the inputs, "
+                "and cannot be used with other inputs or --batch.\n");
+            return false;
+        }
+
+        if (!g_options.compress || !g_options.saveCompressedFileName)
+        {
+            fprintf(stderr, "Option --atlas requires --compress and --saveCompressed.\n");
+            return false;
+        }
+
+        if (g_options.loadMips || dimensionsString)
+        {
+            fprintf(stderr, "Option --atlas cannot be used with --loadMips or --dimensions, "
+                "the atlas is made from the MIP 0 images at their original size.\n");
+            return false;
+        }
+
+        g_options.inputType = ToolInputType::MaterialAtlas;
+    }
+
+    if (g_options.batchFileName)
+    {
+        if (g_options.inputType != ToolInputType::None)
+        {
+            fprintf(stderr, "Option --batch cannot be combined with other inputs.\n");
+            return false;
+        }
+
+        if (!g_options.compress)
+        {
+            fprintf(stderr, "Option --batch requires --compress.\n");
+            return false;
+        }
+
+        if (g_options.saveImagesPath || g_options.saveCompressedFileName)
+        {
+            fprintf(stderr, "Options --saveImages and --saveCompressed cannot be used with --batch, "
+                "output files are specified in the batch file.\n");
+            return false;
+        }
+
+        if (strcmp(g_options.batchFileName, "-") != 0 && !fs::exists(g_options.batchFileName))
+        {
+            fprintf(stderr, "Batch file '%s' does not exist.\n", g_options.batchFileName);
+            return false;
+        }
+
+        if (g_options.batchIndexFileName && !fs::is_directory(g_options.batchFileName))
+        {
+            fprintf(stderr, "Option --batchIndex requires --batch with a directory.\n");
+            return false;
+        }
+    }
+    else if (g_options.batchReportFileName || g_options.batchIndexFileName)
+    {
+        fprintf(stderr, "Options --batchReport and --batchIndex require --batch.\n");
+        return false;
+    }
+
+    if (g_options.packArchivePath)
+    {
+        if (g_options.inputType != ToolInputType::None || g_options.batchFileName)
+        {
+            fprintf(stderr, "Option --packArchive cannot be combined with other inputs.\n");
+            return false;
+        }
+
+        if (!g_options.saveArchiveFileName)
+        {
+            fprintf(stderr, "Option --packArchive requires --saveArchive.\n");
+            return false;
+        }
+
+        if (!fs::is_directory(g_options.packArchivePath))
+        {
+            fprintf(stderr, "Directory '%s' does not exist.\n", g_options.packArchivePath);
+            return false;
+        }
+
+        // Packing only copies existing files, none of the other options apply
+        return true;
+    }
+
+    if (g_options.describeJsonPath)
+    {
+        if (g_options.inputType != ToolInputType::None || g_options.batchFileName)
+        {
+            fprintf(stderr, "Option --describeJson cannot be combined with other inputs.\n");
+            return false;
+        }
+
+        if (!fs::exists(g_options.describeJsonPath))
+        {
+            fprintf(stderr, "File or directory '%s' does not exist.\n", g_options.describeJsonPath);
+            return false;
+        }
+
+        // Only the file headers are read, none of the other options apply
+        return true;
+    }
+
+    if (g_options.saveArchiveFileName && !g_options.batchFileName)
+    {
+        fprintf(stderr, "Option --saveArchive requires --batch or --packArchive.\n");
+        return false;
+    }
+
+    if (g_options.inputType == ToolInputType::None && !g_options.batchFileName)
     {
         fprintf(stderr, "No inputs.\n");
         return false;
@@ -307,6 +578,25 @@ bool ProcessCommandLine(int argc, const char** argv)
         return false;
     }
 
+    if (g_options.benchmarkJsonFileName)
+    {
+        if (g_options.inputType != ToolInputType::CompressedTextureSet || !useGapi || !g_options.decompress)
+        {
+            fprintf(stderr, "Option --benchmarkJson requires --loadCompressed, --decompress and --vk or --dx12.\n");
+            return false;
+        }
+
+        if (g_options.benchmarkWarmup < 0)
+        {
+            fprintf(stderr, "Invalid --benchmarkWarmup value (%d), must be 0 or more.\n", g_options.benchmarkWarmup);
+            return false;
+        }
+
+        // A single iteration doesn't give any percentiles
+        if (g_options.benchmarkIterations <= 1)
+            g_options.benchmarkIterations = 20;
+    }
+
     g_options.benchmarkIterations = std::max(g_options.benchmarkIterations, 1);
 
     if (g_options.compress && g_options.inputType == ToolInputType::CompressedTextureSet)
@@ -381,7 +671,131 @@ bool ProcessCommandLine(int argc, const char** argv)
         fprintf(stderr, "The --matchBcPsnr option requires either --vk or --dx12 (where available).");
         return false;
     }
+
+    if (!std::isnan(g_options.earlyStopPsnr) && (g_options.matchBcPsnr || !std::isnan(g_options.targetPsnr)))
+    {
+        fprintf(stderr, "The --earlyStopPsnr option cannot be used with --targetPsnr or --matchBcPsnr, "
+            "use --earlyStopMargin instead.\n");
+        return false;
+    }
+
+    if (g_options.earlyStopMargin < 0.f)
+    {
+        fprintf(stderr, "The --earlyStopMargin value (%.2f) must be 0 or more.\n", g_options.earlyStopMargin);
+        return false;
+    }
+
+    if (g_options.earlyStopMargin > 0.f && !g_options.matchBcPsnr && std::isnan(g_options.targetPsnr))
+    {
+        fprintf(stderr, "The --earlyStopMargin option requires --targetPsnr or --matchBcPsnr.\n");
+        return false;
+    }
+
+    if (g_options.plateauIterations < 0)
+    {
+        fprintf(stderr, "The --plateauIterations value (%d) must be 0 or more.\n", g_options.plateauIterations);
+        return false;
+    }
+
+    if (g_options.parallelSearch < 1 || g_options.parallelSearch > 8)
+    {
+        fprintf(stderr, "The --parallelSearch value (%d) must be between 1 and 8.\n", g_options.parallelSearch);
+        return false;
+    }
+
+    if (g_options.cacheDirectory)
+    {
+        if (!g_options.compress)
+        {
+            fprintf(stderr, "Option --cache requires --compress.\n");
+            return false;
+        }
+
+        if (g_options.inputType == ToolInputType::CompressedTextureSet)
+        {
+            fprintf(stderr, "Option --cache requires images or a manifest as the input.\n");
+            return false;
+        }
+
+        if (!g_options.saveCompressedFileName && !g_options.batchFileName)
+        {
+            fprintf(stderr, "Option --cache requires --saveCompressed or --batch.\n");
+            return false;
+        }
+    }
+
+    if (g_options.warmStartFileName)
+    {
+        if (!g_options.compress || g_options.batchFileName)
+        {
+            fprintf(stderr, "Option --warmStart requires --compress and cannot be used with --batch.\n");
+            return false;
+        }
+
+        if (g_options.matchBcPsnr || !std::isnan(g_options.targetPsnr))
+        {
+            fprintf(stderr, "Option --warmStart cannot be used with --targetPsnr or --matchBcPsnr, "
+                "the compression parameter search changes the latent shape between experiments.\n");
+            return false;
+        }
+
+        if (!fs::exists(g_options.warmStartFileName))
+        {
+            fprintf(stderr, "Warm start file '%s' does not exist.\n", g_options.warmStartFileName);
+            return false;
+        }
+    }
+    
+    if (g_options.compressFile && !g_options.saveCompressedFileName && !g_options.batchFileName)
+    {
+        fprintf(stderr, "Option --compressFile requires --saveCompressed or --batch.\n");
+        return false;
+    }
+
+    if (compressFileFormatString)
+    {
+        if (!strcmp(compressFileFormatString, "zlib"))
+            g_options.compressFileFormat = CompressedFilePageFormat::Deflate;
+        else if (!strcmp(compressFileFormatString, "gdeflate"))
+            g_options.compressFileFormat = CompressedFilePageFormat::GDeflate;
+        else
+        {
+            fprintf(stderr, "Invalid --compressFileFormat value '%s'.\n", compressFileFormatString);
+            return false;
+        }
+
+        if (g_options.compressFileFormat == CompressedFilePageFormat::GDeflate && !IsGDeflateCodecAvailable())
+        {
+            printf("Warning: GDeflate is not available in this build, --compressFile will use zlib pages.\n");
+        }
+    }
+
+    if (g_options.warmStartSteps < 0)
+    {
+        fprintf(stderr, "The --warmStartSteps value (%d) must be 0 or more.\n", g_options.warmStartSteps);
+        return false;
+    }
+
+    if (g_options.cacheSizeLimitMB < 0)
+    {
+        fprintf(stderr, "The --cacheSizeLimit value (%d) must be 0 or more.\n", g_options.cacheSizeLimitMB);
+        return false;
+    }
+
+    if (g_options.loadMemoryBudgetMB < 0)
+    {
+        fprintf(stderr, "The --loadMemoryBudget value (%d) must be 0 or more.\n", g_options.loadMemoryBudgetMB);
+        return false;
+    }
     
+    if (g_options.pngCompressionLevel < c_MinPngCompressionLevel ||
+        g_options.pngCompressionLevel > c_MaxPngCompressionLevel)
+    {
+        fprintf(stderr, "The --pngCompression value (%d) must be between %d and %d.\n", g_options.pngCompressionLevel,
+            c_MinPngCompressionLevel, c_MaxPngCompressionLevel);
+        return false;
+    }
+
     if (bcFormatString)
     {
         g_options.bcFormat = ParseBlockCompressedFormat(bcFormatString, /* enableAuto = */ true);
@@ -392,6 +806,17 @@ bool ProcessCommandLine(int argc, const char** argv)
         }
     }
     
+    if (mipFilterString)
+    {
+        auto parsedFilter = ParseMipFilter(mipFilterString);
+        if (!parsedFilter.has_value())
+        {
+            fprintf(stderr, "Invalid --mipFilter value '%s'.\n", mipFilterString);
+            return false;
+        }
+        g_options.mipFilter = parsedFilter.value();
+    }
+
     if (imageFormatString)
     {
         auto parsedFormat = ParseImageContainer(imageFormatString);
@@ -447,6 +872,97 @@ bool ProcessCommandLine(int argc, const char** argv)
         g_options.customHeight = height;
     }
 
+    if (texturesString || mipRangeString || regionString)
+    {
+        if (g_options.inputType != ToolInputType::CompressedTextureSet || !useGapi || !g_options.decompress ||
+            g_options.optimizeBC || g_options.benchmarkJsonFileName)
+        {
+            fprintf(stderr, "Options --textures, --mipRange and --region require --loadCompressed, --decompress "
+                "and --vk or --dx12, and cannot be used with --optimizeBC or --benchmarkJson.\n");
+            return false;
+        }
+    }
+
+    if (texturesString)
+    {
+        std::string const names = texturesString;
+        size_t start = 0;
+        while (start <= names.size())
+        {
+            size_t end = names.find(',', start);
+            if (end == std::string::npos)
+                end = names.size();
+            if (end > start)
+                g_options.decompressTextureNames.push_back(names.substr(start, end - start));
+            start = end + 1;
+        }
+
+        if (g_options.decompressTextureNames.empty())
+        {
+            fprintf(stderr, "Invalid --textures value '%s', must be a comma-separated list of texture names.\n",
+                texturesString);
+            return false;
+        }
+    }
+
+    if (mipRangeString)
+    {
+        int first = 0, last = 0;
+        int const parsed = sscanf(mipRangeString, "%d-%d", &first, &last);
+        if (parsed == 1)
+            last = first;
+
+        if (parsed < 1 || first < 0 || last < first)
+        {
+            fprintf(stderr, "Invalid --mipRange value '%s', must be 'N' or 'First-Last' with 0 <= First <= Last.\n",
+                mipRangeString);
+            return false;
+        }
+
+        g_options.decompressFirstMip = first;
+        g_options.decompressLastMip = last;
+    }
+
+    if (regionString)
+    {
+        ntc::Rect& rect = g_options.decompressRegion;
+        if (sscanf(regionString, "%d,%d,%dx%d", &rect.left, &rect.top, &rect.width, &rect.height) != 4)
+        {
+            fprintf(stderr, "Invalid format for --region '%s', must be 'X,Y,WxH' where X, Y, W and H are integers.\n",
+                regionString);
+            return false;
+        }
+
+        if (rect.left < 0 || rect.top < 0 || rect.width <= 0 || rect.height <= 0)
+        {
+            fprintf(stderr, "Invalid values specified in --region (%d,%d,%dx%d), the position must be 0 or more "
+                "and the size must be 1x1 or more.\n", rect.left, rect.top, rect.width, rect.height);
+            return false;
+        }
+    }
+
+    if (cudaDevicesString)
+    {
+        if (!g_options.batchFileName)
+        {
+            fprintf(stderr, "Option --cudaDevices requires --batch.\n");
+            return false;
+        }
+
+        if (!ParseCudaDeviceList(cudaDevicesString, g_options.batchCudaDevices))
+            return false;
+
+        if (g_options.batchCudaDevices.size() > 1 && useGapi)
+        {
+            fprintf(stderr, "Multiple --cudaDevices cannot be used with --vk or --dx12, "
+                "graphics operations are only available on a single device.\n");
+            return false;
+        }
+
+        // The context created by main serves the first device in the list
+        g_options.cudaDevice = g_options.batchCudaDevices[0];
+    }
+
     if (g_options.saveCompressedFileName)
     {
         fs::path outputPath = fs::path(g_options.saveCompressedFileName).parent_path();
@@ -584,9 +1100,12 @@ bool SaveImagesFromTextureSet(ntc::IContext* context, ntc::ITextureSet* textureS
             
             outputFileName += GetContainerExtension(container);
 
-            StartAsyncTask([&mutex, container, outputFileName, mipWidth, mipHeight, numChannels, channelFormat, data, &anyErrors]()
+            int const pngCompressionLevel = g_options.pngCompressionLevel;
+            StartAsyncTask([&mutex, container, outputFileName, mipWidth, mipHeight, numChannels, channelFormat, data,
+                pngCompressionLevel, &anyErrors]()
             {
-                bool success = SaveImageToContainer(container, data, mipWidth, mipHeight, numChannels, outputFileName.c_str());
+                bool success = SaveImageToContainer(container, data, mipWidth, mipHeight, numChannels,
+                    outputFileName.c_str(), pngCompressionLevel);
                 
                 // The rest of this function is interlocked with other threads
                 std::lock_guard lockGuard(mutex);
@@ -598,7 +1117,7 @@ bool SaveImagesFromTextureSet(ntc::IContext* context, ntc::ITextureSet* textureS
                 }
                 else
                 {
-                    printf("Saved image '%s': %dx%d pixels, %d channels, %s.\n", outputFileName.c_str(),
+                    PrintOutput("Saved image '%s': %dx%d pixels, %d channels, %s.\n", outputFileName.c_str(),
                         mipWidth, mipHeight, numChannels, ntc::ChannelFormatToString(channelFormat));
                 }
 
@@ -633,7 +1152,7 @@ bool PickLatentShape(ntc::LatentShape& outShape)
             return false;
         }
 
-        printf("Selected latent shape for %.3f bpp: --gridSizeScale %d --highResFeatures %d --lowResFeatures %d "
+        PrintOutput("Selected latent shape for %.3f bpp: --gridSizeScale %d --highResFeatures %d --lowResFeatures %d "
             "--highResQuantBits %d --lowResQuantBits %d\n", selectedBpp, outShape.gridSizeScale, outShape.highResFeatures, outShape.lowResFeatures,
             outShape.highResQuantBits, outShape.lowResQuantBits);
     }
@@ -648,14 +1167,136 @@ bool PickLatentShape(ntc::LatentShape& outShape)
     return true;
 }
 
-ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, bool manifestIsGenerated)
+// Reads the dimensions, channel count and pixel format of an image file without decoding the pixels.
+static bool ReadImageFileInfo(std::string const& fileName, int& width, int& height, int& channels,
+    ntc::ChannelFormat& format)
 {
-    ntc::TextureSetDesc textureSetDesc{};
-    textureSetDesc.mips = 1;
-
-    ntc::LatentShape latentShape;
-    if (!PickLatentShape(latentShape))
-        return nullptr;
+    std::string extension = fs::path(fileName).extension().generic_string();
+    LowercaseString(extension);
+
+    if (extension == ".exr")
+    {
+        EXRVersion version;
+        if (ParseEXRVersionFromFile(&version, fileName.c_str()) != TINYEXR_SUCCESS)
+            return false;
+
+        EXRHeader header;
+        InitEXRHeader(&header);
+        if (ParseEXRHeaderFromFile(&header, &version, fileName.c_str(), nullptr) != TINYEXR_SUCCESS)
+            return false;
+
+        width = header.data_window.max_x - header.data_window.min_x + 1;
+        height = header.data_window.max_y - header.data_window.min_y + 1;
+        FreeEXRHeader(&header);
+
+        // LoadEXR always produces RGBA data
+        channels = 4;
+        format = ntc::ChannelFormat::FLOAT32;
+        return true;
+    }
+
+    FILE* imageFile = fopen(fileName.c_str(), "rb");
+    if (!imageFile)
+        return false;
+
+    bool const is16bit = stbi_is_16_bit_from_file(imageFile);
+    bool const infoValid = stbi_info_from_file(imageFile, &width, &height, &channels);
+    fclose(imageFile);
+
+    format = is16bit ? ntc::ChannelFormat::UNORM16 : ntc::ChannelFormat::UNORM8;
+    return infoValid;
+}
+
+static bool IsTextureContainerFile(std::string const& fileName)
+{
+    std::string extension = fs::path(fileName).extension().generic_string();
+    LowercaseString(extension);
+    return IsTextureContainerFileExtension(extension);
+}
+
+// Reads the headers of a DDS or KTX2 file, including the locations of all mip levels in the file.
+static bool ReadTextureContainerFile(std::string const& fileName, TextureContainerInfo& outInfo, std::string& outError)
+{
+    std::unique_ptr<MappedFileStream> stream = MappedFileStream::Open(fileName.c_str(), &outError);
+    if (!stream)
+    {
+        outError = "Cannot open the file: " + outError;
+        return false;
+    }
+
+    return ReadTextureContainerInfo(stream->GetData(0, stream->Size()), stream->Size(), outInfo, outError);
+}
+
+// Decodes an image file with a format previously returned by ReadImageFileInfo.
+// The returned data must be released with stbi_image_free.
+static stbi_uc* DecodeImageFile(std::string const& fileName, ntc::ChannelFormat format, int desiredChannels,
+    int& width, int& height)
+{
+    if (format == ntc::ChannelFormat::FLOAT32)
+    {
+        float* data = nullptr;
+        if (LoadEXR(&data, &width, &height, fileName.c_str(), nullptr) != TINYEXR_SUCCESS)
+            return nullptr;
+        return (stbi_uc*)data;
+    }
+
+    FILE* imageFile = fopen(fileName.c_str(), "rb");
+    if (!imageFile)
+        return nullptr;
+
+    int channels = 0;
+    stbi_uc* data;
+    if (format == ntc::ChannelFormat::UNORM16)
+        data = (stbi_uc*)stbi_load_from_file_16(imageFile, &width, &height, &channels, desiredChannels);
+    else
+        data = stbi_load_from_file(imageFile, &width, &height, &channels, desiredChannels);
+
+    fclose(imageFile);
+    return data;
+}
+
+// Limits the total size of decoded images that exist at the same time.
+// A zero budget means no limit. A single image that is larger than the budget is still
+// allowed when nothing else is decoded at the same time.
+class DecodeMemoryBudget
+{
+public:
+    DecodeMemoryBudget(size_t budget)
+        : m_budget(budget)
+    { }
+
+    void Acquire(size_t size)
+    {
+        std::unique_lock lock(m_mutex);
+        m_condition.wait(lock, [this, size]()
+            { return m_budget == 0 || m_used == 0 || m_used + size <= m_budget; });
+        m_used += size;
+    }
+
+    void Release(size_t size)
+    {
+        {
+            std::lock_guard lockGuard(m_mutex);
+            m_used -= size;
+        }
+        m_condition.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    size_t m_budget;
+    size_t m_used = 0;
+};
+
+ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, bool manifestIsGenerated)
+{
+    ntc::TextureSetDesc textureSetDesc{};
+    textureSetDesc.mips = 1;
+
+    ntc::LatentShape latentShape;
+    if (!PickLatentShape(latentShape))
+        return nullptr;
 
     // Count the number of MIP 0 images in the manifest
     int numMipZeroImages = 0;
@@ -688,33 +1329,20 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
         int width = 0;
         int height = 0;
         int channels = 0;
+        int decodedChannels = 0; // Channel count of the pixel data produced by DecodeImageFile
         int storedChannels = 0;
         int alphaMaskChannel = -1;
+        int normalChannel = -1; // First of the 3 source channels with the Normal semantic
         int firstChannel = -1;
         int manifestIndex = 0;
         bool verticalFlip = false;
         std::string channelSwizzle;
-        std::array<stbi_uc*, NTC_MAX_MIPS> data {};
+        std::array<std::string, NTC_MAX_MIPS> fileNames {}; // Empty names for missing mips
         std::string name;
         ntc::ChannelFormat channelFormat = ntc::ChannelFormat::UNORM8;
         ntc::BlockCompressedFormat bcFormat = ntc::BlockCompressedFormat::None;
         bool isSRGB = false;
-
-        SourceImageData()
-        { }
-
-        SourceImageData(SourceImageData& other) = delete;
-        SourceImageData(SourceImageData&& other) = delete;
-
-        ~SourceImageData()
-        {
-            for (auto mipLevel : data)
-            {
-                if (mipLevel)
-                    stbi_image_free((void*)mipLevel);
-            }
-            data.fill(nullptr);
-        }
+        std::optional<TextureContainerInfo> container; // Set for DDS and KTX2 files
     };
 
     std::vector<std::shared_ptr<SourceImageData>> images;
@@ -723,7 +1351,8 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
 
     bool anyErrors = false;
 
-    // Load the base images (mip level 0)
+    // Read the headers of the base images (mip level 0).
+    // The pixels are decoded later, after the texture set is created, see below.
 
     int entryIndex = 0;
     for (const auto& entry : manifest.textures)
@@ -736,44 +1365,32 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
             std::shared_ptr<SourceImageData> image = std::make_shared<SourceImageData>();
 
             fs::path const fileName = entry.fileName;
-            std::string extension = fileName.extension().generic_string();
-            LowercaseString(extension);
-
-            if (extension == ".exr")
+            bool infoValid;
+            std::string containerError;
+            if (IsTextureContainerFile(entry.fileName))
             {
-                LoadEXR((float**)&image->data[0], &image->width, &image->height, entry.fileName.c_str(), nullptr);
-                image->channels = 4;
-                image->channelFormat = ntc::ChannelFormat::FLOAT32;
+                TextureContainerInfo& container = image->container.emplace();
+                infoValid = ReadTextureContainerFile(entry.fileName, container, containerError);
+                image->width = container.width;
+                image->height = container.height;
+                image->channels = container.channels;
+                image->channelFormat = container.channelFormat;
             }
             else
             {
-                FILE* imageFile = fopen(entry.fileName.c_str(), "rb");
-                if (imageFile)
-                {
-                    bool is16bit = stbi_is_16_bit_from_file(imageFile);
-                    fseek(imageFile, 0, SEEK_SET);
-
-                    if (is16bit)
-                    {
-                        image->data[0] = (stbi_uc*)stbi_load_from_file_16(imageFile, &image->width, &image->height, &image->channels, STBI_rgb_alpha);
-                        image->channelFormat = ntc::ChannelFormat::UNORM16;
-                    }
-                    else
-                    {
-                        image->data[0] = stbi_load_from_file(imageFile, &image->width, &image->height, &image->channels, STBI_rgb_alpha);
-                        image->channelFormat = ntc::ChannelFormat::UNORM8;
-                    }
-
-                    fclose(imageFile);
-                }
+                infoValid = ReadImageFileInfo(entry.fileName, image->width, image->height, image->channels,
+                    image->channelFormat);
             }
 
             // The rest of this function is interlocked with other threads
             std::lock_guard lockGuard(mutex);
 
-            if (!image->data[0])
+            if (!infoValid)
             {
-                fprintf(stderr, "Failed to read image '%s'.\n", entry.fileName.c_str());
+                if (containerError.empty())
+                    fprintf(stderr, "Failed to read image '%s'.\n", entry.fileName.c_str());
+                else
+                    fprintf(stderr, "Failed to read image '%s': %s\n", entry.fileName.c_str(), containerError.c_str());
                 anyErrors = true;
                 return;
             }
@@ -784,11 +1401,51 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
             image->firstChannel = entry.firstChannel;
             image->manifestIndex = entryIndex;
             image->verticalFlip = entry.verticalFlip;
-            
-            printf("Loaded image '%s': %dx%d pixels, %d channels.\n", fileName.filename().generic_string().c_str(),
-                image->width, image->height, image->channels);
+            image->fileNames[0] = entry.fileName;
 
             image->channelSwizzle = entry.channelSwizzle;
+
+            if (image->container)
+            {
+                TextureContainerInfo const& container = *image->container;
+
+                // Container data is uploaded as stored, 2-channel data is RG and not grey-alpha
+                image->decodedChannels = image->channels;
+                if (container.isSRGB)
+                    image->isSRGB = true;
+
+                // The mips are read from the same file, unless they will be generated
+                if (!g_options.generateMips)
+                {
+                    for (int mip = 1; mip < container.mips; ++mip)
+                        image->fileNames[mip] = entry.fileName;
+                    textureSetDesc.mips = std::max(textureSetDesc.mips, container.mips);
+                }
+
+                // Map the RGBA channels to the BGRA storage order through the swizzle
+                if (container.isBGR)
+                {
+                    if (image->channelSwizzle.empty())
+                        image->channelSwizzle = "RGBA";
+                    for (char& ch : image->channelSwizzle)
+                        ch = (ch == 'R') ? 'B' : (ch == 'B') ? 'R' : ch;
+                }
+
+                PrintOutput("Loaded image '%s': %dx%d pixels, %d channels, %d mips.\n",
+                    fileName.filename().generic_string().c_str(), image->width, image->height, image->channels,
+                    image->fileNames[1].empty() ? 1 : container.mips);
+            }
+            else
+            {
+                // LoadEXR always produces RGBA data, and 2-channel images are expanded to RGBA by stb_image
+                // to produce (grey, grey, grey, alpha), which is what the channel mapping below expects.
+                image->decodedChannels = (image->channels == 2 || image->channelFormat == ntc::ChannelFormat::FLOAT32)
+                    ? 4 : image->channels;
+            
+                PrintOutput("Loaded image '%s': %dx%d pixels, %d channels.\n", fileName.filename().generic_string().c_str(),
+                    image->width, image->height, image->channels);
+            }
+
             if (image->channelSwizzle.empty())
                 image->storedChannels = image->channels;
             else
@@ -801,6 +1458,10 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
                 {
                     image->alphaMaskChannel = binding.firstChannel; // Default value is -1 which means "none"
                 }
+                else if (binding.label == SemanticLabel::Normal)
+                {
+                    image->normalChannel = binding.firstChannel;
+                }
             }
 
             textureSetDesc.width = std::max(image->width, textureSetDesc.width);
@@ -862,11 +1523,17 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
             {
                 if (binding.label == SemanticLabel::AlphaMask)
                     image->alphaMaskChannel = binding.firstChannel;
+                else if (binding.label == SemanticLabel::Normal)
+                    image->normalChannel = binding.firstChannel;
             }
+
+            // sRGB formats in the container override the guess
+            if (image->container && image->container->isSRGB)
+                image->isSRGB = true;
         }
     }
 
-    // Load the other mips
+    // Validate the headers of the other mips
 
     for (const auto& entry : manifest.textures)
     {
@@ -881,48 +1548,29 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
 
         std::shared_ptr<SourceImageData> const& image = *found;
 
+        if (image->container || IsTextureContainerFile(entry.fileName))
+        {
+            std::lock_guard lockGuard(mutex);
+            fprintf(stderr, "Image '%s' cannot be used for MIP level %d of '%s': DDS and KTX2 files provide "
+                "their own MIP chains.\n", entry.fileName.c_str(), entry.mipLevel, image->name.c_str());
+            anyErrors = true;
+            continue;
+        }
+
         textureSetDesc.mips = std::max(textureSetDesc.mips, entry.mipLevel + 1);
 
         StartAsyncTask([&mutex, &image, entry, &anyErrors]()
         {
             const fs::path fileName = entry.fileName;
-            std::string extension = fileName.extension().generic_string();
-            LowercaseString(extension);
 
-            int width = 0, height = 0;
+            int width = 0, height = 0, channels = 0;
             ntc::ChannelFormat format = ntc::ChannelFormat::UNORM8;
-            if (extension == ".exr")
-            {
-                LoadEXR((float**)&image->data[entry.mipLevel], &width, &height, fileName.generic_string().c_str(), nullptr);
-                format = ntc::ChannelFormat::FLOAT32;
-            }
-            else
-            {
-                FILE* imageFile = fopen(entry.fileName.c_str(), "rb");
-                if (imageFile)
-                {
-                    bool is16bit = stbi_is_16_bit_from_file(imageFile);
-                    fseek(imageFile, 0, SEEK_SET);
-
-                    if (is16bit)
-                    {
-                        image->data[entry.mipLevel] = (stbi_uc*)stbi_load_from_file_16(imageFile, &width, &height, nullptr, STBI_rgb_alpha);
-                        format = ntc::ChannelFormat::UNORM16;
-                    }
-                    else
-                    {
-                        image->data[entry.mipLevel] = stbi_load_from_file(imageFile, &width, &height, nullptr, STBI_rgb_alpha);
-                        format = ntc::ChannelFormat::UNORM8;
-                    }
-
-                    fclose(imageFile);
-                }
-            }
+            bool const infoValid = ReadImageFileInfo(entry.fileName, width, height, channels, format);
 
             // The rest of this function is interlocked with other threads
             std::lock_guard lockGuard(mutex);
 
-            if (!image->data[entry.mipLevel])
+            if (!infoValid)
             {
                 fprintf(stderr, "Failed to read image '%s'.\n", fileName.generic_string().c_str());
                 anyErrors = true;
@@ -947,7 +1595,9 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
                 return;
             }
 
-            printf("Loaded image '%s': %dx%d pixels.\n", fileName.filename().generic_string().c_str(),
+            image->fileNames[entry.mipLevel] = entry.fileName;
+
+            PrintOutput("Loaded image '%s': %dx%d pixels.\n", fileName.filename().generic_string().c_str(),
                 width, height);
         });
     }
@@ -975,7 +1625,7 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
     if (textureSetDesc.width * 2 < textureSetFeatures.stagingWidth ||
         textureSetDesc.height * 2 < textureSetFeatures.stagingHeight)
     {
-        printf("Warning: Texture set dimensions (%dx%d) are less than 1/2 of the maximum input image dimensions "
+        PrintOutput("Warning: Texture set dimensions (%dx%d) are less than 1/2 of the maximum input image dimensions "
                "(%dx%d). The resize operation uses a 2x2 bilinear filter, which may produce low quality output.\n",
                textureSetDesc.width, textureSetDesc.height,
                textureSetFeatures.stagingWidth, textureSetFeatures.stagingHeight);
@@ -989,15 +1639,18 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
     }
 
 
-    // Verify that we have images for all mips
+    // Verify that we have images for all mips, also when some of them come from DDS or KTX2 files
+
+    bool const anyContainerMips = std::any_of(images.begin(), images.end(),
+        [](std::shared_ptr<SourceImageData> const& image) { return !image->fileNames[1].empty(); });
 
-    if (g_options.loadMips)
+    if (g_options.loadMips || (anyContainerMips && !g_options.generateMips))
     {
         for (auto& image : images)
         {
             for (int mip = 0; mip < textureSetDesc.mips; ++mip)
             {
-                if (!image->data[mip])
+                if (image->fileNames[mip].empty())
                 {
                     fprintf(stderr, "Channel '%s' doesn't have an image for MIP level %d.\n",
                         image->name.c_str(), mip);
@@ -1123,109 +1776,242 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
         return nullptr;
     }
     
-    // Upload the image data into the texture set
+    // Validate the swizzles before decoding anything
 
-    int alphaMaskChannel = -1;
     for (std::shared_ptr<SourceImageData> const& image : images)
     {
-        size_t const bytesPerComponent = ntc::GetBytesPerPixelComponent(image->channelFormat);
-        size_t const pixelStride = 4 * bytesPerComponent;
-        ntc::ColorSpace const srcRgbColorSpace = image->isSRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
-        ntc::ColorSpace const dstRgbColorSpace = image->channelFormat == ntc::ChannelFormat::FLOAT32 ? ntc::ColorSpace::HLG : srcRgbColorSpace;
+        for (char ch : image->channelSwizzle)
+        {
+            // The format of 'channelSwizzle' is validated when the manifest is loaded,
+            // so 'channelPos' should never be NULL here.
+            char const* channelMap = "RGBA";
+            char const* channelPos = strchr(channelMap, ch);
+            assert(channelPos);
+
+            if (!channelPos || channelPos - channelMap >= image->channels)
+            {
+                fprintf(stderr, "Swizzle '%s' for texture '%s' requests the '%c' channel, which does not exist "
+                    "in the source texture (it only has %d channels).\n",
+                    image->channelSwizzle.c_str(), image->name.c_str(), ch, image->channels);
+                return nullptr;
+            }
+        }
+    }
+
+    // Upload the image data into the texture set.
+    // Images are decoded in parallel and written into the texture set one at a time, and the decoded pixels
+    // are released right after that. The total size of decoded images that exist at the same time is limited
+    // by --loadMemoryBudget. Images are decoded with their native channel count, except for 2-channel images
+    // which are expanded to RGBA (grey, grey, grey, alpha).
+
+    int alphaMaskChannel = -1;
+
+    auto uploadImage = [&textureSet, &alphaMaskChannel](SourceImageData const& image, int mip, int decodedChannels,
+        uint8_t const* data)
+    {
+        size_t const bytesPerComponent = ntc::GetBytesPerPixelComponent(image.channelFormat);
+        size_t const pixelStride = size_t(decodedChannels) * bytesPerComponent;
+        bool const isFloat = image.channelFormat == ntc::ChannelFormat::FLOAT32 ||
+            image.channelFormat == ntc::ChannelFormat::FLOAT16;
+        ntc::ColorSpace const srcRgbColorSpace = image.isSRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
+        ntc::ColorSpace const dstRgbColorSpace = isFloat ? ntc::ColorSpace::HLG : srcRgbColorSpace;
         ntc::ColorSpace const srcAlphaColorSpace = ntc::ColorSpace::Linear;
-        ntc::ColorSpace const dstAlphaColorSpace = image->channelFormat == ntc::ChannelFormat::FLOAT32 ? ntc::ColorSpace::HLG : srcAlphaColorSpace;
+        ntc::ColorSpace const dstAlphaColorSpace = isFloat ? ntc::ColorSpace::HLG : srcAlphaColorSpace;
         ntc::ColorSpace const srcColorSpaces[4] = { srcRgbColorSpace, srcRgbColorSpace, srcRgbColorSpace, srcAlphaColorSpace };
         ntc::ColorSpace const dstColorSpaces[4] = { dstRgbColorSpace, dstRgbColorSpace, dstRgbColorSpace, dstAlphaColorSpace };
 
-        for (int mip = 0; mip < textureSetDesc.mips; ++mip)
+        int mipWidth = std::max(1, image.width >> mip);
+        int mipHeight = std::max(1, image.height >> mip);
+
+        ntc::WriteChannelsParameters params;
+        params.mipLevel = mip;
+        params.addressSpace = ntc::AddressSpace::Host;
+        params.width = mipWidth;
+        params.height = mipHeight;
+        params.pixelStride = pixelStride;
+        params.rowPitch = size_t(mipWidth) * pixelStride;
+        params.channelFormat = image.channelFormat;
+        params.verticalFlip = image.verticalFlip;
+
+        ntc::Status ntcStatus = ntc::Status::Ok;
+        if (image.channelSwizzle.empty())
         {
-            if (!image->data[mip])
-                continue;
-
-            int mipWidth = std::max(1, image->width >> mip);
-            int mipHeight = std::max(1, image->height >> mip);
-
-            ntc::WriteChannelsParameters params;
-            params.mipLevel = mip;
-            params.addressSpace = ntc::AddressSpace::Host;
-            params.width = mipWidth;
-            params.height = mipHeight;
-            params.pixelStride = pixelStride;
-            params.rowPitch = size_t(mipWidth) * pixelStride;
-            params.channelFormat = image->channelFormat;
-            params.verticalFlip = image->verticalFlip;
+            // No swizzle - write all channels at once
+            params.firstChannel = image.firstChannel;
+            params.numChannels = image.channels;
+            params.pData = data;
+            params.srcColorSpaces = srcColorSpaces;
+            params.dstColorSpaces = dstColorSpaces;
+
+            ntcStatus = textureSet->WriteChannels(params);
             
-            if (image->channelSwizzle.empty())
-            {
-                // No swizzle - write all channels at once
-                params.firstChannel = image->firstChannel;
-                params.numChannels = image->channels;
-                params.pData = image->data[mip];
-                params.srcColorSpaces = srcColorSpaces;
-                params.dstColorSpaces = dstColorSpaces;
+            if (mip == 0 && image.alphaMaskChannel >= 0)
+                alphaMaskChannel = image.alphaMaskChannel + image.firstChannel;
+        }
+        else
+        {
+            int dstChannelOffset = 0;
 
-                ntcStatus = textureSet->WriteChannels(params);
+            // Loop over the swizzled channels and upload each one individually
+            for (char ch : image.channelSwizzle)
+            {
+                // Decode the channel letter into an offset using a lookup string, validated above
+                char const* channelMap = "RGBA";
+                int const srcChannelOffset = int(strchr(channelMap, ch) - channelMap);
+
+                // Write one channel
+                params.firstChannel = image.firstChannel + dstChannelOffset;
+                params.numChannels = 1;
+                params.pData = data + srcChannelOffset * bytesPerComponent;
+                params.srcColorSpaces = srcColorSpaces + srcChannelOffset;
+                params.dstColorSpaces = dstColorSpaces + dstChannelOffset;
                 
-                if (mip == 0 && image->alphaMaskChannel >= 0)
-                    alphaMaskChannel = image->alphaMaskChannel + image->firstChannel;
+                ntcStatus = textureSet->WriteChannels(params);
+
+                // Just check the return code, a failure message will be printed below
+                if (ntcStatus != ntc::Status::Ok)
+                    break;
+
+                // If this channel was the alpha mask in the image before swizzle,
+                // store its index in the texture set after swizzle.
+                if (mip == 0 && srcChannelOffset == image.alphaMaskChannel)
+                    alphaMaskChannel = image.firstChannel + dstChannelOffset;
+
+                ++dstChannelOffset;
             }
-            else
+        }
+
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to upload texture data to NTC texture set, code = %s\n%s\n",
+                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
+
+        return true;
+    };
+
+    DecodeMemoryBudget decodeMemoryBudget(size_t(g_options.loadMemoryBudgetMB) << 20);
+
+    for (std::shared_ptr<SourceImageData> const& image : images)
+    {
+        int const decodedChannels = image->decodedChannels;
+
+        for (int mip = 0; mip < textureSetDesc.mips; ++mip)
+        {
+            if (image->fileNames[mip].empty())
+                continue;
+
+            if (image->container)
             {
-                int dstChannelOffset = 0;
+                // Uncompressed container data is uploaded directly from the mapped file,
+                // only BCn data needs to be decoded into a temporary buffer.
+                bool const isCompressed = image->container->blockFormat != ntc::BlockCompressedFormat::None;
+                size_t const decodedSize = isCompressed ? size_t(std::max(1, image->width >> mip))
+                    * size_t(std::max(1, image->height >> mip)) * size_t(decodedChannels)
+                    * ntc::GetBytesPerPixelComponent(image->channelFormat) : 0;
 
-                // Loop over the swizzled channels and upload each one individually
-                for (char ch : image->channelSwizzle)
+                decodeMemoryBudget.Acquire(decodedSize);
+
+                StartAsyncTask([&mutex, &anyErrors, &uploadImage, &decodeMemoryBudget, image, mip, decodedChannels,
+                    decodedSize, isCompressed]()
                 {
-                    // Decode the channel letter into an offset using a lookup string
-                    char const* channelMap = "RGBA";
-                    char const* channelPos = strchr(channelMap, ch);
-                    if (!channelPos)
+                    std::string const& fileName = image->fileNames[mip];
+                    TextureContainerMip const& mipData = image->container->mipData[mip];
+
+                    std::unique_ptr<MappedFileStream> stream = MappedFileStream::Open(fileName.c_str());
+                    uint8_t const* data = stream
+                        ? static_cast<uint8_t const*>(stream->GetData(mipData.offset, mipData.size))
+                        : nullptr;
+
+                    std::vector<uint8_t> decodedData;
+                    if (data && isCompressed)
                     {
-                        // The format of 'channelSwizzle' is validated when the manifest is loaded,
-                        // so 'channelPos' should never be NULL here.
-                        assert(false);
-                        return nullptr;
+                        decodedData.resize(decodedSize);
+                        bool const decoded = DecodeBlockCompressedImage(image->container->blockFormat,
+                            image->container->isSigned, data, mipData.size, std::max(1, image->width >> mip),
+                            std::max(1, image->height >> mip), decodedData.data());
+                        data = decoded ? decodedData.data() : nullptr;
                     }
 
-                    int const srcChannelOffset = channelPos - channelMap;
-                    if (srcChannelOffset >= image->channels)
                     {
-                        fprintf(stderr, "Swizzle '%s' for texture '%s' requests the '%c' channel, which does not exist "
-                            "in the source texture (it only has %d channels).\n",
-                            image->channelSwizzle.c_str(), image->name.c_str(), ch, image->channels);
-                        return nullptr;
+                        std::lock_guard lockGuard(mutex);
+
+                        if (anyErrors)
+                        {
+                            // Something else failed already, don't bother
+                        }
+                        else if (!data)
+                        {
+                            fprintf(stderr, "Failed to read MIP level %d from '%s'.\n", mip, fileName.c_str());
+                            anyErrors = true;
+                        }
+                        else if (!uploadImage(*image, mip, decodedChannels, data))
+                        {
+                            anyErrors = true;
+                        }
                     }
 
-                    // Write one channel
-                    params.firstChannel = image->firstChannel + dstChannelOffset;
-                    params.numChannels = 1;
-                    params.pData = image->data[mip] + srcChannelOffset * bytesPerComponent;
-                    params.srcColorSpaces = srcColorSpaces + srcChannelOffset;
-                    params.dstColorSpaces = dstColorSpaces + dstChannelOffset;
-                    
-                    ntcStatus = textureSet->WriteChannels(params);
-
-                    // Just check the return code, a failure message will be printed below
-                    if (ntcStatus != ntc::Status::Ok)
-                        break;
-
-                    // If this channel was the alpha mask in the image before swizzle,
-                    // store its index in the texture set after swizzle.
-                    if (mip == 0 && srcChannelOffset == image->alphaMaskChannel)
-                        alphaMaskChannel = image->firstChannel + dstChannelOffset;
-
-                    ++dstChannelOffset;
-                }
+                    decodedData = std::vector<uint8_t>();
+                    decodeMemoryBudget.Release(decodedSize);
+                });
+                continue;
             }
 
-            if (ntcStatus != ntc::Status::Ok)
+            size_t const decodedSize = size_t(std::max(1, image->width >> mip)) * size_t(std::max(1, image->height >> mip))
+                * size_t(decodedChannels) * ntc::GetBytesPerPixelComponent(image->channelFormat);
+
+            // Wait until previously started decodes release enough memory
+            decodeMemoryBudget.Acquire(decodedSize);
+
+            StartAsyncTask([&mutex, &anyErrors, &uploadImage, &decodeMemoryBudget, image, mip, decodedChannels,
+                decodedSize]()
             {
-                fprintf(stderr, "Failed to upload texture data to NTC texture set, code = %s\n%s\n",
-                    ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-                return nullptr;
-            }
+                std::string const& fileName = image->fileNames[mip];
+                
+                int width = 0, height = 0;
+                stbi_uc* data = DecodeImageFile(fileName, image->channelFormat, decodedChannels, width, height);
+
+                {
+                    // Uploads are serialized, decoding of other images continues in the meantime
+                    std::lock_guard lockGuard(mutex);
+
+                    if (anyErrors)
+                    {
+                        // Something else failed already, don't bother
+                    }
+                    else if (!data || width != std::max(1, image->width >> mip) ||
+                        height != std::max(1, image->height >> mip))
+                    {
+                        fprintf(stderr, "Failed to read image '%s'.\n", fileName.c_str());
+                        anyErrors = true;
+                    }
+                    else if (!uploadImage(*image, mip, decodedChannels, data))
+                    {
+                        anyErrors = true;
+                    }
+                }
+
+                if (data)
+                    stbi_image_free(data);
+
+                decodeMemoryBudget.Release(decodedSize);
+            });
         }
-        
+    }
+
+    WaitForAllTasks();
+
+    if (anyErrors)
+    {
+        return nullptr;
+    }
+
+    for (std::shared_ptr<SourceImageData> const& image : images)
+    {
+        ntc::ColorSpace const srcRgbColorSpace = image->isSRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
+        ntc::ColorSpace const srcAlphaColorSpace = ntc::ColorSpace::Linear;
+
         ntc::ITextureMetadata* texture = textureSet->AddTexture();
         texture->SetName(image->name.c_str());
         texture->SetChannels(image->firstChannel, image->storedChannels);
@@ -1244,7 +2030,7 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
 
     // Generate the mips if requested
 
-    if (g_options.generateMips)
+    if (g_options.generateMips && g_options.mipFilter == MipFilter::Box)
     {
         ntcStatus = textureSet->GenerateMips();
         if (ntcStatus != ntc::Status::Ok)
@@ -1254,6 +2040,49 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
             return nullptr;
         }
     }
+    else if (g_options.generateMips)
+    {
+        std::vector<MipGenerationTexture> mipTextures;
+        for (std::shared_ptr<SourceImageData> const& image : images)
+        {
+            bool const isFloat = image->channelFormat == ntc::ChannelFormat::FLOAT32 ||
+                image->channelFormat == ntc::ChannelFormat::FLOAT16;
+
+            MipGenerationTexture& mipTexture = mipTextures.emplace_back();
+            mipTexture.firstChannel = image->firstChannel;
+            mipTexture.numChannels = image->storedChannels;
+            mipTexture.clampToUnitRange = !isFloat;
+
+            // Same color spaces as the ones used by uploadImage above
+            ntc::ColorSpace const rgbColorSpace = isFloat ? ntc::ColorSpace::HLG
+                : image->isSRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
+            ntc::ColorSpace const alphaColorSpace = isFloat ? ntc::ColorSpace::HLG : ntc::ColorSpace::Linear;
+            mipTexture.colorSpaces = { rgbColorSpace, rgbColorSpace, rgbColorSpace, alphaColorSpace };
+
+            // Find where the normal channels ended up after the swizzle
+            if (image->normalChannel >= 0)
+            {
+                for (int i = 0; i < 3; ++i)
+                {
+                    int const srcChannel = image->normalChannel + i;
+                    if (image->channelSwizzle.empty())
+                        mipTexture.normalChannels[i] = srcChannel < image->storedChannels ? srcChannel : -1;
+                    else
+                    {
+                        size_t const position = srcChannel < 4
+                            ? image->channelSwizzle.find("RGBA"[srcChannel]) : std::string::npos;
+                        mipTexture.normalChannels[i] = position != std::string::npos ? int(position) : -1;
+                    }
+                }
+            }
+        }
+
+        bool const mipsGenerated = g_imageProcessingDevice
+            ? GenerateMipsWithFilterOnDevice(g_imageProcessingDevice, textureSet, mipTextures, g_options.mipFilter)
+            : GenerateMipsWithFilter(textureSet, mipTextures, g_options.mipFilter);
+        if (!mipsGenerated)
+            return nullptr;
+    }
 
     // Done - detach the "smart" pointer and return the raw one
 
@@ -1263,426 +2092,2653 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest const& manifest, b
     return rawTextureSet;
 }
 
-bool CompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet, float* outFinalPsnr)
+// Directory for the packed atlas images, removed with its contents when the texture set is done.
+struct AtlasImageDirectory
 {
-    ntc::Status ntcStatus = textureSet->BeginCompression(g_options.compressionSettings);
-    CHECK_NTC_RESULT(BeginCompression);
+    fs::path path;
 
-    ntc::CompressionStats stats;
-    do
+    ~AtlasImageDirectory()
     {
-        ntcStatus = textureSet->RunCompressionSteps(&stats);
-        if (ntcStatus == ntc::Status::Incomplete || ntcStatus == ntc::Status::Ok)
-        {
-            printf("Training: %d steps, %.4f ms/step, intermediate PSNR: %.2f dB\r", stats.currentStep,
-                stats.millisecondsPerStep, ntc::LossToPSNR(stats.loss));
-            fflush(stdout);
-        }
-    } while (ntcStatus == ntc::Status::Incomplete);
-    CHECK_NTC_RESULT(RunCompressionSteps);
-    printf("\n");
-
-    ntcStatus = textureSet->FinalizeCompression();
-    CHECK_NTC_RESULT(FinalizeCompression);
-
-    if (outFinalPsnr)
-        *outFinalPsnr = ntc::LossToPSNR(stats.loss);
-
-    return true;
-}
-
-struct AdaptiveSearchResult
-{
-    std::vector<uint8_t> compressedData;
-    ntc::LatentShape latentShape;
-    float bitsPerPixel = 0.f;
-    float psnr = 0.f;
+        std::error_code errorCode;
+        if (!path.empty())
+            fs::remove_all(path, errorCode);
+    }
 };
 
-bool CompressTextureSetWithTargetPSNR(ntc::IContext* context, ntc::ITextureSet* textureSet)
+// Packs the materials from the --atlas inputs side by side into one image per texture name, so that they are
+// compressed into one texture set with a shared network. The packed images are written into 'imageDirectory',
+// and 'outManifest' refers to them with the original texture names and parameters. Every material must have
+// images of the same size, and the images with the same texture name must have the same pixel format and
+// parameters in all materials. Materials that don't have some texture get zeros in its area.
+static bool BuildMaterialAtlas(fs::path const& imageDirectory, Manifest& outManifest, bool& outManifestIsGenerated,
+    MaterialAtlasLayout& outLayout, std::vector<Manifest>& outSourceManifests)
 {
-    ntc::Status ntcStatus;
+    struct AtlasTexture
+    {
+        ManifestEntry entry; // From the first material that has this texture
+        ntc::ChannelFormat channelFormat = ntc::ChannelFormat::UNORM8;
+        int channels = 0; // Channels of the packed image, the maximum over the materials
+    };
 
-    ntc::AdaptiveCompressionSessionWrapper session(context);
+    struct AtlasImage
+    {
+        std::string fileName;
+        size_t material = 0;
+        size_t texture = 0;
+        bool verticalFlip = false;
+    };
+
+    std::vector<AtlasTexture> textures;
+    std::vector<AtlasImage> images;
+    int directoryCount = 0;
+
+    outLayout = MaterialAtlasLayout();
+    outSourceManifests.clear();
+    for (char const* input : g_options.materialInputs)
+    {
+        Manifest manifest;
+        fs::path inputPath = fs::absolute(input).lexically_normal();
+        bool const isDirectory = fs::is_directory(inputPath);
+        if (isDirectory)
+        {
+            GenerateManifestFromDirectory(input, /* loadMips = */ false, manifest);
+            ++directoryCount;
+            if (!inputPath.has_filename())
+                inputPath = inputPath.parent_path();
+        }
+        else
+        {
+            std::string manifestError;
+            if (!ReadManifestFromFile(input, manifest, manifestError))
+            {
+                fprintf(stderr, "%s\n", manifestError.c_str());
+                return false;
+            }
+
+            if (manifest.width.has_value() || manifest.height.has_value())
+            {
+                fprintf(stderr, "Manifest '%s' specifies the texture set dimensions, which is not supported "
+                    "with --atlas.\n", input);
+                return false;
+            }
+        }
+
+        size_t const materialIndex = outLayout.materials.size();
+        MaterialAtlasEntry& material = outLayout.materials.emplace_back();
+        material.name = isDirectory ? inputPath.filename().generic_string() : inputPath.stem().generic_string();
+        if (outLayout.FindMaterial(material.name) != &material)
+        {
+            fprintf(stderr, "Multiple atlas inputs have the same material name '%s'.\n", material.name.c_str());
+            return false;
+        }
+
+        for (ManifestEntry const& entry : manifest.textures)
+        {
+            if (entry.mipLevel > 0)
+            {
+                PrintOutput("Warning: Ignoring MIP level %d image '%s', the atlas MIP levels can only be generated.\n",
+                    entry.mipLevel, entry.fileName.c_str());
+                continue;
+            }
+
+            if (IsTextureContainerFile(entry.fileName))
+            {
+                fprintf(stderr, "Image '%s' cannot be used with --atlas, DDS and KTX2 files are not supported.\n",
+                    entry.fileName.c_str());
+                return false;
+            }
+
+            int width = 0, height = 0, channels = 0;
+            ntc::ChannelFormat format = ntc::ChannelFormat::UNORM8;
+            if (!ReadImageFileInfo(entry.fileName, width, height, channels, format))
+            {
+                fprintf(stderr, "Failed to read image '%s'.\n", entry.fileName.c_str());
+                return false;
+            }
+
+            if (material.width == 0)
+            {
+                material.width = width;
+                material.height = height;
+            }
+            else if (width != material.width || height != material.height)
+            {
+                fprintf(stderr, "Image '%s' has dimensions %dx%d, but the other images of material '%s' are %dx%d. "
+                    "All images of a material must have the same dimensions with --atlas.\n", entry.fileName.c_str(),
+                    width, height, material.name.c_str(), material.width, material.height);
+                return false;
+            }
+
+            auto found = std::find_if(textures.begin(), textures.end(),
+                [&entry](AtlasTexture const& texture) { return texture.entry.entryName == entry.entryName; });
+
+            if (found == textures.end())
+            {
+                AtlasTexture& texture = textures.emplace_back();
+                texture.entry = entry;
+                texture.channelFormat = format;
+                found = textures.end() - 1;
+            }
+            else if (found->channelFormat != format || found->entry.isSRGB != entry.isSRGB ||
+                found->entry.channelSwizzle != entry.channelSwizzle || found->entry.firstChannel != entry.firstChannel ||
+                found->entry.bcFormat != entry.bcFormat)
+            {
+                fprintf(stderr, "Image '%s' has a different pixel format or parameters than other images of "
+                    "texture '%s'.\n", entry.fileName.c_str(), entry.entryName.c_str());
+                return false;
+            }
+
+            // LoadEXR always produces RGBA data
+            found->channels = (format == ntc::ChannelFormat::FLOAT32) ? 4 : std::max(found->channels, channels);
+
+            size_t const textureIndex = size_t(found - textures.begin());
+            if (std::any_of(images.begin(), images.end(), [materialIndex, textureIndex](AtlasImage const& image)
+                { return image.material == materialIndex && image.texture == textureIndex; }))
+            {
+                fprintf(stderr, "Material '%s' has multiple images named '%s'.\n", material.name.c_str(),
+                    entry.entryName.c_str());
+                return false;
+            }
+
+            AtlasImage& image = images.emplace_back();
+            image.fileName = entry.fileName;
+            image.material = materialIndex;
+            image.texture = textureIndex;
+            image.verticalFlip = entry.verticalFlip;
+        }
+
+        if (material.width == 0)
+        {
+            fprintf(stderr, "No images found for material '%s'.\n", material.name.c_str());
+            return false;
+        }
+
+        outSourceManifests.push_back(std::move(manifest));
+    }
+
+    // The semantics of a generated manifest are guessed from the image names when it's loaded, and that would
+    // silently replace the semantics of the manifests
+    if (directoryCount != 0 && directoryCount != int(g_options.materialInputs.size()))
+    {
+        fprintf(stderr, "Option --atlas cannot combine manifests with image directories.\n");
+        return false;
+    }
+    outManifestIsGenerated = directoryCount != 0;
+
+    if (textures.size() > NTC_MAX_CHANNELS)
+    {
+        fprintf(stderr, "The atlas materials have too many different textures (%d).\n", int(textures.size()));
+        return false;
+    }
+
+    int const maxAtlasSize = 1 << (NTC_MAX_MIPS - 1);
+    if (!PackMaterialAtlas(outLayout, maxAtlasSize))
+    {
+        fprintf(stderr, "The materials don't fit into a %dx%d atlas.\n", maxAtlasSize, maxAtlasSize);
+        return false;
+    }
+
+    PrintOutput("Packed %d materials into a %dx%d atlas.\n", int(outLayout.materials.size()),
+        outLayout.width, outLayout.height);
+
+    // Pack one texture at a time, decoding its images in parallel. The rectangles don't overlap,
+    // so the tasks write into the atlas image without locking.
+    std::mutex mutex;
+    bool anyErrors = false;
+    outManifest = Manifest();
+
+    for (size_t textureIndex = 0; textureIndex < textures.size() && !anyErrors; ++textureIndex)
+    {
+        AtlasTexture const& texture = textures[textureIndex];
+        size_t const pixelStride = size_t(texture.channels) * ntc::GetBytesPerPixelComponent(texture.channelFormat);
+        size_t const rowPitch = size_t(outLayout.width) * pixelStride;
+        std::vector<uint8_t> atlasData(rowPitch * size_t(outLayout.height), 0);
+
+        for (AtlasImage const& image : images)
+        {
+            if (image.texture != textureIndex)
+                continue;
+
+            StartAsyncTask([&mutex, &anyErrors, &texture, &atlasData, &outLayout, &image, pixelStride, rowPitch]()
+            {
+                MaterialAtlasEntry const& material = outLayout.materials[image.material];
+
+                int width = 0, height = 0;
+                stbi_uc* data = DecodeImageFile(image.fileName, texture.channelFormat, texture.channels,
+                    width, height);
+                if (!data || width != material.width || height != material.height)
+                {
+                    std::lock_guard lockGuard(mutex);
+                    fprintf(stderr, "Failed to read image '%s'.\n", image.fileName.c_str());
+                    anyErrors = true;
+                }
+                else
+                {
+                    size_t const srcRowPitch = size_t(width) * pixelStride;
+                    for (int row = 0; row < height; ++row)
+                    {
+                        int const srcRow = image.verticalFlip ? height - 1 - row : row;
+                        memcpy(atlasData.data() + size_t(material.top + row) * rowPitch
+                            + size_t(material.left) * pixelStride, data + size_t(srcRow) * srcRowPitch, srcRowPitch);
+                    }
+                }
+
+                if (data)
+                    stbi_image_free(data);
+            });
+        }
+
+        WaitForAllTasks();
+
+        if (anyErrors)
+            break;
+
+        // The packed images are temporary, so they are saved without PNG compression and with FP32 EXR data
+        bool const isFloat = texture.channelFormat == ntc::ChannelFormat::FLOAT32;
+        bool const is16Bit = texture.channelFormat == ntc::ChannelFormat::UNORM16;
+        fs::path const fileName = imageDirectory /
+            ("texture" + std::to_string(textureIndex) + (isFloat ? ".exr" : ".png"));
+        bool const saved = isFloat
+            ? SaveEXR((float const*)atlasData.data(), outLayout.width, outLayout.height, texture.channels,
+                /* save_as_fp16 = */ false, fileName.generic_string().c_str(), /* err = */ nullptr) == TINYEXR_SUCCESS
+            : SavePNG(atlasData.data(), outLayout.width, outLayout.height, texture.channels, is16Bit,
+                fileName.generic_string().c_str(), c_MinPngCompressionLevel);
+
+        if (!saved)
+        {
+            fprintf(stderr, "Failed to save the atlas image '%s'.\n", fileName.generic_string().c_str());
+            return false;
+        }
+
+        ManifestEntry& entry = outManifest.textures.emplace_back(texture.entry);
+        entry.fileName = fileName.generic_string();
+        entry.verticalFlip = false;
+    }
+
+    if (anyErrors)
+        return false;
+
+    if (IsTelemetryEnabled())
+    {
+        Json::Value event(Json::objectValue);
+        event["width"] = outLayout.width;
+        event["height"] = outLayout.height;
+        Json::Value& materials = event["materials"] = Json::Value(Json::arrayValue);
+        for (MaterialAtlasEntry const& material : outLayout.materials)
+        {
+            Json::Value& node = materials.append(Json::Value(Json::objectValue));
+            node["name"] = material.name;
+            node["left"] = material.left;
+            node["top"] = material.top;
+            node["width"] = material.width;
+            node["height"] = material.height;
+        }
+        EmitTelemetryEvent("atlas", std::move(event));
+    }
+
+    return true;
+}
+
+// Conditions for ending the training before all --trainingSteps are done.
+struct EarlyStopCriteria
+{
+    // Stop when the intermediate PSNR reaches this value.
+    float stopPsnr = NAN;
+    // Stop when the intermediate PSNR is still below this value after half of the steps.
+    float missPsnr = NAN;
+    // Stop when the intermediate PSNR improves by less than 'plateauThreshold' over this many iterations.
+    int plateauIterations = 0;
+    float plateauThreshold = 0.f;
+    // PSNR of the latents and weights loaded with --warmStart. Stop when the first intermediate PSNR is
+    // more than g_warmStartPsnrTolerance below it, which means that the training didn't start from them.
+    float warmStartPsnr = NAN;
+};
+
+// The intermediate PSNR can drop a little after a warm start because the optimizer state is not stored
+// in the file, but training that starts from random values is much further below the loaded PSNR.
+static const float g_warmStartPsnrTolerance = 5.f;
+static char const* const g_warmStartLostReason = "the warm start data was not retained";
+
+// Returns the early stop criteria from the command line. When 'targetPsnr' is specified, i.e. for the adaptive search,
+// also stops the experiments that are clearly above or below the target, because further training won't change
+// which side of the target they end up on.
+static EarlyStopCriteria GetEarlyStopCriteria(float targetPsnr)
+{
+    EarlyStopCriteria criteria;
+    criteria.stopPsnr = g_options.earlyStopPsnr;
+    criteria.plateauIterations = g_options.plateauIterations;
+    criteria.plateauThreshold = g_options.plateauThreshold;
+
+    if (!std::isnan(targetPsnr) && g_options.earlyStopMargin > 0.f)
+    {
+        criteria.stopPsnr = targetPsnr + g_options.earlyStopMargin;
+        criteria.missPsnr = targetPsnr - g_options.earlyStopMargin;
+    }
+
+    return criteria;
+}
+
+// Tracks the intermediate PSNR values reported during training and checks them against the early stop criteria.
+// 'totalSteps' is the step count of this training run, which is smaller than --trainingSteps for warm starts.
+class EarlyStopMonitor
+{
+public:
+    EarlyStopMonitor(EarlyStopCriteria const& criteria, int totalSteps)
+        : m_criteria(criteria)
+        , m_totalSteps(totalSteps)
+    { }
+
+    // Returns the reason to stop training, or nullptr if it should continue.
+    char const* Update(int currentStep, float psnr)
+    {
+        bool const firstUpdate = !m_updated;
+        m_updated = true;
+
+        // Note: comparisons with NAN criteria are always false
+        if (firstUpdate && psnr < m_criteria.warmStartPsnr - g_warmStartPsnrTolerance)
+            return g_warmStartLostReason;
+
+        if (psnr >= m_criteria.stopPsnr)
+            return "reached the PSNR threshold";
+
+        if (currentStep * 2 >= m_totalSteps && psnr < m_criteria.missPsnr)
+            return "PSNR is too far below the target";
+
+        if (m_criteria.plateauIterations > 0)
+        {
+            m_history.push_back(psnr);
+            if (int(m_history.size()) > m_criteria.plateauIterations)
+            {
+                float const improvement = psnr - m_history.front();
+                m_history.pop_front();
+                if (improvement < m_criteria.plateauThreshold)
+                    return "PSNR has reached a plateau";
+            }
+        }
+
+        return nullptr;
+    }
+
+private:
+    EarlyStopCriteria m_criteria;
+    int m_totalSteps;
+    std::deque<float> m_history;
+    bool m_updated = false;
+};
+
+// Trains the texture set with its current latent shape. The number of training steps that were actually run,
+// which may be less than --trainingSteps when an early stop criterion is met, is added to 'outTrainingSteps'.
+// When 'settings' is NULL, the settings from the command line are used. 'outWarmStartLost' is set when
+// the training was stopped because it didn't start from the warm start data, see EarlyStopCriteria.
+bool CompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet, EarlyStopCriteria const& earlyStop,
+    float* outFinalPsnr, int* outTrainingSteps, ntc::CompressionSettings const* settings = nullptr,
+    bool* outWarmStartLost = nullptr)
+{
+    if (!settings)
+        settings = &g_options.compressionSettings;
+
+    ntc::Status ntcStatus = textureSet->BeginCompression(*settings);
+    CHECK_NTC_RESULT(BeginCompression);
+
+    EarlyStopMonitor earlyStopMonitor(earlyStop, settings->trainingSteps);
+    char const* stopReason = nullptr;
+    ntc::CompressionStats stats;
+    do
+    {
+        ntcStatus = textureSet->RunCompressionSteps(&stats);
+        if (ntcStatus == ntc::Status::Incomplete || ntcStatus == ntc::Status::Ok)
+        {
+            PrintOutput("Training: %d steps, %.4f ms/step, intermediate PSNR: %.2f dB\r", stats.currentStep,
+                stats.millisecondsPerStep, ntc::LossToPSNR(stats.loss));
+            fflush(stdout);
+
+            if (IsTelemetryEnabled())
+            {
+                Json::Value event(Json::objectValue);
+                event["step"] = stats.currentStep;
+                event["totalSteps"] = settings->trainingSteps;
+                event["millisecondsPerStep"] = stats.millisecondsPerStep;
+                event["loss"] = stats.loss;
+                event["psnr"] = ntc::LossToPSNR(stats.loss);
+                EmitTelemetryEvent("trainingStep", std::move(event));
+            }
+        }
+        if (ntcStatus == ntc::Status::Incomplete)
+            stopReason = earlyStopMonitor.Update(stats.currentStep, ntc::LossToPSNR(stats.loss));
+    } while (ntcStatus == ntc::Status::Incomplete && !stopReason);
+    if (!stopReason)
+    {
+        CHECK_NTC_RESULT(RunCompressionSteps);
+    }
+    PrintOutput("\n");
+
+    bool const warmStartLost = stopReason == g_warmStartLostReason;
+    if (outWarmStartLost)
+        *outWarmStartLost = warmStartLost;
+
+    if (stopReason && !warmStartLost)
+    {
+        PrintOutput("Training stopped early at %d of %d steps: %s.\n", stats.currentStep,
+            settings->trainingSteps, stopReason);
+
+        Json::Value event(Json::objectValue);
+        event["step"] = stats.currentStep;
+        event["totalSteps"] = settings->trainingSteps;
+        event["reason"] = stopReason;
+        EmitTelemetryEvent("earlyStop", std::move(event));
+    }
+
+    ntcStatus = textureSet->FinalizeCompression();
+    CHECK_NTC_RESULT(FinalizeCompression);
+
+    if (outFinalPsnr)
+        *outFinalPsnr = ntc::LossToPSNR(stats.loss);
+
+    if (outTrainingSteps)
+        *outTrainingSteps += stats.currentStep;
+
+    return true;
+}
+
+// Describes where the texture set being processed was loaded from,
+// so that the parallel adaptive search can create more instances of it.
+struct TextureSetSource
+{
+    Manifest const* manifest = nullptr;
+    bool manifestIsGenerated = false;
+    int cudaDevice = 0;
+    std::string cacheKey; // Empty when --cache is not used
+    bool cacheHit = false; // The texture set was loaded from the cache and doesn't need to be compressed
+};
+
+void OverrideBcFormats(ntc::ITextureSetMetadata* textureSetMetadata);
+
+struct AdaptiveSearchExperiment
+{
+    ntc::LatentShape latentShape;
+    float bitsPerPixel = 0.f;
+    float psnr = 0.f;
+};
+
+// Experiment indices in the telemetry are 0-based, unlike the printed ones
+static void EmitExperimentEvent(int experimentIndex, float bitsPerPixel)
+{
+    Json::Value event(Json::objectValue);
+    event["index"] = experimentIndex;
+    event["bitsPerPixel"] = bitsPerPixel;
+    EmitTelemetryEvent("experiment", std::move(event));
+}
+
+static void EmitExperimentResultEvent(int experimentIndex, float psnr, int trainingSteps)
+{
+    Json::Value event(Json::objectValue);
+    event["index"] = experimentIndex;
+    event["psnr"] = psnr;
+    event["trainingSteps"] = trainingSteps;
+    EmitTelemetryEvent("experimentResult", std::move(event));
+}
+
+// Results of the adaptive compression search. Instead of serializing every experiment, only the data for the run
+// that can still be selected as the final one is kept in memory: the lowest bit rate run that reached the target PSNR,
+// or the highest PSNR run while none of them did.
+struct AdaptiveSearchResults
+{
+    float targetPsnr = 0.f;
+    std::vector<AdaptiveSearchExperiment> experiments;
+    std::vector<uint8_t> keptData;
+    int keptIndex = -1;
+    int trainingSteps = 0; // Total for all experiments, including the cancelled ones
+
+    // Returns true if the data for the experiment is worth keeping, i.e. it's better than the currently kept one.
+    bool IsWorthKeeping(AdaptiveSearchExperiment const& experiment) const
+    {
+        if (keptIndex < 0)
+            return true;
+
+        AdaptiveSearchExperiment const& kept = experiments[keptIndex];
+        if (experiment.psnr >= targetPsnr)
+            return kept.psnr < targetPsnr || experiment.bitsPerPixel < kept.bitsPerPixel;
+        return kept.psnr < targetPsnr && experiment.psnr > kept.psnr;
+    }
+};
+
+// Records the experiment that has just finished compressing 'textureSet' and keeps its data if needed.
+static bool AddAdaptiveSearchExperiment(ntc::ITextureSet* textureSet, AdaptiveSearchExperiment const& experiment,
+    AdaptiveSearchResults& results)
+{
+    results.experiments.push_back(experiment);
+
+    if (!results.IsWorthKeeping(experiment))
+        return true;
+
+    // Save the compressed data to an in-memory vector, reusing the allocation from the previously kept result
+    size_t bufferSize = textureSet->GetOutputStreamSize();
+    results.keptData.resize(bufferSize);
+    ntc::Status ntcStatus = textureSet->SaveToMemory(results.keptData.data(), &bufferSize);
+    CHECK_NTC_RESULT(SaveToMemory)
+
+    // Trim the buffer to the actual size of the saved data
+    results.keptData.resize(bufferSize);
+    results.keptIndex = int(results.experiments.size()) - 1;
+
+    return true;
+}
+
+// Makes sure that the texture set contains the data for the final run selected by the adaptive session.
+// 'textureSetExperimentIndex' is the index of the experiment whose data is currently in the texture set, or -1.
+static bool RestoreFinalSearchResult(ntc::IContext* context, ntc::ITextureSet* textureSet,
+    AdaptiveSearchResults& results, int finalIndex, int textureSetExperimentIndex)
+{
+    ntc::Status ntcStatus;
+
+    // If the texture set already has the final result, do nothing - its data is valid.
+    if (finalIndex == textureSetExperimentIndex)
+        return true;
+
+    // Otherwise, restore the final compression result into the texture set.
+    if (finalIndex == results.keptIndex)
+    {
+        ntcStatus = textureSet->LoadFromMemory(results.keptData.data(), results.keptData.size());
+        CHECK_NTC_RESULT(LoadFromMemory)
+        return true;
+    }
+
+    // The session selected a run that we didn't expect to be final, so its data wasn't kept. Compress it again.
+    AdaptiveSearchExperiment const& result = results.experiments[finalIndex];
+    PrintOutput("Repeating experiment %d to restore its results...\n", finalIndex + 1);
+
+    ntcStatus = textureSet->SetLatentShape(result.latentShape, g_options.networkVersion);
+    CHECK_NTC_RESULT(SetLatentShape)
+
+    return CompressTextureSet(context, textureSet, GetEarlyStopCriteria(results.targetPsnr), nullptr,
+        &results.trainingSteps);
+}
+
+// Validates the index of the final run returned by the session and restores its data into the texture set.
+static bool FinishAdaptiveSearch(ntc::IContext* context, ntc::ITextureSet* textureSet,
+    ntc::IAdaptiveCompressionSession* session, AdaptiveSearchResults& results,
+    int textureSetExperimentIndex, float* outFinalPsnr, int* outTrainingSteps)
+{
+    // Get and validate the index of the final result
+    int finalIndex = session->GetIndexOfFinalRun();
+    if (finalIndex < 0 || finalIndex >= int(results.experiments.size()))
+    {
+        fprintf(stderr, "Internal error: GetIndexOfFinalRun() returned %d, which is not a valid index!\n", finalIndex);
+        return false;
+    }
+
+    // Find the final compresison result
+    AdaptiveSearchExperiment const& result = results.experiments[finalIndex];
+
+    PrintOutput("Selected compression rate: %.2f bpp, %.2f dB PSNR.\n", result.bitsPerPixel, result.psnr);
+    {
+        Json::Value event(Json::objectValue);
+        event["bitsPerPixel"] = result.bitsPerPixel;
+        event["psnr"] = result.psnr;
+        event["targetPsnr"] = results.targetPsnr;
+        event["trainingSteps"] = results.trainingSteps;
+        EmitTelemetryEvent("selectedRate", std::move(event));
+    }
+    if (result.psnr < results.targetPsnr)
+        PrintOutput("WARNING: Target PSNR of %.2f dB was not reached!\n", results.targetPsnr);
+
+    if (outFinalPsnr)
+        *outFinalPsnr = result.psnr;
+
+    if (!RestoreFinalSearchResult(context, textureSet, results, finalIndex, textureSetExperimentIndex))
+        return false;
+
+    if (outTrainingSteps)
+        *outTrainingSteps += results.trainingSteps;
+
+    return true;
+}
+
+// One latent shape being trained by the parallel adaptive search.
+struct SearchCandidate
+{
+    ntc::LatentShape latentShape;
+    float bitsPerPixel = 0.f;
+    // PSNR of the current experiment that was assumed to produce this candidate, NAN for the current experiment.
+    float hypotheticalPsnr = NAN;
+};
+
+// A texture set instance and a thread that trains one search candidate at a time.
+// The first slot uses the texture set being compressed, others load their own copies in separate contexts.
+struct SearchSlot
+{
+    ntc::ContextWrapper ownContext;
+    std::unique_ptr<ntc::TextureSetWrapper> ownTextureSet;
+    ntc::IContext* context = nullptr;
+    ntc::ITextureSet* textureSet = nullptr;
+
+    std::thread thread;
+    std::optional<SearchCandidate> candidate;
+    std::atomic<bool> cancel = false;
+    std::atomic<int> currentStep = 0;
+    std::atomic<float> intermediatePsnr = 0.f;
+    std::atomic<bool> finished = false;
+    bool success = false;
+    float psnr = NAN;
+};
+
+static bool TrainSearchCandidate(SearchSlot& slot, TextureSetSource const& source, float targetPsnr)
+{
+    ntc::Status ntcStatus;
+
+    if (!slot.textureSet)
+    {
+        ntc::ContextParameters contextParams;
+        contextParams.cudaDevice = source.cudaDevice;
+        ntcStatus = ntc::CreateContext(slot.ownContext.ptr(), contextParams);
+        CHECK_NTC_RESULT(CreateContext)
+
+        slot.ownTextureSet = std::make_unique<ntc::TextureSetWrapper>(slot.ownContext);
+        *slot.ownTextureSet->ptr() = LoadImages(slot.ownContext, *source.manifest, source.manifestIsGenerated);
+        if (!*slot.ownTextureSet)
+            return false;
+
+        slot.context = slot.ownContext;
+        slot.textureSet = *slot.ownTextureSet;
+
+        // Apply the same overrides as ProcessTextureSet does to the original texture set
+        OverrideBcFormats(slot.textureSet);
+        slot.textureSet->SetExperimentalKnob(g_options.experimentalKnob);
+    }
+
+    ntcStatus = slot.textureSet->SetLatentShape(slot.candidate->latentShape, g_options.networkVersion);
+    CHECK_NTC_RESULT(SetLatentShape)
+
+    ntcStatus = slot.textureSet->BeginCompression(g_options.compressionSettings);
+    CHECK_NTC_RESULT(BeginCompression)
+
+    EarlyStopMonitor earlyStopMonitor(GetEarlyStopCriteria(targetPsnr), g_options.compressionSettings.trainingSteps);
+    char const* stopReason = nullptr;
+    ntc::CompressionStats stats;
+    do
+    {
+        ntcStatus = slot.textureSet->RunCompressionSteps(&stats);
+        if (ntcStatus == ntc::Status::Incomplete || ntcStatus == ntc::Status::Ok)
+        {
+            slot.currentStep = stats.currentStep;
+            slot.intermediatePsnr = ntc::LossToPSNR(stats.loss);
+        }
+        if (ntcStatus == ntc::Status::Incomplete)
+            stopReason = earlyStopMonitor.Update(stats.currentStep, ntc::LossToPSNR(stats.loss));
+    } while (ntcStatus == ntc::Status::Incomplete && !slot.cancel && !stopReason);
+    if (ntcStatus != ntc::Status::Incomplete)
+    {
+        CHECK_NTC_RESULT(RunCompressionSteps)
+    }
+
+    // Finalize even cancelled runs to leave the texture set ready for the next candidate
+    ntcStatus = slot.textureSet->FinalizeCompression();
+    CHECK_NTC_RESULT(FinalizeCompression)
+
+    slot.psnr = ntc::LossToPSNR(stats.loss);
+    return !slot.cancel;
+}
+
+// Replays the adaptive session with the results obtained so far and a hypothetical result of the current
+// experiment, to predict which latent shape the session is going to ask for next.
+static bool PredictNextPreset(ntc::IContext* context, float targetPsnr, float maxBitsPerPixel,
+    std::vector<AdaptiveSearchExperiment> const& experiments, float hypotheticalPsnr, SearchCandidate& outCandidate)
+{
+    ntc::AdaptiveCompressionSessionWrapper session(context);
+    if (context->CreateAdaptiveCompressionSession(session.ptr()) != ntc::Status::Ok)
+        return false;
+
+    if (session->Reset(targetPsnr, maxBitsPerPixel, g_options.networkVersion) != ntc::Status::Ok)
+        return false;
+
+    for (AdaptiveSearchExperiment const& experiment : experiments)
+        session->Next(experiment.psnr);
+
+    if (session->Finished())
+        return false;
+    session->Next(hypotheticalPsnr);
+    if (session->Finished())
+        return false;
+
+    session->GetCurrentPreset(&outCandidate.bitsPerPixel, &outCandidate.latentShape);
+    outCandidate.hypotheticalPsnr = hypotheticalPsnr;
+    return true;
+}
+
+// Trains the current experiment of the adaptive session together with up to (--parallelSearch - 1) speculative
+// candidates that the session is likely to request next, assuming that the current experiment lands above or
+// below the target PSNR. When the current experiment finishes, speculative candidates that the session doesn't
+// ask for are cancelled; those that it does ask for are reused as they are, possibly already finished.
+static bool CompressTextureSetWithParallelSearch(ntc::IContext* context, ntc::ITextureSet* textureSet,
+    TextureSetSource const& source, ntc::IAdaptiveCompressionSession* session, float targetPsnr,
+    float maxBitsPerPixel, float* outFinalPsnr, int* outTrainingSteps)
+{
+    int const slotCount = g_options.parallelSearch;
+    PrintOutput("Starting search for optimal BPP to achieve %.2f dB PSNR with %d parallel experiments.\n",
+        targetPsnr, slotCount);
+
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    std::vector<std::unique_ptr<SearchSlot>> slots;
+    for (int slotIndex = 0; slotIndex < slotCount; ++slotIndex)
+        slots.push_back(std::make_unique<SearchSlot>());
+    slots[0]->context = context;
+    slots[0]->textureSet = textureSet;
+
+    AdaptiveSearchResults results;
+    results.targetPsnr = targetPsnr;
+    int textureSetExperimentIndex = -1;
+
+    auto findSlot = [&slots](ntc::LatentShape const& latentShape) -> SearchSlot*
+    {
+        for (auto& slot : slots)
+        {
+            if (slot->candidate.has_value() && slot->candidate->latentShape == latentShape)
+                return slot.get();
+        }
+        return nullptr;
+    };
+
+    // Cancels the slot's candidate if it's still running and makes the slot available for a new one
+    auto releaseSlot = [&results](SearchSlot& slot)
+    {
+        if (slot.thread.joinable())
+        {
+            if (!slot.finished)
+            {
+                PrintOutput("Cancelled speculative experiment at %.2f bpp after %d steps.\n",
+                    slot.candidate->bitsPerPixel, slot.currentStep.load());
+            }
+            slot.cancel = true;
+            slot.thread.join();
+            results.trainingSteps += slot.currentStep;
+        }
+        slot.candidate.reset();
+    };
+
+    auto releaseAllSlots = [&slots, &releaseSlot]()
+    {
+        for (auto& slot : slots)
+            releaseSlot(*slot);
+    };
+
+    while (!session->Finished())
+    {
+        std::vector<SearchCandidate> wanted(1);
+        session->GetCurrentPreset(&wanted[0].bitsPerPixel, &wanted[0].latentShape);
+
+        // Predict the next presets for the current experiment landing around the target, then further away
+        for (float offset = 1.f; offset <= 8.f && int(wanted.size()) < slotCount; offset *= 2.f)
+        {
+            for (float hypotheticalPsnr : { targetPsnr + offset, targetPsnr - offset })
+            {
+                SearchCandidate candidate;
+                if (int(wanted.size()) < slotCount && PredictNextPreset(context, targetPsnr, maxBitsPerPixel,
+                    results.experiments, hypotheticalPsnr, candidate) &&
+                    std::none_of(wanted.begin(), wanted.end(), [&candidate](SearchCandidate const& c)
+                        { return c.latentShape == candidate.latentShape; }))
+                {
+                    wanted.push_back(candidate);
+                }
+            }
+        }
+
+        // Cancel the candidates that are no longer needed
+        for (auto& slot : slots)
+        {
+            if (slot->candidate.has_value() && std::none_of(wanted.begin(), wanted.end(),
+                [&slot](SearchCandidate const& c) { return c.latentShape == slot->candidate->latentShape; }))
+            {
+                releaseSlot(*slot);
+            }
+        }
+
+        // Start the candidates that are not running yet on free slots
+        for (SearchCandidate const& candidate : wanted)
+        {
+            if (findSlot(candidate.latentShape))
+                continue;
+
+            for (auto& slot : slots)
+            {
+                if (slot->candidate.has_value())
+                    continue;
+
+                if (slot->textureSet == textureSet)
+                    textureSetExperimentIndex = -1;
+
+                slot->candidate = candidate;
+                slot->cancel = false;
+                slot->finished = false;
+                slot->currentStep = 0;
+                slot->thread = std::thread([&mutex, &condition, &source, targetPsnr, slotPtr = slot.get(),
+                    outputMutex = GetThreadOutputMutex()]()
+                {
+                    SetThreadOutputMutex(outputMutex);
+                    bool const success = TrainSearchCandidate(*slotPtr, source, targetPsnr);
+                    std::lock_guard lockGuard(mutex);
+                    slotPtr->success = success;
+                    slotPtr->finished = true;
+                    condition.notify_all();
+                });
+                break;
+            }
+        }
+
+        int const experimentIndex = int(results.experiments.size());
+        PrintOutput("Experiment %d: %.2f bpp...\n", experimentIndex + 1, wanted[0].bitsPerPixel);
+        EmitExperimentEvent(experimentIndex, wanted[0].bitsPerPixel);
+
+        // Wait for the current experiment to finish. Once it's clearly above the target halfway through training,
+        // the candidates that assumed it would miss the target are cancelled to let the others run faster.
+        SearchSlot* currentSlot = findSlot(wanted[0].latentShape);
+        assert(currentSlot);
+        {
+            std::unique_lock lock(mutex);
+            while (!condition.wait_for(lock, std::chrono::milliseconds(100), [currentSlot]()
+                { return currentSlot->finished; }))
+            {
+                if (currentSlot->currentStep * 2 < g_options.compressionSettings.trainingSteps ||
+                    currentSlot->intermediatePsnr < targetPsnr + 1.f)
+                    continue;
+
+                for (auto& slot : slots)
+                {
+                    if (slot->candidate.has_value() && slot->candidate->hypotheticalPsnr < targetPsnr && !slot->finished)
+                        slot->cancel = true;
+                }
+            }
+        }
+        currentSlot->thread.join();
+        results.trainingSteps += currentSlot->currentStep;
+
+        if (!currentSlot->success)
+        {
+            releaseAllSlots();
+            return false;
+        }
+
+        AdaptiveSearchExperiment experiment;
+        experiment.latentShape = currentSlot->candidate->latentShape;
+        experiment.bitsPerPixel = currentSlot->candidate->bitsPerPixel;
+        experiment.psnr = currentSlot->psnr;
+        PrintOutput("Experiment %d result: %.2f dB PSNR after %d steps.\n", experimentIndex + 1, experiment.psnr,
+            currentSlot->currentStep.load());
+        EmitExperimentResultEvent(experimentIndex, experiment.psnr, currentSlot->currentStep);
+
+        if (!AddAdaptiveSearchExperiment(currentSlot->textureSet, experiment, results))
+        {
+            releaseAllSlots();
+            return false;
+        }
+
+        if (currentSlot->textureSet == textureSet)
+            textureSetExperimentIndex = experimentIndex;
+        currentSlot->candidate.reset();
+
+        // Candidates cancelled early are restarted from scratch if the session asks for them
+        for (auto& slot : slots)
+        {
+            if (slot->candidate.has_value() && slot->cancel)
+                releaseSlot(*slot);
+        }
+
+        session->Next(experiment.psnr);
+    }
+
+    releaseAllSlots();
+
+    return FinishAdaptiveSearch(context, textureSet, session, results, textureSetExperimentIndex, outFinalPsnr,
+        outTrainingSteps);
+}
+
+bool CompressTextureSetWithTargetPSNR(ntc::IContext* context, ntc::ITextureSet* textureSet,
+    TextureSetSource const* source, float targetPsnr, float* outFinalPsnr, int* outTrainingSteps)
+{
+    ntc::Status ntcStatus;
+
+    ntc::AdaptiveCompressionSessionWrapper session(context);
     ntcStatus = context->CreateAdaptiveCompressionSession(session.ptr());
     CHECK_NTC_RESULT("CreateAdaptiveCompressionSession")
 
-    float const targetPsnr = g_options.targetPsnr;
-    float const maxBitsPerPixel = std::isnan(g_options.maxBitsPerPixel) ? 0.f : g_options.maxBitsPerPixel;
-    ntcStatus = session->Reset(targetPsnr, maxBitsPerPixel, g_options.networkVersion);
-    CHECK_NTC_RESULT("Reset")
-    
-    printf("Starting search for optimal BPP to achieve %.2f dB PSNR.\n", g_options.targetPsnr);
-    
-    int experimentCount = 0;
-    std::vector<AdaptiveSearchResult> results;
+    float const maxBitsPerPixel = std::isnan(g_options.maxBitsPerPixel) ? 0.f : g_options.maxBitsPerPixel;
+    ntcStatus = session->Reset(targetPsnr, maxBitsPerPixel, g_options.networkVersion);
+    CHECK_NTC_RESULT("Reset")
+
+    // Additional texture set instances for the parallel search are loaded from the same source
+    if (g_options.parallelSearch > 1 && source && source->manifest)
+    {
+        return CompressTextureSetWithParallelSearch(context, textureSet, *source, session, targetPsnr,
+            maxBitsPerPixel, outFinalPsnr, outTrainingSteps);
+    }
+    
+    PrintOutput("Starting search for optimal BPP to achieve %.2f dB PSNR.\n", targetPsnr);
+    
+    AdaptiveSearchResults results;
+    results.targetPsnr = targetPsnr;
+
+    while (!session->Finished())
+    {
+        AdaptiveSearchExperiment experiment;
+        session->GetCurrentPreset(&experiment.bitsPerPixel, &experiment.latentShape);
+
+        int const experimentIndex = int(results.experiments.size());
+        PrintOutput("Experiment %d: %.2f bpp...\n", experimentIndex + 1, experiment.bitsPerPixel);
+        EmitExperimentEvent(experimentIndex, experiment.bitsPerPixel);
+
+        ntcStatus = textureSet->SetLatentShape(experiment.latentShape, g_options.networkVersion);
+        CHECK_NTC_RESULT(SetLatentShape)
+
+        int experimentSteps = 0;
+        if (!CompressTextureSet(context, textureSet, GetEarlyStopCriteria(targetPsnr), &experiment.psnr,
+            &experimentSteps))
+            return false;
+        results.trainingSteps += experimentSteps;
+        EmitExperimentResultEvent(experimentIndex, experiment.psnr, experimentSteps);
+
+        // Store the compression result if it can be the final one
+        if (!AddAdaptiveSearchExperiment(textureSet, experiment, results))
+            return false;
+        
+        session->Next(experiment.psnr);
+    }
+
+    // The texture set contains the results of the last experiment
+    return FinishAdaptiveSearch(context, textureSet, session, results, int(results.experiments.size()) - 1,
+        outFinalPsnr, outTrainingSteps);
+}
+
+// 'referenceImagesLoaded' is false for texture sets that were loaded from a file or the --cache
+// without their source images, there is nothing to measure the PSNR against then.
+bool DecompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet, bool useFP8Weights,
+    bool referenceImagesLoaded, float* outOverallPsnr = nullptr)
+{
+    ntc::DecompressionStats stats;
+    ntc::Status ntcStatus = textureSet->Decompress(&stats, useFP8Weights);
+    CHECK_NTC_RESULT(NtcDecompress);
+
+    PrintOutput("CUDA decompression time: %.3f ms\n", stats.gpuTimeMilliseconds);
+
+    Json::Value event(Json::objectValue);
+    event["api"] = "CUDA";
+    event["weightType"] = useFP8Weights ? "FP8" : "INT8";
+    event["gpuMilliseconds"] = stats.gpuTimeMilliseconds;
+
+    // Batch jobs always load images, so the reference data is available for them too
+    if (referenceImagesLoaded && (g_options.inputType == ToolInputType::Directory ||
+        g_options.inputType == ToolInputType::Manifest ||
+        g_options.inputType == ToolInputType::Images ||
+        g_options.inputType == ToolInputType::MaterialAtlas ||
+        g_options.batchFileName))
+    {
+        if (outOverallPsnr)
+            *outOverallPsnr = ntc::LossToPSNR(stats.overallLoss);
+
+        PrintOutput("Overall PSNR (%s weights): %.2f dB\n", useFP8Weights ? "FP8" : "INT8", ntc::LossToPSNR(stats.overallLoss));
+        event["overallPsnr"] = ntc::LossToPSNR(stats.overallLoss);
+        
+        if (!useFP8Weights)
+        {
+            size_t maxNameLength = 0;
+            for (int i = 0; i < textureSet->GetTextureCount(); ++i)
+            {
+                maxNameLength = std::max(maxNameLength, strlen(textureSet->GetTexture(i)->GetName()));
+            }
+
+            PrintOutput("Per-texture PSNR:\n");
+            for (int i = 0; i < textureSet->GetTextureCount(); ++i)
+            {
+                ntc::ITextureMetadata* texture = textureSet->GetTexture(i);
+                int firstChannel, numChannels;
+                texture->GetChannels(firstChannel, numChannels);
+
+                float textureMSE = 0.f;
+                for (int ch = firstChannel; ch < firstChannel + numChannels; ++ch)
+                {
+                    textureMSE += stats.perChannelLoss[ch];
+                }
+                textureMSE /= float(numChannels);
+
+                PrintOutput("  %-*s : %.2f dB [ ", int(maxNameLength), texture->GetName(), ntc::LossToPSNR(textureMSE));
+                Json::Value& textureNode = event["textures"].append(Json::Value(Json::objectValue));
+                textureNode["name"] = texture->GetName();
+                textureNode["psnr"] = ntc::LossToPSNR(textureMSE);
+                Json::Value& channelsNode = textureNode["channelPsnr"] = Json::Value(Json::arrayValue);
+                for (int ch = firstChannel; ch < firstChannel + numChannels; ++ch)
+                {
+                    PrintOutput("%.2f ", ntc::LossToPSNR(stats.perChannelLoss[ch]));
+                    channelsNode.append(ntc::LossToPSNR(stats.perChannelLoss[ch]));
+                }
+                PrintOutput("]\n");
+            }
+        }
+
+        if (textureSet->GetDesc().mips > 1)
+        {
+            for (int mip = 0; mip < textureSet->GetDesc().mips; ++mip)
+            {
+                PrintOutput("MIP %2d  PSNR: %.2f dB\n", mip, ntc::LossToPSNR(stats.perMipLoss[mip]));
+                event["mipPsnr"].append(ntc::LossToPSNR(stats.perMipLoss[mip]));
+            }
+        }
+    }
+
+    EmitTelemetryEvent("decompression", std::move(event));
+
+    return true;
+}
+
+// Saves the texture set into a page-compressed file, see CompressedFileStream.h
+static bool SaveDeflatedTextureSet(ntc::ITextureSet* textureSet, char const* fileName, uint64_t& outFileSize)
+{
+    size_t bufferSize = textureSet->GetOutputStreamSize();
+    std::vector<uint8_t> textureSetData(bufferSize);
+    ntc::Status ntcStatus = textureSet->SaveToMemory(textureSetData.data(), &bufferSize);
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        fprintf(stderr, "Failed to save compressed texture set into memory, code = %s\n%s\n",
+            ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        return false;
+    }
+
+    std::vector<uint8_t> fileData;
+    CompressedFilePageFormat const pageFormat = CompressTextureSetData(textureSetData.data(), bufferSize, fileData,
+        g_options.compressFileFormat);
+
+    FILE* outputFile = fopen(fileName, "wb");
+    if (!outputFile)
+    {
+        fprintf(stderr, "Cannot open output file '%s': %s\n", fileName, strerror(errno));
+        return false;
+    }
+
+    bool const success = fwrite(fileData.data(), fileData.size(), 1, outputFile) == 1;
+    fclose(outputFile);
+    if (!success)
+    {
+        fprintf(stderr, "Failed to write output file '%s'.\n", fileName);
+        return false;
+    }
+
+    PrintOutput("Compressed the file with %s pages from %zu to %zu bytes (%.1f%%).\n",
+        GetCompressedFilePageFormatName(pageFormat), bufferSize, fileData.size(),
+        bufferSize ? 100.0 * double(fileData.size()) / double(bufferSize) : 0.0);
+
+    outFileSize = fileData.size();
+    return true;
+}
+
+bool SaveCompressedTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet, char const* fileName,
+    uint64_t* outFileSize = nullptr, float* outBitsPerPixel = nullptr)
+{
+    uint64_t fileSize = 0;
+    if (g_options.compressFile)
+    {
+        if (!SaveDeflatedTextureSet(textureSet, fileName, fileSize))
+            return false;
+    }
+    else
+    {
+        ntc::FileStreamWrapper outputStream(context);
+        
+        ntc::Status ntcStatus = context->OpenFile(fileName, true, outputStream.ptr());
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Cannot open output file '%s', code = %s\n%s\n",
+                fileName, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
+
+        ntcStatus = textureSet->SaveToStream(outputStream);
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to save compressed texture to output file '%s', code = %s\n%s\n",
+                fileName, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
+
+        fileSize = outputStream->Tell();
+    }
+
+    size_t texturePixels = 0;
+    ntc::TextureSetDesc const& desc = textureSet->GetDesc();
+    for (int mip = 0; mip < desc.mips; ++mip)
+    {
+        int mipWidth = std::max(1, desc.width >> mip);
+        int mipHeight = std::max(1, desc.height >> mip);
+        texturePixels += size_t(mipWidth) * size_t(mipHeight);
+    }
+    float const bpp = 8.f * float(fileSize) / float(texturePixels);
+
+    PrintOutput("Saved '%s'\n", fileName);
+    PrintOutput("File size: %" PRIu64 " bytes, %.2f bits per pixel.\n", fileSize, bpp);
+
+    Json::Value event(Json::objectValue);
+    event["path"] = fileName;
+    event["bytes"] = Json::UInt64(fileSize);
+    event["bitsPerPixel"] = bpp;
+    EmitTelemetryEvent("fileSaved", std::move(event));
+
+    if (outFileSize)
+        *outFileSize = fileSize;
+    if (outBitsPerPixel)
+        *outBitsPerPixel = bpp;
+
+    return true;
+}
+
+ntc::ITextureSet* LoadCompressedTextureSet(ntc::IContext* context, char const* fileName)
+{
+    ntc::ITextureSet* textureSet = nullptr;
+    ntc::TextureSetFeatures textureSetFeatures;
+    textureSetFeatures.enableCompression = false;
+    textureSetFeatures.stagingBytesPerPixel = 16;
+    
+    // Open the file through OpenTextureSetFile to support page-compressed files
+    std::string openError;
+    std::unique_ptr<ntc::IStream> inputFile = OpenTextureSetFile(fileName, &openError);
+    if (!inputFile)
+    {
+        fprintf(stderr, "Failed to open input file '%s': %s\n", fileName, openError.c_str());
+        return nullptr;
+    }
+
+    auto compressedFile = dynamic_cast<CompressedFileStream*>(inputFile.get());
+    if (compressedFile && compressedFile->GetPageFormat() == CompressedFilePageFormat::GDeflate &&
+        !IsGDeflateCodecAvailable())
+    {
+        fprintf(stderr, "File '%s' has GDeflate pages, which can only be read by builds with DirectStorage.\n",
+            fileName);
+        return nullptr;
+    }
+
+    ntc::Status ntcStatus = context->CreateCompressedTextureSetFromStream(
+        inputFile.get(), textureSetFeatures, &textureSet);
+
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        fprintf(stderr, "Failed to load compressed texture from file '%s', code = %s\n%s\n",
+            fileName, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        return nullptr;
+    }
+    
+    return textureSet;
+}
+
+static std::unique_ptr<CompressionCache> g_compressionCache;
+
+// Adds the contents of all source images and the manifest entries to the --cache key.
+// Returns false if some of the source files cannot be read.
+static bool AddManifestToCacheKey(CacheKeyBuilder& key, Manifest const& manifest)
+{
+    key.AddValue(manifest.width.value_or(0));
+    key.AddValue(manifest.height.value_or(0));
+    key.AddValue(uint64_t(manifest.textures.size()));
+    for (ManifestEntry const& entry : manifest.textures)
+    {
+        // Hash the file contents and not the name, so that moving the materials around doesn't invalidate the cache.
+        // The name (before extension) matters for generated manifests though, it's used to guess the semantics.
+        if (!key.AddFileContents(entry.fileName.c_str()))
+            return false;
+        key.AddString(fs::path(entry.fileName).extension().generic_string());
+        key.AddString(entry.entryName);
+        key.AddString(entry.channelSwizzle);
+        key.AddValue(uint64_t(entry.semantics.size()));
+        for (ImageSemanticBinding const& binding : entry.semantics)
+        {
+            key.AddValue(binding.label);
+            key.AddValue(binding.firstChannel);
+        }
+        key.AddValue(entry.mipLevel);
+        key.AddValue(entry.firstChannel);
+        key.AddValue(entry.isSRGB);
+        key.AddValue(entry.verticalFlip);
+        key.AddValue(entry.bcFormat);
+    }
+
+    return true;
+}
+
+// Adds the library version and every option that affects the compressed file to the --cache key.
+// Returns false if some of the files referenced by the options cannot be read.
+static bool AddOptionsToCacheKey(CacheKeyBuilder& key)
+{
+    // Different library versions may produce different results with the same settings
+    ntc::VersionInfo const libVersion = ntc::GetLibraryVersion();
+    key.AddValue(libVersion.major);
+    key.AddValue(libVersion.minor);
+    key.AddValue(libVersion.point);
+    key.AddString(libVersion.commitHash);
+
+    // Texture set layout
+    key.AddValue(g_options.customWidth.value_or(0));
+    key.AddValue(g_options.customHeight.value_or(0));
+    key.AddValue(g_options.bcFormat.value_or(ntc::BlockCompressedFormat::None));
+    key.AddValue(g_options.bcFormat.has_value());
+    key.AddValue(g_options.loadMips);
+    key.AddValue(g_options.generateMips);
+    key.AddValue(g_options.mipFilter);
+    key.AddValue(g_options.discardMaskedOutPixels);
+
+    // Latent shape and network version
+    key.AddValue(g_options.bitsPerPixel);
+    key.AddValue(g_options.gridSizeScale);
+    key.AddValue(g_options.highResFeatures);
+    key.AddValue(g_options.lowResFeatures);
+    key.AddValue(g_options.highResQuantBits);
+    key.AddValue(g_options.lowResQuantBits);
+    key.AddValue(g_options.networkVersion);
+
+    // Compression settings, hashed field by field to avoid hashing padding
+    ntc::CompressionSettings const& settings = g_options.compressionSettings;
+    key.AddValue(settings.trainingSteps);
+    key.AddValue(settings.stepsPerIteration);
+    key.AddValue(settings.kPixelsPerBatch);
+    key.AddValue(settings.networkLearningRate);
+    key.AddValue(settings.gridLearningRate);
+    key.AddValue(settings.randomSeed);
+    key.AddValue(settings.stableTraining);
+    key.AddValue(settings.trainFP8Weights);
+    key.AddValue(g_options.experimentalKnob);
+
+    // Adaptive compression and early stopping
+    key.AddValue(g_options.targetPsnr);
+    key.AddValue(g_options.maxBitsPerPixel);
+    key.AddValue(g_options.matchBcPsnr);
+    key.AddValue(g_options.minBcPsnr);
+    key.AddValue(g_options.maxBcPsnr);
+    key.AddValue(g_options.bcPsnrOffset);
+    key.AddValue(g_options.parallelSearch);
+    key.AddValue(g_options.earlyStopPsnr);
+    key.AddValue(g_options.earlyStopMargin);
+    key.AddValue(g_options.plateauIterations);
+    key.AddValue(g_options.plateauThreshold);
+
+    // Warm start changes the initial state of the training
+    key.AddValue(g_options.warmStartSteps);
+    if (g_options.warmStartFileName && !key.AddFileContents(g_options.warmStartFileName))
+        return false;
+
+    // BC7 optimization
+    key.AddValue(g_options.optimizeBC);
+    key.AddValue(g_options.bcPsnrThreshold);
+    key.AddValue(g_options.bcQuality);
+
+    return true;
+}
+
+// Computes the --cache key for a texture set loaded from the manifest with the current options.
+// The key covers the contents of all source images, the manifest entries, and every option that affects
+// the compressed file. Returns an empty string if some of the source files cannot be read.
+static std::string GetCompressionCacheKey(Manifest const& manifest, bool manifestIsGenerated)
+{
+    CacheKeyBuilder key;
+    key.AddValue(manifestIsGenerated);
+    if (!AddManifestToCacheKey(key, manifest) || !AddOptionsToCacheKey(key))
+        return std::string();
+
+    return key.GetKey();
+}
+
+// Computes the --cache key for an --atlas texture set from the manifests of the input materials and the packed
+// layout. The packed images are written into a new temporary directory on every run, so they are not hashed.
+static std::string GetMaterialAtlasCacheKey(std::vector<Manifest> const& sourceManifests,
+    MaterialAtlasLayout const& layout, bool manifestIsGenerated)
+{
+    CacheKeyBuilder key;
+    key.AddString("atlas");
+    key.AddValue(manifestIsGenerated);
+    key.AddValue(uint64_t(sourceManifests.size()));
+    for (Manifest const& manifest : sourceManifests)
+    {
+        if (!AddManifestToCacheKey(key, manifest))
+            return std::string();
+    }
+
+    key.AddValue(layout.width);
+    key.AddValue(layout.height);
+    for (MaterialAtlasEntry const& material : layout.materials)
+    {
+        key.AddString(material.name);
+        key.AddValue(material.left);
+        key.AddValue(material.top);
+        key.AddValue(material.width);
+        key.AddValue(material.height);
+    }
+
+    if (!AddOptionsToCacheKey(key))
+        return std::string();
+
+    return key.GetKey();
+}
+
+// Loads the texture set described by the manifest, or the previously compressed result if --cache has one.
+// Fills the cache related fields in 'source'.
+static void EmitCacheEvent(bool hit, std::string const& key)
+{
+    Json::Value event(Json::objectValue);
+    event["hit"] = hit;
+    event["key"] = key;
+    EmitTelemetryEvent("cache", std::move(event));
+}
+
+static ntc::ITextureSet* LoadImagesOrCachedResult(ntc::IContext* context, Manifest const& manifest,
+    bool manifestIsGenerated, TextureSetSource& source)
+{
+    if (g_compressionCache)
+    {
+        // The --atlas inputs have their key computed from the source manifests already
+        if (source.cacheKey.empty())
+            source.cacheKey = GetCompressionCacheKey(manifest, manifestIsGenerated);
+
+        std::string cachedFileName;
+        if (!source.cacheKey.empty() && g_compressionCache->Lookup(source.cacheKey, cachedFileName))
+        {
+            ntc::ITextureSet* textureSet = LoadCompressedTextureSet(context, cachedFileName.c_str());
+            g_compressionCache->RecordLoadResult(textureSet != nullptr);
+            if (textureSet)
+            {
+                PrintOutput("Compression cache hit: %s\n", source.cacheKey.c_str());
+                EmitCacheEvent(true, source.cacheKey);
+                source.cacheHit = true;
+                return textureSet;
+            }
+
+            // The entry might be damaged or removed by another process, compress from scratch and replace it
+            PrintOutput("Warning: Failed to load the cached result, compressing the images.\n");
+            EmitCacheEvent(false, source.cacheKey);
+        }
+        else if (!source.cacheKey.empty())
+        {
+            PrintOutput("Compression cache miss: %s\n", source.cacheKey.c_str());
+            EmitCacheEvent(false, source.cacheKey);
+        }
+    }
+
+    return LoadImages(context, manifest, manifestIsGenerated);
+}
+
+donut::app::DeviceCreationParameters GetGraphicsDeviceParameters(nvrhi::GraphicsAPI graphicsApi)
+{
+    donut::app::DeviceCreationParameters deviceParams;
+    deviceParams.infoLogSeverity = donut::log::Severity::None;
+    deviceParams.adapterIndex = g_options.adapterIndex;
+    deviceParams.enableDebugRuntime = g_options.debug;
+    deviceParams.enableNvrhiValidationLayer = g_options.debug;
+
+    SetNtcGraphicsDeviceParameters(deviceParams, graphicsApi, true, nullptr);
+
+    return deviceParams;
+}
+
+void DescribeTextureSet(ntc::ITextureSetMetadata* textureSet)
+{
+    ntc::TextureSetDesc const& desc = textureSet->GetDesc();
+    PrintOutput("Dimensions: %dx%d, %d channels, %d mip level(s)\n", desc.width, desc.height, desc.channels, desc.mips);
+    
+    ntc::LatentShape const& latentShape = textureSet->GetLatentShape();
+    PrintOutput("Base compression rate: --bitsPerPixel %.3f\n", ntc::GetLatentShapeBitsPerPixel(latentShape));
+    PrintOutput("Latent shape: --gridSizeScale %d --highResFeatures %d --lowResFeatures %d --highResQuantBits %d --lowResQuantBits %d\n",
+        latentShape.gridSizeScale, latentShape.highResFeatures, latentShape.lowResFeatures,
+        latentShape.highResQuantBits, latentShape.lowResQuantBits);
+    PrintOutput("Network version: %s\n", ntc::NetworkVersionToString(textureSet->GetNetworkVersion()));
+    PrintOutput("Inference weights: Int8 [%c], FP8 [%c]\n",
+        textureSet->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericInt8) ? 'Y' : 'N',
+        textureSet->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericFP8) ? 'Y' : 'N');
+
+    Json::Value event(Json::objectValue);
+    event["width"] = desc.width;
+    event["height"] = desc.height;
+    event["channels"] = desc.channels;
+    event["mips"] = desc.mips;
+    event["bitsPerPixel"] = ntc::GetLatentShapeBitsPerPixel(latentShape);
+    Json::Value& latentShapeNode = event["latentShape"];
+    latentShapeNode["gridSizeScale"] = latentShape.gridSizeScale;
+    latentShapeNode["highResFeatures"] = latentShape.highResFeatures;
+    latentShapeNode["lowResFeatures"] = latentShape.lowResFeatures;
+    latentShapeNode["highResQuantBits"] = latentShape.highResQuantBits;
+    latentShapeNode["lowResQuantBits"] = latentShape.lowResQuantBits;
+    event["networkVersion"] = ntc::NetworkVersionToString(textureSet->GetNetworkVersion());
+    event["textures"] = Json::Value(Json::arrayValue);
+    for (int i = 0; i < textureSet->GetTextureCount(); ++i)
+    {
+        ntc::ITextureMetadata* texture = textureSet->GetTexture(i);
+        int firstChannel, numChannels;
+        texture->GetChannels(firstChannel, numChannels);
+        Json::Value& textureNode = event["textures"].append(Json::Value(Json::objectValue));
+        textureNode["name"] = texture->GetName();
+        textureNode["firstChannel"] = firstChannel;
+        textureNode["numChannels"] = numChannels;
+        textureNode["bcFormat"] = ntc::BlockCompressedFormatToString(texture->GetBlockCompressedFormat());
+    }
+    EmitTelemetryEvent("textureSet", std::move(event));
+        
+    PrintOutput("Textures:\n");
+    for (int i = 0; i < textureSet->GetTextureCount(); ++i)
+    {
+        ntc::ITextureMetadata* texture = textureSet->GetTexture(i);
+        int firstChannel, numChannels;
+        texture->GetChannels(firstChannel, numChannels);
+        PrintOutput("%d: %s\n", i, texture->GetName());
+        PrintOutput("   Channels: %d-%d\n", firstChannel, firstChannel + numChannels - 1);
+        PrintOutput("   Channel format: %s\n", ntc::ChannelFormatToString(texture->GetChannelFormat()));
+        PrintOutput("   BCn format: %s\n", ntc::BlockCompressedFormatToString(texture->GetBlockCompressedFormat()));
+        PrintOutput("   RGB color space: %s\n", ntc::ColorSpaceToString(texture->GetRgbColorSpace()));
+        if (numChannels > 3)
+            PrintOutput("   Alpha color space: %s\n", ntc::ColorSpaceToString(texture->GetAlphaColorSpace()));
+
+        if (texture->GetBlockCompressedFormat() == ntc::BlockCompressedFormat::BC7)
+        {
+            PrintOutput("   BC acceleration data: %s\n", texture->HasBlockCompressionAccelerationData() ? "YES" : "NO");
+            if (texture->HasBlockCompressionAccelerationData())
+                PrintOutput("   BC default quality: %d\n", texture->GetBlockCompressionQuality());
+        }
+        
+        bool colorSpacesMatch = true;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            ntc::ColorSpace const dstColorSpace = (ch < 3) ? texture->GetRgbColorSpace() : texture->GetAlphaColorSpace();
+            if (textureSet->GetChannelStorageColorSpace(firstChannel + ch) != dstColorSpace)
+            {
+                colorSpacesMatch = false;
+                break;
+            }
+        }
+
+        if (!colorSpacesMatch)
+        {
+            PrintOutput("   Storage color spaces: ");
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                if (ch > 0) PrintOutput(", ");
+                PrintOutput("%s", ntc::ColorSpaceToString(textureSet->GetChannelStorageColorSpace(firstChannel + ch)));
+            }
+            PrintOutput("\n");
+        }
+    }
+}
+
+// Reads the descriptors of all .ntc files at 'path' on the worker threads and prints one JSON object per file
+// to stdout, in the order of the file names, as soon as the line and all lines before it are ready.
+// Directories that can't be read are skipped. Doesn't need an NTC context or any GPU.
+static bool DescribeTextureSetFilesAsJson(char const* path)
+{
+    std::vector<std::string> fileNames;
+    std::atomic<bool> anyErrors = false;
+    std::error_code ec;
+    if (fs::is_directory(path, ec))
+    {
+        fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, ec);
+        for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec))
+        {
+            std::string extension = it->path().extension().string();
+            LowercaseString(extension);
+            std::error_code fileEc;
+            if (extension == ".ntc" && it->is_regular_file(fileEc))
+                fileNames.push_back(it->path().generic_string());
+        }
+
+        // The iterator can't continue after an error, describe the files found until then
+        if (ec)
+        {
+            fprintf(stderr, "Cannot list the files in '%s': %s\n", path, ec.message().c_str());
+            anyErrors = true;
+        }
+        std::sort(fileNames.begin(), fileNames.end());
+    }
+    else
+        fileNames.push_back(path);
+
+    std::vector<std::string> lines(fileNames.size());
+    std::vector<bool> linesReady(fileNames.size(), false);
+    std::mutex linesMutex;
+    std::condition_variable lineCondition;
+
+    for (size_t fileIndex = 0; fileIndex < fileNames.size(); ++fileIndex)
+    {
+        StartAsyncTask([&fileNames, &lines, &linesReady, &linesMutex, &lineCondition, &anyErrors, fileIndex]()
+        {
+            std::string const& fileName = fileNames[fileIndex];
+            Json::Value root;
+            root["file"] = fileName;
+
+            TextureSetDescriptor desc;
+            std::string error;
+            std::unique_ptr<ntc::IStream> inputFile = OpenTextureSetFile(fileName.c_str(), &error);
+            if (!inputFile)
+                error = "Cannot open the file: " + error;
+
+            if (!inputFile || !ReadTextureSetDescriptor(inputFile.get(), desc, error))
+            {
+                root["error"] = error;
+                anyErrors = true;
+            }
+            else
+            {
+                root["width"] = desc.width;
+                root["height"] = desc.height;
+                root["channels"] = desc.channels;
+                root["mips"] = desc.mips;
+                root["fileSize"] = Json::UInt64(inputFile->Size());
+                root["dataSize"] = Json::UInt64(desc.dataSize);
+
+                if (desc.hasLatentShape)
+                {
+                    Json::Value& latentShape = root["latentShape"];
+                    latentShape["highResFeatures"] = desc.highResFeatures;
+                    latentShape["lowResFeatures"] = desc.lowResFeatures;
+                    latentShape["highResQuantBits"] = desc.highResQuantBits;
+                    latentShape["lowResQuantBits"] = desc.lowResQuantBits;
+                }
+                root["latentMips"] = desc.latentMips;
+
+                Json::Value& textures = root["textures"] = Json::Value(Json::arrayValue);
+                for (TextureSetDescriptorTexture const& texture : desc.textures)
+                {
+                    Json::Value& node = textures.append(Json::Value(Json::objectValue));
+                    node["name"] = texture.name;
+                    node["firstChannel"] = texture.firstChannel;
+                    node["numChannels"] = texture.numChannels;
+                    node["channelFormat"] = texture.channelFormat;
+                    node["rgbColorSpace"] = texture.rgbColorSpace;
+                    if (texture.numChannels > 3)
+                        node["alphaColorSpace"] = texture.alphaColorSpace;
+                    node["bcFormat"] = texture.bcFormat;
+                    if (texture.bcQuality >= 0)
+                        node["bcQuality"] = texture.bcQuality;
+                    node["bcAccelerationData"] = texture.hasBcAccelerationData;
+                }
+
+                // The network version is not stored in the file, the MLP shapes identify it
+                Json::Value& networks = root["networks"] = Json::Value(Json::arrayValue);
+                for (TextureSetDescriptorMlp const& mlp : desc.mlps)
+                {
+                    Json::Value& node = networks.append(Json::Value(Json::objectValue));
+                    node["weightType"] = mlp.weightType;
+                    Json::Value& layerChannels = node["layerChannels"] = Json::Value(Json::arrayValue);
+                    for (int channels : mlp.layerChannels)
+                        layerChannels.append(channels);
+                }
+            }
+
+            Json::StreamWriterBuilder builder;
+            builder["indentation"] = "";
+            std::string line = Json::writeString(builder, root);
+
+            std::lock_guard lockGuard(linesMutex);
+            lines[fileIndex] = std::move(line);
+            linesReady[fileIndex] = true;
+            lineCondition.notify_one();
+        });
+    }
+
+    // Print the lines in order while the workers read the rest, and free every line once it's printed
+    for (size_t fileIndex = 0; fileIndex < fileNames.size(); ++fileIndex)
+    {
+        std::string line;
+        {
+            std::unique_lock lock(linesMutex);
+            lineCondition.wait(lock, [&linesReady, fileIndex]() { return linesReady[fileIndex]; });
+            line = std::move(lines[fileIndex]);
+            lines[fileIndex] = std::string();
+        }
+        printf("%s\n", line.c_str());
+        fflush(stdout);
+    }
+
+    WaitForAllTasks();
+
+    return !anyErrors;
+}
+
+// Returns true for the names of the graphics API implementations that run on the CPU.
+static bool IsSoftwareAdapterName(std::string name)
+{
+    LowercaseString(name);
+    return name.find("microsoft basic render driver") != std::string::npos || // WARP
+        name.find("llvmpipe") != std::string::npos ||
+        name.find("lavapipe") != std::string::npos ||
+        name.find("swiftshader") != std::string::npos;
+}
+
+static bool ListCudaDevices()
+{
+    int count = 0;
+    cudaError_t err = cudaGetDeviceCount(&count);
+    if (err != cudaSuccess)
+    {
+        fprintf(stderr, "Call to cudaGetDeviceCount failed, error code = %s.\n", cudaGetErrorName(err));
+        return false;
+    }
+
+    if (count == 0)
+    {
+        printf("No CUDA devices available.\n");
+        return true;
+    }
+
+    for (int device = 0; device < count; ++device)
+    {
+        cudaDeviceProp prop{};
+        err = cudaGetDeviceProperties(&prop, device);
+        if (err != cudaSuccess)
+        {
+            fprintf(stderr, "Call to cudaGetDeviceProperties(%d) failed, error code = %s.\n",
+                device, cudaGetErrorName(err));
+            return false;
+        }
+
+        printf("Device %d: %s (compute capability %d.%d, %zu MB VRAM)\n", device, prop.name,
+            prop.major, prop.minor, prop.totalGlobalMem / (1024 * 1024));
+    }
+
+    return true;
+}
+
+void OverrideBcFormats(ntc::ITextureSetMetadata* textureSetMetadata)
+{
+    // Override the BC format from command line, if specified.
+    // Overriding with 'none' is also an option here.
+    if (g_options.bcFormat.has_value())
+    {
+        for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+        {
+            ntc::ITextureMetadata* texture = textureSetMetadata->GetTexture(textureIndex);
+            ntc::BlockCompressedFormat bcFormat = *g_options.bcFormat;
+
+            // Automatic selection of BCn mode based on channel count and HDR-ness
+            if (bcFormat == BlockCompressedFormat_Auto)
+            {
+                ntc::ChannelFormat const channelFormat = texture->GetChannelFormat();
+                if (channelFormat == ntc::ChannelFormat::FLOAT16 || channelFormat == ntc::ChannelFormat::FLOAT32)
+                {
+                    // HDR textures use only BC6, no other options
+                    bcFormat = ntc::BlockCompressedFormat::BC6;
+                }
+                else
+                {
+                    // Best quality options.
+                    // If you want more control, use a manifest.
+                    int const channels = texture->GetNumChannels();
+                    switch(channels)
+                    {
+                        case 1:  bcFormat = ntc::BlockCompressedFormat::BC4; break;
+                        case 2:  bcFormat = ntc::BlockCompressedFormat::BC5; break;
+                        default: bcFormat = ntc::BlockCompressedFormat::BC7; break;
+                    }       
+                }
+            }
+
+            assert(bcFormat != BlockCompressedFormat_Auto);
+    
+            texture->SetBlockCompressedFormat(bcFormat);
+        }
+    }
+}
+
+bool AnyBlockCompressedTextures(ntc::ITextureSetMetadata* textureSetMetadata)
+{
+    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+    {
+        ntc::ITextureMetadata* textureMetadata = textureSetMetadata->GetTexture(textureIndex);
+        if (textureMetadata->GetBlockCompressedFormat() != ntc::BlockCompressedFormat::None)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Derives the part of the texture set to decompress with the graphics API from --textures, --mipRange,
+// --region and --saveMips, and validates it against the texture set.
+bool GetGraphicsDecompressionRegion(ntc::ITextureSetMetadata* metadata, GraphicsDecompressionRegion& outRegion)
+{
+    ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
+
+    if (g_options.decompressLastMip >= 0)
+    {
+        if (g_options.decompressLastMip >= textureSetDesc.mips)
+        {
+            fprintf(stderr, "The --mipRange (%d-%d) is outside of the texture set, which has %d MIP levels.\n",
+                g_options.decompressFirstMip, g_options.decompressLastMip, textureSetDesc.mips);
+            return false;
+        }
+
+        outRegion.firstMip = g_options.decompressFirstMip;
+        outRegion.mipCount = g_options.decompressLastMip - g_options.decompressFirstMip + 1;
+    }
+    else
+    {
+        outRegion.firstMip = 0;
+        outRegion.mipCount = g_options.saveMips ? textureSetDesc.mips : 1;
+    }
+
+    if (!g_options.decompressTextureNames.empty())
+    {
+        int const numTextures = metadata->GetTextureCount();
+        outRegion.textures.assign(numTextures, false);
+        for (std::string const& name : g_options.decompressTextureNames)
+        {
+            int textureIndex = 0;
+            while (textureIndex < numTextures && name != metadata->GetTexture(textureIndex)->GetName())
+                ++textureIndex;
+
+            if (textureIndex == numTextures)
+            {
+                fprintf(stderr, "Texture '%s' specified in --textures is not present in the texture set.\n",
+                    name.c_str());
+                return false;
+            }
+
+            outRegion.textures[textureIndex] = true;
+        }
+    }
+
+    ntc::Rect const& rect = g_options.decompressRegion;
+    if (rect.width > 0 && rect.height > 0)
+    {
+        int const mipWidth = std::max(textureSetDesc.width >> outRegion.firstMip, 1);
+        int const mipHeight = std::max(textureSetDesc.height >> outRegion.firstMip, 1);
+        if (rect.left + rect.width > mipWidth || rect.top + rect.height > mipHeight)
+        {
+            fprintf(stderr, "The --region (%d,%d,%dx%d) is outside of MIP level %d, which is %dx%d pixels.\n",
+                rect.left, rect.top, rect.width, rect.height, outRegion.firstMip, mipWidth, mipHeight);
+            return false;
+        }
+
+        outRegion.rect = rect;
+    }
+
+    return true;
+}
+
+
+// Returns the reason why the compressed texture set described by 'metadata' cannot be used
+// to initialize the training of 'textureSet', or nullptr if it can.
+static char const* GetWarmStartIncompatibility(ntc::ITextureSet* textureSet, ntc::ITextureSetMetadata* metadata)
+{
+    ntc::TextureSetDesc const& desc = textureSet->GetDesc();
+    ntc::TextureSetDesc const& warmDesc = metadata->GetDesc();
+    if (desc.width != warmDesc.width || desc.height != warmDesc.height || desc.mips != warmDesc.mips)
+        return "the dimensions or mip counts are different";
+
+    if (desc.channels != warmDesc.channels || textureSet->GetTextureCount() != metadata->GetTextureCount())
+        return "the channel layout is different";
+
+    for (int textureIndex = 0; textureIndex < textureSet->GetTextureCount(); ++textureIndex)
+    {
+        ntc::ITextureMetadata* texture = textureSet->GetTexture(textureIndex);
+        ntc::ITextureMetadata* warmTexture = metadata->GetTexture(textureIndex);
+
+        int firstChannel, numChannels, warmFirstChannel, warmNumChannels;
+        texture->GetChannels(firstChannel, numChannels);
+        warmTexture->GetChannels(warmFirstChannel, warmNumChannels);
+
+        if (firstChannel != warmFirstChannel || numChannels != warmNumChannels ||
+            strcmp(texture->GetName(), warmTexture->GetName()) != 0)
+            return "the channel layout is different";
+    }
+
+    ntc::LatentShape const shape = textureSet->GetLatentShape();
+    ntc::LatentShape const warmShape = metadata->GetLatentShape();
+    if (shape.gridSizeScale != warmShape.gridSizeScale ||
+        shape.highResFeatures != warmShape.highResFeatures ||
+        shape.lowResFeatures != warmShape.lowResFeatures ||
+        shape.highResQuantBits != warmShape.highResQuantBits ||
+        shape.lowResQuantBits != warmShape.lowResQuantBits ||
+        textureSet->GetNetworkVersion() != metadata->GetNetworkVersion())
+        return "the latent shape or network version is different";
+
+    return nullptr;
+}
+
+// Loads the latents and network weights from the --warmStart file into the texture set, keeping its reference
+// images, so that the following training fine-tunes them instead of starting from random values.
+// 'outLoaded' is set to false when the file is not compatible with the texture set, which is not an error.
+// 'outPsnr' receives the PSNR of the loaded data against the reference images.
+static bool LoadWarmStartData(ntc::IContext* context, ntc::ITextureSet* textureSet, bool& outLoaded,
+    float& outPsnr)
+{
+    outLoaded = false;
+    outPsnr = NAN;
+    char const* fileName = g_options.warmStartFileName;
+
+    std::string openError;
+    std::unique_ptr<ntc::IStream> inputFile = OpenTextureSetFile(fileName, &openError);
+    if (!inputFile)
+    {
+        fprintf(stderr, "Failed to open warm start file '%s': %s\n", fileName, openError.c_str());
+        return false;
+    }
+
+    ntc::TextureSetMetadataWrapper metadata(context);
+    ntc::Status ntcStatus = context->CreateTextureSetMetadataFromStream(inputFile.get(), metadata.ptr());
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        fprintf(stderr, "Failed to load texture set metadata from '%s', code = %s: %s\n", fileName,
+            ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        return false;
+    }
+
+    char const* incompatibility = GetWarmStartIncompatibility(textureSet, metadata);
+    if (!incompatibility)
+    {
+        inputFile->Seek(0);
+        ntcStatus = textureSet->LoadFromStream(inputFile.get());
+        if (ntcStatus == ntc::Status::FileIncompatible)
+            incompatibility = "the library cannot load it into this texture set";
+        else
+        {
+            CHECK_NTC_RESULT(LoadFromStream);
+        }
+    }
+
+    if (incompatibility)
+    {
+        PrintOutput("Warning: Cannot warm start from '%s' because %s, using full training.\n", fileName, incompatibility);
+        return true;
+    }
+
+    // Measure the loaded data, the training checks that its first intermediate PSNR is close to this value
+    ntc::DecompressionStats stats;
+    ntcStatus = textureSet->Decompress(&stats, /* useFP8Weights = */ false);
+    CHECK_NTC_RESULT(Decompress);
+    outPsnr = ntc::LossToPSNR(stats.overallLoss);
+
+    PrintOutput("Warm start from '%s', initial PSNR: %.2f dB.\n", fileName, outPsnr);
+
+    Json::Value event(Json::objectValue);
+    event["psnr"] = outPsnr;
+    EmitTelemetryEvent("warmStart", std::move(event));
+
+    outLoaded = true;
+    return true;
+}
+
+struct JobStats
+{
+    float loadSeconds = 0.f;
+    float compressionSeconds = 0.f;
+    float saveSeconds = 0.f;
+    float psnr = NAN;
+    float bitsPerPixel = NAN;
+    uint64_t fileSize = 0;
+    uint64_t pixels = 0;
+    int64_t peakHostBytes = 0;
+    int trainingSteps = 0;
+    bool cacheHit = false;
+};
+
+static float SecondsSince(std::chrono::steady_clock::time_point startTime)
+{
+    return std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+static void EmitStageEvent(char const* stage, float seconds)
+{
+    Json::Value event(Json::objectValue);
+    event["stage"] = stage;
+    event["seconds"] = seconds;
+    EmitTelemetryEvent("stage", std::move(event));
+}
+
+// Runs all the requested actions on a texture set that has been loaded from images or a compressed file.
+// The graphics resources are (re)created only when the ones passed in are not compatible with the texture set,
+// which allows batch mode to reuse them between jobs.
+bool ProcessTextureSet(
+    ntc::IContext* context,
+    nvrhi::IDevice* device,
+    nvrhi::ICommandList* commandList,
+    nvrhi::ITimerQuery* timerQuery,
+    ntc::ITextureSet* textureSet,
+    TextureSetSource const* source,
+    char const* saveCompressedFileName,
+    GraphicsResourcesForTextureSet& graphicsResources,
+    JobStats* outStats)
+{
+    OverrideBcFormats(textureSet);
+
+    if (g_options.describe)
+    {
+        DescribeTextureSet(textureSet);
+    }
+
+    textureSet->SetExperimentalKnob(g_options.experimentalKnob);
+
+    bool const anyBCTextures = AnyBlockCompressedTextures(textureSet);
+
+    // A texture set loaded from the --cache has already been compressed and BC-optimized with the same settings
+    bool const cacheHit = source && source->cacheHit;
+    bool const compress = g_options.compress && !cacheHit;
+    bool const matchBcPsnr = g_options.matchBcPsnr && !cacheHit;
+    bool const optimizeBC = g_options.optimizeBC && !cacheHit;
+
+    if (g_options.matchBcPsnr && !anyBCTextures)
+    {
+        fprintf(stderr, "--matchBcPsnr requires that at least one texture in the set is compressed to a BCn format.\n");
+        return false;
+    }
+
+    if (matchBcPsnr || optimizeBC || g_options.saveImagesPath && anyBCTextures)
+    {
+        // Verify that we have a graphics device - cannot do that in ProcessCommandLine
+        // because we don't know if there are any BCn textures at that point...
+        if (!device)
+        {
+            fprintf(stderr, "BCn encoding requires either --vk or --dx12 (where available).\n"
+                "To save images in a non-BC format, use --bcFormat none.\n");
+            return false;
+        }
 
-    while (!session->Finished())
+        int const mipLevels = g_options.saveImagesPath && g_options.saveMips ? textureSet->GetDesc().mips : 1;
+
+        if (AreGraphicsResourcesCompatible(textureSet, mipLevels, /* enableCudaSharing = */ true, graphicsResources))
+        {
+            // Reusing the resources from a previous job, only the names need to be updated
+            for (int textureIndex = 0; textureIndex < textureSet->GetTextureCount(); ++textureIndex)
+                graphicsResources.perTexture[textureIndex].name = textureSet->GetTexture(textureIndex)->GetName();
+        }
+        else
+        {
+            graphicsResources.perTexture.clear();
+
+            if (!CreateGraphicsResourcesFromMetadata(context, device, textureSet,
+                mipLevels, /* enableCudaSharing = */ true, graphicsResources))
+                return false;
+        }
+    }
+
+    float targetPsnr = g_options.targetPsnr;
+    if (matchBcPsnr)
     {
-        float bitsPerPixel;
-        ntc::LatentShape latentShape;
-        session->GetCurrentPreset(&bitsPerPixel, &latentShape);
+        if (!CopyTextureSetDataIntoGraphicsTextures(context, textureSet, ntc::TextureDataPage::Reference,
+            /* allMipLevels = */ false, /* onlyBlockCompressedFormats = */ true, graphicsResources))
+            return false;
 
-        printf("Experiment %d: %.2f bpp...\n", experimentCount + 1, bitsPerPixel);
+        if (!ComputePsnrForBlockCompressedTextureSet(context, textureSet, device,
+            commandList, graphicsResources, targetPsnr))
+            return false;
 
-        ntcStatus = textureSet->SetLatentShape(latentShape, g_options.networkVersion);
-        CHECK_NTC_RESULT(SetLatentShape)
+        // Apply the user-specified offset and limits
+        targetPsnr = std::min(g_options.maxBcPsnr, std::max(g_options.minBcPsnr,
+            targetPsnr + g_options.bcPsnrOffset));
 
-        float psnr = NAN;
-        if (!CompressTextureSet(context, textureSet, &psnr))
+        PrintOutput("Selected target PSNR: %.2f dB.\n", targetPsnr);
+    }
+    
+    float psnr = NAN;
+    int trainingSteps = 0;
+    auto const compressionStartTime = std::chrono::steady_clock::now();
+    if (compress)
+    {
+        bool warmStartLoaded = false;
+        float warmStartPsnr = NAN;
+        if (g_options.warmStartFileName &&
+            !LoadWarmStartData(context, textureSet, warmStartLoaded, warmStartPsnr))
             return false;
 
-        // Store the compression result
-        AdaptiveSearchResult result;
-        result.bitsPerPixel = bitsPerPixel;
-        result.latentShape = latentShape;
-        result.psnr = psnr;
+        bool fullTraining = !warmStartLoaded;
+        if (warmStartLoaded)
+        {
+            // Fine-tuning needs fewer steps than training from scratch
+            ntc::CompressionSettings settings = g_options.compressionSettings;
+            settings.trainingSteps = g_options.warmStartSteps > 0
+                ? g_options.warmStartSteps
+                : std::max(settings.trainingSteps / 4, 1);
+
+            EarlyStopCriteria earlyStop = GetEarlyStopCriteria(NAN);
+            earlyStop.warmStartPsnr = warmStartPsnr;
 
-        // Save the compressed data to an in-memory vector
-        size_t bufferSize = textureSet->GetOutputStreamSize();
-        result.compressedData.resize(bufferSize);
-        ntcStatus = textureSet->SaveToMemory(result.compressedData.data(), &bufferSize);
-        CHECK_NTC_RESULT(SaveToMemory)
+            bool warmStartLost = false;
+            if (!CompressTextureSet(context, textureSet, earlyStop, &psnr, &trainingSteps, &settings, &warmStartLost))
+                return false;
 
-        // Trim the buffer to the actual size of the saved data
-        result.compressedData.resize(bufferSize);
+            // The reduced step count is only enough when the training starts from the loaded data
+            if (warmStartLost)
+            {
+                PrintOutput("Warning: The training did not start from the warm start data, its first intermediate "
+                    "PSNR is more than %.0f dB below %.2f dB. Using full training.\n",
+                    g_warmStartPsnrTolerance, warmStartPsnr);
+                EmitTelemetryEvent("warmStartLost", Json::Value(Json::objectValue));
+                fullTraining = true;
+            }
+        }
 
-        results.push_back(std::move(result));
-        
-        session->Next(psnr);
-        ++experimentCount;
+        // Warm start is not allowed with a target PSNR, so its fallback always uses the first branch
+        if (fullTraining && std::isnan(targetPsnr))
+        {
+            if (!CompressTextureSet(context, textureSet, GetEarlyStopCriteria(NAN), &psnr, &trainingSteps))
+                return false;
+        }
+        else if (fullTraining)
+        {
+            if (!CompressTextureSetWithTargetPSNR(context, textureSet, source, targetPsnr, &psnr, &trainingSteps))
+                return false;
+        }
     }
 
-    // Get and validate the index of the final result
-    int finalIndex = session->GetIndexOfFinalRun();
-    if (finalIndex < 0 || finalIndex >= int(results.size()))
+    if (g_options.decompress)
     {
-        fprintf(stderr, "Internal error: GetIndexOfFinalRun() returned %d, which is not a valid index!\n", finalIndex);
-        return false;
+        if (compress && textureSet->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericFP8))
+        {
+            if (!DecompressTextureSet(context, textureSet, /* useFP8Weights = */ true, !cacheHit))
+                return false;
+        }
+
+        if (!DecompressTextureSet(context, textureSet, /* useFP8Weights = */ false, !cacheHit, &psnr))
+            return false;
     }
 
-    // Find the final compresison result
-    auto const& result = results[finalIndex];
+    if (optimizeBC || g_options.saveImagesPath && anyBCTextures)
+    {
+        if (!CopyTextureSetDataIntoGraphicsTextures(context, textureSet, ntc::TextureDataPage::Output,
+            /* allMipLevels = */ true, /* onlyBlockCompressedFormats = */ true, graphicsResources))
+            return false;
+    }
 
-    printf("Selected compression rate: %.2f bpp, %.2f dB PSNR.\n", result.bitsPerPixel, result.psnr);
-    if (result.psnr < targetPsnr)
-        printf("WARNING: Target PSNR of %.2f dB was not reached!\n", targetPsnr);
+    if (optimizeBC)
+    {
+        if (!OptimizeBlockCompression(context, textureSet, device,
+            commandList, g_options.bcPsnrThreshold, graphicsResources))
+            return false;
+    }
+    float const compressionSeconds = SecondsSince(compressionStartTime);
+    EmitStageEvent("compression", compressionSeconds);
 
-    // If the texture set already has the final shape, do nothing - its data is valid.
-    if (result.latentShape == textureSet->GetLatentShape())
-        return true;
+    // Compression needs CUDA, so the device memory is only reported after compressing, while the set is still alive
+    if (compress && IsTelemetryEnabled())
+    {
+        size_t freeBytes = 0, totalBytes = 0;
+        if (cudaSetDevice(source ? source->cudaDevice : g_options.cudaDevice) == cudaSuccess &&
+            cudaMemGetInfo(&freeBytes, &totalBytes) == cudaSuccess)
+        {
+            Json::Value event(Json::objectValue);
+            event["cudaDevice"] = source ? source->cudaDevice : g_options.cudaDevice;
+            event["gpuUsedBytes"] = Json::UInt64(totalBytes - freeBytes);
+            event["gpuTotalBytes"] = Json::UInt64(totalBytes);
+            EmitTelemetryEvent("memory", std::move(event));
+        }
+    }
 
-    // Otherwise, restore the final compression result into the texture set.
-    ntcStatus = textureSet->LoadFromMemory(result.compressedData.data(), result.compressedData.size());
-    CHECK_NTC_RESULT(LoadFromMemory)
+    auto const saveStartTime = std::chrono::steady_clock::now();
+    if (g_options.saveImagesPath)
+    {
+        if (anyBCTextures)
+        {
+            if (!BlockCompressAndSaveGraphicsTextures(context, textureSet, device, commandList, timerQuery,
+                g_options.saveImagesPath, g_options.bcQuality, g_options.benchmarkIterations, graphicsResources))
+                return false;
+        }
+            
+        if (!SaveImagesFromTextureSet(context, textureSet))
+            return false;
+
+        PrintOutput("Image export time: %.3f ms\n", SecondsSince(saveStartTime) * 1e3f);
+    }
+
+    uint64_t fileSize = 0;
+    float bitsPerPixel = NAN;
+    if (saveCompressedFileName)
+    {
+        if (!SaveCompressedTextureSet(context, textureSet, saveCompressedFileName, &fileSize, &bitsPerPixel))
+            return false;
+
+        if (g_compressionCache && source && !source->cacheKey.empty() && !cacheHit)
+            g_compressionCache->Store(source->cacheKey, saveCompressedFileName);
+    }
+
+    float const saveSeconds = SecondsSince(saveStartTime);
+    EmitStageEvent("save", saveSeconds);
+
+    if (outStats)
+    {
+        outStats->compressionSeconds = compressionSeconds;
+        outStats->saveSeconds = saveSeconds;
+        outStats->psnr = psnr;
+        outStats->bitsPerPixel = bitsPerPixel;
+        outStats->fileSize = fileSize;
+        outStats->trainingSteps = trainingSteps;
+    }
 
     return true;
 }
 
-bool DecompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet, bool useFP8Weights)
+// Parses one line of the batch file: "<input>" or "<input><TAB><output.ntc>".
+// Empty lines and lines starting with '#' are skipped.
+static bool ParseBatchJob(std::string line, std::string& outInput, std::string& outOutput)
 {
-    ntc::DecompressionStats stats;
-    ntc::Status ntcStatus = textureSet->Decompress(&stats, useFP8Weights);
-    CHECK_NTC_RESULT(NtcDecompress);
-
-    printf("CUDA decompression time: %.3f ms\n", stats.gpuTimeMilliseconds);
+    // Trim the line ending and surrounding whitespace
+    while (!line.empty() && isspace(uint8_t(line.back())))
+        line.pop_back();
+    size_t const firstChar = line.find_first_not_of(" \t");
+    if (firstChar == std::string::npos || line[firstChar] == '#')
+        return false;
+    line = line.substr(firstChar);
 
-    if (g_options.inputType == ToolInputType::Directory ||
-        g_options.inputType == ToolInputType::Manifest ||
-        g_options.inputType == ToolInputType::Images)
+    size_t const tab = line.find('\t');
+    if (tab != std::string::npos)
     {
-        printf("Overall PSNR (%s weights): %.2f dB\n", useFP8Weights ? "FP8" : "INT8", ntc::LossToPSNR(stats.overallLoss));
-        
-        if (!useFP8Weights)
-        {
-            size_t maxNameLength = 0;
-            for (int i = 0; i < textureSet->GetTextureCount(); ++i)
-            {
-                maxNameLength = std::max(maxNameLength, strlen(textureSet->GetTexture(i)->GetName()));
-            }
+        outInput = line.substr(0, tab);
+        outOutput = line.substr(line.find_first_not_of('\t', tab));
+    }
+    else
+    {
+        // Default output name is the input name with the .ntc extension, placed next to the input
+        outInput = line;
+        outOutput = fs::path(line).replace_extension(".ntc").generic_string();
+    }
 
-            printf("Per-texture PSNR:\n");
-            for (int i = 0; i < textureSet->GetTextureCount(); ++i)
-            {
-                ntc::ITextureMetadata* texture = textureSet->GetTexture(i);
-                int firstChannel, numChannels;
-                texture->GetChannels(firstChannel, numChannels);
+    return true;
+}
 
-                float textureMSE = 0.f;
-                for (int ch = firstChannel; ch < firstChannel + numChannels; ++ch)
-                {
-                    textureMSE += stats.perChannelLoss[ch];
-                }
-                textureMSE /= float(numChannels);
+struct BatchJob
+{
+    int index = 0;
+    std::string input;
+    std::string output;
+    // Manifest that was already parsed or generated by the directory scan, read from 'input' otherwise
+    std::optional<Manifest> manifest;
+    bool manifestIsGenerated = false;
+    std::chrono::steady_clock::time_point enqueueTime;
+};
 
-                printf("  %-*s : %.2f dB [ ", int(maxNameLength), texture->GetName(), ntc::LossToPSNR(textureMSE));
-                for (int ch = firstChannel; ch < firstChannel + numChannels; ++ch)
-                {
-                    printf("%.2f ", ntc::LossToPSNR(stats.perChannelLoss[ch]));
-                }
-                printf("]\n");
-            }
-        }
+// Queue of batch jobs shared by all devices. Jobs are taken by whichever device becomes idle first,
+// so faster devices and devices that got smaller texture sets pick up more of the work.
+class BatchJobQueue
+{
+public:
+    void Push(BatchJob&& job)
+    {
+        std::lock_guard lockGuard(m_mutex);
+        m_jobs.push_back(std::move(job));
+        m_condition.notify_one();
+    }
 
-        if (textureSet->GetDesc().mips > 1)
-        {
-            for (int mip = 0; mip < textureSet->GetDesc().mips; ++mip)
-            {
-                printf("MIP %2d  PSNR: %.2f dB\n", mip, ntc::LossToPSNR(stats.perMipLoss[mip]));
-            }
-        }
+    // Marks the end of input, Pop returns false once all remaining jobs are taken.
+    void Close()
+    {
+        std::lock_guard lockGuard(m_mutex);
+        m_closed = true;
+        m_condition.notify_all();
     }
 
-    return true;
+    bool Pop(BatchJob& outJob)
+    {
+        std::unique_lock lock(m_mutex);
+        m_condition.wait(lock, [this]() { return !m_jobs.empty() || m_closed; });
+        if (m_jobs.empty())
+            return false;
+
+        outJob = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<BatchJob> m_jobs;
+    bool m_closed = false;
+};
+
+struct BatchDeviceStats
+{
+    int cudaDevice = 0;
+    int jobCount = 0;
+    int failedJobCount = 0;
+    uint64_t pixels = 0;
+    float busySeconds = 0.f;
+    float idleSeconds = 0.f;
+    float queueWaitSeconds = 0.f;
+};
+
+// Serializes the console and report output coming from multiple batch workers.
+struct BatchOutput
+{
+    std::mutex mutex;
+    FILE* reportFile = nullptr;
+    std::vector<std::string> completedOutputs; // For --saveArchive
+};
+
+static uint64_t GetTextureSetPixelCount(ntc::ITextureSetMetadata* textureSetMetadata)
+{
+    ntc::TextureSetDesc const& desc = textureSetMetadata->GetDesc();
+    uint64_t pixels = 0;
+    for (int mip = 0; mip < desc.mips; ++mip)
+        pixels += uint64_t(std::max(desc.width >> mip, 1)) * uint64_t(std::max(desc.height >> mip, 1));
+    return pixels;
 }
 
-bool SaveCompressedTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet)
+static bool RunBatchJob(
+    ntc::IContext* context,
+    nvrhi::IDevice* device,
+    nvrhi::ICommandList* commandList,
+    nvrhi::ITimerQuery* timerQuery,
+    int cudaDevice,
+    BatchJob const& job,
+    GraphicsResourcesForTextureSet& graphicsResources,
+    JobStats& stats)
 {
-    ntc::FileStreamWrapper outputStream(context);
-    
-    ntc::Status ntcStatus = context->OpenFile(g_options.saveCompressedFileName, true, outputStream.ptr());
-    if (ntcStatus != ntc::Status::Ok)
+    auto const loadStartTime = std::chrono::steady_clock::now();
+
+    Manifest manifest;
+    bool manifestIsGenerated = false;
+    std::string manifestError;
+    if (job.manifest.has_value())
+    {
+        manifest = *job.manifest;
+        manifestIsGenerated = job.manifestIsGenerated;
+    }
+    else if (fs::is_directory(job.input))
+    {
+        GenerateManifestFromDirectory(job.input.c_str(), g_options.loadMips, manifest,
+            /* includeTextureContainers = */ true);
+        manifestIsGenerated = true;
+    }
+    else if (!ReadManifestFromFile(job.input.c_str(), manifest, manifestError))
     {
-        fprintf(stderr, "Cannot open output file '%s', code = %s\n%s\n",
-            g_options.saveCompressedFileName, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        fprintf(stderr, "%s\n", manifestError.c_str());
         return false;
     }
 
-    ntcStatus = textureSet->SaveToStream(outputStream);
-    if (ntcStatus != ntc::Status::Ok)
+    // Several workers may try to create the same directory at once, so only fail if it's still missing
+    fs::path const outputPath = fs::path(job.output).parent_path();
+    std::error_code ec;
+    if (!outputPath.empty() && !fs::is_directory(outputPath) && !fs::create_directories(outputPath, ec)
+        && !fs::is_directory(outputPath))
     {
-        fprintf(stderr, "Failed to save compressed texture to output file '%s', code = %s\n%s\n",
-            g_options.saveCompressedFileName, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        fprintf(stderr, "Failed to create directories for '%s'.\n", outputPath.generic_string().c_str());
         return false;
     }
 
-    size_t texturePixels = 0;
-    ntc::TextureSetDesc const& desc = textureSet->GetDesc();
-    for (int mip = 0; mip < desc.mips; ++mip)
+    TextureSetSource source;
+    source.manifest = &manifest;
+    source.manifestIsGenerated = manifestIsGenerated;
+    source.cudaDevice = cudaDevice;
+
+    ntc::TextureSetWrapper textureSet(context);
+    *textureSet.ptr() = LoadImagesOrCachedResult(context, manifest, manifestIsGenerated, source);
+    stats.loadSeconds = SecondsSince(loadStartTime);
+    stats.cacheHit = source.cacheHit;
+    if (!textureSet)
+        return false;
+
+    stats.pixels = GetTextureSetPixelCount(textureSet);
+
+    return ProcessTextureSet(context, device, commandList, timerQuery, textureSet, &source,
+        job.output.c_str(), graphicsResources, &stats);
+}
+
+// Takes jobs from the queue and executes them on one device until the queue is closed and empty.
+static void RunBatchWorker(
+    ntc::IContext* context,
+    nvrhi::IDevice* device,
+    nvrhi::ICommandList* commandList,
+    nvrhi::ITimerQuery* timerQuery,
+    PooledAllocator* allocator,
+    BatchJobQueue* queue,
+    BatchOutput* output,
+    BatchDeviceStats* deviceStats)
+{
+    // Keep the graphics resources between jobs, they are only recreated when texture set shapes change
+    GraphicsResourcesForTextureSet graphicsResources;
+
+    // The job prints its progress through PrintOutput, which holds the output mutex for every message
+    SetThreadOutputMutex(&output->mutex);
+
+    while (true)
     {
-        int mipWidth = std::max(1, desc.width >> mip);
-        int mipHeight = std::max(1, desc.height >> mip);
-        texturePixels += size_t(mipWidth) * size_t(mipHeight);
-    }
-    uint64_t const fileSize = outputStream->Tell();
-    float const bpp = 8.f * float(fileSize) / float(texturePixels);
+        auto const idleStartTime = std::chrono::steady_clock::now();
+        BatchJob job;
+        if (!queue->Pop(job))
+            break;
+        deviceStats->idleSeconds += SecondsSince(idleStartTime);
 
-    printf("Saved '%s'\n", g_options.saveCompressedFileName);
-    printf("File size: %" PRIu64 " bytes, %.2f bits per pixel.\n", fileSize, bpp);
+        float const queueWaitSeconds = SecondsSince(job.enqueueTime);
 
-    return true;
+        {
+            std::lock_guard lockGuard(output->mutex);
+            printf("Batch job %d: '%s' -> '%s' on CUDA device %d\n", job.index, job.input.c_str(),
+                job.output.c_str(), deviceStats->cudaDevice);
+            fflush(stdout);
+        }
+
+        auto const jobStartTime = std::chrono::steady_clock::now();
+        JobStats stats;
+        // Each device has its own allocator and runs one job at a time, so the peak belongs to this job
+        allocator->ResetPeak();
+        bool const success = RunBatchJob(context, device, commandList, timerQuery, deviceStats->cudaDevice,
+            job, graphicsResources, stats);
+        stats.peakHostBytes = allocator->GetStats().peakBytesAllocated;
+
+        ++deviceStats->jobCount;
+        if (success)
+            deviceStats->pixels += stats.pixels;
+        else
+            ++deviceStats->failedJobCount;
+        deviceStats->busySeconds += SecondsSince(jobStartTime);
+        deviceStats->queueWaitSeconds += queueWaitSeconds;
+
+        std::lock_guard lockGuard(output->mutex);
+
+        if (output->reportFile)
+        {
+            fprintf(output->reportFile, "\"%s\",\"%s\",%s,%d,%.3f,%.3f,%.3f,%.3f,%.2f,%.3f,%" PRIu64 ",%d,%d,%.2f\n",
+                job.input.c_str(), job.output.c_str(), success ? "OK" : "FAILED", deviceStats->cudaDevice,
+                queueWaitSeconds, stats.loadSeconds, stats.compressionSeconds, stats.saveSeconds,
+                stats.psnr, stats.bitsPerPixel, stats.fileSize, stats.trainingSteps, stats.cacheHit ? 1 : 0,
+                double(stats.peakHostBytes) * 0x1p-20);
+            fflush(output->reportFile);
+        }
+
+        if (success)
+            output->completedOutputs.push_back(job.output);
+
+        if (IsTelemetryEnabled())
+        {
+            Json::Value event(Json::objectValue);
+            event["index"] = job.index;
+            event["input"] = job.input;
+            event["output"] = job.output;
+            event["success"] = success;
+            event["cudaDevice"] = deviceStats->cudaDevice;
+            event["queueWaitSeconds"] = queueWaitSeconds;
+            event["loadSeconds"] = stats.loadSeconds;
+            event["compressionSeconds"] = stats.compressionSeconds;
+            event["saveSeconds"] = stats.saveSeconds;
+            event["psnr"] = stats.psnr;
+            event["bitsPerPixel"] = stats.bitsPerPixel;
+            event["fileSize"] = Json::UInt64(stats.fileSize);
+            event["pixels"] = Json::UInt64(stats.pixels);
+            event["trainingSteps"] = stats.trainingSteps;
+            event["cacheHit"] = stats.cacheHit;
+            event["peakHostBytes"] = Json::Int64(stats.peakHostBytes);
+            EmitTelemetryEvent("batchJob", std::move(event));
+        }
+
+        printf("Batch job %d %s: load %.2f s, compression %.2f s, save %.2f s, PSNR %.2f dB.\n", job.index,
+            success ? "completed" : "FAILED", stats.loadSeconds, stats.compressionSeconds, stats.saveSeconds, stats.psnr);
+        fflush(stdout);
+    }
+
+    SetThreadOutputMutex(nullptr);
 }
 
-ntc::ITextureSet* LoadCompressedTextureSet(ntc::IContext* context)
+// Creates a CUDA-only context for one of the additional --cudaDevices.
+static bool CreateBatchContext(int cudaDevice, ntc::IAllocator* allocator, ntc::ContextWrapper& context)
 {
-    ntc::ITextureSet* textureSet = nullptr;
-    ntc::TextureSetFeatures textureSetFeatures;
-    textureSetFeatures.enableCompression = false;
-    textureSetFeatures.stagingBytesPerPixel = 16;
-    
-    ntc::Status ntcStatus = context->CreateCompressedTextureSetFromFile(
-        g_options.loadCompressedFileName, textureSetFeatures, &textureSet);
+    ntc::ContextParameters contextParams;
+    contextParams.pAllocator = allocator;
+    contextParams.cudaDevice = cudaDevice;
 
+    ntc::Status const ntcStatus = ntc::CreateContext(context.ptr(), contextParams);
     if (ntcStatus != ntc::Status::Ok)
     {
-        fprintf(stderr, "Failed to load compressed texture from file '%s', code = %s\n%s\n",
-            g_options.loadCompressedFileName, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-        return nullptr;
+        fprintf(stderr, "Failed to create an NTC context for CUDA device %d, code = %s: %s\n",
+            cudaDevice, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        return false;
     }
-    
-    return textureSet;
+
+    return true;
 }
 
-donut::app::DeviceCreationParameters GetGraphicsDeviceParameters(nvrhi::GraphicsAPI graphicsApi)
+// Scans the --batch directory and queues a job for every material as soon as its manifest is ready.
+// Returns the number of manifests and directories that could not be read.
+static size_t ScanBatchDirectory(BatchJobQueue* queue, BatchOutput* output)
 {
-    donut::app::DeviceCreationParameters deviceParams;
-    deviceParams.infoLogSeverity = donut::log::Severity::None;
-    deviceParams.adapterIndex = g_options.adapterIndex;
-    deviceParams.enableDebugRuntime = g_options.debug;
-    deviceParams.enableNvrhiValidationLayer = g_options.debug;
+    std::atomic<int> jobCount = 0;
+
+    ManifestIndexParameters params;
+    params.rootPath = g_options.batchFileName;
+    params.cacheFileName = g_options.batchIndexFileName;
+    params.loadMips = g_options.loadMips;
+    params.includeTextureContainers = true;
+
+    ManifestIndexStats stats;
+    std::string error;
+    auto const scanStartTime = std::chrono::steady_clock::now();
+    bool const success = ScanManifestIndex(params,
+        [queue, &jobCount](ManifestIndexMaterial&& material)
+        {
+            BatchJob job;
+            job.index = ++jobCount;
+            job.input = std::move(material.path);
+            job.output = fs::path(job.input).replace_extension(".ntc").generic_string();
+            job.manifest = std::move(material.manifest);
+            job.manifestIsGenerated = material.isDirectory;
+            job.enqueueTime = std::chrono::steady_clock::now();
+            queue->Push(std::move(job));
+        },
+        [output](std::string const& path, std::string const& error)
+        {
+            std::lock_guard lockGuard(output->mutex);
+            fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+        },
+        &stats, error);
 
-    SetNtcGraphicsDeviceParameters(deviceParams, graphicsApi, true, nullptr);
+    std::lock_guard lockGuard(output->mutex);
+    if (!success)
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
 
-    return deviceParams;
+    printf("Scanned %zu directories (%zu from the index) in %.2f s, found %zu materials, %zu errors.\n",
+        stats.directories, stats.cachedDirectories, SecondsSince(scanStartTime), stats.materials, stats.errors);
+    return stats.errors;
 }
 
-void DescribeTextureSet(ntc::ITextureSetMetadata* textureSet)
+// Packs the texture set files into the --saveArchive file. Entries are named with the file paths relative to the
+// archive's directory, which is how the renderer finds the materials of a scene placed next to the archive.
+static bool SaveTextureSetArchive(ntc::IContext* context, std::vector<std::string> const& fileNames)
 {
-    ntc::TextureSetDesc const& desc = textureSet->GetDesc();
-    printf("Dimensions: %dx%d, %d channels, %d mip level(s)\n", desc.width, desc.height, desc.channels, desc.mips);
-    
-    ntc::LatentShape const& latentShape = textureSet->GetLatentShape();
-    printf("Base compression rate: --bitsPerPixel %.3f\n", ntc::GetLatentShapeBitsPerPixel(latentShape));
-    printf("Latent shape: --gridSizeScale %d --highResFeatures %d --lowResFeatures %d --highResQuantBits %d --lowResQuantBits %d\n",
-        latentShape.gridSizeScale, latentShape.highResFeatures, latentShape.lowResFeatures,
-        latentShape.highResQuantBits, latentShape.lowResQuantBits);
-    printf("Network version: %s\n", ntc::NetworkVersionToString(textureSet->GetNetworkVersion()));
-    printf("Inference weights: Int8 [%c], FP8 [%c]\n",
-        textureSet->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericInt8) ? 'Y' : 'N',
-        textureSet->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericFP8) ? 'Y' : 'N');
-        
-    printf("Textures:\n");
-    for (int i = 0; i < textureSet->GetTextureCount(); ++i)
+    auto const saveStartTime = std::chrono::steady_clock::now();
+    fs::path const archiveDirectory = fs::absolute(g_options.saveArchiveFileName).parent_path();
+
+    std::string error;
+    TextureSetArchiveWriter writer;
+    if (!writer.Open(g_options.saveArchiveFileName, error))
     {
-        ntc::ITextureMetadata* texture = textureSet->GetTexture(i);
-        int firstChannel, numChannels;
-        texture->GetChannels(firstChannel, numChannels);
-        printf("%d: %s\n", i, texture->GetName());
-        printf("   Channels: %d-%d\n", firstChannel, firstChannel + numChannels - 1);
-        printf("   Channel format: %s\n", ntc::ChannelFormatToString(texture->GetChannelFormat()));
-        printf("   BCn format: %s\n", ntc::BlockCompressedFormatToString(texture->GetBlockCompressedFormat()));
-        printf("   RGB color space: %s\n", ntc::ColorSpaceToString(texture->GetRgbColorSpace()));
-        if (numChannels > 3)
-            printf("   Alpha color space: %s\n", ntc::ColorSpaceToString(texture->GetAlphaColorSpace()));
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
 
-        if (texture->GetBlockCompressedFormat() == ntc::BlockCompressedFormat::BC7)
+    std::vector<uint8_t> data;
+    for (std::string const& fileName : fileNames)
+    {
+        // Page-compressed files are inflated here, archived texture sets are always stored uncompressed
+        // so that they can be read straight from the archive mapping
+        std::string openError;
+        std::unique_ptr<ntc::IStream> inputFile = OpenTextureSetFile(fileName.c_str(), &openError);
+        if (!inputFile)
         {
-            printf("   BC acceleration data: %s\n", texture->HasBlockCompressionAccelerationData() ? "YES" : "NO");
-            if (texture->HasBlockCompressionAccelerationData())
-                printf("   BC default quality: %d\n", texture->GetBlockCompressionQuality());
+            fprintf(stderr, "Failed to open input file '%s': %s\n", fileName.c_str(), openError.c_str());
+            return false;
         }
-        
-        bool colorSpacesMatch = true;
-        for (int ch = 0; ch < numChannels; ++ch)
+
+        data.resize(size_t(inputFile->Size()));
+        if (!inputFile->Read(data.data(), data.size()) || !inputFile->Seek(0))
         {
-            ntc::ColorSpace const dstColorSpace = (ch < 3) ? texture->GetRgbColorSpace() : texture->GetAlphaColorSpace();
-            if (textureSet->GetChannelStorageColorSpace(firstChannel + ch) != dstColorSpace)
-            {
-                colorSpacesMatch = false;
-                break;
-            }
+            fprintf(stderr, "Failed to read file '%s'.\n", fileName.c_str());
+            return false;
+        }
+
+        ntc::TextureSetMetadataWrapper metadata(context);
+        ntc::Status const ntcStatus = context->CreateTextureSetMetadataFromStream(inputFile.get(), metadata.ptr());
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to load texture set metadata from '%s', code = %s: %s\n", fileName.c_str(),
+                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
         }
 
-        if (!colorSpacesMatch)
+        std::string const name = fs::absolute(fileName).lexically_relative(archiveDirectory).generic_string();
+        if (!writer.AddTextureSet(name, data.data(), data.size(), metadata, error))
         {
-            printf("   Storage color spaces: ");
-            for (int ch = 0; ch < numChannels; ++ch)
-            {
-                if (ch > 0) printf(", ");
-                printf("%s", ntc::ColorSpaceToString(textureSet->GetChannelStorageColorSpace(firstChannel + ch)));
-            }
-            printf("\n");
+            fprintf(stderr, "%s\n", error.c_str());
+            return false;
         }
     }
-}
 
-static bool ListCudaDevices()
-{
-    int count = 0;
-    cudaError_t err = cudaGetDeviceCount(&count);
-    if (err != cudaSuccess)
+    if (!writer.Close(error))
     {
-        fprintf(stderr, "Call to cudaGetDeviceCount failed, error code = %s.\n", cudaGetErrorName(err));
+        fprintf(stderr, "%s\n", error.c_str());
         return false;
     }
 
-    if (count == 0)
+    printf("Saved %zu texture set(s) into archive '%s' in %.2f s.\n", fileNames.size(),
+        g_options.saveArchiveFileName, SecondsSince(saveStartTime));
+    return true;
+}
+
+// Processes the jobs listed in the --batch file or stdin, or found in the --batch directory. The first device uses
+// the context and graphics device created by main, and every additional device from --cudaDevices gets its own
+// CUDA-only context and worker thread. All workers take their jobs from a shared queue which is filled as the lines
+// are read or the materials are found, so a producer can keep feeding stdin while earlier jobs are running.
+bool RunBatch(
+    ntc::IContext* context,
+    nvrhi::IDevice* device,
+    nvrhi::ICommandList* commandList,
+    nvrhi::ITimerQuery* timerQuery,
+    PooledAllocator* allocator)
+{
+    bool const useDirectory = fs::is_directory(g_options.batchFileName);
+    bool const useStdin = strcmp(g_options.batchFileName, "-") == 0;
+    std::ifstream batchFile;
+    if (!useStdin && !useDirectory)
     {
-        printf("No CUDA devices available.\n");
-        return true;
+        batchFile.open(g_options.batchFileName);
+        if (!batchFile.is_open())
+        {
+            fprintf(stderr, "Cannot open batch file '%s'.\n", g_options.batchFileName);
+            return false;
+        }
+    }
+    std::istream& input = useStdin ? std::cin : batchFile;
+
+    std::vector<int> cudaDevices = g_options.batchCudaDevices;
+    if (cudaDevices.empty())
+        cudaDevices.push_back(g_options.cudaDevice);
+    size_t const deviceCount = cudaDevices.size();
+
+    // Create the contexts for additional devices before starting any jobs.
+    // PooledAllocator is thread-safe, but each context gets its own allocator to track the memory per device
+    // and per job. The first device uses the allocator that main created for its context.
+    std::vector<PooledAllocator> allocators(deviceCount);
+    std::vector<ntc::ContextWrapper> contexts(deviceCount);
+    for (size_t deviceIndex = 1; deviceIndex < deviceCount; ++deviceIndex)
+    {
+        if (!CreateBatchContext(cudaDevices[deviceIndex], &allocators[deviceIndex], contexts[deviceIndex]))
+            return false;
     }
 
-    for (int device = 0; device < count; ++device)
+    BatchOutput output;
+    if (g_options.batchReportFileName)
     {
-        cudaDeviceProp prop{};
-        err = cudaGetDeviceProperties(&prop, device);
-        if (err != cudaSuccess)
+        output.reportFile = fopen(g_options.batchReportFileName, "w");
+        if (!output.reportFile)
         {
-            fprintf(stderr, "Call to cudaGetDeviceProperties(%d) failed, error code = %s.\n",
-                device, cudaGetErrorName(err));
+            fprintf(stderr, "Cannot open batch report file '%s': %s\n", g_options.batchReportFileName, strerror(errno));
             return false;
         }
-
-        printf("Device %d: %s (compute capability %d.%d, %zu MB VRAM)\n", device, prop.name,
-            prop.major, prop.minor, prop.totalGlobalMem / (1024 * 1024));
+        fprintf(output.reportFile, "Input,Output,Status,Device,QueueWait(s),LoadTime(s),CompressionTime(s),"
+            "SaveTime(s),PSNR,BPP,FileSize,TrainingSteps,CacheHit,PeakHostMemory(MB)\n");
+        fflush(output.reportFile);
     }
 
-    return true;
-}
+    std::vector<BatchDeviceStats> deviceStats(deviceCount);
+    for (size_t deviceIndex = 0; deviceIndex < deviceCount; ++deviceIndex)
+        deviceStats[deviceIndex].cudaDevice = cudaDevices[deviceIndex];
 
-void OverrideBcFormats(ntc::ITextureSetMetadata* textureSetMetadata)
-{
-    // Override the BC format from command line, if specified.
-    // Overriding with 'none' is also an option here.
-    if (g_options.bcFormat.has_value())
+    auto const batchStartTime = std::chrono::steady_clock::now();
+    BatchJobQueue queue;
+
+    std::vector<std::thread> workers;
+    for (size_t deviceIndex = 1; deviceIndex < deviceCount; ++deviceIndex)
     {
-        for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+        workers.emplace_back(RunBatchWorker, contexts[deviceIndex].Get(), nullptr, nullptr, nullptr,
+            &allocators[deviceIndex], &queue, &output, &deviceStats[deviceIndex]);
+    }
+
+    size_t scanErrorCount = 0;
+    std::thread reader([&queue, &input, &output, &scanErrorCount, useDirectory]()
+    {
+        if (useDirectory)
         {
-            ntc::ITextureMetadata* texture = textureSetMetadata->GetTexture(textureIndex);
-            ntc::BlockCompressedFormat bcFormat = *g_options.bcFormat;
+            scanErrorCount = ScanBatchDirectory(&queue, &output);
+            queue.Close();
+            return;
+        }
 
-            // Automatic selection of BCn mode based on channel count and HDR-ness
-            if (bcFormat == BlockCompressedFormat_Auto)
-            {
-                ntc::ChannelFormat const channelFormat = texture->GetChannelFormat();
-                if (channelFormat == ntc::ChannelFormat::FLOAT16 || channelFormat == ntc::ChannelFormat::FLOAT32)
-                {
-                    // HDR textures use only BC6, no other options
-                    bcFormat = ntc::BlockCompressedFormat::BC6;
-                }
-                else
-                {
-                    // Best quality options.
-                    // If you want more control, use a manifest.
-                    int const channels = texture->GetNumChannels();
-                    switch(channels)
-                    {
-                        case 1:  bcFormat = ntc::BlockCompressedFormat::BC4; break;
-                        case 2:  bcFormat = ntc::BlockCompressedFormat::BC5; break;
-                        default: bcFormat = ntc::BlockCompressedFormat::BC7; break;
-                    }       
-                }
-            }
+        int jobCount = 0;
+        std::string line;
+        while (std::getline(input, line))
+        {
+            BatchJob job;
+            if (!ParseBatchJob(line, job.input, job.output))
+                continue;
 
-            assert(bcFormat != BlockCompressedFormat_Auto);
-    
-            texture->SetBlockCompressedFormat(bcFormat);
+            job.index = ++jobCount;
+            job.enqueueTime = std::chrono::steady_clock::now();
+            queue.Push(std::move(job));
         }
-    }
-}
+        queue.Close();
+    });
 
-bool AnyBlockCompressedTextures(ntc::ITextureSetMetadata* textureSetMetadata)
-{
-    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+    RunBatchWorker(context, device, commandList, timerQuery, allocator, &queue, &output, &deviceStats[0]);
+
+    reader.join();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    if (output.reportFile)
+        fclose(output.reportFile);
+
+    int jobCount = 0;
+    int failedJobCount = 0;
+    for (BatchDeviceStats const& stats : deviceStats)
     {
-        ntc::ITextureMetadata* textureMetadata = textureSetMetadata->GetTexture(textureIndex);
-        if (textureMetadata->GetBlockCompressedFormat() != ntc::BlockCompressedFormat::None)
-        {
-            return true;
-        }
+        jobCount += stats.jobCount;
+        failedJobCount += stats.failedJobCount;
+
+        double const megapixels = double(stats.pixels) * 1e-6;
+        printf("CUDA device %d: %d job(s), %d failed, %.1f MPix in %.2f s (%.2f MPix/s), "
+            "average queue wait %.2f s, idle %.2f s.\n", stats.cudaDevice, stats.jobCount, stats.failedJobCount,
+            megapixels, stats.busySeconds, stats.busySeconds > 0.f ? megapixels / stats.busySeconds : 0.0,
+            stats.jobCount > 0 ? stats.queueWaitSeconds / float(stats.jobCount) : 0.f, stats.idleSeconds);
     }
-    return false;
-}
 
-class CustomAllocator : public ntc::IAllocator
-{
-public:
-    void* Allocate(size_t size) override
+    printf("Batch finished: %d job(s), %d failed, total time %.2f s.\n", jobCount, failedJobCount,
+        SecondsSince(batchStartTime));
+
+    // Job completion order depends on the devices, sort the outputs to make the archive layout reproducible
+    if (g_options.saveArchiveFileName)
     {
-        void* ptr = malloc(size);
-        // printf("Allocating %zu bytes at %p.\n", size, ptr);
-        m_bytesAllocated += size;
-        return ptr;
+        std::sort(output.completedOutputs.begin(), output.completedOutputs.end());
+        if (!SaveTextureSetArchive(context, output.completedOutputs))
+            return false;
     }
 
-    void Deallocate(void* ptr, size_t size) override
+    if (g_options.allocatorStats)
     {
-        if (!ptr)
-            return;
-        // printf("Deallocating %zu bytes at %p.\n", size, ptr);
-        m_bytesAllocated -= size;
-        free(ptr);
+        for (size_t deviceIndex = 1; deviceIndex < deviceCount; ++deviceIndex)
+        {
+            printf("Host memory on CUDA device %d: %s\n", cudaDevices[deviceIndex],
+                PooledAllocator::FormatStats(allocators[deviceIndex].GetStats()).c_str());
+        }
     }
 
-    int64_t GetBytesAllocated() const
+    contexts.clear();
+    for (size_t deviceIndex = 1; deviceIndex < deviceCount; ++deviceIndex)
     {
-        return m_bytesAllocated;
+        if (allocators[deviceIndex].GetBytesAllocated() != 0)
+            fprintf(stderr, "Library leaked %" PRIi64 " bytes on CUDA device %d!\n",
+                allocators[deviceIndex].GetBytesAllocated(), cudaDevices[deviceIndex]);
     }
 
-private:
-    int64_t m_bytesAllocated = 0;
-};
-
+    return failedJobCount == 0 && scanErrorCount == 0;
+}
 
 int main(int argc, const char** argv)
 {
@@ -1713,6 +4769,24 @@ int main(int argc, const char** argv)
             return 1;
     }
 
+    if (g_options.describeJsonPath)
+        return DescribeTextureSetFilesAsJson(g_options.describeJsonPath) ? 0 : 1;
+
+    if (g_options.telemetryFileName)
+    {
+        ntc::VersionInfo const libVersion = ntc::GetLibraryVersion();
+        ntc::VersionInfo const sdkVersion = GetNtcSdkVersion();
+        char libVersionString[64];
+        snprintf(libVersionString, sizeof(libVersionString), "%d.%d.%d", libVersion.major, libVersion.minor,
+            libVersion.point);
+
+        Json::Value fields(Json::objectValue);
+        fields["libraryVersion"] = libVersionString;
+        fields["toolsVersion"] = std::string(sdkVersion.branch) + "-" + sdkVersion.commitHash;
+        if (!OpenTelemetry(g_options.telemetryFileName, std::move(fields)))
+            return 1;
+    }
+
     bool const useGapi = g_options.useVulkan || g_options.useDX12;
 
     bool const graphicsDecompressMode = g_options.inputType == ToolInputType::CompressedTextureSet && useGapi 
@@ -1721,7 +4795,9 @@ int main(int argc, const char** argv)
     bool const describeMode = g_options.inputType == ToolInputType::CompressedTextureSet && g_options.describe
         && !g_options.decompress && !g_options.saveCompressedFileName;
 
-    bool const useCuda = !describeMode && !graphicsDecompressMode;
+    bool const packArchiveMode = g_options.packArchivePath != nullptr;
+
+    bool const useCuda = !describeMode && !graphicsDecompressMode && !packArchiveMode;
 
     cudaDeviceProp cudaDeviceProperties{};
     if (g_options.cudaDevice >= 0 && useCuda)
@@ -1739,7 +4815,15 @@ int main(int argc, const char** argv)
         }
     }
 
-    CustomAllocator customAllocator;
+    if (g_options.cacheDirectory)
+    {
+        uint64_t const cacheSizeLimit = uint64_t(g_options.cacheSizeLimitMB) << 20;
+        g_compressionCache = std::make_unique<CompressionCache>(g_options.cacheDirectory, cacheSizeLimit);
+        if (!g_compressionCache->Init())
+            return 1;
+    }
+
+    PooledAllocator allocator;
 
     typedef std::unique_ptr<donut::app::DeviceManager, void(*)(donut::app::DeviceManager*)> DeviceManagerPtr;
     DeviceManagerPtr deviceManager = DeviceManagerPtr(nullptr, nullptr);
@@ -1816,6 +4900,29 @@ int main(int argc, const char** argv)
             }
         }
 
+        if (g_options.cpuAdapter)
+        {
+            deviceParams.adapterIndex = -1;
+            for (int adapterIndex = 0; adapterIndex < int(adapters.size()); ++adapterIndex)
+            {
+                if (IsSoftwareAdapterName(adapters[adapterIndex].name))
+                {
+                    deviceParams.adapterIndex = adapterIndex;
+                    break;
+                }
+            }
+
+            if (deviceParams.adapterIndex < 0)
+            {
+                fprintf(stderr, "Cannot find a software %s adapter. Install WARP for D3D12, or Mesa llvmpipe or "
+                    "SwiftShader for Vulkan.\n", nvrhi::utils::GraphicsAPIToString(graphicsApi));
+                return 1;
+            }
+
+            printf("Using software adapter %d: %s\n", deviceParams.adapterIndex,
+                adapters[deviceParams.adapterIndex].name.c_str());
+        }
+
         if (!deviceManager->CreateHeadlessDevice(deviceParams))
         {
             fprintf(stderr, "Cannot initialize a %s device.\n", nvrhi::utils::GraphicsAPIToString(graphicsApi));
@@ -1823,6 +4930,7 @@ int main(int argc, const char** argv)
         }
 
         device = deviceManager->GetDevice();
+        g_imageProcessingDevice = device;
         commandList = device->createCommandList();
         timerQuery = device->createTimerQuery();
     }
@@ -1830,7 +4938,7 @@ int main(int argc, const char** argv)
 
     // Initialize the NTC context with or without the graphics device
     ntc::ContextParameters contextParams;
-    contextParams.pAllocator = &customAllocator;
+    contextParams.pAllocator = &allocator;
     contextParams.cudaDevice = useCuda ? g_options.cudaDevice : ntc::DisableCudaDevice;
     
     if (deviceManager)
@@ -1872,6 +4980,14 @@ int main(int argc, const char** argv)
     {
         printf("Using %s with CUDA API. Compute capability %d.%d\n",
             cudaDeviceProperties.name, cudaDeviceProperties.major, cudaDeviceProperties.minor);
+
+        Json::Value event(Json::objectValue);
+        event["name"] = cudaDeviceProperties.name;
+        event["api"] = "CUDA";
+        event["cudaDevice"] = g_options.cudaDevice;
+        event["computeCapability"] = std::to_string(cudaDeviceProperties.major) + "." +
+            std::to_string(cudaDeviceProperties.minor);
+        EmitTelemetryEvent("device", std::move(event));
     }
 
     if (useGapi)
@@ -1883,23 +4999,39 @@ int main(int argc, const char** argv)
             contextParams.graphicsDeviceSupportsFloat16 ? 'Y' : 'N',
             context->IsCooperativeVectorInt8Supported() ? 'Y' : 'N',
             context->IsCooperativeVectorFP8Supported() ? 'Y' : 'N');
+
+        Json::Value event(Json::objectValue);
+        event["name"] = deviceManager->GetRendererString();
+        event["api"] = nvrhi::utils::GraphicsAPIToString(deviceManager->GetGraphicsAPI());
+        Json::Value& features = event["features"] = Json::Value(Json::arrayValue);
+        if (contextParams.graphicsDeviceSupportsDP4a)
+            features.append("DP4a");
+        if (contextParams.graphicsDeviceSupportsFloat16)
+            features.append("FP16");
+        if (context->IsCooperativeVectorInt8Supported())
+            features.append("CoopVecInt8");
+        if (context->IsCooperativeVectorFP8Supported())
+            features.append("CoopVecFP8");
+        EmitTelemetryEvent("device", std::move(event));
     }
 
     if (graphicsDecompressMode || describeMode)
     {
         assert(g_options.loadCompressedFileName); // parseCommandLine checks this condition, but let's be sure...
 
-        ntc::FileStreamWrapper inputFile(context);
-        ntcStatus = context->OpenFile(g_options.loadCompressedFileName, false, inputFile.ptr());
-        if (ntcStatus != ntc::Status::Ok)
+        // Map the file so that the latents are uploaded straight from the file mapping,
+        // or inflate the pages as they are read if the file is page-compressed
+        std::string openError;
+        std::unique_ptr<ntc::IStream> inputFile = OpenTextureSetFile(g_options.loadCompressedFileName, &openError);
+        if (!inputFile)
         {
-            fprintf(stderr, "Failed to open input file '%s', code = %s: %s\n", g_options.loadCompressedFileName,
-                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            fprintf(stderr, "Failed to open input file '%s': %s\n", g_options.loadCompressedFileName,
+                openError.c_str());
             return 1;
         }
 
         ntc::TextureSetMetadataWrapper metadata(context);
-        ntcStatus = context->CreateTextureSetMetadataFromStream(inputFile, metadata.ptr());
+        ntcStatus = context->CreateTextureSetMetadataFromStream(inputFile.get(), metadata.ptr());
         if (ntcStatus != ntc::Status::Ok)
         {
             fprintf(stderr, "Failed to load texture set metadata from '%s', code = %s: %s\n", g_options.loadCompressedFileName,
@@ -1917,10 +5049,34 @@ int main(int argc, const char** argv)
         if (describeMode)
             return 0;
 
-        int const mipLevels = g_options.saveMips ? metadata->GetDesc().mips : 1;
+        // Software adapters don't support CoopVec, so texture sets without Int8 weights, which only have the FP8
+        // weights for CoopVec, cannot be decompressed there. Say so instead of failing in the decompression pass.
+        if (g_options.cpuAdapter && metadata->GetBestSupportedWeightType() == ntc::InferenceWeightType::Unknown)
+        {
+            fprintf(stderr, "The inference weights of '%s' are not supported on the software adapter %s: "
+                "Int8 [%c], FP8 [%c], CoopVec-FP8 [%c]. Use a GPU, or a texture set compressed with Int8 weights.\n",
+                g_options.loadCompressedFileName, deviceManager->GetRendererString(),
+                metadata->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericInt8) ? 'Y' : 'N',
+                metadata->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericFP8) ? 'Y' : 'N',
+                context->IsCooperativeVectorFP8Supported() ? 'Y' : 'N');
+            return 1;
+        }
+
+        if (g_options.benchmarkJsonFileName)
+        {
+            DecompressionBenchmarkSettings benchmarkSettings;
+            benchmarkSettings.warmupIterations = g_options.benchmarkWarmup;
+            benchmarkSettings.iterations = g_options.benchmarkIterations;
+            return RunDecompressionBenchmark(contextParams, device, commandList, timerQuery,
+                g_options.loadCompressedFileName, g_options.benchmarkJsonFileName, benchmarkSettings) ? 0 : 1;
+        }
+
+        GraphicsDecompressionRegion region;
+        if (!GetGraphicsDecompressionRegion(metadata, region))
+            return 1;
 
         GraphicsResourcesForTextureSet graphicsResources;
-        if (!CreateGraphicsResourcesFromMetadata(context, device, metadata, mipLevels, false, graphicsResources))
+        if (!CreateGraphicsResourcesForRegion(context, device, metadata, region, graphicsResources))
             return 1;
 
         GraphicsDecompressionPass gdp(device, NTC_MAX_CHANNELS * NTC_MAX_MIPS);
@@ -1933,13 +5089,16 @@ int main(int argc, const char** argv)
         
         std::vector<float> iterationTimes;
         iterationTimes.resize(g_options.benchmarkIterations);
+        std::vector<float> iterationWallTimes;
+        iterationWallTimes.resize(g_options.benchmarkIterations);
 
         for (int iteration = 0; iteration < g_options.benchmarkIterations; ++iteration)
         {
+            auto const iterationStartTime = std::chrono::steady_clock::now();
             commandList->open();
 
             bool const decompressSucceeded = DecompressTextureSetWithGraphicsAPI(commandList, timerQuery, gdp,
-                    context, metadata, iteration == 0 ? inputFile.Get() : nullptr, mipLevels, graphicsResources);
+                    context, metadata, iteration == 0 ? inputFile.get() : nullptr, region, graphicsResources);
 
             commandList->close();
 
@@ -1948,6 +5107,7 @@ int main(int argc, const char** argv)
 
             device->executeCommandList(commandList);
             device->waitForIdle();
+            iterationWallTimes[iteration] = SecondsSince(iterationStartTime);
             device->runGarbageCollection();
 
             float const decompressTimeSeconds = device->getTimerQueryTime(timerQuery);
@@ -1961,10 +5121,49 @@ int main(int argc, const char** argv)
                 medianDecompressionTime * 1e3f);
         }
 
+        {
+            Json::Value event(Json::objectValue);
+            event["api"] = nvrhi::utils::GraphicsAPIToString(device->getGraphicsAPI());
+            event["iterations"] = g_options.benchmarkIterations;
+            event["gpuMilliseconds"] = Median(iterationTimes) * 1e3f;
+            event["wallMilliseconds"] = Median(iterationWallTimes) * 1e3f;
+            EmitTelemetryEvent("decompression", std::move(event));
+        }
+
+        // Report the time per decoded megapixel for sizing the machines, including the host side with --cpuAdapter
+        // where the device timer doesn't cover the work that the driver does on other threads.
+        // The wall clock time of the first iteration includes the latent upload.
+        {
+            nvrhi::TextureDesc outputDesc;
+            for (GraphicsResourcesForTexture const& textureResources : graphicsResources.perTexture)
+            {
+                if (textureResources.color)
+                {
+                    outputDesc = textureResources.color->getDesc();
+                    break;
+                }
+            }
+
+            double megapixels = 0;
+            for (uint32_t mipLevel = 0; mipLevel < outputDesc.mipLevels; ++mipLevel)
+            {
+                megapixels += double(std::max(outputDesc.width >> mipLevel, 1u)) *
+                    double(std::max(outputDesc.height >> mipLevel, 1u)) * 1e-6;
+            }
+
+            if (megapixels > 0)
+            {
+                printf("Decompression rate for %.2f MPix: %.3f ms/MPix device time, %.3f ms/MPix wall clock time\n",
+                    megapixels, Median(iterationTimes) * 1e3 / megapixels, Median(iterationWallTimes) * 1e3 / megapixels);
+            }
+        }
+
         bool const anyBCTextures = AnyBlockCompressedTextures(metadata);
 
         if (g_options.saveImagesPath)
         {
+            auto const saveStartTime = std::chrono::steady_clock::now();
+
             if (anyBCTextures)
             {
                 if (!BlockCompressAndSaveGraphicsTextures(context, metadata, device, commandList, timerQuery,
@@ -1973,36 +5172,68 @@ int main(int argc, const char** argv)
             }
 
             if (!SaveGraphicsStagingTextures(metadata, device, g_options.saveImagesPath, g_options.imageFormat,
-                g_options.saveMips, graphicsResources))
+                region.mipCount > 1, region.firstMip, g_options.pngCompressionLevel, graphicsResources))
                 return 1;
+
+            printf("Image export time: %.3f ms\n", SecondsSince(saveStartTime) * 1e3f);
+        }
+    }
+    else if (g_options.batchFileName)
+    {
+        if (!RunBatch(context, device, commandList, timerQuery, &allocator))
+            return 1;
+    }
+    else if (packArchiveMode)
+    {
+        std::vector<std::string> fileNames;
+        for (fs::directory_entry const& entry : fs::recursive_directory_iterator(g_options.packArchivePath))
+        {
+            std::string extension = entry.path().extension().string();
+            LowercaseString(extension);
+            if (entry.is_regular_file() && extension == ".ntc")
+                fileNames.push_back(entry.path().generic_string());
         }
+        std::sort(fileNames.begin(), fileNames.end());
+
+        if (!SaveTextureSetArchive(context, fileNames))
+            return 1;
     }
     else
     {
         ntc::TextureSetWrapper textureSet(context);
+        
+        // Keep the manifest around for the parallel PSNR search that may need to load more instances
+        Manifest manifest;
+        TextureSetSource source;
+        source.cudaDevice = g_options.cudaDevice;
+        MaterialAtlasLayout atlasLayout;
+        AtlasImageDirectory atlasImageDirectory;
+        auto const loadStartTime = std::chrono::steady_clock::now();
 
         switch (g_options.inputType)
         {
             case ToolInputType::Directory: {
                 assert(g_options.loadImagesPath);
 
-                Manifest manifest;
-                GenerateManifestFromDirectory(g_options.loadImagesPath, g_options.loadMips, manifest);
-                *textureSet.ptr() = LoadImages(context, manifest, true);
+                GenerateManifestFromDirectory(g_options.loadImagesPath, g_options.loadMips, manifest,
+                    /* includeTextureContainers = */ true);
+                source.manifest = &manifest;
+                source.manifestIsGenerated = true;
+                *textureSet.ptr() = LoadImagesOrCachedResult(context, manifest, true, source);
                 break;
             }
             case ToolInputType::Images: {
                 assert(!g_options.loadImagesList.empty());
 
-                Manifest manifest;
                 GenerateManifestFromFileList(g_options.loadImagesList, manifest);
-                *textureSet.ptr() = LoadImages(context, manifest, true);
+                source.manifest = &manifest;
+                source.manifestIsGenerated = true;
+                *textureSet.ptr() = LoadImagesOrCachedResult(context, manifest, true, source);
                 break;
             }
             case ToolInputType::Manifest: {
                 assert(g_options.loadManifestFileName);
 
-                Manifest manifest;
                 std::string manifestError;
                 if (!ReadManifestFromFile(g_options.loadManifestFileName, manifest, manifestError))
                 {
@@ -2010,13 +5241,40 @@ int main(int argc, const char** argv)
                     return 1;
                 }
 
-                *textureSet.ptr() = LoadImages(context, manifest, false);
+                source.manifest = &manifest;
+                *textureSet.ptr() = LoadImagesOrCachedResult(context, manifest, false, source);
                 break;
             }
             case ToolInputType::CompressedTextureSet: {
                 assert(g_options.loadCompressedFileName);
 
-                *textureSet.ptr() = LoadCompressedTextureSet(context);
+                *textureSet.ptr() = LoadCompressedTextureSet(context, g_options.loadCompressedFileName);
+                break;
+            }
+            case ToolInputType::MaterialAtlas: {
+                std::error_code errorCode;
+                atlasImageDirectory.path = fs::temp_directory_path(errorCode) / ("ntc-atlas-" +
+                    std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+                if (!fs::create_directories(atlasImageDirectory.path, errorCode))
+                {
+                    fprintf(stderr, "Failed to create the atlas image directory '%s'.\n",
+                        atlasImageDirectory.path.generic_string().c_str());
+                    return 1;
+                }
+
+                std::vector<Manifest> sourceManifests;
+                if (!BuildMaterialAtlas(atlasImageDirectory.path, manifest, source.manifestIsGenerated, atlasLayout,
+                    sourceManifests))
+                    return 1;
+
+                if (g_compressionCache)
+                {
+                    source.cacheKey = GetMaterialAtlasCacheKey(sourceManifests, atlasLayout,
+                        source.manifestIsGenerated);
+                }
+
+                source.manifest = &manifest;
+                *textureSet.ptr() = LoadImagesOrCachedResult(context, manifest, source.manifestIsGenerated, source);
                 break;
             }
             default:
@@ -2026,124 +5284,54 @@ int main(int argc, const char** argv)
 
         if (!textureSet)
             return 1;
-
-        OverrideBcFormats(textureSet);
-
-        if (g_options.describe)
-        {
-            DescribeTextureSet(textureSet);
-        }
-
-        textureSet->SetExperimentalKnob(g_options.experimentalKnob);
-
-        bool const anyBCTextures = AnyBlockCompressedTextures(textureSet);
-
-        if (g_options.matchBcPsnr && !anyBCTextures)
-        {
-            fprintf(stderr, "--matchBcPsnr requires that at least one texture in the set is compressed to a BCn format.\n");
-            return 1;
-        }
+        EmitStageEvent("load", SecondsSince(loadStartTime));
 
         GraphicsResourcesForTextureSet graphicsResources;
-        if (g_options.matchBcPsnr || g_options.optimizeBC || g_options.saveImagesPath && anyBCTextures)
-        {
-            // Verify that we have a graphics device - cannot do that in ProcessCommandLine
-            // because we don't know if there are any BCn textures at that point...
-            if (!device)
-            {
-                fprintf(stderr, "BCn encoding requires either --vk or --dx12 (where available).\n"
-                    "To save images in a non-BC format, use --bcFormat none.\n");
-                return 1;
-            }
-
-            int const mipLevels = g_options.saveImagesPath && g_options.saveMips ? textureSet->GetDesc().mips : 1;
-
-            if (!CreateGraphicsResourcesFromMetadata(context, device, textureSet,
-                mipLevels, /* enableCudaSharing = */ true, graphicsResources))
-                return 1;
-        }
-
-        if (g_options.matchBcPsnr)
-        {
-            if (!CopyTextureSetDataIntoGraphicsTextures(context, textureSet, ntc::TextureDataPage::Reference,
-                /* allMipLevels = */ false, /* onlyBlockCompressedFormats = */ true, graphicsResources))
-                return 1;
-
-            if (!ComputePsnrForBlockCompressedTextureSet(context, textureSet, device,
-                commandList, graphicsResources, g_options.targetPsnr))
-                return 1;
-
-            // Apply the user-specified offset and limits
-            g_options.targetPsnr = std::min(g_options.maxBcPsnr, std::max(g_options.minBcPsnr,
-                g_options.targetPsnr + g_options.bcPsnrOffset));
+        if (!ProcessTextureSet(context, device, commandList, timerQuery, textureSet, &source,
+            g_options.saveCompressedFileName, graphicsResources, nullptr))
+            return 1;
 
-            printf("Selected target PSNR: %.2f dB.\n", g_options.targetPsnr);
-        }
-        
-        if (g_options.compress)
+        if (g_options.inputType == ToolInputType::MaterialAtlas)
         {
-            if (std::isnan(g_options.targetPsnr))
-            {
-                if (!CompressTextureSet(context, textureSet, nullptr))
-                    return 1;
-            }
-            else
-            {
-                if (!CompressTextureSetWithTargetPSNR(context, textureSet))
-                    return 1;
-            }
-        }
+            UpdateMaterialAtlasMips(atlasLayout, textureSet->GetDesc().mips);
+            atlasLayout.textureSetFileName = fs::path(g_options.saveCompressedFileName).filename().generic_string();
 
-        if (g_options.decompress)
-        {
-            if (g_options.compress && textureSet->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericFP8))
+            std::string const layoutFileName = GetMaterialAtlasLayoutFileName(g_options.saveCompressedFileName);
+            std::string layoutError;
+            if (!WriteMaterialAtlasLayout(layoutFileName.c_str(), atlasLayout, layoutError))
             {
-                if (!DecompressTextureSet(context, textureSet, /* useFP8Weights = */ true))
-                    return 1;
-            }
-
-            if (!DecompressTextureSet(context, textureSet, /* useFP8Weights = */ false))
-                return 1;
-        }
-
-        if (g_options.optimizeBC || g_options.saveImagesPath && anyBCTextures)
-        {
-            if (!CopyTextureSetDataIntoGraphicsTextures(context, textureSet, ntc::TextureDataPage::Output,
-                /* allMipLevels = */ true, /* onlyBlockCompressedFormats = */ true, graphicsResources))
+                fprintf(stderr, "%s\n", layoutError.c_str());
                 return 1;
+            }
+            printf("Saved the atlas layout into '%s'.\n", layoutFileName.c_str());
         }
+    }
 
-        if (g_options.optimizeBC)
-        {
-            if (!OptimizeBlockCompression(context, textureSet, device,
-                commandList, g_options.bcPsnrThreshold, graphicsResources))
-                return 1;
-        }
+    if (g_compressionCache)
+    {
+        printf("Compression cache: %d hit(s), %d miss(es).\n", g_compressionCache->GetHitCount(),
+            g_compressionCache->GetMissCount());
+    }
 
-        if (g_options.saveImagesPath)
-        {
-            if (anyBCTextures)
-            {
-                if (!BlockCompressAndSaveGraphicsTextures(context, textureSet, device, commandList, timerQuery,
-                    g_options.saveImagesPath, g_options.bcQuality, g_options.benchmarkIterations, graphicsResources))
-                    return 1;
-            }
-                
-            if (!SaveImagesFromTextureSet(context, textureSet))
-                return 1;
-        }
+    if (g_options.allocatorStats)
+        printf("Host memory: %s\n", PooledAllocator::FormatStats(allocator.GetStats()).c_str());
 
-        if (g_options.saveCompressedFileName)
-        {
-            if (!SaveCompressedTextureSet(context, textureSet))
-                return 1;
-        }
+    if (IsTelemetryEnabled())
+    {
+        PooledAllocatorStats const hostStats = allocator.GetStats();
+        Json::Value event(Json::objectValue);
+        event["hostPeakBytes"] = Json::Int64(hostStats.peakBytesAllocated);
+        event["hostLiveBytes"] = Json::Int64(hostStats.bytesAllocated);
+        event["hostAllocations"] = Json::UInt64(hostStats.totalAllocations);
+        EmitTelemetryEvent("memory", std::move(event));
+        EmitTelemetryEvent("end");
     }
+    CloseTelemetry();
 
     context.Release();
 
-    if (customAllocator.GetBytesAllocated() != 0)
-        fprintf(stderr, "Library leaked %" PRIi64 " bytes!\n", customAllocator.GetBytesAllocated());
+    if (allocator.GetBytesAllocated() != 0)
+        fprintf(stderr, "Library leaked %" PRIi64 " bytes!\n", allocator.GetBytesAllocated());
 
     return 0;
 }
\ No newline at end of file
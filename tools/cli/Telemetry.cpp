@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "Telemetry.h"
+#include <json/writer.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+static std::mutex g_telemetryMutex;
+static FILE* g_telemetryFile = nullptr;
+static bool g_telemetryOwnsFile = false;
+static std::chrono::steady_clock::time_point g_telemetryStartTime;
+
+bool OpenTelemetry(char const* fileName, Json::Value startFields)
+{
+    {
+        std::lock_guard lockGuard(g_telemetryMutex);
+
+        if (strcmp(fileName, "-") == 0)
+        {
+            g_telemetryFile = stdout;
+            g_telemetryOwnsFile = false;
+        }
+        else
+        {
+            g_telemetryFile = fopen(fileName, "w");
+            if (!g_telemetryFile)
+            {
+                fprintf(stderr, "Cannot open telemetry file '%s': %s\n", fileName, strerror(errno));
+                return false;
+            }
+            g_telemetryOwnsFile = true;
+        }
+
+        g_telemetryStartTime = std::chrono::steady_clock::now();
+    }
+
+    startFields["version"] = c_TelemetryVersion;
+    EmitTelemetryEvent("start", std::move(startFields));
+    return true;
+}
+
+void CloseTelemetry()
+{
+    std::lock_guard lockGuard(g_telemetryMutex);
+    if (g_telemetryOwnsFile && g_telemetryFile)
+        fclose(g_telemetryFile);
+    g_telemetryFile = nullptr;
+    g_telemetryOwnsFile = false;
+}
+
+bool IsTelemetryEnabled()
+{
+    std::lock_guard lockGuard(g_telemetryMutex);
+    return g_telemetryFile != nullptr;
+}
+
+void EmitTelemetryEvent(char const* eventName, Json::Value fields)
+{
+    std::lock_guard lockGuard(g_telemetryMutex);
+    if (!g_telemetryFile)
+        return;
+
+    fields["event"] = eventName;
+    fields["time"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - g_telemetryStartTime).count();
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    std::string const line = Json::writeString(builder, fields);
+
+    fprintf(g_telemetryFile, "%s\n", line.c_str());
+    fflush(g_telemetryFile);
+}
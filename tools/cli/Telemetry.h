@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <json/value.h>
+
+// Version of the telemetry stream format. New events and fields can be added without changing the version,
+// it is only incremented when existing events or fields are removed or change their meaning.
+constexpr int c_TelemetryVersion = 1;
+
+// Starts writing telemetry events into the file, or into stdout if 'fileName' is "-".
+// On stdout, the events can share a line with the regular output that other threads print, so the consumers
+// that parse the events should use a file.
+// The first event is 'start' with the stream version and 'startFields'.
+bool OpenTelemetry(char const* fileName, Json::Value startFields = Json::Value(Json::objectValue));
+
+void CloseTelemetry();
+
+bool IsTelemetryEnabled();
+
+// Writes one event as a single line of JSON and flushes the output, so that a consumer can process the events
+// while the tool is running. The 'event' field is set to 'eventName', and the 'time' field is set to the number
+// of seconds since OpenTelemetry. Does nothing if telemetry is not enabled. Can be called from any thread.
+void EmitTelemetryEvent(char const* eventName, Json::Value fields = Json::Value(Json::objectValue));
@@ -14,6 +14,9 @@
 #include <lodepng.h>
 #include <taskflow/taskflow.hpp>
 #include <algorithm>
+#include <condition_variable>
+#include <cstdarg>
+#include <mutex>
 #include <stb_image_write.h>
 #include <tinyexr.h>
 #include <ntc-utils/Manifest.h>
@@ -77,7 +80,32 @@ bool WriteDdsHeader(ntc::IStream* ddsFile, int width, int height, int mipLevels,
     return success;
 }
 
-bool SavePNG(uint8_t* data, int mipWidth, int mipHeight, int numChannels, bool is16Bit, char const* fileName)
+struct PngCompressionLevel
+{
+    unsigned btype;         // 0 = stored, 2 = dynamic Huffman
+    unsigned windowSize;
+    unsigned niceMatch;
+    unsigned lazyMatching;
+    LodePNGFilterStrategy filterStrategy;
+};
+
+// LodePNG has no compression level setting, so map the levels to its deflate parameters.
+// Level 4 matches the settings used before the levels were introduced.
+static const PngCompressionLevel c_PngCompressionLevels[] = {
+    { 0,     1,   0, 0, LFS_ZERO },
+    { 2,    64,   8, 0, LFS_ZERO },
+    { 2,   128,  16, 0, LFS_MINSUM },
+    { 2,   256,  32, 0, LFS_MINSUM },
+    { 2,   512, 128, 1, LFS_MINSUM },
+    { 2,  1024, 128, 1, LFS_MINSUM },
+    { 2,  2048, 128, 1, LFS_MINSUM },
+    { 2,  4096, 258, 1, LFS_MINSUM },
+    { 2,  8192, 258, 1, LFS_MINSUM },
+    { 2, 32768, 258, 1, LFS_MINSUM },
+};
+
+bool SavePNG(uint8_t* data, int mipWidth, int mipHeight, int numChannels, bool is16Bit, char const* fileName,
+    int compressionLevel)
 {
     // Use LodePNG to save PNG's instead of STB.
     // It can write 16-bit-per-channel images and extended metadata.
@@ -107,7 +135,15 @@ bool SavePNG(uint8_t* data, int mipWidth, int mipHeight, int numChannels, bool i
     state.info_raw.bitdepth = bitDepth;
     state.info_png.color.colortype = colorType;
     state.info_png.color.bitdepth = bitDepth;
-    state.encoder.zlibsettings.windowsize = 512; // slightly worse compression but much faster, default = 2048
+
+    PngCompressionLevel const& level = c_PngCompressionLevels[std::clamp(compressionLevel,
+        c_MinPngCompressionLevel, c_MaxPngCompressionLevel)];
+    state.encoder.zlibsettings.btype = level.btype;
+    state.encoder.zlibsettings.use_lz77 = level.btype != 0;
+    state.encoder.zlibsettings.windowsize = level.windowSize;
+    state.encoder.zlibsettings.nicematch = level.niceMatch;
+    state.encoder.zlibsettings.lazymatching = level.lazyMatching;
+    state.encoder.filter_strategy = level.filterStrategy;
 
     // Encode the PNG
     unsigned char* pngData = nullptr;
@@ -137,14 +173,70 @@ bool SavePNG(uint8_t* data, int mipWidth, int mipHeight, int numChannels, bool i
     return success;
 }
 
+static thread_local std::mutex* t_OutputMutex = nullptr;
+
+void SetThreadOutputMutex(std::mutex* mutex)
+{
+    t_OutputMutex = mutex;
+}
+
+std::mutex* GetThreadOutputMutex()
+{
+    return t_OutputMutex;
+}
+
+void PrintOutput(char const* format, ...)
+{
+    std::unique_lock<std::mutex> lock;
+    if (t_OutputMutex)
+        lock = std::unique_lock(*t_OutputMutex);
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+
+    // Flush while the lock is held, otherwise the buffered output of several workers is written together
+    if (t_OutputMutex)
+        fflush(stdout);
+}
+
+// Tasks are tracked per calling thread, so that multiple threads (e.g. batch workers for different devices)
+// can share the executor and only wait for the tasks that they started themselves.
+struct PendingTasks
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    int count = 0;
+};
+
+static thread_local PendingTasks t_PendingTasks;
+
 void StartAsyncTask(std::function<void()> function)
 {
-    g_Executor.async(function);
+    PendingTasks* pendingTasks = &t_PendingTasks;
+    {
+        std::lock_guard lockGuard(pendingTasks->mutex);
+        ++pendingTasks->count;
+    }
+
+    g_Executor.async([pendingTasks, function, outputMutex = t_OutputMutex]()
+    {
+        // The executor threads run tasks for all workers, so the mutex is set for every task
+        t_OutputMutex = outputMutex;
+        function();
+        t_OutputMutex = nullptr;
+
+        std::lock_guard lockGuard(pendingTasks->mutex);
+        --pendingTasks->count;
+        pendingTasks->condition.notify_all();
+    });
 }
 
 void WaitForAllTasks()
 {
-    g_Executor.wait_for_all();
+    std::unique_lock lock(t_PendingTasks.mutex);
+    t_PendingTasks.condition.wait(lock, []() { return t_PendingTasks.count == 0; });
 }
 
 std::optional<ImageContainer> ParseImageContainer(char const* container)
@@ -213,7 +305,8 @@ char const* GetContainerExtension(ImageContainer container)
     }
 }
 
-bool SaveImageToContainer(ImageContainer container, void const* data, int width, int height, int channels, char const* fileName)
+bool SaveImageToContainer(ImageContainer container, void const* data, int width, int height, int channels, char const* fileName,
+    int pngCompressionLevel)
 {
     switch(container)
     {
@@ -225,9 +318,9 @@ bool SaveImageToContainer(ImageContainer container, void const* data, int width,
     case ImageContainer::JPG:
         return !!stbi_write_jpg(fileName, width, height, channels, data, /* quality = */ 95);
     case ImageContainer::PNG:
-        return SavePNG((uint8_t*)data, width, height, channels, false, fileName);
+        return SavePNG((uint8_t*)data, width, height, channels, false, fileName, pngCompressionLevel);
     case ImageContainer::PNG16:
-        return SavePNG((uint8_t*)data, width, height, channels, true, fileName);
+        return SavePNG((uint8_t*)data, width, height, channels, true, fileName, pngCompressionLevel);
     case ImageContainer::TGA:
         return !!stbi_write_tga(fileName, width, height, channels, data);
     case ImageContainer::EXR:
@@ -15,6 +15,7 @@
 #include <nvrhi/nvrhi.h>
 #include <libntc/ntc.h>
 #include <functional>
+#include <mutex>
 #include <optional>
 #include <ntc-utils/DDSHeader.h>
 
@@ -41,7 +42,20 @@ float Median(std::vector<float>& items);
 bool WriteDdsHeader(ntc::IStream* ddsFile, int width, int height, int mipLevels,
     BcFormatDefinition const* outputFormatDefinition, ntc::ColorSpace colorSpace);
 
-bool SavePNG(uint8_t* data, int mipWidth, int mipHeight, int numChannels, bool is16Bit, char const* fileName);
+// PNG compression levels, similar to zlib: 0 writes uncompressed data, 9 is the slowest and smallest.
+constexpr int c_MinPngCompressionLevel = 0;
+constexpr int c_MaxPngCompressionLevel = 9;
+constexpr int c_DefaultPngCompressionLevel = 4;
+
+bool SavePNG(uint8_t* data, int mipWidth, int mipHeight, int numChannels, bool is16Bit, char const* fileName,
+    int compressionLevel = c_DefaultPngCompressionLevel);
+
+// Console output of the texture set processing. Batch workers set the mutex of the batch output for their
+// thread, then PrintOutput(...) holds it for every message so that the output of concurrent jobs doesn't mix.
+// The async tasks and the adaptive search threads inherit the mutex of the thread that started them.
+void SetThreadOutputMutex(std::mutex* mutex);
+std::mutex* GetThreadOutputMutex();
+void PrintOutput(char const* format, ...);
 
 void StartAsyncTask(std::function<void()> function);
 
@@ -61,6 +75,7 @@ enum class ImageContainer
 std::optional<ImageContainer> ParseImageContainer(char const* s);
 ntc::ChannelFormat GetContainerChannelFormat(ImageContainer container);
 char const* GetContainerExtension(ImageContainer container);
-bool SaveImageToContainer(ImageContainer container, void const* data, int width, int height, int channels, char const* fileName);
+bool SaveImageToContainer(ImageContainer container, void const* data, int width, int height, int channels, char const* fileName,
+    int pngCompressionLevel = c_DefaultPngCompressionLevel);
 
 std::optional<int> ParseNetworkVersion(char const* version);
\ No newline at end of file
@@ -15,15 +15,20 @@
 #include <donut/engine/CommonRenderPasses.h>
 #include <donut/engine/ShaderFactory.h>
 #include <donut/engine/BindingCache.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <utility>
 
 #define GLFW_INCLUDE_NONE // Do not include any OpenGL headers
 #include <GLFW/glfw3.h>
 
 #if NTC_WITH_DX12
+#include "compiled_shaders/FlatImageView_ErrorAnalysisCS.dxil.h"
 #include "compiled_shaders/FlatImageView_MainPS.dxil.h"
 #endif
 #if NTC_WITH_VULKAN
+#include "compiled_shaders/FlatImageView_ErrorAnalysisCS.spirv.h"
 #include "compiled_shaders/FlatImageView_MainPS.spirv.h"
 #endif
 
@@ -32,6 +37,9 @@ using namespace donut::math;
 
 #include "FlatImageViewConstants.h"
 
+// Number of the highest-error tiles listed in the Error Analysis window
+static constexpr size_t c_WorstTileCount = 8;
+
 FlatImageView::FlatImageView(
     std::shared_ptr<donut::engine::BindingCache> bindingCache,
     std::shared_ptr<donut::engine::CommonRenderPasses> commonPasses,
@@ -64,6 +72,7 @@ bool FlatImageView::Init(nvrhi::IFramebuffer* framebuffer)
         .addItem(nvrhi::BindingLayoutItem::PushConstants(0, sizeof(FlatImageViewConstants)))
         .addItem(nvrhi::BindingLayoutItem::Texture_SRV(0))
         .addItem(nvrhi::BindingLayoutItem::Texture_SRV(1))
+        .addItem(nvrhi::BindingLayoutItem::TypedBuffer_SRV(2))
         .addItem(nvrhi::BindingLayoutItem::TypedBuffer_UAV(0))
         .addItem(nvrhi::BindingLayoutItem::Sampler(0));
 
@@ -111,9 +120,125 @@ bool FlatImageView::Init(nvrhi::IFramebuffer* framebuffer)
     if (!m_pixelStagingBuffer1 || !m_pixelStagingBuffer2)
         return false;
 
+    m_errorAnalysisShader = m_shaderFactory->CreateStaticPlatformShader(DONUT_MAKE_PLATFORM_SHADER(g_FlatImageView_ErrorAnalysisCS),
+        nullptr, nvrhi::ShaderDesc().setShaderType(nvrhi::ShaderType::Compute).setEntryName("ErrorAnalysisCS"));
+
+    if (!m_errorAnalysisShader)
+        return false;
+
+    auto errorAnalysisLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .addItem(nvrhi::BindingLayoutItem::PushConstants(0, sizeof(FlatImageViewConstants)))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(0))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(1))
+        .addItem(nvrhi::BindingLayoutItem::TypedBuffer_UAV(1))
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_UAV(2));
+
+    m_errorAnalysisBindingLayout = m_device->createBindingLayout(errorAnalysisLayoutDesc);
+
+    auto errorAnalysisPipelineDesc = nvrhi::ComputePipelineDesc()
+        .setComputeShader(m_errorAnalysisShader)
+        .addBindingLayout(m_errorAnalysisBindingLayout);
+
+    m_errorAnalysisPipeline = m_device->createComputePipeline(errorAnalysisPipelineDesc);
+
+    if (!m_errorAnalysisPipeline)
+        return false;
+
+    auto histogramBufferDesc = nvrhi::BufferDesc()
+        .setDebugName("Error Histogram")
+        .setByteSize(ERROR_HISTOGRAM_BINS * sizeof(uint32_t))
+        .setCanHaveRawViews(true)
+        .setCanHaveUAVs(true)
+        .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+        .setKeepInitialState(true);
+    m_errorHistogramBuffer = m_device->createBuffer(histogramBufferDesc);
+
+    auto histogramStagingBufferDesc = nvrhi::BufferDesc()
+        .setDebugName("Error Histogram Staging")
+        .setByteSize(histogramBufferDesc.byteSize)
+        .setCpuAccess(nvrhi::CpuAccessMode::Read)
+        .setInitialState(nvrhi::ResourceStates::CopyDest)
+        .setKeepInitialState(true);
+    m_errorHistogramStagingBuffer = m_device->createBuffer(histogramStagingBufferDesc);
+
+    if (!m_errorHistogramBuffer || !m_errorHistogramStagingBuffer)
+        return false;
+
+    m_errorAnalysisQuery = m_device->createEventQuery();
+
     return true;
 }
 
+bool FlatImageView::CreateErrorAnalysisBuffers(uint32_t tileCount)
+{
+    uint64_t const byteSize = uint64_t(tileCount) * sizeof(float);
+    if (m_tileErrorBuffer && m_tileErrorBuffer->getDesc().byteSize >= byteSize)
+        return true;
+
+    // The staging buffer may be mapped later for a pass that used the old buffers, drop those results
+    m_errorAnalysisPending = false;
+    m_errorAnalysisRecorded = false;
+    m_errorAnalysisValid = false;
+
+    auto tileErrorBufferDesc = nvrhi::BufferDesc()
+        .setDebugName("Tile Errors")
+        .setByteSize(byteSize)
+        .setFormat(nvrhi::Format::R32_FLOAT)
+        .setCanHaveTypedViews(true)
+        .setCanHaveUAVs(true)
+        .setInitialState(nvrhi::ResourceStates::ShaderResource)
+        .setKeepInitialState(true);
+    m_tileErrorBuffer = m_device->createBuffer(tileErrorBufferDesc);
+
+    auto stagingBufferDesc = nvrhi::BufferDesc()
+        .setDebugName("Tile Errors Staging")
+        .setByteSize(byteSize)
+        .setCpuAccess(nvrhi::CpuAccessMode::Read)
+        .setInitialState(nvrhi::ResourceStates::CopyDest)
+        .setKeepInitialState(true);
+    m_tileErrorStagingBuffer = m_device->createBuffer(stagingBufferDesc);
+
+    return m_tileErrorBuffer && m_tileErrorStagingBuffer;
+}
+
+void FlatImageView::RenderErrorAnalysis(nvrhi::ICommandList* commandList, uint32_t mipLevel, int2 mipSize, int2 tiles)
+{
+    auto textureSubresourceSet = nvrhi::TextureSubresourceSet(mipLevel, 1, 0, 1);
+
+    auto bindingSetDesc = nvrhi::BindingSetDesc()
+        .addItem(nvrhi::BindingSetItem::PushConstants(0, sizeof(FlatImageViewConstants)))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(0, m_leftTexture, nvrhi::Format::UNKNOWN, textureSubresourceSet))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(1, m_rightTexture, nvrhi::Format::UNKNOWN, textureSubresourceSet))
+        .addItem(nvrhi::BindingSetItem::TypedBuffer_UAV(1, m_tileErrorBuffer))
+        .addItem(nvrhi::BindingSetItem::RawBuffer_UAV(2, m_errorHistogramBuffer));
+
+    auto bindingSet = m_bindingCache->GetOrCreateBindingSet(bindingSetDesc, m_errorAnalysisBindingLayout);
+
+    commandList->clearBufferUInt(m_errorHistogramBuffer, 0);
+
+    auto state = nvrhi::ComputeState()
+        .setPipeline(m_errorAnalysisPipeline)
+        .addBindingSet(bindingSet);
+    commandList->setComputeState(state);
+
+    FlatImageViewConstants constants{};
+    constants.channelMask = m_channelMask & ((1 << m_textureChannels) - 1);
+    constants.errorTilesX = tiles.x;
+    commandList->setPushConstants(&constants, sizeof(constants));
+
+    commandList->dispatch(tiles.x, tiles.y);
+
+    commandList->copyBuffer(m_tileErrorStagingBuffer, 0, m_tileErrorBuffer, 0, uint64_t(tiles.x * tiles.y) * sizeof(float));
+    commandList->copyBuffer(m_errorHistogramStagingBuffer, 0, m_errorHistogramBuffer, 0,
+        m_errorHistogramBuffer->getDesc().byteSize);
+
+    m_errorAnalysisRecorded = true;
+    m_errorAnalysisMip = int(mipLevel);
+    m_errorAnalysisMipSize = mipSize;
+    m_errorAnalysisTiles = tiles;
+}
+
 void FlatImageView::Render(nvrhi::ICommandList* commandList, nvrhi::IFramebuffer* framebuffer)
 {
     if (!m_leftTexture)
@@ -123,11 +248,23 @@ void FlatImageView::Render(nvrhi::ICommandList* commandList, nvrhi::IFramebuffer
     uint32_t sourceMip = std::min(uint32_t(m_mipLevel), textureDesc.mipLevels - 1);
 
     auto textureSubresourceSet = nvrhi::TextureSubresourceSet(sourceMip, 1, 0, 1);
+
+    // Size the tile buffer for mip 0 so that it doesn't need to be recreated when switching mips
+    int2 const tilesMip0 = (int2(int(textureDesc.width), int(textureDesc.height)) + ERROR_TILE_SIZE - 1) / ERROR_TILE_SIZE;
+    if (!CreateErrorAnalysisBuffers(uint32_t(tilesMip0.x * tilesMip0.y)))
+        return;
+
+    int2 const mipSize = max(int2(int(textureDesc.width >> sourceMip), int(textureDesc.height >> sourceMip)), int2(1));
+    int2 const tiles = (mipSize + ERROR_TILE_SIZE - 1) / ERROR_TILE_SIZE;
+    bool const heatmapActive = m_displayMode == uint32_t(DisplayMode::ErrorHeatmap) && m_leftTexture != m_rightTexture;
+    if (heatmapActive && !m_errorAnalysisPending && !m_errorAnalysisRecorded)
+        RenderErrorAnalysis(commandList, sourceMip, mipSize, tiles);
     
     auto bindingSetDesc = nvrhi::BindingSetDesc()
         .addItem(nvrhi::BindingSetItem::PushConstants(0, sizeof(FlatImageViewConstants)))
         .addItem(nvrhi::BindingSetItem::Texture_SRV(0, m_leftTexture, nvrhi::Format::UNKNOWN, textureSubresourceSet))
         .addItem(nvrhi::BindingSetItem::Texture_SRV(1, m_rightTexture, nvrhi::Format::UNKNOWN, textureSubresourceSet))
+        .addItem(nvrhi::BindingSetItem::TypedBuffer_SRV(2, m_tileErrorBuffer))
         .addItem(nvrhi::BindingSetItem::TypedBuffer_UAV(0, m_pixelBuffer))
         .addItem(nvrhi::BindingSetItem::Sampler(0, m_commonPasses->m_PointClampSampler));
 
@@ -160,6 +297,9 @@ void FlatImageView::Render(nvrhi::ICommandList* commandList, nvrhi::IFramebuffer
     constants.isSRGB = m_textureSRGB;
     constants.pixelHighlightTopLeft = 0;
     constants.pixelHighlightBottomRight = 0;
+    constants.errorTilesX = tiles.x;
+    constants.heatmapMinPSNR = m_heatmapMinPSNR;
+    constants.heatmapMaxPSNR = std::max(m_heatmapMaxPSNR, m_heatmapMinPSNR + 0.1f);
     if (m_enablePixelInspector)
     {
         dm::ibox2 pickPixelBounds = GetTexelBounds(m_mousePos);
@@ -194,6 +334,63 @@ void FlatImageView::ReadPixel()
     std::swap(m_pixelStagingBuffer1, m_pixelStagingBuffer2);
 }
 
+void FlatImageView::ReadErrorAnalysis()
+{
+    if (m_errorAnalysisRecorded)
+    {
+        m_device->resetEventQuery(m_errorAnalysisQuery);
+        m_device->setEventQuery(m_errorAnalysisQuery, nvrhi::CommandQueue::Graphics);
+        m_errorAnalysisRecorded = false;
+        m_errorAnalysisPending = true;
+        return;
+    }
+
+    if (!m_errorAnalysisPending || !m_device->pollEventQuery(m_errorAnalysisQuery))
+        return;
+
+    m_errorAnalysisPending = false;
+
+    float const* tileErrors = static_cast<float const*>(m_device->mapBuffer(m_tileErrorStagingBuffer, nvrhi::CpuAccessMode::Read));
+    if (!tileErrors)
+        return;
+
+    // Tiles on the right and bottom edges can be partial, weigh the tile MSE values by their pixel counts
+    double weightedErrorSum = 0.0;
+    std::vector<ErrorTile> tiles;
+    tiles.reserve(m_errorAnalysisTiles.x * m_errorAnalysisTiles.y);
+    for (int y = 0; y < m_errorAnalysisTiles.y; ++y)
+    {
+        for (int x = 0; x < m_errorAnalysisTiles.x; ++x)
+        {
+            float const mse = tileErrors[y * m_errorAnalysisTiles.x + x];
+            int2 const tileSize = min(int2(x + 1, y + 1) * ERROR_TILE_SIZE, m_errorAnalysisMipSize) - int2(x, y) * ERROR_TILE_SIZE;
+            weightedErrorSum += double(mse) * double(tileSize.x * tileSize.y);
+
+            ErrorTile& tile = tiles.emplace_back();
+            tile.position = int2(x, y);
+            tile.psnr = mse > 0.f ? -10.f * log10f(mse) : INFINITY;
+        }
+    }
+    m_device->unmapBuffer(m_tileErrorStagingBuffer);
+
+    size_t const worstTileCount = std::min(tiles.size(), c_WorstTileCount);
+    std::partial_sort(tiles.begin(), tiles.begin() + worstTileCount, tiles.end(),
+        [](ErrorTile const& a, ErrorTile const& b) { return a.psnr < b.psnr; });
+    m_worstTiles.assign(tiles.begin(), tiles.begin() + worstTileCount);
+
+    double const overallMSE = weightedErrorSum / double(m_errorAnalysisMipSize.x * m_errorAnalysisMipSize.y);
+    m_overallPSNR = overallMSE > 0.0 ? float(-10.0 * log10(overallMSE)) : INFINITY;
+
+    uint32_t const* histogram = static_cast<uint32_t const*>(m_device->mapBuffer(m_errorHistogramStagingBuffer, nvrhi::CpuAccessMode::Read));
+    if (!histogram)
+        return;
+
+    m_errorHistogram.assign(histogram, histogram + ERROR_HISTOGRAM_BINS);
+    m_device->unmapBuffer(m_errorHistogramStagingBuffer);
+
+    m_errorAnalysisValid = true;
+}
+
 bool FlatImageView::MousePosUpdate(double xpos, double ypos)
 {
     m_mousePos = int2(int(xpos), int(ypos));
@@ -442,7 +639,8 @@ void FlatImageView::BuildControlDialog()
         { DisplayMode::RightTexture, m_rightImageName.c_str() },
         { DisplayMode::Difference, "Abs Diff" },
         { DisplayMode::RelativeDifference, "Rel Diff" },
-        { DisplayMode::SplitScreen, "Split-Screen" }
+        { DisplayMode::SplitScreen, "Split-Screen" },
+        { DisplayMode::ErrorHeatmap, "Heatmap" }
     };
 
     bool first = true;
@@ -483,6 +681,9 @@ void FlatImageView::BuildControlDialog()
 
     ImGui::End();
 
+    if (m_displayMode == uint32_t(DisplayMode::ErrorHeatmap))
+        BuildErrorAnalysisDialog();
+
     // Pixel Inspector window
 
     ImGui::SetNextWindowPos(
@@ -533,6 +734,59 @@ void FlatImageView::BuildControlDialog()
     ImGui::End();
 }
 
+void FlatImageView::BuildErrorAnalysisDialog()
+{
+    float const fontSize = ImGui::GetFontSize();
+    ImGuiIO const& io = ImGui::GetIO();
+
+    ImGui::SetNextWindowPos(
+        ImVec2(m_viewOrigin.x / io.DisplayFramebufferScale.x + fontSize * 0.6f, fontSize * 2.f),
+        ImGuiCond_FirstUseEver, ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSizeConstraints(ImVec2(fontSize * 16.f, -1.f), ImVec2(fontSize * 16.f, -1.f));
+    if (ImGui::Begin("Error Analysis", nullptr, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        ImGui::PushItemWidth(fontSize * 10.f);
+        ImGui::DragFloatRange2("PSNR Range", &m_heatmapMinPSNR, &m_heatmapMaxPSNR, 0.25f, 0.f, 100.f, "%.1f dB", "%.1f dB");
+        ImGui::PopItemWidth();
+        ImGui::TooltipMarker("Tiles with PSNR at or below the minimum are shown red, at or above the maximum - blue.");
+
+        if (!m_errorAnalysisValid)
+        {
+            ImGui::TextUnformatted("Waiting for results...");
+            ImGui::End();
+            return;
+        }
+
+        ImGui::Text("Mip %d: %dx%d tiles of %dx%d pixels", m_errorAnalysisMip, m_errorAnalysisTiles.x, m_errorAnalysisTiles.y,
+            ERROR_TILE_SIZE, ERROR_TILE_SIZE);
+        ImGui::Text("Overall PSNR: %.2f dB", m_overallPSNR);
+
+        ImGui::PlotHistogram("##Histogram", m_errorHistogram.data(), int(m_errorHistogram.size()), 0, nullptr,
+            0.f, FLT_MAX, ImVec2(fontSize * 15.f, fontSize * 4.f));
+        ImGui::TooltipMarker("Per-pixel PSNR distribution, from 0 dB on the left "
+            "in 2.5 dB bins.\nThe last bin also contains the exact pixels.");
+
+        ImGui::TextUnformatted("Worst tiles:");
+        for (ErrorTile const& tile : m_worstTiles)
+        {
+            char label[64];
+            snprintf(label, sizeof label, "(%d, %d): %.2f dB", tile.position.x, tile.position.y, tile.psnr);
+            if (ImGui::Selectable(label))
+                CenterOnTile(tile);
+        }
+        ImGui::TooltipMarker("Click a tile to center the view on it.");
+    }
+    ImGui::End();
+}
+
+void FlatImageView::CenterOnTile(ErrorTile const& tile)
+{
+    int2 const tileStart = tile.position * ERROR_TILE_SIZE;
+    int2 const tileEnd = min(tileStart + ERROR_TILE_SIZE, m_errorAnalysisMipSize);
+    float2 const uv = float2(tileStart + tileEnd) * 0.5f / float2(m_errorAnalysisMipSize);
+    m_textureCenterOffset = int2(-(uv - 0.5f) * m_textureSize * m_displayScale);
+}
+
 bool FlatImageView::IsRequestingRestore(int& outRunOrdinal, bool& outRightTexture)
 {
     outRunOrdinal = m_requestingRestore;
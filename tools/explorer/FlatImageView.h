@@ -15,6 +15,7 @@
 #include <donut/core/math/math.h>
 #include <nvrhi/nvrhi.h>
 #include <memory>
+#include <vector>
 
 namespace donut::engine
 {
@@ -35,6 +36,9 @@ public:
     bool Init(nvrhi::IFramebuffer* framebuffer);
     void Render(nvrhi::ICommandList* commandList, nvrhi::IFramebuffer* framebuffer);
     void ReadPixel();
+    // Picks up the error analysis results from the GPU when they are ready, never waits.
+    // Call after the command list passed to Render(...) has been executed.
+    void ReadErrorAnalysis();
 
     bool MousePosUpdate(double xpos, double ypos);
     bool MouseButtonUpdate(int button, int action, int mods);
@@ -45,6 +49,7 @@ public:
     void SetTextures(nvrhi::ITexture* leftTexture, nvrhi::ITexture* rightTexture, int channels, bool sRGB);
     void SetViewport(dm::float2 origin, dm::float2 size);
     void SetImageName(bool right, const std::string& name);
+    int GetMipLevel() const { return m_mipLevel; }
 
     void BuildControlDialog();
     bool IsRequestingRestore(int& outRunOrdinal, bool& outRightTexture);
@@ -93,10 +98,41 @@ private:
     nvrhi::BufferHandle m_pixelStagingBuffer1;
     nvrhi::BufferHandle m_pixelStagingBuffer2;
 
+    // The error analysis runs in the heatmap display mode. One pass is in flight at a time, and its results are
+    // read back when the event query signals, so the analysis of large images is spread over several frames.
+    struct ErrorTile
+    {
+        dm::int2 position = 0;
+        float psnr = 0.f;
+    };
+    nvrhi::ShaderHandle m_errorAnalysisShader;
+    nvrhi::BindingLayoutHandle m_errorAnalysisBindingLayout;
+    nvrhi::ComputePipelineHandle m_errorAnalysisPipeline;
+    nvrhi::BufferHandle m_tileErrorBuffer;
+    nvrhi::BufferHandle m_tileErrorStagingBuffer;
+    nvrhi::BufferHandle m_errorHistogramBuffer;
+    nvrhi::BufferHandle m_errorHistogramStagingBuffer;
+    nvrhi::EventQueryHandle m_errorAnalysisQuery;
+    bool m_errorAnalysisRecorded = false;
+    bool m_errorAnalysisPending = false;
+    bool m_errorAnalysisValid = false;
+    int m_errorAnalysisMip = 0;
+    dm::int2 m_errorAnalysisMipSize = 0;
+    dm::int2 m_errorAnalysisTiles = 0;
+    float m_heatmapMinPSNR = 20.f;
+    float m_heatmapMaxPSNR = 50.f;
+    float m_overallPSNR = 0.f;
+    std::vector<float> m_errorHistogram;
+    std::vector<ErrorTile> m_worstTiles;
+
     dm::float2 WindowPosToUv(dm::int2 windowPos) const;
     dm::int2 UvToWindowPos(dm::float2 uv) const;
     dm::ibox2 GetTexelBounds(dm::int2 windowPos) const;
     void FitImageToView();
+    bool CreateErrorAnalysisBuffers(uint32_t tileCount);
+    void RenderErrorAnalysis(nvrhi::ICommandList* commandList, uint32_t mipLevel, dm::int2 mipSize, dm::int2 tiles);
+    void BuildErrorAnalysisDialog();
+    void CenterOnTile(ErrorTile const& tile);
 
     // Zoom in or out, maintaining the same location on the image that stable point (e.g. mouse cursor) is at
     void SetDisplayScaleStable(float newScale, dm::int2 stablePoint);
@@ -22,7 +22,10 @@ VK_PUSH_CONSTANT ConstantBuffer<FlatImageViewConstants> g_Const : register(b0);
 
 Texture2D t_LeftInput : register(t0);
 Texture2D t_RightInput : register(t1);
+Buffer<float> t_TileErrors : register(t2);
 RWBuffer<float4> u_PixelBuffer : register(u0);
+RWBuffer<float> u_TileErrors : register(u1);
+RWByteAddressBuffer u_ErrorHistogram : register(u2);
 SamplerState s_InputSampler : register(s0);
 
 static const float c_CheckerboardSizePixels = 8.0;
@@ -75,6 +78,80 @@ float GetRelativeDifference(float a, float b)
     return abs(a - b) / max(abs(a), abs(b));
 }
 
+float GetPixelMSE(float4 leftValue, float4 rightValue)
+{
+    const float4 diff = leftValue - rightValue;
+    const float4 squaredDiff = diff * diff;
+    float sum = 0;
+    if ((g_Const.channelMask & 1) != 0) sum += squaredDiff.r;
+    if ((g_Const.channelMask & 2) != 0) sum += squaredDiff.g;
+    if ((g_Const.channelMask & 4) != 0) sum += squaredDiff.b;
+    if ((g_Const.channelMask & 8) != 0) sum += squaredDiff.a;
+    return sum / float(max(countbits(g_Const.channelMask), 1u));
+}
+
+float MSEToPSNR(float mse)
+{
+    return (mse > 0) ? -10.0 * log10(mse) : 1000.0;
+}
+
+// Blue-cyan-green-yellow-red ramp for the error heatmap, t = 0 is the lowest error
+float3 HeatmapColor(float t)
+{
+    const float3 r = saturate(float3(4.0 * t - 2.0, 0.0, 0.0));
+    const float3 g = saturate(float3(0.0, t < 0.5 ? 4.0 * t : 4.0 - 4.0 * t, 0.0));
+    const float3 b = saturate(float3(0.0, 0.0, 2.0 - 4.0 * t));
+    return r + g + b;
+}
+
+groupshared float s_TileErrors[ERROR_TILE_SIZE * ERROR_TILE_SIZE];
+groupshared uint s_Histogram[ERROR_HISTOGRAM_BINS];
+
+// Computes the MSE of one tile of the viewed mip level into u_TileErrors,
+// and accumulates the per-pixel PSNR histogram in u_ErrorHistogram.
+[numthreads(ERROR_TILE_SIZE, ERROR_TILE_SIZE, 1)]
+void ErrorAnalysisCS(
+    uint2 pixelPos : SV_DispatchThreadID,
+    uint2 tilePos : SV_GroupID,
+    uint threadIndex : SV_GroupIndex)
+{
+    if (threadIndex < ERROR_HISTOGRAM_BINS)
+        s_Histogram[threadIndex] = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 mipSize;
+    t_LeftInput.GetDimensions(mipSize.x, mipSize.y);
+
+    float pixelMSE = 0;
+    if (all(pixelPos < mipSize))
+    {
+        pixelMSE = GetPixelMSE(t_LeftInput[pixelPos], t_RightInput[pixelPos]);
+
+        const int bin = clamp(int(MSEToPSNR(pixelMSE) / ERROR_HISTOGRAM_BIN_DB), 0, ERROR_HISTOGRAM_BINS - 1);
+        InterlockedAdd(s_Histogram[bin], 1);
+    }
+    s_TileErrors[threadIndex] = pixelMSE;
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint stride = ERROR_TILE_SIZE * ERROR_TILE_SIZE / 2; stride > 0; stride >>= 1)
+    {
+        if (threadIndex < stride)
+            s_TileErrors[threadIndex] += s_TileErrors[threadIndex + stride];
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (threadIndex < ERROR_HISTOGRAM_BINS && s_Histogram[threadIndex] != 0)
+        u_ErrorHistogram.InterlockedAdd(threadIndex * 4, s_Histogram[threadIndex]);
+
+    if (threadIndex == 0)
+    {
+        const uint2 tileStart = tilePos * ERROR_TILE_SIZE;
+        const uint2 tileSize = min(tileStart + ERROR_TILE_SIZE, mipSize) - tileStart;
+        u_TileErrors[tilePos.y * g_Const.errorTilesX + tilePos.x] = s_TileErrors[0] / float(tileSize.x * tileSize.y);
+    }
+}
+
 float4 MainPS(
     in float4 windowPos : SV_Position,
     in float2 quadUv : UV) : SV_Target0
@@ -121,15 +198,30 @@ float4 MainPS(
                 textureColor = windowPos.x < float(g_Const.splitPosition)
                     ? leftValue
                     : rightValue;
+                break;
+            case DisplayMode::ErrorHeatmap: {
+                uint2 mipSize;
+                t_LeftInput.GetDimensions(mipSize.x, mipSize.y);
+                const uint2 tilePos = min(uint2(uv * mipSize), mipSize - 1) / ERROR_TILE_SIZE;
+                const float tilePSNR = MSEToPSNR(t_TileErrors[tilePos.y * g_Const.errorTilesX + tilePos.x]);
+                const float t = saturate((g_Const.heatmapMaxPSNR - tilePSNR) / (g_Const.heatmapMaxPSNR - g_Const.heatmapMinPSNR));
+                // Blend the heatmap over a dimmed grayscale version of the left image to keep the features recognizable
+                textureColor.rgb = lerp(Luminance(leftValue.rgb).xxx, HeatmapColor(t), 0.75);
+                textureColor.a = 1.0;
+                break;
+            }
         }
 
-        if (g_Const.isSRGB)
-            textureColor.rgb = NtcSrgbColorSpace::Decode(textureColor.rgb);
+        if (g_Const.displayMode != DisplayMode::ErrorHeatmap)
+        {
+            if (g_Const.isSRGB)
+                textureColor.rgb = NtcSrgbColorSpace::Decode(textureColor.rgb);
 
-        textureColor.rgb *= g_Const.colorScale;
+            textureColor.rgb *= g_Const.colorScale;
 
-        if (g_Const.applyToneMapping)
-            textureColor.rgb = ReinhardToneMapping(textureColor.rgb);
+            if (g_Const.applyToneMapping)
+                textureColor.rgb = ReinhardToneMapping(textureColor.rgb);
+        }
     }
 
     const int2 checkerboardPos = int2(floor(relativePos / c_CheckerboardSizePixels));
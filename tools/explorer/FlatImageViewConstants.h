@@ -10,13 +10,21 @@
  * its affiliates is strictly prohibited.
  */
 
+// Size of the square tiles for which the error analysis pass computes the MSE, in pixels
+#define ERROR_TILE_SIZE 16
+
+// Number of bins in the per-pixel PSNR histogram, and the PSNR range of each bin
+#define ERROR_HISTOGRAM_BINS 32
+#define ERROR_HISTOGRAM_BIN_DB 2.5
+
 enum class DisplayMode
 {
     LeftTexture,
     RightTexture,
     Difference,
     RelativeDifference,
-    SplitScreen
+    SplitScreen,
+    ErrorHeatmap
 };
 
 struct FlatImageViewConstants
@@ -34,4 +42,7 @@ struct FlatImageViewConstants
     float colorScale;
     uint applyToneMapping;
     uint isSRGB;
+    int errorTilesX;
+    float heatmapMinPSNR;
+    float heatmapMaxPSNR;
 };
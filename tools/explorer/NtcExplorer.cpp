@@ -22,11 +22,14 @@
 #include <donut/core/math/math.h>
 #include <donut/core/string_utils.h>
 #include <nvrhi/utils.h>
+#include <ntc-utils/CompressedFileStream.h>
 #include <ntc-utils/GraphicsDecompressionPass.h>
 #include <ntc-utils/Manifest.h>
 #include <ntc-utils/DeviceUtils.h>
 #include <ntc-utils/Misc.h>
 #include <ntc-utils/Semantics.h>
+#include <atomic>
+#include <deque>
 #include <filesystem>
 #include <argparse.h>
 #include <stb_image.h>
@@ -48,6 +51,9 @@ namespace fs = std::filesystem;
 
 static const char* g_ApplicationName = "Neural Texture Compression Explorer";
 
+// Compression progress previews are limited to this fraction of the training time, and to one per displayed frame
+static const float g_maxPreviewOverhead = 0.03f;
+
 struct
 {
     ToolInputType inputType = ToolInputType::None;
@@ -60,6 +66,7 @@ struct
     bool useDX12 = false;
     int adapterIndex = -1;
     int cudaDevice = 0;
+    int historyBudgetMB = 1024;
 } g_options;
 
 bool ProcessCommandLine(int argc, const char** argv)
@@ -72,6 +79,7 @@ bool ProcessCommandLine(int argc, const char** argv)
         OPT_INTEGER(0, "cudaDevice", &g_options.cudaDevice, "Index of the CUDA device to use (use ntc-cli.exe --listCudaDevices to find out)"),
         OPT_BOOLEAN(0, "captureMode", &g_options.captureMode, "Trace capture mode - run Graphics decompression in a loop"),
         OPT_BOOLEAN(0, "hdr", &g_options.hdr, "Use an HDR (FP16) swap chain"),
+        OPT_INTEGER(0, "historyBudget", &g_options.historyBudgetMB, "Memory budget in MB for the compressed data of the compression results, older results are moved to a temporary folder (default: 1024)"),
 #if NTC_WITH_VULKAN
         OPT_BOOLEAN(0, "vk", &g_options.useVulkan, "Use Vulkan API"),
 #endif
@@ -302,8 +310,19 @@ struct CompressionResult
     int ordinal = 0;
     float timeSeconds = 0.f;
     float experimentalKnob = 0.f;
+    // Null when the data has been moved to spillFileName to fit into the history budget
     std::shared_ptr<std::vector<uint8_t>> compressedData;
+    size_t compressedSize = 0;
     fs::path sourceFileName;
+    fs::path spillFileName;
+};
+
+// Parameters of a compression run that is waiting in the queue
+struct CompressionJob
+{
+    ntc::CompressionSettings compressionSettings;
+    ntc::LatentShape latentShape;
+    float experimentalKnob = 0.f;
 };
 
 class Application : public app::ImGui_Renderer
@@ -354,10 +373,18 @@ private:
     bool m_useRightDecompressedImage = false;
     bool m_compressedTextureSetAvailable = false;
     bool m_showCompressionProgress = true;
+    // Written by the render thread and read by the compression thread to limit the progress previews
+    // to what is visible and to the display rate, see IsPreviewDue(...)
+    std::atomic<int> m_previewImage = -1; // -1 means all images
+    std::atomic<int> m_previewMipLevel = -1; // -1 means all mips
+    std::atomic<float> m_displayFrameTime = 0.f;
+    std::atomic<uint64_t> m_displayedFrames = 0;
     int m_compressionCounter = 0;
     std::vector<CompressionResult> m_compressionResults;
-    CompressionResult m_selectedCompressionResult;
-    bool m_selectedCompressionResultValid = false;
+    std::deque<CompressionJob> m_compressionQueue;
+    fs::path m_spillDirectory;
+    int m_displayedRunOrdinals[2] = {}; // Left and right image slots, 0 means reference
+    int m_selectedResultOrdinal = 0; // Result shown in the details window, 0 means none
     int m_alphaMaskChannelIndex = -1;
     bool m_useAlphaMaskChannel = false;
     bool m_discardMaskedOutPixels = false;
@@ -410,6 +437,12 @@ public:
 
         if (m_textureSet)
             m_ntcContext->DestroyTextureSet(m_textureSet);
+
+        if (!m_spillDirectory.empty())
+        {
+            std::error_code ec;
+            fs::remove_all(m_spillDirectory, ec);
+        }
     }
     
     bool Init()
@@ -532,17 +565,17 @@ public:
 
     CompressionResult* LoadCompressedTextureSet(const char* fileName, bool createImagesIfEmpty)
     {
-        ntc::FileStreamWrapper inputFile(m_ntcContext);
-        ntc::Status ntcStatus = m_ntcContext->OpenFile(fileName, false, inputFile.ptr());
-        if (ntcStatus != ntc::Status::Ok)
+        // Page-compressed files are inflated when they are read, so the data below is always uncompressed
+        std::string openError;
+        std::unique_ptr<ntc::IStream> inputFile = OpenTextureSetFile(fileName, &openError);
+        if (!inputFile)
         {
-            log::error("Failed to open input file '%s', error code = %s: %s", fileName,
-                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            log::error("Failed to open input file '%s': %s", fileName, openError.c_str());
             return nullptr;
         }
         
         ntc::TextureSetMetadataWrapper metadata(m_ntcContext);
-        ntcStatus = m_ntcContext->CreateTextureSetMetadataFromStream(inputFile, metadata.ptr());
+        ntc::Status ntcStatus = m_ntcContext->CreateTextureSetMetadataFromStream(inputFile.get(), metadata.ptr());
         if (ntcStatus != ntc::Status::Ok)
         {
             log::error("Failed to load input file '%s', error code = %s: %s", fileName,
@@ -619,6 +652,7 @@ public:
         result.compressedData = std::make_shared<std::vector<uint8_t>>(fileSize);
         inputFile->Seek(0);
         inputFile->Read(result.compressedData->data(), fileSize);
+        result.compressedSize = fileSize;
         result.compressMipChain = desc.mips > 1;
         result.bitsPerPixel = float(fileSize) / float(desc.width * desc.height);
         if (result.compressMipChain)
@@ -1104,7 +1138,7 @@ public:
     void ClearImages()
     {
         m_semanticBindings.clear();
-        m_compressionResults.clear();
+        ClearCompressionResults();
         m_bindingCache->Clear();
         m_useLeftDecompressedImage = false;
         m_useRightDecompressedImage = false;
@@ -1238,7 +1272,8 @@ public:
         return false; }
 //#end-define
 
-    ntc::Status DecompressWithGapi(ntc::IStream* inputStream, size_t inputSize, bool useRightTextures)
+    ntc::Status DecompressWithGapi(ntc::IStream* inputStream, uint8_t const* inputData, size_t inputSize,
+        bool useRightTextures)
     {
         ntc::TextureSetMetadataWrapper metadata(m_ntcContext);
 
@@ -1283,7 +1318,13 @@ public:
         // Open the command list, upload the latents and weights
         m_commandList->open();
         m_commandList->beginMarker("Upload NTC Data");
-        if (!m_decompressionPass.SetInputData(m_commandList, inputStream, streamRange))
+        // The compressed data is already in memory, upload the latents from there without another copy
+        if (streamRange.offset > inputSize || streamRange.size > inputSize - streamRange.offset)
+        {
+            m_commandList->close();
+            return ntc::Status::InternalError;
+        }
+        if (!m_decompressionPass.SetInputData(m_commandList, inputData + streamRange.offset, streamRange.size))
         {
             m_commandList->close();
             return ntc::Status::InternalError;
@@ -1362,7 +1403,10 @@ public:
         return ntc::Status::Ok;
     }
 
-    bool DecompressIntoTextures(bool recordResults, bool useRightTextures, bool enableFP8, time_point<steady_clock> beginTime)
+    // Decompresses the texture set and copies the results into the graphics textures. The copies can be
+    // limited to one image and one mip level, which is used for the compression progress previews.
+    bool DecompressIntoTextures(bool recordResults, bool useRightTextures, bool enableFP8, time_point<steady_clock> beginTime,
+        int onlyImage = -1, int onlyMipLevel = -1)
     {
         if (!m_cudaAvailable)
             return false;
@@ -1399,6 +1443,7 @@ public:
 
             // Trim the buffer to the actual size of the saved data
             result.compressedData->resize(bufferSize);
+            result.compressedSize = bufferSize;
             result.bitsPerPixel = float(double(bufferSize) * 8.0 / double(m_totalPixels));
             
             // The rest of this function is interlocked with other threads
@@ -1411,8 +1456,12 @@ public:
         int const texturesInSet = m_textureSet->GetTextureCount();
         assert(texturesInSet == m_images.size()); // Validated when loading the file, or equal by definition if the texture was just compressed
 
-        for (auto& image : m_images)
+        for (int imageIndex = 0; imageIndex < int(m_images.size()); ++imageIndex)
         {
+            if (onlyImage >= 0 && imageIndex != onlyImage)
+                continue;
+
+            MaterialImage& image = m_images[imageIndex];
             size_t const bytesPerComponent = ntc::GetBytesPerPixelComponent(image.format);
             size_t const pixelStride = 4 * bytesPerComponent;
 
@@ -1441,6 +1490,8 @@ public:
 
             nvrhi::TextureDesc const& textureDesc = decompressedTexture->getDesc();
             int const effectiveMips = std::min(m_textureSetDesc.mips, int(textureDesc.mipLevels));
+            int const firstMip = (onlyMipLevel >= 0) ? std::min(onlyMipLevel, effectiveMips - 1) : 0;
+            int const lastMip = (onlyMipLevel >= 0) ? firstMip : effectiveMips - 1;
             
             ntc::ColorSpace const rgbColorSpace = image.isSRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
             ntc::ColorSpace const alphaColorSpace = ntc::ColorSpace::Linear;
@@ -1448,7 +1499,7 @@ public:
 
             if (useSharedTextures && decompressedTextureSharedRef)
             {
-                for (int mip = 0; mip < effectiveMips; ++mip)
+                for (int mip = firstMip; mip <= lastMip; ++mip)
                 {
                     ntc::ReadChannelsIntoTextureParameters params;
                     params.page = ntc::TextureDataPage::Output;
@@ -1473,7 +1524,7 @@ public:
 
                 m_uploadCommandList->open();
 
-                for (int mip = 0; mip < effectiveMips; ++mip)
+                for (int mip = firstMip; mip <= lastMip; ++mip)
                 {
                     int const mipWidth = std::max(int(textureDesc.width) >> mip, 1);
                     int const mipHeight = std::max(int(textureDesc.height) >> mip, 1);
@@ -1628,6 +1679,8 @@ public:
 
     void RestoreReferenceTextureView(bool rightTexture)
     {
+        m_displayedRunOrdinals[rightTexture ? 1 : 0] = 0;
+
         if (rightTexture)
         {
             m_useRightDecompressedImage = false;
@@ -1642,6 +1695,8 @@ public:
 
     void SetRestoredRunName(CompressionResult const& result, bool useRightTextures)
     {
+        m_displayedRunOrdinals[useRightTextures ? 1 : 0] = result.ordinal;
+
         char textureName[32];
         if (result.sourceFileName.empty())
             snprintf(textureName, sizeof textureName, "Run #%d", result.ordinal);
@@ -1653,8 +1708,132 @@ public:
             m_leftImageName = textureName;
     }
 
-    bool RestoreCompressedTextureSet(const CompressionResult& result, bool useRightTextures)
+    CompressionResult* FindCompressionResult(int ordinal)
+    {
+        for (auto& result : m_compressionResults)
+        {
+            if (result.ordinal == ordinal)
+                return &result;
+        }
+        return nullptr;
+    }
+
+    void ClearCompressionResults()
+    {
+        for (auto const& result : m_compressionResults)
+        {
+            if (!result.spillFileName.empty())
+            {
+                std::error_code ec;
+                fs::remove(result.spillFileName, ec);
+            }
+        }
+        m_compressionResults.clear();
+        m_displayedRunOrdinals[0] = m_displayedRunOrdinals[1] = 0;
+    }
+
+    // Writes the compressed data of a result into the spill directory and releases the memory.
+    // The spill file is kept until the results are cleared, so a result is only written once.
+    bool SpillCompressionResult(CompressionResult& result)
+    {
+        if (!result.compressedData)
+            return true;
+
+        if (result.spillFileName.empty())
+        {
+            std::error_code ec;
+            if (m_spillDirectory.empty())
+            {
+                m_spillDirectory = fs::temp_directory_path(ec) /
+                    ("ntc-explorer-" + std::to_string(steady_clock::now().time_since_epoch().count()));
+                fs::create_directories(m_spillDirectory, ec);
+            }
+
+            fs::path const spillFileName = m_spillDirectory / ("run-" + std::to_string(result.ordinal) + ".ntc");
+            FILE* spillFile = fopen(spillFileName.generic_string().c_str(), "wb");
+            if (!spillFile)
+            {
+                log::warning("Cannot create spill file '%s', result #%d stays in memory.",
+                    spillFileName.generic_string().c_str(), result.ordinal);
+                return false;
+            }
+
+            bool const success = fwrite(result.compressedData->data(), result.compressedData->size(), 1, spillFile) == 1;
+            fclose(spillFile);
+            if (!success)
+            {
+                log::warning("Failed to write spill file '%s', result #%d stays in memory.",
+                    spillFileName.generic_string().c_str(), result.ordinal);
+                fs::remove(spillFileName, ec);
+                return false;
+            }
+
+            result.spillFileName = spillFileName;
+        }
+
+        result.compressedData.reset();
+        return true;
+    }
+
+    bool MakeCompressionResultResident(CompressionResult& result)
     {
+        if (result.compressedData)
+            return true;
+
+        FILE* spillFile = fopen(result.spillFileName.generic_string().c_str(), "rb");
+        if (!spillFile)
+        {
+            log::error("Cannot open spill file '%s' for result #%d.", result.spillFileName.generic_string().c_str(),
+                result.ordinal);
+            return false;
+        }
+
+        auto data = std::make_shared<std::vector<uint8_t>>(result.compressedSize);
+        bool const success = fread(data->data(), data->size(), 1, spillFile) == 1;
+        fclose(spillFile);
+        if (!success)
+        {
+            log::error("Failed to read spill file '%s' for result #%d.", result.spillFileName.generic_string().c_str(),
+                result.ordinal);
+            return false;
+        }
+
+        result.compressedData = data;
+        return true;
+    }
+
+    // Moves the oldest results out of memory until the resident ones fit into the history budget.
+    // The latest result and the ones shown in the image slots stay resident.
+    void EnforceResultHistoryBudget()
+    {
+        uint64_t const budget = uint64_t(std::max(g_options.historyBudgetMB, 0)) << 20;
+
+        std::lock_guard lock(m_mutex);
+        uint64_t residentBytes = 0;
+        for (auto const& result : m_compressionResults)
+        {
+            if (result.compressedData)
+                residentBytes += result.compressedSize;
+        }
+
+        for (size_t index = 0; index + 1 < m_compressionResults.size() && residentBytes > budget; ++index)
+        {
+            CompressionResult& result = m_compressionResults[index];
+            if (!result.compressedData || result.ordinal == m_displayedRunOrdinals[0] ||
+                result.ordinal == m_displayedRunOrdinals[1])
+                continue;
+
+            if (!SpillCompressionResult(result))
+                break;
+            residentBytes -= result.compressedSize;
+        }
+    }
+
+    bool RestoreCompressedTextureSet(CompressionResult& result, bool useRightTextures)
+    {
+        if (!MakeCompressionResultResident(result))
+            return false;
+
         ntc::MemoryStreamWrapper inputStream(m_ntcContext);
         ntc::Status ntcStatus = m_ntcContext->OpenReadOnlyMemory(result.compressedData->data(),
             result.compressedData->size(), inputStream.ptr());
@@ -1668,7 +1847,8 @@ public:
 
         if (m_useGapiDecompression)
         {
-            ntcStatus = DecompressWithGapi(inputStream, result.compressedData->size(), useRightTextures);
+            ntcStatus = DecompressWithGapi(inputStream, result.compressedData->data(),
+                result.compressedData->size(), useRightTextures);
 
             if (ntcStatus != ntc::Status::Ok)
             {
@@ -1734,6 +1914,19 @@ public:
         return true;
     }
 
+    // Decides whether the compression thread should update the progress preview now. Previews are only made
+    // after the previous one has been displayed, no more often than the display refresh, and rarely enough
+    // that their total cost stays under g_maxPreviewOverhead of the training time.
+    bool IsPreviewDue(time_point<steady_clock> lastPreviewEnd, float lastPreviewSeconds, uint64_t lastPreviewFrame)
+    {
+        if (m_displayedFrames.load() <= lastPreviewFrame)
+            return false;
+
+        float const interval = std::max(m_displayFrameTime.load(), lastPreviewSeconds / g_maxPreviewOverhead);
+        float const secondsSincePreview = float(duration_cast<microseconds>(steady_clock::now() - lastPreviewEnd).count()) * 1e-6f;
+        return secondsSincePreview >= interval;
+    }
+
     bool CompressionThreadProc()
     {
         ntc::Status ntcStatus;
@@ -1765,6 +1958,9 @@ public:
 
         ntc::CompressionStats stats;
         char textureName[32];
+        time_point<steady_clock> lastPreviewEnd = beginTime;
+        float lastPreviewSeconds = 0.f;
+        uint64_t lastPreviewFrame = 0;
 
         do
         {
@@ -1772,9 +1968,17 @@ public:
             CHECK_CANCEL(true);
             if (ntcStatus == ntc::Status::Incomplete || ntcStatus == ntc::Status::Ok)
             {
-                if (m_showCompressionProgress && ntcStatus == ntc::Status::Incomplete)
+                if (m_showCompressionProgress && ntcStatus == ntc::Status::Incomplete &&
+                    IsPreviewDue(lastPreviewEnd, lastPreviewSeconds, lastPreviewFrame))
                 {
-                    if (!DecompressIntoTextures(false, true, false, beginTime))
+                    time_point<steady_clock> const previewBegin = steady_clock::now();
+                    lastPreviewFrame = m_displayedFrames.load();
+                    bool const previewSuccess = DecompressIntoTextures(false, true, false, beginTime,
+                        m_previewImage.load(), m_previewMipLevel.load());
+                    lastPreviewEnd = steady_clock::now();
+                    lastPreviewSeconds = float(duration_cast<microseconds>(lastPreviewEnd - previewBegin).count()) * 1e-6f;
+
+                    if (!previewSuccess)
                     {
                         // If the user clicks Cancel while decompression is running, DecompressIntoTextures(...)
                         // doesn't call AbortCompression() - do that here to avoid leaving the texture set
@@ -1805,10 +2009,11 @@ public:
         bool success = DecompressIntoTextures(true, true, false, beginTime);
         if (success)
         {
-            snprintf(textureName, sizeof textureName, "Run #%d", m_compressionResults[m_compressionResults.size() - 1].ordinal);
-
             std::lock_guard guard(m_mutex);
+            int const ordinal = m_compressionResults[m_compressionResults.size() - 1].ordinal;
+            snprintf(textureName, sizeof textureName, "Run #%d", ordinal);
             m_rightImageName = textureName;
+            m_displayedRunOrdinals[1] = ordinal;
         }
 
         return success;
@@ -1852,6 +2057,30 @@ public:
         });
     }
 
+    void EnqueueCompression()
+    {
+        CompressionJob& job = m_compressionQueue.emplace_back();
+        job.compressionSettings = m_compressionSettings;
+        job.latentShape = m_latentShape;
+        job.experimentalKnob = m_experimentalKnob;
+    }
+
+    // Starts the next queued compression run when the previous one is finished.
+    // The parameters of the job are copied into the UI, same as when restoring a result.
+    void UpdateCompressionQueue()
+    {
+        if (m_compressing || m_compressionQueue.empty() || !m_cudaAvailable || m_loading)
+            return;
+
+        CompressionJob const job = m_compressionQueue.front();
+        m_compressionQueue.pop_front();
+
+        m_compressionSettings = job.compressionSettings;
+        m_latentShape = job.latentShape;
+        m_experimentalKnob = job.experimentalKnob;
+        BeginCompression();
+    }
+
     void SaveCompressedTextureSet(const char* fileName) const
     {
         ntc::Status ntcStatus = m_textureSet->SaveToFile(fileName);
@@ -1867,6 +2096,10 @@ public:
     {
         ImGui_Renderer::Animate(elapsedTimeSeconds);
         m_modelView->Animate(elapsedTimeSeconds);
+
+        if (!m_compressing)
+            EnforceResultHistoryBudget();
+        UpdateCompressionQueue();
     }
 
     void Render(nvrhi::IFramebuffer* framebuffer) override
@@ -1947,10 +2180,19 @@ public:
         m_commandList->close();
         GetDevice()->executeCommandList(m_commandList);
 
+        // The flat view only shows one mip of one image, the model view samples all mips of all images
+        m_previewImage = m_selectedImage;
+        m_previewMipLevel = (m_selectedImage >= 0) ? m_flatImageView->GetMipLevel() : -1;
+        m_displayFrameTime = GetDeviceManager()->GetAverageFrameTimeSeconds();
+        ++m_displayedFrames;
+
         ImGui_Renderer::Render(framebuffer);
 
         if (!m_loading && m_selectedImage >= 0)
+        {
             m_flatImageView->ReadPixel();
+            m_flatImageView->ReadErrorAnalysis();
+        }
     }
 
     void buildUI() override
@@ -2417,8 +2659,20 @@ public:
                 {
                     if (ImGui::Button("Compress!"))
                         BeginCompression();
+                    ImGui::SameLine();
                 }
-                else
+                if (ImGui::Button("Add to Queue"))
+                    EnqueueCompression();
+                ImGui::TooltipMarker("Add a compression run with the current parameters to the queue.\n"
+                    "Queued runs start one after another when the previous run is finished.");
+                if (!m_compressionQueue.empty())
+                {
+                    ImGui::Text("Queued runs: %d", int(m_compressionQueue.size()));
+                    ImGui::SameLine();
+                    if (ImGui::Button("Clear Queue"))
+                        m_compressionQueue.clear();
+                }
+                if (m_compressing)
                 {
                     char buf[32];
                     float progress = float(m_compressionStats.currentStep) / float(m_compressionSettings.trainingSteps);
@@ -2470,8 +2724,7 @@ public:
                     snprintf(buf, sizeof buf, "%d", result->ordinal);
                     if (ImGui::Selectable(buf, false, ImGuiSelectableFlags_SpanAllColumns))
                     {
-                        m_selectedCompressionResult = *result;
-                        m_selectedCompressionResultValid = true;
+                        m_selectedResultOrdinal = result->ordinal;
                     }
                     if (!m_compressing && ImGui::BeginDragDropSource(ImGuiDragDropFlags_None))
                     {
@@ -2496,7 +2749,8 @@ public:
 
                 if (ImGui::Button("Clear Results"))
                 {
-                    m_compressionResults.clear();
+                    ClearCompressionResults();
+                    m_selectedResultOrdinal = 0;
                     RestoreReferenceTextureView(false);
                 }
                 ImGui::SameLine();
@@ -2553,18 +2807,13 @@ public:
             }
             else if (!m_compressing)
             {
-                for (auto& result : m_compressionResults)
-                {
-                    if (result.ordinal == restoreRunOrdinal)
-                    {
-                        RestoreCompressedTextureSet(result, restoreRightTexture);
-                        break;
-                    }
-                }
+                if (CompressionResult* result = FindCompressionResult(restoreRunOrdinal))
+                    RestoreCompressedTextureSet(*result, restoreRightTexture);
             }
         }
         
-        if (m_selectedCompressionResultValid)
+        // Looked up on every frame, the results vector can grow and move its elements while the window is open
+        if (CompressionResult* selectedResult = FindCompressionResult(m_selectedResultOrdinal))
         {
             int width, height;
             GetDeviceManager()->GetWindowDimensions(width, height);
@@ -2584,35 +2833,35 @@ public:
                 ImGui::Selectable(name, false, ImGuiSelectableFlags_SpanAllColumns);
                 ImGui::TableNextColumn();
             };
-            setupRow("Result Ordinal");             ImGui::Text("#%d", m_selectedCompressionResult.ordinal);
+            setupRow("Result Ordinal");             ImGui::Text("#%d", selectedResult->ordinal);
             ImGui::Separator();
 
-            setupRow("Bits per pixel");             ImGui::Text("%.2f", m_selectedCompressionResult.bitsPerPixel);
-            setupRow("Stored texture size");        ImGui::Text("%.2f MB", float(m_selectedCompressionResult.compressedData->size()) / 1'048'576.f);
-            setupRow("Compress MIP chain");         ImGui::Text("%s", m_selectedCompressionResult.compressMipChain ? "YES" : "NO");
-            setupRow("Random seed");                ImGui::Text("%d", m_selectedCompressionResult.compressionSettings.randomSeed);
-            setupRow("Stable training");            ImGui::Text("%s", m_selectedCompressionResult.compressionSettings.stableTraining ? "YES" : "NO");
-            setupRow("Grid size scale");            ImGui::Text("%d", m_selectedCompressionResult.latentShape.gridSizeScale);
-            setupRow("High-res features");          ImGui::Text("%d", m_selectedCompressionResult.latentShape.highResFeatures);
-            setupRow("High-res quantization bits"); ImGui::Text("%d", m_selectedCompressionResult.latentShape.highResQuantBits);
-            setupRow("Low-res features");           ImGui::Text("%d", m_selectedCompressionResult.latentShape.lowResFeatures);
-            setupRow("Low-res quantization bits");  ImGui::Text("%d", m_selectedCompressionResult.latentShape.lowResQuantBits);
-            setupRow("Compression steps");          ImGui::Text("%d", m_selectedCompressionResult.compressionSettings.trainingSteps);
-            setupRow("kPixels per batch");          ImGui::Text("%d", m_selectedCompressionResult.compressionSettings.kPixelsPerBatch);
-            setupRow("Network learning rate");      ImGui::Text("%.4f", m_selectedCompressionResult.compressionSettings.networkLearningRate);
-            setupRow("Grid learning rate");         ImGui::Text("%.4f", m_selectedCompressionResult.compressionSettings.gridLearningRate);
-            setupRow("Experimental knob");          ImGui::Text("%.3f", m_selectedCompressionResult.experimentalKnob);
+            setupRow("Bits per pixel");             ImGui::Text("%.2f", selectedResult->bitsPerPixel);
+            setupRow("Stored texture size");        ImGui::Text("%.2f MB", float(selectedResult->compressedSize) / 1'048'576.f);
+            setupRow("Compress MIP chain");         ImGui::Text("%s", selectedResult->compressMipChain ? "YES" : "NO");
+            setupRow("Random seed");                ImGui::Text("%d", selectedResult->compressionSettings.randomSeed);
+            setupRow("Stable training");            ImGui::Text("%s", selectedResult->compressionSettings.stableTraining ? "YES" : "NO");
+            setupRow("Grid size scale");            ImGui::Text("%d", selectedResult->latentShape.gridSizeScale);
+            setupRow("High-res features");          ImGui::Text("%d", selectedResult->latentShape.highResFeatures);
+            setupRow("High-res quantization bits"); ImGui::Text("%d", selectedResult->latentShape.highResQuantBits);
+            setupRow("Low-res features");           ImGui::Text("%d", selectedResult->latentShape.lowResFeatures);
+            setupRow("Low-res quantization bits");  ImGui::Text("%d", selectedResult->latentShape.lowResQuantBits);
+            setupRow("Compression steps");          ImGui::Text("%d", selectedResult->compressionSettings.trainingSteps);
+            setupRow("kPixels per batch");          ImGui::Text("%d", selectedResult->compressionSettings.kPixelsPerBatch);
+            setupRow("Network learning rate");      ImGui::Text("%.4f", selectedResult->compressionSettings.networkLearningRate);
+            setupRow("Grid learning rate");         ImGui::Text("%.4f", selectedResult->compressionSettings.gridLearningRate);
+            setupRow("Experimental knob");          ImGui::Text("%.3f", selectedResult->experimentalKnob);
 
             ImGui::Separator();
-            setupRow("Overall PSNR");               ImGui::Text("%.2f dB", m_selectedCompressionResult.overallPSNR);
+            setupRow("Overall PSNR");               ImGui::Text("%.2f dB", selectedResult->overallPSNR);
 
-            int const mips = m_selectedCompressionResult.compressMipChain ? m_numTextureSetMips : 1;
+            int const mips = selectedResult->compressMipChain ? m_numTextureSetMips : 1;
             for (int mip = 0; mip < mips; ++mip)
             {
                 char buf[32];
                 snprintf(buf, sizeof buf, "Mip %d PSNR", mip);
                 setupRow(buf);
-                ImGui::Text("%.2f dB", m_selectedCompressionResult.perMipPSNR[mip]);
+                ImGui::Text("%.2f dB", selectedResult->perMipPSNR[mip]);
             }
 
             ImGui::EndTable();
@@ -2628,10 +2877,9 @@ public:
             ImGui::BeginDisabled(m_compressing);
             if (ImGui::ButtonEx("Restore", { buttonWidth, 0.f }) && !m_compressing)
             {
-                m_latentShape = m_selectedCompressionResult.latentShape;
-                m_compressionSettings = m_selectedCompressionResult.compressionSettings;
-
-                RestoreCompressedTextureSet(m_selectedCompressionResult, true);
+                m_latentShape = selectedResult->latentShape;
+                m_compressionSettings = selectedResult->compressionSettings;
+                RestoreCompressedTextureSet(*selectedResult, true);
             }
             ImGui::EndDisabled();
 
@@ -2640,20 +2888,20 @@ public:
             {
                 std::stringstream ss;
                 ss << "Parameter\tName\n";
-                ss << "Ordinal\t" << m_selectedCompressionResult.ordinal << "\n";
-                ss << "Bits per pixel\t" << m_selectedCompressionResult.bitsPerPixel << "\n";
-                ss << "Experimental knob\t" << m_selectedCompressionResult.experimentalKnob << "\n";
-                ss << "Overall PSNR\t" << m_selectedCompressionResult.overallPSNR << "\n";
+                ss << "Ordinal\t" << selectedResult->ordinal << "\n";
+                ss << "Bits per pixel\t" << selectedResult->bitsPerPixel << "\n";
+                ss << "Experimental knob\t" << selectedResult->experimentalKnob << "\n";
+                ss << "Overall PSNR\t" << selectedResult->overallPSNR << "\n";
                 for (int mip = 0; mip < mips; ++mip)
                 {
-                    ss << "Mip " << mip << " PSNR\t" << m_selectedCompressionResult.perMipPSNR[mip] << "\n";
+                    ss << "Mip " << mip << " PSNR\t" << selectedResult->perMipPSNR[mip] << "\n";
                 }
                 glfwSetClipboardString(GetDeviceManager()->GetWindow(), ss.str().c_str());
             }
 
             ImGui::SameLine();
             if (ImGui::Button("Close", { buttonWidth, 0.f }))
-                m_selectedCompressionResultValid = false;
+                m_selectedResultOrdinal = 0;
 
             ImGui::End();
         }